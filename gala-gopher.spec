@@ -57,7 +57,7 @@ Requires:      iproute
 Requires:      kmod
 %endif
 %if 0%{?without_flamegraph}?0:1
-Requires:      flamegraph libcurl
+Requires:      libcurl
 %endif
 %if 0%{?without_opengauss_sli}?0:1
 Requires:      python3-psycopg2 python3-yaml net-tools
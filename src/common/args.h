@@ -47,10 +47,11 @@
 #define L7PROBE_TRACING_REDIS   0x0004
 #define L7PROBE_TRACING_MYSQL   0x0008
 #define L7PROBE_TRACING_PGSQL   0x0010
-#define L7PROBE_TRACING_KAFKA   0x0012
-#define L7PROBE_TRACING_MONGO   0x0014
-#define L7PROBE_TRACING_CQL     0x0018
+#define L7PROBE_TRACING_KAFKA   0x0080
+#define L7PROBE_TRACING_MONGO   0x0100
+#define L7PROBE_TRACING_CQL     0x0200
 #define L7PROBE_TRACING_NATS    0x0020
+#define L7PROBE_TRACING_HTTP2   0x0040
 
 #define __OPT_S "t:s:T:J:O:D:F:lU:L:c:p:w:d:P:Ck:i:m:e:f:A"
 struct probe_params {
@@ -72,6 +73,8 @@ struct probe_params {
     char res_percent_lower;       // [-L <>] Lower limit of resource percentage, default is 0%
     char cport_flag;              // [-c <>] Indicates whether the probes(such as tcp) identifies the client port, default is 0 (no identify)
     char continuous_sampling_flag;     // [-C <>] Enables the continuous sampling, default is 0
+    char dwarf_unwind;                 // Unwind oncpu user stacks with .eh_frame instead of frame pointers, default is 0
+    char binary_output;                // Output records in binary frames decoded by gala-gopher, default is 0 (text)
     char target_dev[DEV_NAME];    // [-d <>] Device name, default is null
     char elf_path[MAX_PATH_LEN];  // [-p <>] Set ELF file path of the monitored software, default is null
     char task_whitelist[MAX_PATH_LEN]; // [-w <>] Filtering app monitoring ranges, default is null
@@ -87,16 +90,18 @@ struct probe_params {
         0x0004  REDIS
         0x0008  MYSQL
         0x0010  PGSQL
-        0x0012  KAFKA
-        0x0014  MONGODB
-        0x0018  Cassandra
         0x0020  NATS
+        0x0040  HTTP2
+        0x0080  KAFKA
+        0x0100  MONGODB
+        0x0200  Cassandra
     */
     unsigned int l7_probe_proto_flags;
     unsigned int enable_all_thrds; // [-A] Enable all threads, default is 0
     char sys_debuging_dir[MAX_PATH_LEN];
     unsigned int svg_period;
     unsigned int perf_sample_period;
+    unsigned int mem_sample_kb;   // Mean KB between two sampled allocations of memleak flame graph, 0 tracks page faults
     char pyroscope_server[PYSCOPE_SERVER_URL_LEN];
     char svg_dir[PATH_LEN];
     char flame_dir[PATH_LEN];
@@ -0,0 +1,357 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-08-30
+ * Description: batched output of probe records, text lines or binary frames
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include "bin_output.h"
+
+#define BIN_REC_LEN_SIZE    sizeof(u16)
+#define BIN_REC_NUM_MAX     0xFFFF
+
+static u32 __start_len(const struct bin_output_s *out)
+{
+    return out->binary ? (u32)sizeof(struct bin_frame_hdr_s) : 0;
+}
+
+struct bin_output_s *create_bin_output(FILE *f)
+{
+    struct bin_output_s *out = (struct bin_output_s *)malloc(sizeof(struct bin_output_s));
+    if (out == NULL) {
+        return NULL;
+    }
+    memset(out, 0, sizeof(struct bin_output_s));
+
+    out->buf = (char *)malloc(BIN_OUTPUT_BUF_SIZE);
+    if (out->buf == NULL) {
+        free(out);
+        return NULL;
+    }
+    out->f = f;
+    return out;
+}
+
+void destroy_bin_output(struct bin_output_s *out)
+{
+    if (out == NULL) {
+        return;
+    }
+
+    (void)bin_output_flush(out);
+    free(out->buf);
+    free(out);
+}
+
+int bin_output_flush(struct bin_output_s *out)
+{
+    struct bin_frame_hdr_s hdr;
+    ssize_t n;
+    u32 off = 0;
+    int ret = 0;
+
+    if (out->rec_num == 0) {
+        return 0;
+    }
+
+    if (out->binary) {
+        hdr.magic = BIN_OUTPUT_MAGIC;
+        hdr.version = BIN_OUTPUT_VERSION;
+        hdr.rec_num = out->rec_num;
+        hdr.len = out->len - (u32)sizeof(struct bin_frame_hdr_s);
+        memcpy(out->buf, &hdr, sizeof(hdr));
+    }
+
+    // Logs are printed to the same stream, keep them in order.
+    (void)fflush(out->f);
+    while (off < out->len) {
+        n = write(fileno(out->f), out->buf + off, out->len - off);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ret = -1;
+            break;
+        }
+        off += (u32)n;
+    }
+
+    out->len = __start_len(out);
+    out->rec_num = 0;
+    return ret;
+}
+
+void bin_output_set_binary(struct bin_output_s *out, char binary)
+{
+    binary = (binary != 0);
+    if (out->binary == binary) {
+        return;
+    }
+
+    (void)bin_output_flush(out);
+    out->binary = binary;
+    out->len = __start_len(out);
+}
+
+static void __append_bytes(struct bin_output_s *out, const void *data, u32 len)
+{
+    if (out->overflow || out->len + len > out->rec_start + BIN_OUTPUT_REC_MAX) {
+        out->overflow = 1;
+        return;
+    }
+    memcpy(out->buf + out->len, data, len);
+    out->len += len;
+}
+
+static void __append_field(struct bin_output_s *out, u8 type, const void *v, u32 len)
+{
+    __append_bytes(out, &type, sizeof(type));
+    __append_bytes(out, v, len);
+}
+
+static void __append_text(struct bin_output_s *out, const char *fmt, ...)
+{
+    int n;
+    u32 left;
+    va_list args;
+
+    if (out->overflow) {
+        return;
+    }
+
+    left = out->rec_start + BIN_OUTPUT_REC_MAX - out->len;
+    va_start(args, fmt);
+    n = vsnprintf(out->buf + out->len, left, fmt, args);
+    va_end(args);
+    if (n < 0 || (u32)n >= left) {
+        out->overflow = 1;
+        return;
+    }
+    out->len += (u32)n;
+}
+
+void bin_output_begin(struct bin_output_s *out, const char *tbl)
+{
+    u16 rec_len = 0;
+    u8 tbl_len;
+
+    if (BIN_OUTPUT_BUF_SIZE - out->len < BIN_OUTPUT_REC_MAX || out->rec_num >= BIN_REC_NUM_MAX) {
+        (void)bin_output_flush(out);
+    }
+
+    out->rec_start = out->len;
+    out->overflow = 0;
+    if (!out->binary) {
+        __append_text(out, "|%.*s|", BIN_OUTPUT_STR_MAX, tbl);
+        return;
+    }
+
+    tbl_len = (u8)strnlen(tbl, BIN_OUTPUT_STR_MAX);
+    __append_bytes(out, &rec_len, sizeof(rec_len));
+    __append_bytes(out, &tbl_len, sizeof(tbl_len));
+    __append_bytes(out, tbl, tbl_len);
+}
+
+void bin_output_u32(struct bin_output_s *out, u32 v)
+{
+    if (out->binary) {
+        __append_field(out, BIN_FIELD_U32, &v, sizeof(v));
+    } else {
+        __append_text(out, "%u|", v);
+    }
+}
+
+void bin_output_s32(struct bin_output_s *out, int v)
+{
+    if (out->binary) {
+        __append_field(out, BIN_FIELD_S32, &v, sizeof(v));
+    } else {
+        __append_text(out, "%d|", v);
+    }
+}
+
+void bin_output_u64(struct bin_output_s *out, u64 v)
+{
+    if (out->binary) {
+        __append_field(out, BIN_FIELD_U64, &v, sizeof(v));
+    } else {
+        __append_text(out, "%llu|", v);
+    }
+}
+
+void bin_output_ip(struct bin_output_s *out, u16 family, const void *ip)
+{
+    unsigned char ip_s[INET6_ADDRSTRLEN];
+
+    if (out->binary) {
+        if (family == AF_INET6) {
+            __append_field(out, BIN_FIELD_IP6, ip, IP6_LEN);
+        } else {
+            __append_field(out, BIN_FIELD_IP4, ip, sizeof(u32));
+        }
+        return;
+    }
+
+    ip_str(family, (unsigned char *)ip, ip_s, INET6_ADDRSTRLEN);
+    __append_text(out, "%s|", (char *)ip_s);
+}
+
+void bin_output_str(struct bin_output_s *out, const char *s)
+{
+    u8 len;
+
+    if (!out->binary) {
+        __append_text(out, "%.*s|", BIN_OUTPUT_STR_MAX, s);
+        return;
+    }
+
+    len = (u8)strnlen(s, BIN_OUTPUT_STR_MAX);
+    __append_field(out, BIN_FIELD_STR, &len, sizeof(len));
+    __append_bytes(out, s, len);
+}
+
+void bin_output_end(struct bin_output_s *out)
+{
+    u16 rec_len;
+
+    if (out->binary) {
+        rec_len = (u16)(out->len - out->rec_start);
+        if (!out->overflow) {
+            memcpy(out->buf + out->rec_start, &rec_len, sizeof(rec_len));
+        }
+    } else {
+        __append_text(out, "\n");
+    }
+
+    if (out->overflow) {
+        out->len = out->rec_start;
+        out->overflow = 0;
+        return;
+    }
+    out->rec_num++;
+}
+
+static int __text_append(char *text, u32 size, u32 *len, const char *fmt, ...)
+{
+    int n;
+    va_list args;
+
+    va_start(args, fmt);
+    n = vsnprintf(text + *len, size - *len, fmt, args);
+    va_end(args);
+    if (n < 0 || (u32)n >= size - *len) {
+        return -1;
+    }
+    *len += (u32)n;
+    return 0;
+}
+
+int bin_record_to_text(const char *rec, u32 avail, u32 *rec_len_out, char *text, u32 size)
+{
+    u32 pos, len = 0;
+    u16 rec_len;
+    u8 tbl_len, type, str_len;
+    u32 v32;
+    int sv;
+    u64 v64;
+    unsigned char ip[IP6_LEN];
+    unsigned char ip_s[INET6_ADDRSTRLEN];
+    char str[BIN_OUTPUT_STR_MAX + 1];
+    int ret;
+
+    if (avail < BIN_REC_LEN_SIZE + sizeof(tbl_len) || size == 0) {
+        return -1;
+    }
+    memcpy(&rec_len, rec, sizeof(rec_len));
+    tbl_len = (u8)rec[BIN_REC_LEN_SIZE];
+    pos = BIN_REC_LEN_SIZE + sizeof(tbl_len);
+    if (rec_len > avail || pos + tbl_len > rec_len) {
+        return -1;
+    }
+    memcpy(str, rec + pos, tbl_len);
+    str[tbl_len] = 0;
+    pos += tbl_len;
+    if (__text_append(text, size, &len, "|%s|", str)) {
+        return -1;
+    }
+
+    while (pos < rec_len) {
+        type = (u8)rec[pos++];
+        switch (type) {
+            case BIN_FIELD_U32:
+                if (pos + sizeof(v32) > rec_len) {
+                    return -1;
+                }
+                memcpy(&v32, rec + pos, sizeof(v32));
+                pos += sizeof(v32);
+                ret = __text_append(text, size, &len, "%u|", v32);
+                break;
+            case BIN_FIELD_S32:
+                if (pos + sizeof(sv) > rec_len) {
+                    return -1;
+                }
+                memcpy(&sv, rec + pos, sizeof(sv));
+                pos += sizeof(sv);
+                ret = __text_append(text, size, &len, "%d|", sv);
+                break;
+            case BIN_FIELD_U64:
+                if (pos + sizeof(v64) > rec_len) {
+                    return -1;
+                }
+                memcpy(&v64, rec + pos, sizeof(v64));
+                pos += sizeof(v64);
+                ret = __text_append(text, size, &len, "%llu|", v64);
+                break;
+            case BIN_FIELD_IP4:
+            case BIN_FIELD_IP6:
+                v32 = (type == BIN_FIELD_IP6) ? IP6_LEN : sizeof(u32);
+                if (pos + v32 > rec_len) {
+                    return -1;
+                }
+                memcpy(ip, rec + pos, v32);
+                pos += v32;
+                ip_str((type == BIN_FIELD_IP6) ? AF_INET6 : AF_INET, ip, ip_s, INET6_ADDRSTRLEN);
+                ret = __text_append(text, size, &len, "%s|", (char *)ip_s);
+                break;
+            case BIN_FIELD_STR:
+                if (pos + sizeof(str_len) > rec_len) {
+                    return -1;
+                }
+                str_len = (u8)rec[pos++];
+                if (pos + str_len > rec_len) {
+                    return -1;
+                }
+                memcpy(str, rec + pos, str_len);
+                str[str_len] = 0;
+                pos += str_len;
+                ret = __text_append(text, size, &len, "%s|", str);
+                break;
+            default:
+                return -1;
+        }
+        if (ret) {
+            return -1;
+        }
+    }
+
+    if (__text_append(text, size, &len, "\n")) {
+        return -1;
+    }
+    *rec_len_out = rec_len;
+    return (int)len;
+}
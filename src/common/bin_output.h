@@ -0,0 +1,83 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-08-30
+ * Description: batched output of probe records, text lines or binary frames
+ ******************************************************************************/
+#ifndef __GOPHER_BIN_OUTPUT_H__
+#define __GOPHER_BIN_OUTPUT_H__
+
+#pragma once
+
+#include <stdio.h>
+#include "common.h"
+
+/*
+ * Probe records are buffered and written to the extend probe pipe once per poll cycle, or when the buffer is
+ * nearly full. In text mode the buffer holds the usual "|tbl|v1|...|vn|\n" lines. In binary mode it holds one
+ * frame, a frame header followed by records, and the fields are kept in binary so that the probe does not
+ * format them at all. The daemon decodes each binary record into exactly the text line the probe would print.
+ *
+ * record: | u16 rec_len | u8 tbl_len | tbl | u8 field_type | value | ... |, rec_len includes itself.
+ */
+#define BIN_OUTPUT_MAGIC        0xFE    // never the first byte of a text line(ascii or utf-8)
+#define BIN_OUTPUT_VERSION      1
+#define BIN_OUTPUT_BUF_SIZE     (64 * 1024)     // default pipe capacity, also the max length of a frame
+#define BIN_OUTPUT_REC_MAX      1024            // max length of a record, both text and binary
+#define BIN_OUTPUT_STR_MAX      255     // max length of table names and string fields
+
+struct bin_frame_hdr_s {
+    u8 magic;
+    u8 version;
+    u16 rec_num;
+    u32 len;        // length of the records following the header
+};
+
+enum bin_field_t {
+    BIN_FIELD_U32 = 1,
+    BIN_FIELD_S32,
+    BIN_FIELD_U64,
+    BIN_FIELD_IP4,
+    BIN_FIELD_IP6,
+    BIN_FIELD_STR,  // u8 len + chars, without '\0'
+};
+
+struct bin_output_s {
+    FILE *f;
+    char *buf;
+    u32 len;
+    u32 rec_start;      // offset of the record being written
+    u16 rec_num;
+    char binary;        // 1: binary frames, 0: text lines
+    char overflow;      // the record being written exceeds BIN_OUTPUT_REC_MAX and is dropped
+};
+
+struct bin_output_s *create_bin_output(FILE *f);
+void destroy_bin_output(struct bin_output_s *out);
+void bin_output_set_binary(struct bin_output_s *out, char binary);
+int bin_output_flush(struct bin_output_s *out);
+
+void bin_output_begin(struct bin_output_s *out, const char *tbl);
+void bin_output_u32(struct bin_output_s *out, u32 v);
+void bin_output_s32(struct bin_output_s *out, int v);
+void bin_output_u64(struct bin_output_s *out, u64 v);
+void bin_output_ip(struct bin_output_s *out, u16 family, const void *ip);
+void bin_output_str(struct bin_output_s *out, const char *s);
+void bin_output_end(struct bin_output_s *out);
+
+/*
+ * Decode the binary record at the head of rec(avail bytes) into a text line which ends with '\n' and is
+ * NUL-terminated, *rec_len is set to the length of the record.
+ * Returns the length of the line, or -1 if the record is malformed or the line exceeds size.
+ */
+int bin_record_to_text(const char *rec, u32 avail, u32 *rec_len, char *text, u32 size);
+
+#endif
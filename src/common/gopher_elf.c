@@ -408,8 +408,12 @@ int gopher_get_elf_build_id(const char *elf_file, char build_id[], size_t len)
 
     d_buf = (char *)data->d_buf + __ELF_BUILD_ID_LEN;
     d_size = data->d_size - __ELF_BUILD_ID_LEN;
+    if (len < (d_size * 2 + 1)) {
+        ret = -1;
+        goto err;
+    }
     for (size_t i = 0; i < d_size; i++) {
-        snprintf(build_id + (i * 2), len ,"%02hhx", d_buf[i]);
+        (void)snprintf(build_id + (i * 2), len - (i * 2), "%02hhx", d_buf[i]);
     }
 
 err:
@@ -454,3 +458,49 @@ err:
     return ret;
 }
 
+
+int gopher_get_elf_section_copy(const char *elf_file, const char *sec_name, u64 *sec_addr, char **buf, size_t *len)
+{
+    int ret = 0, elf_fd = -1;
+    Elf *e = NULL;
+    Elf_Scn *sec;
+    Elf_Data *data;
+    GElf_Shdr header;
+
+    *buf = NULL;
+    *len = 0;
+    if (open_elf(elf_file, &e, &elf_fd)) {
+        ret = -1;
+        goto err;
+    }
+
+    sec = gopher_get_elf_section(e, sec_name);
+    if (!sec || !gelf_getshdr(sec, &header) || header.sh_type == SHT_NOBITS) {
+        ret = -1;
+        goto err;
+    }
+
+    data = elf_getdata(sec, NULL);
+    if (!data || !data->d_buf || data->d_size == 0) {
+        ret = -1;
+        goto err;
+    }
+
+    *buf = (char *)malloc(data->d_size);
+    if (*buf == NULL) {
+        ret = -1;
+        goto err;
+    }
+    (void)memcpy(*buf, data->d_buf, data->d_size);
+    *len = data->d_size;
+    *sec_addr = (u64)header.sh_addr;
+
+err:
+    if (e) {
+        elf_end(e);
+    }
+    if (elf_fd >= 0) {
+        close(elf_fd);
+    }
+    return ret;
+}
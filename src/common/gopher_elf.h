@@ -50,5 +50,9 @@ int gopher_iter_elf_file_symb(const char *elf_file, elf_sym_cb cb, void *ctx);
 int gopher_get_elf_symb(const char *elf_file, char *symb_name, u64 *symb_offset);
 int gopher_get_elf_build_id(const char *elf_file, char build_id[], size_t len);
 int gopher_get_elf_debug_link(const char *elf_file, char debug_link[], size_t len);
+/*
+* Copy the content of a section, *buf must be freed by the caller.
+*/
+int gopher_get_elf_section_copy(const char *elf_file, const char *sec_name, u64 *sec_addr, char **buf, size_t *len);
 
 #endif
@@ -36,5 +36,6 @@
 #define H_REPLACE_I(head_ptr, k_int, item_ptr, replaced_item_ptr)   HASH_REPLACE_INT(head_ptr, k_int, item_ptr, replaced_item_ptr)
 
 #define H_ITER(head_ptr, item_ptr, tmp_item_ptr) HASH_ITER(hh, head_ptr, item_ptr, tmp_item_ptr)
+#define H_SORT(head_ptr, cmp_func) HASH_SORT(head_ptr, cmp_func)
 
 #endif
@@ -26,7 +26,8 @@
 #include "daemon.h"
 #include "object.h"
 
-#define RM_MAP_CMD "/usr/bin/find %s/* 2> /dev/null | /usr/bin/xargs rm -f"
+// Only top-level pins are removed, the state maps of probes in sub directories are kept across restarts.
+#define RM_MAP_CMD "/usr/bin/find %s -mindepth 1 -maxdepth 1 ! -type d 2> /dev/null | /usr/bin/xargs rm -f"
 static const ResourceMgr *resouce_msg;
 
 #if GALA_GOPHER_INFO("inner func declaration")
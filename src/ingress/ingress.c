@@ -323,11 +323,14 @@ static int ProcessMetricData(IngressMgr *mgr, const char *content, const char *t
 
     if (mgr->imdbMgr->writeLogsOn) {
         // save metric to imdb
-        rec = IMDB_DataBaseMgrCreateRec(mgr->imdbMgr, table, content);
-        if (rec == NULL) {
+        ret = IMDB_DataBaseMgrCreateRec(mgr->imdbMgr, table, content, &rec);
+        if (ret != 0) {
             ERROR("[INGRESS] insert metric data into imdb failed.\n");
             return -1;
         }
+        if (rec == NULL) {
+            return 0;   // over the cardinality budget, folded into the "other" record of the table
+        }
     }
 
     if (mgr->egressMgr && mgr->egressMgr->metric_kafkaMgr) {
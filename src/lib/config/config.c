@@ -282,6 +282,51 @@ static int ConfigMgrLoadKafkaConfig(void *config, config_setting_t *settings)
     return 0;
 }
 
+static int ConfigMgrLoadCardLimits(IMDBConfig *imdbConfig, config_setting_t *settings)
+{
+    uint32_t ret = 0;
+    int intVal = 0;
+    const char *strVal = NULL;
+    config_setting_t *limits, *limit;
+    CardLimitConfig *cardLimit;
+
+    limits = config_setting_lookup(settings, "cardinality_limits");
+    if (limits == NULL) {
+        return 0;   // optional
+    }
+
+    int count = config_setting_length(limits);
+    if (count > MAX_CARD_LIMITS_NUM) {
+        ERROR("[CONFIG] too many imdb cardinality_limits(%d), max %d.\n", count, MAX_CARD_LIMITS_NUM);
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        limit = config_setting_get_elem(limits, i);
+        cardLimit = &imdbConfig->cardLimits[i];
+
+        ret = config_setting_lookup_string(limit, "table_name", &strVal);
+        if (ret == 0) {
+            ERROR("[CONFIG] load config for imdb cardinality_limits table_name failed.\n");
+            return -1;
+        }
+        (void)snprintf(cardLimit->tableName, sizeof(cardLimit->tableName), "%s", strVal);
+
+        ret = config_setting_lookup_int(limit, "max_series", &intVal);
+        if (ret == 0 || intVal <= 0) {
+            ERROR("[CONFIG] load config for imdb cardinality_limits max_series of %s failed.\n", strVal);
+            return -1;
+        }
+        cardLimit->maxSeries = (uint32_t)intVal;
+
+        ret = config_setting_lookup_int(limit, "top_k", &intVal);
+        cardLimit->topK = (ret == 0 || intVal <= 0) ? 0 : (uint32_t)intVal;
+    }
+    imdbConfig->cardLimitsNum = (uint32_t)count;
+
+    return 0;
+}
+
 static int ConfigMgrLoadIMDBConfig(void *config, config_setting_t *settings)
 {
     IMDBConfig *imdbConfig = (IMDBConfig *)config;
@@ -316,7 +361,7 @@ static int ConfigMgrLoadIMDBConfig(void *config, config_setting_t *settings)
         imdbConfig->recordTimeout = intVal;
     }
 
-    return 0;
+    return ConfigMgrLoadCardLimits(imdbConfig, settings);
 }
 
 static int ConfigMgrLoadWebServerConfig(void *config, config_setting_t *settings)
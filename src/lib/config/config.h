@@ -54,11 +54,21 @@ typedef struct {
     char password[KAFKA_PASSWORD_LEN];
 } KafkaConfig;
 
+#define MAX_CARD_LIMITS_NUM     64
+
+typedef struct {
+    char tableName[MAX_MEASUREMENT_NAME_LEN];
+    uint32_t maxSeries;     // series kept exactly, the others are folded into the "other" record
+    uint32_t topK;          // counters of the top-K sketch, 0 for default
+} CardLimitConfig;
+
 typedef struct  {
     uint32_t maxTablesNum;
     uint32_t maxRecordsNum;
     uint32_t maxMetricsNum;
     uint32_t recordTimeout;
+    uint32_t cardLimitsNum;
+    CardLimitConfig cardLimits[MAX_CARD_LIMITS_NUM];
 } IMDBConfig;
 
 typedef struct {
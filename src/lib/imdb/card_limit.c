@@ -0,0 +1,257 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-09-05
+ * Description: cardinality limiter of imdb tables
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "card_limit.h"
+
+#define IMDB_CARD_WINDOW_DEFAULT    60
+#define FNV_OFFSET_BASIS    0xcbf29ce484222325ULL
+#define FNV_PRIME           0x100000001b3ULL
+
+IMDB_CardLimit *IMDB_CardLimitCreate(uint32_t maxSeries, uint32_t topK, uint32_t window)
+{
+    IMDB_CardLimit *limit;
+
+    if (maxSeries == 0) {
+        return NULL;
+    }
+
+    limit = (IMDB_CardLimit *)malloc(sizeof(IMDB_CardLimit));
+    if (limit == NULL) {
+        return NULL;
+    }
+    memset(limit, 0, sizeof(IMDB_CardLimit));
+
+    limit->maxSeries = maxSeries;
+    limit->topK = (topK == 0) ? IMDB_CARD_TOPK_DEFAULT : topK;
+    limit->window = (window == 0) ? IMDB_CARD_WINDOW_DEFAULT : window;
+    limit->agingTime = time(NULL);
+
+    limit->counters = (IMDB_CardCounter *)malloc(sizeof(IMDB_CardCounter) * limit->topK);
+    if (limit->counters == NULL) {
+        free(limit);
+        return NULL;
+    }
+    memset(limit->counters, 0, sizeof(IMDB_CardCounter) * limit->topK);
+
+    limit->folded = (IMDB_CardFolded *)malloc(sizeof(IMDB_CardFolded) * (limit->maxSeries + limit->topK));
+    if (limit->folded == NULL) {
+        free(limit->counters);
+        free(limit);
+        return NULL;
+    }
+    memset(limit->folded, 0, sizeof(IMDB_CardFolded) * (limit->maxSeries + limit->topK));
+    return limit;
+}
+
+void IMDB_CardLimitDestroy(IMDB_CardLimit *limit)
+{
+    IMDB_CardSeries *series, *tmp;
+
+    if (limit == NULL) {
+        return;
+    }
+
+    H_ITER(limit->series, series, tmp) {
+        H_DEL(limit->series, series);
+        free(series);
+    }
+    HASH_CLEAR(hh, limit->counterTbl);  // counters are freed at once
+    free(limit->counters);
+    HASH_CLEAR(hh, limit->foldedTbl);
+    free(limit->folded);
+    free(limit);
+    return;
+}
+
+uint64_t IMDB_CardKeyHash(const char *key, uint32_t keySize)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+
+    for (uint32_t i = 0; i < keySize; i++) {
+        hash ^= (uint8_t)key[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// Release idle series and halve all the counts, so that old heavy keys do not hold their place forever.
+static void CardLimitAging(IMDB_CardLimit *limit, time_t now)
+{
+    IMDB_CardSeries *series, *tmp;
+    uint64_t minCount = UINT64_MAX;
+
+    if (now < limit->agingTime + (time_t)limit->window) {
+        return;
+    }
+    limit->agingTime = now;
+
+    H_ITER(limit->series, series, tmp) {
+        if (series->lastTime + (time_t)limit->window < now) {
+            H_DEL(limit->series, series);
+            free(series);
+            limit->seriesNum--;
+            continue;
+        }
+        series->count = (series->count + 1) >> 1;
+        minCount = (series->count < minCount) ? series->count : minCount;
+    }
+    limit->minCount = (limit->seriesNum == 0) ? 0 : minCount;
+
+    for (uint32_t i = 0; i < limit->countersNum; i++) {
+        limit->counters[i].count >>= 1;
+        limit->counters[i].err >>= 1;
+    }
+    return;
+}
+
+static IMDB_CardSeries *CardLimitLightestSeries(IMDB_CardLimit *limit)
+{
+    IMDB_CardSeries *series, *tmp, *lightest = NULL;
+
+    H_ITER(limit->series, series, tmp) {
+        if (lightest == NULL || series->count < lightest->count) {
+            lightest = series;
+        }
+    }
+    limit->minCount = (lightest == NULL) ? 0 : lightest->count;
+    return lightest;
+}
+
+static int CardLimitAddSeries(IMDB_CardLimit *limit, uint64_t key, uint64_t count, time_t now)
+{
+    IMDB_CardSeries *series = (IMDB_CardSeries *)malloc(sizeof(IMDB_CardSeries));
+    if (series == NULL) {
+        return -1;
+    }
+    memset(series, 0, sizeof(IMDB_CardSeries));
+    series->key = key;
+    series->count = count;
+    series->lastTime = now;
+    H_ADD(limit->series, key, sizeof(uint64_t), series);
+    limit->seriesNum++;
+
+    if (count < limit->minCount) {
+        limit->minCount = count;
+    }
+    return 0;
+}
+
+// space-saving: the lightest counter is taken over by a new key, inheriting its count as the error.
+static IMDB_CardCounter *CardLimitCount(IMDB_CardLimit *limit, uint64_t key)
+{
+    IMDB_CardCounter *counter = NULL;
+
+    H_FIND(limit->counterTbl, &key, sizeof(uint64_t), counter);
+    if (counter != NULL) {
+        counter->count++;
+        return counter;
+    }
+
+    if (limit->countersNum < limit->topK) {
+        counter = &limit->counters[limit->countersNum++];
+        counter->key = key;
+        counter->count = 1;
+        counter->err = 0;
+        H_ADD(limit->counterTbl, key, sizeof(uint64_t), counter);
+        return counter;
+    }
+
+    counter = &limit->counters[0];
+    for (uint32_t i = 1; i < limit->countersNum; i++) {
+        if (limit->counters[i].count < counter->count) {
+            counter = &limit->counters[i];
+        }
+    }
+    H_DEL(limit->counterTbl, counter);
+    counter->key = key;
+    counter->err = counter->count;
+    counter->count++;
+    H_ADD(limit->counterTbl, key, sizeof(uint64_t), counter);
+    return counter;
+}
+
+IMDB_CardVerdict IMDB_CardLimitAdmit(IMDB_CardLimit *limit, uint64_t key, time_t now)
+{
+    IMDB_CardSeries *series = NULL;
+    IMDB_CardCounter *counter;
+    uint64_t guaranteed;
+
+    CardLimitAging(limit, now);
+
+    H_FIND(limit->series, &key, sizeof(uint64_t), series);
+    if (series != NULL) {
+        series->count++;
+        series->lastTime = now;
+        return IMDB_CARD_PASS;
+    }
+
+    if (limit->seriesNum < limit->maxSeries) {
+        return (CardLimitAddSeries(limit, key, 1, now) == 0) ? IMDB_CARD_PASS : IMDB_CARD_FOLD;
+    }
+
+    counter = CardLimitCount(limit, key);
+    guaranteed = counter->count - counter->err;
+    if (guaranteed <= limit->minCount) {
+        limit->foldedNum++;
+        return IMDB_CARD_FOLD;
+    }
+
+    // minCount is only a lower bound, compare with the real lightest series.
+    series = CardLimitLightestSeries(limit);
+    if (series == NULL || guaranteed <= series->count) {
+        limit->foldedNum++;
+        return IMDB_CARD_FOLD;
+    }
+
+    H_DEL(limit->series, series);
+    series->key = key;
+    series->count = guaranteed;
+    series->lastTime = now;
+    H_ADD(limit->series, key, sizeof(uint64_t), series);
+
+    // The counter is left as the lightest one, to be taken over by the next new key.
+    counter->count = 0;
+    counter->err = 0;
+    (void)CardLimitLightestSeries(limit);
+    return IMDB_CARD_PASS;
+}
+
+/*
+ * Record that series 'key' is folded into the "other" record. Returns 1 if a new period starts, that is
+ * 'newPeriod' is set, the series has been folded in the current period already or too many series are folded,
+ * then the "other" record shall be rebuilt from this series.
+ */
+int IMDB_CardLimitFoldSeries(IMDB_CardLimit *limit, uint64_t key, char newPeriod)
+{
+    IMDB_CardFolded *folded = NULL;
+
+    if (!newPeriod) {
+        H_FIND(limit->foldedTbl, &key, sizeof(uint64_t), folded);
+        newPeriod = (folded != NULL || limit->foldedSeriesNum >= limit->maxSeries + limit->topK) ? 1 : 0;
+    }
+
+    if (newPeriod) {
+        HASH_CLEAR(hh, limit->foldedTbl);
+        limit->foldedSeriesNum = 0;
+    }
+
+    folded = &limit->folded[limit->foldedSeriesNum++];
+    folded->key = key;
+    H_ADD(limit->foldedTbl, key, sizeof(uint64_t), folded);
+    return newPeriod ? 1 : 0;
+}
@@ -0,0 +1,88 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-09-05
+ * Description: cardinality limiter of imdb tables
+ ******************************************************************************/
+#ifndef __IMDB_CARD_LIMIT_H__
+#define __IMDB_CARD_LIMIT_H__
+
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+#include "hash.h"
+
+/*
+ * A table admits at most 'maxSeries' series(distinct record keys) exactly. Once the budget is used up, the keys
+ * of the new series are counted by a space-saving sketch of 'topK' counters: a key whose guaranteed count
+ * exceeds the lightest exact series takes its place, all the others are folded into the "other" record.
+ *
+ * Series are identified by a 64-bit hash of the record key, series idle for 'window' seconds are released and
+ * all the counts are halved every window, so that the memory is bounded by maxSeries + topK entries.
+ *
+ * The "other" record sums the last report of each folded series in the current period. A period ends when a
+ * folded series reports again (or the "other" record has been output), then the "other" record is rebuilt.
+ * The folded series of a period are tracked in at most maxSeries + topK entries as well.
+ */
+#define IMDB_CARD_TOPK_DEFAULT      64
+#define IMDB_CARD_OTHER             "other"
+#define IMDB_CARD_DROPPED_METRIC    "dropped_series"
+
+typedef enum {
+    IMDB_CARD_PASS = 0,
+    IMDB_CARD_FOLD
+} IMDB_CardVerdict;
+
+typedef struct {
+    uint64_t key;
+    uint64_t count;
+    time_t lastTime;
+    H_HANDLE;
+} IMDB_CardSeries;
+
+typedef struct {
+    uint64_t key;
+    uint64_t count;
+    uint64_t err;               // over-estimation of count inherited from the evicted key
+    H_HANDLE;
+} IMDB_CardCounter;
+
+typedef struct {
+    uint64_t key;
+    H_HANDLE;
+} IMDB_CardFolded;
+
+typedef struct {
+    uint32_t maxSeries;
+    uint32_t topK;
+    uint32_t window;            // Unit: second
+    uint32_t seriesNum;
+    uint32_t countersNum;
+    uint64_t minCount;          // lower bound of the count of the exact series
+    time_t agingTime;
+    uint64_t foldedNum;         // records folded since created
+    uint32_t foldedSeriesNum;   // series folded in the current period
+    IMDB_CardSeries *series;
+    IMDB_CardCounter *counterTbl;
+    IMDB_CardCounter *counters; // topK counters allocated once
+    IMDB_CardFolded *foldedTbl;
+    IMDB_CardFolded *folded;    // maxSeries + topK entries allocated once
+} IMDB_CardLimit;
+
+IMDB_CardLimit *IMDB_CardLimitCreate(uint32_t maxSeries, uint32_t topK, uint32_t window);
+void IMDB_CardLimitDestroy(IMDB_CardLimit *limit);
+
+uint64_t IMDB_CardKeyHash(const char *key, uint32_t keySize);
+IMDB_CardVerdict IMDB_CardLimitAdmit(IMDB_CardLimit *limit, uint64_t key, time_t now);
+int IMDB_CardLimitFoldSeries(IMDB_CardLimit *limit, uint64_t key, char newPeriod);
+
+#endif
@@ -58,6 +58,24 @@ IMDB_Metric *IMDB_MetricCreate(char *name, char *description, char *type)
 int IMDB_MetricSetValue(IMDB_Metric *metric, char *val)
 {
     int ret = 0;
+
+    // Histogram values grow with their buckets, they are allocated apart so that other metrics stay small.
+    if (!strcmp(metric->type, METRIC_TYPE_HISTOGRAM)) {
+        if (metric->histoVal != NULL) {
+            free(metric->histoVal);
+            metric->histoVal = NULL;
+        }
+        if (strlen(val) >= MAX_IMDB_HISTO_VAL_LEN) {
+            return -1;
+        }
+        if (strcmp(val, INVALID_METRIC_VALUE)) {
+            metric->histoVal = strdup(val);
+            if (metric->histoVal == NULL) {
+                return -1;
+            }
+        }
+    }
+
     ret = snprintf(metric->val, MAX_IMDB_METRIC_VAL_LEN, val);
     if (ret < 0) {
         return -1;
@@ -72,6 +90,9 @@ void IMDB_MetricDestroy(IMDB_Metric *metric)
         return;
     }
 
+    if (metric->histoVal != NULL) {
+        free(metric->histoVal);
+    }
     free(metric);
     return;
 }
@@ -212,10 +233,136 @@ int IMDB_TableSetRecordKeySize(IMDB_Table *table, uint32_t keyNum)
     return 0;
 }
 
+int IMDB_TableSetCardLimit(IMDB_Table *table, uint32_t maxSeries, uint32_t topK)
+{
+    IMDB_CardLimitDestroy(table->cardLimit);
+    table->cardLimit = IMDB_CardLimitCreate(maxSeries, topK, g_recordTimeout);
+    return (table->cardLimit == NULL) ? -1 : 0;
+}
+
+// Records of a limited table reserve one more metric for the dropped series counter of the "other" record.
+static uint32_t IMDB_TableRecordCapacity(const IMDB_Table *table)
+{
+    return table->meta->metricsCapacity + ((table->cardLimit != NULL) ? 1 : 0);
+}
+
+static char IMDB_IsNumber(const char *val, char digitsOnly)
+{
+    char *end;
+
+    if (val[0] == 0) {
+        return 0;
+    }
+    if (digitsOnly) {
+        return (strspn(val, "0123456789") == strlen(val)) ? 1 : 0;
+    }
+    (void)strtod(val, &end);
+    return (*end == 0) ? 1 : 0;
+}
+
+static void IMDB_MetricAddValue(IMDB_Metric *metric, const char *val)
+{
+    if (!strcmp(val, INVALID_METRIC_VALUE)) {
+        return;
+    }
+
+    if (!strcmp(metric->val, INVALID_METRIC_VALUE)) {
+        (void)snprintf(metric->val, sizeof(metric->val), "%s", val);
+    } else if (IMDB_IsNumber(metric->val, 1) && IMDB_IsNumber(val, 1)) {
+        (void)snprintf(metric->val, sizeof(metric->val), "%llu",
+                       strtoull(metric->val, NULL, 10) + strtoull(val, NULL, 10));
+    } else if (IMDB_IsNumber(metric->val, 0) && IMDB_IsNumber(val, 0)) {
+        (void)snprintf(metric->val, sizeof(metric->val), "%.15g", strtod(metric->val, NULL) + strtod(val, NULL));
+    }
+    return;
+}
+
+/*
+ * Turn record into the "other" record of the table: keys are set to "other", labels and histograms are dropped,
+ * counters and gauges are kept to be summed up.
+ */
+static int IMDB_RecordSetOther(IMDB_Record *record)
+{
+    uint32_t keyIdx = 0;
+
+    memset(record->key, 0, record->keySize);
+    for (int i = 0; i < record->metricsNum; i++) {
+        IMDB_Metric *metric = record->metrics[i];
+        if (!strcmp(metric->type, METRIC_TYPE_KEY)) {
+            if (IMDB_RecordAppendKey(record, keyIdx, IMDB_CARD_OTHER) < 0) {
+                return -1;
+            }
+            keyIdx++;
+            (void)snprintf(metric->val, sizeof(metric->val), "%s", IMDB_CARD_OTHER);
+        } else if (strcmp(metric->type, "counter") && strcmp(metric->type, "gauge")) {
+            (void)IMDB_MetricSetValue(metric, INVALID_METRIC_VALUE);
+        }
+    }
+    return 0;
+}
+
+static int IMDB_TableFoldRecord(IMDB_Table *table, IMDB_Record *record, uint64_t key)
+{
+    IMDB_Record *other;
+    IMDB_Metric *dropped;
+    char droppedVal[INT_LEN];
+
+    if (IMDB_RecordSetOther(record)) {
+        return -1;
+    }
+
+    // A new period starts if the "other" record of the last period has been output or the series reports again.
+    other = HASH_findRecord((const IMDB_Record **)table->records, (const IMDB_Record *)record);
+    if (IMDB_CardLimitFoldSeries(table->cardLimit, key, (other == NULL) ? 1 : 0) && other != NULL) {
+        HASH_deleteRecord(table->records, other);
+        IMDB_RecordDestroy(other);
+        other = NULL;
+    }
+    (void)snprintf(droppedVal, sizeof(droppedVal), "%u", table->cardLimit->foldedSeriesNum);
+
+    if (other == NULL) {
+        if (HASH_recordCount((const IMDB_Record **)table->records) >= table->recordsCapability) {
+            ERROR("[IMDB] Can not add other record to table %s: table full.\n", table->name);
+            return -1;
+        }
+        dropped = IMDB_MetricCreate(IMDB_CARD_DROPPED_METRIC, "Series folded into the other record in the period",
+                                    "gauge");
+        if (dropped == NULL) {
+            return -1;
+        }
+        (void)IMDB_MetricSetValue(dropped, droppedVal);
+        if (IMDB_RecordAddMetric(record, dropped)) {
+            IMDB_MetricDestroy(dropped);
+            return -1;
+        }
+        IMDB_RecordUpdateTime(record, (time_t)time(NULL));
+        HASH_addRecord(table->records, record);
+        return IMDB_RECORD_FOLDED;
+    }
+
+    // Both records are built from the table meta, the dropped series gauge is the last metric of other.
+    for (int i = 0; i < record->metricsNum && i < other->metricsNum; i++) {
+        IMDB_MetricAddValue(other->metrics[i], record->metrics[i]->val);
+    }
+    if (other->metricsNum > record->metricsNum) {
+        (void)IMDB_MetricSetValue(other->metrics[other->metricsNum - 1], droppedVal);
+    }
+    IMDB_RecordUpdateTime(other, (time_t)time(NULL));
+    IMDB_RecordDestroy(record);
+    return IMDB_RECORD_FOLDED;
+}
+
 int IMDB_TableAddRecord(IMDB_Table *table, IMDB_Record *record)
 {
     IMDB_Record *old_record;
 
+    if (table->cardLimit != NULL) {
+        uint64_t key = IMDB_CardKeyHash(record->key, record->keySize);
+        if (IMDB_CardLimitAdmit(table->cardLimit, key, time(NULL)) == IMDB_CARD_FOLD) {
+            return IMDB_TableFoldRecord(table, record, key);
+        }
+    }
+
     old_record = HASH_findRecord((const IMDB_Record **)table->records, (const IMDB_Record *)record);
     if (old_record != NULL) {
         HASH_deleteRecord(table->records, old_record);
@@ -247,6 +394,7 @@ void IMDB_TableDestroy(IMDB_Table *table)
         IMDB_RecordDestroy(table->meta);
     }
 
+    IMDB_CardLimitDestroy(table->cardLimit);
     free(table);
     return;
 }
@@ -534,14 +682,15 @@ ERR:
     return -1;
 }
 
-IMDB_Record* IMDB_DataBaseMgrCreateRec(IMDB_DataBaseMgr *mgr, IMDB_Table *table, const char *content)
+int IMDB_DataBaseMgrCreateRec(IMDB_DataBaseMgr *mgr, IMDB_Table *table, const char *content, IMDB_Record **rec)
 {
     pthread_rwlock_wrlock(&mgr->rwlock);
 
     int ret = 0;
     IMDB_Record *record;
 
-    record = IMDB_RecordCreateWithKey(table->meta->metricsCapacity, table->recordKeySize);
+    *rec = NULL;
+    record = IMDB_RecordCreateWithKey(IMDB_TableRecordCapacity(table), table->recordKeySize);
     if (record == NULL) {
         goto ERR;
     }
@@ -552,12 +701,17 @@ IMDB_Record* IMDB_DataBaseMgrCreateRec(IMDB_DataBaseMgr *mgr, IMDB_Table *table,
         goto ERR;
     }
     ret = IMDB_TableAddRecord(table, record);
+    if (ret == IMDB_RECORD_FOLDED) {
+        pthread_rwlock_unlock(&mgr->rwlock);
+        return 0;   // folded into the "other" record
+    }
     if (ret != 0) {
         goto ERR;
     }
 
     pthread_rwlock_unlock(&mgr->rwlock);
-    return record;
+    *rec = record;
+    return 0;
 
 ERR:
     pthread_rwlock_unlock(&mgr->rwlock);
@@ -565,7 +719,7 @@ ERR:
         IMDB_RecordDestroy(record);
     }
 
-    return NULL;
+    return -1;
 }
 
 int IMDB_DataBaseMgrAddRecord(IMDB_DataBaseMgr *mgr, char *recordStr)
@@ -620,7 +774,7 @@ int IMDB_DataBaseMgrAddRecord(IMDB_DataBaseMgr *mgr, char *recordStr)
                 goto ERR;
             }
 
-            record = IMDB_RecordCreateWithKey(table->meta->metricsCapacity, table->recordKeySize);
+            record = IMDB_RecordCreateWithKey(IMDB_TableRecordCapacity(table), table->recordKeySize);
             if (record == NULL) {
                 ERROR("[IMDB] Can not create record.\n");
                 free(buffer_head);
@@ -673,6 +827,10 @@ int IMDB_DataBaseMgrAddRecord(IMDB_DataBaseMgr *mgr, char *recordStr)
     }
 
     ret = IMDB_TableAddRecord(table, record);
+    if (ret == IMDB_RECORD_FOLDED) {
+        record = NULL;
+        ret = 0;
+    }
     if (ret != 0) {
         free(buffer_head);
         goto ERR;
@@ -775,6 +933,87 @@ static int IMDB_BuildPrometheusMetrics(const IMDB_Metric *metric, char *buffer,
     return (int)((int)maxLen - size);   // Returns the number of printed characters
 }
 
+static int IMDB_ParseHistogram(const char *val, u64 *sum, u64 *count, u64 *bound, u64 buckets[], int *bucketsNum)
+{
+    char *end;
+    const char *p = val;
+    u64 *heads[] = {sum, count, bound};
+
+    for (int i = 0; i < sizeof(heads) / sizeof(heads[0]); i++) {
+        *heads[i] = strtoull(p, &end, 10);
+        if (end == p) {
+            return -1;
+        }
+        p = end;
+    }
+
+    *bucketsNum = 0;
+    while (*bucketsNum < IMDB_HISTO_BUCKETS_MAX) {
+        buckets[*bucketsNum] = strtoull(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        p = end;
+        (*bucketsNum)++;
+    }
+    return (*bound == 0) ? -1 : 0;
+}
+
+/*
+ * eg: gala_gopher_block_latency_req_bucket{label,le="2000"} 3 1586960586000
+ *     gala_gopher_block_latency_req_bucket{label,le="+Inf"} 5 1586960586000
+ *     gala_gopher_block_latency_req_sum{label} 12000 1586960586000
+ *     gala_gopher_block_latency_req_count{label} 5 1586960586000
+ */
+static int IMDB_BuildPrometheusHistogram(const IMDB_Metric *metric, char *buffer, uint32_t maxLen,
+                                         const char *entity_name, const char *labels)
+{
+    int ret, bucketsNum;
+    char *p = buffer;
+    int size = (int)maxLen;
+    int labelsLen = (int)strlen(labels) - 1;    // without the closing '}'
+    char name[MAX_IMDB_TABLE_NAME_LEN + MAX_IMDB_METRIC_NAME_LEN + 16];
+    u64 sum, count, bound, cumulative = 0;
+    u64 buckets[IMDB_HISTO_BUCKETS_MAX];
+    long long ts;
+    time_t now;
+
+    if (labelsLen < 0 || metric->histoVal == NULL ||
+        IMDB_ParseHistogram(metric->histoVal, &sum, &count, &bound, buckets, &bucketsNum)) {
+        return 0;   // Invalid value, skip it
+    }
+
+    ret = IMDB_BuildMetrics(entity_name, metric->name, name, sizeof(name));
+    if (ret < 0) {
+        return ret;
+    }
+    (void)time(&now);
+    ts = now * THOUSAND;
+
+    for (int i = 0; i < bucketsNum && (bound << i) > 0; i++) {
+        cumulative += buckets[i];
+        ret = __snprintf(&p, size, &size, "%s_bucket%.*s,le=\"%llu\"} %llu %lld\n",
+                         name, labelsLen, labels, bound << i, cumulative, ts);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+    ret = __snprintf(&p, size, &size, "%s_bucket%.*s,le=\"+Inf\"} %llu %lld\n", name, labelsLen, labels, count, ts);
+    if (ret < 0) {
+        return ret;
+    }
+    ret = __snprintf(&p, size, &size, "%s_sum%s %llu %lld\n", name, labels, sum, ts);
+    if (ret < 0) {
+        return ret;
+    }
+    ret = __snprintf(&p, size, &size, "%s_count%s %llu %lld\n", name, labels, count, ts);
+    if (ret < 0) {
+        return ret;
+    }
+
+    return (int)((int)maxLen - size);
+}
+
 
 static int IMDB_BuildPrometheusLabel(IMDB_DataBaseMgr *mgr,
                                      IMDB_Record *record,
@@ -953,7 +1192,11 @@ static int IMDB_Rec2Prometheus(IMDB_DataBaseMgr *mgr, IMDB_Record *record, char
             continue;
         }
 
-        ret = IMDB_BuildPrometheusMetrics(record->metrics[i], curBuffer, curMaxLen, entity_name, labels);
+        if (strcmp(record->metrics[i]->type, METRIC_TYPE_HISTOGRAM) == 0) {
+            ret = IMDB_BuildPrometheusHistogram(record->metrics[i], curBuffer, curMaxLen, entity_name, labels);
+        } else {
+            ret = IMDB_BuildPrometheusMetrics(record->metrics[i], curBuffer, curMaxLen, entity_name, labels);
+        }
         if (ret < 0) {
             break;  /* buffer is full, break loop */
         }
@@ -1099,7 +1342,8 @@ int IMDB_Record2Json(const IMDB_DataBaseMgr *mgr, const IMDB_Table *table, const
     }
 
     for (int i = 0; i < record->metricsNum; i++) {
-        ret = snprintf(json_cursor, maxLen, ", \"%s\": \"%s\"", record->metrics[i]->name, record->metrics[i]->val);
+        ret = snprintf(json_cursor, maxLen, ", \"%s\": \"%s\"", record->metrics[i]->name,
+                       (record->metrics[i]->histoVal != NULL) ? record->metrics[i]->histoVal : record->metrics[i]->val);
         if (ret < 0)  {
             return -1;
         }
@@ -21,6 +21,7 @@
 #include <pthread.h>
 #include "base.h"
 #include "hash.h"
+#include "card_limit.h"
 
 #define MAX_IMDB_DATABASEMGR_CAPACITY   256
 // metric specification
@@ -44,11 +45,23 @@
 
 #define METRIC_TYPE_LABEL "label"
 #define METRIC_TYPE_KEY "key"
+#define METRIC_TYPE_HISTOGRAM "histogram"
+
+/*
+ * Value of a histogram metric: "<sum> <count> <bound> <count_0> <count_1> ... <count_n>"
+ * The upper bound of bucket i is (bound << i), bucket counts are not cumulative and values above the
+ * last bucket are only counted in <count>. Buckets after the last non-empty one may be omitted.
+ */
+#define IMDB_HISTO_BUCKETS_MAX  64
+#define MAX_IMDB_HISTO_VAL_LEN  ((3 + IMDB_HISTO_BUCKETS_MAX) * 21)    // 20 digits of a u64 and a separator each
 
 #define THOUSAND        1000
 
 #define INVALID_METRIC_VALUE "(null)"
 
+// IMDB_TableAddRecord() returns it if the record is folded into the "other" record, the record is then freed.
+#define IMDB_RECORD_FOLDED      1
+
 // NUMS OF RECORD TO STRING EVERY PERIOD
 #define DEFAULT_PERIOD_RECORD_NUM       100
 
@@ -64,6 +77,7 @@ typedef struct {
     char type[MAX_IMDB_METRIC_TYPE_LEN];
     char name[MAX_IMDB_METRIC_NAME_LEN];
     char val[MAX_IMDB_METRIC_VAL_LEN];
+    char *histoVal;         // whole value of a histogram metric, val only keeps its head
 } IMDB_Metric;
 
 typedef struct {
@@ -85,6 +99,7 @@ typedef struct {
     uint32_t recordsCapability;     // Capability for records count in one table
     uint32_t recordKeySize;
     IMDB_Record **records;
+    IMDB_CardLimit *cardLimit;      // NULL if the cardinality of the table is not limited
 } IMDB_Table;
 
 typedef struct {
@@ -135,6 +150,7 @@ IMDB_Table *IMDB_TableCreate(char *name, uint32_t capacity);
 void IMDB_TableSetEntityName(IMDB_Table *table, char *entity_name);
 int IMDB_TableSetMeta(IMDB_Table *table, IMDB_Record *metaRecord);
 int IMDB_TableSetRecordKeySize(IMDB_Table *table, uint32_t keyNum);
+int IMDB_TableSetCardLimit(IMDB_Table *table, uint32_t maxSeries, uint32_t topK);
 int IMDB_TableAddRecord(IMDB_Table *table, IMDB_Record *record);
 void IMDB_TableDestroy(IMDB_Table *table);
 
@@ -146,7 +162,7 @@ int IMDB_DataBaseMgrAddTable(IMDB_DataBaseMgr *mgr, IMDB_Table* table);
 IMDB_Table *IMDB_DataBaseMgrFindTable(IMDB_DataBaseMgr *mgr, const char *tableName);
 
 int IMDB_DataBaseMgrAddRecord(IMDB_DataBaseMgr *mgr, char *recordStr);
-IMDB_Record* IMDB_DataBaseMgrCreateRec(IMDB_DataBaseMgr *mgr, IMDB_Table *table, const char *content);
+int IMDB_DataBaseMgrCreateRec(IMDB_DataBaseMgr *mgr, IMDB_Table *table, const char *content, IMDB_Record **rec);
 int IMDB_DataBase2Prometheus(IMDB_DataBaseMgr *mgr, char *buffer, uint32_t maxLen, uint32_t *buf_len);
 int IMDB_DataStr2Json(IMDB_DataBaseMgr *mgr, const char *recordStr, char *jsonStr, uint32_t jsonStrLen);
 int IMDB_Record2Json(const IMDB_DataBaseMgr *mgr, const IMDB_Table *table, const IMDB_Record *record,
@@ -419,7 +419,8 @@ static int is_filed_type_metric(char *field_type)
 
     const char meta_fileld_type_metric[][MAX_FIELD_TYPE_LEN] = {
         "counter",
-        "gauge"
+        "gauge",
+        "histogram"
     };
     int size = sizeof(meta_fileld_type_metric) / sizeof(meta_fileld_type_metric[0]);
 
@@ -15,14 +15,17 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <errno.h>
 #include <sys/prctl.h>
 #include <unistd.h>
 
 #include "probe_mng.h"
+#include "bin_output.h"
 
 #define PROBE_START_DELAY 5
 #define PROBE_LKUP_PID_RETRY_MAX 2
 #define PROBE_LKUP_PID_DELAY 2
+#define EXTEND_PROBE_READ_BUF_SIZE (2 * BIN_OUTPUT_BUF_SIZE)
 
 FILE* __DoRunExtProbe(struct probe_s *probe)
 {
@@ -109,31 +112,122 @@ static void sendOutputToIngresss(struct probe_s *probe, char *buffer, uint32_t b
     }
 }
 
-static void parseExtendProbeOutput(struct probe_s *probe, FILE *f)
+static void __handle_text_line(struct probe_s *probe, const char *line, uint32_t len)
 {
-    int ret = 0;
     char buffer[MAX_DATA_STR_LEN];
-    uint32_t bufferSize = 0;
 
-    while (feof(f) == 0 && ferror(f) == 0) {
-        if (IS_STOPPING_PROBE(probe)) {
-            break;
+    if (len >= MAX_DATA_STR_LEN) {
+        ERROR("[E-PROBE %s] stdout buf(len:%u) is too long\n", probe->name, len);
+        return;
+    }
+    (void)memcpy(buffer, line, len);
+    buffer[len] = 0;
+
+    if (buffer[0] != '|') {
+        convert_output_to_log(buffer, MAX_DATA_STR_LEN);
+        return;
+    }
+    sendOutputToIngresss(probe, buffer, len);
+}
+
+static int __handle_bin_frame(struct probe_s *probe, const char *frame, uint32_t len)
+{
+    char buffer[MAX_DATA_STR_LEN];
+    uint32_t pos = 0, rec_len;
+    int text_len;
+
+    while (pos < len) {
+        text_len = bin_record_to_text(frame + pos, len - pos, &rec_len, buffer, MAX_DATA_STR_LEN);
+        if (text_len < 0) {
+            ERROR("[E-PROBE %s] invalid binary record at %u of frame(len:%u).\n", probe->name, pos, len);
+            return -1;
         }
-        if (fgets(buffer, sizeof(buffer), f) == NULL) {
+        sendOutputToIngresss(probe, buffer, (uint32_t)text_len);
+        pos += rec_len;
+    }
+    return 0;
+}
+
+/*
+ * Handle text lines and binary frames in buf, returns the number of bytes consumed.
+ * An incomplete line or frame at the tail is left for the next read.
+ */
+static uint32_t __handle_probe_output(struct probe_s *probe, const char *buf, uint32_t len)
+{
+    struct bin_frame_hdr_s hdr;
+    uint32_t pos = 0;
+    const char *eol;
+
+    while (pos < len) {
+        if ((unsigned char)buf[pos] != BIN_OUTPUT_MAGIC) {
+            eol = memchr(buf + pos, '\n', len - pos);
+            if (eol == NULL) {
+                break;
+            }
+            __handle_text_line(probe, buf + pos, (uint32_t)(eol - buf - pos + 1));
+            pos = (uint32_t)(eol - buf + 1);
             continue;
         }
 
-        if (buffer[0] != '|') {
-            convert_output_to_log(buffer, MAX_DATA_STR_LEN);
-            continue;
+        if (len - pos < sizeof(hdr)) {
+            break;
+        }
+        (void)memcpy(&hdr, buf + pos, sizeof(hdr));
+        if (hdr.version != BIN_OUTPUT_VERSION || hdr.len > BIN_OUTPUT_BUF_SIZE - sizeof(hdr)) {
+            // Unable to find the next frame, drop the buffered output.
+            ERROR("[E-PROBE %s] invalid binary frame(version:%u, len:%u).\n", probe->name, hdr.version, hdr.len);
+            return len;
         }
+        if (len - pos < sizeof(hdr) + hdr.len) {
+            break;
+        }
+        (void)__handle_bin_frame(probe, buf + pos + sizeof(hdr), hdr.len);
+        pos += sizeof(hdr) + hdr.len;
+    }
+    return pos;
+}
 
-        if ((bufferSize = strlen(buffer)) >= MAX_DATA_STR_LEN) {
-            ERROR("[E-PROBE %s] stdout buf(len:%u) is too long\n", probe->name, bufferSize);
-            continue;
+/*
+ * Probe output is read in bulk instead of line by line, a batch of records written by the probe at once
+ * takes one read(). Text lines and binary frames(refer to bin_output.h) can be mixed in the output.
+ */
+static void parseExtendProbeOutput(struct probe_s *probe, FILE *f)
+{
+    int fd = fileno(f);
+    char *buf;
+    uint32_t len = 0, consumed;
+    ssize_t n;
+
+    buf = (char *)malloc(EXTEND_PROBE_READ_BUF_SIZE);
+    if (buf == NULL) {
+        ERROR("[E-PROBE %s] malloc output buf failed.\n", probe->name);
+        return;
+    }
+
+    while (!IS_STOPPING_PROBE(probe)) {
+        n = read(fd, buf + len, EXTEND_PROBE_READ_BUF_SIZE - len);
+        if (n == 0) {
+            break;
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        len += (uint32_t)n;
+
+        consumed = __handle_probe_output(probe, buf, len);
+        if (consumed == 0 && len == EXTEND_PROBE_READ_BUF_SIZE) {
+            ERROR("[E-PROBE %s] stdout buf(len:%u) is too long\n", probe->name, len);
+            consumed = len;
+        }
+        len -= consumed;
+        if (len > 0 && consumed > 0) {
+            (void)memmove(buf, buf + consumed, len);
         }
-        sendOutputToIngresss(probe, buffer, bufferSize);
     }
+    free(buf);
 }
 
 int RunExtendProbe(struct probe_s *probe)
@@ -35,7 +35,8 @@ struct param_flags_s param_l7pro_flags[] = {
     {"mysql",   L7PROBE_TRACING_MYSQL},
     {"pgsql",   L7PROBE_TRACING_PGSQL},
     {"kafka",   L7PROBE_TRACING_KAFKA},
-    {"mongo",   L7PROBE_TRACING_MONGO}
+    {"mongo",   L7PROBE_TRACING_MONGO},
+    {"http2",   L7PROBE_TRACING_HTTP2}
 };
 
 struct param_flags_s param_metrics_flags[] = {
@@ -362,6 +363,19 @@ static int parser_perf_sample_period(struct probe_s *probe, struct param_key_s *
     return 0;
 }
 
+static int parser_mem_sample_kb(struct probe_s *probe, struct param_key_s *param_key, const cJSON *key_item)
+{
+    int value = (int)key_item->valueint;
+    if (value < param_key->v.min || value > param_key->v.max) {
+        PARSE_ERR("params.%s invalid value, must be in [%d, %d]",
+                  param_key->key, param_key->v.min, param_key->v.max);
+        return -1;
+    }
+
+    probe->probe_param.mem_sample_kb = (u32)value;
+    return 0;
+}
+
 static int parser_sysdebuging_dir(struct probe_s *probe, struct param_key_s *param_key, const cJSON *key_item)
 {
     const char *value = (const char*)key_item->valuestring;
@@ -426,6 +440,32 @@ static int parser_continuous_sampling(struct probe_s *probe, struct param_key_s
     return 0;
 }
 
+static int parser_dwarf_unwind(struct probe_s *probe, struct param_key_s *param_key, const cJSON *key_item)
+{
+    int value = (int)key_item->valueint;
+    if (value < param_key->v.min || value > param_key->v.max) {
+        PARSE_ERR("params.%s invalid value, must be in [%d, %d]",
+                  param_key->key, param_key->v.min, param_key->v.max);
+        return -1;
+    }
+
+    probe->probe_param.dwarf_unwind = (char)value;
+    return 0;
+}
+
+static int parser_binary_output(struct probe_s *probe, struct param_key_s *param_key, const cJSON *key_item)
+{
+    int value = (int)key_item->valueint;
+    if (value < param_key->v.min || value > param_key->v.max) {
+        PARSE_ERR("params.%s invalid value, must be in [%d, %d]",
+                  param_key->key, param_key->v.min, param_key->v.max);
+        return -1;
+    }
+
+    probe->probe_param.binary_output = (char)value;
+    return 0;
+}
+
 static int parser_elf_path(struct probe_s *probe, struct param_key_s *param_key, const cJSON *key_item)
 {
     const char *value = (const char*)key_item->valuestring;
@@ -466,6 +506,7 @@ SET_DEFAULT_PARAMS_INTER(l7_probe_proto_flags);
 SET_DEFAULT_PARAMS_INTER(enable_all_thrds);
 SET_DEFAULT_PARAMS_INTER(svg_period);
 SET_DEFAULT_PARAMS_INTER(perf_sample_period);
+SET_DEFAULT_PARAMS_INTER(mem_sample_kb);
 
 
 SET_DEFAULT_PARAMS_CAHR(logs);
@@ -476,6 +517,8 @@ SET_DEFAULT_PARAMS_CAHR(res_percent_upper);
 SET_DEFAULT_PARAMS_CAHR(res_percent_lower);
 SET_DEFAULT_PARAMS_CAHR(cport_flag);
 SET_DEFAULT_PARAMS_CAHR(continuous_sampling_flag);
+SET_DEFAULT_PARAMS_CAHR(dwarf_unwind);
+SET_DEFAULT_PARAMS_CAHR(binary_output);
 
 
 SET_DEFAULT_PARAMS_STR(sys_debuging_dir);
@@ -500,6 +543,9 @@ struct param_key_s param_keys[] = {
     {"pyroscope_server",   {0, 0, 0, "localhost:4040"},             parser_pyscope_server, set_default_params_str_pyroscope_server, cJSON_String},
     {"svg_period",         {180, 30, 600, ""},                      parser_svg_period, set_default_params_inter_svg_period, cJSON_Number},
     {"perf_sample_period", {10, 10, 1000, ""},                      parser_perf_sample_period, set_default_params_inter_perf_sample_period, cJSON_Number},
+    {"mem_sample_kb",      {0, 0, 65536, ""},                       parser_mem_sample_kb, set_default_params_inter_mem_sample_kb, cJSON_Number},
+    {"dwarf_unwind",       {0, 0, 1, ""},                           parser_dwarf_unwind, set_default_params_char_dwarf_unwind, cJSON_Number},
+    {"binary_output",      {0, 0, 1, ""},                           parser_binary_output, set_default_params_char_binary_output, cJSON_Number},
     {"svg_dir",            {0, 0, 0, "/var/log/gala-gopher/stacktrace"}, parser_svg_dir, set_default_params_str_svg_dir, cJSON_String},
     {"flame_dir",          {0, 0, 0, "/var/log/gala-gopher/flamegraph"}, parser_flame_dir, set_default_params_str_flame_dir, cJSON_String},
     {"debugging_dir",      {0, 0, 0, ""},                           parser_sysdebuging_dir, set_default_params_str_sys_debuging_dir, cJSON_String},
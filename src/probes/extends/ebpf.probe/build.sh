@@ -77,6 +77,15 @@ function compile_probe()
         echo "debug: match vmlinux :" ${MATCH_VMLINUX}
     elif [ -f "vmlinux.h" ];then
         echo "debug: vmlinux.h is already here, continue compile."
+    elif [ -f /sys/kernel/btf/vmlinux ];then
+        # CO-RE: the kernel types are dumped from the running kernel, relocations are done by libbpf at load time
+        ${TOOLS_DIR}/bpftool btf dump file /sys/kernel/btf/vmlinux format c > vmlinux.h
+        if [ $? -ne 0 ];then
+            rm -f vmlinux.h
+            echo "failed to generate vmlinux.h from /sys/kernel/btf/vmlinux"
+            exit
+        fi
+        echo "debug: generate vmlinux.h from kernel BTF."
     else
         echo "======================================ERROR==============================================="
         echo "there no match vmlinux :" ${MATCH_VMLINUX}
@@ -0,0 +1,72 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-09-01
+ * Description: block device topology cache
+ ******************************************************************************/
+#ifndef __GOPHER_BLK_TOPO_H__
+#define __GOPHER_BLK_TOPO_H__
+
+#pragma once
+
+#include <uthash.h>
+#include "common.h"
+
+/*
+ * Block devices(disks and partitions) are loaded from /sys/class/block once, then kept up to date by the block
+ * uevents of the kernel(NETLINK_KOBJECT_UEVENT), so that lookups by major:minor never fork or rescan sysfs.
+ * The disk of a device is resolved through its parent disk(partitions) and its first slave(dm/md devices).
+ */
+#define BLK_TOPO_SYS_ROOT   "/sys"
+#define BLK_DEVT(major, minor)  (((u32)(major) << 20) | ((u32)(minor) & 0xFFFFF))
+
+struct blk_dev_s {
+    u32 devt;                           // key, BLK_DEVT(major, minor)
+    char kname[DISK_NAME_LEN];          // kernel name, e.g. sda1, dm-0
+    char name[DISK_NAME_LEN];           // name shown by lsblk, the mapped name for dm devices
+    char parent[DISK_NAME_LEN];         // kname of the disk of a partition
+    char slave[DISK_NAME_LEN];          // kname of the first slave of a dm/md device
+    char devpath[PATH_LEN];             // sysfs path of the device, e.g. /devices/pci0000:00/.../block/sda
+    char is_partition;
+    UT_hash_handle hh;                  // by devt
+    UT_hash_handle kname_hh;            // by kname
+};
+
+struct blk_topo_s {
+    struct blk_dev_s *devs;
+    struct blk_dev_s *knames;
+    int uevent_fd;                      // -1 if uevents are not available, the topology is then a snapshot
+    char sys_root[PATH_LEN];
+};
+
+// sys_root is BLK_TOPO_SYS_ROOT if NULL, uevents are only subscribed for the real sysfs
+struct blk_topo_s *create_blk_topo(const char *sys_root);
+void destroy_blk_topo(struct blk_topo_s *topo);
+
+/*
+ * Apply pending block uevents without blocking, the whole topology is reloaded if uevents were lost.
+ * Returns the number of devices updated.
+ */
+int blk_topo_update(struct blk_topo_s *topo);
+
+struct blk_dev_s *blk_topo_find(struct blk_topo_s *topo, int major, int minor);
+
+// dev_name and disk_name are set to "" if the device is unknown
+void blk_topo_get_names(struct blk_topo_s *topo, int major, int minor,
+                        char *dev_name, char *disk_name, size_t size);
+
+// whether the device is known or still present in sysfs(<sys_root>/dev/block/<major>:<minor>), 1 if topo is NULL
+char blk_topo_dev_exists(struct blk_topo_s *topo, int major, int minor);
+
+// whether the sysfs path of any device contains str, e.g. "nvme", "virtio"
+char blk_topo_has_devpath(struct blk_topo_s *topo, const char *str);
+
+#endif
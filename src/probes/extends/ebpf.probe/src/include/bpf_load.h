@@ -0,0 +1,65 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-09-07
+ * Description: parallel loading of bpf skeletons and run-time selection of their programs
+ ******************************************************************************/
+#ifndef __GOPHER_BPF_LOAD_H__
+#define __GOPHER_BPF_LOAD_H__
+
+#pragma once
+
+#include "common.h"
+
+/*
+ * Most of the start-up time of a probe is spent in the verifier, and privileged loads are verified concurrently
+ * by the kernel. Skeletons of a probe which are independent of each other are opened, loaded and attached on
+ * their own threads.
+ *
+ * Skeletons sharing pinned maps must not be loaded in parallel before the maps are pinned: the skeleton which
+ * creates the maps is loaded first, the others reuse the pinned maps. A task must only write its own slot of
+ * struct bpf_prog_s.
+ */
+#define BPF_LOAD_TASK_MAX   20
+
+typedef int (*bpf_load_fn)(void *arg);
+
+struct bpf_load_task_s {
+    const char *name;
+    bpf_load_fn fn;
+    void *arg;
+    int ret;
+};
+
+/*
+ * Run all the tasks and wait for them, tasks are run in the caller thread if no thread can be created.
+ * Returns 0 if all of the tasks succeed, otherwise -1.
+ */
+int bpf_parallel_load(struct bpf_load_task_s *tasks, u32 num);
+
+/*
+ * Objects built once against the kernel BTF(CO-RE) carry every hook an event may be traced with on the kernels
+ * they run on. Which one is loaded is decided on the running kernel rather than by CURRENT_KERNEL_VERSION.
+ */
+struct bpf_object;
+
+// Returns 1 if the raw tracepoint <category>:<name> can be attached on the running kernel, otherwise 0.
+char is_raw_tracepoint_supported(const char *category, const char *name);
+
+/*
+ * Of the two programs tracing the same event, only the raw tracepoint one is loaded if the raw tracepoint is
+ * supported, otherwise only the kprobe one. Must be called between open and load of the object.
+ * Returns 1 if the raw tracepoint program is selected, 0 if the kprobe one is, -1 on error.
+ */
+int bpf_select_raw_tracepoint(struct bpf_object *obj, const char *category, const char *name,
+                              const char *raw_tp_prog, const char *kprobe_prog);
+
+#endif
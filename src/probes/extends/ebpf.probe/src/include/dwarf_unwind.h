@@ -0,0 +1,79 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-08-21
+ * Description: user stack unwinding based on .eh_frame
+ ******************************************************************************/
+#ifndef __GOPHER_DWARF_UNWIND_H__
+#define __GOPHER_DWARF_UNWIND_H__
+
+#pragma once
+
+#include "common.h"
+#include "symbol.h"
+
+enum unwind_cfa_e {
+    UNWIND_CFA_UNDEF = 0,   // no unwind info(gap between FDEs or unsupported rule)
+    UNWIND_CFA_SP,          // CFA = sp + cfa_offset
+    UNWIND_CFA_FP,          // CFA = fp + cfa_offset
+    UNWIND_CFA_PLT,         // x86_64 PLT: CFA = sp + 8 + ((ip & 15) >= cfa_offset ? 8 : 0)
+    UNWIND_CFA_END          // return address undefined, the outermost frame
+};
+
+#define UNWIND_RA_IN_LR     0   // ra_offset 0: the return address is still in the link register
+
+/*
+ * One row of the unwind table compiled from the CFI of .eh_frame, valid from pc until the next row.
+ * Only the rules needed to walk a stack are kept: CFA, saved frame pointer and return address.
+ */
+struct unwind_row_s {
+    u32 pc_off;             // pc - unwind_tbl_s.base_pc
+    int cfa_offset;
+    s16 fp_offset;          // fp saved at CFA + fp_offset, 0 if fp is unchanged
+    s16 ra_offset;          // ra saved at CFA + ra_offset
+    u8 cfa_type;            // enum unwind_cfa_e
+    u8 pad[3];
+};
+
+// Unwind table of an elf, sorted by pc. Shared by all processes mapping the elf, see elf_symbo_s.
+struct unwind_tbl_s {
+    u64 base_pc;
+    u32 count;
+    struct unwind_row_s *rows;
+};
+
+struct unwind_regs_s {
+    u64 ip;
+    u64 sp;
+    u64 fp;
+    u64 lr;                 // aarch64 only
+};
+
+// A copy of the user stack from regs.sp upwards.
+struct unwind_stack_s {
+    u64 sp;
+    u32 len;
+    const char *data;
+};
+
+struct unwind_tbl_s *create_unwind_tbl(const char *eh_frame, size_t len, u64 eh_frame_addr);
+struct unwind_tbl_s *load_unwind_tbl(const char *elf);
+void destroy_unwind_tbl(struct unwind_tbl_s *tbl);
+const struct unwind_row_s *search_unwind_row(const struct unwind_tbl_s *tbl, u64 pc);
+
+/*
+ * Walk the user stack of proc_symbs with the unwind tables of its modules, frame pointers are used
+ * for code without unwind info. ips[0] is the leaf, unused slots are 0. Returns the number of frames.
+ */
+int proc_unwind_user_stack(struct proc_symbs_s *proc_symbs, const struct unwind_regs_s *regs,
+    const struct unwind_stack_s *stack, u64 ips[], u32 max_depth);
+
+#endif
@@ -23,7 +23,8 @@
 
 enum sym_file_t {
     ELF_SYM = 0,
-    JAVA_SYM = 1
+    JAVA_SYM = 1,
+    DEBUG_SYM = 2       // separate debuginfo file, shares build-id with its elf
 };
 
 struct elf_symbo_s* update_symb_from_jvm_sym_file(const char* elf);
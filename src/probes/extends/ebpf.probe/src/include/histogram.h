@@ -10,7 +10,7 @@
  * See the Mulan PSL v2 for more details.
  * Author: luzhihao
  * Create: 2023-06-28
- * Description: open telemetry histogram calculation
+ * Description: log-linear(HDR) histogram calculation
  ******************************************************************************/
 #ifndef __GOPHER_HISTOGRAM_H__
 #define __GOPHER_HISTOGRAM_H__
@@ -19,21 +19,59 @@
 
 #include "common.h"
 
+/*
+ * Values are counted in buckets of power-of-2 magnitude, each split into linear sub-buckets, so that the
+ * bucket of a value is found by a bit scan and any recorded value is reported with a relative error
+ * below 10^(-sig_digits).
+ *
+ * Values below 'lowest' share the resolution of 'lowest', values above 'highest' are counted as 'highest'.
+ */
+#define HISTO_SIG_DIGITS_MIN    1
+#define HISTO_SIG_DIGITS_MAX    3
+
 enum histo_type_t {
     HISTO_P50,
     HISTO_P90,
     HISTO_P99
 };
 
-struct histo_bucket_s {
-    u64 min, max;
-    u64 count;
+struct histo_s {
+    u64 lowest, highest;
+    int sig_digits;
+    int unit_magnitude;                 // log2 of lowest
+    int sub_bucket_half_count_magnitude;
+    u32 sub_bucket_count;
+    u32 sub_bucket_half_count;
+    u64 sub_bucket_mask;
+    u32 bucket_count;
+    u32 counts_len;
+    u64 total_count;
+    u64 min, max;                       // min is (u64)-1 if no values recorded
+    u64 counts[];
 };
 
-int init_histo_bucket(struct histo_bucket_s *bucket, u64 min, u64 max);
-int histo_bucket_add_value(struct histo_bucket_s bucket[], size_t bucket_size, u64 value);
-int histo_bucket_value(struct histo_bucket_s bucket[], size_t bucket_size, enum histo_type_t type, float *value);
-void histo_bucket_reset(struct histo_bucket_s bucket[], size_t bucket_size);
+struct histo_s *create_histo(u64 lowest, u64 highest, int sig_digits);
+void destroy_histo(struct histo_s *histo);
+void histo_reset(struct histo_s *histo);
+
+int histo_add_value(struct histo_s *histo, u64 value);
+int histo_add_values(struct histo_s *histo, u64 value, u64 count);
+
+// q in [0, 1], the highest value equivalent to the recorded one is returned, 0 if no values recorded
+u64 histo_value_at_quantile(const struct histo_s *histo, double q);
+int histo_value(const struct histo_s *histo, enum histo_type_t type, float *value);
+
+// Histograms must be created with the same lowest, highest and sig_digits.
+int histo_merge(struct histo_s *dst, const struct histo_s *src);
+int histo_subtract(struct histo_s *dst, const struct histo_s *src);
+
+/*
+ * Compact encoding: a version byte, the layout and the non-zero buckets as varint (index delta, count) pairs.
+ * histo_serialize() returns the encoded length, -1 if buf is too small.
+ * histo_deserialize() adds the decoded counts into a histogram of the same layout.
+ */
+int histo_serialize(const struct histo_s *histo, char *buf, size_t size);
+int histo_deserialize(struct histo_s *histo, const char *buf, size_t len);
 
 #endif
 
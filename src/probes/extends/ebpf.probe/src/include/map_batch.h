@@ -0,0 +1,55 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-08-31
+ * Description: periodic snapshot of bpf maps from userspace
+ ******************************************************************************/
+#ifndef __GOPHER_MAP_BATCH_H__
+#define __GOPHER_MAP_BATCH_H__
+
+#pragma once
+
+#include "common.h"
+
+/*
+ * Kernel progs only update counters in the map, the probe snapshots the whole map on its own schedule instead of
+ * receiving a perf event per entity per period. The map is read with bpf_map_lookup_batch(), or
+ * bpf_map_lookup_and_delete_batch() to reset counters, falling back to iteration on kernels before 5.6.
+ *
+ * For per-cpu maps, the value passed to the callback holds ncpus values of MAP_BATCH_PERCPU_SIZE(value_size) bytes.
+ */
+#define MAP_BATCH_PERCPU_SIZE(size)     (((size) + 7) & ~7U)
+
+typedef void (*map_batch_cb)(void *key, void *value, void *ctx);
+
+struct map_batch_s {
+    int fd;
+    u32 key_size;
+    u32 value_size;     // size of the value of an entry in userspace, including all cpus for per-cpu maps
+    u32 max_entries;
+    u32 ncpus;          // number of possible cpus for per-cpu maps, otherwise 0
+    char reset;         // delete entries after snapshot, hash maps only
+    char no_batch;      // batch ops are not supported
+    void *keys;
+    void *values;
+    void *batch;        // batch token
+};
+
+struct map_batch_s *create_map_batch(int map_fd, char reset);
+void destroy_map_batch(struct map_batch_s *mb);
+
+/*
+ * Snapshot all entries of the map and call cb on each of them.
+ * Returns the number of entries, or -1 on error.
+ */
+int map_batch_collect(struct map_batch_s *mb, map_batch_cb cb, void *ctx);
+
+#endif
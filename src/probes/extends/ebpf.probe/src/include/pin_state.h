@@ -0,0 +1,61 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-09-11
+ * Description: pinned state maps kept across probe restarts
+ ******************************************************************************/
+#ifndef __GOPHER_PIN_STATE_H__
+#define __GOPHER_PIN_STATE_H__
+
+#pragma once
+
+#include <bpf/libbpf.h>
+#include "common.h"
+
+/*
+ * Long-lived state maps(e.g. connection tracking) are pinned under PIN_STATE_DIR, which is not cleaned when the
+ * probe or gala-gopher restarts, so that a restarted probe goes on with the state built up by the kernel progs.
+ *
+ * Along with the maps, a layout descriptor is pinned: the layout version of the probe and the type, key size,
+ * value size and max entries of each map. The probe must bump its layout version whenever the key or value of a
+ * state map changes meaning. If the pinned descriptor differs from the maps being loaded, the stale maps are
+ * unpinned and created again.
+ */
+#define PIN_STATE_DIR           "/sys/fs/bpf/gala-gopher/state"
+#define PIN_STATE_MAP_MAX       8
+
+struct pin_state_geo_s {
+    u32 type;
+    u32 key_size;
+    u32 value_size;
+    u32 max_entries;
+};
+
+struct pin_state_map_s {
+    struct bpf_map *map;        // map of the opened skeleton
+    const char *path;           // pin path under PIN_STATE_DIR
+};
+
+/*
+ * Called between open and load of a skeleton, the pin paths of the maps are set.
+ * Returns 1 if the pinned maps are reused, 0 if they are to be created, -1 on error.
+ */
+int pin_state_maps(const char *layout_path, u32 version, struct pin_state_map_s *maps, u32 num);
+
+/*
+ * Compares the pinned layout with the expected version and geometries, and checks that every path in paths is
+ * pinned. On any mismatch the stale pins are unlinked and the expected layout is pinned.
+ * Returns 1 if the pinned maps can be reused, 0 if they are to be created, -1 on error.
+ */
+int pin_state_check_layout(const char *layout_path, u32 version, const struct pin_state_geo_s *geos,
+                           const char *const *paths, u32 num);
+
+#endif
@@ -58,18 +58,66 @@ struct mod_info_s {
     u64 inode;
 };
 
+#define ELF_BUILD_ID_LEN    65   // hex string, GNU build-id is at most 32 bytes
+
+/*
+ * Key of the global symbol table cache. ELF files are keyed by build-id when present, so the same
+ * binary seen through different containers/mount namespaces shares one symbol table; otherwise
+ * by file identity (st_dev/st_ino/st_mtime/st_size). JVM symbol files are appended in place, so
+ * only st_dev/st_ino are used for them.
+ */
+struct elf_symb_key_s {
+    u32 sym_type;       // enum sym_file_t
+    u32 pad;
+    u64 dev;
+    u64 ino;
+    s64 mtime;
+    s64 size;
+    char build_id[ELF_BUILD_ID_LEN];
+};
+
+/*
+ * Compact, read-only symbol table of an elf, built once after loading and possibly mmap'd from
+ * the on-disk symbol cache. start[]/size[]/name_off[] are in address order; eytz_start[] holds
+ * the same start addresses in Eytzinger (BFS) order, 1-based, with eytz_rank[] mapping each slot
+ * back to its address-order index. max_end[i] is the highest end address of symbols 0..i.
+ */
+struct symb_tbl_s {
+    u32 count;
+    u32 strtab_len;
+    const u64 *eytz_start;
+    const u32 *eytz_rank;
+    const u64 *start;
+    const u64 *size;
+    const u64 *max_end;
+    const u32 *name_off;
+    const char *strtab;
+    void *mem;          // malloc'd or mmap'd, holds all of the above
+    size_t mem_len;
+    char is_mmap;
+};
+
+struct unwind_tbl_s;
+
 struct elf_symbo_s {
     H_HANDLE;
-    u32 i_inode;
+    struct elf_symb_key_s key;
     u32 refcnt;
     char *elf;
     long elf_offset; // for jvm symbols 
+    char text_section_loaded;
+    u64 text_section_addr;      // .text section addr/offset, shared by all process mapping this elf
+    u64 text_section_offset;
     u32 symbs_count;
     u32 symbs_capability;
-    struct symb_s** __symbs;
+    struct symb_s** __symbs;    // only used while loading and for jvm symbols
+    struct symb_tbl_s *symb_tbl;
+    char unwind_loaded;
+    struct unwind_tbl_s *unwind_tbl;    // .eh_frame unwind table, loaded on first use
 };
 
 #define MOD_ADDR_RANGE_COUNT 100
+#define MOD_ADDR_RANGE_STEP  4
 struct mod_s {
     struct mod_info_s __mod_info;
     #define mod_type            __mod_info.type
@@ -82,8 +130,10 @@ struct mod_s {
     #define mod_f_offset        __mod_info.f_offset
     #define mod_inode           __mod_info.inode
 
+    // Per-process state is only the mapped ranges, symbol tables below are shared via the global cache.
     u32 addr_ranges_count;
-    struct mod_addr_rage_s addr_ranges[MOD_ADDR_RANGE_COUNT];
+    u32 addr_ranges_capability;
+    struct mod_addr_rage_s *addr_ranges;
 
     struct elf_symbo_s *debug_symbs;
     void *elf_reader;   // No release is required.
@@ -106,6 +156,7 @@ struct proc_symbs_s {
 
 struct proc_symbs_s* proc_load_all_symbs(void *elf_reader, int proc_id);
 void proc_delete_all_symbs(struct proc_symbs_s *proc_symbs);
+struct mod_s* proc_get_mod_by_addr(struct proc_symbs_s *proc_symbs, u64 addr, u64 *target_addr);
 int proc_search_addr_symb(struct proc_symbs_s *proc_symbs,
         u64 addr, struct addr_symb_s *addr_symb, char *comm);
 
@@ -95,6 +95,7 @@ char is_listen_port(unsigned int port, struct tcp_listen_ports* tlps);
 struct tcp_listen_ports* get_listen_ports(void);
 void free_listen_ports(struct tcp_listen_ports** ptlps);
 struct tcp_estabs* get_estab_tcps(struct tcp_listen_ports* tlps);
+int get_listen_estab_tcps(struct tcp_listen_ports** ptlps, struct tcp_estabs** ptes);
 void free_estab_tcps(struct tcp_estabs** ptes);
 struct tcp_endpoints *get_tcp_endpoints(struct tcp_listen_ports* tlps, struct tcp_estabs* tes);
 void free_tcp_endpoints(struct tcp_endpoints **pteps);
@@ -26,6 +26,7 @@
 char g_linsence[] SEC("license") = "GPL";
 
 #define __IO_COUNT_MAX      100
+// Only counters are updated here, ioprobe reads and deletes the entries once per period.
 struct {
     __uint(type, BPF_MAP_TYPE_HASH);
     __uint(key_size, sizeof(struct io_entity_s));
@@ -33,13 +34,6 @@ struct {
     __uint(max_entries, __IO_COUNT_MAX);
 } io_count_map SEC(".maps");
 
-struct {
-    __uint(type, BPF_MAP_TYPE_PERF_EVENT_ARRAY);
-    __uint(key_size, sizeof(u32));
-    __uint(value_size, sizeof(u32));
-    __uint(max_entries, __PERF_OUT_MAX);
-} io_count_channel_map SEC(".maps");
-
 
 struct block_bio_queue_args {
     struct trace_entry ent;
@@ -50,20 +44,6 @@ struct block_bio_queue_args {
     char comm[TASK_COMM_LEN];
 };
 
-static __always_inline void report_io_count(void *ctx, struct io_count_s* io_count)
-{
-    if (is_report_tmout(&(io_count->io_count_ts))) {
-        (void)bpf_perf_event_output(ctx,
-                                    &io_count_channel_map,
-                                    BPF_F_ALL_CPU,
-                                    io_count,
-                                    sizeof(struct io_count_s));
-        io_count->read_bytes = 0;
-        io_count->write_bytes = 0;
-        io_count->io_count_ts.ts = 0;
-    }
-}
-
 static __always_inline struct io_count_s* get_io_count(int major, int minor)
 {
     struct io_entity_s io_entity = {.major = major, .first_minor = minor};
@@ -125,13 +105,11 @@ void tracepoint_block_bio_queue(struct block_bio_queue_args *ctx)
 
     if (is_read_bio(ctx)) {
         __sync_fetch_and_add(&(io_count->read_bytes), bio_size);
-        report_io_count(ctx, io_count);
         return;
     }
 
     if (is_write_bio(ctx)) {
         __sync_fetch_and_add(&(io_count->write_bytes), bio_size);
-        report_io_count(ctx, io_count);
         return;
     }
 }
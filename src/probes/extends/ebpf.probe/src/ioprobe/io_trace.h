@@ -65,6 +65,22 @@ enum IO_STAGE_E {
     IO_STAGE_MAX
 };
 
+enum IO_OP_E {
+    IO_OP_READ = 0,
+    IO_OP_WRITE,
+    IO_OP_DISCARD,
+    IO_OP_FLUSH,
+    IO_OP_OTHER,
+    IO_OP_MAX
+};
+
+/*
+ * log2 latency histogram, slot i counts latencies in [2^i, 2^(i+1)) us(slot 0 also counts latencies below 1us),
+ * the last slot counts all the latencies above and is only reported as +Inf.
+ */
+#define IO_HISTO_SLOTS  25
+#define IO_HISTO_UNIT   1000        // unit of slot 0, nanosecond
+
 struct io_report_s {
     u64 ts;
 };
@@ -88,7 +104,6 @@ struct io_trace_s {
 };
 
 struct io_count_s {
-    struct io_report_s io_count_ts;
     int major;
     int first_minor;
     u64 read_bytes;
@@ -122,6 +137,17 @@ struct io_latency_s {
     struct latency_stats latency[IO_STAGE_MAX];
 };
 
+struct io_histo_key_s {
+    int major;
+    int first_minor;
+    int op;                 // IO_OP_E
+};
+
+struct io_histo_s {
+    u64 slots[IO_STAGE_MAX][IO_HISTO_SLOTS];
+    u64 sum[IO_STAGE_MAX];  // unit: nanosecond
+};
+
 struct io_entity_s {
     int major;
     int first_minor;
@@ -58,6 +58,24 @@ struct {
     __uint(max_entries, __IO_LATENCY_ENTRIES_MAX);
 } io_latency_map SEC(".maps");
 
+/*
+ * Histograms are only added to, userspace reads the cumulative counters and never resets them.
+ * The value is too large for the bpf stack, new entries are inserted from io_histo_zero_map.
+ */
+#define __IO_HISTO_ENTRIES_MAX (512)
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_HASH);
+    __uint(key_size, sizeof(struct io_histo_key_s));
+    __uint(value_size, sizeof(struct io_histo_s));
+    __uint(max_entries, __IO_HISTO_ENTRIES_MAX);
+} io_histo_map SEC(".maps");
+
+struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __uint(key_size, sizeof(int));
+    __uint(value_size, sizeof(struct io_histo_s));
+    __uint(max_entries, 1);
+} io_histo_zero_map SEC(".maps");
 
 static __always_inline __maybe_unused char is_sample_tmout(u64 current_ts)
 {
@@ -194,6 +212,103 @@ static __always_inline void blk_fill_rwbs(char *rwbs, unsigned int op)
     }
 }
 
+static __always_inline int get_io_op(const char *rwbs)
+{
+    switch (rwbs[0]) {
+    case 'R':
+        return IO_OP_READ;
+    case 'W':
+        return IO_OP_WRITE;
+    case 'D':
+    case 'E':
+        return IO_OP_DISCARD;
+    case 'F':
+        return IO_OP_FLUSH;
+    default:
+        return IO_OP_OTHER;
+    }
+}
+
+static __always_inline u32 io_histo_slot(u64 delta)
+{
+    u64 v = delta / IO_HISTO_UNIT;
+    u32 slot = 0;
+
+    if (v >= (1ULL << 16)) {
+        v >>= 16;
+        slot += 16;
+    }
+    if (v >= (1ULL << 8)) {
+        v >>= 8;
+        slot += 8;
+    }
+    if (v >= (1ULL << 4)) {
+        v >>= 4;
+        slot += 4;
+    }
+    if (v >= (1ULL << 2)) {
+        v >>= 2;
+        slot += 2;
+    }
+    if (v >= (1ULL << 1)) {
+        v >>= 1;
+        slot += 1;
+    }
+    if (v > 1) {    // above 2^32 us
+        slot = IO_HISTO_SLOTS - 1;
+    }
+
+    return (slot >= IO_HISTO_SLOTS) ? (IO_HISTO_SLOTS - 1) : slot;
+}
+
+static __always_inline struct io_histo_s* get_io_histo(struct io_trace_s* io_trace)
+{
+    int zero = 0;
+    struct io_histo_key_s key = {0};
+    struct io_histo_s *io_histo, *new_io_histo;
+
+    key.major = io_trace->major;
+    key.first_minor = io_trace->first_minor;
+    key.op = get_io_op(io_trace->rwbs);
+
+    io_histo = (struct io_histo_s *)bpf_map_lookup_elem(&io_histo_map, &key);
+    if (io_histo != NULL) {
+        return io_histo;
+    }
+
+    new_io_histo = (struct io_histo_s *)bpf_map_lookup_elem(&io_histo_zero_map, &zero);
+    if (new_io_histo == NULL) {
+        return NULL;
+    }
+    bpf_map_update_elem(&io_histo_map, &key, new_io_histo, BPF_NOEXIST);
+
+    return (struct io_histo_s *)bpf_map_lookup_elem(&io_histo_map, &key);
+}
+
+// Per-cpu value, plain increments are enough.
+static __always_inline void update_io_histo(struct io_trace_s* io_trace)
+{
+    u64 delta[IO_STAGE_MAX];
+    struct io_histo_s *io_histo = get_io_histo(io_trace);
+
+    if (io_histo == NULL) {
+        return;
+    }
+
+    delta[IO_STAGE_BLOCK] = io_trace->ts[IO_ISSUE_END] - io_trace->ts[IO_ISSUE_START];
+    delta[IO_STAGE_DRIVER] = io_trace->ts[IO_ISSUE_DEVICE] - io_trace->ts[IO_ISSUE_START];
+    delta[IO_STAGE_DEVICE] = io_trace->ts[IO_ISSUE_DEVICE_END] - io_trace->ts[IO_ISSUE_DEVICE];
+
+#pragma unroll
+    for (int i = 0; i < IO_STAGE_MAX; i++) {
+        u32 slot = io_histo_slot(delta[i]);
+        if (slot < IO_HISTO_SLOTS) {
+            io_histo->slots[i][slot]++;
+        }
+        io_histo->sum[i] += delta[i];
+    }
+}
+
 static __always_inline __maybe_unused char is_normal_io_trace(struct io_trace_s *io_trace)
 {
     if (io_trace->ts[IO_ISSUE_START] == 0) {
@@ -413,6 +528,7 @@ static int bpf_trace_block_rq_completet_func(void *ctx, struct request* req, int
         io_trace->ts[IO_ISSUE_END] = bpf_ktime_get_ns();
         if (is_normal_io_trace(io_trace)) {
             CALC_LATENCY(io_latency, io_trace);
+            update_io_histo(io_trace);
             report_io_latency(ctx, io_latency);
         }
     }
@@ -17,6 +17,7 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
+#include <time.h>
 #include <sys/resource.h>
 
 #ifdef BPF_PROG_KERN
@@ -30,6 +31,8 @@
 #include "bpf.h"
 #include "args.h"
 #include "ipc.h"
+#include "map_batch.h"
+#include "blk_topo.h"
 #include "io_trace_scsi.skel.h"
 #include "io_trace_nvme.skel.h"
 #include "io_trace_virtblk.skel.h"
@@ -44,6 +47,7 @@
 #define IO_TBL_PAGECACHE  "io_pagecache"
 #define IO_TBL_ERR        "io_err"
 #define IO_TBL_COUNT      "io_count"
+#define IO_TBL_LATENCY_HISTO    "io_latency_histo"
 
 /* Path to pin map */
 #define IO_ARGS_PATH            "/sys/fs/bpf/gala-gopher/__io_args"
@@ -51,6 +55,7 @@
 #define IO_LATENCY_CHANNEL_PATH "/sys/fs/bpf/gala-gopher/__io_latency_channel"
 #define IO_TRACE_PATH           "/sys/fs/bpf/gala-gopher/__io_trace"
 #define IO_LATENCY_PATH         "/sys/fs/bpf/gala-gopher/__io_latency"
+#define IO_HISTO_PATH           "/sys/fs/bpf/gala-gopher/__io_histo"
 
 #define RM_IO_PATH              "/usr/bin/rm -rf /sys/fs/bpf/gala-gopher/__io*"
 
@@ -61,6 +66,7 @@
     MAP_SET_PIN_PATH(probe_name, io_latency_channel_map, IO_LATENCY_CHANNEL_PATH, load); \
     MAP_SET_PIN_PATH(probe_name, io_trace_map, IO_TRACE_PATH, load); \
     MAP_SET_PIN_PATH(probe_name, io_latency_map, IO_LATENCY_PATH, load); \
+    MAP_SET_PIN_PATH(probe_name, io_histo_map, IO_HISTO_PATH, load); \
     LOAD_ATTACH(ioprobe, probe_name, end, load)
 
 #define __LOAD_IO_PROBE(probe_name, end, load) \
@@ -72,6 +78,11 @@ static volatile sig_atomic_t g_stop;
 static int io_args_fd = -1;
 static struct ipc_body_s g_ipc_body;
 static struct bpf_prog_s *g_bpf_prog = NULL;
+static struct map_batch_s *io_count_batch = NULL;
+static time_t io_count_ts = 0;
+static struct map_batch_s *io_histo_batch = NULL;
+static time_t io_histo_ts = 0;
+static struct blk_topo_s *g_blk_topo = NULL;
 
 struct scsi_err_desc_s {
     int scsi_ret_code;
@@ -164,86 +175,6 @@ static void sig_int(int signo)
     g_stop = 1;
 }
 
-/**
-lsblk -l | grep 8:0 | awk '{print $1}'
-sda
-*/
-#define LSBLK_LIST_CMD "lsblk -l | grep %d:%d | awk '{print $1}'"
-static void get_devname(int major, int minor, char dev_name[], size_t size)
-{
-    char cmd[COMMAND_LEN];
-
-    cmd[0] = 0;
-    (void)sprintf(cmd, LSBLK_LIST_CMD, major, minor);
-
-    (void)exec_cmd((const char *)cmd, dev_name, size);
-    return;
-}
-
-#define IS_LOWERCASE_LEETER(a) (((a) >= 'a') && ((a) <= 'z'))
-static char* __get_first_letter_pos(char *buf)
-{
-    char *p;
-    size_t pos;
-    size_t len = strlen(buf);
-    if (len == 0) {
-        return NULL;
-    }
-
-    pos = 0;
-    p = buf + pos;
-    while ((pos < len) && (!IS_LOWERCASE_LEETER(*p))) {
-        pos++;
-        p = buf + pos;
-    }
-
-    if (pos >= len) {
-        return NULL;
-    }
-    return p;
-}
-
-#define LSBLK_TREE_CMD "lsblk -t | awk 'NR > 1 {print $1}'"
-static void get_diskname(const char* dev_name, char *disk_name, size_t size)
-{
-    FILE *f = NULL;
-    char cmd[COMMAND_LEN];
-    char line[LINE_BUF_LEN];
-    char *p;
-    char last_disk_name[DISK_NAME_LEN];
-
-    strcpy(cmd, LSBLK_TREE_CMD);
-    f = popen(cmd, "r");
-    if (f == NULL) {
-        return;
-    }
-    while (!feof(f)) {
-        line[0] = 0;
-        if (fgets(line, LINE_BUF_LEN, f) == NULL) {
-            break;
-        }
-        SPLIT_NEWLINE_SYMBOL(line);
-        p = __get_first_letter_pos(line);
-        if (p && (p == line)) {
-            // record last disk name
-            last_disk_name[0] = 0;
-            (void)snprintf(last_disk_name, sizeof(last_disk_name), "%s", p);
-        }
-
-        if (strcmp(dev_name, last_disk_name) == 0) {
-            (void)snprintf(disk_name, size, "%s", dev_name);
-        }
-
-        if (p && (p != line) && (strcmp(dev_name, p) == 0)) {
-            (void)snprintf(disk_name, size, "%s", last_disk_name);
-            break;
-        }
-    }
-
-    pclose(f);
-    return;
-}
-
 #if 0
 static int get_devt(char *dev_name, int *major, int *minor)
 {
@@ -306,10 +237,7 @@ static void rcv_io_latency_thr(struct io_latency_s *io_latency)
         entityId[0] = 0;
         __build_entity_id(io_latency->major, io_latency->first_minor, entityId, __ENTITY_ID_LEN);
 
-        dev_name[0] = 0;
-        disk_name[0] = 0;
-        get_devname(io_latency->major, io_latency->first_minor, dev_name, DISK_NAME_LEN);
-        get_diskname((const char*)dev_name, disk_name, DISK_NAME_LEN);
+        blk_topo_get_names(g_blk_topo, io_latency->major, io_latency->first_minor, dev_name, disk_name, DISK_NAME_LEN);
 
         evt.entityName = OO_NAME;
         evt.entityId = entityId;
@@ -335,10 +263,8 @@ static void rcv_pagecache_stats(void *ctx, int cpu, void *data, __u32 size)
     char disk_name[DISK_NAME_LEN];
     struct pagecache_stats_s *pagecache_stats = data;
 
-    dev_name[0] = 0;
-    disk_name[0] = 0;
-    get_devname(pagecache_stats->major, pagecache_stats->first_minor, dev_name, DISK_NAME_LEN);
-    get_diskname((const char*)dev_name, disk_name, DISK_NAME_LEN);
+    blk_topo_get_names(g_blk_topo, pagecache_stats->major, pagecache_stats->first_minor,
+                       dev_name, disk_name, DISK_NAME_LEN);
 
     (void)fprintf(stdout, "|%s|%d|%d|%s|%s"
         "|%u|%u|%u|%u|\n",
@@ -356,16 +282,13 @@ static void rcv_pagecache_stats(void *ctx, int cpu, void *data, __u32 size)
     (void)fflush(stdout);
 }
 
-static void rcv_io_count(void *ctx, int cpu, void *data, __u32 size)
+static void output_io_count(void *key, void *value, void *ctx)
 {
     char dev_name[DISK_NAME_LEN];
     char disk_name[DISK_NAME_LEN];
-    struct io_count_s *io_count = data;
+    struct io_count_s *io_count = value;
 
-    dev_name[0] = 0;
-    disk_name[0] = 0;
-    get_devname(io_count->major, io_count->first_minor, dev_name, DISK_NAME_LEN);
-    get_diskname((const char*)dev_name, disk_name, DISK_NAME_LEN);
+    blk_topo_get_names(g_blk_topo, io_count->major, io_count->first_minor, dev_name, disk_name, DISK_NAME_LEN);
 
     (void)fprintf(stdout, "|%s|%d|%d|%s|%s"
         "|%llu|%llu|\n",
@@ -381,6 +304,90 @@ static void rcv_io_count(void *ctx, int cpu, void *data, __u32 size)
     (void)fflush(stdout);
 }
 
+static const char *io_op_names[IO_OP_MAX] = {"read", "write", "discard", "flush", "other"};
+
+// The counts are cumulative, so every number may take the 20 digits of a u64 plus a separator.
+#define IO_HISTO_VAL_LEN    ((3 + IO_HISTO_SLOTS) * 21)
+
+/*
+ * Histogram value: "<sum> <count> <bound> <count_0> ... <count_n>", the upper bound of bucket i is (bound << i).
+ * The value is left empty if it can not be printed entirely.
+ */
+static void __build_io_histo_val(const u64 *slots, u64 sum, char *buf, int size)
+{
+    int ret, last = -1;
+    char *p = buf;
+    u64 count = 0;
+
+    for (int i = 0; i < IO_HISTO_SLOTS; i++) {
+        count += slots[i];
+        if (i < IO_HISTO_SLOTS - 1 && slots[i] != 0) {
+            last = i;
+        }
+    }
+
+    buf[0] = 0;
+    ret = __snprintf(&p, size, &size, "%llu %llu %llu", sum, count, (u64)IO_HISTO_UNIT << 1);
+    for (int i = 0; ret >= 0 && i <= last; i++) {
+        ret = __snprintf(&p, size, &size, " %llu", slots[i]);
+    }
+    if (ret < 0) {
+        buf[0] = 0;
+    }
+}
+
+static void output_io_histo(void *key, void *value, void *ctx)
+{
+    char dev_name[DISK_NAME_LEN];
+    char disk_name[DISK_NAME_LEN];
+    char vals[IO_STAGE_MAX][IO_HISTO_VAL_LEN];
+    struct io_histo_s io_histo = {0};
+    struct io_histo_key_s *histo_key = key;
+    struct map_batch_s *mb = ctx;
+    u32 stride = MAP_BATCH_PERCPU_SIZE(sizeof(struct io_histo_s));
+
+    if (histo_key->op < 0 || histo_key->op >= IO_OP_MAX) {
+        return;
+    }
+
+    // The map is pinned and never reset, drop the histograms of removed disks instead of reporting them forever.
+    if (!blk_topo_dev_exists(g_blk_topo, histo_key->major, histo_key->first_minor)) {
+        (void)bpf_map_delete_elem(mb->fd, histo_key);
+        return;
+    }
+
+    for (int cpu = 0; cpu < mb->ncpus; cpu++) {
+        struct io_histo_s *percpu = (struct io_histo_s *)((char *)value + cpu * stride);
+        for (int i = 0; i < IO_STAGE_MAX; i++) {
+            for (int j = 0; j < IO_HISTO_SLOTS; j++) {
+                io_histo.slots[i][j] += percpu->slots[i][j];
+            }
+            io_histo.sum[i] += percpu->sum[i];
+        }
+    }
+
+    for (int i = 0; i < IO_STAGE_MAX; i++) {
+        __build_io_histo_val(io_histo.slots[i], io_histo.sum[i], vals[i], IO_HISTO_VAL_LEN);
+    }
+
+    blk_topo_get_names(g_blk_topo, histo_key->major, histo_key->first_minor, dev_name, disk_name, DISK_NAME_LEN);
+
+    (void)fprintf(stdout, "|%s|%d|%d|%s|%s|%s"
+        "|%s|%s|%s|\n",
+
+        IO_TBL_LATENCY_HISTO,
+        histo_key->major,
+        histo_key->first_minor,
+        io_op_names[histo_key->op],
+        dev_name,
+        disk_name,
+
+        vals[IO_STAGE_BLOCK],
+        vals[IO_STAGE_DRIVER],
+        vals[IO_STAGE_DEVICE]);
+    (void)fflush(stdout);
+}
+
 static void rcv_io_latency(void *ctx, int cpu, void *data, __u32 size)
 {
     char dev_name[DISK_NAME_LEN];
@@ -389,10 +396,7 @@ static void rcv_io_latency(void *ctx, int cpu, void *data, __u32 size)
 
     rcv_io_latency_thr(io_latency);
 
-    dev_name[0] = 0;
-    disk_name[0] = 0;
-    get_devname(io_latency->major, io_latency->first_minor, dev_name, DISK_NAME_LEN);
-    get_diskname((const char*)dev_name, disk_name, DISK_NAME_LEN);
+    blk_topo_get_names(g_blk_topo, io_latency->major, io_latency->first_minor, dev_name, disk_name, DISK_NAME_LEN);
 
     (void)fprintf(stdout, "|%s|%d|%d|%s|%s"
         "|%llu|%llu|%llu|%llu|%u"
@@ -441,10 +445,7 @@ static void rcv_io_err(void *ctx, int cpu, void *data, __u32 size)
     entityId[0] = 0;
     __build_entity_id(io_err->major, io_err->first_minor, entityId, __ENTITY_ID_LEN);
 
-    dev_name[0] = 0;
-    disk_name[0] = 0;
-    get_devname(io_err->major, io_err->first_minor, dev_name, DISK_NAME_LEN);
-    get_diskname((const char*)dev_name, disk_name, DISK_NAME_LEN);
+    blk_topo_get_names(g_blk_topo, io_err->major, io_err->first_minor, dev_name, disk_name, DISK_NAME_LEN);
 
     evt.entityName = OO_NAME;
     evt.entityId = entityId;
@@ -469,23 +470,13 @@ static void rcv_io_err(void *ctx, int cpu, void *data, __u32 size)
 #define NVME_PROBE      "nvme"
 #define SCSI_PROBE      "target"
 
-#define LS_BLOCK_CMD "/usr/bin/ls -l /sys/class/block | grep %s | wc -l"
+// e.g. /sys/class/block/vda -> ../../devices/pci0000:00/0000:00:05.0/virtio2/block/vda
 static char is_load_probe(char *probe_name)
 {
-    char cmd[COMMAND_LEN];
-    char count_str[INT_LEN];
-    int count;
-
-    cmd[0] = 0;
-    (void)sprintf(cmd, LS_BLOCK_CMD, probe_name);
-    count_str[0] = 0;
-    if (exec_cmd(cmd, count_str, INT_LEN) < 0) {
+    if (g_blk_topo == NULL) {
         return 0;
     }
-
-    count = atoi((const char *)count_str);
-
-    return (count > 0) ? 1 : 0;
+    return blk_topo_has_devpath(g_blk_topo, probe_name);
 }
 
 static int load_io_args(int fd, struct ipc_body_s* ipc_body)
@@ -512,11 +503,47 @@ static int load_io_args(int fd, struct ipc_body_s* ipc_body)
     return bpf_map_update_elem(fd, &key, &io_args, BPF_ANY);
 }
 
-static int load_io_count_probe(struct bpf_prog_s *prog, char is_load_count)
+static void collect_io_count(u32 period)
 {
-    int fd;
-    struct perf_buffer *pb = NULL;
+    time_t now = time(NULL);
 
+    if (io_count_batch == NULL || now < io_count_ts + (time_t)period) {
+        return;
+    }
+    io_count_ts = now;
+    (void)map_batch_collect(io_count_batch, output_io_count, NULL);
+}
+
+// Histograms are cumulative, they are read without reset.
+static void collect_io_histo(u32 period)
+{
+    time_t now = time(NULL);
+
+    if (io_histo_batch == NULL || now < io_histo_ts + (time_t)period) {
+        return;
+    }
+    io_histo_ts = now;
+    (void)map_batch_collect(io_histo_batch, output_io_histo, io_histo_batch);
+}
+
+// io_histo_map is pinned and shared by all the io trace progs.
+static int create_io_histo_batch(int map_fd)
+{
+    if (io_histo_batch != NULL) {
+        return 0;
+    }
+
+    io_histo_batch = create_map_batch(map_fd, 0);
+    if (io_histo_batch == NULL) {
+        ERROR("[IOPROBE] Crate 'io_histo' map batch failed.\n");
+        return -1;
+    }
+    io_histo_ts = time(NULL);
+    return 0;
+}
+
+static int load_io_count_probe(struct bpf_prog_s *prog, char is_load_count)
+{
     if (is_load_count == 0) {
         return 0;
     }
@@ -524,15 +551,15 @@ static int load_io_count_probe(struct bpf_prog_s *prog, char is_load_count)
     __LOAD_IO_PROBE(io_count, err, 1);
     prog->skels[prog->num].skel = io_count_skel;
     prog->skels[prog->num].fn = (skel_destroy_fn)io_count_bpf__destroy;
+    prog->num++;
 
-    fd = GET_MAP_FD(io_count, io_count_channel_map);
-    pb = create_pref_buffer(fd, rcv_io_count);
-    if (pb == NULL) {
-        ERROR("[IOPROBE] Crate 'io_count' perf buffer failed.\n");
-        goto err;
+    // io counts of all disks are read and reset once per period, instead of a perf event per disk.
+    io_count_batch = create_map_batch(GET_MAP_FD(io_count, io_count_map), 1);
+    if (io_count_batch == NULL) {
+        ERROR("[IOPROBE] Crate 'io_count' map batch failed.\n");
+        return -1;
     }
-    prog->pbs[prog->num] = pb;
-    prog->num++;
+    io_count_ts = time(NULL);
 
     if (io_args_fd < 0) {
         io_args_fd = GET_MAP_FD(io_count, io_args_map);
@@ -630,6 +657,10 @@ static int load_io_scsi_probe(struct bpf_prog_s *prog, char scsi_probe)
     prog->pbs[prog->num] = pb;
     prog->num++;
 
+    if (create_io_histo_batch(GET_MAP_FD(io_trace_scsi, io_histo_map))) {
+        return -1;
+    }
+
     if (io_args_fd < 0) {
         io_args_fd = GET_MAP_FD(io_trace_scsi, io_args_map);
     }
@@ -662,6 +693,10 @@ static int load_io_nvme_probe(struct bpf_prog_s *prog, char nvme_probe)
     prog->pbs[prog->num] = pb;
     prog->num++;
 
+    if (create_io_histo_batch(GET_MAP_FD(io_trace_nvme, io_histo_map))) {
+        return -1;
+    }
+
     if (io_args_fd < 0) {
         io_args_fd = GET_MAP_FD(io_trace_nvme, io_args_map);
     }
@@ -694,6 +729,10 @@ static int load_io_virtblk_probe(struct bpf_prog_s *prog, char virtblk_probe)
     prog->pbs[prog->num] = pb;
     prog->num++;
 
+    if (create_io_histo_batch(GET_MAP_FD(io_trace_virtblk, io_histo_map))) {
+        return -1;
+    }
+
     if (io_args_fd < 0) {
         io_args_fd = GET_MAP_FD(io_trace_virtblk, io_args_map);
     }
@@ -707,6 +746,10 @@ err:
 static void ioprobe_unload_bpf(void)
 {
     unload_bpf_prog(&g_bpf_prog);
+    destroy_map_batch(io_count_batch);
+    io_count_batch = NULL;
+    destroy_map_batch(io_histo_batch);
+    io_histo_batch = NULL;
     io_args_fd = -1;
 }
 
@@ -771,6 +814,7 @@ err:
 int main(int argc, char **argv)
 {
     int ret = 0;
+    char polled;
     FILE *fp = NULL;
     struct ipc_body_s ipc_body;
 
@@ -792,10 +836,19 @@ int main(int argc, char **argv)
         goto err;
     }
 
+    g_blk_topo = create_blk_topo(NULL);
+    if (g_blk_topo == NULL) {
+        ERROR("[IOPROBE] Load block devices failed.\n");
+        goto err;
+    }
+
     printf("Successfully started!\n");
     INIT_BPF_APP(ioprobe, EBPF_RLIM_LIMITED);
 
     while (!g_stop) {
+        // disks added or removed since last loop
+        (void)blk_topo_update(g_blk_topo);
+
         ret = recv_ipc_msg(msq_id, (long)PROBE_IO, &ipc_body);
         if (ret == 0) {
             ioprobe_unload_bpf();
@@ -810,19 +863,31 @@ int main(int argc, char **argv)
             continue;
         }
 
+        polled = 0;
         for (int i = 0; i < g_bpf_prog->num; i++) {
-            if (g_bpf_prog->pbs[i] && ((ret = perf_buffer__poll(g_bpf_prog->pbs[i], THOUSAND)) < 0)) {
+            if (g_bpf_prog->pbs[i] == NULL) {
+                continue;
+            }
+            polled = 1;
+            if ((ret = perf_buffer__poll(g_bpf_prog->pbs[i], THOUSAND)) < 0) {
                 if (ret != -EINTR) {
                     ERROR("[IOPROBE]: perf poll prog_%d failed.\n", i);
                 }
                 break;
             }
         }
+
+        collect_io_count(g_ipc_body.probe_param.period);
+        collect_io_histo(g_ipc_body.probe_param.period);
+        if (!polled) {
+            sleep(1);
+        }
     }
 
 err:
     ioprobe_unload_bpf();
     destroy_ipc_body(&g_ipc_body);
+    destroy_blk_topo(g_blk_topo);
 
     return ret;
 }
@@ -0,0 +1,94 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-08-29
+ * Description: top-K(space-saving) sketch of high cardinality apis
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/api_topk.h"
+
+struct api_topk_s *create_api_topk(void)
+{
+    struct api_topk_s *topk = (struct api_topk_s *)malloc(sizeof(struct api_topk_s));
+    if (topk == NULL) {
+        return NULL;
+    }
+    memset(topk, 0, sizeof(struct api_topk_s));
+    return topk;
+}
+
+void destroy_api_topk(struct api_topk_s *topk)
+{
+    struct api_topk_item_s *item, *tmp;
+
+    if (topk == NULL) {
+        return;
+    }
+
+    H_ITER(topk->index, item, tmp) {
+        H_DEL(topk->index, item);
+    }
+    free(topk);
+}
+
+static struct api_topk_item_s *__min_topk_item(struct api_topk_s *topk)
+{
+    struct api_topk_item_s *min = &(topk->items[0]);
+
+    for (u32 i = 1; i < topk->num; i++) {
+        if (topk->items[i].count < min->count) {
+            min = &(topk->items[i]);
+        }
+    }
+    return min;
+}
+
+const char *api_topk_add(struct api_topk_s *topk, const char *api)
+{
+    struct api_topk_item_s *item = NULL;
+    u64 min_count;
+
+    H_FIND_S(topk->index, api, item);
+    if (item) {
+        item->count++;
+        return item->api;
+    }
+
+    if (topk->num < L7_API_TOPK_SIZE) {
+        item = &(topk->items[topk->num++]);
+        (void)snprintf(item->api, sizeof(item->api), "%s", api);
+        item->count = 1;
+        H_ADD_S(topk->index, api, item);
+        return item->api;
+    }
+
+    // Take over the minimal counter.
+    item = __min_topk_item(topk);
+    min_count = item->count;
+    H_DEL(topk->index, item);
+    (void)snprintf(item->api, sizeof(item->api), "%s", api);
+    item->count = min_count + 1;
+    H_ADD_S(topk->index, api, item);
+    return L7_API_OTHER;
+}
+
+void api_topk_decay(struct api_topk_s *topk)
+{
+    if (topk == NULL) {
+        return;
+    }
+
+    for (u32 i = 0; i < topk->num; i++) {
+        topk->items[i].count >>= 1;
+    }
+}
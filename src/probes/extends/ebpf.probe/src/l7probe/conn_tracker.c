@@ -36,24 +36,6 @@
 #include "l7_common.h"
 
 
-struct latency_histo_s {
-    enum latency_range_t range;
-    int min, max;
-};
-
-struct latency_histo_s latency_histios[__MAX_LT_RANGE] = {
-    {LT_RANGE_1, 0, 1},
-    {LT_RANGE_2, 1, 3},
-    {LT_RANGE_3, 3, 10},
-    {LT_RANGE_4, 10, 20},
-    {LT_RANGE_5, 20, 50},
-    {LT_RANGE_6, 50, 100},
-    {LT_RANGE_7, 100, 300},
-    {LT_RANGE_8, 300, 500},
-    {LT_RANGE_9, 500, 1000},
-    {LT_RANGE_10, 1000, 10000}
-};
-
 const char *proto_name[PROTO_MAX] = {
     "unknown",
     "http",
@@ -74,13 +56,6 @@ const char *l7_role_name[L7_ROLE_MAX] = {
     "server"
 };
 
-static void init_latency_buckets(struct histo_bucket_s latency_buckets[], size_t size)
-{
-    for (int i = 0; i < __MAX_LT_RANGE && i < size; i++) {
-        (void)init_histo_bucket(&(latency_buckets[i]), latency_histios[i].min, latency_histios[i].max);
-    }
-}
-
 #if 1
 
 static void destroy_tracker_record(struct conn_tracker_s* tracker)
@@ -103,6 +78,7 @@ static void destroy_conn_tracker(struct conn_tracker_s* tracker)
     destroy_tracker_record(tracker);
     deinit_data_stream(&(tracker->send_stream));
     deinit_data_stream(&(tracker->recv_stream));
+    destroy_histo(tracker->latency_histo);
     free(tracker);
     return;
 }
@@ -120,7 +96,11 @@ static struct conn_tracker_s* create_conn_tracker(const struct tracker_id_s *id)
     (void)init_data_stream(&(tracker->send_stream));
     (void)init_data_stream(&(tracker->recv_stream));
 
-    init_latency_buckets(tracker->latency_buckets, __MAX_LT_RANGE);
+    tracker->latency_histo = create_histo(L7_LATENCY_LOWEST, L7_LATENCY_HIGHEST, L7_LATENCY_SIG_DIGITS);
+    if (tracker->latency_histo == NULL) {
+        destroy_conn_tracker(tracker);
+        return NULL;
+    }
     return tracker;
 }
 
@@ -207,8 +187,53 @@ static struct frame_buf_s* get_resp_frames(struct conn_tracker_s* tracker)
 #endif
 
 #if 1
+static void destroy_l7_api_stats(struct l7_link_s* link)
+{
+    struct l7_api_stats_s *api_stats, *tmp;
+
+    H_ITER(link->api_stats, api_stats, tmp) {
+        H_DEL(link->api_stats, api_stats);
+        destroy_histo(api_stats->latency_histo);
+        free(api_stats);
+    }
+    link->api_stats = NULL;
+    return;
+}
+
+static struct l7_api_stats_s* add_l7_api_stats(struct l7_link_s* link, const char *api)
+{
+    struct l7_api_stats_s *api_stats = NULL;
+
+    H_FIND_S(link->api_stats, api, api_stats);
+    if (api_stats) {
+        return api_stats;
+    }
+
+    if (H_COUNT(link->api_stats) >= L7_API_STATS_MAX) {
+        return NULL;
+    }
+
+    api_stats = (struct l7_api_stats_s *)malloc(sizeof(struct l7_api_stats_s));
+    if (api_stats == NULL) {
+        return NULL;
+    }
+    memset(api_stats, 0, sizeof(struct l7_api_stats_s));
+    (void)snprintf(api_stats->api, sizeof(api_stats->api), "%s", api);
+    api_stats->latency_histo = create_histo(L7_LATENCY_LOWEST, L7_LATENCY_HIGHEST, L7_LATENCY_SIG_DIGITS);
+    if (api_stats->latency_histo == NULL) {
+        free(api_stats);
+        return NULL;
+    }
+
+    H_ADD_S(link->api_stats, api, api_stats);
+    return api_stats;
+}
+
 static void destroy_l7_link(struct l7_link_s* link)
 {
+    destroy_l7_api_stats(link);
+    destroy_api_topk(link->api_topk);
+    destroy_histo(link->latency_histo);
     free(link);
     return;
 }
@@ -222,7 +247,16 @@ static struct l7_link_s* create_l7_link(const struct l7_link_id_s *id)
 
     memset(link, 0, sizeof(struct l7_link_s));
     memcpy(&(link->id), id, sizeof(struct l7_link_id_s));
-    init_latency_buckets(link->latency_buckets, __MAX_LT_RANGE);
+    link->latency_histo = create_histo(L7_LATENCY_LOWEST, L7_LATENCY_HIGHEST, L7_LINK_LATENCY_SIG_DIGITS);
+    if (link->latency_histo == NULL) {
+        free(link);
+        return NULL;
+    }
+
+    // Domains are unbounded, only the top-K domains of the link are reported on their own.
+    if (id->protocol == PROTO_DNS) {
+        link->api_topk = create_api_topk();
+    }
     return link;
 }
 
@@ -264,7 +298,7 @@ static struct l7_link_s* add_l7_link(struct l7_mng_s *l7_mng, const struct l7_li
         return NULL;
     }
 
-    link->stats[OPEN_EVT] = 1;
+    new_link->stats[OPEN_EVT] = 1;
     __init_l7_link_info(l7_mng, new_link, tracker);
 
     H_ADD_KEYPTR(l7_mng->l7_links, &new_link->id, sizeof(struct l7_link_id_s), new_link);
@@ -413,6 +447,8 @@ static int proc_conn_data_msg(struct l7_mng_s *l7_mng, struct conn_data_s *conn_
 
     tracker->protocol = conn_data_msg->proto;
     tracker->l7_role = conn_data_msg->l7_role;
+    tracker->send_stream.type = conn_data_msg->proto;
+    tracker->recv_stream.type = conn_data_msg->proto;
 
     switch (conn_data_msg->direction) {
         case L7_EGRESS:
@@ -442,9 +478,38 @@ static int proc_conn_data_msg(struct l7_mng_s *l7_mng, struct conn_data_s *conn_
     return ret;
 }
 
+static void add_api_stats(struct l7_link_s* link, const struct record_data_s *record_data)
+{
+    struct l7_api_stats_s *api_stats;
+    const char *api = record_data->api;
+
+    if (api[0] == 0) {
+        return;
+    }
+
+    if (link->api_topk) {
+        api = api_topk_add(link->api_topk, api);
+    }
+
+    api_stats = add_l7_api_stats(link, api);
+    if (api_stats == NULL) {
+        return;
+    }
+
+    api_stats->req_count++;
+    if (record_data->is_err) {
+        api_stats->err_count++;
+        if ((unsigned char)record_data->err_type < __MAX_L7_ERR_TYPE) {
+            api_stats->err_type_count[(unsigned char)record_data->err_type]++;
+        }
+    }
+    api_stats->latency_sum += record_data->latency;
+    (void)histo_add_value(api_stats->latency_histo, record_data->latency);
+    return;
+}
+
 static void add_tracker_stats(struct l7_mng_s *l7_mng, struct conn_tracker_s* tracker)
 {
-    int ret;
     struct l7_link_s* link;
     tracker->stats[REQ_COUNT] += tracker->records.req_count;
     tracker->stats[RSP_COUNT] += tracker->records.resp_count;
@@ -460,16 +525,11 @@ static void add_tracker_stats(struct l7_mng_s *l7_mng, struct conn_tracker_s* tr
     for (int i = 0; i < tracker->records.record_buf_size && i < RECORD_BUF_SIZE; i++) {
         if (tracker->records.records[i]) {
             tracker->latency_sum += tracker->records.records[i]->latency;
-            ret = histo_bucket_add_value(tracker->latency_buckets,
-                            __MAX_LT_RANGE, tracker->records.records[i]->latency);
+            (void)histo_add_value(tracker->latency_histo, tracker->records.records[i]->latency);
             if (link) {
                 link->latency_sum += tracker->records.records[i]->latency;
-                ret = histo_bucket_add_value(link->latency_buckets,
-                                __MAX_LT_RANGE, tracker->records.records[i]->latency);
-            }
-
-            if (ret) {
-                // TODO: debuging
+                (void)histo_add_value(link->latency_histo, tracker->records.records[i]->latency);
+                add_api_stats(link, tracker->records.records[i]);
             }
         }
     }
@@ -509,7 +569,7 @@ static void l7_parser_tracker(struct l7_mng_s *l7_mng, struct conn_tracker_s* tr
 
 static void reset_tracker_stats(struct conn_tracker_s* tracker)
 {
-    histo_bucket_reset(tracker->latency_buckets, __MAX_LT_RANGE);
+    histo_reset(tracker->latency_histo);
     tracker->latency_sum = 0;
     tracker->err_ratio = 0.0;
 
@@ -521,7 +581,7 @@ static void reset_tracker_stats(struct conn_tracker_s* tracker)
 
 static void reset_link_stats(struct l7_link_s *link)
 {
-    histo_bucket_reset(link->latency_buckets, __MAX_LT_RANGE);
+    histo_reset(link->latency_histo);
     link->latency_sum = 0;
     link->err_ratio = 0.0;
 
@@ -529,6 +589,9 @@ static void reset_link_stats(struct l7_link_s *link)
     memset(&(link->throughput), 0, sizeof(float) * __MAX_THROUGHPUT);
     memset(&(link->latency), 0, sizeof(float) * __MAX_LATENCY);
 
+    // Apis are released every period, so that inactive apis do not stay in the link.
+    destroy_l7_api_stats(link);
+    api_topk_decay(link->api_topk);
     return;
 }
 
@@ -554,21 +617,34 @@ static void calc_tracker_stats(struct conn_tracker_s* tracker, struct probe_para
     tracker->throughput[THROUGHPUT_REQ] = (float)((float)tracker->stats[REQ_COUNT] / (float)probe_param->period);
     tracker->throughput[THROUGHPUT_RESP] = (float)((float)tracker->stats[REQ_COUNT] / (float)probe_param->period);
 
-    (void)histo_bucket_value(tracker->latency_buckets, __MAX_LT_RANGE, HISTO_P50, &(tracker->latency[LATENCY_P50]));
-    (void)histo_bucket_value(tracker->latency_buckets, __MAX_LT_RANGE, HISTO_P90, &(tracker->latency[LATENCY_P90]));
-    (void)histo_bucket_value(tracker->latency_buckets, __MAX_LT_RANGE, HISTO_P99, &(tracker->latency[LATENCY_P99]));
+    (void)histo_value(tracker->latency_histo, HISTO_P50, &(tracker->latency[LATENCY_P50]));
+    (void)histo_value(tracker->latency_histo, HISTO_P90, &(tracker->latency[LATENCY_P90]));
+    (void)histo_value(tracker->latency_histo, HISTO_P99, &(tracker->latency[LATENCY_P99]));
 }
 
 static void calc_link_stats(struct l7_link_s *link, struct probe_params *probe_param)
 {
+    struct l7_api_stats_s *api_stats, *tmp;
+
     link->err_ratio = (float)((float)link->stats[ERR_COUNT] / (float)link->stats[REQ_COUNT]);
 
     link->throughput[THROUGHPUT_REQ] = (float)((float)link->stats[REQ_COUNT] / (float)probe_param->period);
     link->throughput[THROUGHPUT_RESP] = (float)((float)link->stats[REQ_COUNT] / (float)probe_param->period);
 
-    (void)histo_bucket_value(link->latency_buckets, __MAX_LT_RANGE, HISTO_P50, &(link->latency[LATENCY_P50]));
-    (void)histo_bucket_value(link->latency_buckets, __MAX_LT_RANGE, HISTO_P90, &(link->latency[LATENCY_P90]));
-    (void)histo_bucket_value(link->latency_buckets, __MAX_LT_RANGE, HISTO_P99, &(link->latency[LATENCY_P99]));
+    (void)histo_value(link->latency_histo, HISTO_P50, &(link->latency[LATENCY_P50]));
+    (void)histo_value(link->latency_histo, HISTO_P90, &(link->latency[LATENCY_P90]));
+    (void)histo_value(link->latency_histo, HISTO_P99, &(link->latency[LATENCY_P99]));
+
+    H_ITER(link->api_stats, api_stats, tmp) {
+        api_stats->err_ratio = (float)((float)api_stats->err_count / (float)api_stats->req_count);
+        api_stats->not_found_ratio = (float)((float)api_stats->err_type_count[L7_ERR_NOT_FOUND] / (float)api_stats->req_count);
+        api_stats->server_err_ratio = (float)((float)api_stats->err_type_count[L7_ERR_SERVER] / (float)api_stats->req_count);
+        api_stats->throughput = (float)((float)api_stats->req_count / (float)probe_param->period);
+
+        (void)histo_value(api_stats->latency_histo, HISTO_P50, &(api_stats->latency[LATENCY_P50]));
+        (void)histo_value(api_stats->latency_histo, HISTO_P90, &(api_stats->latency[LATENCY_P90]));
+        (void)histo_value(api_stats->latency_histo, HISTO_P99, &(api_stats->latency[LATENCY_P99]));
+    }
 
     return;
 }
@@ -650,6 +726,50 @@ static void reprot_l7_rpc(struct l7_link_s *link)
         link->err_ratio);
 }
 
+#define OO_API_NAME "L7_API"
+static void reprot_l7_api(struct l7_link_s *link)
+{
+    unsigned char remote_ip[INET6_ADDRSTRLEN];
+    struct l7_api_stats_s *api_stats, *tmp;
+
+    if (link->api_stats == NULL) {
+        return;
+    }
+
+    ip_str(link->id.remote_addr.family, (unsigned char *)&(link->id.remote_addr.ip), remote_ip, INET6_ADDRSTRLEN);
+
+    H_ITER(link->api_stats, api_stats, tmp) {
+        (void)fprintf(stdout, "|%s|%u|%s|%u|%s|%s|%s"
+            "|%s|%s|%s|%s|%s"
+            "|%.2f|%.2f|%.2f|%.2f|%.2f|%.2f|%.2f|%.2f|\n",
+
+            OO_API_NAME,
+            link->id.tgid,
+            remote_ip,
+            link->id.remote_addr.port,
+            proto_name[link->id.protocol],
+            l7_role_name[link->id.l7_role],
+            api_stats->api,
+
+            link->l7_info.comm,
+            link->l7_info.container_id,
+            link->l7_info.pod_id,
+            link->l7_info.pod_ip,
+            link->l7_info.is_ssl ? "ssl" : "no_ssl",
+
+            api_stats->throughput,
+
+            (float)((float)api_stats->latency_sum / (float)api_stats->req_count),
+            api_stats->latency[LATENCY_P50],
+            api_stats->latency[LATENCY_P90],
+            api_stats->latency[LATENCY_P99],
+
+            api_stats->err_ratio,
+            api_stats->not_found_ratio,
+            api_stats->server_err_ratio);
+    }
+}
+
 static void report_l7_stats(struct l7_mng_s *l7_mng)
 {
     struct l7_link_s *link, *tmp;
@@ -657,6 +777,7 @@ static void report_l7_stats(struct l7_mng_s *l7_mng)
     H_ITER(l7_mng->l7_links, link, tmp) {
         reprot_l7_link(link);
         reprot_l7_rpc(link);
+        reprot_l7_api(link);
     }
 
     return;
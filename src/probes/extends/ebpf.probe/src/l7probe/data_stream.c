@@ -138,6 +138,7 @@ static struct raw_data_s* __do_overlay_raw_data(const struct raw_data_s* dst_dat
     new_raw_data->data_len = mem_size - sizeof(struct raw_data_s);
     new_raw_data->timestamp_ns = dst_data->timestamp_ns;
     new_raw_data->current_pos = dst_data->current_pos;
+    new_raw_data->skip_len = 0;
     new_raw_data->flags = 0;
 
     p = new_raw_data->data;
@@ -204,7 +205,9 @@ static void __do_pop_frames(enum proto_type_t type, struct frame_buf_s *frame_bu
     start = 0;
     for (int i = frame_bufs->current_pos; i < frame_bufs->frame_buf_size && i < __FRAME_BUF_SIZE && start < __FRAME_BUF_SIZE; i++) {
         frame_bufs->frames[start++] = frame_bufs->frames[i];
+        frame_bufs->frames[i] = NULL;
     }
+    frame_bufs->frame_buf_size = start;
     frame_bufs->current_pos = 0;
 
     return;
@@ -242,6 +245,9 @@ void deinit_data_stream(struct data_stream_s *data_stream)
         }
     }
     data_stream->frame_bufs.frame_buf_size = 0;
+
+    free_proto_ctx(data_stream->type, data_stream->proto_ctx);
+    data_stream->proto_ctx = NULL;
     return;
 }
 
@@ -264,7 +270,7 @@ static enum parse_rslt_e __do_parse_frames(enum message_type_t msg_type, struct
     enum parse_rslt_e rslt;
 
     frame_data = NULL;
-    parse_state = proto_parse_frame(data_stream->type, msg_type, raw_data, &frame_data);
+    parse_state = proto_parse_frame(data_stream->type, msg_type, raw_data, &data_stream->proto_ctx, &frame_data);
     switch (parse_state) {
         case STATE_SUCCESS:
         {
@@ -290,7 +296,11 @@ static enum parse_rslt_e __do_parse_frames(enum message_type_t msg_type, struct
         }
         case STATE_IGNORE:
         {
-            rslt = PARSE_NEXT;
+            if (raw_data->current_pos == raw_data->data_len) {
+                rslt = PARSE_NEXT;
+            } else {
+                rslt = PARSE_REPEAT;
+            }
             break;
         }
         case STATE_INVALID:
@@ -323,6 +333,24 @@ static enum parse_rslt_e __do_parse_frames(enum message_type_t msg_type, struct
     return rslt;
 }
 
+// Skip the remaining part of a message which is larger than the previous raw data.
+static int __do_skip_raw_data(struct data_stream_s *data_stream, struct raw_data_s *raw_data)
+{
+    size_t skip_len;
+
+    if (data_stream->skip_len == 0) {
+        return 0;
+    }
+
+    skip_len = raw_data->data_len - raw_data->current_pos;
+    if (skip_len > data_stream->skip_len) {
+        skip_len = data_stream->skip_len;
+    }
+    raw_data->current_pos += skip_len;
+    data_stream->skip_len -= skip_len;
+
+    return (raw_data->current_pos == raw_data->data_len) ? -1 : 0;
+}
 
 int data_stream_parse_frames(enum message_type_t msg_type, struct data_stream_s *data_stream)
 {
@@ -337,6 +365,15 @@ next:
             break;
         }
 
+        if (__do_skip_raw_data(data_stream, raw_data)) {
+            raw_data = pop_raw_data(data_stream);
+            if (raw_data) {
+                destroy_raw_data(raw_data);
+                raw_data = NULL;
+            }
+            goto next;
+        }
+
 rebound:
         new_pos = proto_find_frame_boundary(data_stream->type, msg_type, raw_data);
         if (-1 == new_pos) {
@@ -355,6 +392,7 @@ repeat:
         if (rslt == PARSE_NEXT) {
             poped_raw_data = pop_raw_data(data_stream);
             if (poped_raw_data) {
+                data_stream->skip_len = poped_raw_data->skip_len;
                 destroy_raw_data(poped_raw_data);
                 poped_raw_data = NULL;
             }
@@ -395,6 +433,7 @@ int data_stream_add_raw_data(struct data_stream_s *data_stream, const char *data
 
     new_raw_data->timestamp_ns = timestamp_ns;
     new_raw_data->current_pos = 0;
+    new_raw_data->skip_len = 0;
     new_raw_data->flags = 0;
     (void)memcpy(new_raw_data->data, data, data_len);
 
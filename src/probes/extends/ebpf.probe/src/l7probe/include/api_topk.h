@@ -0,0 +1,54 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-08-29
+ * Description: top-K(space-saving) sketch of high cardinality apis
+ ******************************************************************************/
+#ifndef __API_TOPK_H__
+#define __API_TOPK_H__
+
+#pragma once
+
+#include "common.h"
+#include "hash.h"
+#include "include/data_stream.h"
+
+#define L7_API_TOPK_SIZE    64
+#define L7_API_OTHER        "[other]"   // apis out of the top-K, not a valid dns name or redis/kafka api
+
+struct api_topk_item_s {
+    H_HANDLE;
+    char api[L7_API_LEN];
+    u64 count;      // estimated count, overestimated by the count of the api it took over
+};
+
+/*
+ * Space-saving sketch: K counters monitor the most frequent apis, an unmonitored api takes over the counter
+ * with the minimal count. Counts are halved every period so that apis which are no longer hot age out.
+ */
+struct api_topk_s {
+    struct api_topk_item_s *index;
+    u32 num;
+    struct api_topk_item_s items[L7_API_TOPK_SIZE];
+};
+
+struct api_topk_s *create_api_topk(void);
+void destroy_api_topk(struct api_topk_s *topk);
+
+/*
+ * Count one occurrence of api.
+ * Returns api if it is monitored by the sketch, otherwise L7_API_OTHER. An api which just takes over a counter
+ * is reported as L7_API_OTHER this time, so that a long tail of rare apis only adds to L7_API_OTHER.
+ */
+const char *api_topk_add(struct api_topk_s *topk, const char *api);
+void api_topk_decay(struct api_topk_s *topk);
+
+#endif
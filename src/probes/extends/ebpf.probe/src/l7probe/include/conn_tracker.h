@@ -19,6 +19,7 @@
 
 #include "include/connect.h"
 #include "include/data_stream.h"
+#include "include/api_topk.h"
 #include "histogram.h"
 #include "hash.h"
 
@@ -74,20 +75,11 @@ struct tracker_close_s {
 };
 
 
-enum latency_range_t {
-    LT_RANGE_1 = 0,         // (0 ~ 1]ms
-    LT_RANGE_2,             // (1 ~ 3]ms
-    LT_RANGE_3,             // (3 ~ 10]ms
-    LT_RANGE_4,             // (10 ~ 20]ms
-    LT_RANGE_5,             // (20 ~ 50]ms
-    LT_RANGE_6,             // (50 ~ 100]ms
-    LT_RANGE_7,             // (100 ~ 300]ms
-    LT_RANGE_8,             // (300 ~ 500]ms
-    LT_RANGE_9,             // (500 ~ 1000]ms
-    LT_RANGE_10,            // (1000 ~ 10000]ms
-
-    __MAX_LT_RANGE
-};
+// RPC latency(ns) histograms, the relative error of P50/P90/P99 is below 10^(-sig_digits)
+#define L7_LATENCY_LOWEST           1000                        // 1us
+#define L7_LATENCY_HIGHEST          (60 * NSEC_PER_SEC)         // 60s, larger latencies are counted as 60s
+#define L7_LINK_LATENCY_SIG_DIGITS  2
+#define L7_LATENCY_SIG_DIGITS       1                           // Trackers and apis, there are many of them
 
 enum latency_t {
     LATENCY_P50 = 0,
@@ -121,7 +113,7 @@ struct conn_tracker_s {
     struct tracker_close_s close_info;
     u64 stats[__MAX_STATS];
 
-    struct histo_bucket_s latency_buckets[__MAX_LT_RANGE];
+    struct histo_s *latency_histo;
     u64 latency_sum;
 
     float throughput[__MAX_THROUGHPUT];
@@ -151,16 +143,35 @@ struct l7_link_id_s {
     enum proto_type_t protocol; // L7 protocol type
 };
 
+// Per-api(eg.. redis command) RPC stats of a link
+#define L7_API_STATS_MAX    256     // Max number of apis tracked per link, the rest only count in link stats
+struct l7_api_stats_s {
+    H_HANDLE;
+    char api[L7_API_LEN];
+    u64 req_count;
+    u64 err_count;
+    u64 err_type_count[__MAX_L7_ERR_TYPE];
+    u64 latency_sum;
+    struct histo_s *latency_histo;
+    float throughput;
+    float latency[__MAX_LATENCY];
+    float err_ratio;
+    float not_found_ratio;
+    float server_err_ratio;
+};
+
 struct l7_link_s {
     H_HANDLE;
     struct l7_link_id_s id;
     struct l7_info_s l7_info;
     u64 stats[__MAX_STATS];
-    struct histo_bucket_s latency_buckets[__MAX_LT_RANGE];
+    struct histo_s *latency_histo;
     float throughput[__MAX_THROUGHPUT];
     float latency[__MAX_LATENCY];
     float err_ratio;
     u64 latency_sum;
+    struct l7_api_stats_s *api_stats;
+    struct api_topk_s *api_topk;    // Only for protocols whose apis are unbounded, eg.. dns domains
 };
 
 void destroy_trackers(void *ctx);
@@ -75,15 +75,31 @@ struct raw_data_s {
 
     // current_pos有效值：[0, data_len - 1]，current_pos = data_len时，证明已解析完当前data[]
     size_t current_pos;
+
+    // 超出当前data[]的待跳过字节数（如报文体长度大于剩余数据），由后续raw data继续跳过，避免缓存大报文
+    size_t skip_len;
     char data[0];
 };
 
 /**
  * Record of matching request and response frames.
  */
+#define L7_API_LEN 64
+// Finer class of an error record, for protocols which report such rates(eg.. dns NXDOMAIN/SERVFAIL)
+enum l7_err_type_t {
+    L7_ERR_OTHER = 0,
+    L7_ERR_NOT_FOUND,
+    L7_ERR_SERVER,
+
+    __MAX_L7_ERR_TYPE
+};
+
 struct record_data_s {
     void *record;   // protocol_record
     u64 latency;    // latency of record: resp.timestamp_ns - req.timestamp_ns
+    char api[L7_API_LEN];   // api of record(eg.. redis command), empty if the protocol does not report per-api stats
+    char is_err;
+    char err_type;  // enum l7_err_type_t, valid if is_err
 };
 
 /**
@@ -113,6 +129,8 @@ struct raw_buf_s {
 struct data_stream_s {
     struct raw_buf_s raw_bufs;
     struct frame_buf_s frame_bufs;
+    size_t skip_len;    // bytes to be skipped at the head of next raw data
+    void *proto_ctx;    // parse state of stateful protocols(eg. HPACK dynamic table of HTTP/2), freed with the stream
 
     enum proto_type_t type;
 };
@@ -29,10 +29,11 @@ enum filter_type_t {
 #define L7PROBE_TRACING_REDIS   0x0004
 #define L7PROBE_TRACING_MYSQL   0x0008
 #define L7PROBE_TRACING_PGSQL   0x0010
-#define L7PROBE_TRACING_KAFKA   0x0012
-#define L7PROBE_TRACING_MONGO   0x0014
-#define L7PROBE_TRACING_CQL     0x0018
+#define L7PROBE_TRACING_KAFKA   0x0080
+#define L7PROBE_TRACING_MONGO   0x0100
+#define L7PROBE_TRACING_CQL     0x0200
 #define L7PROBE_TRACING_NATS    0x0020
+#define L7PROBE_TRACING_HTTP2   0x0040
 
 struct filter_args_s {
     char is_tracing;            // Support for L7 protocol tracing
@@ -29,10 +29,11 @@
 #define REDIS_ENABLE    0x0004
 #define MYSQL_ENABLE    0x0008
 #define PGSQL_ENABLE    0x0010
-#define KAFKA_ENABLE    0x0012
-#define MONGO_ENABLE    0x0014
-#define CQL_ENABLE      0x0018
+#define KAFKA_ENABLE    0x0080
+#define MONGO_ENABLE    0x0100
+#define CQL_ENABLE      0x0200
 #define NATS_ENABLE     0x0020
+#define HTTP2_ENABLE    0x0040
 
 #define PROTO_ALL_ENABLE     0XFFFF
 
@@ -104,6 +105,53 @@ static __inline enum message_type_t __get_http_type(const char* buf, size_t coun
     return MESSAGE_UNKNOW;
 }
 
+/*
+
+// References HTTP/2 spec:
+https://www.rfc-editor.org/rfc/rfc9113#section-3.4
+
+The client connection preface starts with "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n", the server connection
+preface is a SETTINGS frame, which must be the first frame the server sends:
+0         8        16        24        32
++---------+---------+---------+---------+
+|          length(6 * n)      |  type(4)|
++---------+---------+---------+---------+
+| flags(0)|        stream_id(0)         |
++---------+---------+---------+---------+
+|         |      ... settings ...       .
++---------+------------------------------
+
+*/
+#define __HTTP2_FRAME_HEADER_SIZE   9
+#define __HTTP2_FRAME_SETTINGS      4
+#define __HTTP2_SETTING_SIZE        6
+#define __HTTP2_MAX_SETTINGS        16  // 6 settings defined by RFC 9113, reserve for extensions
+
+static __inline enum message_type_t __get_http2_type(const char* buf, size_t count)
+{
+    if (count < __HTTP2_FRAME_HEADER_SIZE) {
+        return MESSAGE_UNKNOW;
+    }
+
+    // "PRI * HTT", long enough to tell from HTTP/1.x
+    if (buf[0] == 'P' && buf[1] == 'R' && buf[2] == 'I' && buf[3] == ' ' && buf[4] == '*'
+        && buf[5] == ' ' && buf[6] == 'H' && buf[7] == 'T' && buf[8] == 'T') {
+        return MESSAGE_REQUEST;
+    }
+
+    u32 len = ((u32)(u8)buf[0] << 16) | ((u32)(u8)buf[1] << 8) | (u8)buf[2];
+    if (buf[3] != __HTTP2_FRAME_SETTINGS || buf[4] != 0) {
+        return MESSAGE_UNKNOW;
+    }
+    if ((len % __HTTP2_SETTING_SIZE) != 0 || len > __HTTP2_SETTING_SIZE * __HTTP2_MAX_SETTINGS) {
+        return MESSAGE_UNKNOW;
+    }
+    if (buf[5] != 0 || buf[6] != 0 || buf[7] != 0 || buf[8] != 0) {
+        return MESSAGE_UNKNOW;
+    }
+    return MESSAGE_RESPONSE;
+}
+
 #define __REDIS_MIN_SIZE 6      // Smallest Redis size
 
 #define __IS_REDIS_COMMAND(cmd) ((cmd == '+') || (cmd == '-') || \
@@ -526,6 +574,61 @@ static __inline enum message_type_t get_mysql_type(const char* buf, size_t count
     return MESSAGE_UNKNOW;
 }
 
+/*
+
+// References kafka spec:
+https://kafka.apache.org/protocol.html#protocol_messages
+
+Kafka request:
+0         8        16        24        32
++---------+---------+---------+---------+
+|                 length                |
++---------+---------+---------+---------+
+|       api_key     |    api_version    |
++---------+---------+---------+---------+
+|             correlation_id            |
++---------+---------+---------+---------+
+.            ...  body ...              .
++----------------------------------------
+
+*/
+#define __KAFKA_MINSIZE             12
+#define __KAFKA_MAXSIZE             (100 * 1024 * 1024)
+#define __KAFKA_MAX_API_KEY         74
+#define __KAFKA_MAX_API_VERSION     20
+
+static __inline enum message_type_t __get_kafka_type(const char* buf, size_t count)
+{
+    if (count < __KAFKA_MINSIZE) {
+        return MESSAGE_UNKNOW;
+    }
+
+    // Kafka is big-endian.
+    int len = (int)(((u32)(u8)buf[0] << 24) | ((u32)(u8)buf[1] << 16) | ((u32)(u8)buf[2] << 8) | (u8)buf[3]);
+    s16 api_key = (s16)(((u16)(u8)buf[4] << 8) | (u8)buf[5]);
+    s16 api_version = (s16)(((u16)(u8)buf[6] << 8) | (u8)buf[7]);
+    int correlation_id = (int)(((u32)(u8)buf[8] << 24) | ((u32)(u8)buf[9] << 16) | ((u32)(u8)buf[10] << 8) | (u8)buf[11]);
+
+    if ((len < __KAFKA_MINSIZE - 4) || (len > __KAFKA_MAXSIZE)) {
+        return MESSAGE_UNKNOW;
+    }
+
+    if ((api_key < 0) || (api_key > __KAFKA_MAX_API_KEY)) {
+        return MESSAGE_UNKNOW;
+    }
+
+    if ((api_version < 0) || (api_version > __KAFKA_MAX_API_VERSION)) {
+        return MESSAGE_UNKNOW;
+    }
+
+    if (correlation_id < 0) {
+        return MESSAGE_UNKNOW;
+    }
+
+    // Only requests can be identified, responses carry no api key.
+    return MESSAGE_REQUEST;
+}
+
 static __inline int get_l7_protocol(const char* buf, size_t count, u32 flags, struct l7_proto_s* l7pro)
 {
     enum message_type_t type;
@@ -544,6 +647,15 @@ static __inline int get_l7_protocol(const char* buf, size_t count, u32 flags, st
         }
     }
 
+    if (flags & HTTP2_ENABLE) {
+        type = __get_http2_type(buf, count);
+        if (type != MESSAGE_UNKNOW) {
+            l7pro->proto = PROTO_HTTP2;
+            l7pro->type = type;
+            return 0;
+        }
+    }
+
     if (flags & DNS_ENABLE) {
         type = __get_dns_type(buf, count);
         if (type != MESSAGE_UNKNOW) {
@@ -588,6 +700,16 @@ static __inline int get_l7_protocol(const char* buf, size_t count, u32 flags, st
             return 0;
         }
     }
+
+    // Kafka request header is weak to identify, keep it the last one.
+    if (flags & KAFKA_ENABLE) {
+        type = __get_kafka_type(buf, count);
+        if (type != MESSAGE_UNKNOW) {
+            l7pro->proto = PROTO_KAFKA;
+            l7pro->type = type;
+            return 0;
+        }
+    }
     return -1;
 }
 #endif
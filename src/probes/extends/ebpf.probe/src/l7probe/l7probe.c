@@ -53,17 +53,11 @@ static void __do_l7_load_tcp_fd(int fd)
 {
     int i, j;
     int role;
-    struct tcp_listen_ports* tlps;
+    struct tcp_listen_ports* tlps = NULL;
     struct tcp_estabs* tes = NULL;
     struct conn_id_s k;
 
-    tlps = get_listen_ports();
-    if (tlps == NULL) {
-        goto err;
-    }
-
-    tes = get_estab_tcps(tlps);
-    if (tes == NULL) {
+    if (get_listen_estab_tcps(&tlps, &tes) < 0) {
         goto err;
     }
 
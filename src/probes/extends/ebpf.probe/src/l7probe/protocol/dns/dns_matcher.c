@@ -0,0 +1,144 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-08-29
+ * Description:
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "common.h"
+#include "dns_matcher.h"
+
+// 待匹配查询的上限，超出时丢弃最早的查询
+#define DNS_MAX_PENDING_REQS (__FRAME_BUF_SIZE / 2)
+
+static char dns_err_type(uint8_t rcode)
+{
+    switch (rcode) {
+        case DNS_RCODE_NXDOMAIN:
+            return L7_ERR_NOT_FOUND;
+        case DNS_RCODE_SERVFAIL:
+            return L7_ERR_SERVER;
+        default:
+            return L7_ERR_OTHER;
+    }
+}
+
+static void add_dns_record_into_buf(const struct dns_msg_s *req_msg, const struct dns_msg_s *resp_msg,
+                                    struct record_buf_s *record_buf)
+{
+    struct dns_record_s *record;
+    struct record_data_s *record_data;
+
+    record = init_dns_record();
+    if (record == NULL) {
+        ERROR("[DNS MATCHER] Failed to malloc dns_record.\n");
+        return;
+    }
+    (void)memcpy(record->domain, req_msg->domain, DNS_NAME_LEN);
+    record->qtype = req_msg->qtype;
+    record->rcode = resp_msg->rcode;
+    record->req_timestamp_ns = req_msg->timestamp_ns;
+    record->resp_timestamp_ns = resp_msg->timestamp_ns;
+
+    record_data = (struct record_data_s *) malloc(sizeof(struct record_data_s));
+    if (record_data == NULL) {
+        ERROR("[DNS MATCHER] Failed to malloc record_data.\n");
+        free_dns_record(record);
+        return;
+    }
+    memset(record_data, 0, sizeof(struct record_data_s));
+    record_data->record = record;
+    if (record->resp_timestamp_ns > record->req_timestamp_ns) {
+        record_data->latency = record->resp_timestamp_ns - record->req_timestamp_ns;
+    }
+
+    // 按域名统计，域名的基数由conn_tracker中的top-K统计限制
+    (void)snprintf(record_data->api, L7_API_LEN, "%s", record->domain);
+    record_data->is_err = (record->rcode != DNS_RCODE_NOERROR);
+    record_data->err_type = dns_err_type(record->rcode);
+
+    if (record_data->is_err) {
+        ++record_buf->err_count;
+    }
+    record_buf->records[record_buf->record_buf_size] = record_data;
+    ++record_buf->record_buf_size;
+}
+
+static u64 dns_latest_timestamp(const struct frame_buf_s *req_frames, const struct frame_buf_s *resp_frames)
+{
+    u64 ts = 0;
+
+    if (req_frames->frame_buf_size > 0) {
+        ts = req_frames->frames[req_frames->frame_buf_size - 1]->timestamp_ns;
+    }
+    if (resp_frames->frame_buf_size > 0 && resp_frames->frames[resp_frames->frame_buf_size - 1]->timestamp_ns > ts) {
+        ts = resp_frames->frames[resp_frames->frame_buf_size - 1]->timestamp_ns;
+    }
+    return ts;
+}
+
+// Release the leading queries which are matched, timed out or exceed the pending limit, each query is counted once.
+static void dns_release_reqs(struct frame_buf_s *req_frames, u64 now, struct record_buf_s *record_buf)
+{
+    struct dns_msg_s *msg;
+
+    while (req_frames->current_pos < req_frames->frame_buf_size) {
+        msg = (struct dns_msg_s *) req_frames->frames[req_frames->current_pos]->frame;
+        if (!msg->matched && msg->timestamp_ns + DNS_QUERY_TIMEOUT_NS >= now &&
+            req_frames->frame_buf_size - req_frames->current_pos <= DNS_MAX_PENDING_REQS) {
+            break;
+        }
+        ++req_frames->current_pos;
+        ++record_buf->req_count;
+    }
+}
+
+void dns_match_frames(struct frame_buf_s *req_frames, struct frame_buf_s *resp_frames,
+                      struct record_buf_s *record_buf)
+{
+    record_buf->err_count = 0;
+    record_buf->record_buf_size = 0;
+    record_buf->req_count = 0;
+    record_buf->resp_count = 0;
+
+    while (resp_frames->current_pos < resp_frames->frame_buf_size) {
+        struct dns_msg_s *resp_msg;
+        struct dns_msg_s *req_msg = NULL;
+
+        if (record_buf->record_buf_size >= RECORD_BUF_SIZE) {
+            break;
+        }
+
+        resp_msg = (struct dns_msg_s *) resp_frames->frames[resp_frames->current_pos]->frame;
+        // 事务id只有16位，同时比较问题，避免重传或id复用时匹配到其他查询
+        for (size_t req_pos = req_frames->current_pos; req_pos < req_frames->frame_buf_size; ++req_pos) {
+            struct dns_msg_s *msg = (struct dns_msg_s *) req_frames->frames[req_pos]->frame;
+            if (!msg->matched && msg->txid == resp_msg->txid && msg->qtype == resp_msg->qtype &&
+                strcmp(msg->domain, resp_msg->domain) == 0) {
+                req_msg = msg;
+                break;
+            }
+        }
+        ++resp_frames->current_pos;
+        ++record_buf->resp_count;
+
+        // 找不到对应查询说明查询已丢失或已超时，丢弃该响应
+        if (req_msg == NULL) {
+            continue;
+        }
+        req_msg->matched = true;
+        add_dns_record_into_buf(req_msg, resp_msg, record_buf);
+    }
+
+    dns_release_reqs(req_frames, dns_latest_timestamp(req_frames, resp_frames), record_buf);
+}
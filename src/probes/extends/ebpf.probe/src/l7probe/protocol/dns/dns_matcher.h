@@ -0,0 +1,38 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-08-29
+ * Description:
+ ******************************************************************************/
+
+#ifndef __DNS_MATCHER_H__
+#define __DNS_MATCHER_H__
+
+#pragma once
+
+#include "../../include/data_stream.h"
+#include "dns_msg_format.h"
+
+// 解析器默认超时5s并重试，超过该时间仍未得到响应的查询不再等待
+#define DNS_QUERY_TIMEOUT_NS (10 * 1000000000ULL)
+
+/**
+ * Match DNS queries and responses by transaction id and question.
+ * 同一socket上的查询（如并发的A/AAAA查询）乱序完成，未得到响应的查询保留在队列中，直至得到响应、超时或待匹配查询过多时被丢弃。
+ *
+ * @param req_frames
+ * @param resp_frames
+ * @param record_buf
+ */
+void dns_match_frames(struct frame_buf_s *req_frames, struct frame_buf_s *resp_frames,
+                      struct record_buf_s *record_buf);
+
+#endif
@@ -0,0 +1,82 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-08-29
+ * Description:
+ ******************************************************************************/
+
+#ifndef __DNS_MSG_FORMAT_H__
+#define __DNS_MSG_FORMAT_H__
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../../include/data_stream.h"
+
+// References DNS spec:
+// https://www.rfc-editor.org/rfc/rfc1035#section-4.1
+#define DNS_HEADER_LEN 12
+#define DNS_TCP_LEN_SIZE 2      // DNS over TCP报文前带2字节长度
+#define DNS_QUESTION_FIXED_LEN 4   // qtype(2) + qclass(2)
+#define DNS_RR_FIXED_LEN 10        // type(2) + class(2) + ttl(4) + rdlength(2)
+
+#define DNS_FLAG_QR 0x8000
+#define DNS_FLAG_Z 0x0040
+#define DNS_OPCODE(flags) (((flags) >> 11) & 0xf)
+#define DNS_RCODE(flags) ((flags) & 0xf)
+#define DNS_OPCODE_QUERY 0
+
+// 域名最长253字节，超出部分截断
+#define DNS_NAME_LEN 256
+
+enum dns_rcode_t {
+    DNS_RCODE_NOERROR = 0,
+    DNS_RCODE_FORMERR = 1,
+    DNS_RCODE_SERVFAIL = 2,
+    DNS_RCODE_NXDOMAIN = 3,
+    DNS_RCODE_NOTIMP = 4,
+    DNS_RCODE_REFUSED = 5,
+};
+
+/**
+ * DNS query or response, only the header and the (first) question are kept.
+ */
+struct dns_msg_s {
+    u64 timestamp_ns;
+    uint16_t txid;
+    uint16_t qtype;
+    uint8_t rcode;      // response only
+    bool matched;       // query only, the response is matched
+    char domain[DNS_NAME_LEN];  // lower case QNAME without the trailing dot, "." for the root
+};
+
+struct dns_msg_s *init_dns_msg(void);
+
+void free_dns_msg(struct dns_msg_s *msg);
+
+/**
+ * DNS record, query & response metadata copied from frames.
+ */
+struct dns_record_s {
+    char domain[DNS_NAME_LEN];
+    uint16_t qtype;
+    uint8_t rcode;
+    u64 req_timestamp_ns;
+    u64 resp_timestamp_ns;
+};
+
+struct dns_record_s *init_dns_record(void);
+
+void free_dns_record(struct dns_record_s *record);
+
+#endif
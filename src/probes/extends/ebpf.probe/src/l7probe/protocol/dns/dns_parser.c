@@ -0,0 +1,292 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-08-29
+ * Description:
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "common.h"
+#include "dns_parser.h"
+#include "../utils/macros.h"
+#include "../utils/binary_decoder.h"
+
+#define DNS_LABEL_PTR 0xc0
+#define DNS_LABEL_PTR_MASK 0x3fff
+#define DNS_NAME_MAX_WIRE_LEN 255
+#define DNS_NAME_MAX_PTR_HOPS 16
+
+// 查询报文的附加段只携带EDNS OPT，以及可能的TSIG
+#define DNS_REQ_MAX_ADDITIONAL 2
+
+#define DNS_QDCOUNT_OFFSET 4
+#define DNS_ANCOUNT_OFFSET 6
+#define DNS_NSCOUNT_OFFSET 8
+#define DNS_ARCOUNT_OFFSET 10
+
+static inline uint16_t dns_get_u16(const uint8_t *p)
+{
+    return big_endian_bytes_to_uint16_t((const char *)p);
+}
+
+static bool dns_valid_header(const uint8_t *hdr, enum message_type_t msg_type)
+{
+    uint16_t flags = dns_get_u16(hdr + 2);
+    bool is_resp = (flags & DNS_FLAG_QR) != 0;
+
+    if (is_resp != (msg_type == MESSAGE_RESPONSE)) {
+        return false;
+    }
+    if (DNS_OPCODE(flags) != DNS_OPCODE_QUERY || (flags & DNS_FLAG_Z) != 0) {
+        return false;
+    }
+    // 协议允许多个问题，但实际的解析器只发送1个
+    if (dns_get_u16(hdr + DNS_QDCOUNT_OFFSET) != 1) {
+        return false;
+    }
+    if (is_resp) {
+        return true;
+    }
+    return DNS_RCODE(flags) == DNS_RCODE_NOERROR && dns_get_u16(hdr + DNS_ANCOUNT_OFFSET) == 0 &&
+           dns_get_u16(hdr + DNS_NSCOUNT_OFFSET) == 0 &&
+           dns_get_u16(hdr + DNS_ARCOUNT_OFFSET) <= DNS_REQ_MAX_ADDITIONAL;
+}
+
+/**
+ * Offset of the DNS header from data: 0 for a UDP datagram, DNS_TCP_LEN_SIZE for a TCP message, -1 if neither.
+ * 两种格式不会同时成立：按UDP格式时qdcount位于TCP格式的flags处，请求的flags不可能为1，响应的QR位必然置位。
+ */
+static int dns_header_offset(const uint8_t *data, size_t avail, enum message_type_t msg_type)
+{
+    if (avail >= DNS_HEADER_LEN && dns_valid_header(data, msg_type)) {
+        return 0;
+    }
+    if (avail >= DNS_TCP_LEN_SIZE + DNS_HEADER_LEN && dns_get_u16(data) >= DNS_HEADER_LEN &&
+        dns_valid_header(data + DNS_TCP_LEN_SIZE, msg_type)) {
+        return DNS_TCP_LEN_SIZE;
+    }
+    return -1;
+}
+
+static void dns_append_label(char *name, size_t name_size, size_t *name_len, const uint8_t *label, uint8_t len)
+{
+    if (*name_len > 0 && *name_len < name_size - 1) {
+        name[(*name_len)++] = '.';
+    }
+    for (uint8_t i = 0; i < len && *name_len < name_size - 1; i++) {
+        char c = (char)tolower(label[i]);
+        // 域名会作为api上报，不合法的字符（包括输出分隔符'|'）替换掉
+        if (!isalnum((unsigned char)c) && c != '-' && c != '_' && c != '*') {
+            c = '?';
+        }
+        name[(*name_len)++] = c;
+    }
+}
+
+/**
+ * Decode a (compressed) domain name at *pos of the message, name can be NULL to skip the name.
+ * 压缩指针只允许指向当前位置之前，且跳转次数有上限，避免构造的报文导致死循环。
+ *
+ * @return STATE_NEEDS_MORE_DATA if the name runs beyond msg_len
+ */
+static parse_state_t dns_decode_name(const uint8_t *msg, size_t msg_len, size_t *pos, char *name, size_t name_size)
+{
+    size_t cur = *pos;
+    size_t end = 0;
+    size_t name_len = 0;
+    size_t wire_len = 0;
+    int hops = 0;
+    uint8_t len;
+
+    while (1) {
+        if (cur >= msg_len) {
+            return STATE_NEEDS_MORE_DATA;
+        }
+        len = msg[cur];
+        if ((len & DNS_LABEL_PTR) == DNS_LABEL_PTR) {
+            if (cur + 1 >= msg_len) {
+                return STATE_NEEDS_MORE_DATA;
+            }
+            size_t target = dns_get_u16(&msg[cur]) & DNS_LABEL_PTR_MASK;
+            if (hops == 0) {
+                end = cur + 2;
+            }
+            if (target >= cur || ++hops > DNS_NAME_MAX_PTR_HOPS) {
+                return STATE_INVALID;
+            }
+            cur = target;
+            continue;
+        }
+        // 0x40/0x80为已废弃的扩展标签类型
+        if ((len & DNS_LABEL_PTR) != 0) {
+            return STATE_INVALID;
+        }
+
+        wire_len += len + 1;
+        if (wire_len > DNS_NAME_MAX_WIRE_LEN) {
+            return STATE_INVALID;
+        }
+        if (len == 0) {
+            cur++;
+            break;
+        }
+        if (cur + 1 + len > msg_len) {
+            return STATE_NEEDS_MORE_DATA;
+        }
+        if (name != NULL) {
+            dns_append_label(name, name_size, &name_len, &msg[cur + 1], len);
+        }
+        cur += 1 + len;
+    }
+
+    if (name != NULL) {
+        if (name_len == 0) {
+            name[name_len++] = '.';
+        }
+        name[name_len] = '\0';
+    }
+    *pos = (hops > 0) ? end : cur;
+    return STATE_SUCCESS;
+}
+
+// Skip resource records from *pos, used to find the end of a UDP datagram.
+static parse_state_t dns_skip_rrs(const uint8_t *msg, size_t msg_len, size_t *pos, uint32_t count)
+{
+    size_t cur = *pos;
+    parse_state_t state;
+
+    for (uint32_t i = 0; i < count; i++) {
+        state = dns_decode_name(msg, msg_len, &cur, NULL, 0);
+        if (state != STATE_SUCCESS) {
+            return state;
+        }
+        if (cur + DNS_RR_FIXED_LEN > msg_len) {
+            return STATE_NEEDS_MORE_DATA;
+        }
+        cur += DNS_RR_FIXED_LEN + dns_get_u16(&msg[cur + DNS_RR_FIXED_LEN - 2]);
+        if (cur > msg_len) {
+            return STATE_NEEDS_MORE_DATA;
+        }
+    }
+    *pos = cur;
+    return STATE_SUCCESS;
+}
+
+size_t dns_find_frame_boundary(enum message_type_t msg_type, struct raw_data_s *raw_data)
+{
+    const uint8_t *data = (const uint8_t *)raw_data->data;
+
+    for (size_t i = raw_data->current_pos; i + DNS_TCP_LEN_SIZE + DNS_HEADER_LEN <= raw_data->data_len; ++i) {
+        if (dns_header_offset(&data[i], raw_data->data_len - i, msg_type) >= 0) {
+            return i;
+        }
+    }
+
+    // 数据不足以判断时，保留当前位置等待更多数据
+    if (raw_data->current_pos < raw_data->data_len &&
+        raw_data->data_len - raw_data->current_pos < DNS_TCP_LEN_SIZE + DNS_HEADER_LEN) {
+        return raw_data->current_pos;
+    }
+    return PARSER_INVALID_BOUNDARY_INDEX;
+}
+
+parse_state_t dns_parse_frame(enum message_type_t msg_type, struct raw_data_s *raw_data,
+                              struct frame_data_s **frame_data)
+{
+    struct dns_msg_s *msg;
+    const uint8_t *hdr;
+    char domain[DNS_NAME_LEN];
+    size_t start = raw_data->current_pos;
+    size_t avail;
+    size_t msg_len;
+    size_t view_len;
+    size_t pos;
+    uint32_t rr_count;
+    uint16_t flags;
+    int hdr_off;
+    parse_state_t state;
+
+    if (raw_data->data_len == 0 || start >= raw_data->data_len) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+    avail = raw_data->data_len - start;
+    if (avail < DNS_TCP_LEN_SIZE + DNS_HEADER_LEN) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+
+    hdr_off = dns_header_offset((const uint8_t *)&raw_data->data[start], avail, msg_type);
+    if (hdr_off < 0) {
+        raw_data->current_pos = start + 1;
+        return STATE_INVALID;
+    }
+    hdr = (const uint8_t *)&raw_data->data[start + hdr_off];
+    avail -= (size_t)hdr_off;
+    msg_len = (hdr_off == DNS_TCP_LEN_SIZE) ? dns_get_u16((const uint8_t *)&raw_data->data[start]) : avail;
+    view_len = (msg_len < avail) ? msg_len : avail;
+
+    pos = DNS_HEADER_LEN;
+    state = dns_decode_name(hdr, view_len, &pos, domain, DNS_NAME_LEN);
+    if (state == STATE_SUCCESS && pos + DNS_QUESTION_FIXED_LEN > view_len) {
+        state = STATE_NEEDS_MORE_DATA;
+    }
+    // 只有TCP报文未接收完整时才需要等待，截断的UDP报文或超出TCP报文长度的问题段都是无效数据
+    if (state == STATE_NEEDS_MORE_DATA && !(hdr_off == DNS_TCP_LEN_SIZE && avail < msg_len)) {
+        state = STATE_INVALID;
+    }
+    if (state != STATE_SUCCESS) {
+        raw_data->current_pos = (state == STATE_INVALID) ? start + 1 : start;
+        return state;
+    }
+
+    msg = init_dns_msg();
+    if (msg == NULL) {
+        ERROR("[DNS parser] Failed to malloc dns_msg.\n");
+        return STATE_INVALID;
+    }
+    flags = dns_get_u16(hdr + 2);
+    msg->timestamp_ns = raw_data->timestamp_ns;
+    msg->txid = dns_get_u16(hdr);
+    msg->rcode = DNS_RCODE(flags);
+    msg->qtype = dns_get_u16(hdr + pos);
+    (void)memcpy(msg->domain, domain, DNS_NAME_LEN);
+    pos += DNS_QUESTION_FIXED_LEN;
+
+    if (hdr_off == DNS_TCP_LEN_SIZE) {
+        if (msg_len <= avail) {
+            raw_data->current_pos = start + DNS_TCP_LEN_SIZE + msg_len;
+        } else {
+            raw_data->current_pos = raw_data->data_len;
+            raw_data->skip_len = msg_len - avail;
+        }
+    } else {
+        // 一个raw_data通常就是一个UDP报文，资源记录不完整（被截断）时丢弃剩余数据
+        rr_count = (uint32_t)dns_get_u16(hdr + DNS_ANCOUNT_OFFSET) + dns_get_u16(hdr + DNS_NSCOUNT_OFFSET) +
+                   dns_get_u16(hdr + DNS_ARCOUNT_OFFSET);
+        if (dns_skip_rrs(hdr, view_len, &pos, rr_count) == STATE_SUCCESS) {
+            raw_data->current_pos = start + pos;
+        } else {
+            raw_data->current_pos = raw_data->data_len;
+        }
+    }
+
+    *frame_data = (struct frame_data_s *) malloc(sizeof(struct frame_data_s));
+    if ((*frame_data) == NULL) {
+        ERROR("[DNS parser] Failed to malloc frame_data.\n");
+        free_dns_msg(msg);
+        return STATE_INVALID;
+    }
+    (*frame_data)->msg_type = msg_type;
+    (*frame_data)->timestamp_ns = msg->timestamp_ns;
+    (*frame_data)->frame = msg;
+    return STATE_SUCCESS;
+}
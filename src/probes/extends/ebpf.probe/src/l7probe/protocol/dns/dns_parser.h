@@ -0,0 +1,40 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-08-29
+ * Description:
+ ******************************************************************************/
+
+#ifndef __DNS_PARSER_H__
+#define __DNS_PARSER_H__
+
+#pragma once
+
+#include "../../include/data_stream.h"
+#include "dns_msg_format.h"
+
+size_t dns_find_frame_boundary(enum message_type_t msg_type, struct raw_data_s *raw_data);
+
+/**
+ * Parse one DNS message from raw_data->current_pos, either a UDP datagram or a length-prefixed TCP message.
+ * Only the header and the 1st question(compressed QNAME supported) are decoded in place, nothing is allocated
+ * except the output message. The rest of a TCP message is skipped by length, a UDP datagram is consumed up to
+ * the end of its resource records, or to the end of raw_data if it is truncated.
+ *
+ * @param msg_type request or response
+ * @param raw_data
+ * @param frame_data
+ * @return
+ */
+parse_state_t dns_parse_frame(enum message_type_t msg_type, struct raw_data_s *raw_data,
+                              struct frame_data_s **frame_data);
+
+#endif
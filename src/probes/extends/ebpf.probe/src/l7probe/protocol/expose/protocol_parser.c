@@ -19,6 +19,21 @@
 #include "../pgsql/pgsql_matcher.h"
 #include "../http1.x/parser/http_parser.h"
 #include "../http1.x/matcher/http_matcher.h"
+#include "../redis/redis_msg_format.h"
+#include "../redis/redis_parser.h"
+#include "../redis/redis_matcher.h"
+#include "../mysql/mysql_msg_format.h"
+#include "../mysql/mysql_parser.h"
+#include "../mysql/mysql_matcher.h"
+#include "../kafka/kafka_msg_format.h"
+#include "../kafka/kafka_parser.h"
+#include "../kafka/kafka_matcher.h"
+#include "../http2/http2_msg_format.h"
+#include "../http2/http2_parser.h"
+#include "../http2/http2_matcher.h"
+#include "../dns/dns_msg_format.h"
+#include "../dns/dns_parser.h"
+#include "../dns/dns_matcher.h"
 
 /**
  * Free record data
@@ -43,13 +58,23 @@ void free_record_data(enum proto_type_t type, struct record_data_s *record_data)
         case PROTO_HTTP:
             free_http_record((http_record *) record_data);
             break;
-        // todo: add protocols:
-        case PROTO_HTTP2:
         case PROTO_REDIS:
-        case PROTO_KAFKA:
+            free_redis_record((struct redis_record_s *) record_data->record);
+            break;
         case PROTO_MYSQL:
-        case PROTO_MONGO:
+            free_mysql_record((struct mysql_record_s *) record_data->record);
+            break;
+        case PROTO_KAFKA:
+            free_kafka_record((struct kafka_record_s *) record_data->record);
+            break;
+        case PROTO_HTTP2:
+            free_http2_record((struct http2_record_s *) record_data->record);
+            break;
         case PROTO_DNS:
+            free_dns_record((struct dns_record_s *) record_data->record);
+            break;
+        // todo: add protocols:
+        case PROTO_MONGO:
         case PROTO_NATS:
         case PROTO_CQL:
         default:
@@ -58,6 +83,21 @@ void free_record_data(enum proto_type_t type, struct record_data_s *record_data)
     free(record_data);
 }
 
+void free_proto_ctx(enum proto_type_t type, void *proto_ctx)
+{
+    if (proto_ctx == NULL) {
+        return;
+    }
+
+    switch (type) {
+        case PROTO_HTTP2:
+            free_http2_conn_ctx((struct http2_conn_ctx_s *) proto_ctx);
+            break;
+        default:
+            break;
+    }
+}
+
 void free_frame_data_s(enum proto_type_t type, struct frame_data_s *frame)
 {
     if (frame == NULL) {
@@ -75,13 +115,23 @@ void free_frame_data_s(enum proto_type_t type, struct frame_data_s *frame)
         case PROTO_HTTP:
             free_http_msg((http_message *) frame->frame);
             break;
-        // todo: add protocols:
-        case PROTO_HTTP2:
         case PROTO_REDIS:
-        case PROTO_KAFKA:
+            free_redis_msg((struct redis_msg_s *) frame->frame);
+            break;
         case PROTO_MYSQL:
-        case PROTO_MONGO:
+            free_mysql_packet_msg((struct mysql_packet_msg_s *) frame->frame);
+            break;
+        case PROTO_KAFKA:
+            free_kafka_msg((struct kafka_msg_s *) frame->frame);
+            break;
+        case PROTO_HTTP2:
+            free_http2_msg((struct http2_msg_s *) frame->frame);
+            break;
         case PROTO_DNS:
+            free_dns_msg((struct dns_msg_s *) frame->frame);
+            break;
+        // todo: add protocols:
+        case PROTO_MONGO:
         case PROTO_NATS:
         case PROTO_CQL:
         default:
@@ -100,12 +150,22 @@ size_t proto_find_frame_boundary(enum proto_type_t type, enum message_type_t msg
         case PROTO_HTTP:
             ret = http_find_frame_boundary(msg_type, raw_data);
             break;
-        case PROTO_HTTP2:
         case PROTO_REDIS:
-        case PROTO_KAFKA:
+            ret = redis_find_frame_boundary(msg_type, raw_data);
+            break;
         case PROTO_MYSQL:
-        case PROTO_MONGO:
+            ret = mysql_find_frame_boundary(msg_type, raw_data);
+            break;
+        case PROTO_KAFKA:
+            ret = kafka_find_frame_boundary(msg_type, raw_data);
+            break;
+        case PROTO_HTTP2:
+            ret = http2_find_frame_boundary(msg_type, raw_data);
+            break;
         case PROTO_DNS:
+            ret = dns_find_frame_boundary(msg_type, raw_data);
+            break;
+        case PROTO_MONGO:
         case PROTO_NATS:
         case PROTO_CQL:
         default:
@@ -115,7 +175,7 @@ size_t proto_find_frame_boundary(enum proto_type_t type, enum message_type_t msg
 }
 
 parse_state_t proto_parse_frame(enum proto_type_t type, enum message_type_t msg_type, struct raw_data_s *raw_data,
-                                struct frame_data_s **frame_data)
+                                void **proto_ctx, struct frame_data_s **frame_data)
 {
     parse_state_t state = STATE_UNKNOWN;
     switch (type) {
@@ -125,12 +185,22 @@ parse_state_t proto_parse_frame(enum proto_type_t type, enum message_type_t msg_
         case PROTO_HTTP:
             state = http_parse_frame(msg_type, raw_data, frame_data);
             break;
-        case PROTO_HTTP2:
         case PROTO_REDIS:
-        case PROTO_KAFKA:
+            state = redis_parse_frame(msg_type, raw_data, frame_data);
+            break;
         case PROTO_MYSQL:
-        case PROTO_MONGO:
+            state = mysql_parse_frame(msg_type, raw_data, frame_data);
+            break;
+        case PROTO_KAFKA:
+            state = kafka_parse_frame(msg_type, raw_data, frame_data);
+            break;
+        case PROTO_HTTP2:
+            state = http2_parse_frame(msg_type, raw_data, (struct http2_conn_ctx_s **) proto_ctx, frame_data);
+            break;
         case PROTO_DNS:
+            state = dns_parse_frame(msg_type, raw_data, frame_data);
+            break;
+        case PROTO_MONGO:
         case PROTO_NATS:
         case PROTO_CQL:
         default:
@@ -149,12 +219,22 @@ void proto_match_frames(enum proto_type_t type, struct frame_buf_s *req_frame, s
         case PROTO_HTTP:
             http_match_frames(req_frame, resp_frame, record_buf);
             break;
-        case PROTO_HTTP2:
         case PROTO_REDIS:
-        case PROTO_KAFKA:
+            redis_match_frames(req_frame, resp_frame, record_buf);
+            break;
         case PROTO_MYSQL:
-        case PROTO_MONGO:
+            mysql_match_frames(req_frame, resp_frame, record_buf);
+            break;
+        case PROTO_KAFKA:
+            kafka_match_frames(req_frame, resp_frame, record_buf);
+            break;
+        case PROTO_HTTP2:
+            http2_match_frames(req_frame, resp_frame, record_buf);
+            break;
         case PROTO_DNS:
+            dns_match_frames(req_frame, resp_frame, record_buf);
+            break;
+        case PROTO_MONGO:
         case PROTO_NATS:
         case PROTO_CQL:
         default:
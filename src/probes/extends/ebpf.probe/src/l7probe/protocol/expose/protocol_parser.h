@@ -35,6 +35,14 @@ void free_record_data(enum proto_type_t type, struct record_data_s *record_data)
  */
 void free_frame_data_s(enum proto_type_t type, struct frame_data_s *frame);
 
+/**
+ * Free parse state of stateful protocols
+ *
+ * @param type protocol type
+ * @param proto_ctx data_stream_s.proto_ctx
+ */
+void free_proto_ctx(enum proto_type_t type, void *proto_ctx);
+
 /**
  * Find frame boundary for protocols
  *
@@ -51,11 +59,12 @@ size_t proto_find_frame_boundary(enum proto_type_t type, enum message_type_t msg
  * @param type protocol type
  * @param msg_type message type
  * @param raw_data raw data
+ * @param proto_ctx parse state of the data stream, created by the parser of stateful protocols
  * @param frame_data frame data
  * @return
  */
 parse_state_t proto_parse_frame(enum proto_type_t type, enum message_type_t msg_type, struct raw_data_s *raw_data,
-                                struct frame_data_s **frame_data);
+                                void **proto_ctx, struct frame_data_s **frame_data);
 
 /**
  * Match req & resp frames into record for protocols
@@ -24,9 +24,12 @@ static void add_http_record_into_buf(http_record *record, struct record_buf_s *r
     }
     record_data->record = record;
     record_data->latency = record->resp->timestamp_ns - record->req->timestamp_ns;
+    record_data->api[0] = 0;
+    record_data->is_err = 0;
 
     // 计数错误个数，大于等于400均为错误，4xx为客户端错误，5xx为服务端错误
     if (record->resp->resp_status >= 400) {
+        record_data->is_err = 1;
         ++record_buf->err_count;
     }
     record_buf->records[record_buf->record_buf_size] = record_data;
@@ -0,0 +1,152 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: eank
+ * Create: 2023/7/20
+ * Description: Flat, allocation-free HTTP1.x headers
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include "http_headers.h"
+
+#define LOWER_CASE_MASK_8 0x2020202020202020ULL
+#define LOWER_CASE_MASK_1 0x20
+
+struct known_header_name_s {
+    const char *lower_name;
+    size_t len;
+};
+
+#define KNOWN_HEADER_NAME(s) {s, sizeof(s) - 1}
+
+static const struct known_header_name_s known_header_names[__MAX_HTTP_KNOWN_HEADER] = {
+    [HTTP_HEADER_CONTENT_LENGTH] = KNOWN_HEADER_NAME("content-length"),
+    [HTTP_HEADER_TRANSFER_ENCODING] = KNOWN_HEADER_NAME("transfer-encoding"),
+    [HTTP_HEADER_CONTENT_TYPE] = KNOWN_HEADER_NAME("content-type"),
+    [HTTP_HEADER_CONTENT_ENCODING] = KNOWN_HEADER_NAME("content-encoding"),
+    [HTTP_HEADER_UPGRADE] = KNOWN_HEADER_NAME("upgrade"),
+};
+
+void init_http_headers(http_headers *headers)
+{
+    headers->num_headers = 0;
+    for (int i = 0; i < __MAX_HTTP_KNOWN_HEADER; i++) {
+        headers->known_idx[i] = -1;
+    }
+}
+
+// 按8字节一组比较（SWAR）。lower_name仅包含[a-z0-9-]，这些字符的0x20位均为1，
+// 因此对name或上0x20即可完成大小写无关比较；token中不会出现与之冲突的控制字符。
+bool http_header_name_equal(const char *name, size_t name_len, const char *lower_name, size_t lower_name_len)
+{
+    size_t i = 0;
+
+    if (name == NULL || name_len != lower_name_len) {
+        return false;
+    }
+
+    for (; i + sizeof(uint64_t) <= name_len; i += sizeof(uint64_t)) {
+        uint64_t a, b;
+        memcpy(&a, name + i, sizeof(uint64_t));
+        memcpy(&b, lower_name + i, sizeof(uint64_t));
+        if ((a | LOWER_CASE_MASK_8) != b) {
+            return false;
+        }
+    }
+    for (; i < name_len; i++) {
+        if (((unsigned char)name[i] | LOWER_CASE_MASK_1) != (unsigned char)lower_name[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void http_headers_index_known(http_headers *headers, size_t idx)
+{
+    const http_header *header = &headers->headers[idx];
+
+    for (int i = 0; i < __MAX_HTTP_KNOWN_HEADER; i++) {
+        if (headers->known_idx[i] != -1) {
+            continue;
+        }
+        if (http_header_name_equal(header->name, header->name_len, known_header_names[i].lower_name,
+                                   known_header_names[i].len)) {
+            headers->known_idx[i] = (int)idx;
+            return;
+        }
+    }
+}
+
+const http_header *http_headers_get_known(const http_headers *headers, enum http_known_header_t known)
+{
+    int idx;
+
+    if (known >= __MAX_HTTP_KNOWN_HEADER) {
+        return NULL;
+    }
+    idx = headers->known_idx[known];
+    if (idx < 0 || idx >= headers->num_headers) {
+        return NULL;
+    }
+    return &headers->headers[idx];
+}
+
+const http_header *http_headers_get(const http_headers *headers, const char *lower_name)
+{
+    size_t len = strlen(lower_name);
+
+    for (size_t i = 0; i < headers->num_headers && i < HTTP_MAX_NUM_HEADERS; i++) {
+        if (http_header_name_equal(headers->headers[i].name, headers->headers[i].name_len, lower_name, len)) {
+            return &headers->headers[i];
+        }
+    }
+    return NULL;
+}
+
+bool http_header_value_equal(const http_header *header, const char *lower_value)
+{
+    size_t len = strlen(lower_value);
+
+    if (header == NULL || header->value_len != len) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)header->value[i];
+        if (c >= 'A' && c <= 'Z') {
+            c |= LOWER_CASE_MASK_1;
+        }
+        if (c != (unsigned char)lower_value[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool http_header_value_to_size(const http_header *header, size_t *num)
+{
+    size_t res = 0;
+
+    if (header == NULL || header->value_len == 0) {
+        return false;
+    }
+    for (size_t i = 0; i < header->value_len; i++) {
+        char c = header->value[i];
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        if (res > (SIZE_MAX - (c - '0')) / 10) {
+            return false;
+        }
+        res = res * 10 + (c - '0');
+    }
+    *num = res;
+    return true;
+}
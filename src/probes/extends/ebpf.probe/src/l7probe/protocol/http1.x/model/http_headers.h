@@ -0,0 +1,117 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: eank
+ * Create: 2023/7/20
+ * Description: Flat, allocation-free HTTP1.x headers
+ ******************************************************************************/
+#ifndef __HTTP_HEADERS_H__
+#define __HTTP_HEADERS_H__
+
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define HTTP_MAX_NUM_HEADERS 50
+
+/**
+ * HTTP header
+ * name/value are slices of raw_data, they are only valid while the raw_data is alive.
+ */
+typedef struct http_header_t {
+    const char *name;
+    size_t name_len;
+    const char *value;
+    size_t value_len;
+} http_header;
+
+/**
+ * Headers consulted by the parser, their indexes are recorded while parsing.
+ */
+enum http_known_header_t {
+    HTTP_HEADER_CONTENT_LENGTH = 0,
+    HTTP_HEADER_TRANSFER_ENCODING,
+    HTTP_HEADER_CONTENT_TYPE,
+    HTTP_HEADER_CONTENT_ENCODING,
+    HTTP_HEADER_UPGRADE,
+
+    __MAX_HTTP_KNOWN_HEADER
+};
+
+/**
+ * HTTP headers, fixed capacity and no allocation.
+ * known_idx[] holds the index of the 1st occurrence of each known header in headers[], -1 if absent.
+ */
+typedef struct http_headers_s {
+    http_header headers[HTTP_MAX_NUM_HEADERS];
+    size_t num_headers;
+    int known_idx[__MAX_HTTP_KNOWN_HEADER];
+} http_headers;
+
+void init_http_headers(http_headers *headers);
+
+/**
+ * Case-insensitive compare of a header name with a lower case name.
+ * lower_name must consist of [a-z0-9-] only.
+ *
+ * @param name
+ * @param name_len
+ * @param lower_name
+ * @param lower_name_len
+ * @return
+ */
+bool http_header_name_equal(const char *name, size_t name_len, const char *lower_name, size_t lower_name_len);
+
+/**
+ * Record headers[idx] into known_idx[] if it is a known header.
+ *
+ * @param headers
+ * @param idx
+ */
+void http_headers_index_known(http_headers *headers, size_t idx);
+
+/**
+ * get 1st known header
+ *
+ * @param headers
+ * @param known
+ * @return NULL if absent
+ */
+const http_header *http_headers_get_known(const http_headers *headers, enum http_known_header_t known);
+
+/**
+ * get 1st header by lower case name
+ *
+ * @param headers
+ * @param lower_name
+ * @return NULL if absent
+ */
+const http_header *http_headers_get(const http_headers *headers, const char *lower_name);
+
+/**
+ * Case-insensitive compare of a header value with a lower case token, eg. "chunked".
+ *
+ * @param header
+ * @param lower_value
+ * @return
+ */
+bool http_header_value_equal(const http_header *header, const char *lower_value);
+
+/**
+ * parse a header value as a non-negative decimal number, eg. Content-Length
+ *
+ * @param header
+ * @param num
+ * @return false if the value is empty, not all digits or overflows
+ */
+bool http_header_value_to_size(const http_header *header, size_t *num);
+
+#endif // __HTTP_HEADERS_H__
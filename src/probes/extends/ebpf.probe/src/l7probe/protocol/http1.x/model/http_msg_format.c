@@ -16,12 +16,6 @@
 #include <stdlib.h>
 #include "http_msg_format.h"
 
-const char kContentEncoding[17] = "Content-Encoding";
-const char kContentLength[15] = "Content-Length";
-const char kContentType[13] = "Content-Type";
-const char kTransferEncoding[18] = "Transfer-Encoding";
-const char kUpgrade[8] = "Upgrade";
-
 http_message *init_http_msg(void)
 {
     http_message *http_msg = (http_message *) malloc(sizeof(struct http_message));
@@ -31,9 +25,13 @@ http_message *init_http_msg(void)
     http_msg->type = MESSAGE_UNKNOW;
     http_msg->timestamp_ns = 0;
     http_msg->minor_version = -1;
-    http_msg->headers = init_http_headers_map();
+    http_msg->req_method = NULL;
+    http_msg->req_path = NULL;
     http_msg->resp_status = -1;
+    http_msg->resp_message = NULL;
+    http_msg->body = NULL;
     http_msg->body_size = 0;
+    http_msg->headers_byte_size = 0;
 
     return http_msg;
 }
@@ -43,9 +41,6 @@ void free_http_msg(http_message *http_msg)
     if (http_msg == NULL) {
         return;
     }
-    if (http_msg->headers != NULL) {
-        free_http_headers_map(http_msg->headers);
-    }
     if (http_msg->req_method != NULL) {
         free(http_msg->req_method);
     }
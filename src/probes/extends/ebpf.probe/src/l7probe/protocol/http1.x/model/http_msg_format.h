@@ -17,15 +17,11 @@
 
 #pragma once
 
-#include "multiple_map.h"
+#include <stdint.h>
+#include "http_headers.h"
+#include "../util/string_utils.h"
 #include "../../../include/data_stream.h"
 
-extern const char kContentEncoding[17];
-extern const char kContentLength[15];
-extern const char kContentType[13];
-extern const char kTransferEncoding[18];
-extern const char kUpgrade[8];
-
 /**
  * Http message structure, req or resp use the same
  */
@@ -34,7 +30,6 @@ typedef struct http_message {
     uint64_t timestamp_ns;
 
     int minor_version;
-    http_headers_map *headers;
 
     char *req_method;
     char *req_path;
@@ -14,8 +14,7 @@
  ******************************************************************************/
 
 #include "http_parse_wrapper.h"
-
-#define K_MAX_NUM_HEADERS 50
+#include "../../utils/char_scan.h"
 
 #ifdef _MSC_VER
 #define ALIGNED(n) _declspec(align(n))
@@ -98,42 +97,11 @@ static const char *token_char_map = "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\
                                     "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0"
                                     "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0";
 
-// 快速找到字符
-static const char *find_char_fast(const char *buf, const char *buf_end, const char *ranges, size_t ranges_size, int *found)
-{
-    *found = 0;
-#if __SSE4_2__
-    if (buf_end - buf >= 16) {
-        __m128i ranges16 = _mm_loadu_si128((const __m128i *)ranges);
-
-        size_t left = (buf_end - buf) & ~15;
-        do {
-            __m128i b16 = _mm_loadu_si128((const __m128i *)buf);
-            int r = _mm_cmpestri(ranges16, ranges_size, b16, 16, _SIDD_LEAST_SIGNIFICANT | _SIDD_CMP_RANGES | _SIDD_UBYTE_OPS);
-            if (r != 16) {
-                buf += r;
-                *found = 1;
-                break;
-            }
-            buf += 16;
-            left -= 16;
-        } while (left != 0);
-    }
-#else
-    /* suppress unused parameter warning */
-    (void)buf_end;
-    (void)ranges;
-    (void)ranges_size;
-#endif
-    return buf;
-}
-
 // 解析到行末，eol：end of line，用于解析header.value和response.Reason-Phrase时使用
 static const char *get_token_to_eol(const char *buf, const char *buf_end, const char **token, size_t *token_len, size_t *ret)
 {
     const char *token_start = buf;
 
-#ifdef __SSE4_2__
     static const char ALIGNED(16) ranges1[16] = "\0\010"    /* allow HT */
                                                 "\012\037"  /* allow SP and up to but not including DEL */
                                                 "\177\177"; /* allow chars w. MSB set */
@@ -141,7 +109,8 @@ static const char *get_token_to_eol(const char *buf, const char *buf_end, const
     buf = find_char_fast(buf, buf_end, ranges1, 6, &found);
     if (found)
         goto FOUND_CTL;
-#else
+
+    /* 向量实现只处理完整的向量块，剩余部分（或无SIMD时的全部数据）按8字节展开逐字节检查 */
     /* find non-printable char within the next 8 bytes, this is the hottest code; manually inlined */
     while (buf_end - buf >= 8) {
 #define DOIT()                                                                                                                     \
@@ -166,7 +135,6 @@ static const char *get_token_to_eol(const char *buf, const char *buf_end, const
         }
         ++buf;
     }
-#endif
     for (;; ++buf) {
         CHECK_EOF()
         if (!IS_PRINTABLE_ASCII(*buf)) {
@@ -256,11 +224,13 @@ static const char *parse_http_version(const char *buf, const char *buf_end, int
 // 解析请求头，格式:
 // field-name | : | [field-value] | CRLF
 // field-name | : | [field-value] | CRLF
-static const char *parse_headers(const char *buf, const char *buf_end, http_header *headers, size_t *num_headers,
-                                 size_t *ret)
+static const char *parse_headers(const char *buf, const char *buf_end, http_headers *http_hdrs, size_t *ret)
 {
+    http_header *headers = http_hdrs->headers;
+    size_t *num_headers = &http_hdrs->num_headers;
+
     // 循环解析每个header
-    const size_t max_headers = K_MAX_NUM_HEADERS;
+    const size_t max_headers = HTTP_MAX_NUM_HEADERS;
     for (;; ++*num_headers) {
         // 检查是否循环到了buf末尾
         CHECK_EOF()
@@ -290,6 +260,8 @@ static const char *parse_headers(const char *buf, const char *buf_end, http_head
                 *ret = -1;
                 return NULL;
             }
+            // 记录需要使用的头部（Content-Length等）下标，后续按下标直接取值
+            http_headers_index_known(http_hdrs, *num_headers);
             ++buf;
             for (;; ++buf) {
                 CHECK_EOF()
@@ -382,7 +354,7 @@ static const char *parse_request_line(const char *buf, const char *buf_end, http
     }
 
     // 解析请求行
-    return parse_headers(buf, buf_end, req->headers, &req->num_headers, ret);
+    return parse_headers(buf, buf_end, &req->headers, ret);
 }
 
 // 解析响应行，格式：Http-Version | SP | Status-Code | SP | Reason-Phrase | CRLF
@@ -422,7 +394,7 @@ static const char *parse_response_line(const char *buf, const char *buf_end, htt
     // msg为空时（即msg_len为0时）为正确场景，直接下一步解析响应头
     if (resp->msg_len == 0) {
         // 解析响应行
-        return parse_headers(buf, buf_end, resp->headers, &resp->num_headers, ret);
+        return parse_headers(buf, buf_end, &resp->headers, ret);
     }
 
     // msg首字符为空格时，去除开头的所有空格
@@ -433,7 +405,7 @@ static const char *parse_response_line(const char *buf, const char *buf_end, htt
         } while (*resp->msg == ' ');
 
         // 解析响应头
-        return parse_headers(buf, buf_end, resp->headers, &resp->num_headers, ret);
+        return parse_headers(buf, buf_end, &resp->headers, ret);
     }
 
     // 如果不为以上两种情况，解析错误，返回-1
@@ -471,93 +443,23 @@ size_t http_parse_response_headers(struct raw_data_s *raw_data, http_response *r
     return (int)(buf - buf_start);
 }
 
-http_headers_map *get_http_headers_map(http_header *headers, size_t num_headers)
+void init_http_request(http_request *req)
 {
-    http_headers_map *headers_map = init_http_headers_map();
-    for (size_t i = 0; i < num_headers; i++) {
-        char *name = "", *value = "";
-        strcpy(name, headers[i].name);
-        strcpy(value, headers[i].value);
-        insert_into_multiple_map(headers_map, name, value);
-    }
-    return headers_map;
-}
-
-http_header *init_http_header()
-{
-    http_header *header = (http_header *) malloc(sizeof(http_header));
-    if (header == NULL) {
-        ERROR("[Http Parse] Failed to malloc http_header.");
-        return NULL;
-    }
-    header->name = "";
-    header->name_len = 0;
-    header->value = "";
-    header->value_len = 0;
-    return header;
-}
-
-void free_http_header(http_header *header)
-{
-    if (header == NULL) {
-        return;
-    }
-    free(header);
-}
-
-http_request *init_http_request(void)
-{
-    http_request *req = (http_request *) malloc(sizeof(http_request));
-    if (req == NULL) {
-        ERROR("[HTTP PARSER] Failed to malloc http_request.");
-        return NULL;
-    }
     req->method = "";
     req->method_len = 0;
     req->path = "";
     req->path_len = 0;
     req->minor_version = -1;
-    req->num_headers = 0;
-    req->headers = init_http_header();
-    return req;
+    init_http_headers(&req->headers);
 }
 
-void free_http_request(http_request *req)
+void init_http_response(http_response *resp)
 {
-    if (req == NULL) {
-        return;
-    }
-    if (req->headers != NULL) {
-        free_http_header(req->headers);
-    }
-    free(req);
-}
-
-http_response *init_http_response(void)
-{
-    http_response *resp = (http_response *) malloc(sizeof(http_response));
-    if (resp == NULL) {
-        ERROR("[HTTP1.x PARSER] Failed to malloc http_response.");
-        return NULL;
-    }
     resp->minor_version = -1;
     resp->status = 0;
     resp->msg = NULL;
     resp->msg_len = 0;
-    resp->num_headers = 0;
-    resp->headers = init_http_header();
-    return resp;
-}
-
-void free_http_response(http_response *resp)
-{
-    if (resp == NULL) {
-        return;
-    }
-    if (resp->headers != NULL) {
-        free_http_header(resp->headers);
-    }
-    free(resp);
+    init_http_headers(&resp->headers);
 }
 
 #undef CHECK_EOF
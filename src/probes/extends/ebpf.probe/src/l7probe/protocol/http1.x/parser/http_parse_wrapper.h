@@ -17,22 +17,9 @@
 
 #include "../model/http_msg_format.h"
 
-/**
- * HTTP header
- */
-typedef struct http_header_t {
-    const char *name;
-    size_t name_len;
-    const char *value;
-    size_t value_len;
-} http_header;
-
-http_header *init_http_header();
-
-void free_http_header(http_header *header);
-
 /**
  * HTTP Request
+ * method/path/headers are slices of raw_data, they are only valid while the raw_data is alive.
  */
 typedef struct http_request {
     const char *method;
@@ -40,29 +27,24 @@ typedef struct http_request {
     const char *path;
     size_t path_len;
     int minor_version;
-    http_header *headers;
-    size_t num_headers;
+    http_headers headers;
 } http_request;
 
-http_request *init_http_request(void);
-
-void free_http_request(http_request *req);
+void init_http_request(http_request *req);
 
 /**
  * HTTP Response
+ * msg/headers are slices of raw_data, they are only valid while the raw_data is alive.
  */
 typedef struct http_response {
     const char* msg;
     size_t msg_len;
     int status;
     int minor_version;
-    http_header *headers;
-    size_t num_headers;
+    http_headers headers;
 } http_response;
 
-http_response *init_http_response(void);
-
-void free_http_response(http_response *resp);
+void init_http_response(http_response *resp);
 
 /**
  * Parse http request header
@@ -82,13 +64,4 @@ size_t http_parse_request_headers(struct raw_data_s *raw_data, http_request* req
  */
 size_t http_parse_response_headers(struct raw_data_s *raw_data, http_response* resp);
 
-/**
- * parse http headers from req.headers into http_headers_map
- *
- * @param headers
- * @param num_headers
- * @return
- */
-http_headers_map *get_http_headers_map(http_header *headers, size_t num_headers);
-
 #endif // __HTTP_PARSE_WRAPPER_H__
\ No newline at end of file
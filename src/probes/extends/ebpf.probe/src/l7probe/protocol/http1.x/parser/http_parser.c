@@ -14,12 +14,42 @@
  ******************************************************************************/
 
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include "http_parser.h"
 #include "../../utils/macros.h"
 #include "http_parse_wrapper.h"
 
+static int parse_hex_len(const char *start, const char *end, size_t *len)
+{
+    size_t val = 0;
+    const char *p = start;
+
+    for (; p < end && *p != ';'; p++) {
+        char c = *p;
+        if (c >= '0' && c <= '9') {
+            val = (val << 4) | (size_t)(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            val = (val << 4) | (size_t)(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            val = (val << 4) | (size_t)(c - 'A' + 10);
+        } else if (c == ' ' || c == '\t') {
+            continue;
+        } else {
+            return -1;
+        }
+        if (val > (size_t)UINT32_MAX) {
+            return -1;
+        }
+    }
+    if (p == start) {
+        return -1;
+    }
+    *len = val;
+    return 0;
+}
+
 /**
  * parse chunked data and data length
  *
@@ -30,63 +60,58 @@
  */
 static enum parse_state_t parse_chunked(struct raw_data_s *raw_data, size_t *offset, char **body)
 {
-    const int search_window = 2048;
+    const size_t search_window = 2048;
     const size_t delimiter_len = 2;
-    char *data = raw_data->data + raw_data->current_pos;
-    size_t data_len = raw_data->data_len - raw_data->current_pos;
+    const char *data = raw_data->data + raw_data->current_pos;
+    const char *data_end = raw_data->data + raw_data->data_len;
     size_t total_size = 0;
-    while(true) {
-        size_t chunked_len = 0;
 
-        size_t deli_pos = find_str(substr(data, 0,search_window), "\r\n", 0);
-        if (deli_pos == data_len) {
-            return data_len > search_window ? STATE_INVALID : STATE_NEEDS_MORE_DATA;
-        }
+    while (true) {
+        size_t chunked_len = 0;
+        size_t window = (size_t)(data_end - data);
+        const char *deli;
 
         // chunked数据每个分片都在开头设置分片数据长度，用";"和数据隔开
-        // 格式： chunked_data_len ; extension | \r\n | data
-        char *chunked_str_len = substr(data, 0, deli_pos);
-        size_t chunked_ext_pos = find_str(chunked_str_len, ";", 0);
-        if (chunked_ext_pos != strlen(chunked_str_len) -1) {
-            chunked_str_len = substr(chunked_str_len, 0, chunked_ext_pos);
+        // 格式： chunked_data_len ; extension | \r\n | data | \r\n
+        window = (window > search_window) ? search_window : window;
+        deli = memchr(data, '\r', window);
+        while (deli != NULL && deli + 1 < data + window && deli[1] != '\n') {
+            deli = memchr(deli + 1, '\r', (size_t)(data + window - deli - 1));
         }
+        if (deli == NULL || deli + 1 >= data + window) {
+            return (size_t)(data_end - data) > search_window ? STATE_INVALID : STATE_NEEDS_MORE_DATA;
+        }
+        if (parse_hex_len(data, deli, &chunked_len)) {
+            return STATE_INVALID;
+        }
+        data = deli + delimiter_len;
 
-        chunked_len = simple_hex_atoi(chunked_str_len);
-
-        // 指针偏移deli_pos + delimiter_len
-        data += deli_pos + delimiter_len;
-
-//        total_size += chunked_len;
+        // last-chunk，trailer暂不支持，仅跳过结尾的\r\n
         if (chunked_len == 0) {
+            if ((size_t)(data_end - data) < delimiter_len) {
+                return STATE_NEEDS_MORE_DATA;
+            }
+            if (data[0] != '\r' || data[1] != '\n') {
+                return STATE_INVALID;
+            }
+            data += delimiter_len;
             break;
         }
 
-        // todo: parse chunked data, not support for now
-        char *chunked_data;
-        if (strlen(data) < chunked_len + delimiter_len) {
+        // note: 暂不解析chunk内容，仅偏移指针并计算总长度
+        if ((size_t)(data_end - data) < chunked_len + delimiter_len) {
             return STATE_NEEDS_MORE_DATA;
         }
-        chunked_data = substr(data, 0, chunked_len);
-        data += chunked_len;
-        if (data[0] != '\r' || data[1] != '\n') {
+        if (data[chunked_len] != '\r' || data[chunked_len + 1] != '\n') {
             return STATE_INVALID;
         }
-        data += delimiter_len;
-
-        // 仅偏移chunk_data长度的指针
         data += chunked_len + delimiter_len;
-
-        // 计算总长度
-        total_size += strlen(chunked_data);
+        total_size += chunked_len;
     }
 
-    raw_data->current_pos += data + raw_data->current_pos - raw_data->data;
-
-    // todo: note: 暂不计算body
-//    *body = data;
-
+    raw_data->current_pos = (size_t)(data - raw_data->data);
     *offset = total_size;
-    return STATE_UNKNOWN;
+    return STATE_SUCCESS;
 }
 
 /**
@@ -100,15 +125,16 @@ static enum parse_state_t parse_chunked(struct raw_data_s *raw_data, size_t *off
  * @param frame_data
  * @return
  */
-static parse_state_t parse_request_body(struct raw_data_s *raw_data, struct http_message *frame_data)
+static parse_state_t parse_request_body(struct raw_data_s *raw_data, const http_headers *headers,
+                                        struct http_message *frame_data)
 {
     size_t offset = 0;
 
     // 1. Content-Length
-    char *content_len_str = get_1st_value_by_key(frame_data->headers, kContentLength);
-    if (content_len_str != NULL) {
-        size_t content_len = atoi(content_len_str);
-        if (strcmp(content_len_str, "0") != 1 && content_len == 0) {
+    const http_header *content_len_hdr = http_headers_get_known(headers, HTTP_HEADER_CONTENT_LENGTH);
+    if (content_len_hdr != NULL) {
+        size_t content_len;
+        if (!http_header_value_to_size(content_len_hdr, &content_len)) {
             ERROR("[HTTP PARSER] Failed to parse content-Length.");
             return STATE_INVALID;
         }
@@ -116,29 +142,27 @@ static parse_state_t parse_request_body(struct raw_data_s *raw_data, struct http
             WARN("[HTTP PARSE] Parsing request body needs more data.");
             return STATE_NEEDS_MORE_DATA;
         }
-        frame_data->body = substr(raw_data->data, raw_data->current_pos, raw_data->current_pos + content_len);
+        // note: 暂不需要解析body内容，仅拿到body长度即可
         frame_data->body_size = content_len;
+        raw_data->current_pos += content_len;
         return STATE_SUCCESS;
     }
 
     // 2. Transfer-Encoding: Chunked
-    char *transfer_encoding = get_1st_value_by_key(frame_data->headers, kTransferEncoding);
-    if (transfer_encoding != NULL && strcmp(transfer_encoding, "chunked")) {
-        char **body;
-        enum parse_state_t state = parse_chunked(raw_data, &offset, body);
+    const http_header *transfer_encoding = http_headers_get_known(headers, HTTP_HEADER_TRANSFER_ENCODING);
+    if (http_header_value_equal(transfer_encoding, "chunked")) {
+        char *body = NULL;
+        enum parse_state_t state = parse_chunked(raw_data, &offset, &body);
 
         // todo: 暂不需要解析body内容，仅拿到body长度即可
-//        frame_data->body = substr(raw_data->data, raw_data->current_pos, raw_data->current_pos + content_len);
-        frame_data->body = *body;
+        frame_data->body = body;
         frame_data->body_size = offset;
         return state;
     }
 
     // 3. 无Content-Length和Transfer-Encoding，即无请求body，直接返回successful即可
-    frame_data->body = "";
     frame_data->body_size = 0;
-    raw_data->current_pos += offset;
-    return STATE_UNKNOWN;
+    return STATE_SUCCESS;
 }
 
 /**
@@ -154,27 +178,29 @@ static parse_state_t parse_request_body(struct raw_data_s *raw_data, struct http
  * @param frame_data
  * @return
  */
-static parse_state_t parse_response_body(struct raw_data_s *raw_data, struct http_message *frame_data)
+static parse_state_t parse_response_body(struct raw_data_s *raw_data, const http_headers *headers,
+                                         struct http_message *frame_data)
 {
     size_t offset = 0;
     char *buf = raw_data->data + raw_data->current_pos;
 
     // 1. HEAD请求的响应，前面已经解析完响应头，此处是新的响应的开始，以协议号开头。此处预解析新的响应，不发生指针偏移
-    if (frame_data->type == MESSAGE_RESPONSE && starts_with(buf, "HTTP") == 1) {
-        http_response *resp;
-        size_t next_resp_header_offset = http_parse_response_headers(raw_data, resp);
+    if (frame_data->type == MESSAGE_RESPONSE && raw_data->data_len - raw_data->current_pos >= 4 &&
+        memcmp(buf, "HTTP", 4) == 0) {
+        http_response next_resp;
+        init_http_response(&next_resp);
+        size_t next_resp_header_offset = http_parse_response_headers(raw_data, &next_resp);
         if (next_resp_header_offset > 0) {
-            frame_data->body = "";
             frame_data->body_size = 0;
             return STATE_SUCCESS;
         }
     }
 
     // 2. 有Content-Length
-    char *content_len_str = get_1st_value_by_key(frame_data->headers, kContentLength);
-    if (content_len_str != NULL) {
-        size_t content_len = atoi(content_len_str);
-        if (strcmp(content_len_str, "0") != 1 && content_len == 0) {
+    const http_header *content_len_hdr = http_headers_get_known(headers, HTTP_HEADER_CONTENT_LENGTH);
+    if (content_len_hdr != NULL) {
+        size_t content_len;
+        if (!http_header_value_to_size(content_len_hdr, &content_len)) {
             ERROR("[HTTP PARSER] Failed to parse content-Length.");
             return STATE_INVALID;
         }
@@ -182,19 +208,20 @@ static parse_state_t parse_response_body(struct raw_data_s *raw_data, struct htt
             WARN("[HTTP PARSE] Parsing request body needs more data.");
             return STATE_NEEDS_MORE_DATA;
         }
-        frame_data->body = substr(raw_data->data, raw_data->current_pos, raw_data->current_pos + content_len);
+        // note: 暂不需要解析body内容，仅拿到body长度即可
         frame_data->body_size = content_len;
+        raw_data->current_pos += content_len;
         return STATE_SUCCESS;
     }
 
     // 3. 有Transfer-Encoding
-    char *transfer_encoding = get_1st_value_by_key(frame_data->headers, kTransferEncoding);
-    if (transfer_encoding != NULL && strcmp(transfer_encoding, "chunked")) {
-        char **body;
-        enum parse_state_t state = parse_chunked(raw_data, &offset, body);
+    const http_header *transfer_encoding = http_headers_get_known(headers, HTTP_HEADER_TRANSFER_ENCODING);
+    if (http_header_value_equal(transfer_encoding, "chunked")) {
+        char *body = NULL;
+        enum parse_state_t state = parse_chunked(raw_data, &offset, &body);
 
         // note: 暂不需要解析body内容，仅拿到body长度即可
-        frame_data->body = *body;
+        frame_data->body = body;
         frame_data->body_size = offset;
         return state;
     }
@@ -202,12 +229,10 @@ static parse_state_t parse_response_body(struct raw_data_s *raw_data, struct htt
     // 4. 已知的无body情况，状态码在[100, 199], {204, 304} 范围内的。其中101较为特殊，是Upgrade消息，暂不支持；
     if ((frame_data->resp_status >= 100 && frame_data->resp_status < 200) || frame_data->resp_status == 204 ||
         frame_data->resp_status == 304) {
-        frame_data->body = "";
         frame_data->body_size = 0;
 
         if (frame_data->resp_status == 101) {
-            char *upgrade_str = get_1st_value_by_key(frame_data->headers, kUpgrade);
-            if (upgrade_str == NULL) {
+            if (http_headers_get_known(headers, HTTP_HEADER_UPGRADE) == NULL) {
                 WARN("[HTTP PARSER] Expected an Upgrade header with http status code 101.");
             }
             WARN("[HTTP PARSER] Http Upgrades are not supported yet.");
@@ -219,9 +244,6 @@ static parse_state_t parse_response_body(struct raw_data_s *raw_data, struct htt
     // note: 暂不考虑该情况，直接跳过，解析下一帧
     // 5. 无法预知是否有body的，响应头中既没有Content-Length也没有Transfer-Encoding，这种情况应该等待连接断开
     frame_data->body_size = 0;
-    frame_data->body = "";
-
-    raw_data->current_pos += offset;
     return STATE_SUCCESS;
 }
 
@@ -233,40 +255,38 @@ static parse_state_t parse_response_body(struct raw_data_s *raw_data, struct htt
  * @return
  */
 static parse_state_t parse_request_frame(struct raw_data_s *raw_data, http_message *frame_data) {
-    http_request *req = init_http_request();
+    http_request req;
+    init_http_request(&req);
 
     // 解析 request headers
-    size_t offset = http_parse_request_headers(raw_data, req);
+    size_t offset = http_parse_request_headers(raw_data, &req);
 
     // 返回的retval若为-2，则表示部分解析成功，但需要更多数据来完成解析，指针不偏移
-    if (offset == -2) {
+    if (offset == (size_t)-2) {
         INFO("[HTTP1.x PARSER] Parser needs more data.");
         return STATE_NEEDS_MORE_DATA;
     }
 
-    // -1时为解析失败
-    if (offset == -1 || offset < -2) {
+    // -1时为解析失败（offset为size_t，不能用 < -2 判断）
+    if (offset == (size_t)-1) {
         ERROR("[HTTP1.x PARSER] Failed to parse raw_data into request.");
         return STATE_INVALID;
     }
 
-    // offset >= 0 时解析成功，偏移指针
-    raw_data->current_pos = offset;
-
+    // offset >= 0 时解析成功
     // 组装frame
     frame_data->type = MESSAGE_REQUEST;
     frame_data->timestamp_ns = raw_data->timestamp_ns;
-    frame_data->minor_version = req->minor_version;
-    frame_data->headers = get_http_headers_map(req->headers, req->num_headers);
-    strcpy(frame_data->req_method, req->method);
-    strcpy(frame_data->req_path, req->path);
+    frame_data->minor_version = req.minor_version;
+    frame_data->req_method = strndup(req.method, req.method_len);
+    frame_data->req_path = strndup(req.path, req.path_len);
     frame_data->headers_byte_size = offset;
 
     // raw_data指针偏移offset长度
     raw_data->current_pos += offset;
 
     // 解析request body
-    return parse_request_body(raw_data, frame_data);
+    return parse_request_body(raw_data, &req.headers, frame_data);
 }
 
 /**
@@ -278,40 +298,38 @@ static parse_state_t parse_request_frame(struct raw_data_s *raw_data, http_messa
  * @return
  */
 static parse_state_t parse_response_frame(struct raw_data_s *raw_data, struct http_message *frame_data) {
-    http_response *resp = init_http_response();
+    http_response resp;
+    init_http_response(&resp);
 
     // 解析 response header
-    size_t offset = http_parse_response_headers(raw_data, resp);
+    size_t offset = http_parse_response_headers(raw_data, &resp);
 
     // 返回的offset若为-2，则表示部分解析成功，但需要更多数据来完成解析，指针不偏移
-    if (offset == -2) {
+    if (offset == (size_t)-2) {
         INFO("[HTTP1.x PARSER] Parser needs more data.");
         return STATE_NEEDS_MORE_DATA;
     }
 
-    // -1时为解析失败
-    if (offset == -1 || offset < -2) {
+    // -1时为解析失败（offset为size_t，不能用 < -2 判断）
+    if (offset == (size_t)-1) {
         ERROR("[HTTP1.x PARSER] Failed to parse raw_data into response.");
         return STATE_INVALID;
     }
 
-    // offset >= 0 时解析成功，偏移指针
-    raw_data->current_pos = offset;
-
+    // offset >= 0 时解析成功
     // 组装frame
     frame_data->type = MESSAGE_RESPONSE;
     frame_data->timestamp_ns = raw_data->timestamp_ns;
-    frame_data->minor_version = resp->minor_version;
-    frame_data->headers = get_http_headers_map(resp->headers, resp->num_headers);
-    frame_data->resp_status = resp->status;
-    strcpy(frame_data->resp_message, resp->msg);
+    frame_data->minor_version = resp.minor_version;
+    frame_data->resp_status = resp.status;
+    frame_data->resp_message = strndup(resp.msg, resp.msg_len);
     frame_data->headers_byte_size = offset;
 
     // raw_data指针偏移offset长度
     raw_data->current_pos += offset;
 
     // 解析response body
-    return parse_response_body(raw_data, frame_data);
+    return parse_response_body(raw_data, &resp.headers, frame_data);
 }
 
 /**
@@ -324,24 +342,80 @@ static parse_state_t parse_response_frame(struct raw_data_s *raw_data, struct ht
  * @return parse_state
  */
 parse_state_t http_parse_frame(enum message_type_t msg_type, struct raw_data_s *raw_data, struct frame_data_s **frame_data) {
-    http_message *http_msg = init_http_msg();
+    http_message *http_msg;
     parse_state_t state;
-    switch (msg_type) {
-        case MESSAGE_REQUEST:
-            state = parse_request_frame(raw_data, http_msg);
-            (*frame_data)->frame = http_msg;
-            (*frame_data)->msg_type = msg_type;
-            (*frame_data)->timestamp_ns = http_msg->timestamp_ns;
-            return state;
-        case MESSAGE_RESPONSE:
-            state = parse_response_frame(raw_data, http_msg);
-            (*frame_data)->frame = http_msg;
-            (*frame_data)->msg_type = msg_type;
-            (*frame_data)->timestamp_ns = http_msg->timestamp_ns;
-            return state;
-        default:
-            return STATE_INVALID;
+    size_t start_pos = raw_data->current_pos;
+
+    if (msg_type != MESSAGE_REQUEST && msg_type != MESSAGE_RESPONSE) {
+        return STATE_INVALID;
+    }
+
+    http_msg = init_http_msg();
+    if (http_msg == NULL) {
+        ERROR("[HTTP1.x PARSER] Failed to malloc http_msg.\n");
+        return STATE_INVALID;
+    }
+
+    if (msg_type == MESSAGE_REQUEST) {
+        state = parse_request_frame(raw_data, http_msg);
+    } else {
+        state = parse_response_frame(raw_data, http_msg);
+    }
+    if (state != STATE_SUCCESS) {
+        // 未完整解析的帧不消费数据，等待更多数据；非法帧跳过当前起始字符，使rebound从下一个候选位置开始查找
+        raw_data->current_pos = (state == STATE_INVALID) ? start_pos + 1 : start_pos;
+        free_http_msg(http_msg);
+        return state;
+    }
+
+    *frame_data = (struct frame_data_s *) malloc(sizeof(struct frame_data_s));
+    if ((*frame_data) == NULL) {
+        ERROR("[HTTP1.x PARSER] Failed to malloc frame_data.\n");
+        free_http_msg(http_msg);
+        return STATE_INVALID;
+    }
+    (*frame_data)->frame = http_msg;
+    (*frame_data)->msg_type = msg_type;
+    (*frame_data)->timestamp_ns = http_msg->timestamp_ns;
+    return STATE_SUCCESS;
+}
+
+static const char *find_bytes(const char *start, const char *end, const char *pattern, size_t pattern_len)
+{
+    const char *p = start;
+
+    while ((size_t)(end - p) >= pattern_len) {
+        p = memchr(p, pattern[0], (size_t)(end - p) - pattern_len + 1);
+        if (p == NULL) {
+            return NULL;
+        }
+        if (memcmp(p, pattern, pattern_len) == 0) {
+            return p;
+        }
+        p++;
     }
+    return NULL;
+}
+
+static const char *rfind_bytes(const char *start, const char *end, const char *pattern, size_t pattern_len)
+{
+    size_t off;
+
+    if ((size_t)(end - start) < pattern_len) {
+        return NULL;
+    }
+    // Count down an offset, a pointer before start can not even be formed.
+    off = (size_t)(end - start) - pattern_len;
+    while (1) {
+        if (start[off] == pattern[0] && memcmp(start + off, pattern, pattern_len) == 0) {
+            return start + off;
+        }
+        if (off == 0) {
+            break;
+        }
+        off--;
+    }
+    return NULL;
 }
 
 // NOTE: This function should use is_http_{response,request} inside
@@ -350,8 +424,6 @@ parse_state_t http_parse_frame(enum message_type_t msg_type, struct raw_data_s *
 // can actually fail to find any valid boundary by this function. Unfortunately, BPF has many
 // restrictions that likely make this a difficult or impossible goal.
 size_t http_find_frame_boundary(enum message_type_t msg_type, struct raw_data_s *raw_data) {
-    size_t start_pos = raw_data->current_pos;
-
     // List of all HTTP request methods. All HTTP requests start with one of these.
     // https://developer.mozilla.org/en-US/docs/Web/HTTP/Methods
     static const char *HTTP_REQUEST_START_PATTERN_ARRAY[] = {
@@ -363,17 +435,26 @@ size_t http_find_frame_boundary(enum message_type_t msg_type, struct raw_data_s
     static const char *HTTP_RESPONSE_START_PATTERN_ARRAY[] = {"HTTP/1.1 ", "HTTP/1.0 "};
 
     static const char *kBoundaryMarker = "\r\n\r\n";
+    const size_t marker_len = 4;
+
+    const char *data = raw_data->data;
+    const char *start = data + raw_data->current_pos;
+    const char *end = data + raw_data->data_len;
+    const char *search = start;
 
     // Choose the right set of patterns for request or response.
-    const char **start_patterns = {0};
+    const char **start_patterns;
+    size_t patterns_num;
     switch (msg_type) {
         case MESSAGE_REQUEST:
             start_patterns = HTTP_REQUEST_START_PATTERN_ARRAY;
+            patterns_num = sizeof(HTTP_REQUEST_START_PATTERN_ARRAY) / sizeof(HTTP_REQUEST_START_PATTERN_ARRAY[0]);
             break;
         case MESSAGE_RESPONSE:
             start_patterns = HTTP_RESPONSE_START_PATTERN_ARRAY;
+            patterns_num = sizeof(HTTP_RESPONSE_START_PATTERN_ARRAY) / sizeof(HTTP_RESPONSE_START_PATTERN_ARRAY[0]);
             break;
-        case MESSAGE_UNKNOW:
+        default:
             return PARSER_INVALID_BOUNDARY_INDEX;
     }
 
@@ -386,43 +467,35 @@ size_t http_find_frame_boundary(enum message_type_t msg_type, struct raw_data_s
     // 首先查找\r\n\r\n的标记，然后再反过来查找状态行首的协议版本号
     // 不直接查找协议版本号作为帧边界，是因为可能会在req/resp中找到，导致分帧错误
     // 因此先找\r\n\r\n，再回头找最贴近\r\n\r\n的协议号，这样比较准确
+    // 所有查找都限定在raw_data范围内，raw_data不以'\0'结尾
     while (true) {
-        // 1.find the first "\r\n\r\n" sub-string in the raw_data.data
-        size_t marker_pos = find_str(raw_data->data, kBoundaryMarker, raw_data->current_pos);
-
-        // 如果pos数值不正确，返回-1
-        if (marker_pos == -1) {
+        const char *marker = find_bytes(search, end, kBoundaryMarker, marker_len);
+        const char *best = NULL;
+
+        // 头部尚未接收完整时，仅当起始位置恰好是帧起始标志（或其前缀）时返回，等待解析时补齐数据
+        if (marker == NULL) {
+            for (size_t i = 0; i < patterns_num; i++) {
+                size_t len = strlen(start_patterns[i]);
+                len = ((size_t)(end - start) < len) ? (size_t)(end - start) : len;
+                if (len > 0 && memcmp(start, start_patterns[i], len) == 0) {
+                    return raw_data->current_pos;
+                }
+            }
             return PARSER_INVALID_BOUNDARY_INDEX;
         }
 
-        // 2.寻找子字符串: start_pos ~ marker_pos
-        // todo: 待优化，可以不用取子串来算，减少字符串复制操作，优化性能。直接用raw_data来匹配，用current_pos指针来控制遍历范围
-        char *buf_substr = substr(raw_data->data, start_pos, marker_pos - start_pos);
-
-        // 3.匹配start_pos ~ marker_pos之间子串中的start_pattern，取最后一个（最靠近 "\r\n\r\n" 标志的帧边界）
-        size_t substr_pos = -1;
-        for (int i = 0; i < get_array_len(start_patterns) - 1; i++) {
-            const char *start_pattern = start_patterns[i];
-            size_t current_substr_pos = rfind_str(buf_substr, start_pattern);
-            if (current_substr_pos != -1) {
-                // Found a match. Check if it is closer to the marker than our previous match.
-                // We want to return the match that is closest to the marker, so we aren't
-                // matching to something in a previous message's body.
-                size_t max_pos = substr_pos;
-                if (max_pos < current_substr_pos) {
-                    marker_pos = current_substr_pos;
-                }
-                substr_pos = (substr_pos == -1) ? current_substr_pos : max_pos;
+        // 匹配start ~ marker之间的start_pattern，取最后一个（最靠近 "\r\n\r\n" 标志的帧边界）
+        for (size_t i = 0; i < patterns_num; i++) {
+            const char *pos = rfind_bytes(start, marker, start_patterns[i], strlen(start_patterns[i]));
+            if (pos != NULL && (best == NULL || pos > best)) {
+                best = pos;
             }
         }
-
-        // 4.返回帧边界标志匹配到的位置
-        if (substr_pos != -1) {
-            return start_pos + substr_pos;
+        if (best != NULL) {
+            return (size_t)(best - data);
         }
 
-        // 5.找不到帧边界时，将指针移至 "\r\n\r\n" 标志的末尾，进行下一个帧边界的寻找
-        // Couldn't find a start position. Move to the marker, and search for another marker.
-        raw_data->current_pos = marker_pos + strlen(kBoundaryMarker);
+        // 找不到帧边界时，移至 "\r\n\r\n" 标志的末尾，进行下一个帧边界的寻找
+        search = marker + marker_len;
     }
 }
@@ -0,0 +1,422 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-08-22
+ * Description: HPACK header block decoder
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "hpack.h"
+
+#define HPACK_ENTRY_OVERHEAD 32
+#define HPACK_MIN_TABLE_SLOTS 16
+#define HPACK_INT_MAX_SHIFT 28
+#define HPACK_HUFFMAN_MAX_BITS 30
+#define HPACK_HUFFMAN_EOS 256
+
+struct hpack_static_entry_s {
+    const char *name;
+    const char *value;
+};
+
+// RFC 7541 Appendix A
+#define HPACK_STATIC_TABLE_SIZE 61
+static const struct hpack_static_entry_s hpack_static_table[HPACK_STATIC_TABLE_SIZE] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""}
+};
+
+/*
+ * RFC 7541 Appendix B is a canonical Huffman code, it is described by the number of codes of each length and
+ * the symbols sorted by (code length, symbol). EOS is the last code of length 30.
+ */
+static const uint16_t hpack_huffman_count[HPACK_HUFFMAN_MAX_BITS + 1] = {
+    0, 0, 0, 0, 0, 10, 26, 32, 6, 0, 5, 3, 2, 6, 2, 3, 0, 0, 0, 3, 8, 13, 26, 29, 12, 4, 15, 19, 29, 0, 4
+};
+
+static const uint8_t hpack_huffman_symbol[HPACK_HUFFMAN_EOS] = {
+    48, 49, 50, 97, 99, 101, 105, 111, 115, 116, 32, 37, 45, 46, 47, 51,
+    52, 53, 54, 55, 56, 57, 61, 65, 95, 98, 100, 102, 103, 104, 108, 109,
+    110, 112, 114, 117, 58, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76,
+    77, 78, 79, 80, 81, 82, 83, 84, 85, 86, 87, 89, 106, 107, 113, 118,
+    119, 120, 121, 122, 38, 42, 44, 59, 88, 90, 33, 34, 40, 41, 63, 39,
+    43, 124, 35, 62, 0, 36, 64, 91, 93, 126, 94, 125, 60, 96, 123, 92,
+    195, 208, 128, 130, 131, 162, 184, 194, 224, 226, 153, 161, 167, 172, 176, 177,
+    179, 209, 216, 217, 227, 229, 230, 129, 132, 133, 134, 136, 146, 154, 156, 160,
+    163, 164, 169, 170, 173, 178, 181, 185, 186, 187, 189, 190, 196, 198, 228, 232,
+    233, 1, 135, 137, 138, 139, 140, 141, 143, 147, 149, 150, 151, 152, 155, 157,
+    158, 165, 166, 168, 174, 175, 180, 182, 183, 188, 191, 197, 231, 239, 9, 142,
+    144, 145, 148, 159, 171, 206, 215, 225, 236, 237, 199, 207, 234, 235, 192, 193,
+    200, 201, 202, 205, 210, 213, 218, 219, 238, 240, 242, 243, 255, 203, 204, 211,
+    212, 214, 221, 222, 223, 241, 244, 245, 246, 247, 248, 250, 251, 252, 253, 254,
+    2, 3, 4, 5, 6, 7, 8, 11, 12, 14, 15, 16, 17, 18, 19, 20,
+    21, 23, 24, 25, 26, 27, 28, 29, 30, 31, 127, 220, 249, 10, 13, 22
+};
+
+// Decoded string, points into the header block or the scratch buffer.
+struct hpack_str_s {
+    const char *str;
+    size_t len;
+};
+
+static int hpack_huffman_decode(const uint8_t *src, size_t len, char *dst, size_t dst_size, size_t *dst_len)
+{
+    uint32_t code = 0;
+    uint32_t first = 0;
+    uint32_t index = 0;
+    uint32_t bits = 0;
+    uint32_t count;
+    size_t n = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        for (int b = 7; b >= 0; b--) {
+            code = (code << 1) | ((src[i] >> b) & 1);
+            bits++;
+            count = hpack_huffman_count[bits];
+            if (code < first + count) {
+                index += code - first;
+                if (index >= HPACK_HUFFMAN_EOS || n >= dst_size) {
+                    return -1;
+                }
+                dst[n++] = (char)hpack_huffman_symbol[index];
+                code = first = index = bits = 0;
+                continue;
+            }
+            index += count;
+            first = (first + count) << 1;
+            if (bits >= HPACK_HUFFMAN_MAX_BITS) {
+                return -1;
+            }
+        }
+    }
+
+    // 末尾填充为EOS编码的高位（全1），且不超过7位
+    if (bits > 7 || code != (1U << bits) - 1) {
+        return -1;
+    }
+    *dst_len = n;
+    return 0;
+}
+
+static int hpack_decode_int(const uint8_t **pos, const uint8_t *end, int prefix_bits, uint32_t *res)
+{
+    uint32_t mask = (1U << prefix_bits) - 1;
+    uint32_t value;
+    uint32_t shift = 0;
+    uint8_t b;
+
+    if (*pos >= end) {
+        return -1;
+    }
+    value = **pos & mask;
+    (*pos)++;
+    if (value < mask) {
+        *res = value;
+        return 0;
+    }
+
+    while (*pos < end) {
+        b = **pos;
+        (*pos)++;
+        if (shift > HPACK_INT_MAX_SHIFT - 7) {
+            return -1;
+        }
+        value += (uint32_t)(b & 0x7f) << shift;
+        shift += 7;
+        if ((b & 0x80) == 0) {
+            *res = value;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int hpack_decode_str(const uint8_t **pos, const uint8_t *end, char *scratch, struct hpack_str_s *res)
+{
+    uint32_t len;
+    int huffman;
+
+    if (*pos >= end) {
+        return -1;
+    }
+    huffman = (**pos & 0x80) != 0;
+    if (hpack_decode_int(pos, end, 7, &len)) {
+        return -1;
+    }
+    if (len > (size_t)(end - *pos)) {
+        return -1;
+    }
+
+    if (huffman) {
+        if (hpack_huffman_decode(*pos, len, scratch, HPACK_MAX_STRING_LEN, &res->len)) {
+            return -1;
+        }
+        res->str = scratch;
+    } else {
+        if (len > HPACK_MAX_STRING_LEN) {
+            return -1;
+        }
+        res->str = (const char *)*pos;
+        res->len = len;
+    }
+    *pos += len;
+    return 0;
+}
+
+#if 1
+static struct hpack_entry_s *hpack_dynamic_entry(struct hpack_table_s *table, uint32_t i)
+{
+    // i == 0 is the newest entry
+    return &table->entries[(table->head + table->capacity - i) % table->capacity];
+}
+
+static void hpack_evict_oldest(struct hpack_table_s *table)
+{
+    struct hpack_entry_s *entry = hpack_dynamic_entry(table, table->count - 1);
+
+    table->size -= entry->name_len + entry->value_len + HPACK_ENTRY_OVERHEAD;
+    free(entry->name);
+    (void)memset(entry, 0, sizeof(struct hpack_entry_s));
+    table->count--;
+}
+
+static void hpack_evict_to(struct hpack_table_s *table, uint32_t size)
+{
+    while (table->count > 0 && table->size > size) {
+        hpack_evict_oldest(table);
+    }
+}
+
+static int hpack_grow_table(struct hpack_table_s *table)
+{
+    struct hpack_entry_s *entries;
+    uint32_t capacity = (table->capacity == 0) ? HPACK_MIN_TABLE_SLOTS : table->capacity * 2;
+
+    entries = (struct hpack_entry_s *)calloc(capacity, sizeof(struct hpack_entry_s));
+    if (entries == NULL) {
+        return -1;
+    }
+    // oldest entry first, so that the newest one is at count - 1
+    for (uint32_t i = 0; i < table->count; i++) {
+        entries[i] = *hpack_dynamic_entry(table, table->count - 1 - i);
+    }
+    free(table->entries);
+    table->entries = entries;
+    table->capacity = capacity;
+    table->head = (table->count == 0) ? capacity - 1 : table->count - 1;
+    return 0;
+}
+
+// RFC 7541 4.4
+static int hpack_add_entry(struct hpack_table_s *table, const struct hpack_str_s *name, const struct hpack_str_s *value)
+{
+    struct hpack_entry_s *entry;
+    char *buf;
+    uint32_t entry_size = (uint32_t)(name->len + value->len + HPACK_ENTRY_OVERHEAD);
+
+    if (entry_size > table->max_size) {
+        hpack_evict_to(table, 0);
+        return 0;
+    }
+
+    // name可能引用即将淘汰的表项，先拷贝再淘汰
+    buf = (char *)malloc(name->len + value->len + 2);
+    if (buf == NULL) {
+        return -1;
+    }
+    (void)memcpy(buf, name->str, name->len);
+    buf[name->len] = 0;
+    (void)memcpy(buf + name->len + 1, value->str, value->len);
+    buf[name->len + 1 + value->len] = 0;
+
+    hpack_evict_to(table, table->max_size - entry_size);
+    if (table->count == table->capacity && hpack_grow_table(table)) {
+        free(buf);
+        return -1;
+    }
+
+    table->head = (table->head + 1) % table->capacity;
+    entry = &table->entries[table->head];
+    entry->name = buf;
+    entry->name_len = (uint32_t)name->len;
+    entry->value = buf + name->len + 1;
+    entry->value_len = (uint32_t)value->len;
+    table->count++;
+    table->size += entry_size;
+    return 0;
+}
+
+static int hpack_get_field(struct hpack_table_s *table, uint32_t index, struct hpack_str_s *name,
+                           struct hpack_str_s *value)
+{
+    struct hpack_entry_s *entry;
+
+    if (index == 0) {
+        return -1;
+    }
+    if (index <= HPACK_STATIC_TABLE_SIZE) {
+        name->str = hpack_static_table[index - 1].name;
+        name->len = strlen(name->str);
+        value->str = hpack_static_table[index - 1].value;
+        value->len = strlen(value->str);
+        return 0;
+    }
+
+    index -= HPACK_STATIC_TABLE_SIZE + 1;
+    if (index >= table->count) {
+        return -1;
+    }
+    entry = hpack_dynamic_entry(table, index);
+    name->str = entry->name;
+    name->len = entry->name_len;
+    value->str = entry->value;
+    value->len = entry->value_len;
+    return 0;
+}
+#endif
+
+void init_hpack_table(struct hpack_table_s *table)
+{
+    (void)memset(table, 0, sizeof(struct hpack_table_s));
+    table->max_size = HPACK_DEFAULT_TABLE_SIZE;
+}
+
+void deinit_hpack_table(struct hpack_table_s *table)
+{
+    hpack_evict_to(table, 0);
+    free(table->entries);
+    init_hpack_table(table);
+}
+
+void reset_hpack_table(struct hpack_table_s *table)
+{
+    deinit_hpack_table(table);
+}
+
+int hpack_decode_block(struct hpack_table_s *table, const uint8_t *block, size_t len, hpack_field_cb cb, void *arg)
+{
+    const uint8_t *pos = block;
+    const uint8_t *end = block + len;
+    char name_buf[HPACK_MAX_STRING_LEN];
+    char value_buf[HPACK_MAX_STRING_LEN];
+    struct hpack_str_s name, value;
+    uint32_t index;
+    uint8_t b;
+    int prefix_bits;
+
+    while (pos < end) {
+        b = *pos;
+
+        // Indexed Header Field, RFC 7541 6.1
+        if (b & 0x80) {
+            if (hpack_decode_int(&pos, end, 7, &index) || hpack_get_field(table, index, &name, &value)) {
+                return -1;
+            }
+            if (cb) {
+                cb(name.str, name.len, value.str, value.len, arg);
+            }
+            continue;
+        }
+
+        // Dynamic Table Size Update, RFC 7541 6.3
+        if ((b & 0xe0) == 0x20) {
+            if (hpack_decode_int(&pos, end, 5, &index)) {
+                return -1;
+            }
+            table->max_size = (index > HPACK_MAX_TABLE_SIZE) ? HPACK_MAX_TABLE_SIZE : index;
+            hpack_evict_to(table, table->max_size);
+            continue;
+        }
+
+        // Literal Header Field with Incremental Indexing(6 bits prefix), without Indexing or Never Indexed(4 bits)
+        prefix_bits = ((b & 0xc0) == 0x40) ? 6 : 4;
+        if (hpack_decode_int(&pos, end, prefix_bits, &index)) {
+            return -1;
+        }
+        if (index == 0) {
+            if (hpack_decode_str(&pos, end, name_buf, &name)) {
+                return -1;
+            }
+        } else if (hpack_get_field(table, index, &name, &value)) {
+            return -1;
+        }
+        if (hpack_decode_str(&pos, end, value_buf, &value)) {
+            return -1;
+        }
+        if (cb) {
+            cb(name.str, name.len, value.str, value.len, arg);
+        }
+        if (prefix_bits == 6 && hpack_add_entry(table, &name, &value)) {
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-08-22
+ * Description: HPACK header block decoder
+ ******************************************************************************/
+
+#ifndef __HPACK_H__
+#define __HPACK_H__
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// References HPACK spec:
+// https://www.rfc-editor.org/rfc/rfc7541
+#define HPACK_DEFAULT_TABLE_SIZE 4096
+
+// 对端可通过SETTINGS_HEADER_TABLE_SIZE调大动态表，超出该上限的大小更新按上限处理，避免异常报文耗尽内存
+#define HPACK_MAX_TABLE_SIZE (64 * 1024)
+
+// 单个头部字段（Huffman解码后）的最大长度，超出视为解码失败
+#define HPACK_MAX_STRING_LEN 8192
+
+struct hpack_entry_s {
+    char *name;
+    char *value;
+    uint32_t name_len;
+    uint32_t value_len;
+};
+
+/**
+ * HPACK dynamic table, one per connection direction.
+ * 环形数组保存表项，head为最新插入的表项（动态表索引62），按RFC 7541 4.1计算表项大小并按FIFO淘汰。
+ */
+struct hpack_table_s {
+    struct hpack_entry_s *entries;
+    uint32_t capacity;      // slots of entries[]
+    uint32_t head;
+    uint32_t count;
+    uint32_t size;          // sum of (name_len + value_len + 32)
+    uint32_t max_size;
+};
+
+/**
+ * Called for every decoded header field, name and value are not NUL-terminated and only valid during the call.
+ */
+typedef void (*hpack_field_cb)(const char *name, size_t name_len, const char *value, size_t value_len, void *arg);
+
+void init_hpack_table(struct hpack_table_s *table);
+
+void deinit_hpack_table(struct hpack_table_s *table);
+
+/**
+ * Reset the dynamic table to the initial state, used when the decoder loses sync with the encoder.
+ */
+void reset_hpack_table(struct hpack_table_s *table);
+
+/**
+ * Decode a complete header block(HEADERS/PUSH_PROMISE + CONTINUATION payloads with padding and priority removed).
+ * Every header block must be decoded in order, even if its fields are not used, to keep the dynamic table in sync.
+ *
+ * @param table dynamic table of the direction
+ * @param block header block
+ * @param len length of block
+ * @param cb callback of each decoded field, can be NULL
+ * @param arg argument of cb
+ * @return 0 if success, -1 if the block is malformed, the dynamic table is undefined and should be reset.
+ */
+int hpack_decode_block(struct hpack_table_s *table, const uint8_t *block, size_t len, hpack_field_cb cb, void *arg);
+
+#endif
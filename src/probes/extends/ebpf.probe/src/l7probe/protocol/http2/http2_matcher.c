@@ -0,0 +1,147 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-08-22
+ * Description:
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "common.h"
+#include "http2_parser.h"
+#include "http2_matcher.h"
+
+// 待匹配请求的上限，超出时丢弃最早的请求，避免长连接流（如gRPC streaming）占满帧缓存
+#define HTTP2_MAX_PENDING_REQS (__FRAME_BUF_SIZE / 2)
+
+static bool http2_is_err(const struct http2_record_s *record)
+{
+    if (record->reset) {
+        return true;
+    }
+    // gRPC的错误通过grpc-status返回，HTTP状态码为200
+    if (record->grpc_status != HTTP2_GRPC_STATUS_NONE) {
+        return record->grpc_status != 0;
+    }
+    return record->status >= 400;
+}
+
+static void add_http2_record_into_buf(const struct http2_msg_s *req_msg, const struct http2_msg_s *resp_msg,
+                                      struct record_buf_s *record_buf)
+{
+    struct http2_record_s *record;
+    struct record_data_s *record_data;
+
+    record = init_http2_record();
+    if (record == NULL) {
+        ERROR("[HTTP2 MATCHER] Failed to malloc http2_record.\n");
+        return;
+    }
+    (void)strncpy(record->method, req_msg->method, HTTP2_METHOD_LEN - 1);
+    (void)strncpy(record->path, req_msg->path, HTTP2_PATH_LEN - 1);
+    record->status = resp_msg->status;
+    record->grpc_status = resp_msg->grpc_status;
+    // RST_STREAM(NO_ERROR)用于服务端已完成响应后提前结束请求体，不视为错误
+    record->reset = resp_msg->reset && resp_msg->rst_code != 0;
+    record->req_timestamp_ns = req_msg->timestamp_ns;
+    record->resp_timestamp_ns = resp_msg->timestamp_ns;
+
+    record_data = (struct record_data_s *) malloc(sizeof(struct record_data_s));
+    if (record_data == NULL) {
+        ERROR("[HTTP2 MATCHER] Failed to malloc record_data.\n");
+        free_http2_record(record);
+        return;
+    }
+    memset(record_data, 0, sizeof(struct record_data_s));
+    record_data->record = record;
+    if (record->resp_timestamp_ns > record->req_timestamp_ns) {
+        record_data->latency = record->resp_timestamp_ns - record->req_timestamp_ns;
+    }
+
+    // gRPC按方法（:path）统计，普通HTTP/2请求与HTTP/1.x一致，不按api统计
+    if (record->grpc_status != HTTP2_GRPC_STATUS_NONE) {
+        (void)snprintf(record_data->api, L7_API_LEN, "%s", record->path);
+    }
+    record_data->is_err = http2_is_err(record);
+
+    if (record_data->is_err) {
+        ++record_buf->err_count;
+    }
+    record_buf->records[record_buf->record_buf_size] = record_data;
+    ++record_buf->record_buf_size;
+}
+
+static u64 http2_latest_timestamp(const struct frame_buf_s *req_frames, const struct frame_buf_s *resp_frames)
+{
+    u64 ts = 0;
+
+    if (req_frames->frame_buf_size > 0) {
+        ts = req_frames->frames[req_frames->frame_buf_size - 1]->timestamp_ns;
+    }
+    if (resp_frames->frame_buf_size > 0 && resp_frames->frames[resp_frames->frame_buf_size - 1]->timestamp_ns > ts) {
+        ts = resp_frames->frames[resp_frames->frame_buf_size - 1]->timestamp_ns;
+    }
+    return ts;
+}
+
+// Release the leading requests which are matched, timed out or exceed the pending limit, each request is counted once.
+static void http2_release_reqs(struct frame_buf_s *req_frames, u64 now, struct record_buf_s *record_buf)
+{
+    struct http2_msg_s *msg;
+
+    while (req_frames->current_pos < req_frames->frame_buf_size) {
+        msg = (struct http2_msg_s *) req_frames->frames[req_frames->current_pos]->frame;
+        if (!msg->matched && msg->timestamp_ns + HTTP2_STREAM_TIMEOUT_NS >= now &&
+            req_frames->frame_buf_size - req_frames->current_pos <= HTTP2_MAX_PENDING_REQS) {
+            break;
+        }
+        ++req_frames->current_pos;
+        ++record_buf->req_count;
+    }
+}
+
+void http2_match_frames(struct frame_buf_s *req_frames, struct frame_buf_s *resp_frames,
+                        struct record_buf_s *record_buf)
+{
+    record_buf->err_count = 0;
+    record_buf->record_buf_size = 0;
+    record_buf->req_count = 0;
+    record_buf->resp_count = 0;
+
+    while (resp_frames->current_pos < resp_frames->frame_buf_size) {
+        struct http2_msg_s *resp_msg;
+        struct http2_msg_s *req_msg = NULL;
+
+        if (record_buf->record_buf_size >= RECORD_BUF_SIZE) {
+            break;
+        }
+
+        resp_msg = (struct http2_msg_s *) resp_frames->frames[resp_frames->current_pos]->frame;
+        for (size_t req_pos = req_frames->current_pos; req_pos < req_frames->frame_buf_size; ++req_pos) {
+            struct http2_msg_s *msg = (struct http2_msg_s *) req_frames->frames[req_pos]->frame;
+            if (!msg->matched && msg->stream_id == resp_msg->stream_id) {
+                req_msg = msg;
+                break;
+            }
+        }
+        ++resp_frames->current_pos;
+        ++record_buf->resp_count;
+
+        // 找不到对应请求说明请求已丢失（或已被RST_STREAM取消），丢弃该响应
+        if (req_msg == NULL) {
+            continue;
+        }
+        req_msg->matched = true;
+        add_http2_record_into_buf(req_msg, resp_msg, record_buf);
+    }
+
+    http2_release_reqs(req_frames, http2_latest_timestamp(req_frames, resp_frames), record_buf);
+}
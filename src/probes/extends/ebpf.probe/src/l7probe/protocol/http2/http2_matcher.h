@@ -0,0 +1,35 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-08-22
+ * Description:
+ ******************************************************************************/
+
+#ifndef __HTTP2_MATCHER_H__
+#define __HTTP2_MATCHER_H__
+
+#pragma once
+
+#include "../../include/data_stream.h"
+#include "http2_msg_format.h"
+
+/**
+ * Match HTTP/2 requests and responses by stream id.
+ * 同一连接上的流并发且乱序完成，未得到响应的请求保留在队列中，直至得到响应、超时或待匹配请求过多时被丢弃。
+ *
+ * @param req_frames
+ * @param resp_frames
+ * @param record_buf
+ */
+void http2_match_frames(struct frame_buf_s *req_frames, struct frame_buf_s *resp_frames,
+                        struct record_buf_s *record_buf);
+
+#endif
@@ -0,0 +1,57 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-08-22
+ * Description:
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "common.h"
+#include "http2_msg_format.h"
+
+struct http2_msg_s *init_http2_msg(void)
+{
+    struct http2_msg_s *msg = (struct http2_msg_s *) malloc(sizeof(struct http2_msg_s));
+    if (msg == NULL) {
+        return NULL;
+    }
+    memset(msg, 0, sizeof(struct http2_msg_s));
+    msg->grpc_status = HTTP2_GRPC_STATUS_NONE;
+    return msg;
+}
+
+void free_http2_msg(struct http2_msg_s *msg)
+{
+    if (msg == NULL) {
+        return;
+    }
+    free(msg);
+}
+
+struct http2_record_s *init_http2_record(void)
+{
+    struct http2_record_s *record = (struct http2_record_s *) malloc(sizeof(struct http2_record_s));
+    if (record == NULL) {
+        return NULL;
+    }
+    memset(record, 0, sizeof(struct http2_record_s));
+    record->grpc_status = HTTP2_GRPC_STATUS_NONE;
+    return record;
+}
+
+void free_http2_record(struct http2_record_s *record)
+{
+    if (record == NULL) {
+        return;
+    }
+    free(record);
+}
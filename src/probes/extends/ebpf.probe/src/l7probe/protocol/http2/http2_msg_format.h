@@ -0,0 +1,97 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-08-22
+ * Description:
+ ******************************************************************************/
+
+#ifndef __HTTP2_MSG_FORMAT_H__
+#define __HTTP2_MSG_FORMAT_H__
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../../include/data_stream.h"
+
+// References HTTP/2 spec:
+// https://www.rfc-editor.org/rfc/rfc9113
+#define HTTP2_PREFACE "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+#define HTTP2_PREFACE_LEN 24
+#define HTTP2_FRAME_HEADER_LEN 9
+
+enum http2_frame_type_t {
+    HTTP2_FRAME_DATA = 0x0,
+    HTTP2_FRAME_HEADERS = 0x1,
+    HTTP2_FRAME_PRIORITY = 0x2,
+    HTTP2_FRAME_RST_STREAM = 0x3,
+    HTTP2_FRAME_SETTINGS = 0x4,
+    HTTP2_FRAME_PUSH_PROMISE = 0x5,
+    HTTP2_FRAME_PING = 0x6,
+    HTTP2_FRAME_GOAWAY = 0x7,
+    HTTP2_FRAME_WINDOW_UPDATE = 0x8,
+    HTTP2_FRAME_CONTINUATION = 0x9,
+};
+
+// 扩展帧类型（ALTSVC、ORIGIN、PRIORITY_UPDATE等）的上限，解析时按长度跳过
+#define HTTP2_FRAME_MAX_EXT_TYPE 0x10
+
+#define HTTP2_FLAG_END_STREAM 0x01
+#define HTTP2_FLAG_ACK 0x01
+#define HTTP2_FLAG_END_HEADERS 0x04
+#define HTTP2_FLAG_PADDED 0x08
+#define HTTP2_FLAG_PRIORITY 0x20
+
+#define HTTP2_METHOD_LEN 16
+#define HTTP2_PATH_LEN 128      // gRPC时为"/package.Service/Method"，超出部分截断
+
+#define HTTP2_GRPC_STATUS_NONE (-1)
+
+/**
+ * HTTP/2 request or response of one stream, emitted when the stream is closed(END_STREAM or RST_STREAM) in
+ * the direction. 头部字段在HPACK解码时提取，DATA帧只累计长度，不拷贝。
+ */
+struct http2_msg_s {
+    u64 timestamp_ns;   // request: 1st HEADERS frame; response: the frame closing the stream
+    uint32_t stream_id;
+    char method[HTTP2_METHOD_LEN];
+    char path[HTTP2_PATH_LEN];
+    int status;         // :status, 0 if absent
+    int grpc_status;    // grpc-status in headers or trailers, HTTP2_GRPC_STATUS_NONE if absent
+    bool reset;         // closed by RST_STREAM
+    uint32_t rst_code;
+    bool matched;       // request only, the response is matched
+    u64 body_len;       // sum of DATA payload lengths
+};
+
+struct http2_msg_s *init_http2_msg(void);
+
+void free_http2_msg(struct http2_msg_s *msg);
+
+/**
+ * HTTP/2 record, req & resp metadata copied from frames.
+ */
+struct http2_record_s {
+    char method[HTTP2_METHOD_LEN];
+    char path[HTTP2_PATH_LEN];
+    int status;
+    int grpc_status;
+    bool reset;
+    u64 req_timestamp_ns;
+    u64 resp_timestamp_ns;
+};
+
+struct http2_record_s *init_http2_record(void);
+
+void free_http2_record(struct http2_record_s *record);
+
+#endif
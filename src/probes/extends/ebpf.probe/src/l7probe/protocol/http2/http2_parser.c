@@ -0,0 +1,584 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-08-22
+ * Description:
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "common.h"
+#include "http2_parser.h"
+#include "../utils/macros.h"
+
+// 重新同步帧边界时只接受不超过默认SETTINGS_MAX_FRAME_SIZE的帧
+#define HTTP2_RESYNC_MAX_FRAME_LEN 16384
+
+#define HTTP2_PRIORITY_LEN 5
+#define HTTP2_PROMISED_ID_LEN 4
+#define HTTP2_RST_STREAM_LEN 4
+#define HTTP2_SETTING_LEN 6
+#define HTTP2_PING_LEN 8
+#define HTTP2_GOAWAY_MIN_LEN 8
+#define HTTP2_WINDOW_UPDATE_LEN 4
+
+struct http2_frame_header_s {
+    uint32_t len;
+    uint8_t type;
+    uint8_t flags;
+    uint32_t stream_id;
+};
+
+static uint32_t http2_be32(const uint8_t *buf)
+{
+    return ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+}
+
+static void http2_decode_frame_header(const uint8_t *buf, struct http2_frame_header_s *hdr)
+{
+    hdr->len = ((uint32_t)buf[0] << 16) | ((uint32_t)buf[1] << 8) | buf[2];
+    hdr->type = buf[3];
+    hdr->flags = buf[4];
+    hdr->stream_id = http2_be32(buf + 5) & 0x7fffffff;
+}
+
+/*
+ * resync: looking for a frame boundary in the middle of the data, only well-known frame types of reasonable size
+ * with the reserved bit cleared on client-initiated(odd) streams are accepted.
+ */
+static bool http2_valid_frame_header(const uint8_t *buf, bool resync)
+{
+    struct http2_frame_header_s hdr;
+
+    http2_decode_frame_header(buf, &hdr);
+    if (resync) {
+        if (hdr.len > HTTP2_RESYNC_MAX_FRAME_LEN || (buf[5] & 0x80) != 0) {
+            return false;
+        }
+        if (hdr.stream_id != 0 && (hdr.stream_id & 1) == 0) {
+            return false;
+        }
+    }
+
+    switch (hdr.type) {
+        case HTTP2_FRAME_DATA:
+        case HTTP2_FRAME_HEADERS:
+        case HTTP2_FRAME_PUSH_PROMISE:
+        case HTTP2_FRAME_CONTINUATION:
+            return hdr.stream_id != 0;
+        case HTTP2_FRAME_PRIORITY:
+            return hdr.stream_id != 0 && hdr.len == HTTP2_PRIORITY_LEN;
+        case HTTP2_FRAME_RST_STREAM:
+            return hdr.stream_id != 0 && hdr.len == HTTP2_RST_STREAM_LEN;
+        case HTTP2_FRAME_SETTINGS:
+            return hdr.stream_id == 0 && (hdr.len % HTTP2_SETTING_LEN) == 0 &&
+                   ((hdr.flags & HTTP2_FLAG_ACK) == 0 || hdr.len == 0);
+        case HTTP2_FRAME_PING:
+            return hdr.stream_id == 0 && hdr.len == HTTP2_PING_LEN;
+        case HTTP2_FRAME_GOAWAY:
+            return hdr.stream_id == 0 && hdr.len >= HTTP2_GOAWAY_MIN_LEN;
+        case HTTP2_FRAME_WINDOW_UPDATE:
+            return hdr.len == HTTP2_WINDOW_UPDATE_LEN;
+        default:
+            return !resync && hdr.type <= HTTP2_FRAME_MAX_EXT_TYPE;
+    }
+}
+
+// Skip the payload by length, the part beyond raw_data is skipped via raw_data->skip_len.
+static void http2_skip_payload(struct raw_data_s *raw_data, size_t payload_start, uint32_t len)
+{
+    size_t avail = raw_data->data_len - payload_start;
+
+    if ((size_t)len <= avail) {
+        raw_data->current_pos = payload_start + len;
+    } else {
+        raw_data->current_pos = raw_data->data_len;
+        raw_data->skip_len = (size_t)len - avail;
+    }
+}
+
+#if 1
+static struct http2_stream_s *http2_find_stream(struct http2_conn_ctx_s *ctx, uint32_t stream_id)
+{
+    struct http2_stream_s *stream = NULL;
+
+    H_FIND(ctx->streams, &stream_id, sizeof(uint32_t), stream);
+    return stream;
+}
+
+static void http2_del_stream(struct http2_conn_ctx_s *ctx, struct http2_stream_s *stream)
+{
+    if (ctx->hdr_stream == stream) {
+        ctx->hdr_stream = NULL;
+    }
+    H_DEL(ctx->streams, stream);
+    free_http2_msg(stream->msg);
+    free(stream);
+}
+
+// 流在该方向上未关闭（如请求/响应丢失），超时后淘汰
+static void http2_evict_streams(struct http2_conn_ctx_s *ctx, u64 now)
+{
+    struct http2_stream_s *stream, *tmp;
+
+    H_ITER(ctx->streams, stream, tmp) {
+        if (stream->msg->timestamp_ns + HTTP2_STREAM_TIMEOUT_NS < now) {
+            http2_del_stream(ctx, stream);
+        }
+    }
+}
+
+static struct http2_stream_s *http2_get_stream(struct http2_conn_ctx_s *ctx, uint32_t stream_id, u64 timestamp_ns)
+{
+    struct http2_stream_s *stream = http2_find_stream(ctx, stream_id);
+
+    if (stream != NULL) {
+        return stream;
+    }
+
+    if (H_COUNT(ctx->streams) >= HTTP2_MAX_STREAMS) {
+        http2_evict_streams(ctx, timestamp_ns);
+        if (H_COUNT(ctx->streams) >= HTTP2_MAX_STREAMS) {
+            return NULL;
+        }
+    }
+
+    stream = (struct http2_stream_s *) malloc(sizeof(struct http2_stream_s));
+    if (stream == NULL) {
+        return NULL;
+    }
+    memset(stream, 0, sizeof(struct http2_stream_s));
+    stream->msg = init_http2_msg();
+    if (stream->msg == NULL) {
+        free(stream);
+        return NULL;
+    }
+    stream->stream_id = stream_id;
+    stream->msg->stream_id = stream_id;
+    stream->msg->timestamp_ns = timestamp_ns;
+    H_ADD(ctx->streams, stream_id, sizeof(uint32_t), stream);
+    return stream;
+}
+
+// Remove the stream and take over its message.
+static struct http2_msg_s *http2_detach_msg(struct http2_conn_ctx_s *ctx, struct http2_stream_s *stream)
+{
+    struct http2_msg_s *msg = stream->msg;
+
+    stream->msg = NULL;
+    http2_del_stream(ctx, stream);
+    return msg;
+}
+
+static parse_state_t http2_emit_msg(enum message_type_t msg_type, struct http2_msg_s *msg, u64 timestamp_ns,
+                                    struct frame_data_s **frame_data)
+{
+    if (msg_type == MESSAGE_RESPONSE) {
+        msg->timestamp_ns = timestamp_ns;
+    }
+
+    *frame_data = (struct frame_data_s *) malloc(sizeof(struct frame_data_s));
+    if ((*frame_data) == NULL) {
+        ERROR("[HTTP2 parser] Failed to malloc frame_data.\n");
+        free_http2_msg(msg);
+        return STATE_IGNORE;
+    }
+    (*frame_data)->msg_type = msg_type;
+    (*frame_data)->timestamp_ns = msg->timestamp_ns;
+    (*frame_data)->frame = msg;
+    return STATE_SUCCESS;
+}
+#endif
+
+#if 1
+#define HTTP2_FIELD_IS(name, name_len, field) \
+    ((name_len) == sizeof(field) - 1 && memcmp((name), (field), sizeof(field) - 1) == 0)
+
+static void http2_copy_field(char *dst, size_t dst_size, const char *value, size_t value_len)
+{
+    size_t len = (value_len < dst_size - 1) ? value_len : dst_size - 1;
+
+    (void)memcpy(dst, value, len);
+    dst[len] = 0;
+}
+
+static int http2_field_to_int(const char *value, size_t value_len)
+{
+    int res = 0;
+
+    // :status为3位数字，grpc-status为0-16
+    for (size_t i = 0; i < value_len && i < 4; i++) {
+        if (value[i] < '0' || value[i] > '9') {
+            break;
+        }
+        res = res * 10 + (value[i] - '0');
+    }
+    return res;
+}
+
+static void http2_on_header_field(const char *name, size_t name_len, const char *value, size_t value_len, void *arg)
+{
+    struct http2_msg_s *msg = (struct http2_msg_s *)arg;
+
+    if (HTTP2_FIELD_IS(name, name_len, ":method")) {
+        http2_copy_field(msg->method, HTTP2_METHOD_LEN, value, value_len);
+    } else if (HTTP2_FIELD_IS(name, name_len, ":path")) {
+        http2_copy_field(msg->path, HTTP2_PATH_LEN, value, value_len);
+    } else if (HTTP2_FIELD_IS(name, name_len, ":status")) {
+        msg->status = http2_field_to_int(value, value_len);
+    } else if (HTTP2_FIELD_IS(name, name_len, "grpc-status")) {
+        msg->grpc_status = http2_field_to_int(value, value_len);
+    }
+}
+
+static void http2_drop_header_block(struct http2_conn_ctx_s *ctx)
+{
+    if (ctx->hdr_block != NULL) {
+        free(ctx->hdr_block);
+    }
+    ctx->hdr_block = NULL;
+    ctx->hdr_block_len = 0;
+    ctx->hdr_pending = 0;
+    ctx->hdr_end_stream = 0;
+    ctx->hdr_stream_id = 0;
+    ctx->hdr_stream = NULL;
+}
+
+// 头部块丢失或无法解码，HPACK动态表与编码端失去同步，之后引用动态表的字段无法解码直至动态表重新建立
+static void http2_lost_hpack_sync(struct http2_conn_ctx_s *ctx)
+{
+    http2_drop_header_block(ctx);
+    reset_hpack_table(&ctx->hpack);
+}
+
+static int http2_append_header_block(struct http2_conn_ctx_s *ctx, const uint8_t *frag, size_t frag_len)
+{
+    uint8_t *block;
+
+    if (frag_len == 0) {
+        return 0;
+    }
+    if (ctx->hdr_block_len + frag_len > HTTP2_MAX_HEADER_BLOCK_LEN) {
+        return -1;
+    }
+    block = (uint8_t *) realloc(ctx->hdr_block, ctx->hdr_block_len + frag_len);
+    if (block == NULL) {
+        return -1;
+    }
+    (void)memcpy(block + ctx->hdr_block_len, frag, frag_len);
+    ctx->hdr_block = block;
+    ctx->hdr_block_len += frag_len;
+    return 0;
+}
+
+static void http2_decode_header_block(struct http2_conn_ctx_s *ctx, const uint8_t *block, size_t len)
+{
+    struct http2_msg_s *msg = (ctx->hdr_stream != NULL) ? ctx->hdr_stream->msg : NULL;
+
+    if (hpack_decode_block(&ctx->hpack, block, len, (msg != NULL) ? http2_on_header_field : NULL, msg)) {
+        DEBUG("[HTTP2 parser] Failed to decode header block of stream %u.\n", ctx->hdr_stream_id);
+        reset_hpack_table(&ctx->hpack);
+    }
+}
+#endif
+
+static parse_state_t http2_parse_data(enum message_type_t msg_type, struct raw_data_s *raw_data,
+                                      struct http2_conn_ctx_s *ctx, const struct http2_frame_header_s *hdr,
+                                      struct frame_data_s **frame_data)
+{
+    struct http2_stream_s *stream;
+
+    // 报文体不拷贝，超出raw_data的部分由后续raw data跳过
+    http2_skip_payload(raw_data, raw_data->current_pos + HTTP2_FRAME_HEADER_LEN, hdr->len);
+
+    stream = http2_find_stream(ctx, hdr->stream_id);
+    if (stream == NULL) {
+        return STATE_IGNORE;
+    }
+    stream->msg->body_len += hdr->len;
+    if (hdr->flags & HTTP2_FLAG_END_STREAM) {
+        return http2_emit_msg(msg_type, http2_detach_msg(ctx, stream), raw_data->timestamp_ns, frame_data);
+    }
+    return STATE_IGNORE;
+}
+
+// Strip padding, priority and promised stream id of HEADERS/PUSH_PROMISE, and start a new header block.
+static int http2_start_header_block(struct http2_conn_ctx_s *ctx, const struct http2_frame_header_s *hdr,
+                                    u64 timestamp_ns, const uint8_t **frag, size_t *frag_len)
+{
+    size_t pad_len = 0;
+    size_t skip_len = 0;
+
+    if (hdr->flags & HTTP2_FLAG_PADDED) {
+        if (*frag_len < 1) {
+            return -1;
+        }
+        pad_len = (*frag)[0];
+        skip_len = 1;
+    }
+    if (hdr->type == HTTP2_FRAME_HEADERS && (hdr->flags & HTTP2_FLAG_PRIORITY)) {
+        skip_len += HTTP2_PRIORITY_LEN;
+    } else if (hdr->type == HTTP2_FRAME_PUSH_PROMISE) {
+        skip_len += HTTP2_PROMISED_ID_LEN;
+    }
+    if (skip_len + pad_len > *frag_len) {
+        return -1;
+    }
+    *frag += skip_len;
+    *frag_len -= skip_len + pad_len;
+
+    ctx->hdr_stream_id = hdr->stream_id;
+    // PUSH_PROMISE的头部块只需解码以同步动态表
+    if (hdr->type == HTTP2_FRAME_HEADERS) {
+        ctx->hdr_end_stream = (hdr->flags & HTTP2_FLAG_END_STREAM) ? 1 : 0;
+        ctx->hdr_stream = http2_get_stream(ctx, hdr->stream_id, timestamp_ns);
+    }
+    return 0;
+}
+
+static parse_state_t http2_parse_headers(enum message_type_t msg_type, struct raw_data_s *raw_data,
+                                         struct http2_conn_ctx_s *ctx, const struct http2_frame_header_s *hdr,
+                                         struct frame_data_s **frame_data)
+{
+    size_t payload_start = raw_data->current_pos + HTTP2_FRAME_HEADER_LEN;
+    const uint8_t *frag = (const uint8_t *)raw_data->data + payload_start;
+    size_t frag_len = hdr->len;
+    struct http2_stream_s *stream;
+    char end_stream;
+
+    if (hdr->len > HTTP2_MAX_HEADER_BLOCK_LEN) {
+        http2_lost_hpack_sync(ctx);
+        http2_skip_payload(raw_data, payload_start, hdr->len);
+        return STATE_IGNORE;
+    }
+    if ((size_t)hdr->len > raw_data->data_len - payload_start) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+    raw_data->current_pos = payload_start + hdr->len;
+
+    if (hdr->type == HTTP2_FRAME_CONTINUATION) {
+        if (!ctx->hdr_pending || hdr->stream_id != ctx->hdr_stream_id) {
+            http2_lost_hpack_sync(ctx);
+            return STATE_IGNORE;
+        }
+    } else if (http2_start_header_block(ctx, hdr, raw_data->timestamp_ns, &frag, &frag_len)) {
+        http2_lost_hpack_sync(ctx);
+        return STATE_IGNORE;
+    }
+
+    if ((hdr->flags & HTTP2_FLAG_END_HEADERS) == 0) {
+        if (http2_append_header_block(ctx, frag, frag_len)) {
+            http2_lost_hpack_sync(ctx);
+            return STATE_IGNORE;
+        }
+        ctx->hdr_pending = 1;
+        return STATE_IGNORE;
+    }
+
+    // 头部块未被拆分时直接在raw_data上解码，无需拷贝
+    if (ctx->hdr_pending) {
+        if (http2_append_header_block(ctx, frag, frag_len)) {
+            http2_lost_hpack_sync(ctx);
+            return STATE_IGNORE;
+        }
+        http2_decode_header_block(ctx, ctx->hdr_block, ctx->hdr_block_len);
+    } else {
+        http2_decode_header_block(ctx, frag, frag_len);
+    }
+
+    stream = ctx->hdr_stream;
+    end_stream = ctx->hdr_end_stream;
+    http2_drop_header_block(ctx);
+    if (stream != NULL && end_stream) {
+        return http2_emit_msg(msg_type, http2_detach_msg(ctx, stream), raw_data->timestamp_ns, frame_data);
+    }
+    return STATE_IGNORE;
+}
+
+static parse_state_t http2_parse_rst_stream(enum message_type_t msg_type, struct raw_data_s *raw_data,
+                                            struct http2_conn_ctx_s *ctx, const struct http2_frame_header_s *hdr,
+                                            struct frame_data_s **frame_data)
+{
+    size_t payload_start = raw_data->current_pos + HTTP2_FRAME_HEADER_LEN;
+    struct http2_stream_s *stream;
+    struct http2_msg_s *msg;
+
+    if (raw_data->data_len - payload_start < HTTP2_RST_STREAM_LEN) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+    raw_data->current_pos = payload_start + HTTP2_RST_STREAM_LEN;
+
+    stream = http2_find_stream(ctx, hdr->stream_id);
+    // 客户端取消的流：丢弃未完成的请求；已发出的请求等待服务端的RST_STREAM或超时
+    if (msg_type == MESSAGE_REQUEST) {
+        if (stream != NULL) {
+            http2_del_stream(ctx, stream);
+        }
+        return STATE_IGNORE;
+    }
+
+    // 服务端重置的流（包括未发送响应头的流，如REFUSED_STREAM）作为错误响应
+    if (stream != NULL) {
+        msg = http2_detach_msg(ctx, stream);
+    } else {
+        msg = init_http2_msg();
+        if (msg == NULL) {
+            return STATE_IGNORE;
+        }
+        msg->stream_id = hdr->stream_id;
+    }
+    msg->reset = true;
+    msg->rst_code = http2_be32((const uint8_t *)raw_data->data + payload_start);
+    return http2_emit_msg(msg_type, msg, raw_data->timestamp_ns, frame_data);
+}
+
+static struct http2_conn_ctx_s *create_http2_conn_ctx(void)
+{
+    struct http2_conn_ctx_s *ctx = (struct http2_conn_ctx_s *) malloc(sizeof(struct http2_conn_ctx_s));
+    if (ctx == NULL) {
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(struct http2_conn_ctx_s));
+    init_hpack_table(&ctx->hpack);
+    return ctx;
+}
+
+void free_http2_conn_ctx(struct http2_conn_ctx_s *ctx)
+{
+    struct http2_stream_s *stream, *tmp;
+
+    if (ctx == NULL) {
+        return;
+    }
+    http2_drop_header_block(ctx);
+    H_ITER(ctx->streams, stream, tmp) {
+        http2_del_stream(ctx, stream);
+    }
+    deinit_hpack_table(&ctx->hpack);
+    free(ctx);
+}
+
+// The following frame header, if present in the data, must be valid too.
+static bool http2_resync_frame_header(const uint8_t *data, size_t pos, size_t data_len)
+{
+    struct http2_frame_header_s hdr;
+    size_t next;
+
+    if (!http2_valid_frame_header(&data[pos], true)) {
+        return false;
+    }
+    http2_decode_frame_header(&data[pos], &hdr);
+    next = pos + HTTP2_FRAME_HEADER_LEN + hdr.len;
+    if (next + HTTP2_FRAME_HEADER_LEN <= data_len) {
+        return http2_valid_frame_header(&data[next], true);
+    }
+    return true;
+}
+
+size_t http2_find_frame_boundary(enum message_type_t msg_type, struct raw_data_s *raw_data)
+{
+    const uint8_t *data = (const uint8_t *)raw_data->data;
+    size_t remain;
+    size_t cmp_len;
+    bool resync;
+
+    for (size_t i = raw_data->current_pos; i < raw_data->data_len; ++i) {
+        remain = raw_data->data_len - i;
+        cmp_len = (remain < HTTP2_PREFACE_LEN) ? remain : HTTP2_PREFACE_LEN;
+        if (memcmp(&data[i], HTTP2_PREFACE, cmp_len) == 0) {
+            return i;
+        }
+
+        // 数据不足以判断时，保留当前位置等待更多数据
+        if (remain < HTTP2_FRAME_HEADER_LEN) {
+            return i;
+        }
+
+        // 正常情况下当前位置即为帧边界，解析失败后才需要严格校验
+        resync = (i != raw_data->current_pos) || (raw_data->flags & RAW_DATA_FLAGS_INVALID);
+        if (!resync) {
+            if (http2_valid_frame_header(&data[i], false)) {
+                return i;
+            }
+            continue;
+        }
+        if (http2_resync_frame_header(data, i, raw_data->data_len)) {
+            return i;
+        }
+    }
+    return PARSER_INVALID_BOUNDARY_INDEX;
+}
+
+parse_state_t http2_parse_frame(enum message_type_t msg_type, struct raw_data_s *raw_data,
+                                struct http2_conn_ctx_s **ctx, struct frame_data_s **frame_data)
+{
+    struct http2_frame_header_s hdr;
+    const uint8_t *data;
+    size_t start = raw_data->current_pos;
+    size_t avail;
+    size_t cmp_len;
+
+    if (raw_data->data_len == 0 || start >= raw_data->data_len) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+    if (*ctx == NULL) {
+        *ctx = create_http2_conn_ctx();
+        if (*ctx == NULL) {
+            ERROR("[HTTP2 parser] Failed to malloc http2 conn ctx.\n");
+            return STATE_INVALID;
+        }
+    }
+    data = (const uint8_t *)raw_data->data + start;
+    avail = raw_data->data_len - start;
+
+    // 连接前言只出现在客户端发送方向的开头
+    if (!(*ctx)->preface_checked) {
+        cmp_len = (avail < HTTP2_PREFACE_LEN) ? avail : HTTP2_PREFACE_LEN;
+        if (memcmp(data, HTTP2_PREFACE, cmp_len) == 0) {
+            if (avail < HTTP2_PREFACE_LEN) {
+                return STATE_NEEDS_MORE_DATA;
+            }
+            raw_data->current_pos = start + HTTP2_PREFACE_LEN;
+            (*ctx)->preface_checked = 1;
+            return STATE_IGNORE;
+        }
+        (*ctx)->preface_checked = 1;
+    }
+
+    if (avail < HTTP2_FRAME_HEADER_LEN) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+    if (!http2_valid_frame_header(data, false)) {
+        http2_lost_hpack_sync(*ctx);
+        raw_data->current_pos = start + 1;
+        return STATE_INVALID;
+    }
+    http2_decode_frame_header(data, &hdr);
+
+    // 头部块必须由连续的CONTINUATION帧完成
+    if ((*ctx)->hdr_pending && hdr.type != HTTP2_FRAME_CONTINUATION) {
+        http2_lost_hpack_sync(*ctx);
+    }
+
+    switch (hdr.type) {
+        case HTTP2_FRAME_DATA:
+            return http2_parse_data(msg_type, raw_data, *ctx, &hdr, frame_data);
+        case HTTP2_FRAME_HEADERS:
+        case HTTP2_FRAME_PUSH_PROMISE:
+        case HTTP2_FRAME_CONTINUATION:
+            return http2_parse_headers(msg_type, raw_data, *ctx, &hdr, frame_data);
+        case HTTP2_FRAME_RST_STREAM:
+            return http2_parse_rst_stream(msg_type, raw_data, *ctx, &hdr, frame_data);
+        default:
+            http2_skip_payload(raw_data, start + HTTP2_FRAME_HEADER_LEN, hdr.len);
+            return STATE_IGNORE;
+    }
+}
@@ -0,0 +1,74 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-08-22
+ * Description:
+ ******************************************************************************/
+
+#ifndef __HTTP2_PARSER_H__
+#define __HTTP2_PARSER_H__
+
+#pragma once
+
+#include "hash.h"
+#include "../../include/data_stream.h"
+#include "http2_msg_format.h"
+#include "hpack.h"
+
+// HEADERS/CONTINUATION帧需要完整缓存后解码，超出该长度的头部块无法解码，HPACK动态表随之重置
+#define HTTP2_MAX_HEADER_BLOCK_LEN (64 * 1024)
+
+// 每个方向同时跟踪的流上限，以及未关闭的流被淘汰前的最长存活时间
+#define HTTP2_MAX_STREAMS 1024
+#define HTTP2_STREAM_TIMEOUT_NS (60 * 1000000000ULL)
+
+struct http2_stream_s {
+    H_HANDLE;
+    uint32_t stream_id;
+    struct http2_msg_s *msg;
+};
+
+/**
+ * Parse state of one direction of a connection, kept in data_stream_s.proto_ctx.
+ */
+struct http2_conn_ctx_s {
+    struct hpack_table_s hpack;
+    struct http2_stream_s *streams;
+    char preface_checked;
+
+    // header block split into HEADERS/PUSH_PROMISE + CONTINUATION frames
+    char hdr_pending;
+    char hdr_end_stream;
+    uint32_t hdr_stream_id;
+    struct http2_stream_s *hdr_stream;  // NULL if the fields of the block are not used
+    uint8_t *hdr_block;
+    size_t hdr_block_len;
+};
+
+void free_http2_conn_ctx(struct http2_conn_ctx_s *ctx);
+
+size_t http2_find_frame_boundary(enum message_type_t msg_type, struct raw_data_s *raw_data);
+
+/**
+ * Parse HTTP/2 frames from raw_data->current_pos until a stream is closed in this direction.
+ * HEADERS/CONTINUATION are HPACK decoded in order to keep the dynamic table of the connection in sync,
+ * DATA and other frames are skipped by length, a frame longer than raw_data is skipped via raw_data->skip_len.
+ *
+ * @param msg_type request or response
+ * @param raw_data
+ * @param ctx per direction parse state, created at the 1st call
+ * @param frame_data a http2_msg_s of the closed stream
+ * @return STATE_SUCCESS if a stream is closed, STATE_IGNORE if a frame is consumed without output
+ */
+parse_state_t http2_parse_frame(enum message_type_t msg_type, struct raw_data_s *raw_data,
+                                struct http2_conn_ctx_s **ctx, struct frame_data_s **frame_data);
+
+#endif
@@ -0,0 +1,101 @@
+/*******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-07-28
+ * Description:
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "common.h"
+#include "kafka_parser.h"
+#include "kafka_matcher.h"
+
+static void add_kafka_record_into_buf(const struct kafka_msg_s *req_msg, struct kafka_msg_s *resp_msg,
+                                      struct record_buf_s *record_buf)
+{
+    struct kafka_record_s *record;
+    struct record_data_s *record_data;
+
+    record = init_kafka_record();
+    if (record == NULL) {
+        ERROR("[KAFKA MATCHER] Failed to malloc kafka_record.\n");
+        return;
+    }
+    record->api_key = req_msg->api_key;
+    record->api_version = req_msg->api_version;
+    (void)strncpy(record->topic, req_msg->topic, KAFKA_TOPIC_LEN - 1);
+    record->error_code = kafka_parse_resp_error_code(req_msg, resp_msg);
+    record->req_timestamp_ns = req_msg->timestamp_ns;
+    record->resp_timestamp_ns = resp_msg->timestamp_ns;
+
+    record_data = (struct record_data_s *) malloc(sizeof(struct record_data_s));
+    if (record_data == NULL) {
+        ERROR("[KAFKA MATCHER] Failed to malloc record_data.\n");
+        free_kafka_record(record);
+        return;
+    }
+    memset(record_data, 0, sizeof(struct record_data_s));
+    record_data->record = record;
+    record_data->latency = record->resp_timestamp_ns - record->req_timestamp_ns;
+
+    // Produce/Fetch按topic统计，其余api按api名称统计
+    if (record->topic[0] != 0) {
+        (void)snprintf(record_data->api, L7_API_LEN, "%s %s", kafka_api_name(record->api_key), record->topic);
+    } else {
+        (void)snprintf(record_data->api, L7_API_LEN, "%s", kafka_api_name(record->api_key));
+    }
+    record_data->is_err = (record->error_code != 0);
+
+    if (record_data->is_err) {
+        ++record_buf->err_count;
+    }
+    record_buf->records[record_buf->record_buf_size] = record_data;
+    ++record_buf->record_buf_size;
+}
+
+void kafka_match_frames(struct frame_buf_s *req_frames, struct frame_buf_s *resp_frames,
+                        struct record_buf_s *record_buf)
+{
+    record_buf->err_count = 0;
+    record_buf->record_buf_size = 0;
+    record_buf->req_count = req_frames->frame_buf_size;
+    record_buf->resp_count = resp_frames->frame_buf_size;
+
+    while (resp_frames->current_pos < resp_frames->frame_buf_size) {
+        struct kafka_msg_s *resp_msg;
+        struct kafka_msg_s *req_msg = NULL;
+        size_t req_pos;
+
+        if (record_buf->record_buf_size >= RECORD_BUF_SIZE) {
+            break;
+        }
+
+        resp_msg = (struct kafka_msg_s *) resp_frames->frames[resp_frames->current_pos]->frame;
+        for (req_pos = req_frames->current_pos; req_pos < req_frames->frame_buf_size; ++req_pos) {
+            struct kafka_msg_s *msg = (struct kafka_msg_s *) req_frames->frames[req_pos]->frame;
+            if (msg->has_resp && msg->correlation_id == resp_msg->correlation_id) {
+                req_msg = msg;
+                break;
+            }
+        }
+
+        // 请求一定先于响应完整发出，找不到对应请求说明请求已丢失，丢弃该响应
+        if (req_msg == NULL) {
+            ++resp_frames->current_pos;
+            continue;
+        }
+
+        add_kafka_record_into_buf(req_msg, resp_msg, record_buf);
+        req_frames->current_pos = req_pos + 1;
+        ++resp_frames->current_pos;
+    }
+}
@@ -0,0 +1,35 @@
+/*******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-07-28
+ * Description:
+ ******************************************************************************/
+
+#ifndef __KAFKA_MATCHER_H__
+#define __KAFKA_MATCHER_H__
+
+#pragma once
+
+#include "../../include/data_stream.h"
+#include "kafka_msg_format.h"
+
+/**
+ * Match kafka requests and responses by correlation id.
+ * Broker在同一连接上按请求顺序返回响应，匹配到某个响应时，其之前未得到响应的请求（如acks = 0的Produce）一并丢弃。
+ *
+ * @param req_frames
+ * @param resp_frames
+ * @param record_buf
+ */
+void kafka_match_frames(struct frame_buf_s *req_frames, struct frame_buf_s *resp_frames,
+                        struct record_buf_s *record_buf);
+
+#endif
@@ -0,0 +1,145 @@
+/*******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-07-28
+ * Description:
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "common.h"
+#include "kafka_msg_format.h"
+
+struct kafka_api_s {
+    const char *name;
+    int16_t flexible_version;   // first flexible version, -1 if never
+};
+
+#define KAFKA_API(key, api_name, flexible) [key] = {api_name, flexible}
+
+// 未列出的api（新增的api均从版本0开始使用flexible versions）
+#define KAFKA_DEFAULT_FLEXIBLE_VERSION 0
+
+static const struct kafka_api_s kafka_apis[KAFKA_MAX_API_KEY + 1] = {
+    KAFKA_API(0, "Produce", 9),
+    KAFKA_API(1, "Fetch", 12),
+    KAFKA_API(2, "ListOffsets", 6),
+    KAFKA_API(3, "Metadata", 9),
+    KAFKA_API(4, "LeaderAndIsr", 4),
+    KAFKA_API(5, "StopReplica", 2),
+    KAFKA_API(6, "UpdateMetadata", 6),
+    KAFKA_API(7, "ControlledShutdown", 3),
+    KAFKA_API(8, "OffsetCommit", 8),
+    KAFKA_API(9, "OffsetFetch", 6),
+    KAFKA_API(10, "FindCoordinator", 3),
+    KAFKA_API(11, "JoinGroup", 6),
+    KAFKA_API(12, "Heartbeat", 4),
+    KAFKA_API(13, "LeaveGroup", 4),
+    KAFKA_API(14, "SyncGroup", 4),
+    KAFKA_API(15, "DescribeGroups", 5),
+    KAFKA_API(16, "ListGroups", 3),
+    KAFKA_API(17, "SaslHandshake", -1),
+    KAFKA_API(18, "ApiVersions", 3),
+    KAFKA_API(19, "CreateTopics", 5),
+    KAFKA_API(20, "DeleteTopics", 4),
+    KAFKA_API(21, "DeleteRecords", 2),
+    KAFKA_API(22, "InitProducerId", 2),
+    KAFKA_API(23, "OffsetForLeaderEpoch", 4),
+    KAFKA_API(24, "AddPartitionsToTxn", 3),
+    KAFKA_API(25, "AddOffsetsToTxn", 3),
+    KAFKA_API(26, "EndTxn", 3),
+    KAFKA_API(27, "WriteTxnMarkers", 1),
+    KAFKA_API(28, "TxnOffsetCommit", 3),
+    KAFKA_API(29, "DescribeAcls", 2),
+    KAFKA_API(30, "CreateAcls", 2),
+    KAFKA_API(31, "DeleteAcls", 2),
+    KAFKA_API(32, "DescribeConfigs", 4),
+    KAFKA_API(33, "AlterConfigs", 2),
+    KAFKA_API(34, "AlterReplicaLogDirs", 2),
+    KAFKA_API(35, "DescribeLogDirs", 2),
+    KAFKA_API(36, "SaslAuthenticate", 2),
+    KAFKA_API(37, "CreatePartitions", 2),
+    KAFKA_API(38, "CreateDelegationToken", 2),
+    KAFKA_API(39, "RenewDelegationToken", 2),
+    KAFKA_API(40, "ExpireDelegationToken", 2),
+    KAFKA_API(41, "DescribeDelegationToken", 2),
+    KAFKA_API(42, "DeleteGroups", 2),
+    KAFKA_API(43, "ElectLeaders", 2),
+    KAFKA_API(44, "IncrementalAlterConfigs", 1),
+    KAFKA_API(45, "AlterPartitionReassignments", 0),
+    KAFKA_API(46, "ListPartitionReassignments", 0),
+    KAFKA_API(47, "OffsetDelete", -1),
+    KAFKA_API(48, "DescribeClientQuotas", 1),
+    KAFKA_API(49, "AlterClientQuotas", 1),
+    KAFKA_API(50, "DescribeUserScramCredentials", 0),
+    KAFKA_API(51, "AlterUserScramCredentials", 0),
+};
+
+const char *kafka_api_name(int16_t api_key)
+{
+    if (api_key < 0 || api_key > KAFKA_MAX_API_KEY || kafka_apis[api_key].name == NULL) {
+        return "Unknown";
+    }
+    return kafka_apis[api_key].name;
+}
+
+bool kafka_is_flexible(int16_t api_key, int16_t api_version)
+{
+    int16_t flexible_version = KAFKA_DEFAULT_FLEXIBLE_VERSION;
+
+    if (api_key < 0 || api_key > KAFKA_MAX_API_KEY) {
+        return false;
+    }
+    if (kafka_apis[api_key].name != NULL) {
+        flexible_version = kafka_apis[api_key].flexible_version;
+    }
+    return flexible_version >= 0 && api_version >= flexible_version;
+}
+
+struct kafka_msg_s *init_kafka_msg(void)
+{
+    struct kafka_msg_s *msg = (struct kafka_msg_s *) malloc(sizeof(struct kafka_msg_s));
+    if (msg == NULL) {
+        return NULL;
+    }
+    memset(msg, 0, sizeof(struct kafka_msg_s));
+    msg->has_resp = true;
+    return msg;
+}
+
+void free_kafka_msg(struct kafka_msg_s *msg)
+{
+    if (msg == NULL) {
+        return;
+    }
+    if (msg->resp_head != NULL) {
+        free(msg->resp_head);
+    }
+    free(msg);
+}
+
+struct kafka_record_s *init_kafka_record(void)
+{
+    struct kafka_record_s *record = (struct kafka_record_s *) malloc(sizeof(struct kafka_record_s));
+    if (record == NULL) {
+        return NULL;
+    }
+    memset(record, 0, sizeof(struct kafka_record_s));
+    return record;
+}
+
+void free_kafka_record(struct kafka_record_s *record)
+{
+    if (record == NULL) {
+        return;
+    }
+    free(record);
+}
@@ -0,0 +1,95 @@
+/*******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-07-28
+ * Description:
+ ******************************************************************************/
+
+#ifndef __KAFKA_MSG_FORMAT_H__
+#define __KAFKA_MSG_FORMAT_H__
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../../include/data_stream.h"
+
+// References kafka spec:
+// https://kafka.apache.org/protocol.html#protocol_messages
+#define KAFKA_LENGTH_SIZE 4
+#define KAFKA_REQ_HEADER_MIN_LEN 8     // api_key(2) + api_version(2) + correlation_id(4)
+#define KAFKA_RESP_HEADER_MIN_LEN 4    // correlation_id(4)
+#define KAFKA_MAX_MSG_LEN (100 * 1024 * 1024)
+
+// 解析请求/响应时最多查看的报文头部字节数，record batch等报文体按长度跳过，解析开销与消息大小无关
+#define KAFKA_MSG_HEAD_LEN 512
+
+// topic名称最长249字节，超出部分截断
+#define KAFKA_TOPIC_LEN 128
+
+#define KAFKA_MAX_API_KEY 74
+
+enum kafka_api_key_t {
+    KAFKA_API_PRODUCE = 0,
+    KAFKA_API_FETCH = 1,
+    KAFKA_API_VERSIONS = 18,
+};
+
+/**
+ * Name of the api key, eg. "Produce".
+ */
+const char *kafka_api_name(int16_t api_key);
+
+/**
+ * Is the message of api_key/api_version encoded with flexible versions(compact strings/arrays and tagged fields).
+ */
+bool kafka_is_flexible(int16_t api_key, int16_t api_version);
+
+/**
+ * Kafka request or response frame.
+ * 请求只保存报文头和第一个topic；响应不携带api_key，拷贝报文体开头的少量字节，待匹配到请求后再解析错误码。
+ */
+struct kafka_msg_s {
+    u64 timestamp_ns;
+    int32_t correlation_id;
+
+    // request only
+    int16_t api_key;
+    int16_t api_version;
+    bool has_resp;      // Produce acks = 0 时没有响应
+    char topic[KAFKA_TOPIC_LEN];
+
+    // response only, head of the response body, starting right after correlation_id
+    struct raw_data_s *resp_head;
+};
+
+struct kafka_msg_s *init_kafka_msg(void);
+
+void free_kafka_msg(struct kafka_msg_s *msg);
+
+/**
+ * Kafka record, req & resp metadata copied from frames.
+ */
+struct kafka_record_s {
+    int16_t api_key;
+    int16_t api_version;
+    char topic[KAFKA_TOPIC_LEN];
+    int16_t error_code;
+    u64 req_timestamp_ns;
+    u64 resp_timestamp_ns;
+};
+
+struct kafka_record_s *init_kafka_record(void);
+
+void free_kafka_record(struct kafka_record_s *record);
+
+#endif
@@ -0,0 +1,449 @@
+/*******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-07-28
+ * Description:
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "common.h"
+#include "kafka_parser.h"
+#include "../utils/macros.h"
+#include "../utils/binary_decoder.h"
+
+#define KAFKA_UVARINT_MAX_BYTES 5
+#define KAFKA_UUID_LEN 16
+
+// Produce请求从v3开始携带transactional_id
+#define KAFKA_PRODUCE_TXN_ID_VERSION 3
+
+// Fetch请求各字段的起始版本
+#define KAFKA_FETCH_MAX_BYTES_VERSION 3
+#define KAFKA_FETCH_ISOLATION_VERSION 4
+#define KAFKA_FETCH_SESSION_VERSION 7
+#define KAFKA_FETCH_TOPIC_ID_VERSION 13
+#define KAFKA_FETCH_NO_REPLICA_ID_VERSION 15
+
+// Fetch响应从v1开始携带throttle_time_ms，从v7开始携带顶层error_code和session_id
+#define KAFKA_FETCH_RESP_THROTTLE_VERSION 1
+
+// unsigned varint, used by flexible versions
+static parse_state_t kafka_extract_uvarint(struct raw_data_s *raw_data, uint32_t *res)
+{
+    uint32_t value = 0;
+    char c;
+    parse_state_t state;
+
+    for (int i = 0; i < KAFKA_UVARINT_MAX_BYTES; i++) {
+        state = decoder_extract_char(raw_data, &c);
+        if (state != STATE_SUCCESS) {
+            return state;
+        }
+        value |= (uint32_t)((uint8_t)c & 0x7f) << (i * 7);
+        if (((uint8_t)c & 0x80) == 0) {
+            *res = value;
+            return STATE_SUCCESS;
+        }
+    }
+    return STATE_INVALID;
+}
+
+static parse_state_t kafka_extract_array_len(struct raw_data_s *raw_data, bool flexible, int32_t *len)
+{
+    uint32_t compact_len;
+    parse_state_t state;
+
+    if (!flexible) {
+        return decoder_extract_int32_t(raw_data, len);
+    }
+
+    // compact array: N + 1, 0 for null
+    state = kafka_extract_uvarint(raw_data, &compact_len);
+    if (state != STATE_SUCCESS) {
+        return state;
+    }
+    *len = (int32_t)compact_len - 1;
+    return STATE_SUCCESS;
+}
+
+/**
+ * Extract (nullable) string, truncated to buf_size - 1. buf can be NULL to skip the string.
+ */
+static parse_state_t kafka_extract_string(struct raw_data_s *raw_data, bool flexible, char *buf, size_t buf_size)
+{
+    int32_t len;
+    int16_t len16;
+    uint32_t compact_len;
+    size_t copy_len;
+    parse_state_t state;
+
+    if (flexible) {
+        state = kafka_extract_uvarint(raw_data, &compact_len);
+        len = (int32_t)compact_len - 1;
+    } else {
+        state = decoder_extract_int16_t(raw_data, &len16);
+        len = len16;
+    }
+    if (state != STATE_SUCCESS) {
+        return state;
+    }
+    if (len < 0) {
+        len = 0;
+    }
+
+    if ((raw_data->data_len - raw_data->current_pos) < (size_t)len) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+    if (buf != NULL && buf_size > 0) {
+        copy_len = ((size_t)len < buf_size - 1) ? (size_t)len : buf_size - 1;
+        memcpy(buf, &raw_data->data[raw_data->current_pos], copy_len);
+        buf[copy_len] = '\0';
+    }
+    return decoder_extract_prefix_ignore(raw_data, (size_t)len);
+}
+
+static parse_state_t kafka_skip_tagged_fields(struct raw_data_s *raw_data)
+{
+    uint32_t num;
+    uint32_t tag;
+    uint32_t size;
+    parse_state_t state;
+
+    state = kafka_extract_uvarint(raw_data, &num);
+    if (state != STATE_SUCCESS) {
+        return state;
+    }
+    for (uint32_t i = 0; i < num; i++) {
+        state = kafka_extract_uvarint(raw_data, &tag);
+        if (state != STATE_SUCCESS) {
+            return state;
+        }
+        state = kafka_extract_uvarint(raw_data, &size);
+        if (state != STATE_SUCCESS) {
+            return state;
+        }
+        state = decoder_extract_prefix_ignore(raw_data, size);
+        if (state != STATE_SUCCESS) {
+            return state;
+        }
+    }
+    return STATE_SUCCESS;
+}
+
+#define KAFKA_CHECK_STATE(expr)             \
+    do {                                    \
+        parse_state_t __state = (expr);     \
+        if (__state != STATE_SUCCESS) {     \
+            return __state;                 \
+        }                                   \
+    } while (0)
+
+static parse_state_t kafka_parse_topic_uuid(struct raw_data_s *raw_data, char *topic)
+{
+    if ((raw_data->data_len - raw_data->current_pos) < KAFKA_UUID_LEN) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+    for (int i = 0; i < KAFKA_UUID_LEN; i++) {
+        (void)snprintf(topic + i * 2, KAFKA_TOPIC_LEN - i * 2, "%02x",
+                       (uint8_t)raw_data->data[raw_data->current_pos + i]);
+    }
+    return decoder_extract_prefix_ignore(raw_data, KAFKA_UUID_LEN);
+}
+
+static parse_state_t kafka_parse_produce_req(struct raw_data_s *raw_data, bool flexible, struct kafka_msg_s *msg)
+{
+    int16_t acks;
+    int32_t timeout_ms;
+    int32_t topic_num;
+
+    if (msg->api_version >= KAFKA_PRODUCE_TXN_ID_VERSION) {
+        KAFKA_CHECK_STATE(kafka_extract_string(raw_data, flexible, NULL, 0));
+    }
+    KAFKA_CHECK_STATE(decoder_extract_int16_t(raw_data, &acks));
+    KAFKA_CHECK_STATE(decoder_extract_int32_t(raw_data, &timeout_ms));
+
+    // acks = 0时broker不返回响应
+    if (acks == 0) {
+        msg->has_resp = false;
+    }
+
+    KAFKA_CHECK_STATE(kafka_extract_array_len(raw_data, flexible, &topic_num));
+    if (topic_num <= 0) {
+        return STATE_SUCCESS;
+    }
+    return kafka_extract_string(raw_data, flexible, msg->topic, KAFKA_TOPIC_LEN);
+}
+
+static parse_state_t kafka_parse_fetch_req(struct raw_data_s *raw_data, bool flexible, struct kafka_msg_s *msg)
+{
+    int32_t i32;
+    int8_t i8;
+    int32_t topic_num;
+
+    if (msg->api_version < KAFKA_FETCH_NO_REPLICA_ID_VERSION) {
+        KAFKA_CHECK_STATE(decoder_extract_int32_t(raw_data, &i32));     // replica_id
+    }
+    KAFKA_CHECK_STATE(decoder_extract_int32_t(raw_data, &i32));         // max_wait_ms
+    KAFKA_CHECK_STATE(decoder_extract_int32_t(raw_data, &i32));         // min_bytes
+    if (msg->api_version >= KAFKA_FETCH_MAX_BYTES_VERSION) {
+        KAFKA_CHECK_STATE(decoder_extract_int32_t(raw_data, &i32));     // max_bytes
+    }
+    if (msg->api_version >= KAFKA_FETCH_ISOLATION_VERSION) {
+        KAFKA_CHECK_STATE(decoder_extract_int8_t(raw_data, &i8));       // isolation_level
+    }
+    if (msg->api_version >= KAFKA_FETCH_SESSION_VERSION) {
+        KAFKA_CHECK_STATE(decoder_extract_int32_t(raw_data, &i32));     // session_id
+        KAFKA_CHECK_STATE(decoder_extract_int32_t(raw_data, &i32));     // session_epoch
+    }
+
+    KAFKA_CHECK_STATE(kafka_extract_array_len(raw_data, flexible, &topic_num));
+    if (topic_num <= 0) {
+        return STATE_SUCCESS;
+    }
+    if (msg->api_version >= KAFKA_FETCH_TOPIC_ID_VERSION) {
+        return kafka_parse_topic_uuid(raw_data, msg->topic);
+    }
+    return kafka_extract_string(raw_data, flexible, msg->topic, KAFKA_TOPIC_LEN);
+}
+
+static parse_state_t kafka_parse_req(struct raw_data_s *raw_data, struct kafka_msg_s *msg)
+{
+    bool flexible;
+
+    KAFKA_CHECK_STATE(decoder_extract_int16_t(raw_data, &msg->api_key));
+    KAFKA_CHECK_STATE(decoder_extract_int16_t(raw_data, &msg->api_version));
+    KAFKA_CHECK_STATE(decoder_extract_int32_t(raw_data, &msg->correlation_id));
+    if (msg->api_key < 0 || msg->api_key > KAFKA_MAX_API_KEY || msg->api_version < 0 || msg->correlation_id < 0) {
+        return STATE_INVALID;
+    }
+
+    // request header v1+: client_id始终为非compact的nullable string
+    KAFKA_CHECK_STATE(kafka_extract_string(raw_data, false, NULL, 0));
+    flexible = kafka_is_flexible(msg->api_key, msg->api_version);
+    if (flexible) {
+        KAFKA_CHECK_STATE(kafka_skip_tagged_fields(raw_data));
+    }
+
+    switch (msg->api_key) {
+        case KAFKA_API_PRODUCE:
+            return kafka_parse_produce_req(raw_data, flexible, msg);
+        case KAFKA_API_FETCH:
+            return kafka_parse_fetch_req(raw_data, flexible, msg);
+        default:
+            return STATE_SUCCESS;
+    }
+}
+
+static bool kafka_valid_len(int32_t len, enum message_type_t msg_type)
+{
+    int32_t min_len = (msg_type == MESSAGE_REQUEST) ? KAFKA_REQ_HEADER_MIN_LEN : KAFKA_RESP_HEADER_MIN_LEN;
+    return len >= min_len && len <= KAFKA_MAX_MSG_LEN;
+}
+
+size_t kafka_find_frame_boundary(enum message_type_t msg_type, struct raw_data_s *raw_data)
+{
+    const char *data = raw_data->data;
+
+    for (size_t i = raw_data->current_pos; i + KAFKA_LENGTH_SIZE + KAFKA_REQ_HEADER_MIN_LEN <= raw_data->data_len; ++i) {
+        int32_t len = big_endian_bytes_to_int32_t(&data[i]);
+        if (!kafka_valid_len(len, msg_type)) {
+            continue;
+        }
+
+        if (msg_type == MESSAGE_RESPONSE) {
+            // 响应只有correlation_id，无法可靠地重新同步，只接受当前位置
+            if (i == raw_data->current_pos && big_endian_bytes_to_int32_t(&data[i + KAFKA_LENGTH_SIZE]) >= 0) {
+                return i;
+            }
+            continue;
+        }
+
+        int16_t api_key = big_endian_bytes_to_int16_t(&data[i + KAFKA_LENGTH_SIZE]);
+        int16_t api_version = big_endian_bytes_to_int16_t(&data[i + KAFKA_LENGTH_SIZE + 2]);
+        int32_t correlation_id = big_endian_bytes_to_int32_t(&data[i + KAFKA_LENGTH_SIZE + 4]);
+        if (api_key >= 0 && api_key <= KAFKA_MAX_API_KEY && api_version >= 0 && correlation_id >= 0) {
+            return i;
+        }
+    }
+
+    // 数据不足以判断时，保留当前位置等待更多数据
+    if (raw_data->current_pos < raw_data->data_len &&
+        raw_data->data_len - raw_data->current_pos < KAFKA_LENGTH_SIZE + KAFKA_REQ_HEADER_MIN_LEN) {
+        return raw_data->current_pos;
+    }
+    return PARSER_INVALID_BOUNDARY_INDEX;
+}
+
+parse_state_t kafka_parse_frame(enum message_type_t msg_type, struct raw_data_s *raw_data,
+                                struct frame_data_s **frame_data)
+{
+    struct kafka_msg_s *msg;
+    size_t start = raw_data->current_pos;
+    size_t body_start;
+    size_t avail;
+    size_t head_len;
+    int32_t len;
+    parse_state_t state;
+
+    if (raw_data->data_len == 0 || start >= raw_data->data_len) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+    if (raw_data->data_len - start < KAFKA_LENGTH_SIZE + KAFKA_RESP_HEADER_MIN_LEN) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+
+    len = big_endian_bytes_to_int32_t(&raw_data->data[start]);
+    if (!kafka_valid_len(len, msg_type)) {
+        raw_data->current_pos = start + 1;
+        return STATE_INVALID;
+    }
+
+    // 只要求报文头部就绪，报文体按长度跳过
+    body_start = start + KAFKA_LENGTH_SIZE;
+    head_len = ((size_t)len < KAFKA_MSG_HEAD_LEN) ? (size_t)len : KAFKA_MSG_HEAD_LEN;
+    if (raw_data->data_len - body_start < head_len) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+
+    msg = init_kafka_msg();
+    if (msg == NULL) {
+        ERROR("[Kafka parser] Failed to malloc kafka_msg.\n");
+        return STATE_INVALID;
+    }
+    msg->timestamp_ns = raw_data->timestamp_ns;
+
+    raw_data->current_pos = body_start;
+    if (msg_type == MESSAGE_REQUEST) {
+        state = kafka_parse_req(raw_data, msg);
+        // topic位于头部之外时不影响请求本身的解析
+        if (state == STATE_NEEDS_MORE_DATA) {
+            state = STATE_SUCCESS;
+        }
+    } else {
+        state = decoder_extract_int32_t(raw_data, &msg->correlation_id);
+        if (state == STATE_SUCCESS) {
+            state = decoder_extract_raw_data_with_len(raw_data, head_len - KAFKA_RESP_HEADER_MIN_LEN, &msg->resp_head);
+        }
+    }
+    if (state != STATE_SUCCESS) {
+        free_kafka_msg(msg);
+        raw_data->current_pos = (state == STATE_INVALID) ? start + 1 : start;
+        return state;
+    }
+
+    raw_data->current_pos = body_start;
+    avail = raw_data->data_len - body_start;
+    if ((size_t)len <= avail) {
+        (void)decoder_extract_prefix_ignore(raw_data, (size_t)len);
+    } else {
+        raw_data->current_pos = raw_data->data_len;
+        raw_data->skip_len = (size_t)len - avail;
+    }
+
+    *frame_data = (struct frame_data_s *) malloc(sizeof(struct frame_data_s));
+    if ((*frame_data) == NULL) {
+        ERROR("[Kafka parser] Failed to malloc frame_data.\n");
+        free_kafka_msg(msg);
+        return STATE_INVALID;
+    }
+    (*frame_data)->msg_type = msg_type;
+    (*frame_data)->timestamp_ns = msg->timestamp_ns;
+    (*frame_data)->frame = msg;
+    return STATE_SUCCESS;
+}
+
+static parse_state_t kafka_parse_produce_resp_error(struct raw_data_s *head, bool flexible, int16_t *error_code)
+{
+    int32_t topic_num;
+    int32_t partition_num;
+    int32_t partition;
+
+    KAFKA_CHECK_STATE(kafka_extract_array_len(head, flexible, &topic_num));
+    if (topic_num <= 0) {
+        return STATE_SUCCESS;
+    }
+    KAFKA_CHECK_STATE(kafka_extract_string(head, flexible, NULL, 0));
+    KAFKA_CHECK_STATE(kafka_extract_array_len(head, flexible, &partition_num));
+    if (partition_num <= 0) {
+        return STATE_SUCCESS;
+    }
+    KAFKA_CHECK_STATE(decoder_extract_int32_t(head, &partition));
+    return decoder_extract_int16_t(head, error_code);
+}
+
+static parse_state_t kafka_parse_fetch_resp_error(struct raw_data_s *head, bool flexible, int16_t api_version,
+                                                  int16_t *error_code)
+{
+    int32_t i32;
+    int32_t topic_num;
+    int32_t partition_num;
+
+    if (api_version >= KAFKA_FETCH_RESP_THROTTLE_VERSION) {
+        KAFKA_CHECK_STATE(decoder_extract_int32_t(head, &i32));     // throttle_time_ms
+    }
+    if (api_version >= KAFKA_FETCH_SESSION_VERSION) {
+        KAFKA_CHECK_STATE(decoder_extract_int16_t(head, error_code));
+        if (*error_code != 0) {
+            return STATE_SUCCESS;
+        }
+        KAFKA_CHECK_STATE(decoder_extract_int32_t(head, &i32));     // session_id
+    }
+
+    KAFKA_CHECK_STATE(kafka_extract_array_len(head, flexible, &topic_num));
+    if (topic_num <= 0) {
+        return STATE_SUCCESS;
+    }
+    if (api_version >= KAFKA_FETCH_TOPIC_ID_VERSION) {
+        KAFKA_CHECK_STATE(decoder_extract_prefix_ignore(head, KAFKA_UUID_LEN));
+    } else {
+        KAFKA_CHECK_STATE(kafka_extract_string(head, flexible, NULL, 0));
+    }
+    KAFKA_CHECK_STATE(kafka_extract_array_len(head, flexible, &partition_num));
+    if (partition_num <= 0) {
+        return STATE_SUCCESS;
+    }
+    KAFKA_CHECK_STATE(decoder_extract_int32_t(head, &i32));         // partition_index
+    return decoder_extract_int16_t(head, error_code);
+}
+
+int16_t kafka_parse_resp_error_code(const struct kafka_msg_s *req_msg, struct kafka_msg_s *resp_msg)
+{
+    struct raw_data_s *head = resp_msg->resp_head;
+    int16_t error_code = 0;
+    bool flexible;
+
+    if (head == NULL) {
+        return 0;
+    }
+    head->current_pos = 0;
+
+    flexible = kafka_is_flexible(req_msg->api_key, req_msg->api_version);
+
+    // response header v1带tagged fields，ApiVersions响应例外，始终使用header v0
+    if (flexible && req_msg->api_key != KAFKA_API_VERSIONS) {
+        if (kafka_skip_tagged_fields(head) != STATE_SUCCESS) {
+            return 0;
+        }
+    }
+
+    switch (req_msg->api_key) {
+        case KAFKA_API_PRODUCE:
+            (void)kafka_parse_produce_resp_error(head, flexible, &error_code);
+            break;
+        case KAFKA_API_FETCH:
+            (void)kafka_parse_fetch_resp_error(head, flexible, req_msg->api_version, &error_code);
+            break;
+        default:
+            break;
+    }
+    return error_code;
+}
@@ -0,0 +1,49 @@
+/*******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-07-28
+ * Description:
+ ******************************************************************************/
+
+#ifndef __KAFKA_PARSER_H__
+#define __KAFKA_PARSER_H__
+
+#pragma once
+
+#include "../../include/data_stream.h"
+#include "kafka_msg_format.h"
+
+size_t kafka_find_frame_boundary(enum message_type_t msg_type, struct raw_data_s *raw_data);
+
+/**
+ * Parse one size-prefixed kafka message from raw_data->current_pos.
+ * Only the header (and the 1st topic of Produce/Fetch requests) is decoded, the rest of the message
+ * including record batches is skipped by length, a message longer than raw_data is skipped via raw_data->skip_len.
+ *
+ * @param msg_type request or response
+ * @param raw_data
+ * @param frame_data
+ * @return
+ */
+parse_state_t kafka_parse_frame(enum message_type_t msg_type, struct raw_data_s *raw_data,
+                                struct frame_data_s **frame_data);
+
+/**
+ * Decode the error code of a response by the api of the matched request.
+ * Produce/Fetch: the 1st non-zero partition error code of the 1st topic; other apis: 0.
+ *
+ * @param req_msg matched request
+ * @param resp_msg response
+ * @return error code, 0 if no error or not decodable
+ */
+int16_t kafka_parse_resp_error_code(const struct kafka_msg_s *req_msg, struct kafka_msg_s *resp_msg);
+
+#endif
@@ -0,0 +1,159 @@
+/*******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-07-26
+ * Description:
+ ******************************************************************************/
+
+#include <string.h>
+#include "common.h"
+#include "mysql_matcher.h"
+
+#define MYSQL_FRAME(frame_buf, pos) ((struct mysql_packet_msg_s *) ((frame_buf)->frames[(pos)]->frame))
+
+/**
+ * Is the response [first, end) completed, only used for the last request which has no successor yet.
+ */
+static bool mysql_resp_completed(struct frame_buf_s *resp_frames, size_t first, size_t end)
+{
+    struct mysql_packet_msg_s *first_msg = MYSQL_FRAME(resp_frames, first);
+    struct mysql_packet_msg_s *last_msg = MYSQL_FRAME(resp_frames, end - 1);
+    size_t eof_count = 0;
+
+    switch (last_msg->type) {
+        case MYSQL_PACKET_RESP_ERR:
+            return true;
+        case MYSQL_PACKET_RESP_FIRST:
+            // OK、ERR或COM_STMT_PREPARE_OK；列数或LOCAL INFILE请求之后还有后续报文
+            return last_msg->header == MYSQL_RESP_OK || last_msg->header == MYSQL_RESP_ERR ||
+                   last_msg->header == MYSQL_RESP_EOF;
+        case MYSQL_PACKET_RESP_EOF:
+            break;
+        default:
+            return false;
+    }
+
+    if (first_msg->type != MYSQL_PACKET_RESP_FIRST || first_msg->column_count == 0) {
+        return true;
+    }
+
+    // 结果集：列定义之后的EOF（seq_id = 列数 + 2）不是结束标志，行数据之后的EOF才是
+    for (size_t i = first; i < end; i++) {
+        if (MYSQL_FRAME(resp_frames, i)->type == MYSQL_PACKET_RESP_EOF) {
+            ++eof_count;
+        }
+    }
+    if (eof_count == 1 && last_msg->seq_id == (uint8_t)(first_msg->column_count + 2)) {
+        return false;
+    }
+    return true;
+}
+
+static void add_mysql_record_into_buf(const struct mysql_packet_msg_s *req_msg, struct frame_buf_s *resp_frames,
+                                      size_t first, size_t end, struct record_buf_s *record_buf)
+{
+    struct mysql_record_s *record;
+    struct record_data_s *record_data;
+
+    record = init_mysql_record();
+    if (record == NULL) {
+        ERROR("[MYSQL MATCHER] Failed to malloc mysql_record.\n");
+        return;
+    }
+    (void)strncpy(record->api, req_msg->api, L7_API_LEN - 1);
+    record->command = req_msg->header;
+    record->req_timestamp_ns = req_msg->timestamp_ns;
+    record->resp_timestamp_ns = MYSQL_FRAME(resp_frames, end - 1)->timestamp_ns;
+    for (size_t i = first; i < end; i++) {
+        if (MYSQL_FRAME(resp_frames, i)->header == MYSQL_RESP_ERR) {
+            record->is_err = true;
+            break;
+        }
+    }
+
+    record_data = (struct record_data_s *) malloc(sizeof(struct record_data_s));
+    if (record_data == NULL) {
+        ERROR("[MYSQL MATCHER] Failed to malloc record_data.\n");
+        free_mysql_record(record);
+        return;
+    }
+    memset(record_data, 0, sizeof(struct record_data_s));
+    record_data->record = record;
+    record_data->latency = record->resp_timestamp_ns - record->req_timestamp_ns;
+    (void)strncpy(record_data->api, record->api, L7_API_LEN - 1);
+    record_data->is_err = record->is_err;
+
+    if (record->is_err) {
+        ++record_buf->err_count;
+    }
+    record_buf->records[record_buf->record_buf_size] = record_data;
+    ++record_buf->record_buf_size;
+}
+
+void mysql_match_frames(struct frame_buf_s *req_frames, struct frame_buf_s *resp_frames,
+                        struct record_buf_s *record_buf)
+{
+    record_buf->err_count = 0;
+    record_buf->record_buf_size = 0;
+    record_buf->req_count = req_frames->frame_buf_size;
+    record_buf->resp_count = resp_frames->frame_buf_size;
+
+    while (req_frames->current_pos < req_frames->frame_buf_size) {
+        struct mysql_packet_msg_s *req_msg;
+        struct mysql_packet_msg_s *next_req_msg = NULL;
+        size_t first;
+        size_t end;
+
+        if (record_buf->record_buf_size >= RECORD_BUF_SIZE) {
+            break;
+        }
+
+        req_msg = MYSQL_FRAME(req_frames, req_frames->current_pos);
+        if (req_frames->current_pos + 1 < req_frames->frame_buf_size) {
+            next_req_msg = MYSQL_FRAME(req_frames, req_frames->current_pos + 1);
+        }
+
+        // 早于请求的响应，说明其对应的请求已丢失，丢弃
+        while (resp_frames->current_pos < resp_frames->frame_buf_size &&
+               MYSQL_FRAME(resp_frames, resp_frames->current_pos)->timestamp_ns < req_msg->timestamp_ns) {
+            ++resp_frames->current_pos;
+        }
+
+        first = resp_frames->current_pos;
+        end = first;
+        while (end < resp_frames->frame_buf_size &&
+               (next_req_msg == NULL || MYSQL_FRAME(resp_frames, end)->timestamp_ns < next_req_msg->timestamp_ns)) {
+            ++end;
+        }
+
+        if (next_req_msg == NULL) {
+            // 最后一个请求：等待响应完整后再匹配
+            if (end == first || !mysql_resp_completed(resp_frames, first, end)) {
+                break;
+            }
+        } else if (end == first) {
+            // 无响应的请求（如COM_STMT_CLOSE）或响应丢失
+            ++req_frames->current_pos;
+            continue;
+        }
+
+        if (mysql_command_has_resp(req_msg->header)) {
+            add_mysql_record_into_buf(req_msg, resp_frames, first, end, record_buf);
+        }
+        ++req_frames->current_pos;
+        resp_frames->current_pos = end;
+    }
+
+    // 没有待匹配的请求时，剩余的响应无法匹配，直接丢弃
+    if (req_frames->current_pos == req_frames->frame_buf_size) {
+        resp_frames->current_pos = resp_frames->frame_buf_size;
+    }
+}
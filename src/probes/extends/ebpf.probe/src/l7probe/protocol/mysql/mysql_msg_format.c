@@ -0,0 +1,112 @@
+/*******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-07-26
+ * Description:
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "common.h"
+#include "mysql_msg_format.h"
+
+#define MYSQL_COMMAND_NAME(cmd, name) [cmd] = name
+
+static const char *mysql_command_names[__MAX_MYSQL_COMMAND] = {
+    MYSQL_COMMAND_NAME(MYSQL_COM_SLEEP, "SLEEP"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_QUIT, "QUIT"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_INIT_DB, "INIT_DB"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_QUERY, "QUERY"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_FIELD_LIST, "FIELD_LIST"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_CREATE_DB, "CREATE_DB"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_DROP_DB, "DROP_DB"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_REFRESH, "REFRESH"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_SHUTDOWN, "SHUTDOWN"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_STATISTICS, "STATISTICS"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_PROCESS_INFO, "PROCESS_INFO"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_CONNECT, "CONNECT"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_PROCESS_KILL, "PROCESS_KILL"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_DEBUG, "DEBUG"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_PING, "PING"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_TIME, "TIME"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_DELAYED_INSERT, "DELAYED_INSERT"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_CHANGE_USER, "CHANGE_USER"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_BINLOG_DUMP, "BINLOG_DUMP"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_TABLE_DUMP, "TABLE_DUMP"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_CONNECT_OUT, "CONNECT_OUT"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_REGISTER_SLAVE, "REGISTER_SLAVE"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_STMT_PREPARE, "STMT_PREPARE"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_STMT_EXECUTE, "STMT_EXECUTE"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_STMT_SEND_LONG_DATA, "STMT_SEND_LONG_DATA"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_STMT_CLOSE, "STMT_CLOSE"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_STMT_RESET, "STMT_RESET"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_SET_OPTION, "SET_OPTION"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_STMT_FETCH, "STMT_FETCH"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_DAEMON, "DAEMON"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_BINLOG_DUMP_GTID, "BINLOG_DUMP_GTID"),
+    MYSQL_COMMAND_NAME(MYSQL_COM_RESET_CONNECTION, "RESET_CONNECTION"),
+};
+
+bool mysql_command_has_resp(uint8_t command)
+{
+    switch (command) {
+        case MYSQL_COM_QUIT:
+        case MYSQL_COM_STMT_SEND_LONG_DATA:
+        case MYSQL_COM_STMT_CLOSE:
+            return false;
+        default:
+            return true;
+    }
+}
+
+const char *mysql_command_name(uint8_t command)
+{
+    if (command >= __MAX_MYSQL_COMMAND) {
+        return "UNKNOWN";
+    }
+    return mysql_command_names[command];
+}
+
+struct mysql_packet_msg_s *init_mysql_packet_msg(void)
+{
+    struct mysql_packet_msg_s *msg = (struct mysql_packet_msg_s *) malloc(sizeof(struct mysql_packet_msg_s));
+    if (msg == NULL) {
+        return NULL;
+    }
+    memset(msg, 0, sizeof(struct mysql_packet_msg_s));
+    return msg;
+}
+
+void free_mysql_packet_msg(struct mysql_packet_msg_s *msg)
+{
+    if (msg == NULL) {
+        return;
+    }
+    free(msg);
+}
+
+struct mysql_record_s *init_mysql_record(void)
+{
+    struct mysql_record_s *record = (struct mysql_record_s *) malloc(sizeof(struct mysql_record_s));
+    if (record == NULL) {
+        return NULL;
+    }
+    memset(record, 0, sizeof(struct mysql_record_s));
+    return record;
+}
+
+void free_mysql_record(struct mysql_record_s *record)
+{
+    if (record == NULL) {
+        return;
+    }
+    free(record);
+}
@@ -0,0 +1,143 @@
+/*******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-07-26
+ * Description:
+ ******************************************************************************/
+
+#ifndef __MYSQL_MSG_FORMAT_H__
+#define __MYSQL_MSG_FORMAT_H__
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../../include/data_stream.h"
+
+// References mysql spec:
+// https://dev.mysql.com/doc/dev/mysql-server/latest/page_protocol_basic_packets.html
+#define MYSQL_PACKET_HEADER_LEN 4
+#define MYSQL_PAYLOAD_LEN_BYTES 3
+#define MYSQL_MAX_PAYLOAD_LEN 0xffffff
+
+// OK报文最短长度：header(1) + affected_rows(1) + last_insert_id(1) + status_flags(2) + warnings(2)
+#define MYSQL_OK_PACKET_MIN_LEN 7
+
+// EOF报文最大长度，超过则为行数据
+#define MYSQL_EOF_PACKET_MAX_LEN 9
+
+// 第一个字节，响应包头
+#define MYSQL_RESP_OK 0x00
+#define MYSQL_RESP_LOCAL_INFILE 0xfb
+#define MYSQL_RESP_EOF 0xfe
+#define MYSQL_RESP_ERR 0xff
+
+// https://dev.mysql.com/doc/dev/mysql-server/latest/page_protocol_command_phase.html
+enum mysql_command_t {
+    MYSQL_COM_SLEEP = 0x00,
+    MYSQL_COM_QUIT = 0x01,
+    MYSQL_COM_INIT_DB = 0x02,
+    MYSQL_COM_QUERY = 0x03,
+    MYSQL_COM_FIELD_LIST = 0x04,
+    MYSQL_COM_CREATE_DB = 0x05,
+    MYSQL_COM_DROP_DB = 0x06,
+    MYSQL_COM_REFRESH = 0x07,
+    MYSQL_COM_SHUTDOWN = 0x08,
+    MYSQL_COM_STATISTICS = 0x09,
+    MYSQL_COM_PROCESS_INFO = 0x0a,
+    MYSQL_COM_CONNECT = 0x0b,
+    MYSQL_COM_PROCESS_KILL = 0x0c,
+    MYSQL_COM_DEBUG = 0x0d,
+    MYSQL_COM_PING = 0x0e,
+    MYSQL_COM_TIME = 0x0f,
+    MYSQL_COM_DELAYED_INSERT = 0x10,
+    MYSQL_COM_CHANGE_USER = 0x11,
+    MYSQL_COM_BINLOG_DUMP = 0x12,
+    MYSQL_COM_TABLE_DUMP = 0x13,
+    MYSQL_COM_CONNECT_OUT = 0x14,
+    MYSQL_COM_REGISTER_SLAVE = 0x15,
+    MYSQL_COM_STMT_PREPARE = 0x16,
+    MYSQL_COM_STMT_EXECUTE = 0x17,
+    MYSQL_COM_STMT_SEND_LONG_DATA = 0x18,
+    MYSQL_COM_STMT_CLOSE = 0x19,
+    MYSQL_COM_STMT_RESET = 0x1a,
+    MYSQL_COM_SET_OPTION = 0x1b,
+    MYSQL_COM_STMT_FETCH = 0x1c,
+    MYSQL_COM_DAEMON = 0x1d,
+    MYSQL_COM_BINLOG_DUMP_GTID = 0x1e,
+    MYSQL_COM_RESET_CONNECTION = 0x1f,
+
+    __MAX_MYSQL_COMMAND
+};
+
+/**
+ * Is the command followed by a response, eg. COM_STMT_CLOSE has no response.
+ */
+bool mysql_command_has_resp(uint8_t command);
+
+/**
+ * Name of the command, eg. "STMT_EXECUTE".
+ */
+const char *mysql_command_name(uint8_t command);
+
+enum mysql_packet_type_t {
+    MYSQL_PACKET_REQUEST = 0,
+
+    // 响应的第一个报文（seq_id = 1）：OK、ERR、结果集列数或COM_STMT_PREPARE_OK
+    MYSQL_PACKET_RESP_FIRST,
+
+    // 结果集中的EOF报文，或CLIENT_DEPRECATE_EOF下结束结果集的OK报文（包头均为0xfe）
+    MYSQL_PACKET_RESP_EOF,
+
+    // 响应中途的ERR报文
+    MYSQL_PACKET_RESP_ERR
+};
+
+/**
+ * MySQL packet frame.
+ * 只有请求和可能结束响应的报文才会生成frame，列定义和行数据按长度跳过，不生成frame。
+ */
+struct mysql_packet_msg_s {
+    u64 timestamp_ns;
+    enum mysql_packet_type_t type;
+    uint8_t seq_id;
+
+    // 请求：command；响应：报文的第一个字节
+    uint8_t header;
+
+    // 响应的第一个报文为结果集列数时有效，用于识别列定义之后的EOF
+    uint64_t column_count;
+
+    // 请求的api名称，COM_QUERY取SQL首个关键字（如SELECT），其余取command名称
+    char api[L7_API_LEN];
+};
+
+struct mysql_packet_msg_s *init_mysql_packet_msg(void);
+
+void free_mysql_packet_msg(struct mysql_packet_msg_s *msg);
+
+/**
+ * MySQL record, req & resp metadata copied from frames.
+ */
+struct mysql_record_s {
+    char api[L7_API_LEN];
+    uint8_t command;
+    u64 req_timestamp_ns;
+    u64 resp_timestamp_ns;
+    bool is_err;
+};
+
+struct mysql_record_s *init_mysql_record(void);
+
+void free_mysql_record(struct mysql_record_s *record);
+
+#endif
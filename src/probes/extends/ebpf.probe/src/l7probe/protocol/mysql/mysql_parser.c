@@ -0,0 +1,262 @@
+/*******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-07-26
+ * Description:
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "common.h"
+#include "mysql_parser.h"
+#include "../utils/macros.h"
+#include "../utils/binary_decoder.h"
+
+// length-encoded integer前缀
+#define MYSQL_LENENC_NULL 0xfb
+#define MYSQL_LENENC_2_BYTES 0xfc
+#define MYSQL_LENENC_3_BYTES 0xfd
+#define MYSQL_LENENC_8_BYTES 0xfe
+
+/**
+ * Extract length-encoded integer.
+ * https://dev.mysql.com/doc/dev/mysql-server/latest/page_protocol_basic_dt_integers.html
+ */
+static parse_state_t mysql_extract_lenenc_int(struct raw_data_s *raw_data, uint64_t *res)
+{
+    uint64_t prefix;
+    parse_state_t state;
+
+    state = decoder_extract_le_uint(raw_data, 1, &prefix);
+    if (state != STATE_SUCCESS) {
+        return state;
+    }
+
+    switch (prefix) {
+        case MYSQL_LENENC_2_BYTES:
+            return decoder_extract_le_uint(raw_data, 2, res);
+        case MYSQL_LENENC_3_BYTES:
+            return decoder_extract_le_uint(raw_data, 3, res);
+        case MYSQL_LENENC_8_BYTES:
+            return decoder_extract_le_uint(raw_data, 8, res);
+        case MYSQL_LENENC_NULL:
+        case 0xff:
+            return STATE_INVALID;
+        default:
+            *res = prefix;
+            return STATE_SUCCESS;
+    }
+}
+
+// COM_QUERY的api取SQL的首个关键字，如SELECT、INSERT，避免以整条SQL作为统计维度
+static void mysql_extract_query_api(const struct raw_data_s *raw_data, size_t len, char *api)
+{
+    const char *sql = &raw_data->data[raw_data->current_pos];
+    size_t i = 0;
+    size_t api_len = 0;
+
+    while (i < len && (isspace((unsigned char)sql[i]) || sql[i] == '(')) {
+        i++;
+    }
+    while (i < len && api_len < L7_API_LEN - 1 && isalpha((unsigned char)sql[i])) {
+        api[api_len++] = (char)toupper((unsigned char)sql[i]);
+        i++;
+    }
+    api[api_len] = '\0';
+}
+
+static parse_state_t mysql_parse_request(struct raw_data_s *raw_data, size_t payload_len,
+                                         struct mysql_packet_msg_s *msg)
+{
+    uint64_t command;
+    size_t query_len;
+    parse_state_t state;
+
+    state = decoder_extract_le_uint(raw_data, 1, &command);
+    if (state != STATE_SUCCESS) {
+        return state;
+    }
+    if (command >= __MAX_MYSQL_COMMAND) {
+        return STATE_INVALID;
+    }
+    msg->type = MYSQL_PACKET_REQUEST;
+    msg->header = (uint8_t)command;
+
+    if (command == MYSQL_COM_QUERY) {
+        // 只需要SQL开头的关键字，无需等待整条SQL
+        query_len = payload_len - 1;
+        if (query_len > L7_API_LEN) {
+            query_len = L7_API_LEN;
+        }
+        if (raw_data->data_len - raw_data->current_pos < query_len) {
+            return STATE_NEEDS_MORE_DATA;
+        }
+        mysql_extract_query_api(raw_data, query_len, msg->api);
+    }
+    if (msg->api[0] == '\0') {
+        (void)snprintf(msg->api, L7_API_LEN, "%s", mysql_command_name(msg->header));
+    }
+    return STATE_SUCCESS;
+}
+
+static parse_state_t mysql_parse_response(struct raw_data_s *raw_data, size_t payload_len,
+                                          struct mysql_packet_msg_s *msg)
+{
+    uint64_t header;
+    parse_state_t state;
+
+    if (raw_data->current_pos >= raw_data->data_len) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+    header = (uint8_t)raw_data->data[raw_data->current_pos];
+    msg->header = (uint8_t)header;
+
+    // seq_id = 0为服务端握手报文，不属于任何命令的响应
+    if (msg->seq_id == 0) {
+        return STATE_IGNORE;
+    }
+
+    if (msg->seq_id == 1) {
+        msg->type = MYSQL_PACKET_RESP_FIRST;
+        if (header == MYSQL_RESP_OK || header == MYSQL_RESP_ERR || header == MYSQL_RESP_EOF ||
+            header == MYSQL_RESP_LOCAL_INFILE) {
+            return STATE_SUCCESS;
+        }
+
+        // 结果集首个报文为列数
+        state = mysql_extract_lenenc_int(raw_data, &msg->column_count);
+        return state;
+    }
+
+    if (header == MYSQL_RESP_ERR) {
+        msg->type = MYSQL_PACKET_RESP_ERR;
+        return STATE_SUCCESS;
+    }
+
+    // 以0xfe开头的行数据长度至少为2^24，必然被拆分为多个报文，因此长度不足最大值的0xfe报文一定是EOF
+    if (header == MYSQL_RESP_EOF && payload_len < MYSQL_MAX_PAYLOAD_LEN) {
+        msg->type = MYSQL_PACKET_RESP_EOF;
+        return STATE_SUCCESS;
+    }
+
+    // 列定义、行数据
+    return STATE_IGNORE;
+}
+
+size_t mysql_find_frame_boundary(enum message_type_t msg_type, struct raw_data_s *raw_data)
+{
+    const char *data = raw_data->data;
+
+    for (size_t i = raw_data->current_pos; i + MYSQL_PACKET_HEADER_LEN < raw_data->data_len; ++i) {
+        uint32_t payload_len = (uint8_t)data[i] | ((uint8_t)data[i + 1] << 8) | ((uint8_t)data[i + 2] << 16);
+        uint8_t seq_id = (uint8_t)data[i + 3];
+
+        if (payload_len == 0) {
+            continue;
+        }
+        if (msg_type == MESSAGE_REQUEST) {
+            // 请求报文的seq_id为0，且紧跟合法的command
+            if (seq_id == 0 && (uint8_t)data[i + MYSQL_PACKET_HEADER_LEN] < __MAX_MYSQL_COMMAND) {
+                return i;
+            }
+            continue;
+        }
+        if (i == raw_data->current_pos) {
+            return i;
+        }
+        // 重新同步时只从响应的第一个报文开始
+        if (seq_id == 1) {
+            return i;
+        }
+    }
+    return PARSER_INVALID_BOUNDARY_INDEX;
+}
+
+parse_state_t mysql_parse_frame(enum message_type_t msg_type, struct raw_data_s *raw_data,
+                                struct frame_data_s **frame_data)
+{
+    struct mysql_packet_msg_s *msg;
+    size_t start = raw_data->current_pos;
+    size_t body_start;
+    size_t avail;
+    uint64_t payload_len;
+    uint64_t seq_id;
+    parse_state_t state;
+
+    if (raw_data->data_len == 0 || start >= raw_data->data_len) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+
+    state = decoder_extract_le_uint(raw_data, MYSQL_PAYLOAD_LEN_BYTES, &payload_len);
+    if (state == STATE_SUCCESS) {
+        state = decoder_extract_le_uint(raw_data, 1, &seq_id);
+    }
+    if (state != STATE_SUCCESS) {
+        raw_data->current_pos = start;
+        return state;
+    }
+
+    // 空报文用于结束长度恰为0xffffff整数倍的大报文
+    if (payload_len == 0) {
+        return STATE_IGNORE;
+    }
+
+    msg = init_mysql_packet_msg();
+    if (msg == NULL) {
+        ERROR("[Mysql parser] Failed to malloc mysql_packet_msg.\n");
+        raw_data->current_pos = start;
+        return STATE_INVALID;
+    }
+    msg->timestamp_ns = raw_data->timestamp_ns;
+    msg->seq_id = (uint8_t)seq_id;
+
+    body_start = raw_data->current_pos;
+    if (msg_type == MESSAGE_REQUEST) {
+        // seq_id非0的请求报文为握手认证或大报文的后续分片
+        state = (msg->seq_id == 0) ? mysql_parse_request(raw_data, payload_len, msg) : STATE_IGNORE;
+    } else {
+        state = mysql_parse_response(raw_data, payload_len, msg);
+    }
+
+    if (state == STATE_NEEDS_MORE_DATA || state == STATE_INVALID) {
+        free_mysql_packet_msg(msg);
+        // INVALID时跳过当前字节，使rebound从下一个候选位置开始
+        raw_data->current_pos = (state == STATE_INVALID) ? start + 1 : start;
+        return state;
+    }
+
+    // 按长度跳过报文体，超出当前raw_data的部分由后续raw_data继续跳过
+    raw_data->current_pos = body_start;
+    avail = raw_data->data_len - raw_data->current_pos;
+    if (payload_len <= avail) {
+        (void)decoder_extract_prefix_ignore(raw_data, payload_len);
+    } else {
+        raw_data->current_pos = raw_data->data_len;
+        raw_data->skip_len = payload_len - avail;
+    }
+
+    if (state == STATE_IGNORE) {
+        free_mysql_packet_msg(msg);
+        return STATE_IGNORE;
+    }
+
+    *frame_data = (struct frame_data_s *) malloc(sizeof(struct frame_data_s));
+    if ((*frame_data) == NULL) {
+        ERROR("[Mysql parser] Failed to malloc frame_data.\n");
+        free_mysql_packet_msg(msg);
+        return STATE_INVALID;
+    }
+    (*frame_data)->msg_type = msg_type;
+    (*frame_data)->timestamp_ns = msg->timestamp_ns;
+    (*frame_data)->frame = msg;
+    return STATE_SUCCESS;
+}
@@ -0,0 +1,39 @@
+/*******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-07-26
+ * Description:
+ ******************************************************************************/
+
+#ifndef __MYSQL_PARSER_H__
+#define __MYSQL_PARSER_H__
+
+#pragma once
+
+#include "../../include/data_stream.h"
+#include "mysql_msg_format.h"
+
+size_t mysql_find_frame_boundary(enum message_type_t msg_type, struct raw_data_s *raw_data);
+
+/**
+ * Parse one MySQL packet from raw_data->current_pos.
+ * Column definitions and rows are skipped by payload length without copying and return STATE_IGNORE;
+ * a payload longer than the rest of raw_data is skipped via raw_data->skip_len.
+ *
+ * @param msg_type request or response
+ * @param raw_data
+ * @param frame_data
+ * @return
+ */
+parse_state_t mysql_parse_frame(enum message_type_t msg_type, struct raw_data_s *raw_data,
+                                struct frame_data_s **frame_data);
+
+#endif
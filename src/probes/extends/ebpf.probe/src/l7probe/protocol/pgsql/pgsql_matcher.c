@@ -468,6 +468,8 @@ void pgsql_matcher_add_record(struct pgsql_regular_msg_s *req, uint64_t resp_tim
     }
     record_data->record = pgsql_record;
     record_data->latency = resp_timestamp_ns - req->timestamp_ns;
+    record_data->api[0] = 0;
+    record_data->is_err = 0;
     record_buf->records[record_buf->record_buf_size] = record_data;
     ++record_buf->record_buf_size;
 }
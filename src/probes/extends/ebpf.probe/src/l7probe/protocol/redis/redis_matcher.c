@@ -0,0 +1,98 @@
+/*******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-07-24
+ * Description:
+ ******************************************************************************/
+
+#include <string.h>
+#include "common.h"
+#include "redis_matcher.h"
+
+static void add_redis_record_into_buf(const struct redis_msg_s *req_msg, const struct redis_msg_s *resp_msg,
+                                      struct record_buf_s *record_buf)
+{
+    struct redis_record_s *record;
+    struct record_data_s *record_data;
+
+    record = init_redis_record();
+    if (record == NULL) {
+        ERROR("[REDIS MATCHER] Failed to malloc redis_record.\n");
+        return;
+    }
+    // frame在匹配完成后会被释放，record只保存拷贝的元数据
+    (void)strncpy(record->command, req_msg->command, L7_API_LEN - 1);
+    record->req_timestamp_ns = req_msg->timestamp_ns;
+    record->resp_timestamp_ns = resp_msg->timestamp_ns;
+    record->is_err = resp_msg->is_err;
+
+    record_data = (struct record_data_s *) malloc(sizeof(struct record_data_s));
+    if (record_data == NULL) {
+        ERROR("[REDIS MATCHER] Failed to malloc record_data.\n");
+        free_redis_record(record);
+        return;
+    }
+    memset(record_data, 0, sizeof(struct record_data_s));
+    record_data->record = record;
+    record_data->latency = record->resp_timestamp_ns - record->req_timestamp_ns;
+    (void)strncpy(record_data->api, record->command, L7_API_LEN - 1);
+    record_data->is_err = record->is_err;
+
+    if (record->is_err) {
+        ++record_buf->err_count;
+    }
+    record_buf->records[record_buf->record_buf_size] = record_data;
+    ++record_buf->record_buf_size;
+}
+
+// Note: 若中间丢失了某个请求的响应，其后的请求会与错位的响应配对，直至连接上的数据重新对齐
+void redis_match_frames(struct frame_buf_s *req_frames, struct frame_buf_s *resp_frames,
+                        struct record_buf_s *record_buf)
+{
+    record_buf->err_count = 0;
+    record_buf->record_buf_size = 0;
+    record_buf->req_count = req_frames->frame_buf_size;
+    record_buf->resp_count = resp_frames->frame_buf_size;
+
+    while (resp_frames->current_pos < resp_frames->frame_buf_size) {
+        struct redis_msg_s *req_msg;
+        struct redis_msg_s *resp_msg;
+
+        if (record_buf->record_buf_size >= RECORD_BUF_SIZE) {
+            break;
+        }
+
+        resp_msg = (struct redis_msg_s *) resp_frames->frames[resp_frames->current_pos]->frame;
+
+        // push消息由服务端主动推送，不对应任何请求
+        if (resp_msg->is_push) {
+            ++resp_frames->current_pos;
+            continue;
+        }
+
+        // 请求一定先于响应完整发出，此时没有待匹配的请求说明请求已丢失，丢弃该响应
+        if (req_frames->current_pos >= req_frames->frame_buf_size) {
+            ++resp_frames->current_pos;
+            continue;
+        }
+        req_msg = (struct redis_msg_s *) req_frames->frames[req_frames->current_pos]->frame;
+
+        // 响应早于队首请求，说明其对应的请求已丢失，丢弃该响应
+        if (resp_msg->timestamp_ns < req_msg->timestamp_ns) {
+            ++resp_frames->current_pos;
+            continue;
+        }
+
+        add_redis_record_into_buf(req_msg, resp_msg, record_buf);
+        ++req_frames->current_pos;
+        ++resp_frames->current_pos;
+    }
+}
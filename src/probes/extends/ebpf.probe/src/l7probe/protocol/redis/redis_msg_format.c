@@ -0,0 +1,79 @@
+/*******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-07-24
+ * Description:
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "common.h"
+#include "redis_msg_format.h"
+
+bool is_redis_data_type(char type)
+{
+    switch (type) {
+        case REDIS_SIMPLE_STRING:
+        case REDIS_SIMPLE_ERROR:
+        case REDIS_INTEGER:
+        case REDIS_BULK_STRING:
+        case REDIS_ARRAY:
+        case REDIS_NULL:
+        case REDIS_BOOLEAN:
+        case REDIS_DOUBLE:
+        case REDIS_BIG_NUMBER:
+        case REDIS_BULK_ERROR:
+        case REDIS_VERBATIM_STRING:
+        case REDIS_MAP:
+        case REDIS_SET:
+        case REDIS_ATTRIBUTE:
+        case REDIS_PUSH:
+            return true;
+        default:
+            return false;
+    }
+}
+
+struct redis_msg_s *init_redis_msg(void)
+{
+    struct redis_msg_s *msg = (struct redis_msg_s *) malloc(sizeof(struct redis_msg_s));
+    if (msg == NULL) {
+        return NULL;
+    }
+    memset(msg, 0, sizeof(struct redis_msg_s));
+    return msg;
+}
+
+void free_redis_msg(struct redis_msg_s *msg)
+{
+    if (msg == NULL) {
+        return;
+    }
+    free(msg);
+}
+
+struct redis_record_s *init_redis_record(void)
+{
+    struct redis_record_s *record = (struct redis_record_s *) malloc(sizeof(struct redis_record_s));
+    if (record == NULL) {
+        return NULL;
+    }
+    memset(record, 0, sizeof(struct redis_record_s));
+    return record;
+}
+
+void free_redis_record(struct redis_record_s *record)
+{
+    if (record == NULL) {
+        return;
+    }
+    free(record);
+}
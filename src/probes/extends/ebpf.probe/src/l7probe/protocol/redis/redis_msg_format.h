@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-07-24
+ * Description:
+ ******************************************************************************/
+
+#ifndef __REDIS_MSG_FORMAT_H__
+#define __REDIS_MSG_FORMAT_H__
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../../include/data_stream.h"
+
+// 聚合类型最大嵌套层数，超过则认为报文非法
+#define REDIS_MAX_NESTING_DEPTH 16
+
+// RESP协议中最短的元素（例如 "_\r\n"、":1\r\n" 去掉数字）为3字节，用于快速判断数组数据是否足够
+#define REDIS_MIN_ELEMENT_LEN 3
+
+// First byte of a RESP value.
+// References redis spec:
+// https://redis.io/docs/reference/protocol-spec/
+enum redis_data_type_t {
+    // RESP2
+    REDIS_SIMPLE_STRING = '+',
+    REDIS_SIMPLE_ERROR = '-',
+    REDIS_INTEGER = ':',
+    REDIS_BULK_STRING = '$',
+    REDIS_ARRAY = '*',
+
+    // RESP3
+    REDIS_NULL = '_',
+    REDIS_BOOLEAN = '#',
+    REDIS_DOUBLE = ',',
+    REDIS_BIG_NUMBER = '(',
+    REDIS_BULK_ERROR = '!',
+    REDIS_VERBATIM_STRING = '=',
+    REDIS_MAP = '%',
+    REDIS_SET = '~',
+    REDIS_ATTRIBUTE = '|',
+    REDIS_PUSH = '>',
+
+    REDIS_UNKNOWN_TYPE = '\0'
+};
+
+bool is_redis_data_type(char type);
+
+/**
+ * Redis message frame.
+ * 解析时不拷贝报文内容，仅保存匹配与统计所需的元数据。
+ */
+struct redis_msg_s {
+    u64 timestamp_ns;
+
+    // 首字节类型
+    char data_type;
+
+    // 响应为 simple error 或 bulk error
+    bool is_err;
+
+    // RESP3 push 消息（pub/sub、客户端缓存失效通知等），不对应任何请求
+    bool is_push;
+
+    // 请求命令名（大写），取请求数组的第一个元素
+    char command[L7_API_LEN];
+
+    // 整个RESP值的字节数
+    size_t msg_len;
+};
+
+struct redis_msg_s *init_redis_msg(void);
+
+void free_redis_msg(struct redis_msg_s *msg);
+
+/**
+ * Redis record, req & resp metadata copied from frames.
+ */
+struct redis_record_s {
+    char command[L7_API_LEN];
+    u64 req_timestamp_ns;
+    u64 resp_timestamp_ns;
+    bool is_err;
+};
+
+struct redis_record_s *init_redis_record(void);
+
+void free_redis_record(struct redis_record_s *record);
+
+#endif
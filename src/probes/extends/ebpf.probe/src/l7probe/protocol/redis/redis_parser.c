@@ -0,0 +1,375 @@
+/*******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-07-24
+ * Description:
+ ******************************************************************************/
+
+#include <string.h>
+#include <ctype.h>
+#include "common.h"
+#include "redis_parser.h"
+#include "../utils/macros.h"
+
+#define REDIS_CRLF_LEN 2
+
+// 单个bulk string最大512MB（redis proto-max-bulk-len默认值）
+#define REDIS_MAX_BULK_LEN (512 * 1024 * 1024LL)
+
+// 聚合类型元素个数上限，超过则认为是误判的数据，避免长时间等待更多数据
+#define REDIS_MAX_AGGREGATE_LEN (1024 * 1024LL)
+
+/**
+ * Locate "\r\n" from pos, *line_end is set to the index of '\r'.
+ * RESP的行内不允许出现单独的'\r'。
+ */
+static parse_state_t redis_find_crlf(const char *data, size_t data_len, size_t pos, size_t *line_end)
+{
+    const char *cr;
+    size_t idx;
+
+    if (pos >= data_len) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+
+    cr = (const char *) memchr(data + pos, '\r', data_len - pos);
+    if (cr == NULL) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+    idx = (size_t)(cr - data);
+    if (idx + 1 >= data_len) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+    if (data[idx + 1] != '\n') {
+        return STATE_INVALID;
+    }
+    *line_end = idx;
+    return STATE_SUCCESS;
+}
+
+/**
+ * Parse the decimal length/count in [start, end), "-1" is allowed for null values.
+ */
+static parse_state_t redis_parse_len(const char *data, size_t start, size_t end, long long *len)
+{
+    long long res = 0;
+    bool negative = false;
+    size_t i = start;
+
+    if (i < end && data[i] == '-') {
+        negative = true;
+        i++;
+    }
+    if (i == end) {
+        return STATE_INVALID;
+    }
+    for (; i < end; i++) {
+        if (data[i] < '0' || data[i] > '9') {
+            return STATE_INVALID;
+        }
+        res = res * 10 + (data[i] - '0');
+        if (res > REDIS_MAX_BULK_LEN) {
+            return STATE_INVALID;
+        }
+    }
+
+    if (negative) {
+        // 仅允许-1表示null
+        if (res != 1) {
+            return STATE_INVALID;
+        }
+        res = -1;
+    }
+    *len = res;
+    return STATE_SUCCESS;
+}
+
+/**
+ * Parse the header line of a bulk/aggregate value, *pos is moved to the next line.
+ */
+static parse_state_t redis_parse_header_len(const char *data, size_t data_len, size_t *pos, long long *len)
+{
+    size_t line_end;
+    parse_state_t state;
+
+    state = redis_find_crlf(data, data_len, *pos, &line_end);
+    if (state != STATE_SUCCESS) {
+        return state;
+    }
+    state = redis_parse_len(data, *pos, line_end, len);
+    if (state != STATE_SUCCESS) {
+        return state;
+    }
+    *pos = line_end + REDIS_CRLF_LEN;
+    return STATE_SUCCESS;
+}
+
+/*
+ * 大value按长度跳过：位于整个RESP值末尾（tail）的bulk string，payload尚未全部到达时，
+ * 不等待更多数据（避免overlay反复拷贝），剩余长度记入*skip，由后续raw_data通过skip_len跳过。
+ * 非末尾的bulk之后仍有需要解析的数据，只能等待更多数据。
+ */
+struct redis_skip_ctx_s {
+    const char *data;
+    size_t data_len;
+    size_t skip;        // 超出data_len、需要在后续数据中跳过的字节数
+};
+
+static parse_state_t redis_skip_value(struct redis_skip_ctx_s *ctx, size_t *pos, int depth, bool tail,
+                                      char *data_type);
+
+static parse_state_t redis_skip_bulk(struct redis_skip_ctx_s *ctx, size_t *pos, bool tail)
+{
+    const char *data = ctx->data;
+    size_t data_len = ctx->data_len;
+    long long len;
+    parse_state_t state;
+
+    state = redis_parse_header_len(data, data_len, pos, &len);
+    if (state != STATE_SUCCESS) {
+        return state;
+    }
+    if (len < 0) {
+        return STATE_SUCCESS;
+    }
+
+    // 按长度跳过payload，不关心其内容
+    if (data_len - *pos < (size_t)len + REDIS_CRLF_LEN) {
+        if (!tail) {
+            return STATE_NEEDS_MORE_DATA;
+        }
+        ctx->skip = (size_t)len + REDIS_CRLF_LEN - (data_len - *pos);
+        *pos = data_len;
+        return STATE_SUCCESS;
+    }
+    if (data[*pos + len] != '\r' || data[*pos + len + 1] != '\n') {
+        return STATE_INVALID;
+    }
+    *pos += (size_t)len + REDIS_CRLF_LEN;
+    return STATE_SUCCESS;
+}
+
+static parse_state_t redis_skip_aggregate(struct redis_skip_ctx_s *ctx, size_t *pos, int depth, bool tail,
+                                          size_t elements_per_entry)
+{
+    const char *data = ctx->data;
+    size_t data_len = ctx->data_len;
+    long long count;
+    size_t elements;
+    parse_state_t state;
+
+    state = redis_parse_header_len(data, data_len, pos, &count);
+    if (state != STATE_SUCCESS) {
+        return state;
+    }
+    if (count < 0) {
+        return STATE_SUCCESS;
+    }
+    if (count > REDIS_MAX_AGGREGATE_LEN) {
+        return STATE_INVALID;
+    }
+
+    elements = (size_t)count * elements_per_entry;
+
+    // 剩余数据连最短的元素都放不下时，无需逐个解析即可判断数据不足
+    if (data_len - *pos < elements * REDIS_MIN_ELEMENT_LEN) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+
+    for (size_t i = 0; i < elements; i++) {
+        state = redis_skip_value(ctx, pos, depth + 1, tail && (i + 1 == elements), NULL);
+        if (state != STATE_SUCCESS) {
+            return state;
+        }
+    }
+    return STATE_SUCCESS;
+}
+
+/**
+ * Skip one RESP value starting at *pos.
+ * data_type is set to the type of the value, attributes ('|') preceding the value are skipped.
+ * tail: the value ends the top-level value, so its last bulk payload may be skipped beyond data_len.
+ */
+static parse_state_t redis_skip_value(struct redis_skip_ctx_s *ctx, size_t *pos, int depth, bool tail,
+                                      char *data_type)
+{
+    const char *data = ctx->data;
+    size_t data_len = ctx->data_len;
+    parse_state_t state;
+    size_t line_end;
+    char type;
+
+    if (depth > REDIS_MAX_NESTING_DEPTH) {
+        return STATE_INVALID;
+    }
+
+    while (1) {
+        if (*pos >= data_len) {
+            return STATE_NEEDS_MORE_DATA;
+        }
+        type = data[*pos];
+        if (type != REDIS_ATTRIBUTE) {
+            break;
+        }
+
+        // 属性是附加在真实值之前的map，跳过后继续解析真实值
+        (*pos)++;
+        state = redis_skip_aggregate(ctx, pos, depth, false, 2);
+        if (state != STATE_SUCCESS) {
+            return state;
+        }
+    }
+
+    if (data_type != NULL) {
+        *data_type = type;
+    }
+    (*pos)++;
+
+    switch (type) {
+        case REDIS_SIMPLE_STRING:
+        case REDIS_SIMPLE_ERROR:
+        case REDIS_INTEGER:
+        case REDIS_NULL:
+        case REDIS_BOOLEAN:
+        case REDIS_DOUBLE:
+        case REDIS_BIG_NUMBER:
+            state = redis_find_crlf(data, data_len, *pos, &line_end);
+            if (state != STATE_SUCCESS) {
+                return state;
+            }
+            *pos = line_end + REDIS_CRLF_LEN;
+            return STATE_SUCCESS;
+        case REDIS_BULK_STRING:
+        case REDIS_BULK_ERROR:
+        case REDIS_VERBATIM_STRING:
+            return redis_skip_bulk(ctx, pos, tail);
+        case REDIS_ARRAY:
+        case REDIS_SET:
+        case REDIS_PUSH:
+            return redis_skip_aggregate(ctx, pos, depth, tail, 1);
+        case REDIS_MAP:
+            return redis_skip_aggregate(ctx, pos, depth, tail, 2);
+        default:
+            return STATE_INVALID;
+    }
+}
+
+/**
+ * Copy the command name from a complete request array, eg. "*2\r\n$3\r\nGET\r\n$1\r\nk\r\n" -> "GET".
+ */
+static void redis_extract_command(const char *data, size_t data_len, size_t start, struct redis_msg_s *msg)
+{
+    size_t pos = start + 1;
+    long long count;
+    long long len;
+    size_t copy_len;
+
+    if (redis_parse_header_len(data, data_len, &pos, &count) != STATE_SUCCESS || count <= 0) {
+        return;
+    }
+    if (pos >= data_len || data[pos] != REDIS_BULK_STRING) {
+        return;
+    }
+    pos++;
+    if (redis_parse_header_len(data, data_len, &pos, &len) != STATE_SUCCESS || len <= 0) {
+        return;
+    }
+
+    copy_len = (size_t)len < L7_API_LEN - 1 ? (size_t)len : L7_API_LEN - 1;
+    // 命令名本身可能是被跳过的大bulk，只拷贝已到达的部分
+    copy_len = (copy_len < data_len - pos) ? copy_len : data_len - pos;
+    for (size_t i = 0; i < copy_len; i++) {
+        msg->command[i] = (char)toupper((unsigned char)data[pos + i]);
+    }
+    msg->command[copy_len] = '\0';
+}
+
+size_t redis_find_frame_boundary(enum message_type_t msg_type, struct raw_data_s *raw_data)
+{
+    const char *data = raw_data->data;
+
+    for (size_t i = raw_data->current_pos; i < raw_data->data_len; ++i) {
+        if (i != raw_data->current_pos && (i < REDIS_CRLF_LEN || data[i - 2] != '\r' || data[i - 1] != '\n')) {
+            continue;
+        }
+        if (msg_type == MESSAGE_REQUEST) {
+            if (data[i] == REDIS_ARRAY) {
+                return i;
+            }
+            continue;
+        }
+        if (is_redis_data_type(data[i])) {
+            return i;
+        }
+    }
+    return PARSER_INVALID_BOUNDARY_INDEX;
+}
+
+parse_state_t redis_parse_frame(enum message_type_t msg_type, struct raw_data_s *raw_data,
+                                struct frame_data_s **frame_data)
+{
+    struct redis_msg_s *msg;
+    parse_state_t state;
+    size_t start = raw_data->current_pos;
+    size_t pos = start;
+    char data_type = REDIS_UNKNOWN_TYPE;
+    struct redis_skip_ctx_s ctx = {.data = raw_data->data, .data_len = raw_data->data_len, .skip = 0};
+
+    if (raw_data->data_len == 0 || start >= raw_data->data_len) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+
+    // redis请求均为bulk string数组（inline command不会被bpf识别为redis）
+    if (msg_type == MESSAGE_REQUEST && raw_data->data[start] != REDIS_ARRAY) {
+        raw_data->current_pos++;
+        return STATE_INVALID;
+    }
+
+    state = redis_skip_value(&ctx, &pos, 0, true, &data_type);
+    if (state == STATE_INVALID) {
+        // 跳过当前起始字符，使rebound从下一个候选位置开始查找
+        raw_data->current_pos++;
+        return STATE_INVALID;
+    }
+    if (state != STATE_SUCCESS) {
+        return state;
+    }
+
+    msg = init_redis_msg();
+    if (msg == NULL) {
+        ERROR("[Redis parser] Failed to malloc redis_msg.\n");
+        return STATE_INVALID;
+    }
+    msg->timestamp_ns = raw_data->timestamp_ns;
+    msg->data_type = data_type;
+    msg->is_err = (data_type == REDIS_SIMPLE_ERROR || data_type == REDIS_BULK_ERROR);
+    msg->is_push = (data_type == REDIS_PUSH);
+    msg->msg_len = pos - start + ctx.skip;
+    if (msg_type == MESSAGE_REQUEST) {
+        redis_extract_command(raw_data->data, raw_data->data_len, start, msg);
+    }
+
+    *frame_data = (struct frame_data_s *) malloc(sizeof(struct frame_data_s));
+    if ((*frame_data) == NULL) {
+        ERROR("[Redis parser] Failed to malloc frame_data.\n");
+        free_redis_msg(msg);
+        return STATE_INVALID;
+    }
+    (*frame_data)->msg_type = msg_type;
+    (*frame_data)->timestamp_ns = msg->timestamp_ns;
+    (*frame_data)->frame = msg;
+
+    raw_data->current_pos = pos;
+    if (ctx.skip > 0) {
+        raw_data->skip_len = ctx.skip;
+    }
+    return STATE_SUCCESS;
+}
@@ -0,0 +1,48 @@
+/*******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: zhaoguolin
+ * Create: 2023-07-24
+ * Description:
+ ******************************************************************************/
+
+#ifndef __REDIS_PARSER_H__
+#define __REDIS_PARSER_H__
+
+#pragma once
+
+#include "../../include/data_stream.h"
+#include "redis_msg_format.h"
+
+/**
+ * Find the start of the next RESP value.
+ * 请求只能是数组（'*'），响应可以是任意RESP类型；候选位置必须位于current_pos或紧跟在"\r\n"之后。
+ *
+ * @param msg_type request or response
+ * @param raw_data
+ * @return boundary index, PARSER_INVALID_BOUNDARY_INDEX if not found
+ */
+size_t redis_find_frame_boundary(enum message_type_t msg_type, struct raw_data_s *raw_data);
+
+/**
+ * Parse one complete RESP2/RESP3 value from raw_data->current_pos.
+ * Zero-copy: bulk payloads are skipped by length, only the command name of a request is copied.
+ * A bulk payload ending the value and longer than the rest of raw_data is skipped via raw_data->skip_len.
+ * raw_data->current_pos is left unchanged unless STATE_SUCCESS is returned.
+ *
+ * @param msg_type request or response
+ * @param raw_data
+ * @param frame_data
+ * @return
+ */
+parse_state_t redis_parse_frame(enum message_type_t msg_type, struct raw_data_s *raw_data,
+                                struct frame_data_s **frame_data);
+
+#endif
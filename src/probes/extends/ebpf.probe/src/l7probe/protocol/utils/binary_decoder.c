@@ -99,6 +99,25 @@ DECODER_EXTRACT_INT(uint16_t)
 // parse_state_t decoder_extract_uint32_t(raw_data_s *raw_data, uint32_t *res)
 DECODER_EXTRACT_INT(uint32_t)
 
+parse_state_t decoder_extract_le_uint(struct raw_data_s *raw_data, size_t int_len, uint64_t *res)
+{
+    uint64_t value = 0;
+
+    if (int_len == 0 || int_len > sizeof(uint64_t)) {
+        return STATE_INVALID;
+    }
+    if ((raw_data->data_len - raw_data->current_pos) < int_len) {
+        return STATE_NEEDS_MORE_DATA;
+    }
+
+    for (size_t i = int_len; i > 0; i--) {
+        value = (value << 8) | (uint8_t)(raw_data->data[raw_data->current_pos + i - 1]);
+    }
+    *res = value;
+    parser_raw_data_offset(raw_data, int_len);
+    return STATE_SUCCESS;
+}
+
 bool extract_prefix_bytes_string(struct raw_data_s *raw_data, char **res, size_t decode_len, size_t data_stream_offset)
 {
     // 申请新内存，存放提取后字符串
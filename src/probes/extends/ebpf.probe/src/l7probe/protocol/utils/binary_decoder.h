@@ -82,6 +82,16 @@ DECODER_EXTRACT_INT_FUNC(uint32_t);
 #define DECODER_EXTRACT_INT_WITH_INT_TYPE(int_type, raw_data_ptr, res_ptr) \
     decoder_extract_##int_type(raw_data_ptr, res_ptr)
 
+/**
+ * 小端法提取raw_data中int_len字节的无符号整形数据（如mysql的3字节报文长度），int_len取值[1, 8]。
+ *
+ * @param raw_data 字符串缓存
+ * @param int_len 整形数据字节数
+ * @param res 整形数据结果存放指针
+ * @return parse_state_t，若raw_data长度不足int_len，则返回STATE_NEEDS_MORE_DATA
+ */
+parse_state_t decoder_extract_le_uint(struct raw_data_s *raw_data, size_t int_len, uint64_t *res);
+
 /**
  * 从raw_data中提取decode_len长度子串，置于*res，并偏移raw_data指针。
  * NOTE：入参*res需要在堆上分配内存。
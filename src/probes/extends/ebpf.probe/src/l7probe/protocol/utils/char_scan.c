@@ -0,0 +1,287 @@
+/*******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: eank
+ * Create: 2023-07-20
+ * Description: SIMD byte-range scanner shared by l7 text protocol parsers
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#include <sys/auxv.h>
+#include <arm_neon.h>
+#if defined(__ARM_FEATURE_SVE)
+#include <arm_sve.h>
+#endif
+#ifndef HWCAP_SVE
+#define HWCAP_SVE (1 << 22)
+#endif
+#endif
+
+#include "char_scan.h"
+
+typedef const char *(*find_char_func)(const char *buf, const char *buf_end, const char *ranges, size_t ranges_size,
+                                      int *found);
+
+static const char *char_scan_names[CHAR_SCAN_IMPL_MAX] = {
+    "scalar",
+    "sse4.2",
+    "avx2",
+    "neon",
+    "sve"
+};
+
+static const char *find_char_scalar(const char *buf, const char *buf_end, const char *ranges, size_t ranges_size,
+                                    int *found)
+{
+    // 标量场景下由调用方的循环逐字节处理
+    (void)buf_end;
+    (void)ranges;
+    (void)ranges_size;
+    *found = 0;
+    return buf;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("sse4.2")))
+static const char *find_char_sse42(const char *buf, const char *buf_end, const char *ranges, size_t ranges_size,
+                                   int *found)
+{
+    // pcmpestri一次读取16字节，ranges可能不足16字节，先拷贝到对齐的本地缓存中
+    char __attribute__((aligned(16))) ranges_buf[16] = {0};
+    __m128i ranges16;
+    size_t left;
+
+    *found = 0;
+    if (buf_end - buf < 16) {
+        return buf;
+    }
+
+    memcpy(ranges_buf, ranges, ranges_size);
+    ranges16 = _mm_load_si128((const __m128i *)ranges_buf);
+    left = (buf_end - buf) & ~15;
+    do {
+        __m128i b16 = _mm_loadu_si128((const __m128i *)buf);
+        int r = _mm_cmpestri(ranges16, ranges_size, b16, 16, _SIDD_LEAST_SIGNIFICANT | _SIDD_CMP_RANGES | _SIDD_UBYTE_OPS);
+        if (r != 16) {
+            buf += r;
+            *found = 1;
+            break;
+        }
+        buf += 16;
+        left -= 16;
+    } while (left != 0);
+
+    return buf;
+}
+
+// AVX2没有范围比较指令，使用无符号max/min判断 low <= c <= high，一次处理32字节
+__attribute__((target("avx2")))
+static const char *find_char_avx2(const char *buf, const char *buf_end, const char *ranges, size_t ranges_size,
+                                  int *found)
+{
+    __m256i low[CHAR_SCAN_MAX_RANGES];
+    __m256i high[CHAR_SCAN_MAX_RANGES];
+    size_t range_num = ranges_size / 2;
+
+    *found = 0;
+    for (size_t i = 0; i < range_num; i++) {
+        low[i] = _mm256_set1_epi8(ranges[i * 2]);
+        high[i] = _mm256_set1_epi8(ranges[i * 2 + 1]);
+    }
+
+    while (buf_end - buf >= 32) {
+        __m256i b32 = _mm256_loadu_si256((const __m256i *)buf);
+        __m256i hit = _mm256_setzero_si256();
+        for (size_t i = 0; i < range_num; i++) {
+            __m256i ge = _mm256_cmpeq_epi8(_mm256_max_epu8(b32, low[i]), b32);
+            __m256i le = _mm256_cmpeq_epi8(_mm256_min_epu8(b32, high[i]), b32);
+            hit = _mm256_or_si256(hit, _mm256_and_si256(ge, le));
+        }
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(hit);
+        if (mask != 0) {
+            buf += __builtin_ctz(mask);
+            *found = 1;
+            break;
+        }
+        buf += 32;
+    }
+
+    return buf;
+}
+
+#endif
+
+#if defined(__aarch64__)
+
+static const char *find_char_neon(const char *buf, const char *buf_end, const char *ranges, size_t ranges_size,
+                                  int *found)
+{
+    uint8x16_t low[CHAR_SCAN_MAX_RANGES];
+    uint8x16_t high[CHAR_SCAN_MAX_RANGES];
+    size_t range_num = ranges_size / 2;
+
+    *found = 0;
+    for (size_t i = 0; i < range_num; i++) {
+        low[i] = vdupq_n_u8((uint8_t)ranges[i * 2]);
+        high[i] = vdupq_n_u8((uint8_t)ranges[i * 2 + 1]);
+    }
+
+    while (buf_end - buf >= 16) {
+        uint8x16_t b16 = vld1q_u8((const uint8_t *)buf);
+        uint8x16_t hit = vdupq_n_u8(0);
+        for (size_t i = 0; i < range_num; i++) {
+            hit = vorrq_u8(hit, vandq_u8(vcgeq_u8(b16, low[i]), vcleq_u8(b16, high[i])));
+        }
+
+        // NEON没有movemask，右移窄化后每个字节对应4个bit，计算尾零个数即可得到命中下标
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+        if (mask != 0) {
+            buf += __builtin_ctzll(mask) >> 2;
+            *found = 1;
+            break;
+        }
+        buf += 16;
+    }
+
+    return buf;
+}
+
+#if defined(__ARM_FEATURE_SVE)
+static const char *find_char_sve(const char *buf, const char *buf_end, const char *ranges, size_t ranges_size,
+                                 int *found)
+{
+    size_t range_num = ranges_size / 2;
+    size_t vl = svcntb();
+    svbool_t pg = svptrue_b8();
+
+    *found = 0;
+    while ((size_t)(buf_end - buf) >= vl) {
+        svuint8_t b = svld1_u8(pg, (const uint8_t *)buf);
+        svbool_t hit = svpfalse_b();
+        for (size_t i = 0; i < range_num; i++) {
+            svbool_t ge = svcmpge_n_u8(pg, b, (uint8_t)ranges[i * 2]);
+            svbool_t le = svcmple_n_u8(pg, b, (uint8_t)ranges[i * 2 + 1]);
+            hit = svorr_b_z(pg, hit, svand_b_z(pg, ge, le));
+        }
+        if (svptest_any(pg, hit)) {
+            buf += svcntp_b8(pg, svbrkb_b_z(pg, hit));
+            *found = 1;
+            break;
+        }
+        buf += vl;
+    }
+
+    return buf;
+}
+#endif
+
+#endif
+
+static find_char_func find_char_impls[CHAR_SCAN_IMPL_MAX] = {
+    [CHAR_SCAN_SCALAR] = find_char_scalar,
+#if defined(__x86_64__) || defined(__i386__)
+    [CHAR_SCAN_SSE42] = find_char_sse42,
+    [CHAR_SCAN_AVX2] = find_char_avx2,
+#endif
+#if defined(__aarch64__)
+    [CHAR_SCAN_NEON] = find_char_neon,
+#if defined(__ARM_FEATURE_SVE)
+    [CHAR_SCAN_SVE] = find_char_sve,
+#endif
+#endif
+};
+
+// 由pthread_once在首次扫描时初始化；char_scan_select_impl可能与解析线程并发，读写均使用原子操作
+static find_char_func find_char_impl = NULL;
+static pthread_once_t find_char_once = PTHREAD_ONCE_INIT;
+
+static char is_impl_supported(enum char_scan_impl_t impl)
+{
+    if (impl >= CHAR_SCAN_IMPL_MAX || find_char_impls[impl] == NULL) {
+        return 0;
+    }
+
+    switch (impl) {
+#if defined(__x86_64__) || defined(__i386__)
+        case CHAR_SCAN_SSE42:
+            return __builtin_cpu_supports("sse4.2") ? 1 : 0;
+        case CHAR_SCAN_AVX2:
+            return __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
+#if defined(__aarch64__)
+        case CHAR_SCAN_SVE:
+            return (getauxval(AT_HWCAP) & HWCAP_SVE) ? 1 : 0;
+#endif
+        default:
+            // 标量实现总是可用；NEON是aarch64的基础指令集
+            return 1;
+    }
+}
+
+static enum char_scan_impl_t detect_impl(void)
+{
+    // 按优先级从高到低选择
+    static const enum char_scan_impl_t prefer[] = {
+        CHAR_SCAN_SVE, CHAR_SCAN_AVX2, CHAR_SCAN_NEON, CHAR_SCAN_SSE42
+    };
+
+    for (size_t i = 0; i < sizeof(prefer) / sizeof(prefer[0]); i++) {
+        if (is_impl_supported(prefer[i])) {
+            return prefer[i];
+        }
+    }
+    return CHAR_SCAN_SCALAR;
+}
+
+static void init_find_char_impl(void)
+{
+    __atomic_store_n(&find_char_impl, find_char_impls[detect_impl()], __ATOMIC_RELAXED);
+}
+
+enum char_scan_impl_t char_scan_select_impl(enum char_scan_impl_t impl)
+{
+    // 先完成默认初始化，避免其在之后覆盖显式指定的实现
+    (void)pthread_once(&find_char_once, init_find_char_impl);
+
+    if (impl >= CHAR_SCAN_IMPL_MAX || !is_impl_supported(impl)) {
+        impl = detect_impl();
+    }
+    __atomic_store_n(&find_char_impl, find_char_impls[impl], __ATOMIC_RELAXED);
+    return impl;
+}
+
+const char *char_scan_impl_name(enum char_scan_impl_t impl)
+{
+    if (impl >= CHAR_SCAN_IMPL_MAX) {
+        return "unknown";
+    }
+    return char_scan_names[impl];
+}
+
+const char *find_char_fast(const char *buf, const char *buf_end, const char *ranges, size_t ranges_size, int *found)
+{
+    if (ranges_size > CHAR_SCAN_MAX_RANGES * 2) {
+        *found = 0;
+        return buf;
+    }
+
+    (void)pthread_once(&find_char_once, init_find_char_impl);
+    find_char_func impl = __atomic_load_n(&find_char_impl, __ATOMIC_RELAXED);
+    return impl(buf, buf_end, ranges, ranges_size, found);
+}
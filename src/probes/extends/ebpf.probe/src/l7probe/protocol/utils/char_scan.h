@@ -0,0 +1,61 @@
+/*******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: eank
+ * Create: 2023-07-20
+ * Description: SIMD byte-range scanner shared by l7 text protocol parsers
+ ******************************************************************************/
+
+#ifndef __CHAR_SCAN_H__
+#define __CHAR_SCAN_H__
+
+#pragma once
+
+#include <stddef.h>
+
+// 最多支持8组字符范围，与pcmpestri指令的能力保持一致
+#define CHAR_SCAN_MAX_RANGES 8
+
+enum char_scan_impl_t {
+    CHAR_SCAN_SCALAR = 0,
+    CHAR_SCAN_SSE42,
+    CHAR_SCAN_AVX2,
+    CHAR_SCAN_NEON,
+    CHAR_SCAN_SVE,
+
+    CHAR_SCAN_IMPL_MAX
+};
+
+/**
+ * 在[buf, buf_end)中按向量宽度查找第一个落在ranges内的字符。
+ * ranges由若干[low, high]字节对组成，ranges_size为字节数（必须为偶数）。
+ * 向量实现只处理完整的向量块，不足一个向量宽度的尾部由调用方的标量循环处理。
+ *
+ * @param buf 起始位置
+ * @param buf_end 结束位置
+ * @param ranges 字符范围
+ * @param ranges_size 字符范围字节数
+ * @param found 输出参数，找到时置1
+ * @return 找到时返回命中字符的位置，否则返回已扫描到的位置
+ */
+const char *find_char_fast(const char *buf, const char *buf_end, const char *ranges, size_t ranges_size, int *found);
+
+/**
+ * 根据CPU特性选择find_char_fast的实现，可重复调用，线程安全。
+ * 未调用时find_char_fast在首次扫描时自动选择一次。
+ *
+ * @param impl 指定实现，传入CHAR_SCAN_IMPL_MAX表示按CPU特性自动选择
+ * @return 实际生效的实现；若指定实现当前CPU不支持，则回退到自动选择结果
+ */
+enum char_scan_impl_t char_scan_select_impl(enum char_scan_impl_t impl);
+
+const char *char_scan_impl_name(enum char_scan_impl_t impl);
+
+#endif
@@ -0,0 +1,424 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-09-01
+ * Description: block device topology cache
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+
+#include "blk_topo.h"
+
+#define UEVENT_BUF_LEN      (8 * 1024)
+#define UEVENT_RCVBUF_SIZE  (1024 * 1024)
+#define UEVENT_GROUP_KERNEL 1
+#define BLK_TOPO_MAX_DEPTH  8       // partition -> disk -> dm -> md ...
+
+static int __read_sys_line(const char *dir, const char *file, char *buf, size_t size)
+{
+    int fd;
+    ssize_t len;
+    char path[PATH_MAX];
+
+    (void)snprintf(path, sizeof(path), "%s/%s", dir, file);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    len = read(fd, buf, size - 1);
+    (void)close(fd);
+    if (len <= 0) {
+        return -1;
+    }
+    buf[len] = 0;
+    SPLIT_NEWLINE_SYMBOL(buf);
+    return 0;
+}
+
+static char __has_sys_file(const char *dir, const char *file)
+{
+    char path[PATH_MAX];
+
+    (void)snprintf(path, sizeof(path), "%s/%s", dir, file);
+    return (access(path, F_OK) == 0);
+}
+
+// e.g. sda of /devices/.../block/sda/sda1
+static void __parent_name(const char *devpath, char *buf, size_t size)
+{
+    const char *end = strrchr(devpath, '/');
+    const char *start = end;
+
+    buf[0] = 0;
+    if (end == NULL) {
+        return;
+    }
+    while (start > devpath && *(start - 1) != '/') {
+        start--;
+    }
+    (void)snprintf(buf, size, "%.*s", (int)(end - start), start);
+}
+
+static void __first_dir_entry(const char *dir, const char *sub, char *buf, size_t size)
+{
+    DIR *d;
+    struct dirent *entry;
+    char path[PATH_MAX];
+
+    buf[0] = 0;
+    (void)snprintf(path, sizeof(path), "%s/%s", dir, sub);
+    d = opendir(path);
+    if (d == NULL) {
+        return;
+    }
+    while ((entry = readdir(d)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        (void)snprintf(buf, size, "%s", entry->d_name);
+        break;
+    }
+    (void)closedir(d);
+}
+
+static void __del_blk_dev(struct blk_topo_s *topo, struct blk_dev_s *dev)
+{
+    HASH_DELETE(hh, topo->devs, dev);
+    HASH_DELETE(kname_hh, topo->knames, dev);
+    free(dev);
+}
+
+static void __clear_blk_devs(struct blk_topo_s *topo)
+{
+    struct blk_dev_s *dev, *tmp;
+
+    HASH_ITER(hh, topo->devs, dev, tmp) {
+        __del_blk_dev(topo, dev);
+    }
+}
+
+static struct blk_dev_s *__find_kname(struct blk_topo_s *topo, const char *kname)
+{
+    struct blk_dev_s *dev = NULL;
+
+    HASH_FIND(kname_hh, topo->knames, kname, strlen(kname), dev);
+    return dev;
+}
+
+/* dir is the sysfs directory of the device, e.g. /sys/class/block/sda1 or /sys/devices/.../block/sda/sda1 */
+static int __load_blk_dev(struct blk_topo_s *topo, const char *kname, const char *dir)
+{
+    int major, minor;
+    char line[INT_LEN];
+    char path[PATH_MAX];
+    struct blk_dev_s *dev, *old;
+    size_t root_len = strlen(topo->sys_root);
+
+    if (__read_sys_line(dir, "dev", line, sizeof(line)) || sscanf(line, "%d:%d", &major, &minor) != 2) {
+        return -1;
+    }
+
+    dev = (struct blk_dev_s *)calloc(1, sizeof(struct blk_dev_s));
+    if (dev == NULL) {
+        return -1;
+    }
+    dev->devt = BLK_DEVT(major, minor);
+    (void)snprintf(dev->kname, sizeof(dev->kname), "%s", kname);
+    if (__read_sys_line(dir, "dm/name", dev->name, sizeof(dev->name))) {
+        (void)snprintf(dev->name, sizeof(dev->name), "%s", kname);
+    }
+    __first_dir_entry(dir, "slaves", dev->slave, sizeof(dev->slave));
+
+    if (realpath(dir, path) != NULL) {
+        (void)snprintf(dev->devpath, sizeof(dev->devpath), "%s",
+                       (strncmp(path, topo->sys_root, root_len) == 0) ? path + root_len : path);
+    }
+
+    // the directory of a partition is in the directory of its disk
+    if (__has_sys_file(dir, "partition")) {
+        dev->is_partition = 1;
+        __parent_name(dev->devpath, dev->parent, sizeof(dev->parent));
+    }
+
+    old = NULL;
+    HASH_FIND(hh, topo->devs, &dev->devt, sizeof(u32), old);
+    if (old != NULL) {
+        __del_blk_dev(topo, old);
+    }
+    old = __find_kname(topo, dev->kname);
+    if (old != NULL) {
+        __del_blk_dev(topo, old);
+    }
+    HASH_ADD(hh, topo->devs, devt, sizeof(u32), dev);
+    HASH_ADD(kname_hh, topo->knames, kname, strlen(dev->kname), dev);
+    return 0;
+}
+
+static int __load_blk_devs(struct blk_topo_s *topo)
+{
+    DIR *d;
+    struct dirent *entry;
+    char dir[PATH_MAX];
+    char path[PATH_MAX];
+    int num = 0;
+
+    (void)snprintf(dir, sizeof(dir), "%s/class/block", topo->sys_root);
+    d = opendir(dir);
+    if (d == NULL) {
+        ERROR("[BLK_TOPO] Open '%s' failed.\n", dir);
+        return -1;
+    }
+    while ((entry = readdir(d)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        (void)snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        if (__load_blk_dev(topo, entry->d_name, path) == 0) {
+            num++;
+        }
+    }
+    (void)closedir(d);
+    return num;
+}
+
+static int __open_uevent_sock(void)
+{
+    int fd;
+    int rcvbuf = UEVENT_RCVBUF_SIZE;
+    struct sockaddr_nl addr = {0};
+
+    fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (fd < 0) {
+        return -1;
+    }
+    // bursts of uevents(e.g. many LUNs are added) are not lost, they are reloaded at worst
+    (void)setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = UEVENT_GROUP_KERNEL;
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        (void)close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+struct blk_topo_s *create_blk_topo(const char *sys_root)
+{
+    struct blk_topo_s *topo;
+    char root[PATH_MAX];
+
+    topo = (struct blk_topo_s *)calloc(1, sizeof(struct blk_topo_s));
+    if (topo == NULL) {
+        return NULL;
+    }
+    topo->uevent_fd = -1;
+    if (sys_root == NULL) {
+        sys_root = BLK_TOPO_SYS_ROOT;
+    }
+    (void)snprintf(topo->sys_root, sizeof(topo->sys_root), "%s",
+                   (realpath(sys_root, root) != NULL) ? root : sys_root);
+
+    // subscribe before loading, no device is missed in between
+    if (strcmp(topo->sys_root, BLK_TOPO_SYS_ROOT) == 0) {
+        topo->uevent_fd = __open_uevent_sock();
+        if (topo->uevent_fd < 0) {
+            WARN("[BLK_TOPO] Subscribe uevents failed(%d), block devices will not be updated.\n", errno);
+        }
+    }
+
+    if (__load_blk_devs(topo) < 0) {
+        destroy_blk_topo(topo);
+        return NULL;
+    }
+    return topo;
+}
+
+void destroy_blk_topo(struct blk_topo_s *topo)
+{
+    if (topo == NULL) {
+        return;
+    }
+
+    __clear_blk_devs(topo);
+    if (topo->uevent_fd >= 0) {
+        (void)close(topo->uevent_fd);
+    }
+    free(topo);
+}
+
+/*
+ * Kernel uevent: "ACTION@DEVPATH\0ACTION=add\0DEVPATH=/devices/.../block/sda/sda1\0SUBSYSTEM=block\0MAJOR=8\0
+ * MINOR=1\0DEVNAME=sda1\0DEVTYPE=partition\0..."
+ */
+static int __handle_uevent(struct blk_topo_s *topo, const char *msg, size_t len)
+{
+    const char *action = NULL, *devpath = NULL, *subsystem = NULL;
+    int major = -1, minor = -1;
+    const char *kname;
+    char dir[PATH_MAX];
+    struct blk_dev_s *dev = NULL;
+
+    for (size_t pos = strlen(msg) + 1; pos < len; pos += strlen(msg + pos) + 1) {
+        const char *kv = msg + pos;
+        if (strncmp(kv, "ACTION=", 7) == 0) {
+            action = kv + 7;
+        } else if (strncmp(kv, "DEVPATH=", 8) == 0) {
+            devpath = kv + 8;
+        } else if (strncmp(kv, "SUBSYSTEM=", 10) == 0) {
+            subsystem = kv + 10;
+        } else if (strncmp(kv, "MAJOR=", 6) == 0) {
+            major = atoi(kv + 6);
+        } else if (strncmp(kv, "MINOR=", 6) == 0) {
+            minor = atoi(kv + 6);
+        }
+    }
+    if (action == NULL || devpath == NULL || subsystem == NULL || strcmp(subsystem, "block") != 0) {
+        return 0;
+    }
+
+    if (strcmp(action, "remove") == 0) {
+        if (major < 0 || minor < 0) {
+            return 0;
+        }
+        dev = blk_topo_find(topo, major, minor);
+        if (dev == NULL) {
+            return 0;
+        }
+        __del_blk_dev(topo, dev);
+        return 1;
+    }
+
+    if (strcmp(action, "add") != 0 && strcmp(action, "change") != 0 && strcmp(action, "move") != 0) {
+        return 0;
+    }
+    kname = strrchr(devpath, '/');
+    kname = (kname == NULL) ? devpath : kname + 1;
+    (void)snprintf(dir, sizeof(dir), "%s%s", topo->sys_root, devpath);
+    return (__load_blk_dev(topo, kname, dir) == 0) ? 1 : 0;
+}
+
+int blk_topo_update(struct blk_topo_s *topo)
+{
+    char buf[UEVENT_BUF_LEN];
+    struct sockaddr_nl addr;
+    socklen_t addr_len;
+    ssize_t len;
+    char lost = 0;
+    int num = 0;
+
+    if (topo->uevent_fd < 0) {
+        return 0;
+    }
+
+    while (1) {
+        addr_len = sizeof(addr);
+        len = recvfrom(topo->uevent_fd, buf, sizeof(buf) - 1, MSG_DONTWAIT, (struct sockaddr *)&addr, &addr_len);
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == ENOBUFS) {
+                lost = 1;
+                continue;
+            }
+            break;
+        }
+        // only trust uevents of the kernel
+        if (addr_len != sizeof(addr) || addr.nl_pid != 0) {
+            continue;
+        }
+        buf[len] = 0;
+        num += __handle_uevent(topo, buf, (size_t)len);
+    }
+
+    if (lost) {
+        INFO("[BLK_TOPO] Block uevents lost, reload block devices.\n");
+        __clear_blk_devs(topo);
+        num = __load_blk_devs(topo);
+    }
+    return num;
+}
+
+struct blk_dev_s *blk_topo_find(struct blk_topo_s *topo, int major, int minor)
+{
+    struct blk_dev_s *dev = NULL;
+    u32 devt = BLK_DEVT(major, minor);
+
+    HASH_FIND(hh, topo->devs, &devt, sizeof(u32), dev);
+    return dev;
+}
+
+void blk_topo_get_names(struct blk_topo_s *topo, int major, int minor,
+                        char *dev_name, char *disk_name, size_t size)
+{
+    struct blk_dev_s *dev, *next;
+
+    dev_name[0] = 0;
+    disk_name[0] = 0;
+    if (topo == NULL) {
+        return;
+    }
+    dev = blk_topo_find(topo, major, minor);
+    if (dev == NULL) {
+        return;
+    }
+    (void)snprintf(dev_name, size, "%s", dev->name);
+
+    // e.g. dm-0 -> sda2 -> sda
+    for (int i = 0; i < BLK_TOPO_MAX_DEPTH; i++) {
+        if (dev->is_partition) {
+            next = __find_kname(topo, dev->parent);
+        } else if (dev->slave[0] != 0) {
+            next = __find_kname(topo, dev->slave);
+        } else {
+            break;
+        }
+        if (next == NULL) {
+            break;
+        }
+        dev = next;
+    }
+    (void)snprintf(disk_name, size, "%s", dev->name);
+}
+
+char blk_topo_dev_exists(struct blk_topo_s *topo, int major, int minor)
+{
+    char path[PATH_LEN];
+
+    if (topo == NULL || blk_topo_find(topo, major, minor) != NULL) {
+        return 1;
+    }
+
+    // The topology may be a snapshot, a device missing from it is only gone if sysfs agrees.
+    (void)snprintf(path, sizeof(path), "%s/dev/block/%d:%d", topo->sys_root, major, minor);
+    return (access(path, F_OK) == 0) ? 1 : 0;
+}
+
+char blk_topo_has_devpath(struct blk_topo_s *topo, const char *str)
+{
+    struct blk_dev_s *dev, *tmp;
+
+    HASH_ITER(hh, topo->devs, dev, tmp) {
+        if (strstr(dev->devpath, str) != NULL) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,143 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-09-07
+ * Description: parallel loading of bpf skeletons and run-time selection of their programs
+ ******************************************************************************/
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <bpf/libbpf.h>
+#include <bpf/btf.h>
+
+#include "bpf.h"
+#include "bpf_load.h"
+
+#define BTF_TRACE_PREFIX    "btf_trace_"
+
+static void *__bpf_load_task(void *arg)
+{
+    struct bpf_load_task_s *task = arg;
+
+    task->ret = task->fn(task->arg);
+    return NULL;
+}
+
+int bpf_parallel_load(struct bpf_load_task_s *tasks, u32 num)
+{
+    int ret = 0;
+    pthread_t tids[BPF_LOAD_TASK_MAX];
+    char started[BPF_LOAD_TASK_MAX] = {0};
+
+    if (num > BPF_LOAD_TASK_MAX) {
+        ERROR("Too many bpf load tasks(%u).\n", num);
+        return -1;
+    }
+
+    for (u32 i = 0; i < num; i++) {
+        tasks[i].ret = 0;
+        if (pthread_create(&tids[i], NULL, __bpf_load_task, &tasks[i]) == 0) {
+            started[i] = 1;
+        }
+    }
+
+    for (u32 i = 0; i < num; i++) {
+        if (started[i]) {
+            (void)pthread_join(tids[i], NULL);
+        } else {
+            tasks[i].ret = tasks[i].fn(tasks[i].arg);
+        }
+
+        if (tasks[i].ret) {
+            ERROR("Failed to load bpf %s.\n", tasks[i].name ? tasks[i].name : "task");
+            ret = -1;
+        }
+    }
+
+    return ret;
+}
+
+// Returns 1 or 0 if the kernel BTF tells whether the raw tracepoint exists, -1 if there is no kernel BTF.
+static int __raw_tracepoint_in_btf(const char *name)
+{
+    int ret;
+    char type_name[PATH_LEN];
+    struct btf *btf;
+
+    if (access("/sys/kernel/btf/vmlinux", R_OK) != 0) {
+        return -1;
+    }
+
+    btf = libbpf_find_kernel_btf();
+    if (libbpf_get_error(btf)) {
+        return -1;
+    }
+
+    // every raw tracepoint of the kernel is described by the typedef btf_trace_<name>
+    (void)snprintf(type_name, sizeof(type_name), BTF_TRACE_PREFIX "%s", name);
+    ret = (btf__find_by_name_kind(btf, type_name, BTF_KIND_TYPEDEF) > 0) ? 1 : 0;
+    btf__free(btf);
+    return ret;
+}
+
+static char __is_raw_tracepoint_prog_supported(void)
+{
+#if (CURRENT_LIBBPF_VERSION  >= LIBBPF_VERSION(0, 8))
+    return (libbpf_probe_bpf_prog_type(BPF_PROG_TYPE_RAW_TRACEPOINT, NULL) == 1) ? 1 : 0;
+#else
+    return bpf_probe_prog_type(BPF_PROG_TYPE_RAW_TRACEPOINT, 0) ? 1 : 0;
+#endif
+}
+
+char is_raw_tracepoint_supported(const char *category, const char *name)
+{
+    int ret;
+    char path[PATH_LEN];
+
+    ret = __raw_tracepoint_in_btf(name);
+    if (ret >= 0) {
+        return (char)ret;
+    }
+
+    // Without kernel BTF, the tracepoint must exist and the kernel must support raw tracepoint programs.
+    (void)snprintf(path, sizeof(path), "/sys/kernel/tracing/events/%s/%s", category, name);
+    if (access(path, F_OK) != 0) {
+        (void)snprintf(path, sizeof(path), "/sys/kernel/debug/tracing/events/%s/%s", category, name);
+        if (access(path, F_OK) != 0) {
+            return 0;
+        }
+    }
+    return __is_raw_tracepoint_prog_supported();
+}
+
+int bpf_select_raw_tracepoint(struct bpf_object *obj, const char *category, const char *name,
+                              const char *raw_tp_prog, const char *kprobe_prog)
+{
+    char raw_tp;
+    struct bpf_program *raw_tp_p, *kprobe_p;
+
+    raw_tp_p = bpf_object__find_program_by_name(obj, raw_tp_prog);
+    kprobe_p = bpf_object__find_program_by_name(obj, kprobe_prog);
+    if (raw_tp_p == NULL || kprobe_p == NULL) {
+        ERROR("Failed to find bpf prog %s or %s.\n", raw_tp_prog, kprobe_prog);
+        return -1;
+    }
+
+    raw_tp = is_raw_tracepoint_supported(category, name);
+    if (bpf_program__set_autoload(raw_tp_p, raw_tp ? true : false) ||
+        bpf_program__set_autoload(kprobe_p, raw_tp ? false : true)) {
+        ERROR("Failed to select bpf prog for %s:%s.\n", category, name);
+        return -1;
+    }
+
+    INFO("Select bpf prog %s for %s:%s.\n", raw_tp ? raw_tp_prog : kprobe_prog, category, name);
+    return (int)raw_tp;
+}
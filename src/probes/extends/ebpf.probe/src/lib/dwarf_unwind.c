@@ -0,0 +1,1050 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-08-21
+ * Description: user stack unwinding based on .eh_frame
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gopher_elf.h"
+#include "dwarf_unwind.h"
+
+// Refer to https://refspecs.linuxfoundation.org/LSB_5.0.0/LSB-Core-generic/LSB-Core-generic/ehframechpt.html
+
+#if defined(__x86_64__)
+#define DWARF_REG_FP        6       // rbp
+#define DWARF_REG_SP        7       // rsp
+#define DWARF_REG_RA        16      // return address column
+#elif defined(__aarch64__)
+#define DWARF_REG_FP        29      // x29
+#define DWARF_REG_SP        31      // sp
+#define DWARF_REG_RA        30      // x30(lr)
+#define USER_ADDR_MASK      0x0000ffffffffffffULL  // strip pointer authentication bits
+#endif
+
+#define DW_EH_PE_absptr     0x00
+#define DW_EH_PE_uleb128    0x01
+#define DW_EH_PE_udata2     0x02
+#define DW_EH_PE_udata4     0x03
+#define DW_EH_PE_udata8     0x04
+#define DW_EH_PE_sleb128    0x09
+#define DW_EH_PE_sdata2     0x0a
+#define DW_EH_PE_sdata4     0x0b
+#define DW_EH_PE_sdata8     0x0c
+#define DW_EH_PE_pcrel      0x10
+#define DW_EH_PE_indirect   0x80
+#define DW_EH_PE_omit       0xff
+
+#define DW_CFA_advance_loc          0x40
+#define DW_CFA_offset               0x80
+#define DW_CFA_restore              0xc0
+#define DW_CFA_nop                  0x00
+#define DW_CFA_set_loc              0x01
+#define DW_CFA_advance_loc1         0x02
+#define DW_CFA_advance_loc2         0x03
+#define DW_CFA_advance_loc4         0x04
+#define DW_CFA_offset_extended      0x05
+#define DW_CFA_restore_extended     0x06
+#define DW_CFA_undefined            0x07
+#define DW_CFA_same_value           0x08
+#define DW_CFA_register             0x09
+#define DW_CFA_remember_state       0x0a
+#define DW_CFA_restore_state        0x0b
+#define DW_CFA_def_cfa              0x0c
+#define DW_CFA_def_cfa_register     0x0d
+#define DW_CFA_def_cfa_offset       0x0e
+#define DW_CFA_def_cfa_expression   0x0f
+#define DW_CFA_expression           0x10
+#define DW_CFA_offset_extended_sf   0x11
+#define DW_CFA_def_cfa_sf           0x12
+#define DW_CFA_def_cfa_offset_sf    0x13
+#define DW_CFA_val_offset           0x14
+#define DW_CFA_val_offset_sf        0x15
+#define DW_CFA_val_expression       0x16
+#define DW_CFA_AARCH64_negate_ra_state  0x2d
+#define DW_CFA_GNU_args_size        0x2e
+#define DW_CFA_GNU_negative_offset_extended 0x2f
+
+#define DW_OP_breg7         0x77
+#define DW_OP_breg16        0x80
+#define DW_OP_lit15         0x3f
+#define DW_OP_and           0x1a
+#define DW_OP_lit0          0x30
+#define DW_OP_ge            0x2a
+#define DW_OP_lit3          0x33
+#define DW_OP_shl           0x24
+#define DW_OP_plus          0x22
+
+#define CFI_STATE_STACK_DEPTH   8
+#define UNWIND_ROWS_STEP        1024
+
+enum cfi_rule_e {
+    CFI_RULE_SAME = 0,      // unchanged by the function
+    CFI_RULE_OFFSET,        // saved at CFA + offset
+    CFI_RULE_UNDEF,         // undefined(outermost frame for ra)
+    CFI_RULE_OTHER          // register/expression rules, not supported
+};
+
+struct cfi_rule_s {
+    u8 type;
+    s64 offset;
+};
+
+struct cfi_state_s {
+    u8 cfa_type;            // enum unwind_cfa_e
+    u64 cfa_reg;
+    s64 cfa_offset;
+    struct cfi_rule_s fp;
+    struct cfi_rule_s ra;
+};
+
+struct cfi_reader_s {
+    const u8 *base;         // start of .eh_frame
+    const u8 *pos;
+    const u8 *end;
+    u64 base_addr;          // vaddr of .eh_frame
+};
+
+struct cie_s {
+    u64 code_align;
+    s64 data_align;
+    u64 ra_reg;
+    u8 fde_enc;
+    u8 has_aug_data;
+    const u8 *insn;
+    const u8 *insn_end;
+};
+
+// Unwind rows while building, pc is absolute here.
+struct unwind_build_s {
+    u64 *pcs;
+    struct unwind_row_s *rows;
+    u32 count;
+    u32 capability;
+    u32 fde_start;          // first row of the FDE being parsed
+};
+
+static int __rd_u8(struct cfi_reader_s *r, u8 *v)
+{
+    if (r->pos + sizeof(u8) > r->end) {
+        return -1;
+    }
+    *v = *r->pos;
+    r->pos += sizeof(u8);
+    return 0;
+}
+
+static int __rd_bytes(struct cfi_reader_s *r, void *v, size_t size)
+{
+    if (r->pos + size > r->end) {
+        return -1;
+    }
+    memcpy(v, r->pos, size);
+    r->pos += size;
+    return 0;
+}
+
+static int __rd_uleb(struct cfi_reader_s *r, u64 *v)
+{
+    u8 byte;
+    u32 shift = 0;
+
+    *v = 0;
+    do {
+        if (__rd_u8(r, &byte)) {
+            return -1;
+        }
+        if (shift < 64) {
+            *v |= (u64)(byte & 0x7f) << shift;
+        }
+        shift += 7;
+    } while (byte & 0x80);
+    return 0;
+}
+
+static int __rd_sleb(struct cfi_reader_s *r, s64 *v)
+{
+    u8 byte;
+    u32 shift = 0;
+    u64 val = 0;
+
+    do {
+        if (__rd_u8(r, &byte)) {
+            return -1;
+        }
+        if (shift < 64) {
+            val |= (u64)(byte & 0x7f) << shift;
+        }
+        shift += 7;
+    } while (byte & 0x80);
+
+    if (shift < 64 && (byte & 0x40)) {
+        val |= ~0ULL << shift;
+    }
+    *v = (s64)val;
+    return 0;
+}
+
+static int __rd_encoded(struct cfi_reader_s *r, u8 enc, u64 *v)
+{
+    u16 u16_val;
+    u32 u32_val;
+    s64 s64_val;
+    const u8 *field = r->pos;
+
+    *v = 0;
+    if (enc == DW_EH_PE_omit) {
+        return 0;
+    }
+
+    switch (enc & 0x0f) {
+        case DW_EH_PE_absptr:
+        case DW_EH_PE_udata8:
+        case DW_EH_PE_sdata8:
+            if (__rd_bytes(r, v, sizeof(u64))) {
+                return -1;
+            }
+            break;
+        case DW_EH_PE_udata2:
+            if (__rd_bytes(r, &u16_val, sizeof(u16))) {
+                return -1;
+            }
+            *v = u16_val;
+            break;
+        case DW_EH_PE_sdata2:
+            if (__rd_bytes(r, &u16_val, sizeof(u16))) {
+                return -1;
+            }
+            *v = (u64)(s64)(s16)u16_val;
+            break;
+        case DW_EH_PE_udata4:
+            if (__rd_bytes(r, &u32_val, sizeof(u32))) {
+                return -1;
+            }
+            *v = u32_val;
+            break;
+        case DW_EH_PE_sdata4:
+            if (__rd_bytes(r, &u32_val, sizeof(u32))) {
+                return -1;
+            }
+            *v = (u64)(s64)(int)u32_val;
+            break;
+        case DW_EH_PE_uleb128:
+            if (__rd_uleb(r, v)) {
+                return -1;
+            }
+            break;
+        case DW_EH_PE_sleb128:
+            if (__rd_sleb(r, &s64_val)) {
+                return -1;
+            }
+            *v = (u64)s64_val;
+            break;
+        default:
+            return -1;
+    }
+
+    // datarel/textrel/funcrel never show up in .eh_frame of x86_64/aarch64.
+    switch (enc & 0x70) {
+        case 0:
+            break;
+        case DW_EH_PE_pcrel:
+            *v += r->base_addr + (u64)(field - r->base);
+            break;
+        default:
+            return -1;
+    }
+
+    if (enc & DW_EH_PE_indirect) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Read the length of a CIE/FDE record, r->pos is left at the CIE id/CIE pointer.
+ * Returns the end of the record, NULL for the terminator or a malformed record.
+ */
+static const u8 *__rd_record_len(struct cfi_reader_s *r)
+{
+    u32 len32;
+    u64 len;
+
+    if (__rd_bytes(r, &len32, sizeof(u32))) {
+        return NULL;
+    }
+    if (len32 == 0) {
+        return NULL;
+    }
+    if (len32 == 0xffffffff) {
+        if (__rd_bytes(r, &len, sizeof(u64))) {
+            return NULL;
+        }
+    } else {
+        len = len32;
+    }
+    if (len > (u64)(r->end - r->pos)) {
+        return NULL;
+    }
+    return r->pos + len;
+}
+
+static int __parse_cie(const struct cfi_reader_s *eh, const u8 *cie_pos, struct cie_s *cie)
+{
+    u8 version, byte, ptr_enc;
+    u32 cie_id;
+    u64 val, aug_len;
+    const char *aug;
+    const u8 *rec_end, *aug_end = NULL;
+    struct cfi_reader_s r = *eh;
+
+    r.pos = cie_pos;
+    rec_end = __rd_record_len(&r);
+    if (rec_end == NULL) {
+        return -1;
+    }
+    r.end = rec_end;
+
+    if (__rd_bytes(&r, &cie_id, sizeof(u32)) || cie_id != 0) {
+        return -1;
+    }
+    if (__rd_u8(&r, &version) || (version != 1 && version != 3)) {
+        return -1;
+    }
+
+    aug = (const char *)r.pos;
+    while (r.pos < r.end && *r.pos != 0) {
+        r.pos++;
+    }
+    if (r.pos >= r.end) {
+        return -1;
+    }
+    r.pos++;
+
+    memset(cie, 0, sizeof(struct cie_s));
+    cie->fde_enc = DW_EH_PE_absptr;
+    if (__rd_uleb(&r, &cie->code_align) || __rd_sleb(&r, &cie->data_align)) {
+        return -1;
+    }
+    if (version == 1) {
+        if (__rd_u8(&r, &byte)) {
+            return -1;
+        }
+        cie->ra_reg = byte;
+    } else if (__rd_uleb(&r, &cie->ra_reg)) {
+        return -1;
+    }
+
+    for (const char *c = aug; *c != 0; c++) {
+        switch (*c) {
+            case 'z':
+                if (__rd_uleb(&r, &aug_len) || aug_len > (u64)(r.end - r.pos)) {
+                    return -1;
+                }
+                cie->has_aug_data = 1;
+                aug_end = r.pos + aug_len;
+                break;
+            case 'R':
+                if (__rd_u8(&r, &cie->fde_enc)) {
+                    return -1;
+                }
+                break;
+            case 'P':
+                if (__rd_u8(&r, &ptr_enc) || __rd_encoded(&r, ptr_enc & ~DW_EH_PE_indirect, &val)) {
+                    return -1;
+                }
+                break;
+            case 'L':
+                if (__rd_u8(&r, &byte)) {
+                    return -1;
+                }
+                break;
+            case 'S':
+            case 'B':
+                break;
+            default:
+                // Unknown augmentation, its data can only be skipped with 'z'.
+                if (aug_end == NULL) {
+                    return -1;
+                }
+                r.pos = aug_end;
+                goto out;
+        }
+    }
+out:
+    if (aug_end) {
+        r.pos = aug_end;
+    }
+    cie->insn = r.pos;
+    cie->insn_end = r.end;
+    return 0;
+}
+
+static void __set_rule(struct cfi_state_s *state, u64 reg, u8 type, s64 offset)
+{
+    struct cfi_rule_s *rule;
+
+    if (reg == DWARF_REG_FP) {
+        rule = &state->fp;
+    } else if (reg == DWARF_REG_RA) {
+        rule = &state->ra;
+    } else {
+        return;
+    }
+    rule->type = type;
+    rule->offset = offset;
+}
+
+static void __restore_rule(struct cfi_state_s *state, const struct cfi_state_s *init, u64 reg)
+{
+    if (reg == DWARF_REG_FP) {
+        state->fp = init->fp;
+    } else if (reg == DWARF_REG_RA) {
+        state->ra = init->ra;
+    }
+}
+
+static void __set_cfa_reg(struct cfi_state_s *state, u64 reg)
+{
+    state->cfa_reg = reg;
+    if (reg == DWARF_REG_SP) {
+        state->cfa_type = UNWIND_CFA_SP;
+    } else if (reg == DWARF_REG_FP) {
+        state->cfa_type = UNWIND_CFA_FP;
+    } else {
+        state->cfa_type = UNWIND_CFA_UNDEF;
+    }
+}
+
+/*
+ * The only CFA expression worth supporting, gcc/ld emit it for every x86_64 PLT:
+ * DW_OP_breg7(rsp) 8; DW_OP_breg16(rip) 0; DW_OP_lit15; DW_OP_and; DW_OP_lit11(or lit10);
+ * DW_OP_ge; DW_OP_lit3; DW_OP_shl; DW_OP_plus
+ */
+static void __def_cfa_expression(struct cfi_state_s *state, const u8 *expr, u64 len)
+{
+    state->cfa_type = UNWIND_CFA_UNDEF;
+#if defined(__x86_64__)
+    if (len == 11 && expr[0] == DW_OP_breg7 && expr[1] == 8 && expr[2] == DW_OP_breg16 && expr[3] == 0 &&
+        expr[4] == DW_OP_lit15 && expr[5] == DW_OP_and && expr[6] >= DW_OP_lit3 && expr[6] <= DW_OP_lit15 &&
+        expr[7] == DW_OP_ge && expr[8] == DW_OP_lit3 && expr[9] == DW_OP_shl && expr[10] == DW_OP_plus) {
+        state->cfa_type = UNWIND_CFA_PLT;
+        state->cfa_offset = expr[6] - DW_OP_lit0;
+    }
+#endif
+}
+
+static int __emit_row(struct unwind_build_s *build, u64 pc, const struct cfi_state_s *state)
+{
+    struct unwind_row_s row = {0};
+    struct unwind_row_s *last;
+
+    row.cfa_type = state->cfa_type;
+    row.cfa_offset = (int)state->cfa_offset;
+    if (state->cfa_type != UNWIND_CFA_UNDEF && (s64)row.cfa_offset != state->cfa_offset) {
+        row.cfa_type = UNWIND_CFA_UNDEF;
+    }
+
+    if (state->ra.type == CFI_RULE_UNDEF) {
+        row.cfa_type = UNWIND_CFA_END;
+    } else if (state->ra.type == CFI_RULE_OFFSET && state->ra.offset != 0 &&
+        (s64)(s16)state->ra.offset == state->ra.offset) {
+        row.ra_offset = (s16)state->ra.offset;
+    } else if (state->ra.type == CFI_RULE_SAME) {
+#if defined(__aarch64__)
+        row.ra_offset = UNWIND_RA_IN_LR;
+#else
+        row.cfa_type = UNWIND_CFA_UNDEF;
+#endif
+    } else {
+        row.cfa_type = UNWIND_CFA_UNDEF;
+    }
+
+    if (state->fp.type == CFI_RULE_OFFSET && (s64)(s16)state->fp.offset == state->fp.offset) {
+        row.fp_offset = (s16)state->fp.offset;
+    } else if (state->fp.type != CFI_RULE_SAME) {
+        row.cfa_type = UNWIND_CFA_UNDEF;
+    }
+
+    if (row.cfa_type == UNWIND_CFA_UNDEF) {
+        row.cfa_offset = 0;
+        row.fp_offset = 0;
+        row.ra_offset = 0;
+    }
+
+    // FDEs are not sorted, rows are only merged within one FDE.
+    if (build->count > build->fde_start) {
+        last = &build->rows[build->count - 1];
+        if (build->pcs[build->count - 1] == pc) {
+            *last = row;
+            return 0;
+        }
+        if (!memcmp(last, &row, sizeof(row))) {
+            return 0;
+        }
+    }
+
+    if (build->count >= build->capability) {
+        u32 new_cap = build->capability + UNWIND_ROWS_STEP;
+        u64 *pcs = (u64 *)realloc(build->pcs, new_cap * sizeof(u64));
+        if (!pcs) {
+            return -1;
+        }
+        build->pcs = pcs;
+        struct unwind_row_s *rows = (struct unwind_row_s *)realloc(build->rows, new_cap * sizeof(struct unwind_row_s));
+        if (!rows) {
+            return -1;
+        }
+        build->rows = rows;
+        build->capability = new_cap;
+    }
+    build->pcs[build->count] = pc;
+    build->rows[build->count] = row;
+    build->count++;
+    return 0;
+}
+
+/*
+ * Execute CFA instructions from loc, rows are emitted only when build is not NULL(FDE instructions).
+ */
+static int __exec_cfi(struct cfi_reader_s *r, const struct cie_s *cie, const struct cfi_state_s *init,
+    struct cfi_state_s *state, u64 *loc, struct unwind_build_s *build)
+{
+    u8 op, byte;
+    u16 u16_val;
+    u32 u32_val;
+    u64 reg, uval, delta;
+    s64 sval;
+    u32 depth = 0;
+    struct cfi_state_s stack[CFI_STATE_STACK_DEPTH];
+
+    while (r->pos < r->end) {
+        (void)__rd_u8(r, &op);
+        delta = 0;
+
+        switch (op & 0xc0) {
+            case DW_CFA_advance_loc:
+                delta = (op & 0x3f) * cie->code_align;
+                goto advance;
+            case DW_CFA_offset:
+                if (__rd_uleb(r, &uval)) {
+                    return -1;
+                }
+                __set_rule(state, op & 0x3f, CFI_RULE_OFFSET, (s64)uval * cie->data_align);
+                continue;
+            case DW_CFA_restore:
+                __restore_rule(state, init, op & 0x3f);
+                continue;
+            default:
+                break;
+        }
+
+        switch (op) {
+            case DW_CFA_nop:
+            case DW_CFA_AARCH64_negate_ra_state:
+                break;
+            case DW_CFA_set_loc:
+                if (__rd_encoded(r, cie->fde_enc, &uval) || uval < *loc) {
+                    return -1;
+                }
+                delta = uval - *loc;
+                goto advance;
+            case DW_CFA_advance_loc1:
+                if (__rd_u8(r, &byte)) {
+                    return -1;
+                }
+                delta = byte * cie->code_align;
+                goto advance;
+            case DW_CFA_advance_loc2:
+                if (__rd_bytes(r, &u16_val, sizeof(u16))) {
+                    return -1;
+                }
+                delta = u16_val * cie->code_align;
+                goto advance;
+            case DW_CFA_advance_loc4:
+                if (__rd_bytes(r, &u32_val, sizeof(u32))) {
+                    return -1;
+                }
+                delta = u32_val * cie->code_align;
+                goto advance;
+            case DW_CFA_offset_extended:
+                if (__rd_uleb(r, &reg) || __rd_uleb(r, &uval)) {
+                    return -1;
+                }
+                __set_rule(state, reg, CFI_RULE_OFFSET, (s64)uval * cie->data_align);
+                break;
+            case DW_CFA_offset_extended_sf:
+                if (__rd_uleb(r, &reg) || __rd_sleb(r, &sval)) {
+                    return -1;
+                }
+                __set_rule(state, reg, CFI_RULE_OFFSET, sval * cie->data_align);
+                break;
+            case DW_CFA_GNU_negative_offset_extended:
+                if (__rd_uleb(r, &reg) || __rd_uleb(r, &uval)) {
+                    return -1;
+                }
+                __set_rule(state, reg, CFI_RULE_OFFSET, -(s64)uval * cie->data_align);
+                break;
+            case DW_CFA_restore_extended:
+                if (__rd_uleb(r, &reg)) {
+                    return -1;
+                }
+                __restore_rule(state, init, reg);
+                break;
+            case DW_CFA_undefined:
+                if (__rd_uleb(r, &reg)) {
+                    return -1;
+                }
+                __set_rule(state, reg, CFI_RULE_UNDEF, 0);
+                break;
+            case DW_CFA_same_value:
+                if (__rd_uleb(r, &reg)) {
+                    return -1;
+                }
+                __set_rule(state, reg, CFI_RULE_SAME, 0);
+                break;
+            case DW_CFA_register:
+                if (__rd_uleb(r, &reg) || __rd_uleb(r, &uval)) {
+                    return -1;
+                }
+                __set_rule(state, reg, CFI_RULE_OTHER, 0);
+                break;
+            case DW_CFA_remember_state:
+                if (depth >= CFI_STATE_STACK_DEPTH) {
+                    return -1;
+                }
+                stack[depth++] = *state;
+                break;
+            case DW_CFA_restore_state:
+                if (depth == 0) {
+                    return -1;
+                }
+                // Like libgcc the CFA is remembered too, epilogues rely on it.
+                *state = stack[--depth];
+                break;
+            case DW_CFA_def_cfa:
+                if (__rd_uleb(r, &reg) || __rd_uleb(r, &uval)) {
+                    return -1;
+                }
+                __set_cfa_reg(state, reg);
+                state->cfa_offset = (s64)uval;
+                break;
+            case DW_CFA_def_cfa_sf:
+                if (__rd_uleb(r, &reg) || __rd_sleb(r, &sval)) {
+                    return -1;
+                }
+                __set_cfa_reg(state, reg);
+                state->cfa_offset = sval * cie->data_align;
+                break;
+            case DW_CFA_def_cfa_register:
+                if (__rd_uleb(r, &reg)) {
+                    return -1;
+                }
+                __set_cfa_reg(state, reg);
+                break;
+            case DW_CFA_def_cfa_offset:
+                if (__rd_uleb(r, &uval)) {
+                    return -1;
+                }
+                state->cfa_offset = (s64)uval;
+                break;
+            case DW_CFA_def_cfa_offset_sf:
+                if (__rd_sleb(r, &sval)) {
+                    return -1;
+                }
+                state->cfa_offset = sval * cie->data_align;
+                break;
+            case DW_CFA_def_cfa_expression:
+                if (__rd_uleb(r, &uval) || uval > (u64)(r->end - r->pos)) {
+                    return -1;
+                }
+                __def_cfa_expression(state, r->pos, uval);
+                r->pos += uval;
+                break;
+            case DW_CFA_expression:
+            case DW_CFA_val_expression:
+                if (__rd_uleb(r, &reg) || __rd_uleb(r, &uval) || uval > (u64)(r->end - r->pos)) {
+                    return -1;
+                }
+                __set_rule(state, reg, CFI_RULE_OTHER, 0);
+                r->pos += uval;
+                break;
+            case DW_CFA_val_offset:
+                if (__rd_uleb(r, &reg) || __rd_uleb(r, &uval)) {
+                    return -1;
+                }
+                __set_rule(state, reg, CFI_RULE_OTHER, 0);
+                break;
+            case DW_CFA_val_offset_sf:
+                if (__rd_uleb(r, &reg) || __rd_sleb(r, &sval)) {
+                    return -1;
+                }
+                __set_rule(state, reg, CFI_RULE_OTHER, 0);
+                break;
+            case DW_CFA_GNU_args_size:
+                if (__rd_uleb(r, &uval)) {
+                    return -1;
+                }
+                break;
+            default:
+                return -1;
+        }
+        continue;
+
+advance:
+        if (build && __emit_row(build, *loc, state)) {
+            return -1;
+        }
+        *loc += delta;
+    }
+    return 0;
+}
+
+static int __parse_fde(const struct cfi_reader_s *eh, const struct cie_s *cie, struct cfi_reader_s *r,
+    struct unwind_build_s *build)
+{
+    u64 pc_begin, pc_range, aug_len, loc;
+    struct cfi_state_s init = {0}, state;
+    struct cfi_reader_s cie_r = *eh;
+
+    if (__rd_encoded(r, cie->fde_enc, &pc_begin) || __rd_encoded(r, cie->fde_enc & 0x0f, &pc_range)) {
+        return -1;
+    }
+    if (pc_begin == 0 || pc_range == 0) {
+        return 0;   // discarded by the linker
+    }
+    if (cie->has_aug_data) {
+        if (__rd_uleb(r, &aug_len) || aug_len > (u64)(r->end - r->pos)) {
+            return -1;
+        }
+        r->pos += aug_len;
+    }
+
+    // Initial instructions of the CIE set up the state every FDE starts with.
+    cie_r.pos = cie->insn;
+    cie_r.end = cie->insn_end;
+    loc = pc_begin;
+    if (__exec_cfi(&cie_r, cie, &init, &init, &loc, NULL)) {
+        return -1;
+    }
+
+    state = init;
+    loc = pc_begin;
+    if (__exec_cfi(r, cie, &init, &state, &loc, build)) {
+        return -1;
+    }
+    if (loc < pc_begin + pc_range && __emit_row(build, loc, &state)) {
+        return -1;
+    }
+
+    // Close the FDE, the next FDE starting here overrides it after sorting.
+    state.cfa_type = UNWIND_CFA_UNDEF;
+    state.ra.type = CFI_RULE_OTHER;
+    return __emit_row(build, pc_begin + pc_range, &state);
+}
+
+struct unwind_sort_s {
+    u64 pc;
+    u32 seq;
+    u32 idx;
+};
+
+static int __unwind_sort_cmp(const void *a, const void *b)
+{
+    const struct unwind_sort_s *sa = (const struct unwind_sort_s *)a;
+    const struct unwind_sort_s *sb = (const struct unwind_sort_s *)b;
+
+    if (sa->pc != sb->pc) {
+        return sa->pc < sb->pc ? -1 : 1;
+    }
+    return sa->seq < sb->seq ? -1 : (sa->seq > sb->seq ? 1 : 0);
+}
+
+/*
+ * Sort rows by pc. For rows of the same pc the real one beats the UNDEF end of the previous FDE,
+ * otherwise the later row wins. Rows identical to their predecessor are dropped.
+ */
+static struct unwind_tbl_s *__build_unwind_tbl(struct unwind_build_s *build)
+{
+    u32 i, count = 0;
+    struct unwind_sort_s *sorted;
+    struct unwind_row_s *row, *last = NULL;
+    struct unwind_tbl_s *tbl;
+
+    tbl = (struct unwind_tbl_s *)calloc(1, sizeof(struct unwind_tbl_s));
+    if (!tbl) {
+        return NULL;
+    }
+    if (build->count == 0) {
+        return tbl;
+    }
+
+    sorted = (struct unwind_sort_s *)malloc(build->count * sizeof(struct unwind_sort_s));
+    tbl->rows = (struct unwind_row_s *)malloc(build->count * sizeof(struct unwind_row_s));
+    if (!sorted || !tbl->rows) {
+        free(sorted);
+        destroy_unwind_tbl(tbl);
+        return NULL;
+    }
+
+    for (i = 0; i < build->count; i++) {
+        sorted[i].pc = build->pcs[i];
+        sorted[i].idx = i;
+        sorted[i].seq = (build->rows[i].cfa_type == UNWIND_CFA_UNDEF) ? i : (build->count + i);
+    }
+    qsort(sorted, build->count, sizeof(struct unwind_sort_s), __unwind_sort_cmp);
+
+    tbl->base_pc = sorted[0].pc;
+    for (i = 0; i < build->count; i++) {
+        if (sorted[i].pc - tbl->base_pc > (u64)0xffffffff) {
+            break;
+        }
+        row = &build->rows[sorted[i].idx];
+        row->pc_off = (u32)(sorted[i].pc - tbl->base_pc);
+        if (last && last->pc_off == row->pc_off) {
+            *last = *row;
+            // A replaced row may now repeat the one before it.
+            if (count >= 2 && !memcmp(&tbl->rows[count - 2].cfa_offset, &last->cfa_offset,
+                sizeof(struct unwind_row_s) - sizeof(u32))) {
+                count--;
+                last = &tbl->rows[count - 1];
+            }
+            continue;
+        }
+        if (last && !memcmp(&last->cfa_offset, &row->cfa_offset, sizeof(struct unwind_row_s) - sizeof(u32))) {
+            continue;
+        }
+        tbl->rows[count] = *row;
+        last = &tbl->rows[count];
+        count++;
+    }
+    tbl->count = count;
+    free(sorted);
+    return tbl;
+}
+
+struct unwind_tbl_s *create_unwind_tbl(const char *eh_frame, size_t len, u64 eh_frame_addr)
+{
+#if defined(DWARF_REG_RA)
+    u32 cie_ptr;
+    const u8 *rec_end, *cie_pos, *last_cie_pos = NULL;
+    struct cie_s cie;
+    struct cfi_reader_s eh, r;
+    struct unwind_build_s build = {0};
+    struct unwind_tbl_s *tbl;
+
+    eh.base = (const u8 *)eh_frame;
+    eh.pos = eh.base;
+    eh.end = eh.base + len;
+    eh.base_addr = eh_frame_addr;
+
+    r = eh;
+    while (r.pos < r.end) {
+        rec_end = __rd_record_len(&r);
+        if (rec_end == NULL) {
+            break;
+        }
+        cie_pos = r.pos;
+        if (__rd_bytes(&r, &cie_ptr, sizeof(u32))) {
+            break;
+        }
+        if (cie_ptr != 0) {
+            // FDE, the CIE pointer is relative to the pointer field itself.
+            cie_pos = cie_pos - cie_ptr;
+            if (cie_pos < eh.base || cie_pos >= eh.end) {
+                goto next;
+            }
+            if (cie_pos != last_cie_pos) {
+                if (__parse_cie(&eh, cie_pos, &cie)) {
+                    last_cie_pos = NULL;
+                    goto next;
+                }
+                last_cie_pos = cie_pos;
+            }
+
+            struct cfi_reader_s fde_r = r;
+            fde_r.end = rec_end;
+            // A malformed FDE is dropped along with the rows it has emitted.
+            build.fde_start = build.count;
+            if (__parse_fde(&eh, &cie, &fde_r, &build)) {
+                build.count = build.fde_start;
+            }
+        }
+next:
+        r.pos = rec_end;
+    }
+
+    tbl = __build_unwind_tbl(&build);
+    free(build.pcs);
+    free(build.rows);
+    return tbl;
+#else
+    return NULL;
+#endif
+}
+
+struct unwind_tbl_s *load_unwind_tbl(const char *elf)
+{
+    u64 sec_addr = 0;
+    char *buf = NULL;
+    size_t len = 0;
+    struct unwind_tbl_s *tbl;
+
+    if (gopher_get_elf_section_copy(elf, ".eh_frame", &sec_addr, &buf, &len)) {
+        return NULL;
+    }
+
+    tbl = create_unwind_tbl(buf, len, sec_addr);
+    (void)free(buf);
+    if (tbl) {
+        DEBUG("[DWARF_UNWIND]: Load %u unwind rows from %s.\n", tbl->count, elf);
+    }
+    return tbl;
+}
+
+void destroy_unwind_tbl(struct unwind_tbl_s *tbl)
+{
+    if (!tbl) {
+        return;
+    }
+    if (tbl->rows) {
+        (void)free(tbl->rows);
+    }
+    (void)free(tbl);
+}
+
+const struct unwind_row_s *search_unwind_row(const struct unwind_tbl_s *tbl, u64 pc)
+{
+    u32 lo = 0, hi, mid;
+    u64 off;
+
+    if (!tbl || tbl->count == 0 || pc < tbl->base_pc) {
+        return NULL;
+    }
+    off = pc - tbl->base_pc;
+    if (off > (u64)0xffffffff) {
+        return NULL;
+    }
+
+    // upper bound of off
+    hi = tbl->count;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (tbl->rows[mid].pc_off <= (u32)off) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0) {
+        return NULL;
+    }
+    return &tbl->rows[lo - 1];
+}
+
+static int __read_stack(const struct unwind_stack_s *stack, u64 addr, u64 *val)
+{
+    if (addr < stack->sp || addr + sizeof(u64) > stack->sp + stack->len) {
+        return -1;
+    }
+    memcpy(val, stack->data + (addr - stack->sp), sizeof(u64));
+    return 0;
+}
+
+// Unwind tables are cached with the elf symbols, so processes mapping the same elf share them.
+static const struct unwind_tbl_s *__get_mod_unwind_tbl(struct mod_s *mod)
+{
+    struct elf_symbo_s *elf_symbo = mod->mod_symbs;
+
+    if (!elf_symbo) {
+        return NULL;
+    }
+    if (!elf_symbo->unwind_loaded && mod->mod_path) {
+        elf_symbo->unwind_tbl = load_unwind_tbl(mod->mod_path);
+        elf_symbo->unwind_loaded = 1;
+    }
+    return elf_symbo->unwind_tbl;
+}
+
+int proc_unwind_user_stack(struct proc_symbs_s *proc_symbs, const struct unwind_regs_s *regs,
+    const struct unwind_stack_s *stack, u64 ips[], u32 max_depth)
+{
+    u32 depth = 0;
+    u64 ip = regs->ip, sp = regs->sp, fp = regs->fp, cfa = 0, ra = 0, next_fp, target_addr;
+    struct mod_s *mod;
+    const struct unwind_row_s *row;
+
+    while (depth < max_depth && ip != 0) {
+        ips[depth++] = ip;
+
+        // Return addresses point after the call, look up the call instruction instead.
+        row = NULL;
+        mod = proc_get_mod_by_addr(proc_symbs, (depth == 1) ? ip : ip - 1, &target_addr);
+        if (mod) {
+            row = search_unwind_row(__get_mod_unwind_tbl(mod), target_addr);
+        }
+
+        if (row && row->cfa_type == UNWIND_CFA_END) {
+            break;
+        }
+
+        if (!row || row->cfa_type == UNWIND_CFA_UNDEF) {
+            // No unwind info, fall back to the frame pointer chain.
+            if (fp == 0 || __read_stack(stack, fp, &next_fp) || __read_stack(stack, fp + sizeof(u64), &ra)) {
+                break;
+            }
+            cfa = fp + 2 * sizeof(u64);
+            fp = next_fp;
+        } else {
+            switch (row->cfa_type) {
+                case UNWIND_CFA_SP:
+                    cfa = sp + row->cfa_offset;
+                    break;
+                case UNWIND_CFA_FP:
+                    cfa = fp + row->cfa_offset;
+                    break;
+                case UNWIND_CFA_PLT:
+                    cfa = sp + sizeof(u64) + (((target_addr & 15) >= (u64)row->cfa_offset) ? sizeof(u64) : 0);
+                    break;
+                default:
+                    break;
+            }
+
+            if (row->ra_offset == UNWIND_RA_IN_LR) {
+                // lr only holds the return address in the interrupted frame.
+                if (depth != 1) {
+                    break;
+                }
+                ra = regs->lr;
+            } else if (__read_stack(stack, cfa + row->ra_offset, &ra)) {
+                break;
+            }
+
+            if (row->fp_offset != 0 && __read_stack(stack, cfa + row->fp_offset, &fp)) {
+                break;
+            }
+        }
+
+        // The stack grows down, a caller frame never lies below its callee.
+        if (cfa < sp || (cfa == sp && ra == ip)) {
+            break;
+        }
+        sp = cfa;
+#if defined(USER_ADDR_MASK)
+        ra &= USER_ADDR_MASK;
+#endif
+        ip = ra;
+    }
+
+    return (int)depth;
+}
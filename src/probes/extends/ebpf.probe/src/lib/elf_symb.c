@@ -19,12 +19,16 @@
 #include <unistd.h>
 #include <ctype.h>
 #include <string.h>
+#include <limits.h>
 #include <time.h>
 
 #include <sys/ioctl.h>
 #include <sys/wait.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
+#include <dirent.h>
 
 #ifdef BPF_PROG_KERN
 #undef BPF_PROG_KERN
@@ -38,6 +42,7 @@
 #include "container.h"
 #include "gopher_elf.h"
 #include "elf_symb.h"
+#include "dwarf_unwind.h"
 
 static struct elf_symbo_s* __head = NULL;
 
@@ -47,25 +52,29 @@ static struct elf_symbo_s* __head = NULL;
 #define symbs   __symbs
 
 #if 1
-#define __STAT_INODE "/usr/bin/stat --format=%%i %s"
-int __get_inode(const char *elf, u32 *inode)
+static int __get_symb_key(const char *elf, enum sym_file_t sym_file_type, struct elf_symb_key_s *key)
 {
-    char command[COMMAND_LEN];
-    char inode_s[INT_LEN];
+    struct stat st;
 
-    if (access(elf, 0) != 0) {
+    if (stat(elf, &st) != 0) {
         return -1;
     }
 
-    command[0] = 0;
-    inode_s[0] = 0;
-    (void)snprintf(command, COMMAND_LEN, __STAT_INODE, elf);
+    (void)memset(key, 0, sizeof(struct elf_symb_key_s));
+    key->sym_type = (u32)sym_file_type;
 
-    if (exec_cmd((const char *)command, inode_s, INT_LEN) < 0) {
-        return -1;
+    if (sym_file_type != JAVA_SYM) {
+        // Identical binaries share one symbol table, no matter which container/path they are mapped from.
+        if (gopher_get_elf_build_id(elf, key->build_id, ELF_BUILD_ID_LEN) == 0 && key->build_id[0] != 0) {
+            return 0;
+        }
+        (void)memset(key->build_id, 0, ELF_BUILD_ID_LEN);
+        key->mtime = (s64)st.st_mtime;
+        key->size = (s64)st.st_size;
     }
 
-    *inode = (u32)atoi((const char *)inode_s);
+    key->dev = (u64)st.st_dev;
+    key->ino = (u64)st.st_ino;
     return 0;
 }
 
@@ -82,6 +91,422 @@ static void __symb_destroy(struct symb_s *symb)
     return;
 }
 
+#define SYMB_CACHE_DIR      "/var/run/gala-gopher/symbs"
+#define SYMB_CACHE_MAGIC    0x424d5953  // "SYMB"
+#define SYMB_CACHE_VERSION  2
+#define SYMB_CACHE_MAX_SIZE (64 * 1024 * 1024)  // the cache dir is on tmpfs, it is kept in memory
+#define __ALIGN8(x)         (((x) + 7) & ~((size_t)7))
+
+/*
+ * On-disk symbol cache file, the same layout is used for the in-memory table:
+ * | hdr | eytz_start[count + 1] | start[count] | size[count] | max_end[count] | eytz_rank[count + 1] | name_off[count]
+ * | strtab |
+ */
+struct symb_cache_hdr_s {
+    u32 magic;
+    u32 version;
+    u32 count;
+    u32 strtab_len;
+    u32 sym_type;
+    char build_id[ELF_BUILD_ID_LEN];
+};
+
+struct symb_tbl_layout_s {
+    size_t eytz_start;
+    size_t start;
+    size_t size;
+    size_t max_end;
+    size_t eytz_rank;
+    size_t name_off;
+    size_t strtab;
+    size_t total;
+};
+
+static void __get_symb_tbl_layout(u32 count, u32 strtab_len, struct symb_tbl_layout_s *layout)
+{
+    layout->eytz_start = __ALIGN8(sizeof(struct symb_cache_hdr_s));
+    layout->start = layout->eytz_start + (count + 1) * sizeof(u64);
+    layout->size = layout->start + count * sizeof(u64);
+    layout->max_end = layout->size + count * sizeof(u64);
+    layout->eytz_rank = layout->max_end + count * sizeof(u64);
+    layout->name_off = layout->eytz_rank + (count + 1) * sizeof(u32);
+    layout->strtab = layout->name_off + count * sizeof(u32);
+    layout->total = layout->strtab + strtab_len;
+}
+
+static void __attach_symb_tbl(struct symb_tbl_s *tbl, void *mem, size_t mem_len)
+{
+    struct symb_tbl_layout_s layout;
+    struct symb_cache_hdr_s *hdr = (struct symb_cache_hdr_s *)mem;
+
+    __get_symb_tbl_layout(hdr->count, hdr->strtab_len, &layout);
+    tbl->count = hdr->count;
+    tbl->strtab_len = hdr->strtab_len;
+    tbl->eytz_start = (const u64 *)((char *)mem + layout.eytz_start);
+    tbl->start = (const u64 *)((char *)mem + layout.start);
+    tbl->size = (const u64 *)((char *)mem + layout.size);
+    tbl->max_end = (const u64 *)((char *)mem + layout.max_end);
+    tbl->eytz_rank = (const u32 *)((char *)mem + layout.eytz_rank);
+    tbl->name_off = (const u32 *)((char *)mem + layout.name_off);
+    tbl->strtab = (const char *)mem + layout.strtab;
+    tbl->mem = mem;
+    tbl->mem_len = mem_len;
+}
+
+static void __destroy_symb_tbl(struct symb_tbl_s *tbl)
+{
+    if (!tbl) {
+        return;
+    }
+
+    if (tbl->mem) {
+        if (tbl->is_mmap) {
+            (void)munmap(tbl->mem, tbl->mem_len);
+        } else {
+            (void)free(tbl->mem);
+        }
+        tbl->mem = NULL;
+    }
+    (void)free(tbl);
+}
+
+// In-order traversal of the implicit tree assigns sorted values to Eytzinger slots.
+static u32 __fill_eytz(u64 *eytz_start, u32 *eytz_rank, const u64 *start, u32 i, u32 k, u32 count)
+{
+    if (k <= count) {
+        i = __fill_eytz(eytz_start, eytz_rank, start, i, 2 * k, count);
+        eytz_start[k] = start[i];
+        eytz_rank[k] = i;
+        i++;
+        i = __fill_eytz(eytz_start, eytz_rank, start, i, 2 * k + 1, count);
+    }
+    return i;
+}
+
+/*
+ * Build the compact table from the sorted symbs[] array, then release symbs[].
+ */
+static int __compact_symbol(struct elf_symbo_s* elf_symbo)
+{
+    u32 count = elf_symbo->symbs_count, strtab_len = 0, pos = 0;
+    char *mem, *strtab;
+    u64 *eytz_start, *start, *size, *max_end;
+    u32 *eytz_rank, *name_off;
+    u64 end = 0;
+    struct symb_tbl_layout_s layout;
+    struct symb_cache_hdr_s *hdr;
+    struct symb_tbl_s *tbl;
+
+    if (count == 0 || elf_symbo->symbs == NULL) {
+        return -1;
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        strtab_len += strlen(elf_symbo->symbs[i]->symb_name ? : "") + 1;
+    }
+
+    __get_symb_tbl_layout(count, strtab_len, &layout);
+    tbl = (struct symb_tbl_s *)calloc(1, sizeof(struct symb_tbl_s));
+    mem = (char *)calloc(1, layout.total);
+    if (!tbl || !mem) {
+        (void)free(tbl);
+        (void)free(mem);
+        return -1;
+    }
+
+    hdr = (struct symb_cache_hdr_s *)mem;
+    hdr->magic = SYMB_CACHE_MAGIC;
+    hdr->version = SYMB_CACHE_VERSION;
+    hdr->count = count;
+    hdr->strtab_len = strtab_len;
+    hdr->sym_type = elf_symbo->key.sym_type;
+    (void)memcpy(hdr->build_id, elf_symbo->key.build_id, ELF_BUILD_ID_LEN);
+
+    eytz_start = (u64 *)(mem + layout.eytz_start);
+    start = (u64 *)(mem + layout.start);
+    size = (u64 *)(mem + layout.size);
+    max_end = (u64 *)(mem + layout.max_end);
+    eytz_rank = (u32 *)(mem + layout.eytz_rank);
+    name_off = (u32 *)(mem + layout.name_off);
+    strtab = mem + layout.strtab;
+
+    for (u32 i = 0; i < count; i++) {
+        const char *name = elf_symbo->symbs[i]->symb_name ? : "";
+        size_t len = strlen(name) + 1;
+
+        start[i] = elf_symbo->symbs[i]->start;
+        size[i] = elf_symbo->symbs[i]->size;
+        if (start[i] + size[i] > end) {
+            end = start[i] + size[i];
+        }
+        max_end[i] = end;
+        name_off[i] = pos;
+        (void)memcpy(strtab + pos, name, len);
+        pos += len;
+    }
+    (void)__fill_eytz(eytz_start, eytz_rank, start, 0, 1, count);
+
+    __attach_symb_tbl(tbl, mem, layout.total);
+    elf_symbo->symb_tbl = tbl;
+
+    // Individually allocated symbols are no longer needed.
+    for (u32 i = 0; i < count; i++) {
+        __symb_destroy(elf_symbo->symbs[i]);
+        (void)free(elf_symbo->symbs[i]);
+    }
+    (void)free(elf_symbo->symbs);
+    elf_symbo->symbs = NULL;
+    elf_symbo->symbs_capability = 0;
+    return 0;
+}
+
+static void __get_symb_cache_path(struct elf_symbo_s* elf_symbo, char path[], size_t len)
+{
+    (void)snprintf(path, len, "%s/%s.%u", SYMB_CACHE_DIR, elf_symbo->key.build_id, elf_symbo->key.sym_type);
+}
+
+static int __check_symb_cache(struct elf_symbo_s* elf_symbo, const void *mem, size_t mem_len)
+{
+    struct symb_tbl_layout_s layout;
+    const struct symb_cache_hdr_s *hdr = (const struct symb_cache_hdr_s *)mem;
+    const u64 *eytz_start, *start;
+    const u32 *eytz_rank, *name_off;
+    const char *strtab;
+
+    if (mem_len < sizeof(struct symb_cache_hdr_s)) {
+        return -1;
+    }
+    if (hdr->magic != SYMB_CACHE_MAGIC || hdr->version != SYMB_CACHE_VERSION || hdr->count == 0
+        || hdr->strtab_len == 0 || hdr->count > SYMBS_MAX_COUNT || hdr->sym_type != elf_symbo->key.sym_type
+        || memcmp(hdr->build_id, elf_symbo->key.build_id, ELF_BUILD_ID_LEN) != 0) {
+        return -1;
+    }
+
+    __get_symb_tbl_layout(hdr->count, hdr->strtab_len, &layout);
+    if (layout.total != mem_len) {
+        return -1;
+    }
+
+    name_off = (const u32 *)((const char *)mem + layout.name_off);
+    strtab = (const char *)mem + layout.strtab;
+    if (strtab[hdr->strtab_len - 1] != 0) {
+        return -1;
+    }
+    for (u32 i = 0; i < hdr->count; i++) {
+        if (name_off[i] >= hdr->strtab_len) {
+            return -1;
+        }
+    }
+
+    // __search_symb_tbl indexes start[] and size[] by eytz_rank[k] without checking it.
+    eytz_start = (const u64 *)((const char *)mem + layout.eytz_start);
+    start = (const u64 *)((const char *)mem + layout.start);
+    eytz_rank = (const u32 *)((const char *)mem + layout.eytz_rank);
+    for (u32 k = 1; k <= hdr->count; k++) {
+        if (eytz_rank[k] >= hdr->count || eytz_start[k] != start[eytz_rank[k]]) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int __load_symb_cache(struct elf_symbo_s* elf_symbo)
+{
+    int fd;
+    void *mem;
+    struct stat st;
+    struct symb_tbl_s *tbl;
+    char path[PATH_LEN];
+
+    if (elf_symbo->key.build_id[0] == 0) {
+        return -1;
+    }
+
+    __get_symb_cache_path(elf_symbo, path, PATH_LEN);
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        (void)close(fd);
+        return -1;
+    }
+
+    mem = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    (void)close(fd);
+    if (mem == MAP_FAILED) {
+        return -1;
+    }
+
+    if (__check_symb_cache(elf_symbo, mem, (size_t)st.st_size)) {
+        WARN("[ELF_SYMBOL]: Invalid symbol cache %s, reload from %s.\n", path, elf_symbo->elf);
+        (void)munmap(mem, (size_t)st.st_size);
+        (void)unlink(path);
+        return -1;
+    }
+
+    tbl = (struct symb_tbl_s *)calloc(1, sizeof(struct symb_tbl_s));
+    if (!tbl) {
+        (void)munmap(mem, (size_t)st.st_size);
+        return -1;
+    }
+    __attach_symb_tbl(tbl, mem, (size_t)st.st_size);
+    tbl->is_mmap = 1;
+    elf_symbo->symb_tbl = tbl;
+    elf_symbo->symbs_count = tbl->count;
+
+    // Refresh the mtime, the least recently used files are pruned first.
+    (void)utimensat(AT_FDCWD, path, NULL, 0);
+    return 0;
+}
+
+struct symb_cache_file_s {
+    time_t mtime;
+    off_t size;
+    char name[NAME_MAX + 1];
+};
+
+static int __symb_cache_file_cmp(const void *a, const void *b)
+{
+    const struct symb_cache_file_s *fa = (const struct symb_cache_file_s *)a;
+    const struct symb_cache_file_s *fb = (const struct symb_cache_file_s *)b;
+
+    if (fa->mtime != fb->mtime) {
+        return (fa->mtime < fb->mtime) ? -1 : 1;
+    }
+    return 0;
+}
+
+/*
+ * Remove the least recently used cache files(a hit refreshes the mtime) until a new file of len bytes fits in
+ * SYMB_CACHE_MAX_SIZE. Files of dead processes and temporary files of interrupted saves are pruned the same way.
+ * Returns 0 if the new file fits.
+ */
+static int __prune_symb_cache(size_t len)
+{
+    DIR *dir;
+    struct dirent *ent;
+    struct stat st;
+    struct symb_cache_file_s *files = NULL, *new_files;
+    u32 num = 0, cap = 0;
+    u64 total = 0;
+
+    if (len > SYMB_CACHE_MAX_SIZE) {
+        return -1;
+    }
+
+    dir = opendir(SYMB_CACHE_DIR);
+    if (dir == NULL) {
+        return 0;
+    }
+    while ((ent = readdir(dir)) != NULL) {
+        if (fstatat(dirfd(dir), ent->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        if (num == cap) {
+            cap = (cap == 0) ? 64 : cap * 2;
+            new_files = (struct symb_cache_file_s *)realloc(files, cap * sizeof(struct symb_cache_file_s));
+            if (new_files == NULL) {
+                break;
+            }
+            files = new_files;
+        }
+        files[num].mtime = st.st_mtime;
+        files[num].size = st.st_size;
+        (void)snprintf(files[num].name, sizeof(files[num].name), "%s", ent->d_name);
+        total += (u64)st.st_size;
+        num++;
+    }
+
+    if (total + len > SYMB_CACHE_MAX_SIZE && files != NULL) {
+        qsort(files, num, sizeof(struct symb_cache_file_s), __symb_cache_file_cmp);
+        for (u32 i = 0; i < num && total + len > SYMB_CACHE_MAX_SIZE; i++) {
+            // A mapped cache file stays valid for the processes using it.
+            if (unlinkat(dirfd(dir), files[i].name, 0) == 0) {
+                total -= (u64)files[i].size;
+            }
+        }
+    }
+    (void)closedir(dir);
+    if (files) {
+        (void)free(files);
+    }
+    return (total + len > SYMB_CACHE_MAX_SIZE) ? -1 : 0;
+}
+
+static void __save_symb_cache(struct elf_symbo_s* elf_symbo)
+{
+    int fd;
+    ssize_t ret;
+    size_t written = 0;
+    struct symb_tbl_s *tbl = elf_symbo->symb_tbl;
+    char path[PATH_LEN];
+    char tmp_path[PATH_LEN + INT_LEN];
+
+    if (!tbl || elf_symbo->key.build_id[0] == 0) {
+        return;
+    }
+
+    (void)mkdir(SYMB_CACHE_DIR, 0700);
+    if (__prune_symb_cache(tbl->mem_len)) {
+        return;
+    }
+    __get_symb_cache_path(elf_symbo, path, PATH_LEN);
+    (void)snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, getpid());
+
+    fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        return;
+    }
+    while (written < tbl->mem_len) {
+        ret = write(fd, (const char *)tbl->mem + written, tbl->mem_len - written);
+        if (ret <= 0) {
+            break;
+        }
+        written += (size_t)ret;
+    }
+    (void)close(fd);
+
+    // Rename makes the cache file visible atomically.
+    if (written != tbl->mem_len || rename(tmp_path, path) != 0) {
+        (void)unlink(tmp_path);
+    }
+}
+
+static int __search_symb_tbl(struct symb_tbl_s *tbl,
+        u64 orign_addr, u64 target_addr, const char* comm, struct addr_symb_s* addr_symb)
+{
+    u32 k = 1, n = tbl->count;
+    s64 idx;
+
+    // Branch-free descent, the next levels are prefetched since they sit in adjacent slots.
+    while (k <= n) {
+        __builtin_prefetch(tbl->eytz_start + (u64)k * 8);
+        k = 2 * k + (target_addr >= tbl->eytz_start[k]);
+    }
+    k >>= __builtin_ffs(~k);
+
+    // k points to the first symbol starting above target_addr, take a step back.
+    idx = (k == 0) ? (s64)n - 1 : (s64)tbl->eytz_rank[k] - 1;
+    if (idx < 0) {
+        return -1;
+    }
+
+    // Symbols may overlap, walk back to the closest one containing target_addr. None before idx ends above it
+    // once max_end[idx] does not.
+    while (idx >= 0 && target_addr < tbl->max_end[idx]) {
+        if (target_addr < tbl->start[idx] + tbl->size[idx]) {
+            addr_symb->sym = (char *)(tbl->strtab + tbl->name_off[idx]);
+            addr_symb->offset = target_addr - tbl->start[idx];
+            addr_symb->orign_addr = orign_addr;
+            addr_symb->mod = (char *)comm;
+            return 0;
+        }
+        idx--;
+    }
+    return -1;
+}
+
 static void __destroy_symbol(struct elf_symbo_s* elf_symbo)
 {
     if (!elf_symbo) {
@@ -106,6 +531,12 @@ static void __destroy_symbol(struct elf_symbo_s* elf_symbo)
         elf_symbo->symbs = NULL;
     }
 
+    __destroy_symb_tbl(elf_symbo->symb_tbl);
+    elf_symbo->symb_tbl = NULL;
+
+    destroy_unwind_tbl(elf_symbo->unwind_tbl);
+    elf_symbo->unwind_tbl = NULL;
+    elf_symbo->unwind_loaded = 0;
     return;
 }
 
@@ -114,7 +545,10 @@ static int __symb_cmp(const void *a, const void *b)
     struct symb_s **symb1 = (struct symb_s **)a;
     struct symb_s **symb2 = (struct symb_s **)b;
 
-    return (*symb1)->start - (*symb2)->start;
+    if ((*symb1)->start == (*symb2)->start) {
+        return 0;
+    }
+    return ((*symb1)->start > (*symb2)->start) ? 1 : -1;
 }
 
 static int __sort_symbol(struct elf_symbo_s* elf_symbo)
@@ -126,22 +560,22 @@ static int __sort_symbol(struct elf_symbo_s* elf_symbo)
     return 0;
 }
 
-static struct elf_symbo_s* __lkup_symb(u32 inode)
+static struct elf_symbo_s* __lkup_symb(struct elf_symb_key_s *key)
 {
     struct elf_symbo_s *item = NULL;
 
-    H_FIND_I(__head, &inode, item);
+    H_FIND(__head, key, sizeof(struct elf_symb_key_s), item);
     return item;
 }
 
-static struct elf_symbo_s* __create_symbol(const char* elf, u32 inode)
+static struct elf_symbo_s* __create_symbol(const char* elf, struct elf_symb_key_s *key)
 {
     struct elf_symbo_s* elf_symbo = malloc(sizeof(struct elf_symbo_s));
     if (!elf_symbo) {
         return NULL;
     }
     (void)memset(elf_symbo, 0, sizeof(struct elf_symbo_s));
-    elf_symbo->i_inode = inode;
+    (void)memcpy(&elf_symbo->key, key, sizeof(struct elf_symb_key_s));
     elf_symbo->elf = strdup(elf);
     elf_symbo->refcnt += 1;
     return elf_symbo;
@@ -342,7 +776,7 @@ static int __load_symbol_from_file(struct elf_symbo_s* elf_symbo, enum sym_file_
     }
 #endif
 
-    if (sym_file_type == ELF_SYM) {
+    if (sym_file_type == ELF_SYM || sym_file_type == DEBUG_SYM) {
         ret = gopher_iter_elf_file_symb((const char *)(elf_symbo->elf), __add_symbs, elf_symbo);
     } else if (sym_file_type == JAVA_SYM){
         ret = __get_java_symb_from_file((const char *)(elf_symbo->elf), elf_symbo);
@@ -420,26 +854,31 @@ static int __do_search_addr(struct elf_symbo_s* elf_symb,
 struct elf_symbo_s* update_symb_from_jvm_sym_file(const char* elf)
 {
     int ret;
-    u32 inode;
+    struct elf_symb_key_s key;
     enum sym_file_t sym_file_type = JAVA_SYM;
-    struct elf_symbo_s* item = NULL;
-    ret = __get_inode(elf, &inode);
+    struct elf_symbo_s* item = NULL, *new_item = NULL;
+    ret = __get_symb_key(elf, sym_file_type, &key);
     if (ret != 0) {
         return NULL;
     }
 
-    item = __lkup_symb(inode);
+    item = __lkup_symb(&key);
     if (!item) {
-        item = __create_symbol(elf, inode);
-        if (!item) {
+        new_item = __create_symbol(elf, &key);
+        if (!new_item) {
             goto err;
         }
-        H_ADD_I(__head, i_inode, item);
+        H_ADD_KEYPTR(__head, &new_item->key, sizeof(struct elf_symb_key_s), new_item);
+        item = new_item;
     }
 
     ret = __load_symbol_from_file(item, sym_file_type);
     if (ret != 0) {
         ERROR("[ELF_SYMBOL]: Failed to load symbol(%s).\n", item->elf);
+        // The cached item may be referenced by other modules, keep it.
+        if (item != new_item) {
+            return item;
+        }
         goto err;
     }
 
@@ -449,9 +888,10 @@ struct elf_symbo_s* update_symb_from_jvm_sym_file(const char* elf)
     return item;
 
 err:
-    if (item) {
-        __destroy_symbol(item);
-        (void)free(item);
+    if (new_item) {
+        __destroy_symbol(new_item);
+        H_DEL(__head, new_item);
+        (void)free(new_item);
     }
     return NULL;
 }
@@ -459,23 +899,30 @@ err:
 struct elf_symbo_s* get_symb_from_file(const char* elf, enum sym_file_t sym_file_type)
 {
     int ret;
-    u32 inode;
+    struct elf_symb_key_s key;
     struct elf_symbo_s* item = NULL, *new_item = NULL;
-    ret = __get_inode(elf, &inode);
+    ret = __get_symb_key(elf, sym_file_type, &key);
     if (ret != 0) {
         return NULL;
     }
 
-    item = __lkup_symb(inode);
+    item = __lkup_symb(&key);
     if (item) {
         item->refcnt++;
         return item;
     }
 
-    new_item = __create_symbol(elf, inode);
+    new_item = __create_symbol(elf, &key);
     if (!new_item) {
         goto err;
     }
+
+    // Symbol cache written by a previous run, no need to parse the elf again.
+    if (sym_file_type != JAVA_SYM && __load_symb_cache(new_item) == 0) {
+        H_ADD_KEYPTR(__head, &new_item->key, sizeof(struct elf_symb_key_s), new_item);
+        return new_item;
+    }
+
     ret = __load_symbol_from_file(new_item, sym_file_type);
     if (ret != 0) {
         ERROR("[ELF_SYMBOL]: Failed to load symbol(%s).\n", new_item->elf);
@@ -484,7 +931,12 @@ struct elf_symbo_s* get_symb_from_file(const char* elf, enum sym_file_t sym_file
 
     (void)__sort_symbol(new_item);
 
-    H_ADD_I(__head, i_inode, new_item);
+    // JVM symbols are appended periodically, only elf symbols are compacted.
+    if (sym_file_type != JAVA_SYM && __compact_symbol(new_item) == 0) {
+        __save_symb_cache(new_item);
+    }
+
+    H_ADD_KEYPTR(__head, &new_item->key, sizeof(struct elf_symb_key_s), new_item);
     if (sym_file_type == JAVA_SYM) {
         INFO("[ELF_SYMBOL]: Succeed to init JVM symbs %s(symbs_count = %u).\n", new_item->elf, new_item->symbs_count);
     }
@@ -506,7 +958,7 @@ void rm_elf_symb(struct elf_symbo_s* elf_symb)
         return;
     }
 
-    item = __lkup_symb(elf_symb->i_inode);
+    item = __lkup_symb(&elf_symb->key);
     if (!item) {
         return;
     }
@@ -534,6 +986,9 @@ int search_elf_symb(struct elf_symbo_s* elf_symb,
         return -1;
     }
 
+    if (elf_symb->symb_tbl) {
+        return __search_symb_tbl(elf_symb->symb_tbl, orign_addr, target_addr, comm, addr_symb);
+    }
     return __do_search_addr(elf_symb, orign_addr, target_addr, comm, addr_symb);
 }
 
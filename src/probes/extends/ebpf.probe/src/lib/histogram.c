@@ -10,102 +10,362 @@
  * See the Mulan PSL v2 for more details.
  * Author: luzhihao
  * Create: 2023-06-28
- * Description: open telemetry histogram calculation
+ * Description: log-linear(HDR) histogram calculation
  ******************************************************************************/
 #include <stdio.h>
-#include <unistd.h>
-#include <signal.h>
-#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "histogram.h"
 
-// Refer to https://zhuanlan.zhihu.com/p/608621390
+// Refer to http://hdrhistogram.org/
 
-static const float __histo_p50 = 0.5;
-static const float __histo_p90 = 0.9;
-static const float __histo_p99 = 0.99;
+#define HISTO_SERIAL_VER    1
+#define HISTO_VARINT_MAX    10
 
-static u64 __get_histo_bucket_sum(struct histo_bucket_s bucket[], size_t bucket_size)
+static const double __histo_p50 = 0.5;
+static const double __histo_p90 = 0.9;
+static const double __histo_p99 = 0.99;
+
+static int __histo_counts_index(const struct histo_s *histo, u64 value)
+{
+    int pow2ceiling = 64 - __builtin_clzll(value | histo->sub_bucket_mask);
+    int bucket_index = pow2ceiling - histo->unit_magnitude - (histo->sub_bucket_half_count_magnitude + 1);
+    u32 sub_bucket_index = (u32)(value >> (u32)(bucket_index + histo->unit_magnitude));
+
+    return ((bucket_index + 1) << histo->sub_bucket_half_count_magnitude) +
+           (int)(sub_bucket_index - histo->sub_bucket_half_count);
+}
+
+static u64 __histo_lowest_at_index(const struct histo_s *histo, int index, int *bucket)
 {
-    u64 sum = 0;
+    int bucket_index = (index >> histo->sub_bucket_half_count_magnitude) - 1;
+    u32 sub_bucket_index = (u32)(index & (int)(histo->sub_bucket_half_count - 1)) + histo->sub_bucket_half_count;
 
-    for (int i = 0; i < bucket_size; i++) {
-        sum += bucket[i].count;
+    // The first bucket also covers the lower half of the sub-buckets.
+    if (bucket_index < 0) {
+        sub_bucket_index -= histo->sub_bucket_half_count;
+        bucket_index = 0;
     }
-    return sum;
+    *bucket = bucket_index;
+    return (u64)sub_bucket_index << (u32)(bucket_index + histo->unit_magnitude);
 }
 
-static struct histo_bucket_s* __find_histo_bucket(struct histo_bucket_s bucket[], size_t bucket_size, size_t count, size_t *offset)
+static u64 __histo_highest_at_index(const struct histo_s *histo, int index)
 {
-    size_t remain = count;
+    int bucket_index;
+    u64 lowest = __histo_lowest_at_index(histo, index, &bucket_index);
+
+    return lowest + (1ULL << (u32)(bucket_index + histo->unit_magnitude)) - 1;
+}
 
-    for (int i = 0; i < bucket_size; i++) {
-        if (remain > bucket[i].count) {
-            remain = remain - bucket[i].count;
-        } else {
-            *offset = bucket[i].count - remain;
-            return &(bucket[i]);
+static char __histo_same_layout(const struct histo_s *a, const struct histo_s *b)
+{
+    return (a->lowest == b->lowest && a->highest == b->highest && a->sig_digits == b->sig_digits);
+}
+
+static void __histo_update_min_max(struct histo_s *histo)
+{
+    int bucket_index;
+
+    histo->min = (u64)-1;
+    histo->max = 0;
+    for (int i = 0; i < (int)histo->counts_len; i++) {
+        if (histo->counts[i] == 0) {
+            continue;
         }
+        if (histo->min == (u64)-1) {
+            histo->min = __histo_lowest_at_index(histo, i, &bucket_index);
+        }
+        histo->max = __histo_highest_at_index(histo, i);
+    }
+    histo->max = min(histo->max, histo->highest);
+}
+
+struct histo_s *create_histo(u64 lowest, u64 highest, int sig_digits)
+{
+    struct histo_s *histo;
+    u64 largest_single_unit = 2, smallest_untrackable;
+    int sub_bucket_count_magnitude = 0, unit_magnitude, half_magnitude;
+    u32 bucket_count = 1, counts_len;
+
+    if (sig_digits < HISTO_SIG_DIGITS_MIN || sig_digits > HISTO_SIG_DIGITS_MAX) {
+        return NULL;
+    }
+    lowest = max(lowest, 1);
+    if (highest < 2 * lowest) {
+        return NULL;
+    }
+
+    // Sub-buckets must split a power-of-2 range into at least 2 * 10^sig_digits values.
+    for (int i = 0; i < sig_digits; i++) {
+        largest_single_unit *= 10;
+    }
+    while ((1ULL << (u32)sub_bucket_count_magnitude) < largest_single_unit) {
+        sub_bucket_count_magnitude++;
+    }
+    half_magnitude = sub_bucket_count_magnitude - 1;
+    unit_magnitude = 63 - __builtin_clzll(lowest);
+    if (unit_magnitude + sub_bucket_count_magnitude > 62) {
+        return NULL;
+    }
+
+    smallest_untrackable = (1ULL << (u32)sub_bucket_count_magnitude) << (u32)unit_magnitude;
+    while (smallest_untrackable <= highest) {
+        if (smallest_untrackable > ((u64)-1 >> 1)) {
+            bucket_count++;
+            break;
+        }
+        smallest_untrackable <<= 1;
+        bucket_count++;
+    }
+    counts_len = (bucket_count + 1) << (u32)half_magnitude;
+
+    histo = (struct histo_s *)malloc(sizeof(struct histo_s) + counts_len * sizeof(u64));
+    if (histo == NULL) {
+        return NULL;
+    }
+    (void)memset(histo, 0, sizeof(struct histo_s) + counts_len * sizeof(u64));
+    histo->lowest = lowest;
+    histo->highest = highest;
+    histo->sig_digits = sig_digits;
+    histo->unit_magnitude = unit_magnitude;
+    histo->sub_bucket_half_count_magnitude = half_magnitude;
+    histo->sub_bucket_count = 1U << (u32)sub_bucket_count_magnitude;
+    histo->sub_bucket_half_count = histo->sub_bucket_count / 2;
+    histo->sub_bucket_mask = (u64)(histo->sub_bucket_count - 1) << (u32)unit_magnitude;
+    histo->bucket_count = bucket_count;
+    histo->counts_len = counts_len;
+    histo->min = (u64)-1;
+    return histo;
+}
+
+void destroy_histo(struct histo_s *histo)
+{
+    if (histo == NULL) {
+        return;
     }
-    return NULL;
+    free(histo);
+}
+
+void histo_reset(struct histo_s *histo)
+{
+    (void)memset(histo->counts, 0, histo->counts_len * sizeof(u64));
+    histo->total_count = 0;
+    histo->min = (u64)-1;
+    histo->max = 0;
 }
 
-int init_histo_bucket(struct histo_bucket_s *bucket, u64 min, u64 max)
+int histo_add_values(struct histo_s *histo, u64 value, u64 count)
 {
-    if (min >= max) {
+    int index;
+
+    value = min(value, histo->highest);
+    index = __histo_counts_index(histo, value);
+    if (index < 0 || index >= (int)histo->counts_len) {
         return -1;
     }
 
-    bucket->min = min;
-    bucket->max = max;
-    bucket->count = 0;
+    histo->counts[index] += count;
+    histo->total_count += count;
+    histo->min = min(histo->min, value);
+    histo->max = max(histo->max, value);
     return 0;
 }
 
-int histo_bucket_add_value(struct histo_bucket_s bucket[], size_t bucket_size, u64 value)
+int histo_add_value(struct histo_s *histo, u64 value)
 {
-    for (int i = 0; i < bucket_size; i++) {
-        if ((value > bucket[i].min) && (value <= bucket[i].max)) {
-            bucket[i].count++;
-            return 0;
-        }
-    }
-    return -1;
+    return histo_add_values(histo, value, 1);
 }
 
-void histo_bucket_reset(struct histo_bucket_s bucket[], size_t bucket_size)
+u64 histo_value_at_quantile(const struct histo_s *histo, double q)
 {
-    for (int i = 0; i < bucket_size; i++) {
-        bucket[i].count = 0;
+    u64 target, sum = 0;
+
+    if (histo->total_count == 0) {
+        return 0;
     }
-    return;
+
+    q = (q < 0.0) ? 0.0 : ((q > 1.0) ? 1.0 : q);
+    target = (u64)(q * (double)histo->total_count + 0.5);
+    target = max(target, 1);
+
+    for (int i = 0; i < (int)histo->counts_len; i++) {
+        sum += histo->counts[i];
+        if (sum >= target) {
+            return min(__histo_highest_at_index(histo, i), histo->max);
+        }
+    }
+    return histo->max;
 }
 
-int histo_bucket_value(struct histo_bucket_s bucket[], size_t bucket_size, enum histo_type_t type, float *value)
+int histo_value(const struct histo_s *histo, enum histo_type_t type, float *value)
 {
-    size_t offset = 0;
-    u64 sum = __get_histo_bucket_sum(bucket, bucket_size);
-    size_t histo_count;
-    struct histo_bucket_s *bucket_finded;
+    double q;
+
+    if (histo->total_count == 0) {
+        return -1;
+    }
 
     if (type == HISTO_P50) {
-        histo_count = (size_t)(sum * __histo_p50);
+        q = __histo_p50;
     } else if (type == HISTO_P90) {
-        histo_count = (size_t)(sum * __histo_p90);
+        q = __histo_p90;
     } else {
-        histo_count = (size_t)(sum * __histo_p99);
+        q = __histo_p99;
+    }
+    *value = (float)histo_value_at_quantile(histo, q);
+    return 0;
+}
+
+int histo_merge(struct histo_s *dst, const struct histo_s *src)
+{
+    if (!__histo_same_layout(dst, src)) {
+        return -1;
     }
 
-    bucket_finded = __find_histo_bucket(bucket, bucket_size, histo_count, &offset);
-    if (offset == 0) {
-        offset += 1;
+    for (int i = 0; i < (int)dst->counts_len; i++) {
+        dst->counts[i] += src->counts[i];
     }
+    dst->total_count += src->total_count;
+    dst->min = min(dst->min, src->min);
+    dst->max = max(dst->max, src->max);
+    return 0;
+}
 
-    if (bucket_finded) {
-        *value = (float)(bucket_finded->max - bucket_finded->min) * ((float)offset / (float)bucket_finded->count) + (float)bucket_finded->min;
-        return 0;
+int histo_subtract(struct histo_s *dst, const struct histo_s *src)
+{
+    if (!__histo_same_layout(dst, src)) {
+        return -1;
+    }
+
+    for (int i = 0; i < (int)dst->counts_len; i++) {
+        if (dst->counts[i] < src->counts[i]) {
+            return -1;
+        }
+    }
+    for (int i = 0; i < (int)dst->counts_len; i++) {
+        dst->counts[i] -= src->counts[i];
+    }
+    dst->total_count -= src->total_count;
+
+    // The exact min/max of the remaining values are unknown, use the bounds of their buckets.
+    __histo_update_min_max(dst);
+    return 0;
+}
+
+static int __put_varint(char *buf, size_t size, size_t *pos, u64 value)
+{
+    do {
+        if (*pos >= size) {
+            return -1;
+        }
+        buf[(*pos)++] = (char)((value & 0x7F) | ((value > 0x7F) ? 0x80 : 0));
+        value >>= 7;
+    } while (value != 0);
+    return 0;
+}
+
+static int __get_varint(const char *buf, size_t len, size_t *pos, u64 *value)
+{
+    u64 v = 0;
+    unsigned char c;
+
+    for (int i = 0; i < HISTO_VARINT_MAX; i++) {
+        if (*pos >= len) {
+            return -1;
+        }
+        c = (unsigned char)buf[(*pos)++];
+        v |= (u64)(c & 0x7F) << (u32)(7 * i);
+        if ((c & 0x80) == 0) {
+            *value = v;
+            return 0;
+        }
     }
     return -1;
 }
 
+int histo_serialize(const struct histo_s *histo, char *buf, size_t size)
+{
+    size_t pos = 0;
+    u64 num = 0;
+    int prev = 0;
+
+    for (int i = 0; i < (int)histo->counts_len; i++) {
+        if (histo->counts[i] != 0) {
+            num++;
+        }
+    }
+
+    if (size < 1) {
+        return -1;
+    }
+    buf[pos++] = HISTO_SERIAL_VER;
+    if (__put_varint(buf, size, &pos, histo->lowest) || __put_varint(buf, size, &pos, histo->highest) ||
+        __put_varint(buf, size, &pos, (u64)histo->sig_digits) || __put_varint(buf, size, &pos, histo->min) ||
+        __put_varint(buf, size, &pos, histo->max) || __put_varint(buf, size, &pos, num)) {
+        return -1;
+    }
+
+    for (int i = 0; i < (int)histo->counts_len; i++) {
+        if (histo->counts[i] == 0) {
+            continue;
+        }
+        if (__put_varint(buf, size, &pos, (u64)(i - prev)) || __put_varint(buf, size, &pos, histo->counts[i])) {
+            return -1;
+        }
+        prev = i;
+    }
+    return (int)pos;
+}
+
+static int __histo_decode(struct histo_s *histo, const char *buf, size_t len, char apply)
+{
+    size_t pos = 1;
+    u64 lowest, highest, sig_digits, min_value, max_value, num, delta, count;
+    u64 index = 0, total = 0;
+
+    if (len < 1 || buf[0] != HISTO_SERIAL_VER) {
+        return -1;
+    }
+    if (__get_varint(buf, len, &pos, &lowest) || __get_varint(buf, len, &pos, &highest) ||
+        __get_varint(buf, len, &pos, &sig_digits) || __get_varint(buf, len, &pos, &min_value) ||
+        __get_varint(buf, len, &pos, &max_value) || __get_varint(buf, len, &pos, &num)) {
+        return -1;
+    }
+    if (lowest != histo->lowest || highest != histo->highest || sig_digits != (u64)histo->sig_digits) {
+        return -1;
+    }
 
+    for (u64 i = 0; i < num; i++) {
+        if (__get_varint(buf, len, &pos, &delta) || __get_varint(buf, len, &pos, &count)) {
+            return -1;
+        }
+        index += delta;
+        if (index >= histo->counts_len) {
+            return -1;
+        }
+        if (apply) {
+            histo->counts[index] += count;
+        }
+        total += count;
+    }
+
+    if (apply) {
+        histo->total_count += total;
+        if (total > 0) {
+            histo->min = min(histo->min, min_value);
+            histo->max = max(histo->max, max_value);
+        }
+    }
+    return 0;
+}
+
+int histo_deserialize(struct histo_s *histo, const char *buf, size_t len)
+{
+    // Validate the whole input first, so that a corrupted input leaves the histogram unchanged.
+    if (__histo_decode(histo, buf, len, 0)) {
+        return -1;
+    }
+    return __histo_decode(histo, buf, len, 1);
+}
@@ -0,0 +1,184 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-08-31
+ * Description: periodic snapshot of bpf maps from userspace
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <bpf/bpf.h>
+#include <bpf/libbpf.h>
+
+#include "map_batch.h"
+
+#ifndef ENOTSUPP
+#define ENOTSUPP    524     // kernel internal errno, returned by maps without batch ops
+#endif
+
+static char __is_hash_map(u32 type)
+{
+    return (type == BPF_MAP_TYPE_HASH || type == BPF_MAP_TYPE_PERCPU_HASH ||
+            type == BPF_MAP_TYPE_LRU_HASH || type == BPF_MAP_TYPE_LRU_PERCPU_HASH);
+}
+
+static char __is_percpu_map(u32 type)
+{
+    return (type == BPF_MAP_TYPE_PERCPU_HASH || type == BPF_MAP_TYPE_LRU_PERCPU_HASH ||
+            type == BPF_MAP_TYPE_PERCPU_ARRAY);
+}
+
+struct map_batch_s *create_map_batch(int map_fd, char reset)
+{
+    int ncpus = 0;
+    struct map_batch_s *mb;
+    struct bpf_map_info info = {0};
+    u32 info_len = sizeof(info);
+
+    if (bpf_obj_get_info_by_fd(map_fd, &info, &info_len)) {
+        ERROR("[MAP_BATCH] Get info of map(fd: %d) failed.\n", map_fd);
+        return NULL;
+    }
+    if (reset && !__is_hash_map(info.type)) {
+        ERROR("[MAP_BATCH] Entries of map '%s' can not be deleted.\n", info.name);
+        return NULL;
+    }
+    if (__is_percpu_map(info.type)) {
+        ncpus = libbpf_num_possible_cpus();
+        if (ncpus <= 0) {
+            return NULL;
+        }
+    }
+
+    mb = (struct map_batch_s *)malloc(sizeof(struct map_batch_s));
+    if (mb == NULL) {
+        return NULL;
+    }
+    memset(mb, 0, sizeof(struct map_batch_s));
+    mb->fd = map_fd;
+    mb->key_size = info.key_size;
+    mb->value_size = (ncpus > 0) ? MAP_BATCH_PERCPU_SIZE(info.value_size) * (u32)ncpus : info.value_size;
+    mb->max_entries = info.max_entries;
+    mb->ncpus = (u32)ncpus;
+    mb->reset = reset;
+
+    // The whole map is read at once, so that each entry is reported once per snapshot.
+    mb->keys = calloc(mb->max_entries, mb->key_size);
+    mb->values = calloc(mb->max_entries, mb->value_size);
+    mb->batch = calloc(1, max(mb->key_size, sizeof(u64)));
+    if (mb->keys == NULL || mb->values == NULL || mb->batch == NULL) {
+        destroy_map_batch(mb);
+        return NULL;
+    }
+    return mb;
+}
+
+void destroy_map_batch(struct map_batch_s *mb)
+{
+    if (mb == NULL) {
+        return;
+    }
+
+    free(mb->keys);
+    free(mb->values);
+    free(mb->batch);
+    free(mb);
+}
+
+static void __map_batch_call(struct map_batch_s *mb, u32 count, map_batch_cb cb, void *ctx)
+{
+    for (u32 i = 0; i < count; i++) {
+        cb((char *)mb->keys + (size_t)i * mb->key_size, (char *)mb->values + (size_t)i * mb->value_size, ctx);
+    }
+}
+
+static int __map_batch_collect_batch(struct map_batch_s *mb, map_batch_cb cb, void *ctx)
+{
+    int ret, err;
+    u32 count;
+    int total = 0;
+    void *in_batch = NULL;
+    DECLARE_LIBBPF_OPTS(bpf_map_batch_opts, opts, .elem_flags = 0, .flags = 0);
+
+    while (1) {
+        count = mb->max_entries;
+        if (mb->reset) {
+            ret = bpf_map_lookup_and_delete_batch(mb->fd, in_batch, mb->batch, mb->keys, mb->values, &count, &opts);
+        } else {
+            ret = bpf_map_lookup_batch(mb->fd, in_batch, mb->batch, mb->keys, mb->values, &count, &opts);
+        }
+        err = (ret < 0) ? errno : 0;
+        if (err != 0 && err != ENOENT) {
+            if (in_batch == NULL && (err == EINVAL || err == ENOTSUPP || err == EOPNOTSUPP)) {
+                mb->no_batch = 1;
+                return 0;
+            }
+            ERROR("[MAP_BATCH] Lookup batch of map(fd: %d) failed(%d).\n", mb->fd, err);
+            return -1;
+        }
+
+        __map_batch_call(mb, count, cb, ctx);
+        total += (int)count;
+        if (err == ENOENT || count == 0) {
+            break;
+        }
+        in_batch = mb->batch;
+    }
+    return total;
+}
+
+static int __map_batch_collect_iter(struct map_batch_s *mb, map_batch_cb cb, void *ctx)
+{
+    u32 num = 0, count = 0;
+    void *key, *prev_key = NULL;
+
+    // Collect the keys first, deleting entries during the iteration would restart it.
+    while (num < mb->max_entries) {
+        key = (char *)mb->keys + (size_t)num * mb->key_size;
+        if (bpf_map_get_next_key(mb->fd, prev_key, key) != 0) {
+            break;
+        }
+        prev_key = key;
+        num++;
+    }
+
+    for (u32 i = 0; i < num; i++) {
+        key = (char *)mb->keys + (size_t)i * mb->key_size;
+        if (bpf_map_lookup_elem(mb->fd, key, (char *)mb->values + (size_t)count * mb->value_size) != 0) {
+            continue;
+        }
+        if (mb->reset) {
+            (void)bpf_map_delete_elem(mb->fd, key);
+        }
+        if (count != i) {
+            memcpy((char *)mb->keys + (size_t)count * mb->key_size, key, mb->key_size);
+        }
+        count++;
+    }
+
+    __map_batch_call(mb, count, cb, ctx);
+    return (int)count;
+}
+
+int map_batch_collect(struct map_batch_s *mb, map_batch_cb cb, void *ctx)
+{
+    int ret;
+
+    if (!mb->no_batch) {
+        ret = __map_batch_collect_batch(mb, cb, ctx);
+        if (!mb->no_batch) {
+            return ret;
+        }
+        INFO("[MAP_BATCH] Batch ops are not supported, iterate map(fd: %d) instead.\n", mb->fd);
+    }
+    return __map_batch_collect_iter(mb, cb, ctx);
+}
@@ -0,0 +1,168 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-09-11
+ * Description: pinned state maps kept across probe restarts
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <bpf/bpf.h>
+#include <bpf/libbpf.h>
+
+#include "bpf.h"
+#include "pin_state.h"
+
+#define PIN_STATE_MAGIC     0x67706c74  // "gplt"
+
+struct pin_state_layout_s {
+    u32 magic;
+    u32 version;
+    u32 num;
+    u32 reserved;
+    struct pin_state_geo_s maps[PIN_STATE_MAP_MAX];
+};
+
+static void __build_layout(struct pin_state_layout_s *layout, u32 version, const struct pin_state_geo_s *geos, u32 num)
+{
+    (void)memset(layout, 0, sizeof(struct pin_state_layout_s));
+    layout->magic = PIN_STATE_MAGIC;
+    layout->version = version;
+    layout->num = num;
+    for (u32 i = 0; i < num; i++) {
+        layout->maps[i] = geos[i];
+    }
+}
+
+// 1 if the pinned layout is the same as the expected one and all the maps are pinned.
+static int __is_layout_compat(const char *layout_path, const struct pin_state_layout_s *layout,
+                              const char *const *paths, u32 num)
+{
+    int fd, compat = 0;
+    u32 key = 0;
+    struct bpf_map_info info = {0};
+    u32 info_len = sizeof(info);
+    struct pin_state_layout_s pinned;
+
+    fd = bpf_obj_get(layout_path);
+    if (fd < 0) {
+        return 0;
+    }
+
+    if (bpf_obj_get_info_by_fd(fd, &info, &info_len) != 0 || info.value_size != sizeof(pinned)) {
+        goto out;
+    }
+    if (bpf_map_lookup_elem(fd, &key, &pinned) != 0 || memcmp(&pinned, layout, sizeof(pinned)) != 0) {
+        goto out;
+    }
+
+    for (u32 i = 0; i < num; i++) {
+        if (access(paths[i], F_OK) != 0) {
+            goto out;
+        }
+    }
+    compat = 1;
+out:
+    (void)close(fd);
+    return compat;
+}
+
+static int __pin_layout(const char *layout_path, const struct pin_state_layout_s *layout)
+{
+    int fd, ret;
+    u32 key = 0;
+
+#if (CURRENT_LIBBPF_VERSION  >= LIBBPF_VERSION(0, 8))
+    fd = bpf_map_create(BPF_MAP_TYPE_ARRAY, NULL, sizeof(u32), sizeof(struct pin_state_layout_s), 1, NULL);
+#else
+    fd = bpf_create_map(BPF_MAP_TYPE_ARRAY, sizeof(u32), sizeof(struct pin_state_layout_s), 1, 0);
+#endif
+    if (fd < 0) {
+        ERROR("Failed to create state layout map(%s).\n", layout_path);
+        return -1;
+    }
+
+    ret = bpf_map_update_elem(fd, &key, layout, BPF_ANY);
+    if (ret == 0) {
+        ret = bpf_obj_pin(fd, layout_path);
+    }
+    (void)close(fd);
+    if (ret != 0) {
+        ERROR("Failed to pin state layout map(%s).\n", layout_path);
+        return -1;
+    }
+    return 0;
+}
+
+int pin_state_check_layout(const char *layout_path, u32 version, const struct pin_state_geo_s *geos,
+                           const char *const *paths, u32 num)
+{
+    int reuse;
+    struct pin_state_layout_s layout;
+
+    if (num == 0 || num > PIN_STATE_MAP_MAX) {
+        return -1;
+    }
+
+    __build_layout(&layout, version, geos, num);
+    reuse = __is_layout_compat(layout_path, &layout, paths, num);
+    if (!reuse) {
+        // Stale or partial state, the maps are created again by the load of the skeleton.
+        for (u32 i = 0; i < num; i++) {
+            (void)unlink(paths[i]);
+        }
+        (void)unlink(layout_path);
+        if (__pin_layout(layout_path, &layout)) {
+            return -1;
+        }
+    }
+    return reuse;
+}
+
+int pin_state_maps(const char *layout_path, u32 version, struct pin_state_map_s *maps, u32 num)
+{
+    int reuse;
+    struct pin_state_geo_s geos[PIN_STATE_MAP_MAX];
+    const char *paths[PIN_STATE_MAP_MAX];
+
+    if (num == 0 || num > PIN_STATE_MAP_MAX) {
+        return -1;
+    }
+
+    if (mkdir(PIN_STATE_DIR, 0700) != 0 && errno != EEXIST) {
+        ERROR("Failed to create %s.\n", PIN_STATE_DIR);
+        return -1;
+    }
+
+    for (u32 i = 0; i < num; i++) {
+        geos[i].type = (u32)bpf_map__type(maps[i].map);
+        geos[i].key_size = bpf_map__key_size(maps[i].map);
+        geos[i].value_size = bpf_map__value_size(maps[i].map);
+        geos[i].max_entries = bpf_map__max_entries(maps[i].map);
+        paths[i] = maps[i].path;
+    }
+
+    reuse = pin_state_check_layout(layout_path, version, geos, paths, num);
+    if (reuse < 0) {
+        return -1;
+    }
+
+    for (u32 i = 0; i < num; i++) {
+        if (bpf_map__set_pin_path(maps[i].map, maps[i].path) != 0) {
+            return -1;
+        }
+    }
+
+    INFO("State maps(%s) are %s.\n", layout_path, reuse ? "reused" : "created");
+    return reuse;
+}
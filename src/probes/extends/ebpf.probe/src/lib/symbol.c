@@ -247,6 +247,11 @@ static void __print_proc_ranges(struct proc_symbs_s* proc_symbs)
 
 static void __print_mod_symbs(struct mod_s *mod)
 {
+    // Compacted elf symbols no longer keep the symb_s array.
+    if (!mod->mod_symbs || !mod->symbs) {
+        return;
+    }
+
     __print_symbs_header();
 
     for (int i = 0; i < mod->symbs_count; i++) {
@@ -308,6 +313,13 @@ static void mod_destroy(struct mod_s *mod)
 
     mod->mod_symbs = NULL;
     mod->debug_symbs = NULL;
+
+    if (mod->addr_ranges) {
+        (void)free(mod->addr_ranges);
+        mod->addr_ranges = NULL;
+    }
+    mod->addr_ranges_count = 0;
+    mod->addr_ranges_capability = 0;
     return;
 }
 
@@ -513,7 +525,7 @@ static int load_debug_symbs(struct proc_symbs_s* proc_symbs, struct mod_s* mod)
                              PATH_LEN);
 
     if (debug_file[0] != 0) {
-        mod->debug_symbs = get_symb_from_file((const char *)debug_file, ELF_SYM);
+        mod->debug_symbs = get_symb_from_file((const char *)debug_file, DEBUG_SYM);
     }
 
 #if 0
@@ -581,12 +593,62 @@ static int get_mod_elf_so_offset(struct mod_s* mod)
         return 0;
     }
 
+    // The .text section of a shared elf is parsed once and reused by all processes.
+    if (mod->mod_symbs && mod->mod_symbs->text_section_loaded) {
+        mod->mod_elf_so_addr = mod->mod_symbs->text_section_addr;
+        mod->mod_elf_so_offset = mod->mod_symbs->text_section_offset;
+        return 0;
+    }
+
     if (gopher_get_elf_text_section((const char *)mod->mod_path, 
         &mod->mod_elf_so_addr, &mod->mod_elf_so_offset)) {
         ERROR("[SYMBOL]: Get elf offset failed(%s).\n", mod->mod_path);
         return GET_ELF_OFFSET;
     }
 
+    if (mod->mod_symbs) {
+        mod->mod_symbs->text_section_addr = mod->mod_elf_so_addr;
+        mod->mod_symbs->text_section_offset = mod->mod_elf_so_offset;
+        mod->mod_symbs->text_section_loaded = 1;
+    }
+    return 0;
+}
+
+static int __inc_mod_range_capability(struct mod_s* mod)
+{
+    u32 new_capa;
+    struct mod_addr_rage_s *new_ranges;
+
+    new_capa = (mod->addr_ranges_capability == 0) ? MOD_ADDR_RANGE_STEP : (mod->addr_ranges_capability * 2);
+    if (new_capa > MOD_ADDR_RANGE_COUNT) {
+        new_capa = MOD_ADDR_RANGE_COUNT;
+    }
+
+    new_ranges = (struct mod_addr_rage_s *)realloc(mod->addr_ranges, new_capa * sizeof(struct mod_addr_rage_s));
+    if (!new_ranges) {
+        return -1;
+    }
+    mod->addr_ranges = new_ranges;
+    mod->addr_ranges_capability = new_capa;
+    return 0;
+}
+
+static int add_mod_range(struct mod_s* mod, u64 start, u64 end, u64 f_offset)
+{
+    if (mod->addr_ranges_count >= MOD_ADDR_RANGE_COUNT) {
+        return ADD_MOD_RANGE;
+    }
+
+    if (mod->addr_ranges_count >= mod->addr_ranges_capability) {
+        if (__inc_mod_range_capability(mod)) {
+            return ADD_MOD_RANGE;
+        }
+    }
+
+    mod->addr_ranges[mod->addr_ranges_count].start = start;
+    mod->addr_ranges[mod->addr_ranges_count].end = end;
+    mod->addr_ranges[mod->addr_ranges_count].f_offset = f_offset;
+    mod->addr_ranges_count++;
     return 0;
 }
 
@@ -637,10 +699,10 @@ static int add_mod(void *elf_reader, struct proc_symbs_s* proc_symbs, struct mod
 
     (void)load_debug_symbs(proc_symbs, new_mod);
 
-    new_mod->addr_ranges[0].start = new_mod->mod_start;
-    new_mod->addr_ranges[0].end = new_mod->mod_end;
-    new_mod->addr_ranges[0].f_offset = new_mod->mod_f_offset;
-    new_mod->addr_ranges_count = 1;
+    ret = add_mod_range(new_mod, new_mod->mod_start, new_mod->mod_end, new_mod->mod_f_offset);
+    if (ret != 0) {
+        goto err;
+    }
 
     proc_symbs->mods[proc_symbs->mods_count++] = new_mod;
     return 0;
@@ -651,19 +713,6 @@ err:
     return ret;
 }
 
-static int add_mod_range(struct mod_s* mod, u64 start, u64 end, u64 f_offset)
-{
-    if (mod->addr_ranges_count >= MOD_ADDR_RANGE_COUNT) {
-        return ADD_MOD_RANGE;
-    }
-
-    mod->addr_ranges[mod->addr_ranges_count].start = start;
-    mod->addr_ranges[mod->addr_ranges_count].end = end;
-    mod->addr_ranges[mod->addr_ranges_count].f_offset = f_offset;
-    mod->addr_ranges_count++;
-    return 0;
-}
-
 static char __is_perf_map(const char *perf_map_file)
 {
     char *pos;
@@ -1033,6 +1082,22 @@ void proc_delete_all_symbs(struct proc_symbs_s *proc_symbs)
     return;
 }
 
+struct mod_s* proc_get_mod_by_addr(struct proc_symbs_s *proc_symbs, u64 addr, u64 *target_addr)
+{
+    struct mod_s *mod;
+
+    for (int i = 0; i < proc_symbs->mods_count; i++) {
+        mod = proc_symbs->mods[i];
+        if (mod == NULL || mod->mod_type == MODULE_JVM) {
+            continue;
+        }
+        if (is_mod_contain_addr(mod, addr, target_addr)) {
+            return mod;
+        }
+    }
+    return NULL;
+}
+
 int proc_search_addr_symb(struct proc_symbs_s *proc_symbs,
         u64 addr, struct addr_symb_s *addr_symb, char *comm)
 {
@@ -16,37 +16,38 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <netinet/tcp.h>
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
 #include "bpf.h"
+#include "hash.h"
 #include "tcp.h"
 
 /*
-127.0.0.1:38338users:(("lubanagent",pid=1709,fd=4))
-0.0.0.0:30467users:(("kube-proxy",pid=1528,fd=18))
-0.0.0.0:31075users:(("kube-proxy",pid=1528,fd=17))
-127.0.0.1:38339users:(("lubanagent",pid=1710,fd=4))
-127.0.0.1:10248users:(("kubelet",pid=1954,fd=24))
-0.0.0.0:32136users:(("kube-proxy",pid=1528,fd=21))
-*:10250users:(("kubelet",pid=1954,fd=25))
-[::]:111users:(("rpcbind",pid=1493,fd=9))
-*:10256users:(("kube-proxy",pid=1528,fd=13))
-[::]:22users:(("sshd",pid=1952,fd=4))
-*/
-#define SS_LISTEN_PORTS_COMMAND "ss -anptl | awk '{if (NR >1) print $4 $6}'"
-
-/*
-7.183.6.160:49552|10.32.0.1:443@users:(("kube-rbac-proxy",pid=8302,fd=8))
-7.183.6.160:57239|10.243.116.55:179@users:(("bird",pid=8769,fd=21))
-7.183.6.160:35605|10.247.120.26:179@users:(("bird",pid=8769,fd=10))
-7.183.6.160:22|10.136.115.208:56802@users:(("sshd",pid=1264958,fd=3),("sshd",pid=1264945,fd=3))
-[::ffff:7.183.6.160]:10250|[::ffff:10.28.19.57]:35859@users:(("kubelet",pid=1954,fd=32))
-[::ffff:7.183.6.160]:10250|[::ffff:10.28.18.95]:51694@users:(("kubelet",pid=1954,fd=33))
-*/
-#define SS_ESTAB_COMMAND "ss -anpt | grep ESTAB |  awk '{print $4 \"|\" $5 \"@\" $6}'"
-
-#define PORT_LEN 11
-#define PID_LEN 32
-#define FID_LEN 32
-
+ * Listen and established tcp sockets are dumped by NETLINK_SOCK_DIAG(inet_diag) in the netns of the caller,
+ * the kernel only returns sockets of the requested states. Sockets are then mapped to their owners
+ * (pid, fd, comm) by one pass over /proc/<pid>/fd of the processes in the same netns.
+ */
+#define SOCK_DIAG_BUF_LEN   (32 * 1024)
+#define SOCK_LINK_PREFIX    "socket:["
+#define TCP_STATE_FLAG(state)   (1U << (state))
+
+struct diag_sock_s {
+    H_HANDLE;
+    unsigned int ino;
+    unsigned char state;
+    unsigned char family;
+    unsigned short sport;
+    unsigned short dport;
+    unsigned int saddr[4];
+    unsigned int daddr[4];
+    struct tcp_estab *te;       // established socket, created at the 1st owner
+};
 
 static char __is_digit_str(const char *s)
 {
@@ -58,157 +59,6 @@ static char __is_digit_str(const char *s)
     return 1;
 }
 
-static int __get_next_str_offset(const char *s, const char* target)
-{
-    char *p;
-
-    p = strstr(s, target);
-    if ((p != NULL) && (p > s))
-        return p - s;
-
-    return -1;
-}
-
-static int __get_sub_str(const char *s, const char* start, const char *end,
-                                 char* sub_str_buf, unsigned int buf_len)
-{
-    const char *p2, *p1;
-    int len;
-
-    if (s == NULL)
-        return -1;
-
-    // Point to end, if no terminator is specified
-    if (end == NULL) {
-        p2 = s + strlen(s);
-    } else {
-        p2 = strstr(s, end);
-        if (p2 == NULL)
-            return -1;
-    }
-
-    // Point to start, if no start character is specified
-    if (start == NULL) {
-        p1 = s;
-    } else {
-        p1 = strstr(s, start);
-        if (p1 == NULL)
-            return -1;
-
-        p1 += strlen(start);
-    }
-
-    len = p2 - p1;
-    if ((len <= 0) || (len >= buf_len))
-        return -1;
-
-    (void)memcpy(sub_str_buf, p1, len);
-    sub_str_buf[len] = 0;
-    return 0;
-}
-
-static int __erase_square_brackets(const char* s, char *buf, unsigned int buf_len)
-{
-    char *p1, *p2;
-    int len;
-    char tmp[LINE_BUF_LEN];
-
-    p1 = strchr(s, '[');
-    p2 = strchr(s, ']');
-    if ((p1 == NULL) || (p2 == NULL))
-        return -1;
-
-    if (p2 <= p1)
-        return -1;
-
-    if (__get_sub_str(s, "[", "]", tmp, LINE_BUF_LEN) < 0)
-        return -1;
-
-    len = (int)strlen(tmp);
-    if (len >= buf_len)
-        return -1;
-
-    (void)memcpy(buf, tmp, len);
-    buf[len] = 0;
-    return 0;
-}
-
-/*
-input : [::ffff:7.183.6.160]:10250
-7.183.6.160:57239
-*/
-static int __get_estab_addr(const char *s, struct ip_addr* ip_addr,
-               const char *addr_buf)
-{
-    char *p;
-    int local_len, port_len, ip_len;
-    char port_str[PORT_LEN];
-
-    p = strrchr(addr_buf, ':');
-    if (p == NULL)
-        goto err;
-
-    local_len = (int)strlen(addr_buf);
-    ip_len = p - addr_buf;
-    if ((ip_len >= local_len) || (ip_len <= 0))
-        goto err;
-
-    (void)memcpy(ip_addr->ip, addr_buf, ip_len);
-    ip_addr->ip[ip_len] = 0;
-
-    if (__erase_square_brackets((const char*)ip_addr->ip, ip_addr->ip, IP_STR_LEN) == 0) {
-        ip_addr->ipv4 = 0;
-    } else {
-        ip_addr->ipv4 = 1;
-    }
-
-    port_len = local_len - ip_len - 1;
-    if ((port_len <= 0) || (port_len >= PORT_LEN))
-        goto err;
-
-    (void)memcpy(port_str, p + 1, port_len);
-    port_str[port_len] = 0;
-    if (__is_digit_str((const char *)port_str) == 0)
-        goto err;
-
-    ip_addr->port = (unsigned int)atoi(port_str);
-    return 0;
-err:
-    return -1;
-}
-
-static struct tcp_estab_comm* __get_estab_comm(const char *start, unsigned int len)
-{
-    /* ("sshd",pid=1264958,fd=3) */
-    int ret;
-    char comm[TASK_COMM_LEN];
-    char pid_s[PID_LEN];
-    char fd_s[FID_LEN];
-    char tmp[LINE_BUF_LEN];
-    const char *s = tmp;
-    struct tcp_estab_comm *te_comm;
-
-    if ((start == NULL) || (len >= LINE_BUF_LEN))
-        return NULL;
-
-    (void)memcpy(tmp, start, len);
-    tmp[len] = 0;
-
-    ret = __get_sub_str(s, "(\"", "\",", comm, TASK_COMM_LEN);
-    ret |= __get_sub_str(s, "pid=", ",fd", pid_s, PID_LEN);
-    ret |= __get_sub_str(s, ",fd=", ")", fd_s, FID_LEN);
-    if (ret < 0 || !__is_digit_str((const char *)pid_s)
-           || !__is_digit_str((const char *)fd_s))
-        return NULL;
-
-    te_comm = (struct tcp_estab_comm *)malloc(sizeof(struct tcp_estab_comm));
-    te_comm->comm[0] = 0;
-    (void)strcpy(te_comm->comm, comm);
-    te_comm->pid = (unsigned int)atoi(pid_s);
-    te_comm->fd = (unsigned int)atoi(fd_s);
-    return te_comm;
-}
-
 static int __add_estab_comm(struct tcp_estab* te, const struct tcp_estab_comm *te_comm)
 {
     if (te->te_comm_num >= TCP_ESTAB_COMM_MAX)
@@ -284,295 +134,367 @@ static void __free_estabs(struct tcp_estabs** ptes)
 }
 
 
-/*
-    input : 7.183.6.160:22|10.136.115.208:56802@users:(("sshd",pid=1264958,fd=3),("sshd",pid=1264945,fd=3))
-*/
-static int __get_estab(const char *s, struct tcp_estab* te)
+static struct tcp_listen_ports* __new_tlps(void)
 {
-    int ret;
-    int offset;
-    char *start, *end;
-    char addr_str[IP_STR_LEN];
-    char comms_str[LINE_BUF_LEN];
-    struct tcp_estab_comm *te_comm;
+    struct tcp_listen_ports *tlps;
+    tlps = (struct tcp_listen_ports *)malloc(sizeof(struct tcp_listen_ports));
+    if (tlps == NULL)
+        return NULL;
+
+    memset(tlps, 0, sizeof(struct tcp_listen_ports));
+    return tlps;
+}
+
+static void __free_tlps(struct tcp_listen_ports** ptlps)
+{
+    struct tcp_listen_ports* tlps = *ptlps;
 
-    // get establish tcp local address and port
-    addr_str[0] = 0;
-    ret = __get_sub_str(s, NULL, "|", addr_str, IP_STR_LEN);
-    ret |= __get_estab_addr(s, &(te->local), addr_str);
-    if (ret < 0)
-        goto err;
-
-    // get establish tcp remote address and port
-    addr_str[0] = 0;
-    ret = __get_sub_str(s, "|", "@", addr_str, IP_STR_LEN);
-    ret |= __get_estab_addr(s, &(te->remote), addr_str);
-    if (ret < 0)
-        goto err;
-
-    // get all comm, pid, fd of establish tcp
-    ret = __get_sub_str(s, "@users:(", NULL, comms_str, LINE_BUF_LEN);
-    if (ret < 0)
-        goto err;
-
-    comms_str[strlen(comms_str) - 1] = 0; // Delete last character ')'
-
-    // one by one
-    start = comms_str;
-    end = start + strlen(comms_str);
-    do {
-        if (start >= end)
-            break;
-
-        offset = __get_next_str_offset((const char *)start, ",(");
-        if (offset < 0)
-            break;
-
-        // get one comm, pid, fd of establish tcp
-        te_comm = __get_estab_comm((const char*)start, offset);
-        if (te_comm != NULL) {
-            if (__add_estab_comm(te, te_comm) < 0)
-               (void)free(te_comm);
+    for (int i = 0; i < tlps->tlp_num; i++) {
+        if (tlps->tlp[i] != NULL) {
+            (void)free(tlps->tlp[i]);
+            tlps->tlp[i] = NULL;
         }
-        start += offset + 1;
-    } while (1);
-
-    // get last(or only one) comm, pid, fd of establish tcp
-    te_comm = __get_estab_comm((const char*)start, strlen(start));
-    if (te_comm != NULL) {
-        if (__add_estab_comm(te, te_comm) < 0)
-            (void)free(te_comm);
     }
-
-    return 0;
-err:
-    return -1;
+    tlps->tlp_num = 0;
+    (void)free(tlps);
+    *ptlps = NULL;
+    return;
 }
 
-
-static int __get_estabs(struct tcp_estabs* tes)
+static int __add_tlp(struct tcp_listen_ports* tlps, const struct tcp_listen_port* tlp)
 {
-    char line[LINE_BUF_LEN];
-    FILE *f;
-    const char *command = SS_ESTAB_COMMAND;
-    struct tcp_estab* te;
-    int ret;
+    // 'tlp->port' is a 16-bit port from sock_diag, always less than PORT_MAX_NUM
+    if (tlps->tlp_hash[tlp->port] == 1)
+        return -1;
 
-    f = popen(command, "r");
-    if (f == NULL)
+    if (tlps->tlp_num >= LTP_MAX_NUM)
         return -1;
 
-    while (!feof(f)) {
-        (void)memset(line, 0, LINE_BUF_LEN);
-        if (fgets(line, LINE_BUF_LEN, f) == NULL)
-            break;
+    tlps->tlp_hash[tlp->port] = 1;
+    tlps->tlp[tlps->tlp_num] = (struct tcp_listen_port *)tlp;
+    tlps->tlp_num++;
+    return 0;
+}
 
-        te = __new_estab();
-        if (te == NULL)
-            break;
 
-        ret = __get_estab((const char *)line, te);
-        if (ret < 0) {
-            __free_estab(&te);
-            continue;
-        }
+static void __free_diag_socks(struct diag_sock_s **psocks)
+{
+    struct diag_sock_s *sock, *tmp;
 
-        ret = __add_estab(tes, te);
-        if (ret < 0)
-            __free_estab(&te);
+    H_ITER(*psocks, sock, tmp) {
+        H_DEL(*psocks, sock);
+        (void)free(sock);
     }
-    (void)pclose(f);
-    return 0;
+    *psocks = NULL;
 }
 
-/*
-                       _______
-                       |     |
-   s example: 127.0.0.1:38338users:(("lubanagent",pid=1709,fd=4))
-*/
-static int __get_listen_port(const char *s, unsigned int *port)
+static int __add_diag_sock(struct diag_sock_s **psocks, const struct inet_diag_msg *msg)
 {
-    int ret;
-    char port_str[PORT_LEN];
-    unsigned int port_num;
+    struct diag_sock_s *sock = NULL;
+    unsigned int ino = msg->idiag_inode;
 
-    if (strstr(s, "]:")) {
-        ret = __get_sub_str(s, "]:", "users:", port_str, PORT_LEN);
-        if (ret < 0)
-            return -1;
-    } else {
-        ret = __get_sub_str(s, ":", "users:", port_str, PORT_LEN);
-        if (ret < 0)
-            return -1;
-    }
+    // Sockets without inode(e.g. orphaned) have no owner.
+    if (ino == 0)
+        return 0;
 
-    if (__is_digit_str((const char *)port_str) == 0)
-        return -1;
+    H_FIND(*psocks, &ino, sizeof(unsigned int), sock);
+    if (sock != NULL)
+        return 0;
 
-    port_num = (unsigned int)atoi(port_str);
-    if (port_num >= PORT_MAX_NUM)
+    sock = (struct diag_sock_s *)malloc(sizeof(struct diag_sock_s));
+    if (sock == NULL)
         return -1;
 
-    *port = port_num;
+    (void)memset(sock, 0, sizeof(struct diag_sock_s));
+    sock->ino = ino;
+    sock->state = msg->idiag_state;
+    sock->family = msg->idiag_family;
+    sock->sport = ntohs(msg->id.idiag_sport);
+    sock->dport = ntohs(msg->id.idiag_dport);
+    (void)memcpy(sock->saddr, msg->id.idiag_src, sizeof(sock->saddr));
+    (void)memcpy(sock->daddr, msg->id.idiag_dst, sizeof(sock->daddr));
+    H_ADD(*psocks, ino, sizeof(unsigned int), sock);
     return 0;
 }
 
-/*
-                                     ____________
-                                     |          |
-   s example: 127.0.0.1:38338users:(("lubanagent",pid=1709,fd=4))
-*/
-static int __get_listen_comm(const char *s, char *comm_buf, unsigned int buf_len)
+static int __sock_diag_dump(int nl_fd, unsigned char family, unsigned int states,
+                            struct diag_sock_s **psocks, char *buf)
 {
-    return __get_sub_str(s, "((\"", "\",pid", comm_buf, buf_len);
-}
+    ssize_t len;
+    struct nlmsghdr *nlh;
+    struct nlmsgerr *nl_err;
+    struct {
+        struct nlmsghdr nlh;
+        struct inet_diag_req_v2 req;
+    } request;
 
-/*
-                                                     ______
-                                                     |    |
-   s example: 127.0.0.1:38338users:(("lubanagent",pid=1709,fd=4))
-*/
-static int __get_listen_pid(const char *s, unsigned int *pid)
-{
-    int ret;
-    char pid_str[PID_LEN];
+    (void)memset(&request, 0, sizeof(request));
+    request.nlh.nlmsg_len = sizeof(request);
+    request.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    request.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.req.sdiag_family = family;
+    request.req.sdiag_protocol = IPPROTO_TCP;
+    request.req.idiag_states = states;
 
-    ret = __get_sub_str(s, "pid=", ",fd=", pid_str, PID_LEN);
-    if (ret < 0)
+    if (send(nl_fd, &request, sizeof(request), 0) < 0)
         return -1;
 
-    if (__is_digit_str((const char *)pid_str) == 0)
-        return -1;
+    while (1) {
+        len = recv(nl_fd, buf, SOCK_DIAG_BUF_LEN, 0);
+        if (len < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (len == 0)
+            return 0;
 
-    *pid = (unsigned int)atoi(pid_str);
-    return 0;
+        for (nlh = (struct nlmsghdr *)buf; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_type == NLMSG_DONE)
+                return 0;
+
+            if (nlh->nlmsg_type == NLMSG_ERROR) {
+                nl_err = (struct nlmsgerr *)NLMSG_DATA(nlh);
+                ERROR("[TCP]: Sock diag dump failed.(family = %u, err = %d)\n", family, nl_err->error);
+                return -1;
+            }
+
+            if (nlh->nlmsg_type != SOCK_DIAG_BY_FAMILY)
+                continue;
+
+            if (__add_diag_sock(psocks, (const struct inet_diag_msg *)NLMSG_DATA(nlh)) < 0)
+                return -1;
+        }
+    }
 }
 
-/*
-   s example: 127.0.0.1:38338users:(("lubanagent",pid=1709,fd=4))
-*/
-static int __get_listen_fd(const char *s, int *fd)
+static int __dump_diag_socks(unsigned int states, struct diag_sock_s **psocks)
 {
-    int ret;
-    char fd_str[FID_LEN];
+    int nl_fd, ret4, ret6;
+    char *buf;
 
-    ret = __get_sub_str(s, "fd=", "))", fd_str, FID_LEN);
-    if (ret < 0)
+    nl_fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+    if (nl_fd < 0) {
+        ERROR("[TCP]: Create sock diag socket failed.(errno = %d)\n", errno);
         return -1;
+    }
 
-    if (__is_digit_str((const char *)fd_str) == 0)
+    buf = (char *)malloc(SOCK_DIAG_BUF_LEN);
+    if (buf == NULL) {
+        (void)close(nl_fd);
         return -1;
+    }
 
-    *fd = atoi(fd_str);
-    return 0;
+    ret4 = __sock_diag_dump(nl_fd, AF_INET, states, psocks, buf);
+    // AF_INET6 fails if ipv6 is disabled, v4-mapped sockets are dumped here otherwise.
+    ret6 = __sock_diag_dump(nl_fd, AF_INET6, states, psocks, buf);
+
+    (void)free(buf);
+    (void)close(nl_fd);
+    return (ret4 < 0 && ret6 < 0) ? -1 : 0;
 }
 
-static struct tcp_listen_port* __new_tlp(const char *s)
+static void __get_ip_addr(unsigned char family, const unsigned int *ip, unsigned short port, struct ip_addr *addr)
+{
+    addr->ip[0] = 0;
+    (void)inet_ntop(family, ip, addr->ip, IP_STR_LEN);
+    addr->ipv4 = (family == AF_INET) ? 1 : 0;
+    addr->port = port;
+}
+
+static void __add_listen_owner(struct tcp_listen_ports* tlps, const struct diag_sock_s *sock,
+                               const struct tcp_estab_comm *owner)
 {
-    int ret;
-    unsigned int port, pid;
-    int fd;
-    char comm[TASK_COMM_LEN];
     struct tcp_listen_port* tlp;
 
-    ret = __get_listen_port(s, &port);
-    if (ret < 0)
-        return NULL;
+    // Only the 1st owner of a port is kept.
+    if (is_listen_port(sock->sport, tlps))
+        return;
 
-    ret = __get_listen_comm(s, comm, TASK_COMM_LEN);
-    if (ret < 0)
-        return NULL;
+    tlp = (struct tcp_listen_port *)malloc(sizeof(struct tcp_listen_port));
+    if (tlp == NULL)
+        return;
 
-    ret = __get_listen_pid(s, &pid);
-    if (ret < 0)
-        return NULL;
+    tlp->pid = owner->pid;
+    tlp->port = sock->sport;
+    tlp->fd = owner->fd;
+    memcpy(tlp->comm, owner->comm, TASK_COMM_LEN);
+    if (__add_tlp(tlps, tlp) < 0)
+        (void)free(tlp);
+}
 
-    ret = __get_listen_fd(s, &fd);
-    if (ret < 0)
-        return NULL;
+static void __add_estab_owner(struct tcp_estabs* tes, struct diag_sock_s *sock, const struct tcp_estab_comm *owner)
+{
+    struct tcp_estab_comm *te_comm;
 
-    tlp = (struct tcp_listen_port *)malloc(sizeof(struct tcp_listen_port));
-    if (tlp == NULL)
-        return NULL;
+    if (sock->te == NULL) {
+        if (tes->te_num >= TCP_ESTAB_MAX)
+            return;
+
+        sock->te = __new_estab();
+        if (sock->te == NULL)
+            return;
+
+        __get_ip_addr(sock->family, sock->saddr, sock->sport, &(sock->te->local));
+        __get_ip_addr(sock->family, sock->daddr, sock->dport, &(sock->te->remote));
+        (void)__add_estab(tes, sock->te);
+    }
+
+    te_comm = (struct tcp_estab_comm *)malloc(sizeof(struct tcp_estab_comm));
+    if (te_comm == NULL)
+        return;
 
-    tlp->pid = pid;
-    tlp->port = port;
-    tlp->fd = fd;
-    memcpy(tlp->comm, comm, TASK_COMM_LEN);
-    return tlp;
+    memcpy(te_comm, owner, sizeof(struct tcp_estab_comm));
+    if (__add_estab_comm(sock->te, te_comm) < 0)
+        (void)free(te_comm);
 }
 
-static struct tcp_listen_ports* __new_tlps(void)
+static void __get_proc_comm(unsigned int pid, char *comm)
 {
-    struct tcp_listen_ports *tlps;
-    tlps = (struct tcp_listen_ports *)malloc(sizeof(struct tcp_listen_ports));
-    if (tlps == NULL)
-        return NULL;
+    FILE *f;
+    char path[PATH_LEN];
 
-    memset(tlps, 0, sizeof(struct tcp_listen_ports));
-    return tlps;
+    comm[0] = 0;
+    path[0] = 0;
+    (void)snprintf(path, PATH_LEN, "/proc/%u/comm", pid);
+    f = fopen(path, "r");
+    if (f == NULL)
+        return;
+
+    if (fgets(comm, TASK_COMM_LEN, f) != NULL)
+        comm[strcspn(comm, "\n")] = 0;
+    (void)fclose(f);
 }
 
-static void __free_tlps(struct tcp_listen_ports** ptlps)
+static void __walk_proc_socks(unsigned int pid, struct diag_sock_s *socks,
+                              struct tcp_listen_ports* tlps, struct tcp_estabs* tes)
 {
-    struct tcp_listen_ports* tlps = *ptlps;
+    DIR *dir;
+    struct dirent *entry;
+    ssize_t len;
+    unsigned int ino;
+    char path[PATH_LEN];
+    char link[PATH_LEN];
+    struct diag_sock_s *sock;
+    struct tcp_estab_comm owner = {0};
 
-    for (int i = 0; i < tlps->tlp_num; i++) {
-        if (tlps->tlp[i] != NULL) {
-            (void)free(tlps->tlp[i]);
-            tlps->tlp[i] = NULL;
+    path[0] = 0;
+    (void)snprintf(path, PATH_LEN, "/proc/%u/fd", pid);
+    dir = opendir(path);
+    if (dir == NULL)
+        return;
+
+    owner.pid = pid;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!isdigit(entry->d_name[0]))
+            continue;
+
+        len = readlinkat(dirfd(dir), entry->d_name, link, PATH_LEN - 1);
+        if (len <= 0)
+            continue;
+        link[len] = 0;
+
+        if (strncmp(link, SOCK_LINK_PREFIX, sizeof(SOCK_LINK_PREFIX) - 1) != 0)
+            continue;
+
+        ino = (unsigned int)strtoul(link + sizeof(SOCK_LINK_PREFIX) - 1, NULL, 10);
+        sock = NULL;
+        H_FIND(socks, &ino, sizeof(unsigned int), sock);
+        if (sock == NULL)
+            continue;
+
+        if (owner.comm[0] == 0)
+            __get_proc_comm(pid, owner.comm);
+        owner.fd = (unsigned int)atoi(entry->d_name);
+
+        if (sock->state == TCP_LISTEN) {
+            if (tlps)
+                __add_listen_owner(tlps, sock, &owner);
+        } else if (tes) {
+            __add_estab_owner(tes, sock, &owner);
         }
     }
-    tlps->tlp_num = 0;
-    (void)free(tlps);
-    *ptlps = NULL;
-    return;
+    (void)closedir(dir);
 }
 
-static int __add_tlp(struct tcp_listen_ports* tlps, const struct tcp_listen_port* tlp)
+static int __get_netns_ino(const char *ns_path, ino_t *ino)
 {
-    // Already judge legal of 'tlp->port' in function __get_listen_port
-    if (tlps->tlp_hash[tlp->port] == 1)
-        return -1;
+    struct stat st;
 
-    if (tlps->tlp_num >= LTP_MAX_NUM)
+    if (stat(ns_path, &st) != 0)
         return -1;
 
-    tlps->tlp_hash[tlp->port] = 1;
-    tlps->tlp[tlps->tlp_num] = (struct tcp_listen_port *)tlp;
-    tlps->tlp_num++;
+    *ino = st.st_ino;
     return 0;
 }
 
-static int __get_tlps(struct tcp_listen_ports* tlps)
-{
-    char line[LINE_BUF_LEN];
-    FILE *f;
-    const char *command = SS_LISTEN_PORTS_COMMAND;
-    struct tcp_listen_port* tlp;
-    int ret;
+/*
+ * Sockets are only visible to sock_diag of their own netns, so only processes in the netns of the caller
+ * (which may have entered a container netns) can own them.
+ */
+static void __walk_sock_owners(struct diag_sock_s *socks, struct tcp_listen_ports* tlps, struct tcp_estabs* tes)
+{
+    DIR *dir;
+    struct dirent *entry;
+    ino_t netns, proc_netns;
+    char path[PATH_LEN];
+
+    if (__get_netns_ino("/proc/thread-self/ns/net", &netns) < 0 &&
+        __get_netns_ino("/proc/self/ns/net", &netns) < 0)
+        return;
 
-    f = popen(command, "r");
-    if (f == NULL)
-        return -1;
+    dir = opendir("/proc");
+    if (dir == NULL)
+        return;
 
-    while (feof(f) == 0) {
-        (void)memset(line, 0, LINE_BUF_LEN);
-        if (fgets(line, LINE_BUF_LEN, f) == NULL)
-            break;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!__is_digit_str(entry->d_name))
+            continue;
 
-        tlp = __new_tlp((const char *)line);
-        if (tlp == NULL)
+        path[0] = 0;
+        (void)snprintf(path, PATH_LEN, "/proc/%s/ns/net", entry->d_name);
+        if (__get_netns_ino(path, &proc_netns) < 0 || proc_netns != netns)
             continue;
 
-        ret = __add_tlp(tlps, tlp);
-        if (ret < 0)
-            (void)free(tlp);
+        __walk_proc_socks((unsigned int)atoi(entry->d_name), socks, tlps, tes);
+    }
+    (void)closedir(dir);
+}
+
+// Get listen ports and/or established tcps of the current netns in one sock_diag dump and one pass over /proc.
+static int __get_tcp_socks(struct tcp_listen_ports* tlps, struct tcp_estabs* tes)
+{
+    unsigned int states = 0;
+    struct diag_sock_s *socks = NULL;
+
+    if (tlps)
+        states |= TCP_STATE_FLAG(TCP_LISTEN);
+    if (tes)
+        states |= TCP_STATE_FLAG(TCP_ESTABLISHED);
+
+    if (__dump_diag_socks(states, &socks) < 0) {
+        __free_diag_socks(&socks);
+        return -1;
     }
-    (void)pclose(f);
+
+    if (socks != NULL)
+        __walk_sock_owners(socks, tlps, tes);
+
+    __free_diag_socks(&socks);
     return 0;
 }
 
+static void __set_estab_role(struct tcp_estabs* tes, struct tcp_listen_ports* tlps)
+{
+    for (int i = 0; i < tes->te_num; i++) {
+        if (is_listen_port(tes->te[i]->local.port, tlps)) {
+            tes->te[i]->is_client = 0;
+        } else {
+            tes->te[i]->is_client = 1;
+        }
+    }
+}
+
 char is_listen_port(unsigned int port, struct tcp_listen_ports* tlps)
 {
     if (port >= PORT_MAX_NUM)
@@ -590,7 +512,7 @@ struct tcp_listen_ports* get_listen_ports(void)
     if (tlps == NULL)
         return NULL;
 
-    ret = __get_tlps(tlps);
+    ret = __get_tcp_socks(tlps, NULL);
     if (ret < 0) {
         __free_tlps(&tlps);
         return NULL;
@@ -612,22 +534,46 @@ struct tcp_estabs* get_estab_tcps(struct tcp_listen_ports* tlps)
     if (tes == NULL)
         return NULL;
 
-    ret = __get_estabs(tes);
+    ret = __get_tcp_socks(NULL, tes);
     if (ret < 0) {
         __free_estabs(&tes);
         return NULL;
     }
 
-    for (int i = 0; i < tes->te_num; i++) {
-        if (is_listen_port(tes->te[i]->local.port, tlps)) {
-            tes->te[i]->is_client = 0;
-        } else {
-            tes->te[i]->is_client = 1;
-        }
-    }
+    __set_estab_role(tes, tlps);
     return tes;
 }
 
+int get_listen_estab_tcps(struct tcp_listen_ports** ptlps, struct tcp_estabs** ptes)
+{
+    struct tcp_listen_ports* tlps;
+    struct tcp_estabs* tes;
+
+    *ptlps = NULL;
+    *ptes = NULL;
+
+    tlps = __new_tlps();
+    if (tlps == NULL)
+        return -1;
+
+    tes = __new_estabs();
+    if (tes == NULL) {
+        __free_tlps(&tlps);
+        return -1;
+    }
+
+    if (__get_tcp_socks(tlps, tes) < 0) {
+        __free_tlps(&tlps);
+        __free_estabs(&tes);
+        return -1;
+    }
+
+    __set_estab_role(tes, tlps);
+    *ptlps = tlps;
+    *ptes = tes;
+    return 0;
+}
+
 void free_estab_tcps(struct tcp_estabs** ptes)
 {
     __free_estabs(ptes);
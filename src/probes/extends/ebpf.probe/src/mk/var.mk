@@ -35,11 +35,6 @@ KER_VER_PATCH = $(shell echo $(KER_VER) | awk -F'.' '{print $$3}')
 RELEASE_INFOS = $(shell echo $(LINUX_VER) | awk -F'-' '{print $$2}')
 KER_RELEASE = $(shell echo $(RELEASE_INFOS) | awk -F'.' '{print $$1}')
 
-ifeq ($(wildcard $(VMLINUX)), )
-    $(shell cd $(INCLUDE_DIR); \
-    ln -s linux_${LINUX_VER}.h vmlinux.h;)
-endif
-
 LIBBPF_VER = $(shell rpm -q libbpf | awk -F'-' '{print $$2}')
 LIBBPF_VER_MAJOR = $(shell echo $(LIBBPF_VER) | awk -F'.' '{print $$1}')
 LIBBPF_VER_MINOR = $(shell echo $(LIBBPF_VER) | awk -F'.' '{print $$2}')
@@ -51,6 +46,15 @@ ifeq ($(wildcard $(BPFTOOL)), )
     else ln -s bpftool_${ARCH} bpftool; fi; )
 endif
 
+# The pre-generated header of the kernel is preferred, otherwise it is dumped from the kernel BTF(CO-RE).
+ifeq ($(wildcard $(VMLINUX)), )
+    $(shell cd $(INCLUDE_DIR); \
+    if [ -f linux_${LINUX_VER}.h ]; then ln -s linux_${LINUX_VER}.h vmlinux.h; \
+    elif [ -f /sys/kernel/btf/vmlinux ]; then \
+        $(BPFTOOL) btf dump file /sys/kernel/btf/vmlinux format c > vmlinux.h || rm -f vmlinux.h; \
+    else ln -s linux_${LINUX_VER}.h vmlinux.h; fi; )
+endif
+
 BTF_ENABLE = $(shell if [ -f /sys/kernel/btf/vmlinux ]; then echo "ON" ; else echo "OFF"; fi)
 
 LINK_TARGET ?= -lpthread -lbpf -lelf -llog4cplus -lz -lconfig
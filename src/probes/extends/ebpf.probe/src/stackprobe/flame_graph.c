@@ -34,15 +34,12 @@
 #undef BPF_PROG_USER
 #endif
 
+#include <curl/curl.h>
+
 #include "bpf.h"
 #include "flame_graph.h"
-
-extern int g_post_max;
-
-struct MemoryStruct {
-  char *memory;
-  size_t size;
-};
+#include "pprof.h"
+#include "post_sender.h"
 
 static char *appname[STACK_SVG_MAX] = {
     "gala-gopher-oncpu",
@@ -51,6 +48,19 @@ static char *appname[STACK_SVG_MAX] = {
     "gala-gopher-io"
 };
 
+struct pprof_sample_type_s {
+    const char *type;
+    const char *unit;
+};
+
+// Sample type names known by pyroscope's pprof ingestion.
+static struct pprof_sample_type_s sample_types[STACK_SVG_MAX] = {
+    {"samples", "count"},
+    {"samples", "count"},
+    {"inuse_space", "bytes"},
+    {"samples", "count"}
+};
+
 #if 1
 
 static char __test_flame_graph_flags(struct stack_svg_mng_s *svg_mng, u32 flags)
@@ -98,7 +108,6 @@ static FILE *__open_flame_graph_fp(struct stack_svg_mng_s *svg_mng)
     return sfg->fp;
 }
 
-
 static void __mkdir_flame_graph_path(struct stack_svg_mng_s *svg_mng)
 {
     FILE *fp;
@@ -145,22 +154,11 @@ static void __set_flame_graph_file(struct stack_svg_mng_s *svg_mng)
 
 static void __rm_flame_graph_file(struct stack_svg_mng_s *svg_mng)
 {
-#define __COMMAND_LEN   (2 * PATH_LEN)
-    FILE *fp;
-    char commad[__COMMAND_LEN];
     struct stack_flamegraph_s *sfg;
 
     sfg = &(svg_mng->flame_graph);
 
-    if (!access(sfg->flame_graph_file, 0)) {
-        commad[0] = 0;
-        (void)snprintf(commad, __COMMAND_LEN, "/usr/bin/rm -f %s", sfg->flame_graph_file);
-        fp = popen(commad, "r");
-        if (fp != NULL) {
-            (void)pclose(fp);
-            fp = NULL;
-        }
-    }
+    (void)unlink(sfg->flame_graph_file);
     if (sfg->fp) {
         (void)fclose(sfg->fp);
         sfg->fp = NULL;
@@ -175,156 +173,88 @@ static void __reopen_flame_graph_file(struct stack_svg_mng_s *svg_mng)
     __set_flame_graph_flags(svg_mng, FLAME_GRAPH_NEW);
 }
 
-
-
-static size_t __write_memory_cb(void *contents, size_t size, size_t nmemb, void *userp)
-{
-    size_t realsize = size * nmemb;
-    struct MemoryStruct *mem = (struct MemoryStruct *)userp;
-    
-    char *ptr = realloc(mem->memory, mem->size + realsize + 1);
-    if(!ptr) {
-        /* out of memory! */
-        printf("not enough memory (realloc returned NULL)\n");
-        return 0;
-    }
-    
-    mem->memory = ptr;
-    memcpy(&(mem->memory[mem->size]), contents, realsize);
-    mem->size += realsize;
-    mem->memory[mem->size] = 0;
-    
-    return realsize;
-}
- 
-// http://localhost:4040/ingest?name=gala-gopher-oncpu&from=1671189474&until=1671189534
-static int __build_url(char *url, struct post_server_s *post_server, int en_type)
+// http://localhost:4040/ingest?name=gala-gopher-oncpu&from=1671189474&until=1671189534&format=pprof
+static int __build_url(char *url, struct post_server_s *post_server, int en_type, time_t *from, time_t *until)
 {
     time_t now, before;
     (void)time(&now);
-    if (post_server->last_post_ts == 0) {
+    if (post_server->last_post_ts[en_type] == 0) {
         before = now - TMOUT_PERIOD;
     } else {
-        before = post_server->last_post_ts + 1;
+        before = post_server->last_post_ts[en_type] + 1;
     }
-    post_server->last_post_ts = now;
+    post_server->last_post_ts[en_type] = now;
 
-    (void)snprintf(url, LINE_BUF_LEN, 
-        "http://%s/ingest?name=%s-%s&from=%ld&until=%ld&units=%s",
+    (void)snprintf(url, LINE_BUF_LEN,
+        "http://%s/ingest?name=%s-%s&from=%ld&until=%ld&units=%s&format=pprof",
         post_server->host,
         appname[en_type],
         post_server->app_suffix,
         (long)before,
         (long)now,
         en_type == STACK_SVG_MEMLEAK ? "bytes" : "samples");
+    *from = before;
+    *until = now;
     return 0;
 }
 
-
-static void __curl_post(struct post_server_s *post_server, struct post_info_s *post_info, int en_type)
+static void __post_pprof(struct post_server_s *post_server, struct post_info_s *post_info, int en_type)
 {
-    CURLcode res;
-    CURL *curl = post_info->curl;
-    if (curl == NULL) {
-        goto end2;
-    }
+    char url[LINE_BUF_LEN];
+    time_t from, until;
+    struct pb_buf_s raw = {0}, gz = {0};
 
-    long post_len = (long)strlen(post_info->buf_start);
-    if (post_len == 0) {
-        DEBUG("[FLAMEGRAPH]: buf is null. No need to curl post post to %s\n", appname[en_type]);
-        goto end1;
+    if (pprof_sample_count(post_info->pprof) == 0) {
+        DEBUG("[FLAMEGRAPH]: No samples. No need to post to %s\n", appname[en_type]);
+        return;
     }
 
-    char url[LINE_BUF_LEN] = {0};
-    __build_url(url, post_server, en_type);
-    struct MemoryStruct chunk;
-    chunk.memory = malloc(1);  /* will be grown as needed by realloc above */
-    chunk.size = 0;    /* no data at this point */
-
-    //curl_easy_setopt(curl, CURLOPT_URL, post_server->host);
-    curl_easy_setopt(curl, CURLOPT_URL, url);
+    url[0] = 0;
+    (void)__build_url(url, post_server, en_type, &from, &until);
 
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, post_server->timeout);
-
-    /* send all data to this function */
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, __write_memory_cb);
-
-    /* we pass our 'chunk' struct to the callback function */
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
-
-    /* some servers do not like requests that are made without a user-agent
-    field, so we provide one */
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
-
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_info->buf_start);
-
-    /* if we do not provide POSTFIELDSIZE, libcurl will strlen() by
-    itself */
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, post_len);
-
-    /* Perform the request, res will get the return code */
-    res = curl_easy_perform(curl);
-    /* Check for errors */
-    if(res != CURLE_OK) {
-        ERROR("[FLAMEGRAPH]: curl post to %s failed: %s\n", url, curl_easy_strerror(res));
-    } else {
-        INFO("[FLAMEGRAPH]: curl post post to %s success\n", url);
+    if (pprof_encode(post_info->pprof, (u64)from * NSEC_PER_SEC, (u64)(until - from) * NSEC_PER_SEC, &raw)
+        || pprof_gzip(&raw, &gz)) {
+        ERROR("[FLAMEGRAPH]: Encode pprof for %s failed.\n", appname[en_type]);
+        pb_buf_free(&raw);
+        pb_buf_free(&gz);
+        return;
     }
+    pb_buf_free(&raw);
 
-    if (chunk.memory) {
-        free(chunk.memory);
-    }
-end1:
-    /* always cleanup */
-    curl_easy_cleanup(curl);
-    post_info->curl = NULL;
-end2:
-    if (post_info->buf_start != NULL) {
-        free(post_info->buf_start);
-        post_info->buf_start = NULL;
-    }
-    return;
+    // Uploaded by the sender thread, the body is handed over.
+    (void)post_sender_enqueue(post_server->sender, url, gz.data, gz.len);
 }
 
-static void __init_curl_handle(struct post_server_s *post_server, struct post_info_s *post_info)
+static void __init_post_info(struct post_server_s *post_server, struct post_info_s *post_info, int en_type)
 {
-    if (post_server == NULL || post_server->post_enable == 0) {
+    if (post_server == NULL || post_server->post_enable == 0 || post_server->sender == NULL) {
         return;
     }
 
-    if (post_info->curl != NULL) {
-        ERROR("[FLAMEGRAPH]: curl was not freed normally\n");
-    } else {
-        post_info->curl = curl_easy_init();
-    }
-
-    if(post_info->curl) {
-        post_info->buf = (char *)malloc(g_post_max);
-        post_info->buf_start = post_info->buf;
-        if (post_info->buf != NULL) {
-            post_info->buf[0] = 0;
-            post_info->post_flag = 1;
-        }
+    post_info->pprof = create_pprof_builder(sample_types[en_type].type, sample_types[en_type].unit, 1);
+    if (post_info->pprof != NULL) {
+        post_info->post_flag = 1;
     }
 }
 
 static void __do_wr_flamegraph(struct stack_svg_mng_s *svg_mng, struct post_server_s *post_server, int en_type)
 {
     int first_flag = 0;
-    struct post_info_s post_info = {.remain_size = g_post_max, .post_flag = 0};
+    struct post_info_s post_info = {.post_flag = 0, .pprof = NULL};
 
     if (__test_flame_graph_flags(svg_mng, FLAME_GRAPH_NEW)) {
         first_flag = 1;
     }
 
-    __init_curl_handle(post_server, &post_info);
+    __init_post_info(post_server, &post_info, en_type);
 
     iter_histo_tbl(svg_mng, en_type, &first_flag, &post_info);
 
     if (post_info.post_flag) {
-        __curl_post(post_server, &post_info, en_type);
+        __post_pprof(post_server, &post_info, en_type);
     }
-    
+    destroy_pprof_builder(post_info.pprof);
+
     __flush_flame_graph_file(svg_mng);
     __reset_flame_graph_flags(svg_mng, ~FLAME_GRAPH_NEW);
 }
@@ -387,14 +317,21 @@ int set_post_server(struct post_server_s *post_server, const char *server_str)
     }
 
     curl_global_init(CURL_GLOBAL_ALL);
-    post_server->post_enable = 1;
     post_server->timeout = 3;
     (void)strcpy(post_server->host, server_str);
+    post_server->sender = create_post_sender(post_server->timeout);
+    if (post_server->sender == NULL) {
+        curl_global_cleanup();
+        return -1;
+    }
+    post_server->post_enable = 1;
 
     return 0;
 }
 
-void clean_post_server()
+void clean_post_server(struct post_server_s *post_server)
 {
+    destroy_post_sender(post_server->sender);
+    post_server->sender = NULL;
     curl_global_cleanup();
 }
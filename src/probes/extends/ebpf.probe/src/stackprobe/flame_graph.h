@@ -25,5 +25,5 @@ int do_wr_stack_histo(struct stack_svg_mng_s *svg_mng,
 void wr_flamegraph(struct stack_svg_mng_s *svg_mng, int en_type, struct post_server_s *post_server);
 int set_flame_graph_path(struct stack_svg_mng_s *svg_mng, const char* path, const char *flame_name);
 int set_post_server(struct post_server_s *post_server, const char *pyroscopeServer);
-void clean_post_server();
+void clean_post_server(struct post_server_s *post_server);
 #endif
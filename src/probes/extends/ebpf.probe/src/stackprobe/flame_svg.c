@@ -0,0 +1,382 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-08-10
+ * Description: native flame graph svg renderer
+ ******************************************************************************/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flame_svg.h"
+
+// Layout follows the defaults of flamegraph.pl, so the output looks the same as before.
+#define FLAME_IMAGE_WIDTH       1200
+#define FLAME_FRAME_HEIGHT      16
+#define FLAME_FONT_SIZE         12
+#define FLAME_FONT_WIDTH        0.59
+#define FLAME_MIN_WIDTH         0.1     // frames narrower than this (pixels) are omitted
+#define FLAME_XPAD              10
+#define FLAME_YPAD1             (FLAME_FONT_SIZE * 3)
+#define FLAME_YPAD2             (FLAME_FONT_SIZE * 2 + 10)
+#define FLAME_ROOT_NAME         "all"
+#define FLAME_MAX_DEPTH         1024
+
+struct flame_svg_ctx_s {
+    FILE *fp;
+    const struct flame_svg_opts_s *opts;
+    u64 total;
+    double width_per_count;
+    u32 image_height;
+};
+
+void init_flame_tree(struct flame_tree_s *tree)
+{
+    (void)memset(tree, 0, sizeof(struct flame_tree_s));
+    tree->root.name = FLAME_ROOT_NAME;
+}
+
+static void __destroy_flame_node(struct flame_node_s *node)
+{
+    struct flame_node_s *child, *tmp;
+
+    H_ITER(node->children, child, tmp) {
+        H_DEL(node->children, child);
+        __destroy_flame_node(child);
+        (void)free(child->name);
+        (void)free(child);
+    }
+    node->children = NULL;
+}
+
+void destroy_flame_tree(struct flame_tree_s *tree)
+{
+    if (!tree) {
+        return;
+    }
+    __destroy_flame_node(&tree->root);
+    tree->root.value = 0;
+    tree->max_depth = 0;
+}
+
+static struct flame_node_s *__get_flame_child(struct flame_node_s *parent, const char *name, size_t len)
+{
+    struct flame_node_s *child = NULL;
+
+    H_FIND(parent->children, name, len, child);
+    if (child) {
+        return child;
+    }
+
+    child = (struct flame_node_s *)calloc(1, sizeof(struct flame_node_s));
+    if (!child) {
+        return NULL;
+    }
+    child->name = strndup(name, len);
+    if (!child->name) {
+        (void)free(child);
+        return NULL;
+    }
+    H_ADD_KEYPTR(parent->children, child->name, len, child);
+    return child;
+}
+
+int flame_tree_add_stack(struct flame_tree_s *tree, char *stack, u64 count)
+{
+    u32 depth = 0;
+    char *frame, *save = NULL;
+    struct flame_node_s *node = &tree->root;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    node->value += count;
+    for (frame = strtok_r(stack, ";", &save); frame != NULL; frame = strtok_r(NULL, ";", &save)) {
+        // Stack strings use "; " as separator.
+        while (*frame == ' ') {
+            frame++;
+        }
+        if (*frame == 0) {
+            continue;
+        }
+        if (depth >= FLAME_MAX_DEPTH) {
+            break;
+        }
+
+        node = __get_flame_child(node, frame, strlen(frame));
+        if (!node) {
+            return -1;
+        }
+        node->value += count;
+        depth++;
+    }
+
+    if (depth > tree->max_depth) {
+        tree->max_depth = depth;
+    }
+    return 0;
+}
+
+int flame_tree_load_folded(struct flame_tree_s *tree, const char *folded_file)
+{
+    FILE *fp;
+    char *line = NULL, *count_str, *end;
+    size_t cap = 0;
+    ssize_t len;
+    u64 count;
+    int ret = 0;
+
+    fp = fopen(folded_file, "r");
+    if (!fp) {
+        ERROR("[FLAMESVG]: Open %s failed.\n", folded_file);
+        return -1;
+    }
+
+    while ((len = getline(&line, &cap, fp)) > 0) {
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r' || line[len - 1] == ' ')) {
+            line[--len] = 0;
+        }
+
+        // "<folded stack> <count>"
+        count_str = strrchr(line, ' ');
+        if (!count_str || count_str == line) {
+            continue;
+        }
+        *count_str++ = 0;
+        count = strtoull(count_str, &end, 10);
+        if (end == count_str || *end != 0) {
+            continue;
+        }
+
+        if (flame_tree_add_stack(tree, line, count)) {
+            ret = -1;
+            break;
+        }
+    }
+
+    if (line) {
+        (void)free(line);
+    }
+    (void)fclose(fp);
+    return ret;
+}
+
+static u64 __hash_name(const char *name)
+{
+    u64 hash = 0xcbf29ce484222325ULL;
+
+    while (*name) {
+        hash ^= (unsigned char)*name++;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// Colors are derived from the frame name, so the same function keeps its color between graphs.
+static void __get_frame_color(enum flame_svg_color_e colors, const char *name, int *r, int *g, int *b)
+{
+    u64 hash = __hash_name(name);
+    double v1 = (double)(hash & 0xffff) / 0xffff;
+    double v2 = (double)((hash >> 16) & 0xffff) / 0xffff;
+    double v3 = (double)((hash >> 32) & 0xffff) / 0xffff;
+
+    switch (colors) {
+        case FLAME_SVG_COLOR_IO:
+            *r = 80 + (int)(60 * v1);
+            *g = *r;
+            *b = 190 + (int)(55 * v2);
+            break;
+        case FLAME_SVG_COLOR_MEM:
+            *r = 0;
+            *g = 190 + (int)(50 * v2);
+            *b = (int)(210 * v1);
+            break;
+        case FLAME_SVG_COLOR_HOT:
+        default:
+            *r = 205 + (int)(50 * v3);
+            *g = (int)(230 * v1);
+            *b = (int)(55 * v2);
+            break;
+    }
+}
+
+static void __wr_escaped(FILE *fp, const char *s, size_t len)
+{
+    for (size_t i = 0; i < len && s[i] != 0; i++) {
+        switch (s[i]) {
+            case '&':
+                (void)fputs("&amp;", fp);
+                break;
+            case '<':
+                (void)fputs("&lt;", fp);
+                break;
+            case '>':
+                (void)fputs("&gt;", fp);
+                break;
+            case '"':
+                (void)fputs("&quot;", fp);
+                break;
+            default:
+                (void)fputc(s[i], fp);
+                break;
+        }
+    }
+}
+
+static void __wr_svg_header(struct flame_svg_ctx_s *ctx)
+{
+    FILE *fp = ctx->fp;
+    const char *bg1 = "#eeeeee", *bg2 = "#eeeeb0";
+
+    if (ctx->opts->colors != FLAME_SVG_COLOR_HOT) {
+        bg1 = "#f8f8f8";
+        bg2 = "#e8e8e8";
+    }
+
+    (void)fprintf(fp, "<?xml version=\"1.0\" standalone=\"no\"?>\n"
+        "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" \"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n"
+        "<svg version=\"1.1\" width=\"%d\" height=\"%u\" viewBox=\"0 0 %d %u\" "
+        "xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\">\n",
+        FLAME_IMAGE_WIDTH, ctx->image_height, FLAME_IMAGE_WIDTH, ctx->image_height);
+    (void)fprintf(fp, "<defs>\n"
+        "\t<linearGradient id=\"background\" y1=\"0\" y2=\"1\" x1=\"0\" x2=\"0\">\n"
+        "\t\t<stop stop-color=\"%s\" offset=\"5%%\"/>\n"
+        "\t\t<stop stop-color=\"%s\" offset=\"95%%\"/>\n"
+        "\t</linearGradient>\n"
+        "</defs>\n", bg1, bg2);
+    (void)fprintf(fp, "<style type=\"text/css\">\n"
+        "\ttext { font-family:Verdana; font-size:%dpx; fill:rgb(0,0,0); }\n"
+        "\tg:hover { stroke:black; stroke-width:0.5; cursor:pointer; }\n"
+        "</style>\n", FLAME_FONT_SIZE);
+    (void)fprintf(fp, "<rect x=\"0\" y=\"0\" width=\"%d\" height=\"%u\" fill=\"url(#background)\"/>\n",
+        FLAME_IMAGE_WIDTH, ctx->image_height);
+    (void)fprintf(fp, "<text x=\"%d\" y=\"%d\" text-anchor=\"middle\" style=\"font-size:17px\">",
+        FLAME_IMAGE_WIDTH / 2, FLAME_FONT_SIZE * 2);
+    __wr_escaped(fp, ctx->opts->title ? : "Flame Graph", (size_t)-1);
+    (void)fputs("</text>\n", fp);
+}
+
+static void __wr_svg_frame(struct flame_svg_ctx_s *ctx, const struct flame_node_s *node, u32 depth, u64 offset)
+{
+    FILE *fp = ctx->fp;
+    int r, g, b;
+    double x1 = FLAME_XPAD + offset * ctx->width_per_count;
+    double width = node->value * ctx->width_per_count;
+    u32 y1 = ctx->image_height - FLAME_YPAD2 - (depth + 1) * FLAME_FRAME_HEIGHT;
+    size_t name_len = strlen(node->name);
+    size_t fit_chars = (size_t)((width - 3) / (FLAME_FONT_SIZE * FLAME_FONT_WIDTH));
+
+    if (depth == 0) {
+        r = 250;
+        g = 250;
+        b = 250;
+    } else {
+        __get_frame_color(ctx->opts->colors, node->name, &r, &g, &b);
+    }
+
+    (void)fputs("<g>\n<title>", fp);
+    __wr_escaped(fp, node->name, name_len);
+    (void)fprintf(fp, " (%llu %s, %.2f%%)</title>\n", node->value, ctx->opts->count_name ? : "samples",
+        100.0 * node->value / ctx->total);
+    (void)fprintf(fp, "<rect x=\"%.1f\" y=\"%u\" width=\"%.1f\" height=\"%d\" fill=\"rgb(%d,%d,%d)\" rx=\"2\" ry=\"2\"/>\n",
+        x1, y1, width, FLAME_FRAME_HEIGHT - 1, r, g, b);
+
+    // Labels are truncated to the frame width, too narrow frames get no label.
+    (void)fprintf(fp, "<text x=\"%.2f\" y=\"%.1f\">", x1 + 3, y1 + 10.5);
+    if (fit_chars >= 3) {
+        if (name_len <= fit_chars) {
+            __wr_escaped(fp, node->name, name_len);
+        } else {
+            __wr_escaped(fp, node->name, fit_chars - 2);
+            (void)fputs("..", fp);
+        }
+    }
+    (void)fputs("</text>\n</g>\n", fp);
+}
+
+static int __name_cmp(struct flame_node_s *a, struct flame_node_s *b)
+{
+    return strcmp(a->name, b->name);
+}
+
+static void __wr_svg_frames(struct flame_svg_ctx_s *ctx, struct flame_node_s *node, u32 depth, u64 offset)
+{
+    struct flame_node_s *child, *tmp;
+
+    if (node->value * ctx->width_per_count < FLAME_MIN_WIDTH) {
+        return;
+    }
+
+    __wr_svg_frame(ctx, node, depth, offset);
+
+    // Siblings are laid out in alphabetical order, as flamegraph.pl does.
+    H_SORT(node->children, __name_cmp);
+    H_ITER(node->children, child, tmp) {
+        __wr_svg_frames(ctx, child, depth + 1, offset);
+        offset += child->value;
+    }
+}
+
+int flame_tree_wr_svg(struct flame_tree_s *tree, FILE *fp, const struct flame_svg_opts_s *opts)
+{
+    struct flame_svg_ctx_s ctx = {0};
+
+    if (tree->root.value == 0) {
+        return -1;
+    }
+
+    ctx.fp = fp;
+    ctx.opts = opts;
+    ctx.total = tree->root.value;
+    ctx.width_per_count = (double)(FLAME_IMAGE_WIDTH - 2 * FLAME_XPAD) / ctx.total;
+    ctx.image_height = (tree->max_depth + 1) * FLAME_FRAME_HEIGHT + FLAME_YPAD1 + FLAME_YPAD2;
+
+    __wr_svg_header(&ctx);
+    __wr_svg_frames(&ctx, &tree->root, 0, 0);
+    (void)fputs("</svg>\n", fp);
+    return ferror(fp) ? -1 : 0;
+}
+
+int render_flame_svg(const char *folded_file, const char *svg_file, const struct flame_svg_opts_s *opts)
+{
+    int ret;
+    FILE *fp;
+    struct flame_tree_s tree;
+
+    init_flame_tree(&tree);
+    ret = flame_tree_load_folded(&tree, folded_file);
+    if (ret != 0) {
+        goto out;
+    }
+
+    if (tree.root.value == 0) {
+        INFO("[FLAMESVG]: No stack counts found in %s.\n", folded_file);
+        ret = -1;
+        goto out;
+    }
+
+    fp = fopen(svg_file, "w");
+    if (!fp) {
+        ERROR("[FLAMESVG]: Create %s failed.\n", svg_file);
+        ret = -1;
+        goto out;
+    }
+    ret = flame_tree_wr_svg(&tree, fp, opts);
+    if (fclose(fp) != 0) {
+        ret = -1;
+    }
+
+out:
+    destroy_flame_tree(&tree);
+    return ret;
+}
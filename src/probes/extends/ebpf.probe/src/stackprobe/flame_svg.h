@@ -0,0 +1,71 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-08-10
+ * Description: native flame graph svg renderer
+ ******************************************************************************/
+#ifndef __GOPHER_FLAME_SVG_H__
+#define __GOPHER_FLAME_SVG_H__
+
+#pragma once
+
+#include "common.h"
+#include "hash.h"
+
+enum flame_svg_color_e {
+    FLAME_SVG_COLOR_HOT = 0,
+    FLAME_SVG_COLOR_IO,
+    FLAME_SVG_COLOR_MEM
+};
+
+struct flame_svg_opts_s {
+    const char *title;
+    const char *count_name;     // unit of sample counts, eg. us, Bytes
+    enum flame_svg_color_e colors;
+};
+
+/*
+ * Call tree merged from folded stacks, value of a node includes its children.
+ */
+struct flame_node_s {
+    H_HANDLE;
+    char *name;                 // key
+    u64 value;
+    struct flame_node_s *children;
+};
+
+struct flame_tree_s {
+    struct flame_node_s root;
+    u32 max_depth;
+};
+
+void init_flame_tree(struct flame_tree_s *tree);
+void destroy_flame_tree(struct flame_tree_s *tree);
+
+/*
+ * Merge one folded stack "frame1;frame2;...;frameN" with its count into the tree.
+ * The stack string is modified while splitting.
+ */
+int flame_tree_add_stack(struct flame_tree_s *tree, char *stack, u64 count);
+
+/*
+ * Merge all lines "<folded stack> <count>" of a folded stack file into the tree.
+ */
+int flame_tree_load_folded(struct flame_tree_s *tree, const char *folded_file);
+
+int flame_tree_wr_svg(struct flame_tree_s *tree, FILE *fp, const struct flame_svg_opts_s *opts);
+
+/*
+ * folded stack file -> svg file, replaces flamegraph.pl.
+ */
+int render_flame_svg(const char *folded_file, const char *svg_file, const struct flame_svg_opts_s *opts);
+
+#endif
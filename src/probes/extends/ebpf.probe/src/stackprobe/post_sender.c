@@ -0,0 +1,185 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-08-14
+ * Description: asynchronous profile uploader
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <curl/curl.h>
+
+#include "post_sender.h"
+
+static void __free_post_req(struct post_req_s *req)
+{
+    if (!req) {
+        return;
+    }
+    if (req->body) {
+        (void)free(req->body);
+    }
+    (void)free(req);
+}
+
+// The response body is not needed.
+static size_t __discard_resp_cb(void *contents, size_t size, size_t nmemb, void *userp)
+{
+    (void)contents;
+    (void)userp;
+    return size * nmemb;
+}
+
+static int __do_post(struct post_sender_s *sender, CURL *curl, struct curl_slist *headers, struct post_req_s *req)
+{
+    CURLcode res;
+
+    curl_easy_setopt(curl, CURLOPT_URL, req->url);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, sender->timeout);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, __discard_resp_cb);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, (char *)req->body);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)req->body_len);
+
+    res = curl_easy_perform(curl);
+    if (res != CURLE_OK) {
+        ERROR("[POST_SENDER]: post to %s failed: %s\n", req->url, curl_easy_strerror(res));
+        return -1;
+    }
+    DEBUG("[POST_SENDER]: post %zu bytes to %s success\n", req->body_len, req->url);
+    return 0;
+}
+
+static void *__post_sender_thread(void *arg)
+{
+    CURL *curl;
+    struct curl_slist *headers = NULL;
+    struct post_req_s *req;
+    struct post_sender_s *sender = (struct post_sender_s *)arg;
+
+    // One handle for the thread's lifetime keeps the connection to the server alive.
+    curl = curl_easy_init();
+    headers = curl_slist_append(headers, "Content-Type: binary/octet-stream");
+
+    while (1) {
+        (void)pthread_mutex_lock(&sender->mutex);
+        while (!sender->stop && sender->count == 0) {
+            (void)pthread_cond_wait(&sender->cond, &sender->mutex);
+        }
+        if (sender->stop) {
+            (void)pthread_mutex_unlock(&sender->mutex);
+            break;
+        }
+        req = sender->reqs[sender->head];
+        sender->reqs[sender->head] = NULL;
+        sender->head = (sender->head + 1) % POST_QUEUE_LEN;
+        sender->count--;
+        (void)pthread_mutex_unlock(&sender->mutex);
+
+        if (curl == NULL || __do_post(sender, curl, headers, req)) {
+            __sync_fetch_and_add(&sender->failed, 1);
+        } else {
+            __sync_fetch_and_add(&sender->sent, 1);
+        }
+        __free_post_req(req);
+    }
+
+    if (headers) {
+        curl_slist_free_all(headers);
+    }
+    if (curl) {
+        curl_easy_cleanup(curl);
+    }
+    return NULL;
+}
+
+struct post_sender_s *create_post_sender(long timeout)
+{
+    struct post_sender_s *sender = (struct post_sender_s *)calloc(1, sizeof(struct post_sender_s));
+    if (!sender) {
+        return NULL;
+    }
+
+    sender->timeout = timeout;
+    (void)pthread_mutex_init(&sender->mutex, NULL);
+    (void)pthread_cond_init(&sender->cond, NULL);
+    if (pthread_create(&sender->tid, NULL, __post_sender_thread, sender) != 0) {
+        ERROR("[POST_SENDER]: Failed to create sender thread.\n");
+        (void)pthread_mutex_destroy(&sender->mutex);
+        (void)pthread_cond_destroy(&sender->cond);
+        (void)free(sender);
+        return NULL;
+    }
+    return sender;
+}
+
+void destroy_post_sender(struct post_sender_s *sender)
+{
+    u32 idx;
+
+    if (!sender) {
+        return;
+    }
+
+    (void)pthread_mutex_lock(&sender->mutex);
+    sender->stop = 1;
+    (void)pthread_cond_signal(&sender->cond);
+    (void)pthread_mutex_unlock(&sender->mutex);
+    (void)pthread_join(sender->tid, NULL);
+
+    // Requests still queued are dropped.
+    for (u32 i = 0; i < sender->count; i++) {
+        idx = (sender->head + i) % POST_QUEUE_LEN;
+        __free_post_req(sender->reqs[idx]);
+        sender->reqs[idx] = NULL;
+    }
+    INFO("[POST_SENDER]: sent %llu, failed %llu, dropped %llu.\n", sender->sent, sender->failed, sender->dropped);
+
+    (void)pthread_mutex_destroy(&sender->mutex);
+    (void)pthread_cond_destroy(&sender->cond);
+    (void)free(sender);
+}
+
+int post_sender_enqueue(struct post_sender_s *sender, const char *url, unsigned char *body, size_t body_len)
+{
+    u32 tail;
+    struct post_req_s *req, *dropped = NULL;
+
+    req = (struct post_req_s *)calloc(1, sizeof(struct post_req_s));
+    if (!req) {
+        (void)free(body);
+        return -1;
+    }
+    (void)snprintf(req->url, sizeof(req->url), "%s", url);
+    req->body = body;
+    req->body_len = body_len;
+
+    (void)pthread_mutex_lock(&sender->mutex);
+    if (sender->count >= POST_QUEUE_LEN) {
+        dropped = sender->reqs[sender->head];
+        sender->reqs[sender->head] = NULL;
+        sender->head = (sender->head + 1) % POST_QUEUE_LEN;
+        sender->count--;
+        sender->dropped++;
+    }
+    tail = (sender->head + sender->count) % POST_QUEUE_LEN;
+    sender->reqs[tail] = req;
+    sender->count++;
+    (void)pthread_cond_signal(&sender->cond);
+    (void)pthread_mutex_unlock(&sender->mutex);
+
+    if (dropped) {
+        WARN("[POST_SENDER]: Queue full, drop the oldest profile(%s).\n", dropped->url);
+        __free_post_req(dropped);
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-08-14
+ * Description: asynchronous profile uploader
+ ******************************************************************************/
+#ifndef __GOPHER_POST_SENDER_H__
+#define __GOPHER_POST_SENDER_H__
+
+#pragma once
+
+#include <pthread.h>
+#include "common.h"
+
+#define POST_QUEUE_LEN      16
+
+struct post_req_s {
+    char url[LINE_BUF_LEN];
+    unsigned char *body;    // owned by the request
+    size_t body_len;
+};
+
+/*
+ * Bounded queue drained by a dedicated thread, so a slow server never stalls sample draining.
+ * When the queue is full the oldest request is dropped.
+ */
+struct post_sender_s {
+    pthread_t tid;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    char stop;
+    long timeout;           // sec
+    u32 head;
+    u32 count;
+    struct post_req_s *reqs[POST_QUEUE_LEN];
+
+    u64 sent;
+    u64 failed;
+    u64 dropped;
+};
+
+struct post_sender_s *create_post_sender(long timeout);
+void destroy_post_sender(struct post_sender_s *sender);
+
+/*
+ * Queue a post request, ownership of body is always taken over.
+ */
+int post_sender_enqueue(struct post_sender_s *sender, const char *url, unsigned char *body, size_t body_len);
+
+#endif
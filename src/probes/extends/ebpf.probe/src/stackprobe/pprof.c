@@ -0,0 +1,454 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-08-14
+ * Description: pprof profile encoder
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "pprof.h"
+
+#define PB_WIRE_VARINT      0
+#define PB_WIRE_LEN         2
+
+// perftools.profiles.Profile field numbers
+#define PROFILE_SAMPLE_TYPE     1
+#define PROFILE_SAMPLE          2
+#define PROFILE_LOCATION        4
+#define PROFILE_FUNCTION        5
+#define PROFILE_STRING_TABLE    6
+#define PROFILE_TIME_NANOS      9
+#define PROFILE_DURATION_NANOS  10
+#define PROFILE_PERIOD_TYPE     11
+#define PROFILE_PERIOD          12
+
+#define VALUE_TYPE_TYPE         1
+#define VALUE_TYPE_UNIT         2
+
+#define SAMPLE_LOCATION_ID      1
+#define SAMPLE_VALUE            2
+
+#define LOCATION_ID             1
+#define LOCATION_LINE           4
+
+#define LINE_FUNCTION_ID        1
+
+#define FUNCTION_ID             1
+#define FUNCTION_NAME           2
+#define FUNCTION_SYSTEM_NAME    3
+
+#define PB_BUF_STEP             4096
+#define PPROF_STEP_COUNT        1024
+#define PPROF_MAX_FRAMES        1024
+#define PPROF_FRAME_SEP         ';'
+
+#if 1
+
+void pb_buf_free(struct pb_buf_s *buf)
+{
+    if (buf->data) {
+        (void)free(buf->data);
+    }
+    (void)memset(buf, 0, sizeof(struct pb_buf_s));
+}
+
+static int pb_reserve(struct pb_buf_s *buf, size_t size)
+{
+    size_t new_cap;
+    unsigned char *new_data;
+
+    if (buf->len + size <= buf->cap) {
+        return 0;
+    }
+
+    new_cap = buf->cap ? buf->cap : PB_BUF_STEP;
+    while (new_cap < buf->len + size) {
+        new_cap *= 2;
+    }
+    new_data = (unsigned char *)realloc(buf->data, new_cap);
+    if (!new_data) {
+        return -1;
+    }
+    buf->data = new_data;
+    buf->cap = new_cap;
+    return 0;
+}
+
+static int pb_put_varint(struct pb_buf_s *buf, u64 v)
+{
+    if (pb_reserve(buf, 10)) {
+        return -1;
+    }
+    while (v >= 0x80) {
+        buf->data[buf->len++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    buf->data[buf->len++] = (unsigned char)v;
+    return 0;
+}
+
+static size_t pb_varint_size(u64 v)
+{
+    size_t size = 1;
+
+    while (v >= 0x80) {
+        size++;
+        v >>= 7;
+    }
+    return size;
+}
+
+static int pb_put_tag(struct pb_buf_s *buf, u32 field, u32 wire_type)
+{
+    return pb_put_varint(buf, ((u64)field << 3) | wire_type);
+}
+
+// proto3 scalars equal to 0 are the default value and are not written.
+static int pb_put_uint64(struct pb_buf_s *buf, u32 field, u64 v)
+{
+    if (v == 0) {
+        return 0;
+    }
+    if (pb_put_tag(buf, field, PB_WIRE_VARINT)) {
+        return -1;
+    }
+    return pb_put_varint(buf, v);
+}
+
+static int pb_put_bytes(struct pb_buf_s *buf, u32 field, const void *data, size_t len)
+{
+    if (pb_put_tag(buf, field, PB_WIRE_LEN) || pb_put_varint(buf, (u64)len) || pb_reserve(buf, len)) {
+        return -1;
+    }
+    if (len > 0) {
+        (void)memcpy(buf->data + buf->len, data, len);
+        buf->len += len;
+    }
+    return 0;
+}
+
+// Embedded message, encoded into scratch first since its length prefixes it.
+static int pb_put_msg(struct pb_buf_s *buf, u32 field, const struct pb_buf_s *msg)
+{
+    return pb_put_bytes(buf, field, msg->data, msg->len);
+}
+
+static int pb_put_value_type(struct pb_buf_s *buf, struct pb_buf_s *scratch, u32 field, s64 type, s64 unit)
+{
+    scratch->len = 0;
+    if (pb_put_uint64(scratch, VALUE_TYPE_TYPE, (u64)type) || pb_put_uint64(scratch, VALUE_TYPE_UNIT, (u64)unit)) {
+        return -1;
+    }
+    return pb_put_msg(buf, field, scratch);
+}
+
+#endif
+
+#if 1
+
+static s64 __get_str_idx(struct pprof_builder_s *builder, const char *str, size_t len)
+{
+    u32 new_capa;
+    char **new_strs;
+    struct pprof_str_s *item = NULL;
+
+    H_FIND(builder->str_tbl, str, len, item);
+    if (item) {
+        return item->idx;
+    }
+
+    if (builder->str_count >= builder->str_capability) {
+        new_capa = builder->str_capability + PPROF_STEP_COUNT;
+        new_strs = (char **)realloc(builder->strs, new_capa * sizeof(char *));
+        if (!new_strs) {
+            return -1;
+        }
+        builder->strs = new_strs;
+        builder->str_capability = new_capa;
+    }
+
+    item = (struct pprof_str_s *)calloc(1, sizeof(struct pprof_str_s));
+    if (!item) {
+        return -1;
+    }
+    item->str = strndup(str, len);
+    if (!item->str) {
+        (void)free(item);
+        return -1;
+    }
+    item->idx = builder->str_count;
+    builder->strs[builder->str_count++] = item->str;
+    H_ADD_KEYPTR(builder->str_tbl, item->str, len, item);
+    return item->idx;
+}
+
+static u64 __get_func_id(struct pprof_builder_s *builder, s64 name_idx)
+{
+    u64 new_capa;
+    s64 *new_names;
+    struct pprof_func_s *item = NULL;
+
+    H_FIND(builder->func_tbl, &name_idx, sizeof(s64), item);
+    if (item) {
+        return item->id;
+    }
+
+    if (builder->func_count >= builder->func_capability) {
+        new_capa = builder->func_capability + PPROF_STEP_COUNT;
+        new_names = (s64 *)realloc(builder->func_names, new_capa * sizeof(s64));
+        if (!new_names) {
+            return 0;
+        }
+        builder->func_names = new_names;
+        builder->func_capability = new_capa;
+    }
+
+    item = (struct pprof_func_s *)calloc(1, sizeof(struct pprof_func_s));
+    if (!item) {
+        return 0;
+    }
+    item->name_idx = name_idx;
+    builder->func_names[builder->func_count++] = name_idx;
+    item->id = builder->func_count;     // ids start at 1, 0 is reserved
+    H_ADD(builder->func_tbl, name_idx, sizeof(s64), item);
+    return item->id;
+}
+
+struct pprof_builder_s *create_pprof_builder(const char *sample_type, const char *sample_unit, s64 period)
+{
+    struct pprof_builder_s *builder = (struct pprof_builder_s *)calloc(1, sizeof(struct pprof_builder_s));
+    if (!builder) {
+        return NULL;
+    }
+
+    builder->loc_ids = (u64 *)malloc(PPROF_MAX_FRAMES * sizeof(u64));
+    if (!builder->loc_ids) {
+        goto err;
+    }
+    builder->loc_capability = PPROF_MAX_FRAMES;
+
+    // string_table[0] must be "".
+    if (__get_str_idx(builder, "", 0) != 0) {
+        goto err;
+    }
+    builder->sample_type = __get_str_idx(builder, sample_type, strlen(sample_type));
+    builder->sample_unit = __get_str_idx(builder, sample_unit, strlen(sample_unit));
+    builder->period_type = builder->sample_type;
+    builder->period_unit = builder->sample_unit;
+    builder->period = period;
+    if (builder->sample_type < 0 || builder->sample_unit < 0) {
+        goto err;
+    }
+    return builder;
+
+err:
+    destroy_pprof_builder(builder);
+    return NULL;
+}
+
+void destroy_pprof_builder(struct pprof_builder_s *builder)
+{
+    struct pprof_str_s *str, *tmp_str;
+    struct pprof_func_s *func, *tmp_func;
+
+    if (!builder) {
+        return;
+    }
+
+    H_ITER(builder->str_tbl, str, tmp_str) {
+        H_DEL(builder->str_tbl, str);
+        (void)free(str->str);
+        (void)free(str);
+    }
+    H_ITER(builder->func_tbl, func, tmp_func) {
+        H_DEL(builder->func_tbl, func);
+        (void)free(func);
+    }
+
+    if (builder->strs) {
+        (void)free(builder->strs);
+    }
+    if (builder->func_names) {
+        (void)free(builder->func_names);
+    }
+    if (builder->loc_ids) {
+        (void)free(builder->loc_ids);
+    }
+    pb_buf_free(&builder->samples);
+    pb_buf_free(&builder->scratch);
+    (void)free(builder);
+}
+
+int pprof_add_sample(struct pprof_builder_s *builder, const char *folded_stack, s64 value)
+{
+    u32 frames = 0;
+    const char *frame = folded_stack, *sep;
+    size_t len;
+    s64 name_idx;
+    u64 func_id;
+    struct pb_buf_s *scratch = &builder->scratch;
+
+    if (value <= 0 || folded_stack == NULL) {
+        return 0;
+    }
+
+    // Frames come root first, pprof wants the leaf first; fill loc_ids from the tail.
+    while (*frame != 0 && frames < builder->loc_capability) {
+        while (*frame == ' ') {
+            frame++;
+        }
+        sep = strchr(frame, PPROF_FRAME_SEP);
+        len = sep ? (size_t)(sep - frame) : strlen(frame);
+        if (len > 0) {
+            name_idx = __get_str_idx(builder, frame, len);
+            if (name_idx < 0) {
+                return -1;
+            }
+            func_id = __get_func_id(builder, name_idx);
+            if (func_id == 0) {
+                return -1;
+            }
+            builder->loc_ids[builder->loc_capability - 1 - frames] = func_id;
+            frames++;
+        }
+        if (!sep) {
+            break;
+        }
+        frame = sep + 1;
+    }
+    if (frames == 0) {
+        return 0;
+    }
+
+    // Sample { repeated uint64 location_id = 1 [packed]; repeated int64 value = 2 [packed]; }
+    scratch->len = 0;
+    if (pb_put_tag(scratch, SAMPLE_LOCATION_ID, PB_WIRE_LEN)) {
+        return -1;
+    }
+    len = 0;
+    for (u32 i = builder->loc_capability - frames; i < builder->loc_capability; i++) {
+        len += pb_varint_size(builder->loc_ids[i]);
+    }
+    if (pb_put_varint(scratch, (u64)len)) {
+        return -1;
+    }
+    for (u32 i = builder->loc_capability - frames; i < builder->loc_capability; i++) {
+        if (pb_put_varint(scratch, builder->loc_ids[i])) {
+            return -1;
+        }
+    }
+    if (pb_put_tag(scratch, SAMPLE_VALUE, PB_WIRE_LEN)
+        || pb_put_varint(scratch, (u64)pb_varint_size((u64)value))
+        || pb_put_varint(scratch, (u64)value)) {
+        return -1;
+    }
+
+    if (pb_put_msg(&builder->samples, PROFILE_SAMPLE, scratch)) {
+        return -1;
+    }
+    builder->sample_count++;
+    return 0;
+}
+
+u32 pprof_sample_count(struct pprof_builder_s *builder)
+{
+    return builder ? builder->sample_count : 0;
+}
+
+int pprof_encode(struct pprof_builder_s *builder, u64 time_nanos, u64 duration_nanos, struct pb_buf_s *out)
+{
+    struct pb_buf_s *scratch = &builder->scratch;
+    struct pb_buf_s line = {0};
+    int ret = -1;
+
+    if (pb_put_value_type(out, scratch, PROFILE_SAMPLE_TYPE, builder->sample_type, builder->sample_unit)) {
+        goto end;
+    }
+
+    if (pb_reserve(out, builder->samples.len)) {
+        goto end;
+    }
+    (void)memcpy(out->data + out->len, builder->samples.data, builder->samples.len);
+    out->len += builder->samples.len;
+
+    // One location per function, with the same id.
+    for (u64 id = 1; id <= builder->func_count; id++) {
+        line.len = 0;
+        scratch->len = 0;
+        if (pb_put_uint64(&line, LINE_FUNCTION_ID, id)
+            || pb_put_uint64(scratch, LOCATION_ID, id)
+            || pb_put_msg(scratch, LOCATION_LINE, &line)
+            || pb_put_msg(out, PROFILE_LOCATION, scratch)) {
+            goto end;
+        }
+    }
+
+    for (u64 id = 1; id <= builder->func_count; id++) {
+        s64 name_idx = builder->func_names[id - 1];
+        scratch->len = 0;
+        if (pb_put_uint64(scratch, FUNCTION_ID, id)
+            || pb_put_uint64(scratch, FUNCTION_NAME, (u64)name_idx)
+            || pb_put_uint64(scratch, FUNCTION_SYSTEM_NAME, (u64)name_idx)
+            || pb_put_msg(out, PROFILE_FUNCTION, scratch)) {
+            goto end;
+        }
+    }
+
+    for (u32 i = 0; i < builder->str_count; i++) {
+        if (pb_put_bytes(out, PROFILE_STRING_TABLE, builder->strs[i], strlen(builder->strs[i]))) {
+            goto end;
+        }
+    }
+
+    if (pb_put_uint64(out, PROFILE_TIME_NANOS, time_nanos)
+        || pb_put_uint64(out, PROFILE_DURATION_NANOS, duration_nanos)
+        || pb_put_value_type(out, scratch, PROFILE_PERIOD_TYPE, builder->period_type, builder->period_unit)
+        || pb_put_uint64(out, PROFILE_PERIOD, (u64)builder->period)) {
+        goto end;
+    }
+    ret = 0;
+
+end:
+    pb_buf_free(&line);
+    return ret;
+}
+
+int pprof_gzip(const struct pb_buf_s *in, struct pb_buf_s *out)
+{
+    int ret;
+    z_stream zs;
+
+    (void)memset(&zs, 0, sizeof(zs));
+    // windowBits + 16 writes a gzip header and trailer.
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return -1;
+    }
+
+    out->len = 0;
+    if (pb_reserve(out, deflateBound(&zs, in->len) + 32)) {
+        (void)deflateEnd(&zs);
+        return -1;
+    }
+
+    zs.next_in = in->data;
+    zs.avail_in = (uInt)in->len;
+    zs.next_out = out->data;
+    zs.avail_out = (uInt)out->cap;
+    ret = deflate(&zs, Z_FINISH);
+    out->len = zs.total_out;
+    (void)deflateEnd(&zs);
+    return (ret == Z_STREAM_END) ? 0 : -1;
+}
+
+#endif
@@ -0,0 +1,88 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-08-14
+ * Description: pprof profile encoder
+ ******************************************************************************/
+#ifndef __GOPHER_PPROF_H__
+#define __GOPHER_PPROF_H__
+
+#pragma once
+
+#include "common.h"
+#include "hash.h"
+
+struct pb_buf_s {
+    unsigned char *data;
+    size_t len;
+    size_t cap;
+};
+
+void pb_buf_free(struct pb_buf_s *buf);
+
+struct pprof_str_s {
+    H_HANDLE;
+    char *str;          // key
+    s64 idx;
+};
+
+struct pprof_func_s {
+    H_HANDLE;
+    s64 name_idx;       // key
+    u64 id;
+};
+
+/*
+ * Builds a perftools.profiles.Profile (https://github.com/google/pprof/blob/main/proto/profile.proto).
+ * Stack samples only carry symbol names, so every distinct frame name becomes one function and one
+ * location with the same id; strings, functions and locations are deduplicated.
+ */
+struct pprof_builder_s {
+    struct pprof_str_s *str_tbl;
+    char **strs;            // string table in index order, strs[0] is ""
+    u32 str_count;
+    u32 str_capability;
+
+    struct pprof_func_s *func_tbl;
+    s64 *func_names;        // func_names[id - 1] is the name index of function id
+    u64 func_count;
+    u64 func_capability;
+
+    s64 sample_type;
+    s64 sample_unit;
+    s64 period_type;
+    s64 period_unit;
+    s64 period;
+
+    u64 *loc_ids;           // scratch for one sample, leaf first
+    u32 loc_capability;
+    u32 sample_count;
+    struct pb_buf_s samples;    // encoded Sample messages
+    struct pb_buf_s scratch;
+};
+
+struct pprof_builder_s *create_pprof_builder(const char *sample_type, const char *sample_unit, s64 period);
+void destroy_pprof_builder(struct pprof_builder_s *builder);
+
+/*
+ * Add one folded stack "root; ...; leaf" with its value, the stack string is not modified.
+ */
+int pprof_add_sample(struct pprof_builder_s *builder, const char *folded_stack, s64 value);
+u32 pprof_sample_count(struct pprof_builder_s *builder);
+
+/*
+ * Serialize the profile, then gzip it as pprof files usually are.
+ * The caller owns out and releases it with pb_buf_free().
+ */
+int pprof_encode(struct pprof_builder_s *builder, u64 time_nanos, u64 duration_nanos, struct pb_buf_s *out);
+int pprof_gzip(const struct pb_buf_s *in, struct pb_buf_s *out);
+
+#endif
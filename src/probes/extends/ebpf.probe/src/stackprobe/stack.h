@@ -21,14 +21,25 @@
 
 #define AGGRE_PERIOD    (1 * 30 * 1000) // 30s
 #define TMOUT_PERIOD    (AGGRE_PERIOD / 1000) // Second as unit
-#define PROC_CACHE_MAX_COUNT    100    // Cache 100 proc symbols
+#define PROC_CACHE_MAX_COUNT    1000   // Cache 1000 proc symbols, elf symbol tables are shared among them
 #define DIV_ROUND_UP(NUM, DEN) ((NUM + DEN - 1) / DEN)
 
 #define MAX_PERCPU_SAMPLE_COUNT     (2 * DIV_ROUND_UP(AGGRE_PERIOD, 10)) // samplePeriod as 10ms
 
+// Distinct stack_id_s aggregated in kernel per data channel, excess samples fall back to perf event output.
+#define MAX_STACK_COUNT_ENTRIES     4096
+
+// Sampled memleak(memleak_glibc.bpf.c): live allocation samples and their distinct stacks.
+#define MAX_MEM_ALLOC_ENTRIES       65536
+#define MAX_MEM_STACK_ENTRIES       8192
+
 struct convert_data_t {
     u32 whitelist_enable;
+    u32 stack_count_enable;     // aggregate samples into stack_count_a/b instead of per-sample perf output
     u64 convert_counter;
+    u64 mem_sample_bytes;       // mean bytes between two sampled allocations, 0 tracks every allocation
+    u32 dwarf_unwind_enable;    // oncpu outputs user regs and stack, unwound with .eh_frame in user mode
+    u32 pad;
 };
 
 struct stack_pid_s {
@@ -48,4 +59,23 @@ struct raw_trace_s {
     struct stack_id_s stack_id;
 };
 
+// Bytes of user stack copied for dwarf unwinding, deeper frames are lost.
+#define USER_STACK_COPY_SIZE    8192
+
+struct user_regs_s {
+    u64 ip;
+    u64 sp;
+    u64 fp;
+    u64 lr;                     // aarch64 only
+};
+
+// oncpu sample with dwarf_unwind_enable, user_stack_id is assigned in user mode after unwinding.
+struct user_stack_sample_s {
+    struct raw_trace_s raw_trace;
+    struct user_regs_s regs;
+    u32 stack_len;
+    u32 pad;
+    char stack[USER_STACK_COPY_SIZE];
+};
+
 #endif
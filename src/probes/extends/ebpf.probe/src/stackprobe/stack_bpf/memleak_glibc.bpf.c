@@ -23,169 +23,239 @@
 
 char g_linsence[] SEC("license") = "GPL";
 
+/*
+  Sampled allocation tracking: an allocation is sampled each time about mem_sample_bytes bytes have been
+  allocated on the CPU, the distance to the next sample is exponentially distributed(Poisson process over
+  bytes, like tcmalloc), so the probability of being sampled grows with the allocation size.
+  Outstanding bytes of the sampled allocations are aggregated per stack in mem_live_bytes, user mode
+  snapshots it periodically and reports the growth of each stack between two snapshots.
+  Stacks are kept in mem_stackmap which is not switched with stackmap_a/b, because a live allocation may
+  span many periods.
+*/
+
 struct pid_addr_t {
     u32 tgid;
     u64 addr;
 };
 
-struct mmap_info_t {
-    s64 size;
-    u64 timestamp_ns;
+struct mem_alloc_t {
+    s64 weight;                 // bytes represented by the sample
     struct stack_id_s stack_id;
 };
 
+struct mem_sample_t {
+    s64 bytes_until_sample;
+};
+
+#define LN2_Q16     45426   // ln(2) << 16
+#define LOG2_C_Q16  22713   // 0.3466 << 16, corrects the linear approximation of log2(1 + f)
+
 struct {
-    __uint(type, BPF_MAP_TYPE_PERF_EVENT_ARRAY);
+    __uint(type, BPF_MAP_TYPE_STACK_TRACE);
     __uint(key_size, sizeof(u32));
-    __uint(value_size, sizeof(u32));
-    __uint(max_entries, MAX_CPU);
-} stackmap_perf_a SEC(".maps");
+    __uint(value_size, PERF_MAX_STACK_DEPTH * sizeof(u64));
+    __uint(max_entries, MAX_MEM_STACK_ENTRIES);
+} mem_stackmap SEC(".maps");
 
+// stack_id_s -> outstanding bytes, summed over CPUs by user mode
 struct {
-    __uint(type, BPF_MAP_TYPE_PERF_EVENT_ARRAY);
+    __uint(type, BPF_MAP_TYPE_PERCPU_HASH);
+    __uint(key_size, sizeof(struct stack_id_s));
+    __uint(value_size, sizeof(s64));
+    __uint(max_entries, MAX_MEM_STACK_ENTRIES);
+} mem_live_bytes SEC(".maps");
+
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
     __uint(key_size, sizeof(u32));
-    __uint(value_size, sizeof(u32));
-    __uint(max_entries, MAX_CPU);
-} stackmap_perf_b SEC(".maps");
+    __uint(value_size, sizeof(struct mem_sample_t));
+    __uint(max_entries, 1);
+} mem_sample_map SEC(".maps");
 
 // memory to be allocated for the process
 struct {
     __uint(type, BPF_MAP_TYPE_HASH);
     __uint(key_size, sizeof(u64));  // pid
-    __uint(value_size, sizeof(u64));  // size
+    __uint(value_size, sizeof(s64));  // weight
     __uint(max_entries, 1000);
 } to_allocate SEC(".maps");
 
 struct {
     __uint(type, BPF_MAP_TYPE_HASH);
     __uint(key_size, sizeof(u64)); // pid
-    __uint(value_size, sizeof(u64)); // size
-    __uint(max_entries, 10000);
+    __uint(value_size, sizeof(u64)); // memptr
+    __uint(max_entries, 1000);
 } memalign_allocate SEC(".maps");
 
+// Sampled allocations still alive, the least recently used are evicted if the processes never free them.
 struct {
-    __uint(type, BPF_MAP_TYPE_HASH);
+    __uint(type, BPF_MAP_TYPE_LRU_HASH);
     __uint(key_size, sizeof(struct pid_addr_t));
-    __uint(value_size, sizeof(struct mmap_info_t));
-    __uint(max_entries, 10000);
+    __uint(value_size, sizeof(struct mem_alloc_t));
+    __uint(max_entries, MAX_MEM_ALLOC_ENTRIES);
 } allocs SEC(".maps");
 
-static __always_inline char is_stackmap_a(void)
+// Exponentially distributed with the given mean: -ln(U) * mean, U uniform in (0, 1].
+static __always_inline u64 next_sample_bytes(u64 mean)
+{
+    u32 rnd = bpf_get_prandom_u32() | 1;
+    u32 x = rnd;
+    u32 e = 0;
+    u64 frac_q16, log2_q16, neg_ln_q16, bytes;
+
+    if (x >= (1U << 16)) {
+        x >>= 16;
+        e += 16;
+    }
+    if (x >= (1U << 8)) {
+        x >>= 8;
+        e += 8;
+    }
+    if (x >= (1U << 4)) {
+        x >>= 4;
+        e += 4;
+    }
+    if (x >= (1U << 2)) {
+        x >>= 2;
+        e += 2;
+    }
+    if (x >= (1U << 1)) {
+        e += 1;
+    }
+
+    // log2(rnd) = e + log2(1 + f) ~= e + f + c * f * (1 - f), then -ln(rnd / 2^32) = ln2 * (32 - log2(rnd))
+    frac_q16 = (((u64)rnd - (1ULL << e)) << 16) >> e;
+    log2_q16 = ((u64)e << 16) + frac_q16 + ((((frac_q16 * ((1ULL << 16) - frac_q16)) >> 16) * LOG2_C_Q16) >> 16);
+    neg_ln_q16 = ((32ULL << 16) - log2_q16) * LN2_Q16;
+    bytes = (mean * neg_ln_q16) >> 32;
+    return bytes ? bytes : 1;
+}
+
+/*
+  Returns the bytes a sampled allocation stands for, 0 if the allocation is not sampled.
+  An allocation of size s is sampled with probability 1 - e^(-s/mean), its weight s / (1 - e^(-s/mean))
+  is approximated by mean + s/2 for small allocations and s + mean/2 for large ones.
+*/
+static __always_inline s64 sample_alloc(u64 size, u64 mean)
 {
     const u32 zero = 0;
-    struct convert_data_t *convert_data = (struct convert_data_t *)bpf_map_lookup_elem(&convert_map, &zero);
-    if (!convert_data) {
-        return -1;
+    struct mem_sample_t *sample;
+
+    if (mean == 0) {
+        return (s64)size;
     }
 
-    // Obtains the data channel used to collect stack-trace data.
-    char ret = ((convert_data->convert_counter % 2) == 0);
+    sample = (struct mem_sample_t *)bpf_map_lookup_elem(&mem_sample_map, &zero);
+    if (!sample) {
+        return 0;
+    }
 
-    return ret;
+    sample->bytes_until_sample -= (s64)size;
+    if (sample->bytes_until_sample > 0) {
+        return 0;
+    }
+    sample->bytes_until_sample = (s64)next_sample_bytes(mean);
+
+    if (size < mean) {
+        return (s64)(mean + (size >> 1));
+    }
+    return (s64)(size + (mean >> 1));
 }
 
-static __always_inline int get_stack_id(struct pt_regs *ctx, char stackmap_cur, struct stack_id_s *stack_id)
+static __always_inline int get_stack_id(struct pt_regs *ctx, struct stack_id_s *stack_id)
 {
+    // stack_id is used as hash key, padding must be zeroed.
+    __builtin_memset(stack_id, 0, sizeof(struct stack_id_s));
     stack_id->pid.proc_id = bpf_get_current_pid_tgid() >> INT_LEN;
     stack_id->pid.real_start_time = 0;
     (void)bpf_get_current_comm(&stack_id->comm, sizeof(stack_id->comm));
 
-    if (stackmap_cur) {
-        stack_id->kern_stack_id = bpf_get_stackid(ctx, &stackmap_a, KERN_STACKID_FLAGS);
-        stack_id->user_stack_id = bpf_get_stackid(ctx, &stackmap_a, USER_STACKID_FLAGS);
-    } else {
-        stack_id->kern_stack_id = bpf_get_stackid(ctx, &stackmap_b, KERN_STACKID_FLAGS);
-        stack_id->user_stack_id = bpf_get_stackid(ctx, &stackmap_b, USER_STACKID_FLAGS);
-    }
-
-    if (stack_id->kern_stack_id < 0 && stack_id->user_stack_id < 0) {
+    stack_id->kern_stack_id = -1;   // only user stacks are meaningful for glibc allocations
+    stack_id->user_stack_id = bpf_get_stackid(ctx, &mem_stackmap, USER_STACKID_FLAGS);
+    if (stack_id->user_stack_id < 0) {
         return -1;
     }
 
     return 0;
 }
 
-static __always_inline void update_statistics(struct pt_regs *ctx, char stackmap_cur, s64 count,
-                                              struct stack_id_s stack_id)
-{
-    struct raw_trace_s raw_trace = {
-        .count = count,
-        .stack_id = stack_id
-    };
-
-    if (stackmap_cur) {
-        (void)bpf_perf_event_output(ctx, &stackmap_perf_a, BPF_F_CURRENT_CPU, &raw_trace, sizeof(raw_trace));
-    } else {
-        (void)bpf_perf_event_output(ctx, &stackmap_perf_b, BPF_F_CURRENT_CPU, &raw_trace, sizeof(raw_trace));
-    }
-}
-
 static __always_inline int alloc_exit(struct pt_regs *ctx, u64 addr)
 {
     u64 pid = bpf_get_current_pid_tgid();
     struct pid_addr_t pa = {0};
     pa.tgid = pid >> INT_LEN;
     pa.addr = addr;
-    u64 *alloc_size = (u64 *)bpf_map_lookup_elem(&to_allocate, &pid);
-    struct mmap_info_t mmap_info = {0};
+    s64 *weight = (s64 *)bpf_map_lookup_elem(&to_allocate, &pid);
+    struct mem_alloc_t mem_alloc;
 
-    if (alloc_size == 0)
+    if (weight == 0)
         return 0;
 
+    mem_alloc.weight = *weight;
     bpf_map_delete_elem(&to_allocate, &pid);
 
-    if (addr != 0) {
-        char stackmap_cur = is_stackmap_a();
-        if (get_stack_id(ctx, stackmap_cur, &mmap_info.stack_id) != 0) {
-            return 0;
-        }
+    if (addr == 0 || addr == (u64)-1) {    // NULL or MAP_FAILED
+        return 0;
+    }
 
-        mmap_info.timestamp_ns = bpf_ktime_get_ns();
-        mmap_info.size = (s64)*alloc_size;
-        bpf_map_update_elem(&allocs, &pa, &mmap_info, BPF_ANY);
-        update_statistics(ctx, stackmap_cur, mmap_info.size, mmap_info.stack_id);
+    if (get_stack_id(ctx, &mem_alloc.stack_id) != 0) {
+        return 0;
     }
 
+    if (stack_count_add(&mem_live_bytes, &mem_alloc.stack_id, mem_alloc.weight) != 0) {
+        return 0;
+    }
+    bpf_map_update_elem(&allocs, &pa, &mem_alloc, BPF_ANY);
     return 0;
 }
 
 static __always_inline int alloc_enter(u64 size)
 {
+    s64 weight;
     u64 pid = bpf_get_current_pid_tgid();
     u32 tgid = pid >> INT_LEN;
-    if (tgid > 1) {
-        const u32 zero = 0;
-        struct convert_data_t *convert_data = (struct convert_data_t *)bpf_map_lookup_elem(&convert_map, &zero);
-        if (!convert_data) {
-            return -1;
-        }
-        if (convert_data->whitelist_enable) {
-            struct proc_s obj = {.proc_id = tgid};
-            if (!is_proc_exist(&obj)) {
-                return 0;
-            }
+    const u32 zero = 0;
+    struct convert_data_t *convert_data = (struct convert_data_t *)bpf_map_lookup_elem(&convert_map, &zero);
+    if (!convert_data) {
+        return -1;
+    }
+
+    if (tgid > 1 && convert_data->whitelist_enable) {
+        struct proc_s obj = {.proc_id = tgid};
+        if (!is_proc_exist(&obj)) {
+            return 0;
         }
     }
-    bpf_map_update_elem(&to_allocate, &pid, &size, BPF_ANY);
+
+    if (size == 0) {
+        return 0;
+    }
+
+    weight = sample_alloc(size, convert_data->mem_sample_bytes);
+    if (weight == 0) {
+        return 0;
+    }
+    bpf_map_update_elem(&to_allocate, &pid, &weight, BPF_ANY);
 
     return 0;
 }
 
-static __always_inline int free_enter(struct pt_regs *ctx, u64 addr)
+static __always_inline int free_enter(u64 addr)
 {
     u32 tgid = bpf_get_current_pid_tgid() >> INT_LEN;
     struct pid_addr_t pa = {0};
     pa.tgid = tgid;
     pa.addr = addr;
-    struct mmap_info_t *mmap_info = (struct mmap_info_t *)bpf_map_lookup_elem(&allocs, &pa);
-    if (mmap_info == 0) {
+    struct mem_alloc_t mem_alloc;
+    struct mem_alloc_t *item = (struct mem_alloc_t *)bpf_map_lookup_elem(&allocs, &pa);
+    if (item == 0) {
         return 0;
     }
 
+    __builtin_memcpy(&mem_alloc, item, sizeof(mem_alloc));
     bpf_map_delete_elem(&allocs, &pa);
 
-    char stackmap_cur = is_stackmap_a();
-    update_statistics(ctx, stackmap_cur, -mmap_info->size, mmap_info->stack_id);
+    (void)stack_count_add(&mem_live_bytes, &mem_alloc.stack_id, -mem_alloc.weight);
     return 0;
 }
 
@@ -223,7 +293,7 @@ UPROBE(realloc, pt_regs)
     u64 ptr = (u64)PT_REGS_PARM1(ctx);
     u64 size = (u64)PT_REGS_PARM2(ctx);
 
-    free_enter(ctx, ptr);
+    free_enter(ptr);
     alloc_enter(size);
     return 0;
 }
@@ -252,7 +322,7 @@ URETPROBE(mmap, pt_regs)
 UPROBE(posix_memalign, pt_regs)
 {
     u64 memptr = (u64)PT_REGS_PARM1(ctx);
-    u64 size = (u64)PT_REGS_PARM2(ctx);
+    u64 size = (u64)PT_REGS_PARM3(ctx);
     u64 pid = bpf_get_current_pid_tgid();
     bpf_map_update_elem(&memalign_allocate, &pid, &memptr, BPF_ANY);
     alloc_enter(size);
@@ -268,7 +338,10 @@ URETPROBE(posix_memalign, pt_regs)
         return 0;
     bpf_map_delete_elem(&memalign_allocate, &pid);
 
-    if (bpf_probe_read_user(&addr, sizeof(u64), &memptr))
+    if (PT_REGS_RC(ctx) != 0)
+        return 0;
+
+    if (bpf_probe_read_user(&addr, sizeof(u64), (void *)*memptr))
         return 0;
 
     alloc_exit(ctx, addr);
@@ -291,7 +364,7 @@ URETPROBE(valloc, pt_regs)
 
 UPROBE(memalign, pt_regs)
 {
-    u64 size = (u64)PT_REGS_PARM1(ctx);
+    u64 size = (u64)PT_REGS_PARM2(ctx);
     alloc_enter(size);
     return 0;
 }
@@ -333,15 +406,15 @@ URETPROBE(aligned_alloc, pt_regs)
 
 UPROBE(free, pt_regs)
 {
-    u64 size = (u64)PT_REGS_PARM2(ctx);
-    free_enter(ctx, size);
+    u64 addr = (u64)PT_REGS_PARM1(ctx);
+    free_enter(addr);
     return 0;
 }
 
 UPROBE(munmap, pt_regs)
 {
-    u64 size = (u64)PT_REGS_PARM1(ctx);
-    free_enter(ctx, size);
+    u64 addr = (u64)PT_REGS_PARM1(ctx);
+    free_enter(addr);
     return 0;
 }
 
@@ -46,6 +46,20 @@ struct {
     __uint(max_entries, MAX_CPU);
 } stackmap_perf_b SEC(".maps");
 
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_HASH);
+    __uint(key_size, sizeof(struct stack_id_s));
+    __uint(value_size, sizeof(s64));
+    __uint(max_entries, MAX_STACK_COUNT_ENTRIES);
+} stack_count_a SEC(".maps");
+
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_HASH);
+    __uint(key_size, sizeof(struct stack_id_s));
+    __uint(value_size, sizeof(s64));
+    __uint(max_entries, MAX_STACK_COUNT_ENTRIES);
+} stack_count_b SEC(".maps");
+
 struct {
     __uint(type, BPF_MAP_TYPE_HASH);
     __uint(key_size, sizeof(u32));   // pid
@@ -117,7 +131,9 @@ int bpf_trace_sched_switch_func(struct trace_event_raw_sched_switch *ctx)
     }
     u64 t_end = bpf_ktime_get_ns();
     if (filter) {
-        struct start_info_t prev_info = {0};
+        struct start_info_t prev_info;
+        // stack_id is used as hash key, padding must be zeroed.
+        __builtin_memset(&prev_info, 0, sizeof(prev_info));
         prev_info.tgid = prev_tgid;
         prev_info.ts = t_end;
         struct stack_id_s *stack_id = &prev_info.raw_trace.stack_id;
@@ -155,6 +171,18 @@ int bpf_trace_sched_switch_func(struct trace_event_raw_sched_switch *ctx)
 
     struct raw_trace_s *next_raw_trace = &next_info->raw_trace;
     next_raw_trace->count = delta_us;
+    if (convert_data->stack_count_enable) {
+        int ret;
+        if (((convert_data->convert_counter % 2) == 0)) {
+            ret = stack_count_add(&stack_count_a, &next_raw_trace->stack_id, next_raw_trace->count);
+        } else {
+            ret = stack_count_add(&stack_count_b, &next_raw_trace->stack_id, next_raw_trace->count);
+        }
+        if (ret == 0) {
+            goto out;
+        }
+    }
+
     if (((convert_data->convert_counter % 2) == 0)) { // % 2 代表对stackmap_a和stackmap_b的选择
         (void)bpf_perf_event_output(ctx, &stackmap_perf_a, BPF_F_CURRENT_CPU, next_raw_trace,
             sizeof(struct raw_trace_s));
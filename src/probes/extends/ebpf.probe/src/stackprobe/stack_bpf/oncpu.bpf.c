@@ -36,6 +36,164 @@ struct {
     __uint(max_entries, MAX_CPU);
 } stackmap_perf_b SEC(".maps");
 
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_HASH);
+    __uint(key_size, sizeof(struct stack_id_s));
+    __uint(value_size, sizeof(s64));
+    __uint(max_entries, MAX_STACK_COUNT_ENTRIES);
+} stack_count_a SEC(".maps");
+
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_HASH);
+    __uint(key_size, sizeof(struct stack_id_s));
+    __uint(value_size, sizeof(s64));
+    __uint(max_entries, MAX_STACK_COUNT_ENTRIES);
+} stack_count_b SEC(".maps");
+
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+    __uint(key_size, sizeof(u32));
+    __uint(value_size, sizeof(struct user_stack_sample_s));
+    __uint(max_entries, 1);
+} user_stack_buf SEC(".maps");
+
+/*
+ * bpf_task_pt_regs()(5.15) and bpf_get_current_task_btf()(5.11) are declared here with their UAPI ids, the libbpf
+ * and kernel headers of the build may predate them. The availability is checked through CO-RE by the enumerator of
+ * enum bpf_func_id, matched by name with a local flavor.
+ */
+#define BPF_FUNC_GET_CURRENT_TASK_BTF   158
+#define BPF_FUNC_TASK_PT_REGS           175
+enum bpf_func_id___gopher {
+    BPF_FUNC_task_pt_regs___gopher = BPF_FUNC_TASK_PT_REGS
+};
+static struct task_struct *(*__get_current_task_btf)(void) = (void *)BPF_FUNC_GET_CURRENT_TASK_BTF;
+static void *(*__task_pt_regs)(struct task_struct *task) = (void *)BPF_FUNC_TASK_PT_REGS;
+
+/*
+ * User mode registers saved at the top of the kernel stack, see task_pt_regs(). Without the helper the address is not
+ * guessed, it depends on THREAD_SIZE(KASAN, 64K pages) and TOP_OF_KERNEL_STACK_PADDING(FRED): samples taken in kernel
+ * mode are not output for dwarf unwinding and fall back to bpf_get_stackid().
+ */
+static __always_inline void *get_task_pt_regs(void)
+{
+#ifdef bpf_core_enum_value_exists
+    if (bpf_core_enum_value_exists(enum bpf_func_id___gopher, BPF_FUNC_task_pt_regs___gopher)) {
+        return __task_pt_regs(__get_current_task_btf());
+    }
+#endif
+    return NULL;
+}
+
+static __always_inline int get_user_regs(struct bpf_perf_event_data *ctx, struct user_regs_s *regs)
+{
+#if defined(__TARGET_ARCH_x86)
+    struct pt_regs *task_regs;
+
+    if ((ctx->regs.cs & 3) == 3) {
+        regs->ip = ctx->regs.ip;
+        regs->sp = ctx->regs.sp;
+        regs->fp = ctx->regs.bp;
+        return 0;
+    }
+
+    // Sampled in kernel mode.
+    task_regs = (struct pt_regs *)get_task_pt_regs();
+    if (!task_regs) {
+        return -1;
+    }
+    regs->ip = _(task_regs->ip);
+    regs->sp = _(task_regs->sp);
+    regs->fp = _(task_regs->bp);
+    return 0;
+#elif defined(__TARGET_ARCH_arm64)
+    struct user_pt_regs *task_regs;
+
+    if ((ctx->regs.pstate & 0xf) == 0) {    // PSR_MODE_EL0t
+        regs->ip = ctx->regs.pc;
+        regs->sp = ctx->regs.sp;
+        regs->fp = ctx->regs.regs[29];
+        regs->lr = ctx->regs.regs[30];
+        return 0;
+    }
+
+    task_regs = (struct user_pt_regs *)get_task_pt_regs();
+    if (!task_regs) {
+        return -1;
+    }
+    regs->ip = _(task_regs->pc);
+    regs->sp = _(task_regs->sp);
+    regs->fp = _(task_regs->regs[29]);
+    regs->lr = _(task_regs->regs[30]);
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+#define COPY_USER_STACK(sample, size) \
+    do { \
+        if (bpf_probe_read_user((sample)->stack, (size), (void *)(sample)->regs.sp) == 0) { \
+            (sample)->stack_len = (size); \
+        } \
+    } while (0)
+
+/*
+ * Output the user regs and the top of the user stack, user mode unwinds it with .eh_frame.
+ * Such samples bypass stack_count, their user stacks are only known after unwinding.
+ */
+static __always_inline int output_user_stack_sample(struct bpf_perf_event_data *ctx, struct raw_trace_s *raw_trace,
+    char is_stackmap_a)
+{
+    const u32 zero = 0;
+    u32 size;
+    struct task_struct *task = (struct task_struct *)bpf_get_current_task();
+    struct user_stack_sample_s *sample;
+
+    if (!_(task->mm)) {
+        return -1;  // kernel thread
+    }
+
+    sample = (struct user_stack_sample_s *)bpf_map_lookup_elem(&user_stack_buf, &zero);
+    if (!sample) {
+        return -1;
+    }
+
+    __builtin_memcpy(&sample->raw_trace, raw_trace, sizeof(struct raw_trace_s));
+    sample->raw_trace.stack_id.user_stack_id = -1;
+    __builtin_memset(&sample->regs, 0, sizeof(struct user_regs_s));
+    if (get_user_regs(ctx, &sample->regs) || sample->regs.sp == 0) {
+        return -1;
+    }
+
+    // The stack may end within USER_STACK_COPY_SIZE bytes, retry with less.
+    sample->stack_len = 0;
+    COPY_USER_STACK(sample, USER_STACK_COPY_SIZE);
+    if (sample->stack_len == 0) {
+        COPY_USER_STACK(sample, USER_STACK_COPY_SIZE / 2);
+    }
+    if (sample->stack_len == 0) {
+        COPY_USER_STACK(sample, USER_STACK_COPY_SIZE / 4);
+    }
+    if (sample->stack_len == 0) {
+        COPY_USER_STACK(sample, USER_STACK_COPY_SIZE / 8);
+    }
+    if (sample->stack_len == 0) {
+        return -1;
+    }
+
+    size = __builtin_offsetof(struct user_stack_sample_s, stack) + sample->stack_len;
+    if (size > sizeof(struct user_stack_sample_s)) {
+        return -1;
+    }
+    if (is_stackmap_a) {
+        (void)bpf_perf_event_output(ctx, &stackmap_perf_a, BPF_F_CURRENT_CPU, sample, size);
+    } else {
+        (void)bpf_perf_event_output(ctx, &stackmap_perf_b, BPF_F_CURRENT_CPU, sample, size);
+    }
+    return 0;
+}
+
 static __always_inline u64 get_real_start_time()
 {
     struct task_struct* task = (struct task_struct*)bpf_get_current_task();
@@ -55,7 +213,8 @@ static __always_inline u64 get_real_start_time()
 bpf_section("perf_event")
 int function_stack_trace(struct bpf_perf_event_data *ctx)
 {
-    struct raw_trace_s raw_trace = {.count = 1};
+    struct raw_trace_s raw_trace;
+    int ret;
     const u32 zero = 0;
     struct convert_data_t *convert_data = (struct convert_data_t *)bpf_map_lookup_elem(&convert_map, &zero);
     if (!convert_data) {
@@ -65,6 +224,9 @@ int function_stack_trace(struct bpf_perf_event_data *ctx)
     // Obtains the data channel used to collect stack-trace data.
     char is_stackmap_a = ((convert_data->convert_counter % 2) == 0);
 
+    // stack_id is used as hash key, padding must be zeroed.
+    __builtin_memset(&raw_trace, 0, sizeof(raw_trace));
+    raw_trace.count = 1;
     raw_trace.stack_id.pid.proc_id = bpf_get_current_pid_tgid() >> INT_LEN;
     struct proc_s obj = {.proc_id = raw_trace.stack_id.pid.proc_id};
     if (!is_proc_exist(&obj)) {
@@ -77,9 +239,17 @@ int function_stack_trace(struct bpf_perf_event_data *ctx)
 
     if (is_stackmap_a) {
         raw_trace.stack_id.kern_stack_id = bpf_get_stackid(ctx, &stackmap_a, KERN_STACKID_FLAGS);
-        raw_trace.stack_id.user_stack_id = bpf_get_stackid(ctx, &stackmap_a, USER_STACKID_FLAGS);
     } else {
         raw_trace.stack_id.kern_stack_id = bpf_get_stackid(ctx, &stackmap_b, KERN_STACKID_FLAGS);
+    }
+
+    if (convert_data->dwarf_unwind_enable && output_user_stack_sample(ctx, &raw_trace, is_stackmap_a) == 0) {
+        return 0;
+    }
+
+    if (is_stackmap_a) {
+        raw_trace.stack_id.user_stack_id = bpf_get_stackid(ctx, &stackmap_a, USER_STACKID_FLAGS);
+    } else {
         raw_trace.stack_id.user_stack_id = bpf_get_stackid(ctx, &stackmap_b, USER_STACKID_FLAGS);
     }
     if (raw_trace.stack_id.kern_stack_id < 0 && raw_trace.stack_id.user_stack_id < 0) {
@@ -87,6 +257,17 @@ int function_stack_trace(struct bpf_perf_event_data *ctx)
         return -1;
     }
 
+    if (convert_data->stack_count_enable) {
+        if (is_stackmap_a) {
+            ret = stack_count_add(&stack_count_a, &raw_trace.stack_id, raw_trace.count);
+        } else {
+            ret = stack_count_add(&stack_count_b, &raw_trace.stack_id, raw_trace.count);
+        }
+        if (ret == 0) {
+            return 0;
+        }
+    }
+
     if (is_stackmap_a) {
         (void)bpf_perf_event_output(ctx, &stackmap_perf_a, BPF_F_CURRENT_CPU, &raw_trace, sizeof(raw_trace));
     } else {
@@ -66,5 +66,30 @@ struct {
     __uint(max_entries, MAX_PERCPU_SAMPLE_COUNT);
 } stackmap_b SEC(".maps");
 
+/*
+  In-kernel aggregation: samples with the same stack_id_s are accumulated into a per-CPU hash
+  (stack_count_a/stack_count_b, switched together with stackmap_a/stackmap_b), user mode drains it once per period.
+  Returns non-zero when the sample can not be aggregated (eg. map full), then the caller falls back to perf output.
+*/
+static __always_inline int stack_count_add(void *count_map, struct stack_id_s *stack_id, s64 count)
+{
+    s64 *val = (s64 *)bpf_map_lookup_elem(count_map, stack_id);
+    if (val) {
+        *val += count;
+        return 0;
+    }
+
+    if (bpf_map_update_elem(count_map, stack_id, &count, BPF_NOEXIST) == 0) {
+        return 0;
+    }
+
+    // The key may have been created by another CPU in the meantime.
+    val = (s64 *)bpf_map_lookup_elem(count_map, stack_id);
+    if (val) {
+        *val += count;
+        return 0;
+    }
+    return -1;
+}
 
 #endif
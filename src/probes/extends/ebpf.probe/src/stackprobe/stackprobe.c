@@ -20,6 +20,8 @@
 #include <ctype.h>
 #include <string.h>
 #include <time.h>
+#include <stdbool.h>
+#include <stddef.h>
 
 #include <linux/perf_event.h>
 #include <linux/unistd.h>
@@ -44,11 +46,13 @@
 #include "syscall.h"
 #include "symbol.h"
 #include "flame_graph.h"
+#include "pprof.h"
 #include "debug_elf_reader.h"
 #include "elf_symb.h"
 #include "container.h"
 #include "stackprobe.h"
 #include "java_support.h"
+#include "dwarf_unwind.h"
 
 #define IS_LOAD_PROBE(LOAD_TYPE, PROG_TYPE) (LOAD_TYPE & PROG_TYPE)
 
@@ -56,6 +60,7 @@
 #define OFF_CPU_PROG   "/opt/gala-gopher/extend_probes/stack_bpf/offcpu.bpf.o"
 #define IO_PROG        "/opt/gala-gopher/extend_probes/stack_bpf/io.bpf.o"
 #define MEMLEAK_PROG   "/opt/gala-gopher/extend_probes/stack_bpf/memleak.bpf.o"
+#define MEMLEAK_GLIBC_PROG  "/opt/gala-gopher/extend_probes/stack_bpf/memleak_glibc.bpf.o"
 
 #define RM_STACK_PATH "/usr/bin/rm -rf /sys/fs/bpf/gala-gopher/__stack*"
 #define STACK_PROC_MAP_PATH     "/sys/fs/bpf/gala-gopher/__stack_proc_map"
@@ -68,8 +73,8 @@
 #define IS_IEG_ADDR(addr)     ((addr) != 0xcccccccccccccccc && (addr) != 0xffffffffffffffff)
 
 #define MEMLEAK_SEC_NUM 4
+#define STACK_COUNT_BATCH_SIZE 256
 #define HISTO_TMP_LEN   (2 * STACK_SYMBS_LEN)
-#define POST_MAX_STEP_SIZE 1048576 // 1M
 
 typedef int (*AttachFunc)(struct ipc_body_s *ipc_body, struct svg_stack_trace_s *svg_st);
 typedef int (*PerfProcessFunc)(void *ctx, int cpu, void *data, u32 size);
@@ -82,7 +87,7 @@ typedef struct {
     AttachFunc func;
     perf_buffer_sample_fn cb;
 } FlameProc;
-#if 0
+
 static struct bpf_link_hash_t *bpf_link_head = NULL;
 
 enum pid_state_t {
@@ -102,10 +107,8 @@ struct bpf_link_hash_t {
     unsigned int pid; // key
     struct bpf_link_hash_value v; // value
 };
-#endif
 
 static char __histo_tmp_str[HISTO_TMP_LEN];
-int g_post_max = POST_MAX_STEP_SIZE;
 static struct ipc_body_s g_ipc_body;
 static volatile sig_atomic_t g_stop;
 static struct stack_trace_s *g_st = NULL;
@@ -325,16 +328,43 @@ static int search_user_addr_symb(u64 addr, struct addr_symb_s *addr_symb, struct
 
 #if 1
 
+static void clear_user_stack_tbl(struct user_stack_tbl_s *user_stacks)
+{
+    struct user_stack_s *item, *tmp;
+
+    if (!user_stacks) {
+        return;
+    }
+    H_ITER(user_stacks->tbl, item, tmp) {
+        H_DEL(user_stacks->tbl, item);
+        (void)free(item);
+    }
+    user_stacks->tbl = NULL;
+    user_stacks->count = 0;
+}
+
+static void destroy_raw_stack_trace(struct raw_stack_trace_s *raw_st)
+{
+    if (!raw_st) {
+        return;
+    }
+    if (raw_st->user_stacks) {
+        clear_user_stack_tbl(raw_st->user_stacks);
+        (void)free(raw_st->user_stacks);
+    }
+    (void)free(raw_st);
+}
+
 static void clear_raw_stack_trace(struct svg_stack_trace_s *svg_st, char is_stackmap_a)
 {
+    struct raw_stack_trace_s *raw_st;
+
     if (!svg_st) {
         return;
     }
-    if (is_stackmap_a) {
-        svg_st->raw_stack_trace_a->raw_trace_count = 0;
-    } else {
-        svg_st->raw_stack_trace_b->raw_trace_count = 0;
-    }
+    raw_st = is_stackmap_a ? svg_st->raw_stack_trace_a : svg_st->raw_stack_trace_b;
+    raw_st->raw_trace_count = 0;
+    clear_user_stack_tbl(raw_st->user_stacks);
 }
 
 static struct raw_stack_trace_s *create_raw_stack_trace(struct stack_trace_s *st)
@@ -370,6 +400,259 @@ static int add_raw_stack_id(struct raw_stack_trace_s *raw_st, struct raw_trace_s
     return 0;
 }
 
+static void add_stack_count(struct stack_trace_s *st, struct raw_stack_trace_s *raw_st,
+                            struct stack_id_s *stack_id, s64 *percpu_counts)
+{
+    struct raw_trace_s raw_trace = {0};
+
+    for (int cpu = 0; cpu < st->possible_cpus_num; cpu++) {
+        raw_trace.count += percpu_counts[cpu];
+    }
+    if (raw_trace.count <= 0) {
+        return;
+    }
+    (void)memcpy(&raw_trace.stack_id, stack_id, sizeof(struct stack_id_s));
+
+    if (add_raw_stack_id(raw_st, &raw_trace)) {
+        st->stats.count[STACK_STATS_LOSS]++;
+    } else {
+        st->stats.count[STACK_STATS_AGGR]++;
+    }
+}
+
+// Fallback for kernels without BPF_MAP_LOOKUP_AND_DELETE_BATCH(< 5.6)
+static void drain_stack_count_by_key(struct stack_trace_s *st, int fd, struct raw_stack_trace_s *raw_st,
+                                     s64 *percpu_counts)
+{
+    struct stack_id_s key, next_key;
+
+    while (bpf_map_get_next_key(fd, NULL, &next_key) == 0) {
+        key = next_key;
+        if (bpf_map_lookup_elem(fd, &key, percpu_counts) == 0) {
+            add_stack_count(st, raw_st, &key, percpu_counts);
+        }
+        if (bpf_map_delete_elem(fd, &key) != 0) {
+            break;
+        }
+    }
+}
+
+/*
+ * Move the samples aggregated in kernel(stack_count_a/b of the idle data channel) into raw_st,
+ * then they are symbolized in the same way as samples from perf output.
+ */
+static void drain_stack_count(struct stack_trace_s *st, struct svg_stack_trace_s *svg_st,
+                              struct raw_stack_trace_s *raw_st, char is_stackmap_a)
+{
+    int ret;
+    u32 count;
+    u32 out_batch = 0;
+    void *in_batch = NULL;
+    struct stack_id_s *keys;
+    s64 *values;
+    int fd = is_stackmap_a ? svg_st->stack_count_a_fd : svg_st->stack_count_b_fd;
+
+    if (!st->stack_count_enable || fd <= 0 || st->possible_cpus_num <= 0) {
+        return;
+    }
+
+    keys = (struct stack_id_s *)calloc(STACK_COUNT_BATCH_SIZE, sizeof(struct stack_id_s));
+    values = (s64 *)calloc(STACK_COUNT_BATCH_SIZE * st->possible_cpus_num, sizeof(s64));
+    if (!keys || !values) {
+        goto out;
+    }
+
+    while (1) {
+        count = STACK_COUNT_BATCH_SIZE;
+        ret = bpf_map_lookup_and_delete_batch(fd, in_batch, &out_batch, keys, values, &count, NULL);
+        if (ret && errno != ENOENT) {
+            drain_stack_count_by_key(st, fd, raw_st, values);
+            break;
+        }
+
+        for (u32 i = 0; i < count; i++) {
+            add_stack_count(st, raw_st, &keys[i], &values[i * st->possible_cpus_num]);
+        }
+
+        if (ret) {  // ENOENT, the map is drained
+            break;
+        }
+        in_batch = &out_batch;
+    }
+
+out:
+    if (keys) {
+        (void)free(keys);
+    }
+    if (values) {
+        (void)free(values);
+    }
+}
+
+struct mem_stack_ref_s {
+    H_HANDLE;
+    int stack_id;
+};
+
+static void destroy_mem_live_tbl(struct svg_stack_trace_s *svg_st)
+{
+    struct mem_live_s *item, *tmp;
+    H_ITER(svg_st->mem_live_tbl, item, tmp) {
+        H_DEL(svg_st->mem_live_tbl, item);
+        (void)free(item);
+    }
+    svg_st->mem_live_tbl = NULL;
+}
+
+// Returns the growth of the outstanding bytes of the stack since the last snapshot.
+static s64 update_mem_live(struct svg_stack_trace_s *svg_st, struct stack_id_s *stack_id, s64 live_bytes)
+{
+    s64 growth;
+    struct mem_live_s *item = NULL;
+
+    H_FIND(svg_st->mem_live_tbl, stack_id, sizeof(struct stack_id_s), item);
+    if (!item) {
+        item = (struct mem_live_s *)malloc(sizeof(struct mem_live_s));
+        if (!item) {
+            return 0;
+        }
+        (void)memset(item, 0, sizeof(struct mem_live_s));
+        (void)memcpy(&item->k, stack_id, sizeof(struct stack_id_s));
+        H_ADD(svg_st->mem_live_tbl, k, sizeof(struct stack_id_s), item);
+    }
+
+    growth = live_bytes - item->live_bytes;
+    item->live_bytes = live_bytes;
+    item->snap = svg_st->mem_live_snap;
+    return growth;
+}
+
+/*
+ * Stacks in mem_stackmap are never switched out, delete the ones no live allocation refers to.
+ * A stack id just returned to the bpf prog may be deleted before it is recorded, the stack is then
+ * lost until it is sampled again.
+ */
+static void gc_mem_stackmap(struct svg_stack_trace_s *svg_st)
+{
+    int stack_id = -1, next_id;
+    struct mem_live_s *item, *tmp;
+    struct mem_stack_ref_s *refs = NULL, *ref, *ref_tmp;
+
+    H_ITER(svg_st->mem_live_tbl, item, tmp) {
+        ref = NULL;
+        H_FIND_I(refs, &(item->k.user_stack_id), ref);
+        if (ref) {
+            continue;
+        }
+        ref = (struct mem_stack_ref_s *)malloc(sizeof(struct mem_stack_ref_s));
+        if (!ref) {
+            goto out;   // Keep all stacks.
+        }
+        ref->stack_id = item->k.user_stack_id;
+        H_ADD_I(refs, stack_id, ref);
+    }
+
+    // Deleting does not disturb the iteration of a stack trace map.
+    while (bpf_map_get_next_key(svg_st->mem_stackmap_fd, stack_id < 0 ? NULL : &stack_id, &next_id) == 0) {
+        stack_id = next_id;
+        ref = NULL;
+        H_FIND_I(refs, &stack_id, ref);
+        if (!ref) {
+            (void)bpf_map_delete_elem(svg_st->mem_stackmap_fd, &stack_id);
+        }
+    }
+
+out:
+    H_ITER(refs, ref, ref_tmp) {
+        H_DEL(refs, ref);
+        (void)free(ref);
+    }
+}
+
+/*
+ * Sampled memleak: read the outstanding bytes per stack aggregated in kernel(mem_live_bytes) and put
+ * the growth since the last snapshot into raw_st, so the flame graph shows where memory kept growing
+ * in the period. Stacks whose allocations were all freed or whose process exited are removed.
+ */
+static void snapshot_mem_live(struct stack_trace_s *st, struct svg_stack_trace_s *svg_st,
+                              struct raw_stack_trace_s *raw_st)
+{
+    s64 *values;
+    s64 live_bytes, growth;
+    u32 stale_count = 0;
+    char first = 1;
+    struct stack_id_s key, next_key;
+    struct stack_id_s *stale_keys;
+    struct raw_trace_s raw_trace;
+    struct mem_live_s *item, *tmp;
+    int fd = svg_st->mem_live_fd;
+
+    if (fd <= 0 || st->possible_cpus_num <= 0) {
+        return;
+    }
+
+    values = (s64 *)calloc(st->possible_cpus_num, sizeof(s64));
+    stale_keys = (struct stack_id_s *)calloc(MAX_MEM_STACK_ENTRIES, sizeof(struct stack_id_s));
+    if (!values || !stale_keys) {
+        goto out;
+    }
+
+    svg_st->mem_live_snap++;
+    while (bpf_map_get_next_key(fd, first ? NULL : &key, &next_key) == 0) {
+        first = 0;
+        key = next_key;
+        if (bpf_map_lookup_elem(fd, &key, values) != 0) {
+            continue;
+        }
+
+        live_bytes = 0;
+        for (int cpu = 0; cpu < st->possible_cpus_num; cpu++) {
+            live_bytes += values[cpu];
+        }
+        if (live_bytes <= 0 || !is_valid_proc(key.pid.proc_id)) {
+            if (stale_count < MAX_MEM_STACK_ENTRIES) {
+                (void)memcpy(&stale_keys[stale_count++], &key, sizeof(key));
+            }
+            continue;
+        }
+
+        growth = update_mem_live(svg_st, &key, live_bytes);
+        if (growth <= 0) {
+            continue;
+        }
+        (void)memset(&raw_trace, 0, sizeof(raw_trace));
+        raw_trace.count = growth;
+        (void)memcpy(&raw_trace.stack_id, &key, sizeof(key));
+        if (add_raw_stack_id(raw_st, &raw_trace)) {
+            st->stats.count[STACK_STATS_LOSS]++;
+        } else {
+            st->stats.count[STACK_STATS_AGGR]++;
+        }
+    }
+
+    // Deleting while iterating a hash map restarts the iteration, so delete afterwards.
+    for (u32 i = 0; i < stale_count; i++) {
+        (void)bpf_map_delete_elem(fd, &stale_keys[i]);
+    }
+
+    H_ITER(svg_st->mem_live_tbl, item, tmp) {
+        if (item->snap != svg_st->mem_live_snap) {
+            H_DEL(svg_st->mem_live_tbl, item);
+            (void)free(item);
+        }
+    }
+
+    gc_mem_stackmap(svg_st);
+
+out:
+    if (values) {
+        (void)free(values);
+    }
+    if (stale_keys) {
+        (void)free(stale_keys);
+    }
+}
+
 #endif
 
 #define STACK_LAYER_ELSE 0
@@ -484,69 +767,125 @@ static int __stack_symbs2string(struct stack_symbs_s *stack_symbs, struct proc_s
     return 0;
 }
 
-static int add_stack_histo(struct stack_trace_s *st, struct stack_symbs_s *stack_symbs,
-    struct proc_symbs_s *proc_symbs, enum stack_svg_type_e en_type, s64 count)
-{
-    char str[STACK_SYMBS_LEN];
-    struct stack_trace_histo_s *item = NULL, *new_item = NULL;
-    struct stack_trace_histo_s *tmp;
-    int incomplete_stack_flag = 0;
+#define STACK_HASH_SEED     0xcbf29ce484222325ULL
+#define STACK_HASH_PRIME    0x100000001b3ULL
+#define STACK_FRAME_SEP     "; "
+#define STACK_FRAME_SEP_LEN 2
 
-    str[0] = 0;
+// FNV-1a
+static u64 __stack_hash_bytes(u64 hash, const void *buf, size_t len)
+{
+    const unsigned char *p = (const unsigned char *)buf;
 
-    if (stack_symbs->user_stack_symbs[PERF_MAX_STACK_DEPTH - 1].orign_addr != 0) {
-        incomplete_stack_flag = 1;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (u64)p[i];
+        hash *= STACK_HASH_PRIME;
     }
+    return hash;
+}
 
-    if (__stack_symbs2string(stack_symbs, proc_symbs, str, STACK_SYMBS_LEN, incomplete_stack_flag)) {
-        // Statistic error, but program continues
-        st->stats.count[STACK_STATS_HISTO_ERR]++;
-    }
+static struct stack_pair_idx_s *__search_stack_pair_idx(struct stack_pair_idx_s *pair_idx,
+                                                        int proc_id, const char *pair, size_t len)
+{
+    struct stack_pair_idx_s *item = NULL;
+    struct stack_pair_key_s key;
 
-    if (str[0] == 0) {
-#ifdef GOPHER_DEBUG
-        ERROR("[STACKPROBE]: symbs2str is null(proc = %d).\n",
-                stack_symbs->pid.proc_id);
-#endif
-        return -1;
-    }
+    (void)memset(&key, 0, sizeof(key));
+    key.proc_id = proc_id;
+    key.pair_hash = __stack_hash_bytes(STACK_HASH_SEED, pair, len);
+    H_FIND(pair_idx, &key, sizeof(struct stack_pair_key_s), item);
+    return item;
+}
 
-    if (st->svg_stack_traces[en_type] == NULL) {
-        return 0;
-    }
+/*
+ * Index every two adjacent frames("; A; B") of a complete stack, so that an incomplete stack(which keeps
+ * only its first two frames) can find a complete stack of the same process passing through the same frames.
+ */
+static void add_stack_pair_idx(struct stack_pair_idx_s **pair_idx, int proc_id, struct stack_trace_histo_s *histo)
+{
+    const char *p0, *p1, *p2;
+    size_t len;
+    struct stack_pair_idx_s *item;
+
+    p0 = strstr(histo->stack_symbs_str, STACK_FRAME_SEP);
+    while (p0 != NULL) {
+        p1 = strstr(p0 + STACK_FRAME_SEP_LEN, STACK_FRAME_SEP);
+        if (p1 == NULL) {
+            break;
+        }
+        p2 = strstr(p1 + STACK_FRAME_SEP_LEN, STACK_FRAME_SEP);
+        len = (p2 != NULL) ? (size_t)(p2 - p0) : strlen(p0);
 
-    // incomplete call stack merge
-    if (incomplete_stack_flag) {
-        char tmp_str[__FUNC_NAME_LEN] = {0};
-        (void)snprintf(tmp_str, __FUNC_NAME_LEN, "[%d]", proc_symbs->proc_id);
-        H_ITER(st->svg_stack_traces[en_type]->histo_tbl, item, tmp) {
-            if (strstr(item->stack_symbs_str, tmp_str) && strstr(item->stack_symbs_str, str)) {
-                st->stats.count[STACK_STATS_HISTO_FOLDED]++;
-                item->count = item->count + count;
-                return 0;
+        if (__search_stack_pair_idx(*pair_idx, proc_id, p0, len) == NULL) {
+            item = (struct stack_pair_idx_s *)malloc(sizeof(struct stack_pair_idx_s));
+            if (item == NULL) {
+                return;
             }
+            (void)memset(item, 0, sizeof(struct stack_pair_idx_s));
+            item->k.proc_id = proc_id;
+            item->k.pair_hash = __stack_hash_bytes(STACK_HASH_SEED, p0, len);
+            item->histo = histo;
+            H_ADD(*pair_idx, k, sizeof(struct stack_pair_key_s), item);
         }
-        return -1;
+        p0 = p1;
+    }
+}
+
+static void clear_stack_pair_idx(struct stack_pair_idx_s **pair_idx)
+{
+    struct stack_pair_idx_s *item, *tmp;
+    H_ITER(*pair_idx, item, tmp) {
+        H_DEL(*pair_idx, item);
+        (void)free(item);
+    }
+    *pair_idx = NULL;
+}
+
+static int add_stack_histo(struct stack_trace_s *st, struct stack_symbs_memo_s *memo,
+    enum stack_svg_type_e en_type, s64 count, struct stack_pair_idx_s **pair_idx)
+{
+    struct stack_trace_histo_s *item = NULL, *new_item = NULL;
+    struct svg_stack_trace_s *svg_st = st->svg_stack_traces[en_type];
+
+    if (svg_st == NULL) {
+        return 0;
     }
 
-    H_FIND_S(st->svg_stack_traces[en_type]->histo_tbl, str, item); // TODO: use stack_id as key?
+    H_FIND_S(svg_st->histo_tbl, memo->symbs_str, item);
     if (item) {
         st->stats.count[STACK_STATS_HISTO_FOLDED]++;
         item->count = (s64)item->count + count;
         return 0;
     }
 
+    if (count <= 0) {
+        return 0;
+    }
+
     new_item = (struct stack_trace_histo_s *)malloc(sizeof(struct stack_trace_histo_s));
     if (!new_item) {
         return -1;
     }
-    new_item->stack_symbs_str[0] = 0;
-    (void)snprintf(new_item->stack_symbs_str, sizeof(new_item->stack_symbs_str), "%s", str);
-    new_item->count = count < 0 ? 0 : count;
-    if (new_item->count != 0) {
-        H_ADD_S(st->svg_stack_traces[en_type]->histo_tbl, stack_symbs_str, new_item);
-    }
+    // The string is owned by the memo, which lives at least until the histogram is cleared.
+    new_item->stack_symbs_str = memo->symbs_str;
+    new_item->count = count;
+    H_ADD_KEYPTR(svg_st->histo_tbl, new_item->stack_symbs_str, strlen(new_item->stack_symbs_str), new_item);
+    add_stack_pair_idx(pair_idx, memo->proc_id, new_item);
+    return 0;
+}
 
+// incomplete call stack merge
+static int merge_incomplete_stack_histo(struct stack_trace_s *st, struct stack_symbs_memo_s *memo,
+    s64 count, struct stack_pair_idx_s *pair_idx)
+{
+    struct stack_pair_idx_s *item;
+
+    item = __search_stack_pair_idx(pair_idx, memo->proc_id, memo->symbs_str, strlen(memo->symbs_str));
+    if (item == NULL) {
+        return -1;
+    }
+    st->stats.count[STACK_STATS_HISTO_FOLDED]++;
+    item->histo->count = (s64)item->histo->count + count;
     return 0;
 }
 
@@ -567,20 +906,42 @@ static void clear_stack_histo(struct svg_stack_trace_s *svg_st)
 #endif
 
 #if 1
-static int stack_id2symbs_user(struct stack_trace_s *st, struct stack_id_s *stack_id,
-                               struct addr_symb_s usr_stack_symbs[], struct proc_cache_s* proc_cache, size_t size)
+static int stack_id2ips(struct stack_trace_s *st, int fd, int stack_id, u64 ip[])
 {
-    int index = 0;
-    u64 ip[PERF_MAX_STACK_DEPTH] = {0};
-    int fd = get_stack_map_fd(st);
+    if (stack_id < 0) {
+        return 0;
+    }
 
-    if (bpf_map_lookup_elem(fd, &(stack_id->user_stack_id), ip) != 0) {
+    if (bpf_map_lookup_elem(fd, &stack_id, ip) != 0) {
 #ifdef GOPHER_DEBUG
-        ERROR("[STACKPROBE]: Failed to id2symbs user stack(map_lkup).\n");
+        ERROR("[STACKPROBE]: Failed to lookup stack(stack_id = %d).\n", stack_id);
 #endif
         st->stats.count[STACK_STATS_MAP_LKUP_ERR]++;
         return -1;
     }
+    return 0;
+}
+
+static int user_stack_id2ips(struct stack_trace_s *st, int fd, struct user_stack_tbl_s *user_stacks,
+    int stack_id, u64 ip[])
+{
+    if (stack_id < USER_STACK_ID_BASE) {
+        return stack_id2ips(st, fd, stack_id, ip);
+    }
+
+    stack_id -= USER_STACK_ID_BASE;
+    if (!user_stacks || stack_id >= user_stacks->count) {
+        st->stats.count[STACK_STATS_MAP_LKUP_ERR]++;
+        return -1;
+    }
+    (void)memcpy(ip, user_stacks->by_id[stack_id]->ips, PERF_MAX_STACK_DEPTH * sizeof(u64));
+    return 0;
+}
+
+static int stack_ips2symbs_user(struct stack_trace_s *st, struct stack_id_s *stack_id, u64 ip[],
+                                struct addr_symb_s usr_stack_symbs[], struct proc_cache_s* proc_cache, size_t size)
+{
+    int index = 0;
 
     for (int i = PERF_MAX_STACK_DEPTH - 1; (i >= 0 && index < size); i--) {
         if (ip[i] != 0 && IS_IEG_ADDR(ip[i])) {
@@ -609,20 +970,10 @@ static char __is_cpu_idle(struct addr_symb_s *addr_symb)
     return 0;
 }
 
-static int stack_id2symbs_kern(struct stack_trace_s *st, u32 kern_stack_id,
+static int stack_ips2symbs_kern(struct stack_trace_s *st, u64 ip[],
                                 struct addr_symb_s kern_stack_symbs[], size_t size)
 {
     int index = 0;
-    u64 ip[PERF_MAX_STACK_DEPTH] = {0};
-    int fd = get_stack_map_fd(st);
-
-    if (bpf_map_lookup_elem(fd, &kern_stack_id, ip) != 0) {
-#ifdef GOPHER_DEBUG
-        ERROR("[STACKPROBE]: Failed to id2symbs kern stack(stack_id = %u).\n", kern_stack_id);
-#endif
-        st->stats.count[STACK_STATS_MAP_LKUP_ERR]++;
-        return -1;
-    }
 
     for (int i = PERF_MAX_STACK_DEPTH - 1; (i >= 0 && index < size); i--) {
         if (ip[i] != 0 && IS_IEG_ADDR(ip[i])) {
@@ -645,22 +996,21 @@ static int stack_id2symbs_kern(struct stack_trace_s *st, u32 kern_stack_id,
     return 0;
 }
 
-static int stack_id2symbs(struct stack_trace_s *st, struct stack_id_s *stack_id, struct proc_cache_s* proc_cache,
-                          struct stack_symbs_s *stack_symbs)
+static int stack_ips2symbs(struct stack_trace_s *st, struct stack_id_s *stack_id, u64 user_ip[], u64 kern_ip[],
+                           struct proc_cache_s* proc_cache, struct stack_symbs_s *stack_symbs)
 {
     int ret;
     (void)memcpy(&(stack_symbs->pid), &(stack_id->pid), sizeof(struct stack_pid_s));
 
     if (stack_id->kern_stack_id >= 0) {
-        ret = stack_id2symbs_kern(st, stack_id->kern_stack_id,
-                    stack_symbs->kern_stack_symbs, PERF_MAX_STACK_DEPTH);
+        ret = stack_ips2symbs_kern(st, kern_ip, stack_symbs->kern_stack_symbs, PERF_MAX_STACK_DEPTH);
         if (ret) {
             return ret;
         }
     }
 
     if (stack_id->user_stack_id >= 0) {
-        if (stack_id2symbs_user(st, stack_id,
+        if (stack_ips2symbs_user(st, stack_id, user_ip,
                 stack_symbs->user_stack_symbs, proc_cache, PERF_MAX_STACK_DEPTH)) {
             return -1;
         }
@@ -714,13 +1064,188 @@ static struct proc_cache_s* __get_proc_cache(struct stack_trace_s *st, struct st
     return proc_cache;
 }
 
-static int stack_id2histogram(struct stack_trace_s *st, enum stack_svg_type_e en_type, char is_stackmap_a)
+static char __is_jvm_proc(struct proc_symbs_s *proc_symbs)
+{
+    for (int i = 0; i < proc_symbs->mods_count; i++) {
+        if (proc_symbs->mods[i] && proc_symbs->mods[i]->mod_type == MODULE_JVM) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void __destroy_stack_symbs_memo(struct stack_trace_s *st, struct stack_symbs_memo_s *memo)
+{
+    H_DEL(st->symbs_memo, memo);
+    if (memo->symbs_str) {
+        (void)free(memo->symbs_str);
+    }
+    (void)free(memo);
+}
+
+static void destroy_stack_symbs_memo_tbl(struct stack_trace_s *st)
+{
+    struct stack_symbs_memo_s *item, *tmp;
+    H_ITER(st->symbs_memo, item, tmp) {
+        __destroy_stack_symbs_memo(st, item);
+    }
+    st->symbs_memo = NULL;
+}
+
+/*
+ * Must be called before the histograms of a period are built, because histograms refer to the memo strings.
+ * JIT code of JVM may be replaced at the same address, so its stacks are only reused within one period.
+ */
+static void aging_stack_symbs_memo_tbl(struct stack_trace_s *st)
+{
+    u64 unused_periods;
+    struct stack_symbs_memo_s *item, *tmp;
+
+    H_ITER(st->symbs_memo, item, tmp) {
+        unused_periods = st->convert_stack_count - item->last_used;
+        if (unused_periods >= STACK_SYMBS_MEMO_AGING || (item->flags & STACK_MEMO_JVM) ||
+            H_COUNT(st->symbs_memo) > STACK_SYMBS_MEMO_MAX) {
+            __destroy_stack_symbs_memo(st, item);
+        }
+    }
+}
+
+static struct stack_symbs_memo_s *create_stack_symbs_memo(struct stack_trace_s *st, struct stack_id_s *stack_id,
+    u64 user_ip[], u64 kern_ip[], u64 key)
 {
     int ret;
-    struct stack_id_s *stack_id;
+    int incomplete_stack_flag = 0;
+    char str[STACK_SYMBS_LEN];
     struct stack_symbs_s stack_symbs;
-    struct raw_stack_trace_s *raw_st;
     struct proc_cache_s* proc_cache;
+    struct stack_symbs_memo_s *memo;
+
+    proc_cache = __get_proc_cache(st, &(stack_id->pid));
+    if (!proc_cache) {
+        return NULL;
+    }
+
+    (void)memset(&stack_symbs, 0, sizeof(stack_symbs));
+    ret = stack_ips2symbs(st, stack_id, user_ip, kern_ip, proc_cache, &stack_symbs);
+    if (ret < 0) {
+        return NULL;
+    }
+
+    memo = (struct stack_symbs_memo_s *)malloc(sizeof(struct stack_symbs_memo_s));
+    if (!memo) {
+        return NULL;
+    }
+    (void)memset(memo, 0, sizeof(struct stack_symbs_memo_s));
+    memo->k = key;
+    memo->proc_id = stack_id->pid.proc_id;
+    if (__is_jvm_proc(proc_cache->proc_symbs)) {
+        memo->flags |= STACK_MEMO_JVM;
+    }
+
+    if (ret > 0) {
+        memo->flags |= STACK_MEMO_IDLE;
+        goto out;
+    }
+
+    st->stats.count[STACK_STATS_ID2SYMBS]++;
+    if (stack_symbs.user_stack_symbs[PERF_MAX_STACK_DEPTH - 1].orign_addr != 0) {
+        incomplete_stack_flag = 1;
+        memo->flags |= STACK_MEMO_INCOMPLETE;
+    }
+
+    str[0] = 0;
+    if (__stack_symbs2string(&stack_symbs, proc_cache->proc_symbs, str, STACK_SYMBS_LEN, incomplete_stack_flag)) {
+        // Statistic error, but program continues
+        st->stats.count[STACK_STATS_HISTO_ERR]++;
+    }
+
+    if (str[0] == 0) {
+#ifdef GOPHER_DEBUG
+        ERROR("[STACKPROBE]: symbs2str is null(proc = %d).\n", stack_id->pid.proc_id);
+#endif
+        goto out;
+    }
+    memo->symbs_str = strdup(str);
+
+out:
+    H_ADD(st->symbs_memo, k, sizeof(u64), memo);
+    return memo;
+}
+
+/*
+ * Symbolize a stack once and memoize the result. Stack ids are only valid within one period,
+ * so the memo is keyed by the hash of the process and the raw addresses of the stack.
+ */
+static struct stack_symbs_memo_s *get_stack_symbs_memo(struct stack_trace_s *st, int stackmap_fd,
+    struct user_stack_tbl_s *user_stacks, struct stack_id_s *stack_id)
+{
+    u64 key;
+    u64 user_ip[PERF_MAX_STACK_DEPTH] = {0};
+    u64 kern_ip[PERF_MAX_STACK_DEPTH] = {0};
+    struct stack_symbs_memo_s *memo = NULL;
+
+    if (stack_id2ips(st, stackmap_fd, stack_id->kern_stack_id, kern_ip) ||
+        user_stack_id2ips(st, stackmap_fd, user_stacks, stack_id->user_stack_id, user_ip)) {
+        return NULL;
+    }
+
+    key = __stack_hash_bytes(STACK_HASH_SEED, &(stack_id->pid.proc_id), sizeof(stack_id->pid.proc_id));
+    key = __stack_hash_bytes(key, &(stack_id->pid.real_start_time), sizeof(stack_id->pid.real_start_time));
+    key = __stack_hash_bytes(key, user_ip, sizeof(user_ip));
+    key = __stack_hash_bytes(key, kern_ip, sizeof(kern_ip));
+
+    H_FIND(st->symbs_memo, &key, sizeof(u64), memo);
+    if (memo) {
+        st->stats.count[STACK_STATS_SYMBS_MEMO]++;
+    } else {
+        memo = create_stack_symbs_memo(st, stack_id, user_ip, kern_ip, key);
+        if (!memo) {
+            return NULL;
+        }
+    }
+    memo->last_used = st->convert_stack_count;
+    return memo;
+}
+
+static void clear_stack_id_histo(struct stack_id_histo_s **id_histo_tbl)
+{
+    struct stack_id_histo_s *item, *tmp;
+    H_ITER(*id_histo_tbl, item, tmp) {
+        H_DEL(*id_histo_tbl, item);
+        (void)free(item);
+    }
+    *id_histo_tbl = NULL;
+}
+
+// Samples of the same stack are counted before symbolization.
+static void add_stack_id_histo(struct stack_id_histo_s **id_histo_tbl, struct raw_trace_s *raw_trace)
+{
+    struct stack_id_histo_s *item = NULL;
+
+    H_FIND(*id_histo_tbl, &(raw_trace->stack_id), sizeof(struct stack_id_s), item);
+    if (item) {
+        item->count += raw_trace->count;
+        return;
+    }
+
+    item = (struct stack_id_histo_s *)malloc(sizeof(struct stack_id_histo_s));
+    if (!item) {
+        return;
+    }
+    (void)memset(item, 0, sizeof(struct stack_id_histo_s));
+    (void)memcpy(&(item->k), &(raw_trace->stack_id), sizeof(struct stack_id_s));
+    item->count = raw_trace->count;
+    H_ADD(*id_histo_tbl, k, sizeof(struct stack_id_s), item);
+}
+
+static int stack_id2histogram(struct stack_trace_s *st, enum stack_svg_type_e en_type, char is_stackmap_a)
+{
+    int stackmap_fd = is_stackmap_a ? st->stackmap_a_fd : st->stackmap_b_fd;
+    struct svg_stack_trace_s *svg_st;
+    struct raw_stack_trace_s *raw_st;
+    struct stack_id_histo_s *id_histo_tbl = NULL;
+    struct stack_pair_idx_s *pair_idx = NULL;
+    struct stack_id_histo_s *item, *tmp;
     if (!st->svg_stack_traces[en_type]) {
         return -1;
     }
@@ -732,25 +1257,40 @@ static int stack_id2histogram(struct stack_trace_s *st, enum stack_svg_type_e en
     if (raw_st == NULL) { 
         return -1;
     }
+    svg_st = st->svg_stack_traces[en_type];
+    if (svg_st->mem_live_fd > 0) {
+        snapshot_mem_live(st, svg_st, raw_st);
+        stackmap_fd = svg_st->mem_stackmap_fd;
+    } else {
+        drain_stack_count(st, svg_st, raw_st, is_stackmap_a);
+    }
     int rt_count = raw_st->raw_trace_count;
     for (int i = 0; i < rt_count; i++) {
+        add_stack_id_histo(&id_histo_tbl, &(raw_st->raw_traces[i]));
+    }
+
+    // Complete stacks first, incomplete stacks are merged into them.
+    H_ITER(id_histo_tbl, item, tmp) {
         if (g_stop) {
             break;
         }
-        stack_id = &(raw_st->raw_traces[i].stack_id);
-        proc_cache = __get_proc_cache(st, &(stack_id->pid));
-        if (!proc_cache) {
+        item->memo = get_stack_symbs_memo(st, stackmap_fd, raw_st->user_stacks, &(item->k));
+        if (!item->memo || !item->memo->symbs_str || (item->memo->flags & (STACK_MEMO_IDLE | STACK_MEMO_INCOMPLETE))) {
             continue;
         }
-        (void)memset(&stack_symbs, 0, sizeof(stack_symbs));
-        ret = stack_id2symbs(st, stack_id, proc_cache, &stack_symbs);
-        if (ret != 0) {
+        (void)add_stack_histo(st, item->memo, en_type, item->count, &pair_idx);
+    }
+
+    H_ITER(id_histo_tbl, item, tmp) {
+        if (!item->memo || !item->memo->symbs_str || !(item->memo->flags & STACK_MEMO_INCOMPLETE)) {
             continue;
         }
-        st->stats.count[STACK_STATS_ID2SYMBS]++;
-        (void)add_stack_histo(st, &stack_symbs, proc_cache->proc_symbs, en_type, raw_st->raw_traces[i].count);
+        (void)merge_incomplete_stack_histo(st, item->memo, item->count, pair_idx);
     }
 
+    clear_stack_pair_idx(&pair_idx);
+    clear_stack_id_histo(&id_histo_tbl);
+
     st->stats.count[STACK_STATS_P_CACHE] = H_COUNT(st->proc_cache);
     st->stats.count[STACK_STATS_SYMB_CACHE] = __stack_count_symb(st);
     return 0;
@@ -781,8 +1321,79 @@ static void process_loss_data(void *ctx, int cpu, u64 cnt)
     g_st->stats.count[STACK_STATS_LOSS] += cnt;
 }
 
+static int add_user_stack(struct raw_stack_trace_s *raw_st, u64 ips[])
+{
+    struct user_stack_tbl_s *user_stacks = raw_st->user_stacks;
+    struct user_stack_s *item;
+
+    if (!user_stacks) {
+        user_stacks = (struct user_stack_tbl_s *)calloc(1, sizeof(struct user_stack_tbl_s));
+        if (!user_stacks) {
+            return -1;
+        }
+        raw_st->user_stacks = user_stacks;
+    }
+
+    H_FIND(user_stacks->tbl, ips, PERF_MAX_STACK_DEPTH * sizeof(u64), item);
+    if (item) {
+        return item->id;
+    }
+    if (user_stacks->count >= MAX_USER_STACKS) {
+        return -1;
+    }
+
+    item = (struct user_stack_s *)malloc(sizeof(struct user_stack_s));
+    if (!item) {
+        return -1;
+    }
+    (void)memcpy(item->ips, ips, PERF_MAX_STACK_DEPTH * sizeof(u64));
+    item->id = USER_STACK_ID_BASE + (int)user_stacks->count;
+    user_stacks->by_id[user_stacks->count++] = item;
+    H_ADD_KEYPTR(user_stacks->tbl, item->ips, PERF_MAX_STACK_DEPTH * sizeof(u64), item);
+    return item->id;
+}
+
+/*
+ * Unwind the user stack of a sample with .eh_frame, the result is interned into the user stack table
+ * of the data channel. The user stack is left out(user_stack_id = -1) if unwinding fails.
+ */
+static void unwind_user_stack_sample(struct stack_trace_s *st, struct raw_stack_trace_s *raw_st,
+    struct user_stack_sample_s *sample, u32 size, struct raw_trace_s *raw_trace)
+{
+    u64 ips[PERF_MAX_STACK_DEPTH] = {0};
+    struct unwind_regs_s regs;
+    struct unwind_stack_s stack;
+    struct proc_cache_s *proc_cache;
+
+    (void)memcpy(raw_trace, &sample->raw_trace, sizeof(struct raw_trace_s));
+    raw_trace->stack_id.user_stack_id = -1;
+
+    if (sample->stack_len > size - offsetof(struct user_stack_sample_s, stack)) {
+        return;
+    }
+    proc_cache = __get_proc_cache(st, &(raw_trace->stack_id.pid));
+    if (!proc_cache || !proc_cache->proc_symbs) {
+        return;
+    }
+
+    regs.ip = sample->regs.ip;
+    regs.sp = sample->regs.sp;
+    regs.fp = sample->regs.fp;
+    regs.lr = sample->regs.lr;
+    stack.sp = sample->regs.sp;
+    stack.len = sample->stack_len;
+    stack.data = sample->stack;
+    if (proc_unwind_user_stack(proc_cache->proc_symbs, &regs, &stack, ips, PERF_MAX_STACK_DEPTH) <= 0) {
+        st->stats.count[STACK_STATS_USR_ADDR_ERR]++;
+        return;
+    }
+    raw_trace->stack_id.user_stack_id = add_user_stack(raw_st, ips);
+}
+
 static void process_oncpu_raw_stack_trace(void *ctx, int cpu, void *data, u32 size)
 {
+    int ret;
+    struct raw_trace_s raw_trace;
     struct raw_stack_trace_s *raw_st;
     if (!g_st || !g_st->svg_stack_traces[STACK_SVG_ONCPU] || !data) {
         return;
@@ -798,7 +1409,16 @@ static void process_oncpu_raw_stack_trace(void *ctx, int cpu, void *data, u32 si
         return;
     }
 
-    if (add_raw_stack_id(raw_st, (struct raw_trace_s *)data)) {
+    if (size >= offsetof(struct user_stack_sample_s, stack)) {
+        (void)pthread_mutex_lock(&g_st->proc_cache_lock);
+        unwind_user_stack_sample(g_st, raw_st, (struct user_stack_sample_s *)data, size, &raw_trace);
+        ret = add_raw_stack_id(raw_st, &raw_trace);
+        (void)pthread_mutex_unlock(&g_st->proc_cache_lock);
+    } else {
+        ret = add_raw_stack_id(raw_st, (struct raw_trace_s *)data);
+    }
+
+    if (ret) {
         g_st->stats.count[STACK_STATS_LOSS]++;
     } else {
         g_st->stats.count[STACK_STATS_RAW]++;
@@ -891,15 +1511,12 @@ static void destroy_svg_stack_trace(struct svg_stack_trace_s **ptr_svg_st)
         destroy_svg_mng(svg_st->svg_mng);
         svg_st->svg_mng = NULL;
     }
-    if (svg_st->raw_stack_trace_a) {
-        (void)free(svg_st->raw_stack_trace_a);
-        svg_st->raw_stack_trace_a = NULL;
-    }
-    if (svg_st->raw_stack_trace_b) {
-        (void)free(svg_st->raw_stack_trace_b);
-        svg_st->raw_stack_trace_b = NULL;
-    }
+    destroy_raw_stack_trace(svg_st->raw_stack_trace_a);
+    svg_st->raw_stack_trace_a = NULL;
+    destroy_raw_stack_trace(svg_st->raw_stack_trace_b);
+    svg_st->raw_stack_trace_b = NULL;
     clear_stack_histo(svg_st);
+    destroy_mem_live_tbl(svg_st);
 
     (void)free(svg_st);
     return;
@@ -914,7 +1531,7 @@ static void destroy_stack_trace(struct stack_trace_s **ptr_st)
     }
 
     if (st->post_server.post_enable) {
-        clean_post_server();
+        clean_post_server(&st->post_server);
     }
 
     for (int cpu = 0; cpu < st->cpus_num; cpu++) {
@@ -937,6 +1554,7 @@ static void destroy_stack_trace(struct stack_trace_s **ptr_st)
     }
 
     destroy_proc_cache_tbl(st);
+    destroy_stack_symbs_memo_tbl(st);
 
     if (st->elf_reader) {
         destroy_elf_reader(st->elf_reader);
@@ -946,6 +1564,7 @@ static void destroy_stack_trace(struct stack_trace_s **ptr_st)
 
     stacktrace_destroy_log_mgr(st);
 
+    (void)pthread_mutex_destroy(&st->proc_cache_lock);
     (void)free(st);
     return;
 }
@@ -999,7 +1618,12 @@ static struct stack_trace_s *create_stack_trace(struct ipc_body_s *ipc_body)
 
     (void)memset(st, 0, size);
     st->cpus_num = cpus_num;
+    st->possible_cpus_num = libbpf_num_possible_cpus();
     st->whitelist_enable = 1; // Only the flame graph of the specified process is collected
+    st->stack_count_enable = (st->possible_cpus_num > 0); // Aggregate oncpu/offcpu samples in kernel
+    st->mem_sample_bytes = (u64)ipc_body->probe_param.mem_sample_kb * 1024;
+    st->dwarf_unwind_enable = (u32)ipc_body->probe_param.dwarf_unwind;
+    (void)pthread_mutex_init(&st->proc_cache_lock, NULL);
 
 #if 0
     if (stacktrace_create_log_mgr(st, conf->generalConfig->logDir)) {
@@ -1069,7 +1693,10 @@ static void init_convert_counter()
     }
     struct convert_data_t convert_data = {
         .whitelist_enable = g_st->whitelist_enable,
-        .convert_counter = g_st->convert_stack_count};
+        .stack_count_enable = g_st->stack_count_enable,
+        .convert_counter = g_st->convert_stack_count,
+        .mem_sample_bytes = g_st->mem_sample_bytes,
+        .dwarf_unwind_enable = g_st->dwarf_unwind_enable};
     (void)bpf_map_update_elem(g_st->convert_map_fd, &key, &convert_data, BPF_ANY);
 }
 
@@ -1130,6 +1757,10 @@ static int load_bpf_prog(struct svg_stack_trace_s *svg_st, const char *prog_name
     }
     svg_st->stackmap_perf_a_fd = BPF_OBJ_GET_MAP_FD(svg_st->obj, "stackmap_perf_a");
     svg_st->stackmap_perf_b_fd = BPF_OBJ_GET_MAP_FD(svg_st->obj, "stackmap_perf_b");
+    svg_st->stack_count_a_fd = BPF_OBJ_GET_MAP_FD(svg_st->obj, "stack_count_a");
+    svg_st->stack_count_b_fd = BPF_OBJ_GET_MAP_FD(svg_st->obj, "stack_count_b");
+    svg_st->mem_stackmap_fd = BPF_OBJ_GET_MAP_FD(svg_st->obj, "mem_stackmap");
+    svg_st->mem_live_fd = BPF_OBJ_GET_MAP_FD(svg_st->obj, "mem_live_bytes");
 
     INFO("[STACKPROBE]: load bpf prog succeed(%s).\n", prog_name);
     return 0;
@@ -1227,7 +1858,7 @@ cleanup:
     bpf_link__destroy(links);
     return -1;
 }
-#if 0
+
 static void set_pids_inactive()
 {
     struct bpf_link_hash_t *item, *tmp;
@@ -1322,6 +1953,9 @@ static void clear_invalid_pids()
     H_ITER(bpf_link_head, pid_bpf_links, tmp) {
         if (pid_bpf_links->v.pid_state == PID_NOEXIST) {
             INFO("[STACKPROBE]: clear bpf link of pid %u\n", pid_bpf_links->pid);
+            for (int i = 0; i < pid_bpf_links->v.bpf_link_num; i++) {
+                bpf_link__destroy(pid_bpf_links->v.bpf_links[i]);
+            }
             H_DEL(bpf_link_head, pid_bpf_links);
             (void)free(pid_bpf_links);
         }
@@ -1355,14 +1989,13 @@ static void unload_bpf_progs(struct svg_stack_trace_s *svg_st)
             for (int i = 0; i < pid_bpf_links->v.bpf_link_num; i++) {
                 bpf_link__destroy(pid_bpf_links->v.bpf_links[i]);
             }
+            INFO("[STACKPROBE]: detach memleak bpf to pid %u success\n", pid_bpf_links->pid);
             H_DEL(bpf_link_head, pid_bpf_links);
             (void)free(pid_bpf_links);
-            INFO("[STACKPROBE]: detach memleak bpf to pid %u success\n", pid_bpf_links->pid);
         }
     }
 }
 
-#define BPF_FUNC_NAME_LEN 32
 static void *__uprobe_attach_check(void *arg)
 {
     int err = 0;
@@ -1393,8 +2026,8 @@ static void *__uprobe_attach_check(void *arg)
                         ERROR("[STACKPROBE]: Failed to get func(%s) in(%s) offset.\n", func_sec, elf_path);
                         break;
                     }
-                    pid_bpf_links->v.bpf_links[i] = bpf_program__attach_uprobe(prog, is_uretprobe, -1,
-                        elf_path, (size_t)symbol_offset);
+                    pid_bpf_links->v.bpf_links[i] = bpf_program__attach_uprobe(prog, is_uretprobe,
+                        (pid_t)pid_bpf_links->pid, elf_path, (size_t)symbol_offset);
 
                     err = libbpf_get_error(pid_bpf_links->v.bpf_links[i]); 
                     if (err) {
@@ -1423,16 +2056,36 @@ static void *__uprobe_attach_check(void *arg)
     return NULL;
 
 }
-#endif
+
+// Sampled memleak: uprobes on glibc allocation functions of each observed process(memleak_glibc.bpf.c)
+static int attach_memleak_glibc_bpf_prog(struct svg_stack_trace_s *svg_st)
+{
+    int err;
+    pthread_t uprobe_attach_thd;
+
+    err = pthread_create(&uprobe_attach_thd, NULL, __uprobe_attach_check, (void *)svg_st);
+    if (err != 0) {
+        ERROR("[STACKPROBE]: attach memleak bpf failed %d\n", err);
+        return -1;
+    }
+    (void)pthread_detach(uprobe_attach_thd);
+
+    INFO("[STACKPROBE]: attach memleak bpf succeed(sample every %llu bytes).\n", g_st->mem_sample_bytes);
+    return 0;
+}
+
 static int attach_memleak_bpf_prog(struct ipc_body_s *ipc_body, struct svg_stack_trace_s *svg_st)
 {
     int err;
-#if 1
     // this is for memleak.bpf.c and memleak_fp.bpf.c
     int i = 0;
     struct bpf_program *prog;
     struct bpf_link *links[MEMLEAK_SEC_NUM] = {0};
 
+    if (g_st->mem_sample_bytes != 0) {
+        return attach_memleak_glibc_bpf_prog(svg_st);
+    }
+
     bpf_object__for_each_program(prog, svg_st->obj) {
         links[i] = bpf_program__attach(prog);
         err = libbpf_get_error(links[i]); 
@@ -1452,20 +2105,6 @@ cleanup:
     }
 
     return -1;
-#else
-    // this is for memleak_glibc.bpf.c
-    pthread_t uprobe_attach_thd;
-
-    err = pthread_create(&uprobe_attach_thd, NULL, __uprobe_attach_check, (void *)svg_st);
-    if (err != 0) {
-        ERROR("[STACKPROBE]: attach memleak bpf failed %d\n", err);
-        return -1;
-    }
-    (void)pthread_detach(uprobe_attach_thd);
-
-    INFO("[STACKPROBE]: attach memleak bpf succeed.\n");
-    return 0;
-#endif
 }
 
 static void clear_stackmap(int stackmap_fd)
@@ -1502,10 +2141,10 @@ static void record_running_ctx(struct stack_trace_s *st)
     char *pos;
     char buf[LINE_BUF_LEN];
 
-    const char *col[STACK_STATS_MAX] = {"RAW", "LOSS", "HISTO_ERR", "HISTO_FOLD", "ID2SYMBS",
+    const char *col[STACK_STATS_MAX] = {"RAW", "LOSS", "AGGR", "HISTO_ERR", "HISTO_FOLD", "ID2SYMBS",
         "PCACHE_DEL", "PCACHE_CRT", "KERN_ERR", "USER_ERR", "MAP_LKUP_ERR",
-        "KERN_OK", "USER_OK", "KERN_USER", "P_CACHE", "SYMB_CACHE"};
-    const int offset[STACK_STATS_MAX] = {-8, -8, -10, -12, -10, -12, -12, -10, -10, -14, -9, -9, -11, -9, 12};
+        "KERN_OK", "USER_OK", "KERN_USER", "SYMBS_MEMO", "P_CACHE", "SYMB_CACHE"};
+    const int offset[STACK_STATS_MAX] = {-8, -8, -8, -10, -12, -10, -12, -12, -10, -10, -14, -9, -9, -11, -12, -9, 12};
 
     printf("\n========================================================================================\n");
 
@@ -1579,23 +2218,7 @@ int __do_wr_stack_histo(struct stack_svg_mng_s *svg_mng,
                 stack_trace_histo->stack_symbs_str, stack_trace_histo->count);
     }
     if (post_info->post_flag) {
-        int written = post_info->buf - post_info->buf_start;
-        int ret = __snprintf(&post_info->buf, post_info->remain_size, &post_info->remain_size, "%s", __histo_tmp_str);
-        if (ret < 0) {
-            int new_post_max = g_post_max + POST_MAX_STEP_SIZE;
-            char *temp = (char *)realloc(post_info->buf_start, new_post_max);
-            if(temp == NULL) {
-                ERROR("[STACKPROBE]: Not enough post memory (realloc failed), current capacity is %d.\n",
-                    g_post_max);
-            } else {
-                post_info->buf_start = temp;
-                post_info->buf = post_info->buf_start + written;
-                post_info->remain_size += POST_MAX_STEP_SIZE;
-                g_post_max = new_post_max;
-                INFO("[STACKPROBE]: post memory realloc to %d\n", g_post_max);
-                (void)__snprintf(&post_info->buf, post_info->remain_size, &post_info->remain_size, "%s", __histo_tmp_str);
-            }
-        }
+        (void)pprof_add_sample(post_info->pprof, stack_trace_histo->stack_symbs_str, (s64)stack_trace_histo->count);
     }
 
     (void)fputs(__histo_tmp_str, fp);
@@ -1625,8 +2248,10 @@ static void switch_stackmap()
     }
 
     // Notify BPF to switch to another channel
+    (void)pthread_mutex_lock(&st->proc_cache_lock);
     st->convert_stack_count++;
     update_convert_counter();
+    aging_stack_symbs_memo_tbl(st);
     // Histogram format to flame graph
     for (int i = 0; i < STACK_SVG_MAX; i++) {
         if (st->svg_stack_traces[i] == NULL) {
@@ -1643,6 +2268,7 @@ static void switch_stackmap()
     record_running_ctx(st);
     // Clear the context information of the running environment.
     clear_running_ctx(st);
+    (void)pthread_mutex_unlock(&st->proc_cache_lock);
     sleep(1);
 }
 
@@ -1672,7 +2298,8 @@ static int init_enabled_svg_stack_traces(struct ipc_body_s *ipc_body)
         // This array order must be the same as the order of enum stack_svg_type_e
         { PROBE_RANGE_ONCPU, STACK_SVG_ONCPU, "oncpu", ON_CPU_PROG, attach_oncpu_bpf_prog, process_oncpu_raw_stack_trace},
         { PROBE_RANGE_OFFCPU, STACK_SVG_OFFCPU, "offcpu", OFF_CPU_PROG, attach_offcpu_bpf_prog, process_offcpu_raw_stack_trace},
-        { PROBE_RANGE_MEM, STACK_SVG_MEMLEAK, "memleak", MEMLEAK_PROG, attach_memleak_bpf_prog, process_memleak_raw_stack_trace},
+        { PROBE_RANGE_MEM, STACK_SVG_MEMLEAK, "memleak", g_st->mem_sample_bytes ? MEMLEAK_GLIBC_PROG : MEMLEAK_PROG,
+            attach_memleak_bpf_prog, g_st->mem_sample_bytes ? NULL : process_memleak_raw_stack_trace},
         { PROBE_RANGE_IO, STACK_SVG_IO, "io", IO_PROG, NULL, NULL},
     };
     
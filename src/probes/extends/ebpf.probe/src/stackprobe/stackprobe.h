@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <pthread.h>
+
 #include "hash.h"
 #include "symbol.h"
 #include "svg.h"
@@ -31,9 +33,26 @@ struct stack_symbs_s {
     struct stack_pid_s pid;
 };
 
+// User stacks unwound with .eh_frame(dwarf_unwind), referred by raw traces with synthetic user_stack_id.
+#define USER_STACK_ID_BASE      0x40000000  // above any stack id of stackmap_a/b
+#define MAX_USER_STACKS         8192        // distinct user stacks per data channel
+
+struct user_stack_s {
+    H_HANDLE;
+    u64 ips[PERF_MAX_STACK_DEPTH];  // key
+    int id;
+};
+
+struct user_stack_tbl_s {
+    struct user_stack_s *tbl;
+    u32 count;
+    struct user_stack_s *by_id[MAX_USER_STACKS];
+};
+
 struct raw_stack_trace_s {
     u32 stack_size;
     u32 raw_trace_count;
+    struct user_stack_tbl_s *user_stacks;   // created on the first unwound sample, cleared with raw_traces
     struct raw_trace_s raw_traces[];
 };
 
@@ -41,10 +60,48 @@ struct raw_stack_trace_s {
 #define STACK_SYMBS_LEN     (2 * (PERF_MAX_STACK_DEPTH * __FUNC_NAME_LEN))  // KERN + USER
 struct stack_trace_histo_s {
     H_HANDLE;
-    char stack_symbs_str[STACK_SYMBS_LEN];
+    char *stack_symbs_str;      // refers to stack_symbs_memo_s.symbs_str
     u64 count;
 };
 
+#define STACK_SYMBS_MEMO_MAX    4096
+#define STACK_SYMBS_MEMO_AGING  10      // Periods
+
+#define STACK_MEMO_IDLE         0x01    // cpu idle, ignored
+#define STACK_MEMO_INCOMPLETE   0x02    // symbs_str holds the first two frames only
+#define STACK_MEMO_JVM          0x04    // only reused within one period
+
+// Symbolized stack, memoized across periods.
+struct stack_symbs_memo_s {
+    H_HANDLE;
+    u64 k;                      // hash of pid, real_start_time, user and kern addresses
+    u64 last_used;              // convert_stack_count of the last period the stack was sampled
+    u32 flags;
+    int proc_id;
+    char *symbs_str;            // NULL if no symbol found
+};
+
+// Samples of one period aggregated by stack id.
+struct stack_id_histo_s {
+    H_HANDLE;
+    struct stack_id_s k;
+    s64 count;
+    struct stack_symbs_memo_s *memo;
+};
+
+struct stack_pair_key_s {
+    int proc_id;
+    int pad;
+    u64 pair_hash;
+};
+
+// Two adjacent frames("; A; B") of a complete stack -> the stack, used to merge incomplete stacks.
+struct stack_pair_idx_s {
+    H_HANDLE;
+    struct stack_pair_key_s k;
+    struct stack_trace_histo_s *histo;
+};
+
 struct proc_cache_s {
     H_HANDLE;
     struct stack_pid_s k;
@@ -54,6 +111,7 @@ struct proc_cache_s {
 enum stack_stats_e {
     STACK_STATS_RAW = 0,
     STACK_STATS_LOSS = 1,
+    STACK_STATS_AGGR,
     STACK_STATS_HISTO_ERR,
     STACK_STATS_HISTO_FOLDED,
     STACK_STATS_ID2SYMBS,
@@ -65,6 +123,7 @@ enum stack_stats_e {
     STACK_STATS_KERN_ADDR,
     STACK_STATS_USR_ADDR,
     STACK_STATS_USR_KERN_ADDR,
+    STACK_STATS_SYMBS_MEMO,
     STACK_STATS_P_CACHE,
     STACK_STATS_SYMB_CACHE,
 
@@ -87,6 +146,14 @@ struct stack_param_s {
     struct flame_graph_param_s params[STACK_SVG_MAX];
 };
 
+// Outstanding bytes of an allocation stack at the last snapshot(sampled memleak).
+struct mem_live_s {
+    H_HANDLE;
+    struct stack_id_s k;
+    s64 live_bytes;
+    u64 snap;                   // the last snapshot the stack was alive in
+};
+
 struct svg_stack_trace_s {
     int bpf_prog_fd;
     struct bpf_object *obj;
@@ -94,6 +161,12 @@ struct svg_stack_trace_s {
 
     int stackmap_perf_a_fd;
     int stackmap_perf_b_fd;
+    int stack_count_a_fd;      // in-kernel aggregated samples, -1 if the bpf prog does not aggregate
+    int stack_count_b_fd;
+    int mem_stackmap_fd;        // stacks of live allocations, -1 if the bpf prog does not track them
+    int mem_live_fd;
+    u64 mem_live_snap;
+    struct mem_live_s *mem_live_tbl;
     struct perf_buffer* pb_a;
     struct perf_buffer* pb_b;
     struct raw_stack_trace_s *raw_stack_trace_a;
@@ -103,19 +176,26 @@ struct svg_stack_trace_s {
     struct stack_trace_histo_s *histo_tbl;
 };
 
+struct post_sender_s;
 struct post_server_s {
     char post_enable;
     long timeout; // sec
     char host[PATH_LEN];
     char app_suffix[APP_SUFFIX_LEN];
-    time_t last_post_ts;
+    time_t last_post_ts[STACK_SVG_MAX];
+    struct post_sender_s *sender;
 };
 
 struct stack_trace_s {
     char pad[3];
     char is_stackmap_a;
     int cpus_num;
+    int possible_cpus_num;      // value count of per-CPU maps
     u32 whitelist_enable;
+    u32 stack_count_enable;
+    u64 mem_sample_bytes;       // sampled memleak based on glibc allocations if non-zero
+    u32 dwarf_unwind_enable;    // oncpu user stacks are unwound in user mode
+    pthread_mutex_t proc_cache_lock;    // unwinding runs in the perf thread, share proc_cache with it
     int convert_map_fd;
     int proc_obj_map_fd;
     int stackmap_a_fd;
@@ -127,6 +207,7 @@ struct stack_trace_s {
     struct svg_stack_trace_s *svg_stack_traces[STACK_SVG_MAX];
     struct ksymb_tbl_s *ksymbs;
     struct proc_cache_s *proc_cache;
+    struct stack_symbs_memo_s *symbs_memo;
     u32 proc_cache_mirro_count;
     struct proc_cache_s *proc_cache_mirro[PROC_CACHE_MAX_COUNT]; // No release is required.
 
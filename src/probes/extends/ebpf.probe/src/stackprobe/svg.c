@@ -36,75 +36,37 @@
 
 #include "bpf.h"
 #include "stack.h"
+#include "flame_svg.h"
 #include "svg.h"
 
-#define __COMMAND_LEN       (2 * COMMAND_LEN)
-#define FAMEGRAPH_BIN       "/usr/bin/flamegraph.pl"
-#define SVG_COMMAND   "%s --title=\" %s \" %s %s > %s 2>/dev/null"
-
-struct svg_param_s {
-    char *file_name;
-    char *params;
-    char *titile;
-};
-
-static struct svg_param_s svg_params[STACK_SVG_MAX] =
-    {{"oncpu", "--countname=us", "On-CPU Time Flame Graph"},
-    {"offcpu", "--colors=io --countname=us", "Off-CPU Time Flame Graph"},
-    {"memleak", "--colors=mem --countname=Bytes", "Memory Leak Flame Graph"},
-    {"io", "--colors=io --countname=us", "IO Time Flame Graph"}};
+static struct flame_svg_opts_s svg_params[STACK_SVG_MAX] =
+    {{"On-CPU Time Flame Graph", "us", FLAME_SVG_COLOR_HOT},
+    {"Off-CPU Time Flame Graph", "us", FLAME_SVG_COLOR_IO},
+    {"Memory Leak Flame Graph", "Bytes", FLAME_SVG_COLOR_MEM},
+    {"IO Time Flame Graph", "us", FLAME_SVG_COLOR_IO}};
 
 #if 1
 static void __rm_svg(const char *svg_file)
 {
-    FILE *fp;
-    char commad[__COMMAND_LEN];
-    const char *fmt = "rm -rf %s";
-
-    if (access(svg_file, 0) != 0) {
-        return;
-    }
-
-    commad[0] = 0;
-    (void)snprintf(commad, __COMMAND_LEN, fmt, svg_file);
-    fp = popen(commad, "r");
-    if (fp != NULL) {
-        (void)pclose(fp);
-        fp = NULL;
+    if (unlink(svg_file) == 0) {
         INFO("[SVG]: Delete svg file(%s)\n", svg_file);
     }
 }
 
 static int __new_svg(const char *flame_graph, const char *svg_file, int en_type)
 {
-    const char *flamegraph_bin = FAMEGRAPH_BIN;
-    char commad[__COMMAND_LEN];
-    FILE *fp;
-
-    if (access(flamegraph_bin, 0) != 0) {
-        ERROR("[SVG]: Please install flame graph rpm.\n");
-        return -1;
-    }
-
     if (access(flame_graph, 0) != 0) {
         ERROR("[SVG]: %s is not exist.\n", flame_graph);
         return -1;
     }
 
-    commad[0] = 0;
-    (void)snprintf(commad, __COMMAND_LEN, SVG_COMMAND,
-        flamegraph_bin, svg_params[en_type].titile,
-        svg_params[en_type].params, flame_graph, svg_file);
-
-    fp = popen(commad, "r");
-    if (fp != NULL) {
-        (void)pclose(fp);
-        fp = NULL;
-        INFO("[SVG]: Create svg file(%s)\n", svg_file);
-        return 0;
+    // Rendered in process, forking a perl interpreter per window costs more than the profiling itself.
+    if (render_flame_svg(flame_graph, svg_file, &svg_params[en_type])) {
+        return -1;
     }
 
-    return -1;
+    INFO("[SVG]: Create svg file(%s)\n", svg_file);
+    return 0;
 }
 
 static void __destroy_flamegraph(struct stack_flamegraph_s *flame_graph)
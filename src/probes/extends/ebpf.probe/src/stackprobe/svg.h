@@ -19,14 +19,11 @@
 
 #include <time.h>
 #include "stack.h"
-#include <curl/curl.h>
 
+struct pprof_builder_s;
 struct post_info_s {
     int post_flag;
-    int remain_size;
-    char *buf_start;
-    char *buf;
-    CURL *curl;
+    struct pprof_builder_s *pprof;  // samples of this period, uploaded as pprof
 };
 
 #define DAYS_TIME           (24 * 60 *60)   // 1 DAY
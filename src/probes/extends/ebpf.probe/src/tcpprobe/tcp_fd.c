@@ -122,17 +122,11 @@ static void do_lkup_established_tcp_info(void)
 {
     int i, j;
     u8 role;
-    struct tcp_listen_ports* tlps;
+    struct tcp_listen_ports* tlps = NULL;
     struct tcp_estabs* tes = NULL;
     struct estab_tcp_key k;
 
-    tlps = get_listen_ports();
-    if (tlps == NULL) {
-        goto err;
-    }
-
-    tes = get_estab_tcps(tlps);
-    if (tes == NULL) {
+    if (get_listen_estab_tcps(&tlps, &tes) < 0) {
         goto err;
     }
 
@@ -31,6 +31,7 @@
 #include "bpf.h"
 #include "tcp.h"
 #include "ipc.h"
+#include "pin_state.h"
 #include "tcpprobe.h"
 #include "tcp_fd.skel.h"
 
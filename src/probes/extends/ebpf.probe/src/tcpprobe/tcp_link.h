@@ -28,8 +28,9 @@
 #define __TCP_LINK_MAX (10 * 1024)
 // Used to identifies the TCP link(including multiple establish tcp connection)
 // and save TCP statistics.
+// LRU: the map is pinned across restarts, entries of sockets closed while the probe is down are never deleted.
 struct {
-    __uint(type, BPF_MAP_TYPE_HASH);
+    __uint(type, BPF_MAP_TYPE_LRU_HASH);
     __uint(key_size, sizeof(struct sock *));
     __uint(value_size, sizeof(struct sock_stats_s));
     __uint(max_entries, __TCP_LINK_MAX);
@@ -39,8 +40,9 @@ struct {
 #define __TCP_TUPLE_MAX (10 * 1024)
 // Used to identifies the TCP sock object, and role of the SOCK object.
 // Equivalent to TCP 5-tuple objects.
+// LRU for the same reason as tcp_link_map.
 struct {
-    __uint(type, BPF_MAP_TYPE_HASH);
+    __uint(type, BPF_MAP_TYPE_LRU_HASH);
     __uint(key_size, sizeof(struct sock *));
     __uint(value_size, sizeof(struct sock_info_s));
     __uint(max_entries, __TCP_TUPLE_MAX);
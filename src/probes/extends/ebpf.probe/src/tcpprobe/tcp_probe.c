@@ -29,6 +29,9 @@
 
 #include "bpf.h"
 #include "ipc.h"
+#include "bin_output.h"
+#include "bpf_load.h"
+#include "pin_state.h"
 #include "tcpprobe.h"
 #include "tcp_event.h"
 #include "tcp_tx_rx.skel.h"
@@ -47,27 +50,39 @@
 #define TCP_TBL_SOCKBUF "tcp_sockbuf"
 #define TCP_TBL_TXRX    "tcp_tx_rx"
 
+#define TCP_LOAD_TASK_NUM   6
+
+// tcp_sockbuf is built with CO-RE, the hooks of tcp_probe are selected on the running kernel
+#define TCP_SOCKBUF_RAW_TP_PROG "bpf_raw_trace_tcp_probe"
+#define TCP_SOCKBUF_KPROBE_PROG "bpf_tcp_rcv_established"
+
 static struct ipc_body_s *__ipc_body = NULL;
+static struct bin_output_s *__tcp_output = NULL;
 
 static void output_tcp_metrics(void *ctx, int cpu, void *data, u32 size);
 
+static void output_tcp_link(const char *tbl, struct tcp_link_s *link)
+{
+    bin_output_begin(__tcp_output, tbl);
+    bin_output_u32(__tcp_output, link->tgid);
+    bin_output_u32(__tcp_output, link->role);
+    bin_output_ip(__tcp_output, link->family, &(link->c_ip));
+    bin_output_ip(__tcp_output, link->family, &(link->s_ip));
+    bin_output_u32(__tcp_output, link->c_port);
+    bin_output_u32(__tcp_output, link->s_port);
+    bin_output_u32(__tcp_output, link->family);
+}
+
 static void output_tcp_abn(void *ctx, int cpu, void *data, __u32 size)
 {
     u32 sk_drops_delta;
     u32 lost_out_delta;
     u32 sacked_out_delta;
-    struct tcp_link_s *link;
-    unsigned char src_ip_str[INET6_ADDRSTRLEN];
-    unsigned char dst_ip_str[INET6_ADDRSTRLEN];
 
     struct tcp_metrics_s *metrics  = (struct tcp_metrics_s *)data;
 
     report_tcp_abn_evt(&(__ipc_body->probe_param), metrics);
 
-    link = &(metrics->link);
-    ip_str(link->family, (unsigned char *)&(link->c_ip), src_ip_str, INET6_ADDRSTRLEN);
-    ip_str(link->family, (unsigned char *)&(link->s_ip), dst_ip_str, INET6_ADDRSTRLEN);
-
     sk_drops_delta = (metrics->abn_stats.sk_drops >= metrics->abn_stats.last_time_sk_drops) ?
         (metrics->abn_stats.sk_drops - metrics->abn_stats.last_time_sk_drops) : metrics->abn_stats.sk_drops;
 
@@ -77,242 +92,118 @@ static void output_tcp_abn(void *ctx, int cpu, void *data, __u32 size)
     sacked_out_delta = (metrics->abn_stats.sacked_out >= metrics->abn_stats.last_time_sacked_out) ?
         (metrics->abn_stats.sacked_out - metrics->abn_stats.last_time_sacked_out) : metrics->abn_stats.sacked_out;
 
-    (void)fprintf(stdout,
-        "|%s|%u|%u|%s|%s|%u|%u|%u"
-        "|%u|%u|%u|%u|%u|%u|%u|%u|%u|%u|%u|%u|%d|%d|\n",
-        TCP_TBL_ABN,
-        link->tgid,
-        link->role,
-        src_ip_str,
-        dst_ip_str,
-        link->c_port,
-        link->s_port,
-        link->family,
-
-        metrics->abn_stats.total_retrans,
-        metrics->abn_stats.backlog_drops,
-        sk_drops_delta,
-        lost_out_delta,
-        sacked_out_delta,
-        metrics->abn_stats.filter_drops,
-        metrics->abn_stats.tmout,
-        metrics->abn_stats.sndbuf_limit,
-        metrics->abn_stats.rmem_scheduls,
-        metrics->abn_stats.tcp_oom,
-        metrics->abn_stats.send_rsts,
-        metrics->abn_stats.receive_rsts,
-        metrics->abn_stats.sk_err,
-        metrics->abn_stats.sk_err_soft);
-    (void)fflush(stdout);
+    output_tcp_link(TCP_TBL_ABN, &(metrics->link));
+    bin_output_u32(__tcp_output, metrics->abn_stats.total_retrans);
+    bin_output_u32(__tcp_output, metrics->abn_stats.backlog_drops);
+    bin_output_u32(__tcp_output, sk_drops_delta);
+    bin_output_u32(__tcp_output, lost_out_delta);
+    bin_output_u32(__tcp_output, sacked_out_delta);
+    bin_output_u32(__tcp_output, metrics->abn_stats.filter_drops);
+    bin_output_u32(__tcp_output, metrics->abn_stats.tmout);
+    bin_output_u32(__tcp_output, metrics->abn_stats.sndbuf_limit);
+    bin_output_u32(__tcp_output, metrics->abn_stats.rmem_scheduls);
+    bin_output_u32(__tcp_output, metrics->abn_stats.tcp_oom);
+    bin_output_u32(__tcp_output, metrics->abn_stats.send_rsts);
+    bin_output_u32(__tcp_output, metrics->abn_stats.receive_rsts);
+    bin_output_s32(__tcp_output, metrics->abn_stats.sk_err);
+    bin_output_s32(__tcp_output, metrics->abn_stats.sk_err_soft);
+    bin_output_end(__tcp_output);
 }
 
 static void output_tcp_syn_rtt(void *ctx, int cpu, void *data, __u32 size)
 {
-    struct tcp_link_s *link;
-    unsigned char src_ip_str[INET6_ADDRSTRLEN];
-    unsigned char dst_ip_str[INET6_ADDRSTRLEN];
-
     struct tcp_metrics_s *metrics  = (struct tcp_metrics_s *)data;
 
     report_tcp_syn_rtt_evt(&(__ipc_body->probe_param), metrics);
 
     output_tcp_metrics(ctx, cpu, data, size);
 
-    link = &(metrics->link);
-    ip_str(link->family, (unsigned char *)&(link->c_ip), src_ip_str, INET6_ADDRSTRLEN);
-    ip_str(link->family, (unsigned char *)&(link->s_ip), dst_ip_str, INET6_ADDRSTRLEN);
-
-    (void)fprintf(stdout,
-        "|%s|%u|%u|%s|%s|%u|%u|%u"
-        "|%u|\n",
-        TCP_TBL_SYNRTT,
-        link->tgid,
-        link->role,
-        src_ip_str,
-        dst_ip_str,
-        link->c_port,
-        link->s_port,
-        link->family,
-
-        metrics->srtt_stats.syn_srtt);
-    (void)fflush(stdout);
+    output_tcp_link(TCP_TBL_SYNRTT, &(metrics->link));
+    bin_output_u32(__tcp_output, metrics->srtt_stats.syn_srtt);
+    bin_output_end(__tcp_output);
 }
 
 static void output_tcp_rtt(void *ctx, int cpu, void *data, __u32 size)
 {
-    struct tcp_link_s *link;
-    unsigned char src_ip_str[INET6_ADDRSTRLEN];
-    unsigned char dst_ip_str[INET6_ADDRSTRLEN];
-
     struct tcp_metrics_s *metrics  = (struct tcp_metrics_s *)data;
 
-    link = &(metrics->link);
-    ip_str(link->family, (unsigned char *)&(link->c_ip), src_ip_str, INET6_ADDRSTRLEN);
-    ip_str(link->family, (unsigned char *)&(link->s_ip), dst_ip_str, INET6_ADDRSTRLEN);
-
-    (void)fprintf(stdout,
-        "|%s|%u|%u|%s|%s|%u|%u|%u"
-        "|%u|%u|\n",
-        TCP_TBL_RTT,
-        link->tgid,
-        link->role,
-        src_ip_str,
-        dst_ip_str,
-        link->c_port,
-        link->s_port,
-        link->family,
-
-        metrics->rtt_stats.tcpi_srtt,
-        metrics->rtt_stats.tcpi_rcv_rtt);
-    (void)fflush(stdout);
+    output_tcp_link(TCP_TBL_RTT, &(metrics->link));
+    bin_output_u32(__tcp_output, metrics->rtt_stats.tcpi_srtt);
+    bin_output_u32(__tcp_output, metrics->rtt_stats.tcpi_rcv_rtt);
+    bin_output_end(__tcp_output);
 }
 
 static void output_tcp_txrx(void *ctx, int cpu, void *data, __u32 size)
 {
     u32 segs_out_delta, segs_in_delta;
-    struct tcp_link_s *link;
-    unsigned char src_ip_str[INET6_ADDRSTRLEN];
-    unsigned char dst_ip_str[INET6_ADDRSTRLEN];
 
     struct tcp_metrics_s *metrics  = (struct tcp_metrics_s *)data;
 
-    link = &(metrics->link);
-    ip_str(link->family, (unsigned char *)&(link->c_ip), src_ip_str, INET6_ADDRSTRLEN);
-    ip_str(link->family, (unsigned char *)&(link->s_ip), dst_ip_str, INET6_ADDRSTRLEN);
-
     segs_in_delta = (metrics->tx_rx_stats.segs_in >= metrics->tx_rx_stats.last_time_segs_in) ?
         (metrics->tx_rx_stats.segs_in - metrics->tx_rx_stats.last_time_segs_in) : metrics->tx_rx_stats.segs_in;
     segs_out_delta = (metrics->tx_rx_stats.segs_out >= metrics->tx_rx_stats.last_time_segs_out) ?
         (metrics->tx_rx_stats.segs_out - metrics->tx_rx_stats.last_time_segs_out) : metrics->tx_rx_stats.segs_out;
 
-    (void)fprintf(stdout,
-        "|%s|%u|%u|%s|%s|%u|%u|%u"
-        "|%llu|%llu|%u|%u|\n",
-        TCP_TBL_TXRX,
-        link->tgid,
-        link->role,
-        src_ip_str,
-        dst_ip_str,
-        link->c_port,
-        link->s_port,
-        link->family,
-
-        metrics->tx_rx_stats.rx,
-        metrics->tx_rx_stats.tx,
-        segs_in_delta,
-        segs_out_delta);
-    (void)fflush(stdout);
+    output_tcp_link(TCP_TBL_TXRX, &(metrics->link));
+    bin_output_u64(__tcp_output, metrics->tx_rx_stats.rx);
+    bin_output_u64(__tcp_output, metrics->tx_rx_stats.tx);
+    bin_output_u32(__tcp_output, segs_in_delta);
+    bin_output_u32(__tcp_output, segs_out_delta);
+    bin_output_end(__tcp_output);
 }
 
 static void output_tcp_win(void *ctx, int cpu, void *data, __u32 size)
 {
-    struct tcp_link_s *link;
-    unsigned char src_ip_str[INET6_ADDRSTRLEN];
-    unsigned char dst_ip_str[INET6_ADDRSTRLEN];
-
     struct tcp_metrics_s *metrics  = (struct tcp_metrics_s *)data;
 
     report_tcp_win_evt(&(__ipc_body->probe_param), metrics);
 
-    link = &(metrics->link);
-    ip_str(link->family, (unsigned char *)&(link->c_ip), src_ip_str, INET6_ADDRSTRLEN);
-    ip_str(link->family, (unsigned char *)&(link->s_ip), dst_ip_str, INET6_ADDRSTRLEN);
-
-    (void)fprintf(stdout,
-        "|%s|%u|%u|%s|%s|%u|%u|%u"
-        "|%u|%u|%u|%u|%u|%u|%u|\n",
-        TCP_TBL_WIN,
-        link->tgid,
-        link->role,
-        src_ip_str,
-        dst_ip_str,
-        link->c_port,
-        link->s_port,
-        link->family,
-
-        metrics->win_stats.tcpi_snd_cwnd,
-        metrics->win_stats.tcpi_notsent_bytes,
-        metrics->win_stats.tcpi_notack_bytes,
-        metrics->win_stats.tcpi_reordering,
-        metrics->win_stats.tcpi_snd_wnd,
-        metrics->win_stats.tcpi_rcv_wnd,
-        metrics->win_stats.tcpi_avl_snd_wnd);
-    (void)fflush(stdout);
+    output_tcp_link(TCP_TBL_WIN, &(metrics->link));
+    bin_output_u32(__tcp_output, metrics->win_stats.tcpi_snd_cwnd);
+    bin_output_u32(__tcp_output, metrics->win_stats.tcpi_notsent_bytes);
+    bin_output_u32(__tcp_output, metrics->win_stats.tcpi_notack_bytes);
+    bin_output_u32(__tcp_output, metrics->win_stats.tcpi_reordering);
+    bin_output_u32(__tcp_output, metrics->win_stats.tcpi_snd_wnd);
+    bin_output_u32(__tcp_output, metrics->win_stats.tcpi_rcv_wnd);
+    bin_output_u32(__tcp_output, metrics->win_stats.tcpi_avl_snd_wnd);
+    bin_output_end(__tcp_output);
 }
 
 static void output_tcp_rate(void *ctx, int cpu, void *data, __u32 size)
 {
-    struct tcp_link_s *link;
-    unsigned char src_ip_str[INET6_ADDRSTRLEN];
-    unsigned char dst_ip_str[INET6_ADDRSTRLEN];
-
     struct tcp_metrics_s *metrics  = (struct tcp_metrics_s *)data;
 
-    link = &(metrics->link);
-    ip_str(link->family, (unsigned char *)&(link->c_ip), src_ip_str, INET6_ADDRSTRLEN);
-    ip_str(link->family, (unsigned char *)&(link->s_ip), dst_ip_str, INET6_ADDRSTRLEN);
-
-    (void)fprintf(stdout,
-        "|%s|%u|%u|%s|%s|%u|%u|%u"
-        "|%u|%u|%u|%u|%u|%u|%llu|%u|%u|%u|%u|%u|\n",
-        TCP_TBL_RATE,
-        link->tgid,
-        link->role,
-        src_ip_str,
-        dst_ip_str,
-        link->c_port,
-        link->s_port,
-        link->family,
-
-        metrics->rate_stats.tcpi_rto,
-        metrics->rate_stats.tcpi_ato,
-        metrics->rate_stats.tcpi_snd_ssthresh,
-        metrics->rate_stats.tcpi_rcv_ssthresh,
-        metrics->rate_stats.tcpi_advmss,
-        metrics->rate_stats.tcpi_rcv_space,
-        metrics->rate_stats.tcpi_delivery_rate,
-        metrics->rate_stats.tcpi_busy_time,
-        metrics->rate_stats.tcpi_rwnd_limited,
-        metrics->rate_stats.tcpi_sndbuf_limited,
-        metrics->rate_stats.tcpi_pacing_rate,
-        metrics->rate_stats.tcpi_max_pacing_rate);
-    (void)fflush(stdout);
+    output_tcp_link(TCP_TBL_RATE, &(metrics->link));
+    bin_output_u32(__tcp_output, metrics->rate_stats.tcpi_rto);
+    bin_output_u32(__tcp_output, metrics->rate_stats.tcpi_ato);
+    bin_output_u32(__tcp_output, metrics->rate_stats.tcpi_snd_ssthresh);
+    bin_output_u32(__tcp_output, metrics->rate_stats.tcpi_rcv_ssthresh);
+    bin_output_u32(__tcp_output, metrics->rate_stats.tcpi_advmss);
+    bin_output_u32(__tcp_output, metrics->rate_stats.tcpi_rcv_space);
+    bin_output_u64(__tcp_output, metrics->rate_stats.tcpi_delivery_rate);
+    bin_output_u32(__tcp_output, metrics->rate_stats.tcpi_busy_time);
+    bin_output_u32(__tcp_output, metrics->rate_stats.tcpi_rwnd_limited);
+    bin_output_u32(__tcp_output, metrics->rate_stats.tcpi_sndbuf_limited);
+    bin_output_u32(__tcp_output, metrics->rate_stats.tcpi_pacing_rate);
+    bin_output_u32(__tcp_output, metrics->rate_stats.tcpi_max_pacing_rate);
+    bin_output_end(__tcp_output);
 }
 
 static void output_tcp_sockbuf(void *ctx, int cpu, void *data, __u32 size)
 {
-    struct tcp_link_s *link;
-    unsigned char src_ip_str[INET6_ADDRSTRLEN];
-    unsigned char dst_ip_str[INET6_ADDRSTRLEN];
-
     struct tcp_metrics_s *metrics  = (struct tcp_metrics_s *)data;
 
-    link = &(metrics->link);
-    ip_str(link->family, (unsigned char *)&(link->c_ip), src_ip_str, INET6_ADDRSTRLEN);
-    ip_str(link->family, (unsigned char *)&(link->s_ip), dst_ip_str, INET6_ADDRSTRLEN);
-
-    (void)fprintf(stdout,
-        "|%s|%u|%u|%s|%s|%u|%u|%u"
-        "|%u|%u|%u|%u|%u|%u|%u|%d|%d|\n",
-        TCP_TBL_SOCKBUF,
-        link->tgid,
-        link->role,
-        src_ip_str,
-        dst_ip_str,
-        link->c_port,
-        link->s_port,
-        link->family,
-
-        metrics->sockbuf_stats.tcpi_sk_err_que_size,
-        metrics->sockbuf_stats.tcpi_sk_rcv_que_size,
-        metrics->sockbuf_stats.tcpi_sk_wri_que_size,
-        metrics->sockbuf_stats.tcpi_sk_backlog_size,
-        metrics->sockbuf_stats.tcpi_sk_omem_size,
-        metrics->sockbuf_stats.tcpi_sk_forward_size,
-        metrics->sockbuf_stats.tcpi_sk_wmem_size,
-        metrics->sockbuf_stats.sk_rcvbuf,
-        metrics->sockbuf_stats.sk_sndbuf);
-    (void)fflush(stdout);
+    output_tcp_link(TCP_TBL_SOCKBUF, &(metrics->link));
+    bin_output_u32(__tcp_output, metrics->sockbuf_stats.tcpi_sk_err_que_size);
+    bin_output_u32(__tcp_output, metrics->sockbuf_stats.tcpi_sk_rcv_que_size);
+    bin_output_u32(__tcp_output, metrics->sockbuf_stats.tcpi_sk_wri_que_size);
+    bin_output_u32(__tcp_output, metrics->sockbuf_stats.tcpi_sk_backlog_size);
+    bin_output_u32(__tcp_output, metrics->sockbuf_stats.tcpi_sk_omem_size);
+    bin_output_u32(__tcp_output, metrics->sockbuf_stats.tcpi_sk_forward_size);
+    bin_output_u32(__tcp_output, metrics->sockbuf_stats.tcpi_sk_wmem_size);
+    bin_output_s32(__tcp_output, metrics->sockbuf_stats.sk_rcvbuf);
+    bin_output_s32(__tcp_output, metrics->sockbuf_stats.sk_sndbuf);
+    bin_output_end(__tcp_output);
 }
 
 static void output_tcp_metrics(void *ctx, int cpu, void *data, u32 size)
@@ -371,25 +262,36 @@ static void load_args(int args_fd, struct probe_params* params)
     (void)bpf_map_update_elem(args_fd, &key, &args, BPF_ANY);
 }
 
-static int tcp_load_probe_sockbuf(struct bpf_prog_s *prog, char is_load)
+/* Each skeleton loaded in parallel owns a slot of the prog, reserved before the load. */
+struct tcp_load_arg_s {
+    struct bpf_prog_s *prog;
+    size_t idx;
+};
+
+static int tcp_load_probe_sockbuf(void *arg)
 {
     int fd;
     struct perf_buffer *pb = NULL;
+    struct tcp_load_arg_s *load_arg = arg;
+    struct bpf_prog_s *prog = load_arg->prog;
 
-    __LOAD_PROBE(tcp_sockbuf, err, is_load);
-    if (is_load) {
-        prog->skels[prog->num].skel = tcp_sockbuf_skel;
-        prog->skels[prog->num].fn = (skel_destroy_fn)tcp_sockbuf_bpf__destroy;
-
-        fd = GET_MAP_FD(tcp_sockbuf, tcp_output);
-        pb = create_pref_buffer(fd, output_tcp_sockbuf);
-        if (pb == NULL) {
-            ERROR("[TCPPROBE] Crate 'tcp_sockbuf' perf buffer failed.\n");
-            goto err;
-        }
-        prog->pbs[prog->num] = pb;
-        prog->num++;
+    OPEN(tcp_sockbuf, err, 1);
+    if (bpf_select_raw_tracepoint(tcp_sockbuf_skel->obj, "tcp", "tcp_probe",
+                                  TCP_SOCKBUF_RAW_TP_PROG, TCP_SOCKBUF_KPROBE_PROG) < 0) {
+        goto err;
+    }
+    MAP_SET_PIN_PATH(tcp_sockbuf, args_map, TCP_LINK_ARGS_PATH, 1);
+    __PIN_STATE_MAPS(tcp_sockbuf, err, 1);
+    LOAD_ATTACH(tcpprobe, tcp_sockbuf, err, 1);
+    fd = GET_MAP_FD(tcp_sockbuf, tcp_output);
+    pb = create_pref_buffer(fd, output_tcp_sockbuf);
+    if (pb == NULL) {
+        ERROR("[TCPPROBE] Crate 'tcp_sockbuf' perf buffer failed.\n");
+        goto err;
     }
+    prog->skels[load_arg->idx].skel = tcp_sockbuf_skel;
+    prog->skels[load_arg->idx].fn = (skel_destroy_fn)tcp_sockbuf_bpf__destroy;
+    prog->pbs[load_arg->idx] = pb;
 
     return 0;
 err:
@@ -397,25 +299,23 @@ err:
     return -1;
 }
 
-static int tcp_load_probe_rtt(struct bpf_prog_s *prog, char is_load)
+static int tcp_load_probe_rtt(void *arg)
 {
     int fd;
     struct perf_buffer *pb = NULL;
+    struct tcp_load_arg_s *load_arg = arg;
+    struct bpf_prog_s *prog = load_arg->prog;
 
-    __LOAD_PROBE(tcp_rtt, err, is_load);
-    if (is_load) {
-        prog->skels[prog->num].skel = tcp_rtt_skel;
-        prog->skels[prog->num].fn = (skel_destroy_fn)tcp_rtt_bpf__destroy;
-
-        fd = GET_MAP_FD(tcp_rtt, tcp_output);
-        pb = create_pref_buffer(fd, output_tcp_rtt);
-        if (pb == NULL) {
-            ERROR("[TCPPROBE] Crate 'tcp_rtt' perf buffer failed.\n");
-            goto err;
-        }
-        prog->pbs[prog->num] = pb;
-        prog->num++;
+    __LOAD_PROBE(tcp_rtt, err, 1);
+    fd = GET_MAP_FD(tcp_rtt, tcp_output);
+    pb = create_pref_buffer(fd, output_tcp_rtt);
+    if (pb == NULL) {
+        ERROR("[TCPPROBE] Crate 'tcp_rtt' perf buffer failed.\n");
+        goto err;
     }
+    prog->skels[load_arg->idx].skel = tcp_rtt_skel;
+    prog->skels[load_arg->idx].fn = (skel_destroy_fn)tcp_rtt_bpf__destroy;
+    prog->pbs[load_arg->idx] = pb;
 
     return 0;
 err:
@@ -423,25 +323,23 @@ err:
     return -1;
 }
 
-static int tcp_load_probe_win(struct bpf_prog_s *prog, char is_load)
+static int tcp_load_probe_win(void *arg)
 {
     int fd;
     struct perf_buffer *pb = NULL;
+    struct tcp_load_arg_s *load_arg = arg;
+    struct bpf_prog_s *prog = load_arg->prog;
 
-    __LOAD_PROBE(tcp_windows, err, is_load);
-    if (is_load) {
-        prog->skels[prog->num].skel = tcp_windows_skel;
-        prog->skels[prog->num].fn = (skel_destroy_fn)tcp_windows_bpf__destroy;
-
-        fd = GET_MAP_FD(tcp_windows, tcp_output);
-        pb = create_pref_buffer(fd, output_tcp_win);
-        if (pb == NULL) {
-            ERROR("[TCPPROBE] Crate 'tcp_windows' perf buffer failed.\n");
-            goto err;
-        }
-        prog->pbs[prog->num] = pb;
-        prog->num++;
+    __LOAD_PROBE(tcp_windows, err, 1);
+    fd = GET_MAP_FD(tcp_windows, tcp_output);
+    pb = create_pref_buffer(fd, output_tcp_win);
+    if (pb == NULL) {
+        ERROR("[TCPPROBE] Crate 'tcp_windows' perf buffer failed.\n");
+        goto err;
     }
+    prog->skels[load_arg->idx].skel = tcp_windows_skel;
+    prog->skels[load_arg->idx].fn = (skel_destroy_fn)tcp_windows_bpf__destroy;
+    prog->pbs[load_arg->idx] = pb;
 
     return 0;
 err:
@@ -449,25 +347,23 @@ err:
     return -1;
 }
 
-static int tcp_load_probe_rate(struct bpf_prog_s *prog, char is_load)
+static int tcp_load_probe_rate(void *arg)
 {
     int fd;
     struct perf_buffer *pb = NULL;
+    struct tcp_load_arg_s *load_arg = arg;
+    struct bpf_prog_s *prog = load_arg->prog;
 
-    __LOAD_PROBE(tcp_rate, err, is_load);
-    if (is_load) {
-        prog->skels[prog->num].skel = tcp_rate_skel;
-        prog->skels[prog->num].fn = (skel_destroy_fn)tcp_rate_bpf__destroy;
-
-        fd = GET_MAP_FD(tcp_rate, tcp_output);
-        pb = create_pref_buffer(fd, output_tcp_rate);
-        if (pb == NULL) {
-            ERROR("[TCPPROBE] Crate 'tcp_rate' perf buffer failed.\n");
-            goto err;
-        }
-        prog->pbs[prog->num] = pb;
-        prog->num++;
+    __LOAD_PROBE(tcp_rate, err, 1);
+    fd = GET_MAP_FD(tcp_rate, tcp_output);
+    pb = create_pref_buffer(fd, output_tcp_rate);
+    if (pb == NULL) {
+        ERROR("[TCPPROBE] Crate 'tcp_rate' perf buffer failed.\n");
+        goto err;
     }
+    prog->skels[load_arg->idx].skel = tcp_rate_skel;
+    prog->skels[load_arg->idx].fn = (skel_destroy_fn)tcp_rate_bpf__destroy;
+    prog->pbs[load_arg->idx] = pb;
 
     return 0;
 err:
@@ -475,25 +371,23 @@ err:
     return -1;
 }
 
-static int tcp_load_probe_abn(struct bpf_prog_s *prog, char is_load)
+static int tcp_load_probe_abn(void *arg)
 {
     int fd;
     struct perf_buffer *pb = NULL;
+    struct tcp_load_arg_s *load_arg = arg;
+    struct bpf_prog_s *prog = load_arg->prog;
 
-    __LOAD_PROBE(tcp_abn, err, is_load);
-    if (is_load) {
-        prog->skels[prog->num].skel = tcp_abn_skel;
-        prog->skels[prog->num].fn = (skel_destroy_fn)tcp_abn_bpf__destroy;
-
-        fd = GET_MAP_FD(tcp_abn, tcp_output);
-        pb = create_pref_buffer(fd, output_tcp_abn);
-        if (pb == NULL) {
-            ERROR("[TCPPROBE] Crate 'tcp_abn' perf buffer failed.\n");
-            goto err;
-        }
-        prog->pbs[prog->num] = pb;
-        prog->num++;
+    __LOAD_PROBE(tcp_abn, err, 1);
+    fd = GET_MAP_FD(tcp_abn, tcp_output);
+    pb = create_pref_buffer(fd, output_tcp_abn);
+    if (pb == NULL) {
+        ERROR("[TCPPROBE] Crate 'tcp_abn' perf buffer failed.\n");
+        goto err;
     }
+    prog->skels[load_arg->idx].skel = tcp_abn_skel;
+    prog->skels[load_arg->idx].fn = (skel_destroy_fn)tcp_abn_bpf__destroy;
+    prog->pbs[load_arg->idx] = pb;
 
     return 0;
 err:
@@ -501,25 +395,23 @@ err:
     return -1;
 }
 
-static int tcp_load_probe_txrx(struct bpf_prog_s *prog, char is_load)
+static int tcp_load_probe_txrx(void *arg)
 {
     int fd;
     struct perf_buffer *pb = NULL;
+    struct tcp_load_arg_s *load_arg = arg;
+    struct bpf_prog_s *prog = load_arg->prog;
 
-    __LOAD_PROBE(tcp_tx_rx, err, is_load);
-    if (is_load) {
-        prog->skels[prog->num].skel = tcp_tx_rx_skel;
-        prog->skels[prog->num].fn = (skel_destroy_fn)tcp_tx_rx_bpf__destroy;
-
-        fd = GET_MAP_FD(tcp_tx_rx, tcp_output);
-        pb = create_pref_buffer(fd, output_tcp_txrx);
-        if (pb == NULL) {
-            ERROR("[TCPPROBE] Crate 'tcp_tx_rx' perf buffer failed.\n");
-            goto err;
-        }
-        prog->pbs[prog->num] = pb;
-        prog->num++;
+    __LOAD_PROBE(tcp_tx_rx, err, 1);
+    fd = GET_MAP_FD(tcp_tx_rx, tcp_output);
+    pb = create_pref_buffer(fd, output_tcp_txrx);
+    if (pb == NULL) {
+        ERROR("[TCPPROBE] Crate 'tcp_tx_rx' perf buffer failed.\n");
+        goto err;
     }
+    prog->skels[load_arg->idx].skel = tcp_tx_rx_skel;
+    prog->skels[load_arg->idx].fn = (skel_destroy_fn)tcp_tx_rx_bpf__destroy;
+    prog->pbs[load_arg->idx] = pb;
 
     return 0;
 err:
@@ -558,6 +450,9 @@ int tcp_load_probe(struct ipc_body_s *ipc_body, struct bpf_prog_s **new_prog)
     char is_load = 0;
     struct bpf_prog_s *prog;
     char is_load_txrx, is_load_abn, is_load_win, is_load_rate, is_load_rtt, is_load_sockbuf;
+    u32 task_num = 0;
+    struct tcp_load_arg_s args[TCP_LOAD_TASK_NUM];
+    struct bpf_load_task_s tasks[TCP_LOAD_TASK_NUM];
 
     is_load_txrx = ipc_body->probe_range_flags & PROBE_RANGE_TCP_STATS;
     is_load_abn = ipc_body->probe_range_flags & PROBE_RANGE_TCP_ABNORMAL;
@@ -568,6 +463,28 @@ int tcp_load_probe(struct ipc_body_s *ipc_body, struct bpf_prog_s **new_prog)
 
     __ipc_body = ipc_body;
 
+    if (__tcp_output == NULL) {
+        __tcp_output = create_bin_output(stdout);
+        if (__tcp_output == NULL) {
+            ERROR("[TCPPROBE] Create output buffer failed.\n");
+            return -1;
+        }
+    }
+    bin_output_set_binary(__tcp_output, ipc_body->probe_param.binary_output);
+
+    struct {
+        const char *name;
+        char is_load;
+        bpf_load_fn fn;
+    } loads[TCP_LOAD_TASK_NUM] = {
+        {"tcp_tx_rx", is_load_txrx, tcp_load_probe_txrx},
+        {"tcp_abn", is_load_abn, tcp_load_probe_abn},
+        {"tcp_rate", is_load_rate, tcp_load_probe_rate},
+        {"tcp_windows", is_load_win, tcp_load_probe_win},
+        {"tcp_rtt", is_load_rtt, tcp_load_probe_rtt},
+        {"tcp_sockbuf", is_load_sockbuf, tcp_load_probe_sockbuf}
+    };
+
     is_load = is_load_txrx | is_load_abn | is_load_rate | is_load_win | is_load_rtt | is_load_sockbuf;
     if (!is_load) {
         return 0;
@@ -578,31 +495,26 @@ int tcp_load_probe(struct ipc_body_s *ipc_body, struct bpf_prog_s **new_prog)
         return -1;
     }
 
+    // tcp_link creates the pinned maps shared by the others, which are loaded in parallel afterwards.
     if (tcp_load_probe_link(&(ipc_body->probe_param), prog)) {
         goto err;
     }
 
-    if (tcp_load_probe_txrx(prog, is_load_txrx)) {
-        goto err;
-    }
-
-    if (tcp_load_probe_abn(prog, is_load_abn)) {
-        goto err;
-    }
-
-    if (tcp_load_probe_rate(prog, is_load_rate)) {
-        goto err;
-    }
-
-    if (tcp_load_probe_win(prog, is_load_win)) {
-        goto err;
-    }
-
-    if (tcp_load_probe_rtt(prog, is_load_rtt)) {
-        goto err;
+    for (u32 i = 0; i < TCP_LOAD_TASK_NUM; i++) {
+        if (!loads[i].is_load) {
+            continue;
+        }
+        args[task_num].prog = prog;
+        args[task_num].idx = prog->num + task_num;
+        tasks[task_num].name = loads[i].name;
+        tasks[task_num].fn = loads[i].fn;
+        tasks[task_num].arg = &args[task_num];
+        task_num++;
     }
+    // Slots are reserved first, so that the loaded skeletons are released on failure.
+    prog->num += task_num;
 
-    if (tcp_load_probe_sockbuf(prog, is_load_sockbuf)) {
+    if (bpf_parallel_load(tasks, task_num)) {
         goto err;
     }
 
@@ -614,3 +526,16 @@ err:
     return -1;
 }
 
+/* Records of a poll cycle are written to stdout at once. */
+void flush_tcp_output(void)
+{
+    if (__tcp_output != NULL) {
+        (void)bin_output_flush(__tcp_output);
+    }
+}
+
+void destroy_tcp_output(void)
+{
+    destroy_bin_output(__tcp_output);
+    __tcp_output = NULL;
+}
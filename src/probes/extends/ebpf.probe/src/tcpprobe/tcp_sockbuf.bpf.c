@@ -48,6 +48,24 @@ static __always_inline void report_sockbuf(void *ctx, struct tcp_metrics_s *metr
     //__builtin_memset(&(metrics->sockbuf_stats), 0x0, sizeof(metrics->sockbuf_stats));
 }
 
+/*
+ * 4.13-rc1 convert sock.sk_wmem_alloc from atomic_t to refcount_t, the counter is the first member of both.
+ * The offset and the size of the field are relocated to the running kernel.
+ */
+static __always_inline u32 get_sk_wmem_alloc(struct sock *sk)
+{
+    u32 wmem = 0;
+
+#if defined(__BTF_ENABLE_ON)
+    if (bpf_core_field_exists(sk->sk_wmem_alloc) && bpf_core_field_size(sk->sk_wmem_alloc) == sizeof(wmem)) {
+        (void)bpf_core_read(&wmem, sizeof(wmem), &sk->sk_wmem_alloc);
+    }
+#else
+    (void)bpf_probe_read(&wmem, sizeof(wmem), &sk->sk_wmem_alloc);
+#endif
+    return wmem;
+}
+
 static void get_tcp_sock_buf(struct sock *sk, struct tcp_sockbuf* stats)
 {
     stats->tcpi_sk_err_que_size = _(sk->sk_error_queue.qlen);
@@ -56,12 +74,7 @@ static void get_tcp_sock_buf(struct sock *sk, struct tcp_sockbuf* stats)
     stats->tcpi_sk_backlog_size = (u32)_(sk->sk_backlog.len);
     stats->tcpi_sk_omem_size    = (u32)_(sk->sk_omem_alloc.counter);
     stats->tcpi_sk_forward_size = (u32)_(sk->sk_forward_alloc);
-#if (CURRENT_KERNEL_VERSION < KERNEL_VERSION(4, 14, 0))
-    /* 4.13-rc1 convert sock.sk_wmem_alloc from atomic_t to refcount_t*/
-    stats->tcpi_sk_wmem_size    = (u32)_(sk->sk_wmem_alloc.counter);
-#else
-    stats->tcpi_sk_wmem_size    = (u32)_(sk->sk_wmem_alloc.refs.counter);
-#endif
+    stats->tcpi_sk_wmem_size    = get_sk_wmem_alloc(sk);
 
     stats->sk_rcvbuf    = (int)_(sk->sk_rcvbuf);
     stats->sk_sndbuf    = (int)_(sk->sk_sndbuf);
@@ -132,18 +145,20 @@ static void tcp_sockbuf_probe_func(void *ctx, struct sock *sk)
         }
     }
 }
-#if (CURRENT_KERNEL_VERSION > KERNEL_VERSION(4, 18, 0))
+/*
+ * Both hooks are built in, one object runs on every kernel. Only one of them is loaded, selected by the running
+ * kernel in user space(see bpf_select_raw_tracepoint).
+ */
 KRAWTRACE(tcp_probe, bpf_raw_tracepoint_args)
 {
     struct sock *sk = (struct sock*)ctx->args[0];
     tcp_sockbuf_probe_func(ctx, sk);
     return 0;
 }
-#else
+
 KPROBE(tcp_rcv_established, pt_regs)
 {
     struct sock *sk = (struct sock*)PT_REGS_PARM1(ctx);
     tcp_sockbuf_probe_func(ctx, sk);
     return 0;
 }
-#endif
@@ -46,6 +46,8 @@ static struct ipc_body_s g_ipc_body;
 
 void load_established_tcps(struct ipc_body_s *ipc_body, int map_fd);
 int tcp_load_probe(struct ipc_body_s *ipc_body, struct bpf_prog_s **tcp_progs);
+void flush_tcp_output(void);
+void destroy_tcp_output(void);
 
 static void sig_int(int signo)
 {
@@ -158,6 +160,7 @@ int main(int argc, char **argv)
                     break;
                 }
             }
+            flush_tcp_output();
         } else {
             sleep(1);
         }
@@ -165,6 +168,7 @@ int main(int argc, char **argv)
 
 err:
     unload_bpf_prog(&tcp_progs);
+    destroy_tcp_output();
 
     tcp_unload_fd_probe();
     destroy_established_tcps();
@@ -23,8 +23,11 @@
 
 #define TCP_LINK_OUTPUT_PATH    "/sys/fs/bpf/gala-gopher/__tcplink_output"
 #define TCP_LINK_ARGS_PATH      "/sys/fs/bpf/gala-gopher/__tcplink_args"
-#define TCP_LINK_SOCKS_PATH     "/sys/fs/bpf/gala-gopher/__tcplink_socks"
-#define TCP_LINK_TCP_PATH       "/sys/fs/bpf/gala-gopher/__tcplink_tcp"
+// tcp_link_map and sock_map are state maps kept across restarts, see pin_state.h
+#define TCP_LINK_SOCKS_PATH     "/sys/fs/bpf/gala-gopher/state/__tcplink_socks"
+#define TCP_LINK_TCP_PATH       "/sys/fs/bpf/gala-gopher/state/__tcplink_tcp"
+#define TCP_LINK_LAYOUT_PATH    "/sys/fs/bpf/gala-gopher/state/__tcplink_layout"
+#define TCP_LINK_LAYOUT_VERSION 2   // bump on any change of struct sock_stats_s or struct sock_info_s
 
 #define TCP_PROBE_ABN       (u32)(1)
 #define TCP_PROBE_WINDOWS   (u32)(1 << 1)
@@ -215,11 +218,25 @@ void destroy_established_tcps(void);
 int tcp_load_fd_probe(int *tcp_fd_map_fd, int *proc_obj_map_fd);
 void tcp_unload_fd_probe(void);
 
+#define __PIN_STATE_MAPS(probe_name, end, load) \
+    do { \
+        if (load) { \
+            struct pin_state_map_s __state_maps[] = { \
+                {GET_MAP_OBJ(probe_name, tcp_link_map), TCP_LINK_TCP_PATH}, \
+                {GET_MAP_OBJ(probe_name, sock_map), TCP_LINK_SOCKS_PATH} \
+            }; \
+            if (pin_state_maps(TCP_LINK_LAYOUT_PATH, TCP_LINK_LAYOUT_VERSION, __state_maps, \
+                               sizeof(__state_maps) / sizeof(__state_maps[0])) < 0) { \
+                ERROR("[TCPPROBE] Failed to pin state maps of " #probe_name ".\n"); \
+                goto end; \
+            } \
+        } \
+    } while (0)
+
 #define __LOAD_PROBE(probe_name, end, load) \
     OPEN(probe_name, end, load); \
     MAP_SET_PIN_PATH(probe_name, args_map, TCP_LINK_ARGS_PATH, load); \
-    MAP_SET_PIN_PATH(probe_name, tcp_link_map, TCP_LINK_TCP_PATH, load); \
-    MAP_SET_PIN_PATH(probe_name, sock_map, TCP_LINK_SOCKS_PATH, load); \
+    __PIN_STATE_MAPS(probe_name, end, load); \
     LOAD_ATTACH(tcpprobe, probe_name, end, load)
 
 #endif
@@ -0,0 +1,233 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-08-31
+ * Description: native reader and tokenizer of /proc files
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "proc_file.h"
+
+#define PROC_FILE_BUF_MAX   (16 * 1024 * 1024)
+
+static char g_proc_root[PATH_LEN] = PROC_ROOT_DEFAULT;
+
+void set_proc_root(const char *root)
+{
+    (void)snprintf(g_proc_root, sizeof(g_proc_root), "%s", (root == NULL) ? PROC_ROOT_DEFAULT : root);
+}
+
+const char *get_proc_root(void)
+{
+    return g_proc_root;
+}
+
+static int __open_proc_file(struct proc_file_s *pf, const char *name)
+{
+    (void)snprintf(pf->path, sizeof(pf->path), "%s/%s", g_proc_root, name);
+    pf->fd = open(pf->path, O_RDONLY | O_CLOEXEC);
+    return (pf->fd < 0) ? -1 : 0;
+}
+
+static int __read_proc_file(struct proc_file_s *pf)
+{
+    ssize_t n;
+    char *buf;
+    u32 size;
+
+    if (pf->buf == NULL) {
+        pf->buf = (char *)malloc(PROC_FILE_BUF_SIZE);
+        if (pf->buf == NULL) {
+            return -1;
+        }
+        pf->size = PROC_FILE_BUF_SIZE;
+    }
+
+    // seq files restart from the beginning for offset 0, no lseek() is needed
+    pf->len = 0;
+    while (1) {
+        if (pf->size - pf->len <= 1) {
+            if (pf->size >= PROC_FILE_BUF_MAX) {
+                break;
+            }
+            size = pf->size * 2;
+            buf = (char *)realloc(pf->buf, size);
+            if (buf == NULL) {
+                break;
+            }
+            pf->buf = buf;
+            pf->size = size;
+        }
+        n = pread(pf->fd, pf->buf + pf->len, pf->size - pf->len - 1, (off_t)pf->len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            pf->len = 0;
+            pf->buf[0] = 0;
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        pf->len += (u32)n;
+    }
+    pf->buf[pf->len] = 0;
+    return 0;
+}
+
+int init_proc_file(struct proc_file_s *pf, const char *name)
+{
+    (void)memset(pf, 0, sizeof(struct proc_file_s));
+    if (__open_proc_file(pf, name)) {
+        return -1;
+    }
+    return 0;
+}
+
+void free_proc_file(struct proc_file_s *pf)
+{
+    if (pf->fd >= 0) {
+        (void)close(pf->fd);
+    }
+    pf->fd = -1;
+    if (pf->buf != NULL) {
+        free(pf->buf);
+    }
+    pf->buf = NULL;
+    pf->len = 0;
+    pf->size = 0;
+}
+
+int read_proc_file(struct proc_file_s *pf)
+{
+    if (pf->fd < 0) {
+        return -1;
+    }
+    return __read_proc_file(pf);
+}
+
+int load_proc_file(struct proc_file_s *pf, const char *name)
+{
+    int ret;
+
+    pf->len = 0;
+    if (__open_proc_file(pf, name)) {
+        return -1;
+    }
+    ret = __read_proc_file(pf);
+    (void)close(pf->fd);
+    pf->fd = -1;
+    return ret;
+}
+
+static inline char __is_blank(char c)
+{
+    return (c == ' ' || c == '\t');
+}
+
+int proc_tok_line(struct proc_tok_s *tok, struct proc_tok_s *line)
+{
+    const char *nl;
+
+    if (tok->cur >= tok->end) {
+        return -1;
+    }
+    nl = memchr(tok->cur, '\n', (size_t)(tok->end - tok->cur));
+    line->cur = tok->cur;
+    line->end = (nl == NULL) ? tok->end : nl;
+    tok->cur = (nl == NULL) ? tok->end : nl + 1;
+    return 0;
+}
+
+int proc_tok_next(struct proc_tok_s *tok, struct str_view_s *field)
+{
+    const char *p = tok->cur;
+
+    while (p < tok->end && (__is_blank(*p) || *p == '\n')) {
+        p++;
+    }
+    if (p >= tok->end) {
+        tok->cur = tok->end;
+        return -1;
+    }
+    field->str = p;
+    while (p < tok->end && !__is_blank(*p) && *p != '\n') {
+        p++;
+    }
+    field->len = (u32)(p - field->str);
+    tok->cur = p;
+    return 0;
+}
+
+int proc_tok_skip(struct proc_tok_s *tok, u32 num)
+{
+    struct str_view_s field;
+
+    for (u32 i = 0; i < num; i++) {
+        if (proc_tok_next(tok, &field)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+u32 proc_file_line_num(const struct proc_file_s *pf)
+{
+    u32 num = 0;
+    struct proc_tok_s tok, line;
+
+    proc_file_tok(pf, &tok);
+    while (proc_tok_line(&tok, &line) == 0) {
+        num++;
+    }
+    return num;
+}
+
+char str_view_eq(const struct str_view_s *v, const char *str)
+{
+    return (strlen(str) == v->len && memcmp(v->str, str, v->len) == 0);
+}
+
+char str_view_contains(const struct str_view_s *v, const char *str)
+{
+    u32 len = (u32)strlen(str);
+
+    for (u32 i = 0; i + len <= v->len; i++) {
+        if (memcmp(v->str + i, str, len) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+u64 str_view_to_u64(const struct str_view_s *v)
+{
+    u64 value = 0;
+
+    for (u32 i = 0; i < v->len && v->str[i] >= '0' && v->str[i] <= '9'; i++) {
+        value = value * 10 + (u64)(v->str[i] - '0');
+    }
+    return value;
+}
+
+void str_view_copy(const struct str_view_s *v, char *buf, u32 size)
+{
+    u32 len = min(v->len, size - 1);
+
+    (void)memcpy(buf, v->str, len);
+    buf[len] = 0;
+}
@@ -0,0 +1,87 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-08-31
+ * Description: native reader and tokenizer of /proc files
+ ******************************************************************************/
+#ifndef __SYSTEM_PROC_FILE_H__
+#define __SYSTEM_PROC_FILE_H__
+
+#pragma once
+
+#include "common.h"
+
+/*
+ * System-wide /proc files are opened once and re-read with pread() from offset 0 every period, per-process files
+ * are read with a single open/read/close into a buffer reused across processes. The content is parsed in place,
+ * fields are views into the buffer and are never copied.
+ *
+ * Paths are relative to the proc root, "/proc" by default, so that the collectors can run on a fixture tree.
+ */
+#define PROC_ROOT_DEFAULT   "/proc"
+#define PROC_FILE_BUF_SIZE  4096
+#define PROC_FILE_INITIALIZER   {.fd = -1}
+
+struct proc_file_s {
+    int fd;             // -1 if the file is not kept open
+    u32 len;            // length of the content, the content is always NUL-terminated
+    u32 size;           // capacity of buf
+    char *buf;
+    char path[PATH_LEN];
+};
+
+struct str_view_s {
+    const char *str;    // not NUL-terminated
+    u32 len;
+};
+
+struct proc_tok_s {
+    const char *cur;
+    const char *end;
+};
+
+void set_proc_root(const char *root);
+const char *get_proc_root(void);
+
+// open name under the proc root and keep it open, the content is read by read_proc_file()
+int init_proc_file(struct proc_file_s *pf, const char *name);
+void free_proc_file(struct proc_file_s *pf);
+int read_proc_file(struct proc_file_s *pf);
+
+// read name under the proc root once into pf(PROC_FILE_INITIALIZER), the buffer is reused across calls
+int load_proc_file(struct proc_file_s *pf, const char *name);
+
+static inline void proc_tok_init(struct proc_tok_s *tok, const char *str, u32 len)
+{
+    tok->cur = str;
+    tok->end = str + len;
+}
+
+static inline void proc_file_tok(const struct proc_file_s *pf, struct proc_tok_s *tok)
+{
+    proc_tok_init(tok, pf->buf, pf->len);
+}
+
+/*
+ * proc_tok_line() cuts the next line(without '\n') into line, proc_tok_next() cuts the next field separated by
+ * spaces or tabs. Both return -1 if nothing is left.
+ */
+int proc_tok_line(struct proc_tok_s *tok, struct proc_tok_s *line);
+int proc_tok_next(struct proc_tok_s *tok, struct str_view_s *field);
+int proc_tok_skip(struct proc_tok_s *tok, u32 num);
+u32 proc_file_line_num(const struct proc_file_s *pf);
+
+char str_view_eq(const struct str_view_s *v, const char *str);
+char str_view_contains(const struct str_view_s *v, const char *str);
+u64 str_view_to_u64(const struct str_view_s *v);
+void str_view_copy(const struct str_view_s *v, char *buf, u32 size);
+
+#endif
@@ -21,13 +21,14 @@
 #include "nprobe_fprintf.h"
 #include "event.h"
 #include "system_cpu.h"
+#include "proc_file.h"
 
 #define METRICS_CPU_NAME            "system_cpu"
 #define METRICS_CPU_UTIL_NAME       "system_cpu_util"
 #define ENTITY_NAME                 "cpu"
-#define SYSTEM_PROCESSOR_INFO       "cat /proc/softirqs | grep -E '\\sRCU:\\s|\\sTIMER:\\s|\\sSCHED:\\s|\\sNET_RX:\\s'"
+#define SYSTEM_SOFTIRQS             "softirqs"
 #define SYSTEM_PROC_STAT_PATH       "/proc/stat"
-#define SYSTEM_CPU_MHZ_INFO         "cat /proc/cpuinfo | grep MHz"
+#define SYSTEM_CPUINFO              "cpuinfo"
 #define SOFTNET_STAT_PATH           "/proc/net/softnet_stat"
 #define PROC_STAT_FILEDS_NUM        6
 #define PROC_STAT_COL_NUM           8
@@ -38,7 +39,6 @@
 #define BASE_HEX                    16
 #define MAX_CPU_NUM                 1024
 #define FULL_PER                    100
-#define MAX_COL_NUM                 20
 
 static struct cpu_stat **cur_cpus = NULL;
 static struct cpu_stat **old_cpus = NULL;
@@ -46,8 +46,8 @@ static int cpus_num = 0;
 static bool is_first_get = true;
 static u64 last_time_total, cur_time_total, last_time_used, cur_time_used;
 static float util_per;
-static int softirq_line_num = 0;
-char *softirq_line = NULL;
+static struct proc_file_s softirqs_file = PROC_FILE_INITIALIZER;
+static struct proc_file_s cpuinfo_file = PROC_FILE_INITIALIZER;
 
 /*
  * time_total = user + nice + sys + irq + softirq + steal + idle + iowait (前8列)
@@ -173,38 +173,45 @@ static int get_proc_stat_info(void)
     return 0;
 }
 
+static u64 *get_softirq_counter(struct cpu_stat *cpu, const struct str_view_s *name)
+{
+    if (str_view_eq(name, "RCU:")) {
+        return &cpu->rcu;
+    } else if (str_view_eq(name, "TIMER:")) {
+        return &cpu->timer;
+    } else if (str_view_eq(name, "SCHED:")) {
+        return &cpu->sched;
+    } else if (str_view_eq(name, "NET_RX:")) {
+        return &cpu->net_rx;
+    }
+    return NULL;
+}
+
+/*
+ * [root@localhost ~]# cat /proc/softirqs
+ *                     CPU0       CPU1
+ *           HI:          0          0
+ *        TIMER:    1227466    1167155
+ */
 static int get_softirq_info(void)
 {
-    FILE *f = NULL;
-    char *field, *save;
+    struct proc_tok_s tok, line;
+    struct str_view_s name, value;
 
-    softirq_line[0] = 0;
-    f = popen(SYSTEM_PROCESSOR_INFO, "r");
-    if (f == NULL) {
+    if (read_proc_file(&softirqs_file)) {
         return -1;
     }
-    while (fgets(softirq_line, softirq_line_num - 1, f) != NULL) {
-        field = __strtok_r(softirq_line, " ", &save);
-        if (strcmp(field, "RCU:") == 0) {
-            for (size_t i = 0; i < cpus_num; i++) {
-                cur_cpus[i]->rcu = atoll(__strtok_r(NULL, " ", &save));
-            }
-        } else if (strcmp(field, "TIMER:") == 0) {
-            for (size_t i = 0; i < cpus_num; i++) {
-                cur_cpus[i]->timer = atoll(__strtok_r(NULL, " ", &save));
-            }
-        } else if (strcmp(field, "SCHED:") == 0) {
-            for (size_t i = 0; i < cpus_num; i++) {
-                cur_cpus[i]->sched = atoll(__strtok_r(NULL, " ", &save));
-            }
-        } else if (strcmp(field, "NET_RX:") == 0) {
-            for (size_t i = 0; i < cpus_num; i++) {
-                cur_cpus[i]->net_rx = atoll(__strtok_r(NULL, " ", &save));
-            }
+
+    proc_file_tok(&softirqs_file, &tok);
+    (void)proc_tok_line(&tok, &line);   // filter out the title line
+    while (proc_tok_line(&tok, &line) == 0) {
+        if (proc_tok_next(&line, &name) || get_softirq_counter(cur_cpus[0], &name) == NULL) {
+            continue;
+        }
+        for (int i = 0; i < cpus_num && proc_tok_next(&line, &value) == 0; i++) {
+            *get_softirq_counter(cur_cpus[i], &name) = str_view_to_u64(&value);
         }
-        softirq_line[0] = 0;
     }
-    pclose(f);
     return 0;
 }
 
@@ -245,30 +252,31 @@ static int get_softnet_stat_info(void)
 
 static int get_cpu_mhz_info(void)
 {
-    FILE *f = NULL;
-    char line[LINE_BUF_LEN];
-    char *token, *last_token;
+    int index = 0;
+    const char *sep;
+    struct proc_tok_s tok, line;
+    struct str_view_s key, value;
 
-    f = popen(SYSTEM_CPU_MHZ_INFO, "r");
-    if (f == NULL) {
+    if (read_proc_file(&cpuinfo_file)) {
         return -1;
     }
-    int index = 0;
-    line[0] = 0;
-    while (fgets(line, LINE_BUF_LEN, f) != NULL) {
-        last_token = NULL;
-        token = strtok(line, ":");
-        while (token != NULL) {
-            last_token = token;
-            token = strtok(NULL, ":");
+
+    proc_file_tok(&cpuinfo_file, &tok);
+    while (proc_tok_line(&tok, &line) == 0 && index < cpus_num) {
+        sep = memchr(line.cur, ':', (size_t)(line.end - line.cur));
+        if (sep == NULL) {
+            continue;
         }
-        if (last_token != NULL && index < cpus_num) {
-            cur_cpus[index]->mhz = atof(last_token);
-            index++;
+        key.str = line.cur;
+        key.len = (u32)(sep - line.cur);
+        line.cur = sep + 1;
+        if (!str_view_contains(&key, "MHz") || proc_tok_next(&line, &value)) {
+            continue;
         }
+        // the value is followed by a blank, '\n' or the terminating NUL of the buffer
+        cur_cpus[index]->mhz = strtof(value.str, NULL);
+        index++;
     }
-
-    pclose(f);
     return 0;
 }
 
@@ -332,7 +340,7 @@ static u64 jiffies_to_msecs(u64 j)
 int system_cpu_init(void)
 {
     cpus_num = (int)sysconf(_SC_NPROCESSORS_CONF);
-    if (cpus_num < 0 || cpus_num > MAX_CPU_NUM) {
+    if (cpus_num <= 0 || cpus_num > MAX_CPU_NUM) {
         ERROR("[SYSTEM_PROBE] sysconf to read the number of cpus error\n");
         return -1;
     }
@@ -350,19 +358,24 @@ int system_cpu_init(void)
         }
         return -1;
     }
-    softirq_line_num = MAX_COL_NUM * (1 + cpus_num);
-    softirq_line = (char*)malloc(softirq_line_num);
+    if (init_proc_file(&softirqs_file, SYSTEM_SOFTIRQS) || init_proc_file(&cpuinfo_file, SYSTEM_CPUINFO)) {
+        ERROR("[SYSTEM_PROBE] fail to open softirqs or cpuinfo\n");
+        system_cpu_destroy();
+        return -1;
+    }
     return 0;
 }
 
 void system_cpu_destroy(void)
 {
-    dealloc_memory(cur_cpus);
-    dealloc_memory(old_cpus);
-    if (softirq_line != NULL) {
-        free(softirq_line);
-        softirq_line = NULL;
+    if (cur_cpus != NULL) {
+        dealloc_memory(cur_cpus);
+    }
+    if (old_cpus != NULL) {
+        dealloc_memory(old_cpus);
     }
+    free_proc_file(&softirqs_file);
+    free_proc_file(&cpuinfo_file);
     cur_cpus = NULL;
     old_cpus = NULL;
 }
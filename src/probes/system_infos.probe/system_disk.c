@@ -16,77 +16,145 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/vfs.h>
 #include "event.h"
 #include "nprobe_fprintf.h"
 #include "system_disk.h"
+#include "proc_file.h"
 
 #define METRICS_DF_NAME         "system_df"
 #define METRICS_IOSTAT_NAME     "system_iostat"
 #define ENTITY_FS_NAME          "fs"
 #define ENTITY_DISK_NAME        "disk"
-#define SYSTEM_INODE_COMMAND    "/usr/bin/df -T -i"
-#define SYSTEM_BLOCK_CMD        "/usr/bin/df -T"
-#define SYSTEM_MOUNT_STAT_CMD   "cat /proc/mounts"
-#define SYSTEM_DISKSTATS        "/proc/diskstats"
-#define SYSTEM_DISKSTATS_CMD    "/usr/bin/cat /proc/diskstats"
-#define SYSTEM_DISK_DEV_NUM     "/usr/bin/cat /proc/diskstats | wc -l"
+#define SYSTEM_MOUNTINFO        "self/mountinfo"
+#define SYSTEM_DISKSTATS        "diskstats"
+#define FULL_PER                100
 
 static df_stats *g_df_tbl = NULL;
-
-#define DF_INODE_FIELD_NUM 7
-static int get_df_inode_fields(char *line, df_stats *stats)
+static struct proc_file_s g_mountinfo_file = PROC_FILE_INITIALIZER;
+static struct proc_file_s g_diskstats_file = PROC_FILE_INITIALIZER;
+
+struct mount_info_s {
+    char dev[MOUNTDEV_LEN];
+    char mount_on[PATH_LEN];
+    char mount_status[MOUNTSTATUS_LEN];
+    char fstype[FSTYPE_LEN];
+    char fsname[FSTYPE_LEN];
+};
+
+/* same as the dummy file systems of df, which are not shown without '-a' */
+static const char *g_dummy_fstypes[] = {
+    "autofs", "proc", "subfs", "debugfs", "devpts", "fusectl", "mqueue", "rpc_pipefs", "sysfs", "devfs", "kernfs",
+    "ignore"
+};
+
+static char is_dummy_fs(const char *fstype)
 {
-    int ret;
-
-    ret = sscanf(line, "%s %s %ld %ld %ld %ld%*s %s",
-        &stats->fsname, &stats->fstype, &stats->inode_sum, &stats->inode_used,
-        &stats->inode_free, &stats->inode_used_per, &stats->mount_on);
-    if (ret < DF_INODE_FIELD_NUM) {
-        DEBUG("[SYSTEM_DISK] get df stats fields fail.\n");
-        return -1;
+    for (int i = 0; i < sizeof(g_dummy_fstypes) / sizeof(g_dummy_fstypes[0]); i++) {
+        if (strcmp(fstype, g_dummy_fstypes[i]) == 0) {
+            return 1;
+        }
     }
     return 0;
 }
 
-#define DF_BLOCK_FIELD_NUM 5
-static int get_df_block_fields(char *line, df_stats *stats)
+/* space, tab, newline and backslash are escaped as '\ooo' in mountinfo */
+static void unescape_mount_field(const struct str_view_s *field, char *buf, u32 size)
 {
-    int ret;
-
-    ret = sscanf(line, "%*s %*s %ld %ld %ld %ld%*s %s",
-        &stats->blk_sum, &stats->blk_used,
-        &stats->blk_free, &stats->blk_used_per, &stats->mount_on);
-    if (ret < DF_BLOCK_FIELD_NUM) {
-        DEBUG("[SYSTEM_DISK] get df stats fields fail.\n");
-        return -1;
+    u32 i = 0, len = 0;
+    const char *s = field->str;
+
+    while (i < field->len && len < size - 1) {
+        if (s[i] == '\\' && i + 3 < field->len &&
+            s[i + 1] >= '0' && s[i + 1] <= '3' && s[i + 2] >= '0' && s[i + 2] <= '7' &&
+            s[i + 3] >= '0' && s[i + 3] <= '7') {
+            buf[len++] = (char)(((s[i + 1] - '0') << 6) | ((s[i + 2] - '0') << 3) | (s[i + 3] - '0'));
+            i += 4;
+            continue;
+        }
+        buf[len++] = s[i++];
     }
-    return 0;
+    buf[len] = 0;
 }
 
-#define MNT_FIELD_NUM 2
-static int get_fs_mount_status(char *line, char mountOn[MOUNTON_LEN], char mountStatus[MOUNTSTATUS_LEN])
+/*
+ [root@localhost ~]# cat /proc/self/mountinfo
+ 22 1 253:0 / / rw,relatime shared:1 - xfs /dev/mapper/openeuler-root rw,attr2,inode64,noquota
+         2    4 5           6...     - 7   8
+ */
+static int get_mount_info(struct proc_tok_s *line, struct mount_info_s *mnt)
 {
-    int ret;
-    char buf[LINE_BUF_LEN];
-    char *firstComma;
+    struct str_view_s field;
+    const char *comma;
 
-    buf[0] = 0;
-    ret = sscanf(line, "%*s %s %*s %s", mountOn, buf);
-    if (ret < MNT_FIELD_NUM) {
-        DEBUG("[SYSTEM_DISK] get fs mount status fail.\n");
+    if (proc_tok_skip(line, 2) || proc_tok_next(line, &field)) {
+        return -1;
+    }
+    str_view_copy(&field, mnt->dev, sizeof(mnt->dev));
+    if (proc_tok_skip(line, 1) || proc_tok_next(line, &field)) {
         return -1;
     }
+    unescape_mount_field(&field, mnt->mount_on, sizeof(mnt->mount_on));
+    if (proc_tok_next(line, &field)) {
+        return -1;
+    }
+    comma = memchr(field.str, ',', field.len);
+    if (comma != NULL) {
+        field.len = (u32)(comma - field.str);
+    }
+    str_view_copy(&field, mnt->mount_status, sizeof(mnt->mount_status));
 
-    firstComma = strchr(buf, ',');
-    if (!firstComma) {
-        DEBUG("[SYSTEM_DISK] get fs mount status fail.\n");
+    // optional fields end with a single '-'
+    do {
+        if (proc_tok_next(line, &field)) {
+            return -1;
+        }
+    } while (!str_view_eq(&field, "-"));
+
+    if (proc_tok_next(line, &field)) {
         return -1;
     }
-    *firstComma = '\0';
-    (void)snprintf(mountStatus, MOUNTSTATUS_LEN, "%s", buf);
+    str_view_copy(&field, mnt->fstype, sizeof(mnt->fstype));
+    if (proc_tok_next(line, &field)) {
+        return -1;
+    }
+    unescape_mount_field(&field, mnt->fsname, sizeof(mnt->fsname));
     return 0;
 }
 
+/* df rounds the percentage up */
+static long get_used_per(u64 used, u64 avail)
+{
+    u64 total = used + avail;
+
+    if (total == 0) {
+        return 0;
+    }
+    return (long)((used * FULL_PER + total - 1) / total);
+}
+
+static void set_df_stats(df_stats *fsItem, const struct mount_info_s *mnt, const struct statfs *sfs)
+{
+    u64 bsize = (sfs->f_frsize != 0) ? (u64)sfs->f_frsize : (u64)sfs->f_bsize;
+    u64 blk_used = (u64)(sfs->f_blocks - sfs->f_bfree);
+
+    (void)snprintf(fsItem->dev, sizeof(fsItem->dev), "%s", mnt->dev);
+    (void)snprintf(fsItem->fsname, sizeof(fsItem->fsname), "%s", mnt->fsname);
+    (void)snprintf(fsItem->fstype, sizeof(fsItem->fstype), "%s", mnt->fstype);
+    (void)snprintf(fsItem->mount_status, sizeof(fsItem->mount_status), "%s", mnt->mount_status);
+
+    fsItem->inode_sum = (long)sfs->f_files;
+    fsItem->inode_free = (long)sfs->f_ffree;
+    fsItem->inode_used = (long)(sfs->f_files - sfs->f_ffree);
+    fsItem->inode_used_per = get_used_per((u64)fsItem->inode_used, (u64)sfs->f_ffree);
+
+    // in 1K-blocks as df does
+    fsItem->blk_sum = (long)((sfs->f_blocks * bsize + 1023) / 1024);
+    fsItem->blk_used = (long)((blk_used * bsize + 1023) / 1024);
+    fsItem->blk_free = (long)((sfs->f_bavail * bsize + 1023) / 1024);
+    fsItem->blk_used_per = get_used_per(blk_used, (u64)sfs->f_bavail);
+}
+
 static void report_disk_status(df_stats *fsItem, struct ipc_body_s *ipc_body)
 {
     char entityid[LINE_BUF_LEN];
@@ -125,145 +193,60 @@ static void report_disk_status(df_stats *fsItem, struct ipc_body_s *ipc_body)
     }
 }
 
-static int init_fs_inode_info(void)
+static int init_fs_infos(void)
 {
-    FILE *f = NULL;
-    char line[LINE_BUF_LEN];
-    int is_first_line = 1;
-    df_stats *fsItem;
-    df_stats stats;
-
-    f = popen(SYSTEM_INODE_COMMAND, "r");
-    if (f == NULL) {
+    struct proc_tok_s tok, line;
+    struct mount_info_s mnt;
+    struct statfs sfs;
+    df_stats *fsItem, *dup;
+    df_stats *dev_tbl = NULL;
+
+    if (read_proc_file(&g_mountinfo_file)) {
         return -1;
     }
 
-    while (!feof(f)) {
-        line[0] = 0;
-        if (fgets(line, LINE_BUF_LEN, f) == NULL) {
-            break;
+    proc_file_tok(&g_mountinfo_file, &tok);
+    while (proc_tok_line(&tok, &line) == 0) {
+        if (get_mount_info(&line, &mnt) || is_dummy_fs(mnt.fstype)) {
+            continue;
         }
-        if (is_first_line) {
-            is_first_line = 0;
+        if (statfs(mnt.mount_on, &sfs) || sfs.f_blocks == 0) {
             continue;
         }
-        SPLIT_NEWLINE_SYMBOL(line);
 
-        if (get_df_inode_fields(line, &stats)) {
-            continue;
+        // df shows one mount for each device, the one with the shortest mount point
+        dup = NULL;
+        HASH_FIND(dev_hh, dev_tbl, mnt.dev, strlen(mnt.dev), dup);
+        if (dup != NULL) {
+            if (strlen(dup->mount_on) <= strnlen(mnt.mount_on, MOUNTON_LEN - 1)) {
+                continue;
+            }
+            HASH_DELETE(dev_hh, dev_tbl, dup);
+            dup->valid = 0;
         }
 
         fsItem = NULL;
-        HASH_FIND_STR(g_df_tbl, stats.mount_on, fsItem);
+        mnt.mount_on[MOUNTON_LEN - 1] = 0;
+        HASH_FIND_STR(g_df_tbl, mnt.mount_on, fsItem);
         if (!fsItem) {
             fsItem = (df_stats *)calloc(1, sizeof(df_stats));
             if (!fsItem) {
                 DEBUG("[SYSTEM_DISK] failed to malloc memory.\n");
-                (void)pclose(f);
-                return -1;
+                break;
             }
-            strcpy(fsItem->mount_on, stats.mount_on);
+            (void)strcpy(fsItem->mount_on, mnt.mount_on);
             HASH_ADD_STR(g_df_tbl, mount_on, fsItem);
+        } else if (fsItem->valid) {
+            // over-mounted, the last one is visible
+            HASH_DELETE(dev_hh, dev_tbl, fsItem);
         }
+        set_df_stats(fsItem, &mnt, &sfs);
         fsItem->valid = 1;
-        strcpy(fsItem->fsname, stats.fsname);
-        strcpy(fsItem->fstype, stats.fstype);
-        fsItem->inode_sum = stats.inode_sum;
-        fsItem->inode_used = stats.inode_used;
-        fsItem->inode_free = stats.inode_free;
-        fsItem->inode_used_per = stats.inode_used_per;
-        fsItem->blk_sum = 0;
-        fsItem->blk_used = 0;
-        fsItem->blk_free = 0;
-        fsItem->blk_used_per = 0;
-        fsItem->mount_status[0] = 0;
-    }
-
-    (void)pclose(f);
-    return 0;
-}
-
-static int init_fs_block_info(void)
-{
-    FILE *f = NULL;
-    char line[LINE_BUF_LEN];
-    int is_first_line = 1;
-    df_stats *fsItem;
-    df_stats stats;
-
-    f = popen(SYSTEM_BLOCK_CMD, "r");
-    if (f == NULL) {
-        return -1;
-    }
-
-    while (!feof(f)) {
-        line[0] = 0;
-        if (fgets(line, LINE_BUF_LEN, f) == NULL) {
-            break;
-        }
-        if (is_first_line) {
-            is_first_line = 0;
-            continue;
-        }
-        SPLIT_NEWLINE_SYMBOL(line);
-
-        if (get_df_block_fields(line, &stats)) {
-            continue;
-        }
-
-        fsItem = NULL;
-        HASH_FIND_STR(g_df_tbl, stats.mount_on, fsItem);
-        if (!fsItem || !fsItem->valid) {
-            continue;
-        }
-        fsItem->blk_sum = stats.blk_sum;
-        fsItem->blk_used = stats.blk_used;
-        fsItem->blk_free = stats.blk_free;
-        fsItem->blk_used_per = stats.blk_used_per;
+        HASH_ADD(dev_hh, dev_tbl, dev, strlen(fsItem->dev), fsItem);
     }
 
-    (void)pclose(f);
+    HASH_CLEAR(dev_hh, dev_tbl);
     return 0;
-
-}
-
-static int init_fs_status(void)
-{
-    FILE *f = NULL;
-    df_stats *fsItem;
-    char line[LINE_BUF_LEN];
-    char mountOn[MOUNTON_LEN];
-    char mountStatus[MOUNTSTATUS_LEN];
-
-    f = popen(SYSTEM_MOUNT_STAT_CMD, "r");
-    if (f == NULL) {
-        return -1;
-    }
-
-    while (!feof(f)) {
-        line[0] = 0;
-        if (fgets(line, LINE_BUF_LEN, f) == NULL) {
-            break;
-        }
-        SPLIT_NEWLINE_SYMBOL(line);
-
-        mountOn[0] = 0;
-        mountStatus[0] = 0;
-        if (get_fs_mount_status(line, mountOn, mountStatus)) {
-            continue;
-        }
-
-        fsItem = NULL;
-        HASH_FIND_STR(g_df_tbl, mountOn, fsItem);
-        if (!fsItem || !fsItem->valid) {
-            continue;
-        }
-        (void)strcpy(fsItem->mount_status, mountStatus);
-    }
-
-    (void)pclose(f);
-    return 0;
-
 }
 
 int system_disk_probe(struct ipc_body_s *ipc_body)
@@ -271,15 +254,7 @@ int system_disk_probe(struct ipc_body_s *ipc_body)
     df_stats *fsItem, *tmp;
     int ret;
 
-    ret = init_fs_inode_info();
-    if (ret) {
-        return -1;
-    }
-    ret = init_fs_block_info();
-    if (ret) {
-        return -1;
-    }
-    ret = init_fs_status();
+    ret = init_fs_infos();
     if (ret) {
         return -1;
     }
@@ -314,19 +289,42 @@ int system_disk_probe(struct ipc_body_s *ipc_body)
     return 0;
 }
 
-#define DISKSTAT_FIELD_NUM      9
-static int get_diskstats_fields(const char *line, disk_stats *stats)
+enum diskstat_field_t {
+    DISKSTAT_NAME = 2,
+    DISKSTAT_RD_IOS,
+    DISKSTAT_RD_MERGES,
+    DISKSTAT_RD_SECTORS,
+    DISKSTAT_RD_TICKS,
+    DISKSTAT_WR_IOS,
+    DISKSTAT_WR_MERGES,
+    DISKSTAT_WR_SECTORS,
+    DISKSTAT_WR_TICKS,
+    DISKSTAT_IN_FLIGHT,
+    DISKSTAT_IO_TICKS,
+    DISKSTAT_TIME_IN_QUEUE,
+
+    DISKSTAT_FIELD_NUM
+};
+
+static int get_diskstats_fields(struct proc_tok_s *line, disk_stats *stats)
 {
-    int ret;
+    struct str_view_s fields[DISKSTAT_FIELD_NUM];
 
-    ret = sscanf(line,
-        "%*Lu %*Lu %s %lu %*Lu %lu %u %lu %*Lu %lu %u %*Lu %u %u %*Lu %*Lu %*Lu %*Lu",
-        &stats->disk_name, &stats->rd_ios, &stats->rd_sectors, &stats->rd_ticks,
-        &stats->wr_ios, &stats->wr_sectors, &stats->wr_ticks, &stats->io_ticks, &stats->time_in_queue);
-    if (ret < DISKSTAT_FIELD_NUM) {
-        DEBUG("[SYSTEM_DISK] get disk stats fields fail.\n");
-        return -1;
+    for (int i = 0; i < DISKSTAT_FIELD_NUM; i++) {
+        if (proc_tok_next(line, &fields[i])) {
+            DEBUG("[SYSTEM_DISK] get disk stats fields fail.\n");
+            return -1;
+        }
     }
+    str_view_copy(&fields[DISKSTAT_NAME], stats->disk_name, sizeof(stats->disk_name));
+    stats->rd_ios = (u32)str_view_to_u64(&fields[DISKSTAT_RD_IOS]);
+    stats->rd_sectors = (u32)str_view_to_u64(&fields[DISKSTAT_RD_SECTORS]);
+    stats->rd_ticks = (u32)str_view_to_u64(&fields[DISKSTAT_RD_TICKS]);
+    stats->wr_ios = (u32)str_view_to_u64(&fields[DISKSTAT_WR_IOS]);
+    stats->wr_sectors = (u32)str_view_to_u64(&fields[DISKSTAT_WR_SECTORS]);
+    stats->wr_ticks = (u32)str_view_to_u64(&fields[DISKSTAT_WR_TICKS]);
+    stats->io_ticks = (u32)str_view_to_u64(&fields[DISKSTAT_IO_TICKS]);
+    stats->time_in_queue = (u32)str_view_to_u64(&fields[DISKSTAT_TIME_IN_QUEUE]);
     return 0;
 }
 
@@ -400,30 +398,25 @@ static int g_first_flag;
 
 int system_iostat_probe(struct ipc_body_s *ipc_body)
 {
-    FILE *f = NULL;
-    char line[LINE_BUF_LEN];
+    struct proc_tok_s tok, line;
     disk_stats temp;
     disk_io_stats io_datas;
     int index;
 
-    f = popen(SYSTEM_DISKSTATS_CMD, "r");
-    if (f == NULL) {
+    if (read_proc_file(&g_diskstats_file)) {
         return -1;
     }
 
     index = 0;
-    while (!feof(f) && index < g_disk_dev_num) {
-        line[0] = 0;
-        if (fgets(line, LINE_BUF_LEN, f) == NULL) {
-            (void)pclose(f);
-            return -1;
-        }
+    proc_file_tok(&g_diskstats_file, &tok);
+    while (index < g_disk_dev_num && proc_tok_line(&tok, &line) == 0) {
         (void)memcpy(&temp, &g_disk_stats[index], sizeof(disk_stats));
-        if (get_diskstats_fields(line, &g_disk_stats[index]) < 0) {
+        if (get_diskstats_fields(&line, &g_disk_stats[index]) < 0) {
             continue;
         }
 
-        if (g_first_flag == 1) {
+        // devices may be added or removed since last period
+        if (g_first_flag == 1 || strcmp(temp.disk_name, g_disk_stats[index].disk_name) != 0) {
             (void)memset(&io_datas, 0, sizeof(disk_io_stats));
         } else {
             cal_disk_io_stats(&temp, &g_disk_stats[index], &io_datas, ipc_body->probe_param.period);
@@ -449,38 +442,23 @@ int system_iostat_probe(struct ipc_body_s *ipc_body)
         index++;
     }
     g_first_flag = 0;
-    (void)pclose(f);
     return 0;
 }
 
-static int get_diskdev_num(int *num)
+int system_iostat_init(void)
 {
-    FILE *f = NULL;
-    char line[LINE_BUF_LEN];
-
-    f = popen(SYSTEM_DISK_DEV_NUM, "r");
-    if (f == NULL) {
-        return -1;
-    }
-    line[0] = 0;
-    if (fgets(line, LINE_BUF_LEN, f) == NULL) {
-        (void)pclose(f);
+    if (init_proc_file(&g_diskstats_file, SYSTEM_DISKSTATS) || read_proc_file(&g_diskstats_file)) {
+        free_proc_file(&g_diskstats_file);
         return -1;
     }
-    SPLIT_NEWLINE_SYMBOL(line);
-    *num = atoi(line);
-    (void)pclose(f);
-    return 0;
-}
-
-int system_iostat_init(void)
-{
-    int ret = get_diskdev_num(&g_disk_dev_num);
-    if (ret < 0 || g_disk_dev_num <= 0) {
+    g_disk_dev_num = (int)proc_file_line_num(&g_diskstats_file);
+    if (g_disk_dev_num <= 0) {
+        free_proc_file(&g_diskstats_file);
         return -1;
     }
     g_disk_stats = malloc(g_disk_dev_num * sizeof(disk_stats));
     if (g_disk_stats == NULL) {
+        free_proc_file(&g_diskstats_file);
         return -1;
     }
     (void)memset(g_disk_stats, 0, g_disk_dev_num * sizeof(disk_stats));
@@ -490,6 +468,11 @@ int system_iostat_init(void)
     return 0;
 }
 
+int system_disk_init(void)
+{
+    return init_proc_file(&g_mountinfo_file, SYSTEM_MOUNTINFO);
+}
+
 void system_disk_destroy(void)
 {
     df_stats *item, *tmp;
@@ -500,6 +483,7 @@ void system_disk_destroy(void)
             free(item);
         }
     }
+    free_proc_file(&g_mountinfo_file);
 
     return;
 }
@@ -510,4 +494,5 @@ void system_iostat_destroy(void)
         (void)free(g_disk_stats);
         g_disk_stats = NULL;
     }
+    free_proc_file(&g_diskstats_file);
 }
\ No newline at end of file
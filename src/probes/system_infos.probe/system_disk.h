@@ -27,11 +27,13 @@
 #define FSTYPE_LEN  64
 #define MOUNTON_LEN 128
 #define MOUNTSTATUS_LEN 8
+#define MOUNTDEV_LEN 16
 typedef struct {
     char fsname[FSTYPE_LEN];
     char fstype[FSTYPE_LEN];
     char mount_on[MOUNTON_LEN];
     char mount_status[MOUNTSTATUS_LEN];
+    char dev[MOUNTDEV_LEN];     // major:minor
     long inode_sum;
     long inode_used;
     long inode_free;
@@ -42,6 +44,7 @@ typedef struct {
     long blk_used_per;
     char valid;
     UT_hash_handle hh;
+    UT_hash_handle dev_hh;
 } df_stats;
 
 typedef struct {
@@ -81,6 +84,7 @@ typedef struct {
 int system_disk_probe(struct ipc_body_s *ipc_body);
 int system_iostat_probe(struct ipc_body_s *ipc_body);
 int system_iostat_init(void);
+int system_disk_init(void);
 void system_disk_destroy(void);
 void system_iostat_destroy(void);
 
@@ -45,6 +45,11 @@ static int system_probe_init(void)
         return -1;
     }
 
+    /* system disk init */
+    if (system_disk_init() < 0) {
+        return -1;
+    }
+
     /* system_iostat init */
     if (system_iostat_init() < 0) {
         return -1;
@@ -20,14 +20,16 @@
 #include "event.h"
 #include "nprobe_fprintf.h"
 #include "system_meminfo.h"
+#include "proc_file.h"
 
 #define METRICS_MEMINFO_NAME "system_meminfo"
 #define METRICS_MEMINFO_PATH "/proc/meminfo"
 #define METRTCS_DENTRY_NAME  "system_dentry"
 #define METRICS_DENTRY_ORIGIN  "fs.dentry-state"
-#define SYSTEM_FS_DENTRY_STATE "cat /proc/sys/fs/dentry-state"
+#define SYSTEM_FS_DENTRY_STATE "sys/fs/dentry-state"
 static struct system_meminfo_field* meminfo_fields = NULL;
 static struct dentry_stat dentry_state = {0};
+static struct proc_file_s dentry_state_file = PROC_FILE_INITIALIZER;
 
 int system_meminfo_init(void)
 {
@@ -43,6 +45,10 @@ int system_meminfo_init(void)
         strcpy(meminfo_fields[i].key, key_[i]);
         meminfo_fields[i].value = 0;
     }
+    if (init_proc_file(&dentry_state_file, SYSTEM_FS_DENTRY_STATE)) {
+        system_meminfo_destroy();
+        return -1;
+    }
     return 0;
 }
 
@@ -53,6 +59,7 @@ void system_meminfo_destroy(void)
         (void)free(meminfo_fields);
         meminfo_fields = NULL;
     }
+    free_proc_file(&dentry_state_file);
 }
 
 // get key & value from the line text, and assign to the target key.
@@ -181,26 +188,23 @@ static int get_meminfo(struct ipc_body_s *ipc_body)
 #define DENTRY_STATE_VALID_FIELD_NUM    3
 static int get_dentry_state(void)
 {
-    FILE *f = NULL;
-    char line[LINE_BUF_LEN];
+    struct proc_tok_s tok;
+    struct str_view_s fields[DENTRY_STATE_VALID_FIELD_NUM];
 
-    f = popen(SYSTEM_FS_DENTRY_STATE, "r");
-    if (f == NULL) {
+    if (read_proc_file(&dentry_state_file)) {
         return -1;
     }
-    line[0] = 0;
-    if (fgets(line, LINE_BUF_LEN, f) == NULL) {
-        pclose(f);
-        return -1;
-    }
-    SPLIT_NEWLINE_SYMBOL(line);
-    int ret = sscanf(line, "%d %d %d %*d %*d %*d",
-        &dentry_state.dentry, &dentry_state.unused, &dentry_state.age_limit);
-    if (ret < DENTRY_STATE_VALID_FIELD_NUM) {
-        DEBUG("[SYSTEM_PROBE] get dentry_state fields fail.\n");
-        pclose(f);
-        return -1;
+    proc_file_tok(&dentry_state_file, &tok);
+    for (int i = 0; i < DENTRY_STATE_VALID_FIELD_NUM; i++) {
+        if (proc_tok_next(&tok, &fields[i])) {
+            DEBUG("[SYSTEM_PROBE] get dentry_state fields fail.\n");
+            return -1;
+        }
     }
+    dentry_state.dentry = (int)str_view_to_u64(&fields[0]);
+    dentry_state.unused = (int)str_view_to_u64(&fields[1]);
+    dentry_state.age_limit = (int)str_view_to_u64(&fields[2]);
+
     // report data
     (void)nprobe_fprintf(stdout, "|%s|%s|%d|%d|%d|\n",
         METRTCS_DENTRY_NAME,
@@ -209,7 +213,6 @@ static int get_dentry_state(void)
         dentry_state.unused,
         dentry_state.age_limit);
 
-    pclose(f);
     return 0;
 }
 
@@ -24,21 +24,22 @@
 #include "nprobe_fprintf.h"
 #include "system_procs.h"
 #include "java_support.h"
+#include "proc_file.h"
 
 #define METRICS_PROC_NAME   "system_proc"
-#define PROC_STAT           "/proc/%u/stat"
+#define PROC_STAT           "%u/stat"
 #define FULL_PER            100
 #define PROC_CMDLINE_CMD    "/proc/%u/cmdline"
 #define PROC_FD             "/proc/%u/fd"
 #define PROC_IO             "/proc/%u/io"
 #define PROC_SMAPS          "/proc/%u/smaps_rollup"
-#define PROC_ID_CMD         "ps -eo pid,ppid,pgid,comm | /usr/bin/awk '{if($1==\"%u\"){print $2 \"|\" $3}}'"
 #define PROC_CPUSET         "/proc/%u/cpuset"
 #define PROC_CPUSET_CMD     "/usr/bin/cat /proc/%u/cpuset 2>/dev/null | awk -F '/' '{print $NF}'"
 #define PROC_LIMIT          "/proc/%u/limits"
 
 static proc_hash_t *g_procmap = NULL;
 static proc_info_t g_pre_proc_info;
+static struct proc_file_s g_proc_stat_file = PROC_FILE_INITIALIZER;
 
 static void hash_add_proc(proc_hash_t *one_proc)
 {
@@ -46,13 +47,13 @@ static void hash_add_proc(proc_hash_t *one_proc)
     return;
 }
 
-static proc_hash_t *hash_find_proc(u32 pid, const char *stime)
+static proc_hash_t *hash_find_proc(u32 pid, u64 start_time)
 {
     proc_hash_t *p = NULL;
     proc_hash_t temp = {0};
 
     temp.key.pid = pid;
-    temp.key.start_time = (u64)atoll(stime);
+    temp.key.start_time = start_time;
     HASH_FIND(hh, g_procmap, &temp.key, sizeof(proc_key_t), p);
 
     return p;
@@ -110,40 +111,6 @@ static inline int is_proc_subdir(const char *d_name)
     return -1;
 }
 
-static void get_proc_id(u32 pid, proc_info_t *proc_info)
-{
-    FILE *f = NULL;
-    char cmd[LINE_BUF_LEN];
-    char line[LINE_BUF_LEN];
-
-    if (strlen(proc_info->comm) == 0) {
-        /* comm is NULL, return */
-        return;
-    }
-
-    cmd[0] = 0;
-    (void)snprintf(cmd, LINE_BUF_LEN, PROC_ID_CMD, pid);
-    f = popen(cmd, "r");
-    if (f == NULL) {
-        goto out;
-    }
-    while (!feof(f)) {
-        line[0] = 0;
-        if (fgets(line, LINE_BUF_LEN, f) == NULL) {
-            goto out;
-        }
-        SPLIT_NEWLINE_SYMBOL(line);
-
-        (void)sscanf(line, "%d %*c %d", &proc_info->ppid, &proc_info->pgid);
-    }
-
-out:
-    if (f != NULL) {
-        pclose(f);
-    }
-    return;
-}
-
 int get_proc_cmdline(u32 pid, char *buf, u32 buf_len)
 {
     FILE *f = NULL;
@@ -278,11 +245,17 @@ static int get_proc_fdcnt(u32 pid, proc_info_t *proc_info)
     return 0;
 }
 
-static void do_set_proc_stat(proc_info_t *proc_info, char *buf, int index)
+static void do_set_proc_stat(proc_info_t *proc_info, const char *buf, int index)
 {
     u64 value = (u64)atoll(buf);
     switch (index)
     {
+        case PROC_STAT_PPID:
+            proc_info->ppid = (int)value;
+            break;
+        case PROC_STAT_PGRP:
+            proc_info->pgid = (int)value;
+            break;
         case PROC_STAT_MIN_FLT:
             proc_info->proc_stat_min_flt = value;
             break;
@@ -327,36 +300,43 @@ static void do_set_proc_stat(proc_info_t *proc_info, char *buf, int index)
     }
 }
 
-static int get_proc_stat(u32 pid, proc_info_t *proc_info)
+/*
+ * [root@localhost ~]# cat /proc/1/stat
+ * 1 (systemd) S 0 1 1 0 -1 4194560 106347 ...
+ * comm may contain spaces and ')', the fields after it start from the last ')'.
+ */
+int get_proc_stat(u32 pid, proc_info_t *proc_info)
 {
-    FILE *f = NULL;
-    char buffer[LINE_BUF_LEN];
-    char *p = NULL;
-    int index = 1;
-
-    f = get_proc_file(pid, PROC_STAT);
-    if (f == NULL) {
+    char name[PATH_LEN];
+    const char *lp, *rp;
+    struct proc_tok_s tok;
+    struct str_view_s field;
+    int index = PROC_STAT_STATE;
+
+    name[0] = 0;
+    (void)snprintf(name, sizeof(name), PROC_STAT, pid);
+    if (load_proc_file(&g_proc_stat_file, name)) {
         return -1;
     }
 
-    buffer[0] = 0;
-    if (fgets(buffer, sizeof(buffer), f) == NULL) {
-        (void)fclose(f);
+    lp = strchr(g_proc_stat_file.buf, '(');
+    rp = strrchr(g_proc_stat_file.buf, ')');
+    if (lp == NULL || rp == NULL || rp < lp) {
         return -1;
     }
-    SPLIT_NEWLINE_SYMBOL(buffer);
+    field.str = lp + 1;
+    field.len = (u32)(rp - lp - 1);
+    str_view_copy(&field, proc_info->comm, sizeof(proc_info->comm));
 
-    p = strtok(buffer, " \t");
-    while (p != NULL && index < PROC_STAT_MAX) {
-        do_set_proc_stat(proc_info, p, index);
-        p = strtok(NULL, " \t");
+    // fields end with a blank or the terminating NUL of the buffer
+    proc_tok_init(&tok, rp + 1, (u32)(g_proc_stat_file.buf + g_proc_stat_file.len - rp - 1));
+    while (index < PROC_STAT_MAX && proc_tok_next(&tok, &field) == 0) {
+        do_set_proc_stat(proc_info, field.str, index);
         index++;
     }
     if (index != PROC_STAT_MAX) {
         DEBUG("[SYSTEM_PROC] get proc stats incompletely, last position is:%d\n", index);
     }
-
-    (void)fclose(f);
     return 0;
 }
 
@@ -491,7 +471,7 @@ static int get_proc_mss(u32 pid, proc_info_t *proc_info)
         smap_index++;
     }
 out:
-    (void)pclose(f);
+    (void)fclose(f);
     return 0;
 }
 
@@ -570,21 +550,24 @@ static void output_proc_infos(proc_hash_t *one_proc)
     return;
 }
 
-static proc_hash_t* init_one_proc(u32 pid, char *stime, char *comm)
+static proc_hash_t* init_one_proc(u32 pid, const proc_info_t *stat_info)
 {
     int ret;
     proc_hash_t *item;
     struct java_property_s java_prop = {0};
 
     item = (proc_hash_t *)malloc(sizeof(proc_hash_t));
+    if (item == NULL) {
+        return NULL;
+    }
     (void)memset(item, 0, sizeof(proc_hash_t));
 
     item->key.pid = pid;
-    item->key.start_time = (u64)atoll(stime);
+    item->key.start_time = stat_info->proc_start_time;
 
-    (void)snprintf(item->info.comm, sizeof(item->info.comm), "%s", comm);
+    (void)memcpy(&item->info, stat_info, sizeof(proc_info_t));
     item->flag = PROC_IN_PROBE_RANGE;
-    if (strcmp(comm, "java") == 0) {
+    if (strcmp(item->info.comm, "java") == 0) {
         ret = get_java_property((int)item->key.pid, &java_prop);
         if (ret == 0) {
             (void)snprintf(item->info.cmdline, sizeof(item->info.cmdline), "%s", java_prop.mainClassName);
@@ -595,8 +578,6 @@ static proc_hash_t* init_one_proc(u32 pid, char *stime, char *comm)
 
     (void)get_proc_max_fdnum(pid, &item->info);
 
-    get_proc_id(pid, &item->info);
-
     (void)update_proc_infos(pid, &item->info);
 
     return item;
@@ -630,8 +611,7 @@ int system_proc_probe(struct ipc_body_s *ipc_body)
 int refresh_proc_filter_map(struct ipc_body_s *ipc_body)
 {
     u32 pid;
-    char comm[PROC_NAME_MAX];
-    char stime[PROC_NAME_MAX];
+    proc_info_t stat_info;
     proc_hash_t *item, *p;
 
     hash_clear_all_proc();
@@ -640,16 +620,19 @@ int refresh_proc_filter_map(struct ipc_body_s *ipc_body)
         if (ipc_body->snooper_objs[i].type != SNOOPER_OBJ_PROC) {
             continue;
         }
-        comm[0] = 0;
         pid = ipc_body->snooper_objs[i].obj.proc.proc_id;
-        (void)get_proc_comm(pid, comm, PROC_NAME_MAX);
-        stime[0] = 0;
-        (void)get_proc_start_time(pid, stime, PROC_NAME_MAX);
+        // comm, ppid, pgid and start time all come from one read of /proc/[PID]/stat
+        (void)memset(&stat_info, 0, sizeof(proc_info_t));
+        if (get_proc_stat(pid, &stat_info)) {
+            continue;
+        }
 
-        p = hash_find_proc(pid, stime);
+        p = hash_find_proc(pid, stat_info.proc_start_time);
         if (p == NULL) {
-            item = init_one_proc(pid, stime, comm);
-            hash_add_proc(item);
+            item = init_one_proc(pid, &stat_info);
+            if (item != NULL) {
+                hash_add_proc(item);
+            }
         }
     }
     return 0;
@@ -40,6 +40,9 @@ enum proc_io_e {
 };
 
 enum proc_stat_e {
+    PROC_STAT_STATE = 3,        // the first field after comm
+    PROC_STAT_PPID,
+    PROC_STAT_PGRP,
     PROC_STAT_MIN_FLT = 10,
     PROC_STAT_MAJ_FLT = 12,
     PROC_STAT_UTIME = 14,
@@ -120,6 +123,7 @@ typedef struct {
 } proc_hash_t;
 
 int system_proc_probe(struct ipc_body_s *ipc_body);
+int get_proc_stat(u32 pid, proc_info_t *proc_info);
 int refresh_proc_filter_map(struct ipc_body_s *ipc_body);
 
 #endif
@@ -473,6 +473,29 @@ static int IMDBMgrDatabaseLoad(IMDB_DataBaseMgr *imdbMgr, MeasurementMgr *mmMgr,
     return 0;
 }
 
+static int IMDBMgrCardLimitLoad(IMDB_DataBaseMgr *imdbMgr, const IMDBConfig *imdbConfig)
+{
+    IMDB_Table *table;
+    const CardLimitConfig *cardLimit;
+
+    for (int i = 0; i < imdbConfig->cardLimitsNum; i++) {
+        cardLimit = &imdbConfig->cardLimits[i];
+        table = IMDB_DataBaseMgrFindTable(imdbMgr, cardLimit->tableName);
+        if (table == NULL) {
+            WARN("[RESOURCE] cardinality limit of unknown table %s, skip it.\n", cardLimit->tableName);
+            continue;
+        }
+
+        if (IMDB_TableSetCardLimit(table, cardLimit->maxSeries, cardLimit->topK)) {
+            ERROR("[RESOURCE] set cardinality limit of table %s failed.\n", cardLimit->tableName);
+            return -1;
+        }
+        INFO("[RESOURCE] table %s keeps at most %u series exactly.\n", cardLimit->tableName, cardLimit->maxSeries);
+    }
+
+    return 0;
+}
+
 static int IMDBMgrInit(ResourceMgr *resourceMgr)
 {
     int ret = 0;
@@ -492,6 +515,12 @@ static int IMDBMgrInit(ResourceMgr *resourceMgr)
         return -1;
     }
 
+    ret = IMDBMgrCardLimitLoad(imdbMgr, configMgr->imdbConfig);
+    if (ret != 0) {
+        IMDB_DataBaseMgrDestroy(imdbMgr);
+        return -1;
+    }
+
     resourceMgr->imdbMgr = imdbMgr;
     return 0;
 }
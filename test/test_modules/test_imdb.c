@@ -32,10 +32,13 @@ static void TestIMDB_TableAddRecord(void);
 static void TestIMDB_DataBaseMgrFindTable(void);
 static void TestIMDB_DataBaseMgrAddRecord(void);
 static void TestIMDB_DataBaseMgrData2String(void);
+static void TestIMDB_DataBaseMgrHistogram2String(void);
 static void TestIMDB_RecordAppendKey(void);
 static void TestHASH_addRecord(void);
 static void TestHASH_deleteRecord(void);
 static void TestIMDB_TableSetRecordKeySize(void);
+static void TestIMDB_CardLimitAdmit(void);
+static void TestIMDB_TableCardLimit(void);
 #endif
 
 static void TestIMDB_MetricCreate(void)
@@ -311,6 +314,75 @@ static void TestIMDB_DataBaseMgrData2String(void)
     IMDB_DataBaseMgrDestroy(mgr);
 }
 
+static void TestIMDB_DataBaseMgrHistogram2String(void)
+{
+    int ret = 0;
+    IMDB_DataBaseMgr *mgr = IMDB_DataBaseMgrCreate(1024);
+    CU_ASSERT(mgr != NULL);
+
+    IMDB_Table *table = IMDB_TableCreate("table1", 1024);
+    CU_ASSERT(table != NULL);
+    IMDB_TableSetEntityName(table, "entity1");
+
+    IMDB_Record *meta = IMDB_RecordCreate(1024);
+    CU_ASSERT(meta != NULL);
+    IMDB_Metric *metric1 = IMDB_MetricCreate("metric1", "desc1", "key");
+    CU_ASSERT(metric1 != NULL);
+    ret = IMDB_RecordAddMetric(meta, metric1);
+    CU_ASSERT(ret == 0);
+    IMDB_Metric *metric2 = IMDB_MetricCreate("metric2", "desc2", "histogram");
+    CU_ASSERT(metric2 != NULL);
+    ret = IMDB_RecordAddMetric(meta, metric2);
+    CU_ASSERT(ret == 0);
+    IMDB_Metric *metric3 = IMDB_MetricCreate("metric3", "desc3", "histogram");
+    CU_ASSERT(metric3 != NULL);
+    ret = IMDB_RecordAddMetric(meta, metric3);
+    CU_ASSERT(ret == 0);
+
+    ret = IMDB_TableSetMeta(table, meta);
+    CU_ASSERT(ret == 0);
+
+    ret = IMDB_TableSetRecordKeySize(table, 1);
+    CU_ASSERT(ret == 0);
+
+    ret = IMDB_DataBaseMgrAddTable(mgr, table);
+    CU_ASSERT(ret == 0);
+
+    // sum 700, count 6(one above the last bucket), buckets (0, 100], (100, 200], (200, 400]
+    char recordStr[] = "|table1|value1|700 6 100 2 0 3|invalid|\n";
+    ret = IMDB_DataBaseMgrAddRecord(mgr, recordStr);
+    CU_ASSERT(ret == 0);
+
+    // 25 buckets of 13 digit counts, longer than the value of other metrics
+    char longRecordStr[1024] = "|table1|value2|1 25000000000000 1";
+    for (int i = 0; i < 25; i++) {
+        strcat(longRecordStr, " 1000000000000");
+    }
+    strcat(longRecordStr, "|invalid|\n");
+    CU_ASSERT(strlen(longRecordStr) > MAX_IMDB_METRIC_VAL_LEN);
+    ret = IMDB_DataBaseMgrAddRecord(mgr, longRecordStr);
+    CU_ASSERT(ret == 0);
+
+    char buffer[8192] = {0};
+    uint32_t buf_len;
+    ret = IMDB_DataBase2Prometheus(mgr, buffer, 8192, &buf_len);
+    CU_ASSERT(ret >= 0);
+    CU_ASSERT(strstr(buffer, "gala_gopher_entity1_metric2_bucket{metric1=\"value2\"") != NULL);
+    CU_ASSERT(strstr(buffer, ",le=\"16777216\"} 25000000000000 ") != NULL);
+    CU_ASSERT(strstr(buffer, "gala_gopher_entity1_metric2_bucket{metric1=\"value1\"") != NULL);
+    CU_ASSERT(strstr(buffer, ",le=\"100\"} 2 ") != NULL);
+    CU_ASSERT(strstr(buffer, ",le=\"200\"} 2 ") != NULL);
+    CU_ASSERT(strstr(buffer, ",le=\"400\"} 5 ") != NULL);
+    CU_ASSERT(strstr(buffer, ",le=\"+Inf\"} 6 ") != NULL);
+    CU_ASSERT(strstr(buffer, "gala_gopher_entity1_metric2_sum{") != NULL);
+    CU_ASSERT(strstr(buffer, "gala_gopher_entity1_metric2_count{") != NULL);
+    CU_ASSERT(strstr(buffer, "metric3") == NULL);
+    printf("DatabaseMgrHistogram2String: \n");
+    printf(buffer);
+
+    IMDB_DataBaseMgrDestroy(mgr);
+}
+
 static void TestIMDB_RecordAppendKey(void)
 {
     int ret = 0;
@@ -405,6 +477,123 @@ static void TestIMDB_TableSetRecordKeySize(void)
     IMDB_TableDestroy(table);
 }
 
+static void TestIMDB_CardLimitAdmit(void)
+{
+    time_t now = time(NULL);
+    IMDB_CardLimit *limit = IMDB_CardLimitCreate(2, 4, 60);
+    CU_ASSERT(limit != NULL);
+
+    CU_ASSERT(IMDB_CardLimitAdmit(limit, 1, now) == IMDB_CARD_PASS);
+    CU_ASSERT(IMDB_CardLimitAdmit(limit, 2, now) == IMDB_CARD_PASS);
+    CU_ASSERT(IMDB_CardLimitAdmit(limit, 1, now) == IMDB_CARD_PASS);
+    CU_ASSERT(IMDB_CardLimitAdmit(limit, 2, now) == IMDB_CARD_PASS);
+
+    // over budget, scanned keys are folded and never take the place of the admitted ones
+    for (uint64_t key = 100; key < 1100; key++) {
+        CU_ASSERT(IMDB_CardLimitAdmit(limit, key, now) == IMDB_CARD_FOLD);
+    }
+    CU_ASSERT(limit->seriesNum == 2);
+    CU_ASSERT(limit->countersNum == 4);
+    CU_ASSERT(limit->foldedNum == 1000);
+
+    // a heavy new key takes the place of the lightest series
+    CU_ASSERT(IMDB_CardLimitAdmit(limit, 3, now) == IMDB_CARD_FOLD);
+    CU_ASSERT(IMDB_CardLimitAdmit(limit, 3, now) == IMDB_CARD_FOLD);
+    CU_ASSERT(IMDB_CardLimitAdmit(limit, 3, now) == IMDB_CARD_PASS);
+    CU_ASSERT(limit->seriesNum == 2);
+    CU_ASSERT(IMDB_CardLimitAdmit(limit, 3, now) == IMDB_CARD_PASS);
+
+    // idle series are released after the window
+    CU_ASSERT(IMDB_CardLimitAdmit(limit, 1, now + 30) == IMDB_CARD_PASS);
+    CU_ASSERT(IMDB_CardLimitAdmit(limit, 4, now + 61) == IMDB_CARD_PASS);
+    CU_ASSERT(limit->seriesNum == 2);
+
+    IMDB_CardLimitDestroy(limit);
+    CU_ASSERT(IMDB_CardLimitCreate(0, 4, 60) == NULL);
+}
+
+static void TestIMDB_TableCardLimit(void)
+{
+    int ret = 0;
+    IMDB_DataBaseMgr *mgr = IMDB_DataBaseMgrCreate(1024);
+    CU_ASSERT(mgr != NULL);
+
+    IMDB_Table *table = IMDB_TableCreate("table1", 1024);
+    CU_ASSERT(table != NULL);
+    IMDB_TableSetEntityName(table, "entity1");
+
+    IMDB_Record *meta = IMDB_RecordCreate(1024);
+    CU_ASSERT(meta != NULL);
+    IMDB_Metric *metric1 = IMDB_MetricCreate("metric1", "desc1", "key");
+    CU_ASSERT(metric1 != NULL);
+    ret = IMDB_RecordAddMetric(meta, metric1);
+    CU_ASSERT(ret == 0);
+    IMDB_Metric *metric2 = IMDB_MetricCreate("metric2", "desc2", "label");
+    CU_ASSERT(metric2 != NULL);
+    ret = IMDB_RecordAddMetric(meta, metric2);
+    CU_ASSERT(ret == 0);
+    IMDB_Metric *metric3 = IMDB_MetricCreate("metric3", "desc3", "counter");
+    CU_ASSERT(metric3 != NULL);
+    ret = IMDB_RecordAddMetric(meta, metric3);
+    CU_ASSERT(ret == 0);
+
+    ret = IMDB_TableSetMeta(table, meta);
+    CU_ASSERT(ret == 0);
+    ret = IMDB_TableSetRecordKeySize(table, 1);
+    CU_ASSERT(ret == 0);
+    ret = IMDB_TableSetCardLimit(table, 2, 4);
+    CU_ASSERT(ret == 0);
+    ret = IMDB_DataBaseMgrAddTable(mgr, table);
+    CU_ASSERT(ret == 0);
+
+    char *recordStrs[] = {
+        "|table1|port1|label1|10|\n",
+        "|table1|port2|label2|20|\n",
+        "|table1|port3|label3|30|\n",
+        "|table1|port4|label4|40|\n",
+        "|table1|port1|label1|15|\n"
+    };
+    for (int i = 0; i < sizeof(recordStrs) / sizeof(recordStrs[0]); i++) {
+        ret = IMDB_DataBaseMgrAddRecord(mgr, recordStrs[i]);
+        CU_ASSERT(ret == 0);
+    }
+    CU_ASSERT(HASH_recordCount((const IMDB_Record **)table->records) == 3);
+
+    char buffer[4096] = {0};
+    uint32_t buf_len;
+    ret = IMDB_DataBase2Prometheus(mgr, buffer, 4096, &buf_len);
+    CU_ASSERT(ret >= 0);
+    CU_ASSERT(strstr(buffer, "gala_gopher_entity1_metric3{metric1=\"port1\",metric2=\"label1\"") != NULL);
+    CU_ASSERT(strstr(buffer, "gala_gopher_entity1_metric3{metric1=\"other\",machine_id") != NULL);
+    CU_ASSERT(strstr(buffer, "} 70 ") != NULL);
+    CU_ASSERT(strstr(buffer, "gala_gopher_entity1_dropped_series{metric1=\"other\",machine_id") != NULL);
+    CU_ASSERT(strstr(buffer, "} 2 ") != NULL);
+    CU_ASSERT(strstr(buffer, "port3") == NULL);
+    printf("TableCardLimit: \n");
+    printf(buffer);
+
+    // a folded series reporting again starts a new period, the other record is rebuilt instead of growing
+    char *periodStrs[] = {
+        "|table1|port3|label3|31|\n",
+        "|table1|port4|label4|41|\n",
+        "|table1|port3|label3|32|\n"
+    };
+    for (int i = 0; i < sizeof(periodStrs) / sizeof(periodStrs[0]); i++) {
+        ret = IMDB_DataBaseMgrAddRecord(mgr, periodStrs[i]);
+        CU_ASSERT(ret == 0);
+    }
+    CU_ASSERT(table->cardLimit->foldedSeriesNum == 1);
+
+    memset(buffer, 0, sizeof(buffer));
+    ret = IMDB_DataBase2Prometheus(mgr, buffer, 4096, &buf_len);
+    CU_ASSERT(ret >= 0);
+    CU_ASSERT(strstr(buffer, "} 32 ") != NULL);
+    CU_ASSERT(strstr(buffer, "} 73 ") == NULL);
+    CU_ASSERT(strstr(buffer, "} 1 ") != NULL);
+
+    IMDB_DataBaseMgrDestroy(mgr);
+}
+
 void TestIMDBMain(CU_pSuite suite)
 {
     CU_ADD_TEST(suite, TestIMDB_MetricCreate);
@@ -420,9 +609,12 @@ void TestIMDBMain(CU_pSuite suite)
     CU_ADD_TEST(suite, TestIMDB_DataBaseMgrFindTable);
     CU_ADD_TEST(suite, TestIMDB_DataBaseMgrAddRecord);
     CU_ADD_TEST(suite, TestIMDB_DataBaseMgrData2String);
+    CU_ADD_TEST(suite, TestIMDB_DataBaseMgrHistogram2String);
     CU_ADD_TEST(suite, TestIMDB_RecordAppendKey);
     CU_ADD_TEST(suite, TestHASH_addRecord);
     CU_ADD_TEST(suite, TestHASH_deleteRecord);
     CU_ADD_TEST(suite, TestIMDB_TableSetRecordKeySize);
+    CU_ADD_TEST(suite, TestIMDB_CardLimitAdmit);
+    CU_ADD_TEST(suite, TestIMDB_TableCardLimit);
 }
 
@@ -13,12 +13,19 @@
  * Description: provide gala-gopher test
  ******************************************************************************/
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
 #include <CUnit/Basic.h>
 
 #include "probe.h"
+#include "bin_output.h"
 #include "test_probe.h"
 
 #define PROBE_MGR_SIZE 1024
+#define BIN_OUTPUT_TEST_RECORDS 5000
 
 static void TestProbeMgrCreate(void)
 {
@@ -80,11 +87,95 @@ static void TestProbeCreate(void)
     ProbeDestroy(probe);
 }
 
+static void PutTestRecord(struct bin_output_s *out, int i)
+{
+    unsigned char ip4[IP6_LEN] = {192, 168, 1, 23};
+    unsigned char ip6[IP6_LEN] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+    unsigned char ip6_v4[IP6_LEN] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 10, 0, 0, 1};
+    u16 family = (i % 3 == 0) ? AF_INET : AF_INET6;
+    unsigned char *ip = (i % 3 == 0) ? ip4 : ((i % 3 == 1) ? ip6 : ip6_v4);
+
+    ip4[3] = (unsigned char)i;
+    bin_output_begin(out, (i % 2) ? "tcp_abn" : "tcp_tx_rx");
+    bin_output_u32(out, (u32)i);
+    bin_output_ip(out, family, ip);
+    bin_output_ip(out, family, ip4);
+    bin_output_u32(out, (u32)(i % 65536));
+    bin_output_u64(out, 0xFFFFFFFFFFULL * (u64)i);
+    bin_output_s32(out, -i);
+    bin_output_str(out, "comm");
+    bin_output_end(out);
+}
+
+static char *ReadTestOutput(FILE *f, uint32_t *len)
+{
+    long size = ftell(f);
+    char *buf = (char *)malloc(size + 1);
+
+    CU_ASSERT(size > 0 && buf != NULL);
+    rewind(f);
+    *len = (uint32_t)fread(buf, 1, size, f);
+    return buf;
+}
+
+static void TestBinOutputDecode(void)
+{
+    FILE *text_f = tmpfile();
+    FILE *bin_f = tmpfile();
+    struct bin_output_s *text_out = create_bin_output(text_f);
+    struct bin_output_s *bin_out = create_bin_output(bin_f);
+    struct bin_frame_hdr_s hdr;
+    char *text, *bin, *decoded;
+    uint32_t text_len, bin_len, decoded_len = 0, rec_len, pos = 0, frames = 0;
+    int len;
+
+    CU_ASSERT(text_out != NULL && bin_out != NULL);
+    bin_output_set_binary(bin_out, 1);
+    for (int i = 0; i < BIN_OUTPUT_TEST_RECORDS; i++) {
+        PutTestRecord(text_out, i);
+        PutTestRecord(bin_out, i);
+    }
+    CU_ASSERT(bin_output_flush(text_out) == 0);
+    CU_ASSERT(bin_output_flush(bin_out) == 0);
+
+    text = ReadTestOutput(text_f, &text_len);
+    bin = ReadTestOutput(bin_f, &bin_len);
+    decoded = (char *)malloc(text_len + MAX_DATA_STR_LEN);
+    CU_ASSERT(bin_len < text_len && decoded != NULL);
+
+    while (pos + sizeof(hdr) <= bin_len) {
+        (void)memcpy(&hdr, bin + pos, sizeof(hdr));
+        CU_ASSERT_FATAL(hdr.magic == BIN_OUTPUT_MAGIC && hdr.version == BIN_OUTPUT_VERSION);
+        pos += sizeof(hdr);
+        for (uint32_t end = pos + hdr.len; pos < end; pos += rec_len) {
+            len = bin_record_to_text(bin + pos, end - pos, &rec_len, decoded + decoded_len, MAX_DATA_STR_LEN);
+            CU_ASSERT_FATAL(len > 0);
+            decoded_len += (uint32_t)len;
+        }
+        frames++;
+    }
+
+    // Records are split into frames by size, and decoded to the same text as the text mode.
+    CU_ASSERT(pos == bin_len);
+    CU_ASSERT(frames > 1);
+    CU_ASSERT(decoded_len == text_len);
+    CU_ASSERT(memcmp(decoded, text, text_len) == 0);
+
+    free(decoded);
+    free(bin);
+    free(text);
+    destroy_bin_output(bin_out);
+    destroy_bin_output(text_out);
+    (void)fclose(bin_f);
+    (void)fclose(text_f);
+}
+
 void TestProbeMain(CU_pSuite suite)
 {
     CU_ADD_TEST(suite, TestProbeMgrCreate);
     CU_ADD_TEST(suite, TestProbeMgrPut);
     CU_ADD_TEST(suite, TestProbeMgrGet);
     CU_ADD_TEST(suite, TestProbeCreate);
+    CU_ADD_TEST(suite, TestBinOutputDecode);
 }
 
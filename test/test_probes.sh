@@ -9,6 +9,10 @@ PROBES_LIST=""
 PROBES_C_LIST=""
 PROBES_META_LIST=""
 
+LIBBPF_VER=$(rpm -q libbpf | awk -F'-' '{print $2}')
+LIBBPF_VER_MAJOR=$(echo ${LIBBPF_VER} | awk -F'.' '{print $1}')
+LIBBPF_VER_MINOR=$(echo ${LIBBPF_VER} | awk -F'.' '{print $2}')
+
 TEST_FOLDER=${PROJECT_FOLDER}
 
 echo "PROJECT_FOLDER:"
@@ -77,7 +81,8 @@ function compile_test()
     mkdir build
     cd build
 
-    cmake -DPROBES_C_LIST="${PROBES_C_LIST}" -DPROBES_LIST="${PROBES_LIST}" -DPROBES_META_LIST="${PROBES_META_LIST}" ..
+    cmake -DPROBES_C_LIST="${PROBES_C_LIST}" -DPROBES_LIST="${PROBES_LIST}" -DPROBES_META_LIST="${PROBES_META_LIST}" \
+        -DLIBBPF_VER_MAJOR="${LIBBPF_VER_MAJOR}" -DLIBBPF_VER_MINOR="${LIBBPF_VER_MINOR}" ..
     make
 }
 
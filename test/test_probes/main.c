@@ -42,6 +42,23 @@ int main(int argc, char *argv[])
     CU_ADD_TEST(suite, TestSystemNetProbe);
     CU_ADD_TEST(suite, TestSystemdNetTcpProbe);
     CU_ADD_TEST(suite, TestSystemProcProbe);
+    CU_ADD_TEST(suite, TestProcFileFixture);
+    CU_ADD_TEST(suite, TestHistogram);
+    CU_ADD_TEST(suite, TestBlkTopo);
+    CU_ADD_TEST(suite, TestTcpSockDiag);
+    CU_ADD_TEST(suite, TestPinStateLayout);
+    CU_ADD_TEST(suite, TestBpfRawTracepoint);
+    CU_ADD_TEST(suite, TestTcpSockbufCoreLoad);
+    CU_ADD_TEST(suite, TestDwarfUnwind);
+    CU_ADD_TEST(suite, TestDwarfUnwindCorrupt);
+    CU_ADD_TEST(suite, TestElfSymbEytzinger);
+    CU_ADD_TEST(suite, TestCharScan);
+    CU_ADD_TEST(suite, TestHpackDecode);
+    CU_ADD_TEST(suite, TestDnsParser);
+    CU_ADD_TEST(suite, TestRedisParser);
+    CU_ADD_TEST(suite, TestHttp1Parser);
+    CU_ADD_TEST(suite, TestMysqlParser);
+    CU_ADD_TEST(suite, TestKafkaParser);
     CU_ADD_TEST(suite, TestVirtInfoProbe);
     CU_ADD_TEST(suite, TestEventProbe);
 
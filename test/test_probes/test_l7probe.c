@@ -0,0 +1,1066 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2023. All rights reserved.
+ * gala-gopher licensed under the Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *     http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ * Author: luzhihao
+ * Create: 2023-09-12
+ * Description: l7probe protocol parser test
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <CUnit/Basic.h>
+#include "../../probes/extends/ebpf.probe/src/l7probe/protocol/utils/char_scan.h"
+#include "../../probes/extends/ebpf.probe/src/l7probe/protocol/http2/hpack.h"
+#include "../../probes/extends/ebpf.probe/src/l7probe/protocol/dns/dns_parser.h"
+#include "../../probes/extends/ebpf.probe/src/l7probe/protocol/redis/redis_parser.h"
+#include "../../probes/extends/ebpf.probe/src/l7probe/protocol/redis/redis_matcher.h"
+#include "../../probes/extends/ebpf.probe/src/l7probe/protocol/http1.x/parser/http_parser.h"
+#include "../../probes/extends/ebpf.probe/src/l7probe/protocol/mysql/mysql_parser.h"
+#include "../../probes/extends/ebpf.probe/src/l7probe/protocol/mysql/mysql_matcher.h"
+#include "../../probes/extends/ebpf.probe/src/l7probe/protocol/kafka/kafka_parser.h"
+#include "../../probes/extends/ebpf.probe/src/l7probe/protocol/kafka/kafka_matcher.h"
+#include "../../probes/extends/ebpf.probe/src/l7probe/protocol/utils/macros.h"
+
+#include "test_probes.h"
+
+#define CHAR_SCAN_TEST_LEN      100     // covers several 16/32 bytes chunks and their tails
+#define CHAR_SCAN_BENCH_LEN     (1024 * 1024)
+#define CHAR_SCAN_BENCH_LOOPS   64
+#define HPACK_TEST_BUF_LEN      1024
+#define DNS_TEST_BUF_LEN        512
+#define L7_TEST_MAX_FRAMES      16
+
+// the ranges of http_parse_wrapper.c, plus ranges of bytes above 0x7f and of a single char
+static const char *g_char_scan_ranges[] = {
+    "\0\010\012\037\177\177",
+    "\000\040\177\177",
+    "\x00 \"\"(),,//:@[]{\xff",
+    "\x80\xfe",
+    "aa",
+};
+static const size_t g_char_scan_ranges_size[] = {6, 4, 16, 2, 2};
+
+static char char_in_ranges(unsigned char c, const char *ranges, size_t ranges_size)
+{
+    for (size_t i = 0; i + 1 < ranges_size; i += 2) {
+        if (c >= (unsigned char)ranges[i] && c <= (unsigned char)ranges[i + 1]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// as char_scan_find_caller(), and also checks that find_char_fast() did not skip a hit
+static const char *char_scan_find(const char *buf, const char *buf_end, const char *ranges, size_t ranges_size)
+{
+    int found = 0;
+    const char *p = find_char_fast(buf, buf_end, ranges, ranges_size, &found);
+
+    if (found) {
+        return p;
+    }
+    for (const char *q = buf; q < p; q++) {
+        if (char_in_ranges((unsigned char)*q, ranges, ranges_size)) {
+            return NULL;    // skipped a hit
+        }
+    }
+    for (; p < buf_end; p++) {
+        if (char_in_ranges((unsigned char)*p, ranges, ranges_size)) {
+            return p;
+        }
+    }
+    return buf_end;
+}
+
+// what the parsers do: find_char_fast() and the scalar loop over the tail, without checking the skipped bytes
+static const char *char_scan_find_caller(const char *buf, const char *buf_end, const char *ranges,
+                                         size_t ranges_size)
+{
+    int found = 0;
+    const char *p = find_char_fast(buf, buf_end, ranges, ranges_size, &found);
+
+    if (found) {
+        return p;
+    }
+    for (; p < buf_end; p++) {
+        if (char_in_ranges((unsigned char)*p, ranges, ranges_size)) {
+            return p;
+        }
+    }
+    return buf_end;
+}
+
+static const char *char_scan_find_scalar(const char *buf, const char *buf_end, const char *ranges,
+                                         size_t ranges_size)
+{
+    for (const char *p = buf; p < buf_end; p++) {
+        if (char_in_ranges((unsigned char)*p, ranges, ranges_size)) {
+            return p;
+        }
+    }
+    return buf_end;
+}
+
+// a single hit at every position of every length, the buffer starts at every alignment
+static void char_scan_test_impl(const char *ranges, size_t ranges_size)
+{
+    char buf[CHAR_SCAN_TEST_LEN + 16];
+    char miss = 'x';
+    const char *start, *end;
+
+    while (char_in_ranges((unsigned char)miss, ranges, ranges_size)) {
+        miss++;
+    }
+
+    for (size_t align = 0; align < 16; align += 5) {
+        start = buf + align;
+        for (size_t len = 0; len <= CHAR_SCAN_TEST_LEN; len++) {
+            end = start + len;
+            memset(buf, miss, sizeof(buf));
+            CU_ASSERT(char_scan_find(start, end, ranges, ranges_size) == end);
+
+            // a hit right after the end is never reported
+            if (align + len < sizeof(buf)) {
+                buf[align + len] = ranges[ranges_size - 1];
+                CU_ASSERT(char_scan_find(start, end, ranges, ranges_size) == end);
+            }
+
+            for (size_t hit = 0; hit < len; hit++) {
+                memset(buf, miss, sizeof(buf));
+                buf[align + hit] = ranges[(hit % 2) ? 0 : ranges_size - 1];
+                CU_ASSERT(char_scan_find(start, end, ranges, ranges_size) == start + hit);
+            }
+        }
+    }
+
+    // random bytes, several hits
+    srand(1);
+    for (int i = 0; i < 1000; i++) {
+        for (size_t j = 0; j < sizeof(buf); j++) {
+            buf[j] = (char)(rand() & 0xff);
+        }
+        end = buf + (rand() % (CHAR_SCAN_TEST_LEN + 1));
+        CU_ASSERT(char_scan_find(buf, end, ranges, ranges_size) == char_scan_find_scalar(buf, end, ranges, ranges_size));
+    }
+}
+
+/*
+ * Throughput of each implementation over a buffer without any hit, printed only: the speedup depends on the CPU
+ * and is not asserted.
+ */
+static void char_scan_bench(enum char_scan_impl_t impl)
+{
+    char *buf;
+    const char *p = NULL;
+    struct timespec start, end;
+    double secs;
+
+    buf = (char *)malloc(CHAR_SCAN_BENCH_LEN);
+    CU_ASSERT_FATAL(buf != NULL);
+    memset(buf, 'x', CHAR_SCAN_BENCH_LEN);
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < CHAR_SCAN_BENCH_LOOPS; i++) {
+        p = char_scan_find_caller(buf, buf + CHAR_SCAN_BENCH_LEN, g_char_scan_ranges[1], g_char_scan_ranges_size[1]);
+    }
+    (void)clock_gettime(CLOCK_MONOTONIC, &end);
+    CU_ASSERT(p == buf + CHAR_SCAN_BENCH_LEN);
+
+    secs = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("char_scan %-6s: %8.1f MB/s\n", char_scan_impl_name(impl),
+           (secs > 0) ? (double)CHAR_SCAN_BENCH_LEN * CHAR_SCAN_BENCH_LOOPS / secs / (1024 * 1024) : 0);
+    free(buf);
+}
+
+void TestCharScan(void)
+{
+    enum char_scan_impl_t impl;
+
+    CU_ASSERT(char_scan_select_impl(CHAR_SCAN_SCALAR) == CHAR_SCAN_SCALAR);
+    CU_ASSERT(strcmp(char_scan_impl_name(CHAR_SCAN_IMPL_MAX), "unknown") == 0);
+
+    for (int i = CHAR_SCAN_SCALAR; i < CHAR_SCAN_IMPL_MAX; i++) {
+        // unsupported implementations fall back to the detected one, which is tested in its own turn
+        impl = char_scan_select_impl((enum char_scan_impl_t)i);
+        if (impl != (enum char_scan_impl_t)i) {
+            printf("char_scan %s is not supported\n", char_scan_impl_name((enum char_scan_impl_t)i));
+            continue;
+        }
+        for (size_t j = 0; j < sizeof(g_char_scan_ranges) / sizeof(g_char_scan_ranges[0]); j++) {
+            char_scan_test_impl(g_char_scan_ranges[j], g_char_scan_ranges_size[j]);
+        }
+        char_scan_bench(impl);
+    }
+
+    (void)char_scan_select_impl(CHAR_SCAN_IMPL_MAX);
+}
+
+/*
+ * RFC 7541 Appendix C, the blocks of a group are decoded in order with the same dynamic table. The response
+ * examples(C.5, C.6) use a 256 bytes table, set by a dynamic table size update(3fe101) before their 1st block.
+ */
+struct hpack_test_case_s {
+    char new_table;
+    const char *block;      // hex
+    const char *headers;    // "name: value\n" of each decoded field
+    uint32_t count;         // dynamic table after the block
+    uint32_t size;
+};
+
+static const struct hpack_test_case_s g_hpack_cases[] = {
+    // C.2.1 - C.2.4 literal and indexed fields
+    {1, "400a637573746f6d2d6b65790d637573746f6d2d686561646572", "custom-key: custom-header\n", 1, 55},
+    {1, "040c2f73616d706c652f70617468", ":path: /sample/path\n", 0, 0},
+    {1, "100870617373776f726406736563726574", "password: secret\n", 0, 0},
+    {1, "82", ":method: GET\n", 0, 0},
+
+    // C.3 requests without Huffman coding
+    {1, "828684410f7777772e6578616d706c652e636f6d",
+     ":method: GET\n:scheme: http\n:path: /\n:authority: www.example.com\n", 1, 57},
+    {0, "828684be58086e6f2d6361636865",
+     ":method: GET\n:scheme: http\n:path: /\n:authority: www.example.com\ncache-control: no-cache\n", 2, 110},
+    {0, "828785bf400a637573746f6d2d6b65790c637573746f6d2d76616c7565",
+     ":method: GET\n:scheme: https\n:path: /index.html\n:authority: www.example.com\ncustom-key: custom-value\n",
+     3, 164},
+
+    // C.4 requests with Huffman coding
+    {1, "828684418cf1e3c2e5f23a6ba0ab90f4ff",
+     ":method: GET\n:scheme: http\n:path: /\n:authority: www.example.com\n", 1, 57},
+    {0, "828684be5886a8eb10649cbf",
+     ":method: GET\n:scheme: http\n:path: /\n:authority: www.example.com\ncache-control: no-cache\n", 2, 110},
+    {0, "828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf",
+     ":method: GET\n:scheme: https\n:path: /index.html\n:authority: www.example.com\ncustom-key: custom-value\n",
+     3, 164},
+
+    // C.5 responses without Huffman coding, with eviction
+    {1, "3fe101"
+        "4803333032580770726976617465611d4d6f6e2c203231204f637420323031332032303a31333a323120474d54"
+        "6e1768747470733a2f2f7777772e6578616d706c652e636f6d",
+     ":status: 302\ncache-control: private\ndate: Mon, 21 Oct 2013 20:13:21 GMT\n"
+     "location: https://www.example.com\n", 4, 222},
+    {0, "4803333037c1c0bf",
+     ":status: 307\ncache-control: private\ndate: Mon, 21 Oct 2013 20:13:21 GMT\n"
+     "location: https://www.example.com\n", 4, 222},
+    {0, "88c1611d4d6f6e2c203231204f637420323031332032303a31333a323220474d54c05a04677a6970"
+        "7738666f6f3d4153444a4b48514b425a584f5157454f50495541585157454f49553b206d61782d616765"
+        "3d333630303b2076657273696f6e3d31",
+     ":status: 200\ncache-control: private\ndate: Mon, 21 Oct 2013 20:13:22 GMT\n"
+     "location: https://www.example.com\ncontent-encoding: gzip\n"
+     "set-cookie: foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1\n", 3, 215},
+
+    // C.6 responses with Huffman coding, with eviction
+    {1, "3fe101"
+        "488264025885aec3771a4b6196d07abe941054d444a8200595040b8166e082a62d1bff6e919d29ad171863c78f0b97c8"
+        "e9ae82ae43d3",
+     ":status: 302\ncache-control: private\ndate: Mon, 21 Oct 2013 20:13:21 GMT\n"
+     "location: https://www.example.com\n", 4, 222},
+    {0, "4883640effc1c0bf",
+     ":status: 307\ncache-control: private\ndate: Mon, 21 Oct 2013 20:13:21 GMT\n"
+     "location: https://www.example.com\n", 4, 222},
+    {0, "88c16196d07abe941054d444a8200595040b8166e084a62d1bffc05a839bd9ab77ad94e7821dd7f2e6c7b335dfdfcd5b"
+        "3960d5af27087f3672c1ab270fb5291f9587316065c003ed4ee5b1063d5007",
+     ":status: 200\ncache-control: private\ndate: Mon, 21 Oct 2013 20:13:22 GMT\n"
+     "location: https://www.example.com\ncontent-encoding: gzip\n"
+     "set-cookie: foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1\n", 3, 215},
+};
+
+// malformed blocks, each decoded with a new table
+static const char *g_hpack_bad_blocks[] = {
+    "80",                   // index 0
+    "be",                   // index 62, the dynamic table is empty
+    "ff",                   // integer without its continuation bytes
+    "400a637573746f6d2d",   // string longer than the block
+    "418cf1e3c2e5f23a6ba0ab90f4fe",     // Huffman string ends with a non-EOS padding
+};
+
+struct hpack_test_buf_s {
+    char buf[HPACK_TEST_BUF_LEN];
+    size_t len;
+};
+
+static void hpack_test_field(const char *name, size_t name_len, const char *value, size_t value_len, void *arg)
+{
+    struct hpack_test_buf_s *out = (struct hpack_test_buf_s *)arg;
+    int ret;
+
+    ret = snprintf(out->buf + out->len, sizeof(out->buf) - out->len, "%.*s: %.*s\n",
+                   (int)name_len, name, (int)value_len, value);
+    if (ret > 0) {
+        out->len += (size_t)ret;
+    }
+}
+
+static size_t test_hex_to_bytes(const char *hex, uint8_t *bytes, size_t size)
+{
+    size_t len = 0;
+    unsigned int b;
+
+    while (hex[0] != '\0' && hex[1] != '\0' && len < size) {
+        if (sscanf(hex, "%2x", &b) != 1) {
+            break;
+        }
+        bytes[len++] = (uint8_t)b;
+        hex += 2;
+    }
+    return len;
+}
+
+void TestHpackDecode(void)
+{
+    struct hpack_table_s table;
+    struct hpack_test_buf_s out;
+    uint8_t block[HPACK_TEST_BUF_LEN];
+    size_t len;
+
+    init_hpack_table(&table);
+    for (size_t i = 0; i < sizeof(g_hpack_cases) / sizeof(g_hpack_cases[0]); i++) {
+        const struct hpack_test_case_s *c = &g_hpack_cases[i];
+
+        if (c->new_table) {
+            reset_hpack_table(&table);
+        }
+        len = test_hex_to_bytes(c->block, block, sizeof(block));
+        out.len = 0;
+        out.buf[0] = 0;
+        CU_ASSERT(hpack_decode_block(&table, block, len, hpack_test_field, &out) == 0);
+        CU_ASSERT(strcmp(out.buf, c->headers) == 0);
+        CU_ASSERT(table.count == c->count);
+        CU_ASSERT(table.size == c->size);
+    }
+    deinit_hpack_table(&table);
+
+    for (size_t i = 0; i < sizeof(g_hpack_bad_blocks) / sizeof(g_hpack_bad_blocks[0]); i++) {
+        init_hpack_table(&table);
+        len = test_hex_to_bytes(g_hpack_bad_blocks[i], block, sizeof(block));
+        CU_ASSERT(hpack_decode_block(&table, block, len, NULL, NULL) == -1);
+        deinit_hpack_table(&table);
+    }
+}
+
+// example.com A query, and the header/question/answer pieces of the responses
+#define DNS_TEST_QUERY_HDR  "123401000001000000000000"
+#define DNS_TEST_RESP_HDR   "123481800001000100000000"
+#define DNS_TEST_QUESTION   "076578616d706c6503636f6d0000010001"
+#define DNS_TEST_ANSWER     "c00c000100010000003c00045db8d822"
+#define DNS_TEST_OPT        "0000290200000000000000"
+
+struct dns_test_case_s {
+    enum message_type_t msg_type;
+    const char *data;       // hex
+    parse_state_t state;
+    size_t current_pos;
+    size_t skip_len;
+    uint8_t rcode;
+    const char *domain;
+};
+
+static const struct dns_test_case_s g_dns_cases[] = {
+    // UDP query, the domain is lower cased
+    {MESSAGE_REQUEST, "123401000001000000000000" "07657841" "6d706c6503636f6d0000010001",
+     STATE_SUCCESS, 29, 0, 0, "example.com"},
+    // parsed in the wrong direction
+    {MESSAGE_RESPONSE, DNS_TEST_QUERY_HDR DNS_TEST_QUESTION, STATE_INVALID, 1, 0, 0, NULL},
+    // less than a TCP length and a header
+    {MESSAGE_REQUEST, DNS_TEST_QUERY_HDR "07", STATE_NEEDS_MORE_DATA, 0, 0, 0, NULL},
+    // UDP query truncated in the QNAME, a datagram never gets more data
+    {MESSAGE_REQUEST, DNS_TEST_QUERY_HDR "076578616d706c", STATE_INVALID, 1, 0, 0, NULL},
+    // UDP response, the answer with a compressed name is consumed
+    {MESSAGE_RESPONSE, DNS_TEST_RESP_HDR DNS_TEST_QUESTION DNS_TEST_ANSWER, STATE_SUCCESS, 45, 0, 0, "example.com"},
+    // UDP response truncated in the answer, the rest of the datagram is dropped
+    {MESSAGE_RESPONSE, DNS_TEST_RESP_HDR DNS_TEST_QUESTION "c00c0001000100", STATE_SUCCESS, 36, 0, 0, "example.com"},
+    // NXDOMAIN
+    {MESSAGE_RESPONSE, "123481830001000000000000" DNS_TEST_QUESTION, STATE_SUCCESS, 29, 0, 3, "example.com"},
+    // QNAME points to itself
+    {MESSAGE_RESPONSE, "123481800001000000000000" "c00c00010001", STATE_INVALID, 1, 0, 0, NULL},
+    // QNAME points to the txid, which points back to the QNAME
+    {MESSAGE_RESPONSE, "c00c81800001000000000000" "c00000010001", STATE_INVALID, 1, 0, 0, NULL},
+    // TCP query with the 2 bytes length prefix
+    {MESSAGE_REQUEST, "001d" DNS_TEST_QUERY_HDR DNS_TEST_QUESTION, STATE_SUCCESS, 31, 0, 0, "example.com"},
+    // TCP query followed by the next message, only the 1st one is consumed
+    {MESSAGE_REQUEST, "001d" DNS_TEST_QUERY_HDR DNS_TEST_QUESTION "001d" DNS_TEST_QUERY_HDR,
+     STATE_SUCCESS, 31, 0, 0, "example.com"},
+    // TCP query received up to the middle of the QNAME, waits for more data
+    {MESSAGE_REQUEST, "001d" DNS_TEST_QUERY_HDR "076578616d706c", STATE_NEEDS_MORE_DATA, 0, 0, 0, NULL},
+    // TCP query with an EDNS OPT record
+    {MESSAGE_REQUEST, "0028" "123401000001000000000001" DNS_TEST_QUESTION DNS_TEST_OPT,
+     STATE_SUCCESS, 42, 0, 0, "example.com"},
+    // TCP query whose question is complete but the EDNS OPT record is not, the rest is skipped by length
+    {MESSAGE_REQUEST, "0028" "123401000001000000000001" DNS_TEST_QUESTION "000029",
+     STATE_SUCCESS, 34, 8, 0, "example.com"},
+    // TCP length shorter than the question
+    {MESSAGE_REQUEST, "0010" DNS_TEST_QUERY_HDR DNS_TEST_QUESTION, STATE_INVALID, 1, 0, 0, NULL},
+};
+
+static struct raw_data_s *dns_test_raw_data(const char *hex)
+{
+    uint8_t bytes[DNS_TEST_BUF_LEN];
+    size_t len = test_hex_to_bytes(hex, bytes, sizeof(bytes));
+    struct raw_data_s *raw_data = (struct raw_data_s *)calloc(1, sizeof(struct raw_data_s) + len);
+
+    if (raw_data != NULL) {
+        raw_data->data_len = len;
+        (void)memcpy(raw_data->data, bytes, len);
+    }
+    return raw_data;
+}
+
+void TestDnsParser(void)
+{
+    struct raw_data_s *raw_data;
+    struct frame_data_s *frame_data;
+    struct dns_msg_s *msg;
+    parse_state_t state;
+
+    for (size_t i = 0; i < sizeof(g_dns_cases) / sizeof(g_dns_cases[0]); i++) {
+        const struct dns_test_case_s *c = &g_dns_cases[i];
+
+        raw_data = dns_test_raw_data(c->data);
+        CU_ASSERT_FATAL(raw_data != NULL);
+        frame_data = NULL;
+        state = dns_parse_frame(c->msg_type, raw_data, &frame_data);
+        CU_ASSERT(state == c->state);
+        CU_ASSERT(raw_data->current_pos == c->current_pos);
+        CU_ASSERT(raw_data->skip_len == c->skip_len);
+        if (state == STATE_SUCCESS && frame_data != NULL) {
+            msg = (struct dns_msg_s *)frame_data->frame;
+            CU_ASSERT(frame_data->msg_type == c->msg_type);
+            CU_ASSERT(msg->txid == 0x1234);
+            CU_ASSERT(msg->qtype == 1);
+            CU_ASSERT(msg->rcode == c->rcode);
+            CU_ASSERT(c->domain != NULL && strcmp(msg->domain, c->domain) == 0);
+            free_dns_msg(msg);
+            free(frame_data);
+        } else {
+            CU_ASSERT(frame_data == NULL);
+        }
+        free(raw_data);
+    }
+
+    // a garbage byte before a UDP query
+    raw_data = dns_test_raw_data("00" DNS_TEST_QUERY_HDR DNS_TEST_QUESTION);
+    CU_ASSERT_FATAL(raw_data != NULL);
+    CU_ASSERT(dns_find_frame_boundary(MESSAGE_REQUEST, raw_data) == 1);
+    free(raw_data);
+}
+
+static struct raw_data_s *l7_test_raw_data(const char *data, size_t len, u64 timestamp_ns)
+{
+    struct raw_data_s *raw_data = (struct raw_data_s *)calloc(1, sizeof(struct raw_data_s) + len);
+
+    if (raw_data != NULL) {
+        raw_data->data_len = len;
+        raw_data->timestamp_ns = timestamp_ns;
+        (void)memcpy(raw_data->data, data, len);
+    }
+    return raw_data;
+}
+
+struct redis_test_case_s {
+    enum message_type_t msg_type;
+    const char *data;
+    parse_state_t state;
+    size_t current_pos;
+    size_t skip_len;
+    char data_type;
+    char is_err;
+    char is_push;
+    const char *command;
+};
+
+static const struct redis_test_case_s g_redis_cases[] = {
+    // the command name is upper cased
+    {MESSAGE_REQUEST, "*2\r\n$3\r\nget\r\n$1\r\nk\r\n", STATE_SUCCESS, 20, 0, '*', 0, 0, "GET"},
+    // pipelined commands, only the 1st one is consumed
+    {MESSAGE_REQUEST, "*1\r\n$4\r\nPING\r\n*1\r\n$4\r\nPING\r\n", STATE_SUCCESS, 14, 0, '*', 0, 0, "PING"},
+    // requests are arrays of bulk strings
+    {MESSAGE_REQUEST, "+OK\r\n", STATE_INVALID, 1, 0, 0, 0, 0, NULL},
+    {MESSAGE_REQUEST, "*2\r\n$3\r\nGET\r\n$1", STATE_NEEDS_MORE_DATA, 0, 0, 0, 0, 0, NULL},
+    // the partial bulk string ends the request, the rest of its payload is skipped by length
+    {MESSAGE_REQUEST, "*3\r\n$3\r\nSET\r\n$1\r\nk\r\n$10\r\nabc", STATE_SUCCESS, 28, 9, '*', 0, 0, "SET"},
+    // a partial bulk string followed by other elements waits for more data
+    {MESSAGE_REQUEST, "*3\r\n$3\r\nSET\r\n$10\r\nab", STATE_NEEDS_MORE_DATA, 0, 0, 0, 0, 0, NULL},
+    {MESSAGE_RESPONSE, "+OK\r\n", STATE_SUCCESS, 5, 0, '+', 0, 0, NULL},
+    {MESSAGE_RESPONSE, "-ERR unknown\r\n", STATE_SUCCESS, 14, 0, '-', 1, 0, NULL},
+    {MESSAGE_RESPONSE, "!5\r\nERROR\r\n", STATE_SUCCESS, 11, 0, '!', 1, 0, NULL},
+    {MESSAGE_RESPONSE, "$-1\r\n", STATE_SUCCESS, 5, 0, '$', 0, 0, NULL},
+    // RESP3 pub/sub message
+    {MESSAGE_RESPONSE, ">3\r\n$7\r\nmessage\r\n$2\r\nch\r\n$2\r\nhi\r\n", STATE_SUCCESS, 33, 0, '>', 0, 1, NULL},
+    // the attribute is skipped, the type is the one of the value
+    {MESSAGE_RESPONSE, "|1\r\n+ttl\r\n:3\r\n:1\r\n", STATE_SUCCESS, 18, 0, ':', 0, 0, NULL},
+    // partial bulk string response
+    {MESSAGE_RESPONSE, "$5\r\nhel", STATE_SUCCESS, 7, 4, '$', 0, 0, NULL},
+    // '\r' not followed by '\n'
+    {MESSAGE_RESPONSE, "+OK\rX\n", STATE_INVALID, 1, 0, 0, 0, 0, NULL},
+    // nested deeper than REDIS_MAX_NESTING_DEPTH
+    {MESSAGE_RESPONSE, "*1\r\n*1\r\n*1\r\n*1\r\n*1\r\n*1\r\n*1\r\n*1\r\n*1\r\n"
+     "*1\r\n*1\r\n*1\r\n*1\r\n*1\r\n*1\r\n*1\r\n*1\r\n:1\r\n", STATE_INVALID, 1, 0, 0, 0, 0, NULL},
+};
+
+typedef parse_state_t (*l7_test_parse_fn)(enum message_type_t msg_type, struct raw_data_s *raw_data,
+                                          struct frame_data_s **frame_data);
+
+// parse all the frames of raw_data into frame_buf, returns the state of the last parse
+static parse_state_t l7_test_parse_frames(l7_test_parse_fn parse, enum message_type_t msg_type,
+                                          struct raw_data_s *raw_data, struct frame_buf_s *frame_buf)
+{
+    struct frame_data_s *frame_data;
+    parse_state_t state = STATE_INVALID;
+
+    while (raw_data->current_pos < raw_data->data_len && frame_buf->frame_buf_size < L7_TEST_MAX_FRAMES) {
+        frame_data = NULL;
+        state = parse(msg_type, raw_data, &frame_data);
+        if (state == STATE_IGNORE) {
+            continue;
+        }
+        if (state != STATE_SUCCESS) {
+            break;
+        }
+        frame_buf->frames[frame_buf->frame_buf_size++] = frame_data;
+    }
+    return state;
+}
+
+static parse_state_t redis_test_parse(enum message_type_t msg_type, const char *data, u64 timestamp_ns,
+                                      struct frame_buf_s *frame_buf)
+{
+    struct raw_data_s *raw_data = l7_test_raw_data(data, strlen(data), timestamp_ns);
+    parse_state_t state;
+
+    if (raw_data == NULL) {
+        return STATE_INVALID;
+    }
+    state = l7_test_parse_frames(redis_parse_frame, msg_type, raw_data, frame_buf);
+    free(raw_data);
+    return state;
+}
+
+static void redis_test_free_frames(struct frame_buf_s *frame_buf)
+{
+    for (size_t i = 0; i < frame_buf->frame_buf_size; i++) {
+        free_redis_msg((struct redis_msg_s *)frame_buf->frames[i]->frame);
+        free(frame_buf->frames[i]);
+    }
+}
+
+static void redis_test_matcher(void)
+{
+    static struct frame_buf_s req_frames, resp_frames;
+    static struct record_buf_s record_buf;
+    struct redis_record_s *record;
+
+    memset(&req_frames, 0, sizeof(req_frames));
+    memset(&resp_frames, 0, sizeof(resp_frames));
+    memset(&record_buf, 0, sizeof(record_buf));
+
+    // a stale response of a lost request, then 3 pipelined commands answered in order, with a push in between
+    CU_ASSERT(redis_test_parse(MESSAGE_RESPONSE, "+stale\r\n", 50, &resp_frames) == STATE_SUCCESS);
+    CU_ASSERT(redis_test_parse(MESSAGE_REQUEST,
+        "*2\r\n$3\r\nGET\r\n$1\r\na\r\n*3\r\n$3\r\nSET\r\n$1\r\nb\r\n$1\r\n1\r\n*2\r\n$4\r\nINCR\r\n$1\r\nc\r\n",
+        100, &req_frames) == STATE_SUCCESS);
+    CU_ASSERT(redis_test_parse(MESSAGE_RESPONSE,
+        "$1\r\nx\r\n>2\r\n$10\r\ninvalidate\r\n*1\r\n$1\r\nb\r\n+OK\r\n-ERR not an integer\r\n",
+        200, &resp_frames) == STATE_SUCCESS);
+    CU_ASSERT_FATAL(req_frames.frame_buf_size == 3);
+    CU_ASSERT_FATAL(resp_frames.frame_buf_size == 5);
+
+    redis_match_frames(&req_frames, &resp_frames, &record_buf);
+    CU_ASSERT(record_buf.req_count == 3);
+    CU_ASSERT(record_buf.resp_count == 5);
+    CU_ASSERT(record_buf.err_count == 1);
+    CU_ASSERT_FATAL(record_buf.record_buf_size == 3);
+    CU_ASSERT(strcmp(record_buf.records[0]->api, "GET") == 0 && !record_buf.records[0]->is_err);
+    CU_ASSERT(strcmp(record_buf.records[1]->api, "SET") == 0 && !record_buf.records[1]->is_err);
+    CU_ASSERT(strcmp(record_buf.records[2]->api, "INCR") == 0 && record_buf.records[2]->is_err);
+    CU_ASSERT(req_frames.current_pos == 3);
+    CU_ASSERT(resp_frames.current_pos == 5);
+
+    for (size_t i = 0; i < record_buf.record_buf_size; i++) {
+        record = (struct redis_record_s *)record_buf.records[i]->record;
+        CU_ASSERT(record_buf.records[i]->latency == 100);
+        free_redis_record(record);
+        free(record_buf.records[i]);
+    }
+    redis_test_free_frames(&req_frames);
+    redis_test_free_frames(&resp_frames);
+}
+
+void TestRedisParser(void)
+{
+    struct raw_data_s *raw_data;
+    struct frame_data_s *frame_data;
+    struct redis_msg_s *msg;
+    parse_state_t state;
+
+    for (size_t i = 0; i < sizeof(g_redis_cases) / sizeof(g_redis_cases[0]); i++) {
+        const struct redis_test_case_s *c = &g_redis_cases[i];
+
+        raw_data = l7_test_raw_data(c->data, strlen(c->data), 1);
+        CU_ASSERT_FATAL(raw_data != NULL);
+        frame_data = NULL;
+        state = redis_parse_frame(c->msg_type, raw_data, &frame_data);
+        CU_ASSERT(state == c->state);
+        CU_ASSERT(raw_data->current_pos == c->current_pos);
+        CU_ASSERT(raw_data->skip_len == c->skip_len);
+        if (state == STATE_SUCCESS && frame_data != NULL) {
+            msg = (struct redis_msg_s *)frame_data->frame;
+            CU_ASSERT(msg->data_type == c->data_type);
+            CU_ASSERT(msg->is_err == c->is_err);
+            CU_ASSERT(msg->is_push == c->is_push);
+            CU_ASSERT(msg->msg_len == c->current_pos + c->skip_len);
+            CU_ASSERT(strcmp(msg->command, (c->command != NULL) ? c->command : "") == 0);
+            free_redis_msg(msg);
+            free(frame_data);
+        } else {
+            CU_ASSERT(frame_data == NULL);
+        }
+        free(raw_data);
+    }
+
+    redis_test_matcher();
+}
+
+#define HTTP_TEST_CHUNKED_REQ   "POST /c HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+#define HTTP_TEST_CHUNKED_RESP  "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+
+struct http_test_case_s {
+    enum message_type_t msg_type;
+    const char *data;
+    parse_state_t state;
+    size_t current_pos;
+    size_t body_size;
+    const char *method_or_msg;  // method of a request, message of a response
+    int status;
+};
+
+static const struct http_test_case_s g_http_cases[] = {
+    {MESSAGE_REQUEST, "GET /a HTTP/1.1\r\nHost: x\r\n\r\n", STATE_SUCCESS, 28, 0, "GET", 0},
+    // Content-Length body followed by the next request
+    {MESSAGE_REQUEST, "POST /c HTTP/1.1\r\nContent-Length: 3\r\n\r\nabcGET", STATE_SUCCESS, 42, 3, "POST", 0},
+    {MESSAGE_REQUEST, "POST /c HTTP/1.1\r\nContent-Length: 5\r\n\r\nab", STATE_NEEDS_MORE_DATA, 0, 0, NULL, 0},
+    {MESSAGE_REQUEST, "POST /c HTTP/1.1\r\nContent-Length: x\r\n\r\n", STATE_INVALID, 1, 0, NULL, 0},
+    // chunks with an extension, the body size is the sum of the chunks
+    {MESSAGE_REQUEST, HTTP_TEST_CHUNKED_REQ "4\r\nwiki\r\n5;x=y\r\npedia\r\n0\r\n\r\n",
+     STATE_SUCCESS, 76, 9, "POST", 0},
+    {MESSAGE_REQUEST, HTTP_TEST_CHUNKED_REQ "4\r\nwi", STATE_NEEDS_MORE_DATA, 0, 0, NULL, 0},
+    {MESSAGE_REQUEST, HTTP_TEST_CHUNKED_REQ "4\r\nwiki\r\n0\r\n", STATE_NEEDS_MORE_DATA, 0, 0, NULL, 0},
+    // chunk not ended by CRLF, and a chunk size which is not hex
+    {MESSAGE_REQUEST, HTTP_TEST_CHUNKED_REQ "4\r\nwikiXX0\r\n\r\n", STATE_INVALID, 1, 0, NULL, 0},
+    {MESSAGE_REQUEST, HTTP_TEST_CHUNKED_REQ "4x\r\nwiki\r\n0\r\n\r\n", STATE_INVALID, 1, 0, NULL, 0},
+    {MESSAGE_RESPONSE, "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nhi", STATE_SUCCESS, 40, 2, "OK", 200},
+    {MESSAGE_RESPONSE, HTTP_TEST_CHUNKED_RESP "A\r\n0123456789\r\n0\r\n\r\n", STATE_SUCCESS, 67, 10, "OK", 200},
+    {MESSAGE_RESPONSE, "HTTP/1.1 204 No Content\r\n\r\n", STATE_SUCCESS, 27, 0, "No Content", 204},
+    // response of a HEAD request, the Content-Length is not followed by a body
+    {MESSAGE_RESPONSE, "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nHTTP/1.1 404 Not Found\r\n\r\n",
+     STATE_SUCCESS, 39, 0, "OK", 200},
+};
+
+struct http_boundary_test_case_s {
+    enum message_type_t msg_type;
+    const char *data;
+    size_t boundary;
+};
+
+static const struct http_boundary_test_case_s g_http_boundary_cases[] = {
+    {MESSAGE_REQUEST, "GET /a HTTP/1.1\r\n\r\n", 0},
+    {MESSAGE_REQUEST, "xxGET /a HTTP/1.1\r\n\r\n", 2},
+    // the method nearest to the end of the headers
+    {MESSAGE_REQUEST, "body GET POST /a HTTP/1.1\r\n\r\n", 9},
+    // the leftover of a body
+    {MESSAGE_RESPONSE, "tail HTTP/1.0 x\r\n\r\nHTTP/1.1 200 OK\r\n\r\n", 5},
+    {MESSAGE_RESPONSE, "tail\r\n\r\nHTTP/1.1 200 OK\r\n\r\n", 8},
+    // headers not received entirely, only a frame starting at the current position is kept
+    {MESSAGE_RESPONSE, "HTTP/1.", 0},
+    {MESSAGE_RESPONSE, "x HTTP/1.1 200 OK\r\n", PARSER_INVALID_BOUNDARY_INDEX},
+    {MESSAGE_REQUEST, "no method\r\n\r\n", PARSER_INVALID_BOUNDARY_INDEX},
+};
+
+void TestHttp1Parser(void)
+{
+    struct raw_data_s *raw_data;
+    struct frame_data_s *frame_data;
+    http_message *msg;
+    parse_state_t state;
+
+    for (size_t i = 0; i < sizeof(g_http_cases) / sizeof(g_http_cases[0]); i++) {
+        const struct http_test_case_s *c = &g_http_cases[i];
+
+        raw_data = l7_test_raw_data(c->data, strlen(c->data), 1);
+        CU_ASSERT_FATAL(raw_data != NULL);
+        frame_data = NULL;
+        state = http_parse_frame(c->msg_type, raw_data, &frame_data);
+        CU_ASSERT(state == c->state);
+        CU_ASSERT(raw_data->current_pos == c->current_pos);
+        if (state == STATE_SUCCESS && frame_data != NULL) {
+            msg = (http_message *)frame_data->frame;
+            CU_ASSERT(msg->body_size == c->body_size);
+            if (c->msg_type == MESSAGE_REQUEST) {
+                CU_ASSERT(msg->req_method != NULL && strcmp(msg->req_method, c->method_or_msg) == 0);
+            } else {
+                CU_ASSERT(msg->resp_message != NULL && strcmp(msg->resp_message, c->method_or_msg) == 0);
+                CU_ASSERT(msg->resp_status == c->status);
+            }
+            free_http_msg(msg);
+            free(frame_data);
+        } else {
+            CU_ASSERT(frame_data == NULL);
+        }
+        free(raw_data);
+    }
+
+    for (size_t i = 0; i < sizeof(g_http_boundary_cases) / sizeof(g_http_boundary_cases[0]); i++) {
+        const struct http_boundary_test_case_s *c = &g_http_boundary_cases[i];
+
+        raw_data = l7_test_raw_data(c->data, strlen(c->data), 1);
+        CU_ASSERT_FATAL(raw_data != NULL);
+        CU_ASSERT(http_find_frame_boundary(c->msg_type, raw_data) == c->boundary);
+        free(raw_data);
+    }
+}
+
+static struct raw_data_s *l7_test_hex_raw_data(const char *hex, u64 timestamp_ns)
+{
+    uint8_t bytes[DNS_TEST_BUF_LEN];
+    size_t len = test_hex_to_bytes(hex, bytes, sizeof(bytes));
+
+    return l7_test_raw_data((const char *)bytes, len, timestamp_ns);
+}
+
+// 64 spaces, a COM_QUERY only waits for the first L7_API_LEN bytes of the SQL
+#define MYSQL_TEST_SPACES16     "20202020202020202020202020202020"
+#define MYSQL_TEST_SPACES64     MYSQL_TEST_SPACES16 MYSQL_TEST_SPACES16 MYSQL_TEST_SPACES16 MYSQL_TEST_SPACES16
+#define MYSQL_TEST_ERR          "ff7a04233432533032"    // error 1146, sql state 42S02
+
+struct mysql_test_case_s {
+    enum message_type_t msg_type;
+    const char *data;       // hex
+    parse_state_t state;
+    size_t current_pos;
+    size_t skip_len;
+    enum mysql_packet_type_t type;
+    uint8_t header;
+    uint64_t column_count;
+    const char *api;
+};
+
+static const struct mysql_test_case_s g_mysql_cases[] = {
+    // COM_QUERY "( select 1", the api is the first keyword of the SQL
+    {MESSAGE_REQUEST, "0b000000" "03" "2820" "73656c656374" "2031",
+     STATE_SUCCESS, 15, 0, MYSQL_PACKET_REQUEST, MYSQL_COM_QUERY, 0, "SELECT"},
+    {MESSAGE_REQUEST, "01000000" "0e", STATE_SUCCESS, 5, 0, MYSQL_PACKET_REQUEST, MYSQL_COM_PING, 0, "PING"},
+    // COM_QUERY of 999 bytes, the body after the first 64 bytes of the SQL is skipped by length
+    {MESSAGE_REQUEST, "e8030000" "03" "696e73657274" MYSQL_TEST_SPACES64,
+     STATE_SUCCESS, 75, 929, MYSQL_PACKET_REQUEST, MYSQL_COM_QUERY, 0, "INSERT"},
+    {MESSAGE_REQUEST, "09000000" "03" "73656c", STATE_NEEDS_MORE_DATA, 0, 0, 0, 0, 0, NULL},
+    // handshake response of the client
+    {MESSAGE_REQUEST, "05000001" "0102030405", STATE_IGNORE, 9, 0, 0, 0, 0, NULL},
+    {MESSAGE_REQUEST, "01000000" "40", STATE_INVALID, 1, 0, 0, 0, 0, NULL},
+    {MESSAGE_REQUEST, "0100", STATE_NEEDS_MORE_DATA, 0, 0, 0, 0, 0, NULL},
+    // handshake of the server, seq_id 0
+    {MESSAGE_RESPONSE, "0a000000" "0a" "352e372e3333" "00" "0102", STATE_IGNORE, 14, 0, 0, 0, 0, NULL},
+    {MESSAGE_RESPONSE, "07000001" "00000002000000", STATE_SUCCESS, 11, 0, MYSQL_PACKET_RESP_FIRST, 0, 0, NULL},
+    {MESSAGE_RESPONSE, "09000001" MYSQL_TEST_ERR, STATE_SUCCESS, 13, 0, MYSQL_PACKET_RESP_FIRST, 0xff, 0, NULL},
+    // result set: column count, EOF, a row, an ERR in the middle
+    {MESSAGE_RESPONSE, "01000001" "02", STATE_SUCCESS, 5, 0, MYSQL_PACKET_RESP_FIRST, 2, 2, NULL},
+    {MESSAGE_RESPONSE, "05000004" "fe00000200", STATE_SUCCESS, 9, 0, MYSQL_PACKET_RESP_EOF, 0xfe, 0, NULL},
+    {MESSAGE_RESPONSE, "02000005" "0131", STATE_IGNORE, 6, 0, 0, 0, 0, NULL},
+    {MESSAGE_RESPONSE, "09000005" MYSQL_TEST_ERR, STATE_SUCCESS, 13, 0, MYSQL_PACKET_RESP_ERR, 0xff, 0, NULL},
+    // a row longer than the raw data
+    {MESSAGE_RESPONSE, "00010005" "0131", STATE_IGNORE, 6, 254, 0, 0, 0, NULL},
+    // empty packet ending a payload of 0xffffff bytes
+    {MESSAGE_RESPONSE, "00000002", STATE_IGNORE, 4, 0, 0, 0, 0, NULL},
+};
+
+/*
+ * Requests and responses of a connection, in the order of their timestamps:
+ * SELECT answered by a result set of 2 columns and 2 rows, COM_STMT_CLOSE without response, a failed DROP,
+ * SELECT failed in the middle of its rows, and a SELECT whose rows are not received yet.
+ */
+static const struct {
+    enum message_type_t msg_type;
+    u64 timestamp_ns;
+    const char *data;       // hex
+} g_mysql_conn[] = {
+    {MESSAGE_REQUEST, 100, "0b000000" "03" "53454c45435420612c62"},
+    {MESSAGE_RESPONSE, 200, "01000001" "02" "03000002" "646566" "03000003" "646566" "05000004" "fe00000200"
+                            "02000005" "0131" "02000006" "0132" "05000007" "fe00000200"},
+    {MESSAGE_REQUEST, 300, "05000000" "1901000000"},
+    {MESSAGE_REQUEST, 400, "07000000" "0364726f702074"},
+    {MESSAGE_RESPONSE, 500, "09000001" MYSQL_TEST_ERR},
+    {MESSAGE_REQUEST, 600, "09000000" "0373656c6563742061"},
+    {MESSAGE_RESPONSE, 700, "01000001" "01" "03000002" "646566" "05000003" "fe00000200" "02000004" "0131"
+                            "09000005" MYSQL_TEST_ERR},
+    {MESSAGE_REQUEST, 800, "09000000" "0373656c6563742062"},
+    {MESSAGE_RESPONSE, 900, "01000001" "01" "03000002" "646566" "05000003" "fe00000200"},
+};
+
+static void mysql_test_free_frames(struct frame_buf_s *frame_buf)
+{
+    for (size_t i = 0; i < frame_buf->frame_buf_size; i++) {
+        free_mysql_packet_msg((struct mysql_packet_msg_s *)frame_buf->frames[i]->frame);
+        free(frame_buf->frames[i]);
+    }
+}
+
+static void mysql_test_matcher(void)
+{
+    static struct frame_buf_s req_frames, resp_frames;
+    static struct record_buf_s record_buf;
+    struct raw_data_s *raw_data;
+    struct frame_buf_s *frame_buf;
+    size_t last_resp_pos = 0;
+
+    memset(&req_frames, 0, sizeof(req_frames));
+    memset(&resp_frames, 0, sizeof(resp_frames));
+    memset(&record_buf, 0, sizeof(record_buf));
+
+    for (size_t i = 0; i < sizeof(g_mysql_conn) / sizeof(g_mysql_conn[0]); i++) {
+        frame_buf = (g_mysql_conn[i].msg_type == MESSAGE_REQUEST) ? &req_frames : &resp_frames;
+        if (i == sizeof(g_mysql_conn) / sizeof(g_mysql_conn[0]) - 1) {
+            last_resp_pos = resp_frames.frame_buf_size;
+        }
+        raw_data = l7_test_hex_raw_data(g_mysql_conn[i].data, g_mysql_conn[i].timestamp_ns);
+        CU_ASSERT_FATAL(raw_data != NULL);
+        (void)l7_test_parse_frames(mysql_parse_frame, g_mysql_conn[i].msg_type, raw_data, frame_buf);
+        CU_ASSERT(raw_data->current_pos == raw_data->data_len);
+        free(raw_data);
+    }
+    // column counts, EOFs and ERRs, column definitions and rows are ignored
+    CU_ASSERT_FATAL(req_frames.frame_buf_size == 5);
+    CU_ASSERT_FATAL(resp_frames.frame_buf_size == 9);
+
+    mysql_match_frames(&req_frames, &resp_frames, &record_buf);
+    CU_ASSERT(record_buf.err_count == 2);
+    CU_ASSERT_FATAL(record_buf.record_buf_size == 3);
+    CU_ASSERT(strcmp(record_buf.records[0]->api, "SELECT") == 0 && !record_buf.records[0]->is_err);
+    CU_ASSERT(record_buf.records[0]->latency == 100);
+    CU_ASSERT(strcmp(record_buf.records[1]->api, "DROP") == 0 && record_buf.records[1]->is_err);
+    CU_ASSERT(strcmp(record_buf.records[2]->api, "SELECT") == 0 && record_buf.records[2]->is_err);
+
+    // the EOF after the column definitions does not end the result set of the last request
+    CU_ASSERT(req_frames.current_pos == 4);
+    CU_ASSERT(resp_frames.current_pos == last_resp_pos);
+
+    for (size_t i = 0; i < record_buf.record_buf_size; i++) {
+        free_mysql_record((struct mysql_record_s *)record_buf.records[i]->record);
+        free(record_buf.records[i]);
+    }
+    mysql_test_free_frames(&req_frames);
+    mysql_test_free_frames(&resp_frames);
+}
+
+void TestMysqlParser(void)
+{
+    struct raw_data_s *raw_data;
+    struct frame_data_s *frame_data;
+    struct mysql_packet_msg_s *msg;
+    parse_state_t state;
+
+    for (size_t i = 0; i < sizeof(g_mysql_cases) / sizeof(g_mysql_cases[0]); i++) {
+        const struct mysql_test_case_s *c = &g_mysql_cases[i];
+
+        raw_data = l7_test_hex_raw_data(c->data, 1);
+        CU_ASSERT_FATAL(raw_data != NULL);
+        frame_data = NULL;
+        state = mysql_parse_frame(c->msg_type, raw_data, &frame_data);
+        CU_ASSERT(state == c->state);
+        CU_ASSERT(raw_data->current_pos == c->current_pos);
+        CU_ASSERT(raw_data->skip_len == c->skip_len);
+        if (state == STATE_SUCCESS && frame_data != NULL) {
+            msg = (struct mysql_packet_msg_s *)frame_data->frame;
+            CU_ASSERT(msg->type == c->type);
+            CU_ASSERT(msg->header == c->header);
+            CU_ASSERT(msg->column_count == c->column_count);
+            CU_ASSERT(strcmp(msg->api, (c->api != NULL) ? c->api : "") == 0);
+            free_mysql_packet_msg(msg);
+            free(frame_data);
+        } else {
+            CU_ASSERT(frame_data == NULL);
+        }
+        free(raw_data);
+    }
+
+    mysql_test_matcher();
+}
+
+// client_id "gala", topic "topic" and a topic id
+#define KAFKA_TEST_CLIENT       "000467616c61"
+#define KAFKA_TEST_TOPIC        "0005746f706963"
+#define KAFKA_TEST_TOPIC_ID     "00112233445566778899aabbccddeeff"
+
+// Produce v7, acks -1, non-flexible
+#define KAFKA_TEST_PRODUCE_V7   "00000025" "0000" "0007" "00000001" KAFKA_TEST_CLIENT \
+                                "ffff" "ffff" "00007530" "00000001" KAFKA_TEST_TOPIC "00000000"
+// Produce v9, acks 0, flexible: compact strings and arrays, tagged fields after the header
+#define KAFKA_TEST_PRODUCE_V9   "00000020" "0000" "0009" "00000002" KAFKA_TEST_CLIENT "00" \
+                                "00" "0000" "00007530" "02" "06746f706963" "01" "00" "00"
+// Fetch v13, flexible, topics are identified by their UUIDs
+#define KAFKA_TEST_FETCH_V13    "0000003b" "0001" "000d" "00000003" KAFKA_TEST_CLIENT "00" \
+                                "ffffffff" "000001f4" "00000001" "00100000" "00" "00000000" "ffffffff" \
+                                "02" KAFKA_TEST_TOPIC_ID "01" "00"
+#define KAFKA_TEST_FETCH_V4     "0000002a" "0001" "0004" "00000004" KAFKA_TEST_CLIENT \
+                                "ffffffff" "000001f4" "00000001" "00100000" "00" "00000001" KAFKA_TEST_TOPIC
+#define KAFKA_TEST_API_VERSIONS "00000017" "0012" "0003" "00000005" KAFKA_TEST_CLIENT "00" "0567616c61" "0231" "00"
+
+struct kafka_test_case_s {
+    enum message_type_t msg_type;
+    const char *data;       // hex
+    parse_state_t state;
+    size_t current_pos;
+    int16_t api_key;
+    int16_t api_version;
+    int32_t correlation_id;
+    char has_resp;
+    const char *topic;
+};
+
+static const struct kafka_test_case_s g_kafka_cases[] = {
+    {MESSAGE_REQUEST, KAFKA_TEST_PRODUCE_V7, STATE_SUCCESS, 41, 0, 7, 1, 1, "topic"},
+    {MESSAGE_REQUEST, KAFKA_TEST_PRODUCE_V9, STATE_SUCCESS, 36, 0, 9, 2, 0, "topic"},
+    {MESSAGE_REQUEST, KAFKA_TEST_FETCH_V13, STATE_SUCCESS, 63, 1, 13, 3, 1, KAFKA_TEST_TOPIC_ID},
+    {MESSAGE_REQUEST, KAFKA_TEST_FETCH_V4, STATE_SUCCESS, 46, 1, 4, 4, 1, "topic"},
+    {MESSAGE_REQUEST, KAFKA_TEST_API_VERSIONS, STATE_SUCCESS, 27, 18, 3, 5, 1, ""},
+    {MESSAGE_REQUEST, "00000025" "0000", STATE_NEEDS_MORE_DATA, 0, 0, 0, 0, 0, NULL},
+    // shorter than a request header
+    {MESSAGE_REQUEST, "00000002" "00000000", STATE_INVALID, 1, 0, 0, 0, 0, NULL},
+    // api key out of range
+    {MESSAGE_REQUEST, "00000008" "7fff" "0000" "00000001", STATE_INVALID, 1, 0, 0, 0, 0, NULL},
+    {MESSAGE_RESPONSE, "00000007" "00000005" "000000", STATE_SUCCESS, 11, 0, 0, 5, 1, ""},
+};
+
+/*
+ * Responses carry their correlation id only, the error code is decoded from the response head with the version of
+ * the request: the Produce v7 fails, no response for acks 0, the Fetch v13 fails, the Fetch v4 succeeds, the
+ * ApiVersions v3 response has no tagged fields in its header. The last response has no request.
+ */
+static const char *g_kafka_conn_resps[] = {
+    "00000021" "00000001" "00000001" KAFKA_TEST_TOPIC "00000001" "00000000" "0006" "ffffffffffffffff",
+    "00000027" "00000003" "00" "00000000" "0000" "00000000" "02" KAFKA_TEST_TOPIC_ID "02" "00000000" "0003",
+    "0000001d" "00000004" "00000000" "00000001" KAFKA_TEST_TOPIC "00000001" "00000000" "0000",
+    "00000007" "00000005" "0000" "00",
+    "00000006" "00000063" "0000",
+};
+
+static void kafka_test_free_frames(struct frame_buf_s *frame_buf)
+{
+    for (size_t i = 0; i < frame_buf->frame_buf_size; i++) {
+        free_kafka_msg((struct kafka_msg_s *)frame_buf->frames[i]->frame);
+        free(frame_buf->frames[i]);
+    }
+}
+
+static void kafka_test_matcher(void)
+{
+    static struct frame_buf_s req_frames, resp_frames;
+    static struct record_buf_s record_buf;
+    struct raw_data_s *raw_data;
+    struct kafka_record_s *record;
+
+    memset(&req_frames, 0, sizeof(req_frames));
+    memset(&resp_frames, 0, sizeof(resp_frames));
+    memset(&record_buf, 0, sizeof(record_buf));
+
+    raw_data = l7_test_hex_raw_data(KAFKA_TEST_PRODUCE_V7 KAFKA_TEST_PRODUCE_V9 KAFKA_TEST_FETCH_V13
+                                    KAFKA_TEST_FETCH_V4 KAFKA_TEST_API_VERSIONS, 100);
+    CU_ASSERT_FATAL(raw_data != NULL);
+    (void)l7_test_parse_frames(kafka_parse_frame, MESSAGE_REQUEST, raw_data, &req_frames);
+    free(raw_data);
+    for (size_t i = 0; i < sizeof(g_kafka_conn_resps) / sizeof(g_kafka_conn_resps[0]); i++) {
+        raw_data = l7_test_hex_raw_data(g_kafka_conn_resps[i], 200);
+        CU_ASSERT_FATAL(raw_data != NULL);
+        (void)l7_test_parse_frames(kafka_parse_frame, MESSAGE_RESPONSE, raw_data, &resp_frames);
+        CU_ASSERT(raw_data->current_pos == raw_data->data_len);
+        free(raw_data);
+    }
+    CU_ASSERT_FATAL(req_frames.frame_buf_size == 5);
+    CU_ASSERT_FATAL(resp_frames.frame_buf_size == 5);
+
+    kafka_match_frames(&req_frames, &resp_frames, &record_buf);
+    CU_ASSERT(record_buf.err_count == 2);
+    CU_ASSERT_FATAL(record_buf.record_buf_size == 4);
+    CU_ASSERT(strcmp(record_buf.records[0]->api, "Produce topic") == 0);
+    CU_ASSERT(strcmp(record_buf.records[1]->api, "Fetch " KAFKA_TEST_TOPIC_ID) == 0);
+    CU_ASSERT(strcmp(record_buf.records[2]->api, "Fetch topic") == 0);
+    CU_ASSERT(strcmp(record_buf.records[3]->api, "ApiVersions") == 0);
+    CU_ASSERT(resp_frames.current_pos == 5);
+
+    for (size_t i = 0; i < record_buf.record_buf_size; i++) {
+        static const int16_t error_codes[] = {6, 3, 0, 0};
+
+        record = (struct kafka_record_s *)record_buf.records[i]->record;
+        CU_ASSERT(record->error_code == error_codes[i]);
+        CU_ASSERT(record_buf.records[i]->is_err == (error_codes[i] != 0));
+        CU_ASSERT(record_buf.records[i]->latency == 100);
+        free_kafka_record(record);
+        free(record_buf.records[i]);
+    }
+    kafka_test_free_frames(&req_frames);
+    kafka_test_free_frames(&resp_frames);
+}
+
+void TestKafkaParser(void)
+{
+    struct raw_data_s *raw_data;
+    struct frame_data_s *frame_data;
+    struct kafka_msg_s *msg;
+    parse_state_t state;
+    char big[KAFKA_LENGTH_SIZE + KAFKA_MSG_HEAD_LEN] = {0};
+    size_t len;
+
+    for (size_t i = 0; i < sizeof(g_kafka_cases) / sizeof(g_kafka_cases[0]); i++) {
+        const struct kafka_test_case_s *c = &g_kafka_cases[i];
+
+        raw_data = l7_test_hex_raw_data(c->data, 1);
+        CU_ASSERT_FATAL(raw_data != NULL);
+        frame_data = NULL;
+        state = kafka_parse_frame(c->msg_type, raw_data, &frame_data);
+        CU_ASSERT(state == c->state);
+        CU_ASSERT(raw_data->current_pos == c->current_pos);
+        CU_ASSERT(raw_data->skip_len == 0);
+        if (state == STATE_SUCCESS && frame_data != NULL) {
+            msg = (struct kafka_msg_s *)frame_data->frame;
+            CU_ASSERT(msg->correlation_id == c->correlation_id);
+            CU_ASSERT(msg->has_resp == c->has_resp);
+            if (c->msg_type == MESSAGE_REQUEST) {
+                CU_ASSERT(msg->api_key == c->api_key);
+                CU_ASSERT(msg->api_version == c->api_version);
+                CU_ASSERT(strcmp(msg->topic, c->topic) == 0);
+            } else {
+                CU_ASSERT(msg->resp_head != NULL);
+            }
+            free_kafka_msg(msg);
+            free(frame_data);
+        } else {
+            CU_ASSERT(frame_data == NULL);
+        }
+        free(raw_data);
+    }
+
+    // Produce v7 of 1024 bytes, the records after the head are skipped by length
+    len = test_hex_to_bytes(KAFKA_TEST_PRODUCE_V7, (uint8_t *)big, sizeof(big));
+    CU_ASSERT_FATAL(len == 41);
+    big[2] = 0x04;
+    big[3] = 0x00;
+    raw_data = l7_test_raw_data(big, sizeof(big), 1);
+    CU_ASSERT_FATAL(raw_data != NULL);
+    frame_data = NULL;
+    CU_ASSERT(kafka_parse_frame(MESSAGE_REQUEST, raw_data, &frame_data) == STATE_SUCCESS);
+    CU_ASSERT(raw_data->current_pos == sizeof(big));
+    CU_ASSERT(raw_data->skip_len == 1024 - KAFKA_MSG_HEAD_LEN);
+    if (frame_data != NULL) {
+        CU_ASSERT(strcmp(((struct kafka_msg_s *)frame_data->frame)->topic, "topic") == 0);
+        free_kafka_msg((struct kafka_msg_s *)frame_data->frame);
+        free(frame_data);
+    }
+    free(raw_data);
+
+    kafka_test_matcher();
+}
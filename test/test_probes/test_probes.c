@@ -12,14 +12,43 @@
  * Create: 2021-04-26
  * Description: provide gala-gopher test
  ******************************************************************************/
+#define _GNU_SOURCE
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <elf.h>
 #include <string.h>
+#include <errno.h>
 #include <dirent.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <pthread.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include <linux/bpf.h>
+#include <bpf/bpf.h>
+#include <bpf/libbpf.h>
 #include <CUnit/Basic.h>
 #include "probe.h"
 #include "../../probes/system_infos.probe/system_cpu.h"
+#include "../../probes/system_infos.probe/system_disk.h"
+#include "../../probes/system_infos.probe/system_meminfo.h"
+#include "../../probes/system_infos.probe/system_procs.h"
+#include "../../probes/system_infos.probe/proc_file.h"
+#include "../../probes/extends/ebpf.probe/src/include/histogram.h"
+#include "../../probes/extends/ebpf.probe/src/include/blk_topo.h"
+#include "../../probes/extends/ebpf.probe/src/include/tcp.h"
+#include "../../probes/extends/ebpf.probe/src/include/pin_state.h"
+#include "../../probes/extends/ebpf.probe/src/include/bpf_load.h"
+#include "../../probes/extends/ebpf.probe/src/include/dwarf_unwind.h"
+#include "../../probes/extends/ebpf.probe/src/include/debug_elf_reader.h"
+#include "../../probes/extends/ebpf.probe/src/include/elf_symb.h"
 
 
 #define EVENT_ERR_CODE "code=[13]"
@@ -184,6 +213,8 @@ void TestSystemDiskProbe(void)
     struct probe_params params;
     ret = system_iostat_init();
     CU_ASSERT(ret == 0);
+    ret = system_disk_init();
+    CU_ASSERT(ret == 0);
 
     g_probe = ProbeCreate();
     CU_ASSERT(g_probe != NULL);
@@ -222,6 +253,7 @@ void TestSystemDiskProbe(void)
 
         ProbeDestroy(g_probe);
     }
+    system_disk_destroy();
     system_iostat_destroy();
 }
 
@@ -366,6 +398,1076 @@ void TestSystemProcProbe(void)
     system_proc_destroy();
 }
 
+static int rm_fixture_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+    return remove(path);
+}
+
+static void rm_fixture_dir(const char *dir)
+{
+    CU_ASSERT(nftw(dir, rm_fixture_entry, 16, FTW_DEPTH | FTW_PHYS) == 0);
+}
+
+// like 'mkdir -p <root>/<name>'
+static void mk_fixture_dir(const char *root, const char *name)
+{
+    char path[PATH_LEN];
+
+    (void)snprintf(path, sizeof(path), "%s/%s", root, name);
+    for (char *p = path + strlen(root) + 1; *p != 0; p++) {
+        if (*p == '/') {
+            *p = 0;
+            (void)mkdir(path, 0755);
+            *p = '/';
+        }
+    }
+    CU_ASSERT(mkdir(path, 0755) == 0 || errno == EEXIST);
+}
+
+static void write_fixture_file(const char *root, const char *name, const char *content)
+{
+    char path[PATH_LEN];
+    FILE *f;
+
+    (void)snprintf(path, sizeof(path), "%s/%s", root, name);
+    f = fopen(path, "w");
+    CU_ASSERT_FATAL(f != NULL);
+    (void)fputs(content, f);
+    (void)fclose(f);
+}
+
+static void link_fixture(const char *root, const char *target, const char *name)
+{
+    char path[PATH_LEN];
+
+    (void)snprintf(path, sizeof(path), "%s/%s", root, name);
+    CU_ASSERT(symlink(target, path) == 0);
+}
+
+#define PROC_FIXTURE_MOUNTINFO_LEN  1024
+
+static void write_mountinfo_fixture(const char *root)
+{
+    char buf[PROC_FIXTURE_MOUNTINFO_LEN];
+
+    // dummy fs, "mnt a" with its space escaped, a longer mount of the same device, a missing mount point, ro
+    (void)snprintf(buf, sizeof(buf),
+        "20 1 0:5 / /proc rw,nosuid - proc proc rw\n"
+        "30 1 8:2 / %s/mnt\\040a rw,relatime shared:1 - ext4 /dev/sda2 rw\n"
+        "31 30 8:2 /sub %s/mnt\\040a/sub rw,relatime shared:1 - ext4 /dev/sda2 rw\n"
+        "32 1 8:3 / %s/missing rw,relatime - xfs /dev/sda3 rw\n"
+        "33 1 8:5 / %s/ro ro,noatime master:2 shared:3 - xfs /dev/sdb1 ro\n",
+        root, root, root, root);
+    write_fixture_file(root, "self/mountinfo", buf);
+}
+
+static void test_proc_stat_fixture(const char *root)
+{
+    proc_info_t info;
+
+    // comm with spaces and ')'
+    write_fixture_file(root, "42/stat", "42 (a b) c) S 1 42 42 0 -1 4194560 10 0 0 0 7 3 0 0 20 0 1 0 9527 1 2 0\n");
+    (void)memset(&info, 0, sizeof(info));
+    CU_ASSERT(get_proc_stat(42, &info) == 0);
+    CU_ASSERT(strcmp(info.comm, "a b) c") == 0);
+    CU_ASSERT(info.ppid == 1);
+    CU_ASSERT(info.pgid == 42);
+    CU_ASSERT(info.proc_stat_min_flt == 10);
+    CU_ASSERT(info.proc_stat_utime == 7);
+    CU_ASSERT(info.proc_stat_stime == 3);
+    CU_ASSERT(info.proc_stat_num_threads == 1);
+    CU_ASSERT(info.proc_start_time == 9527);
+    CU_ASSERT(info.proc_stat_rss == 2);
+
+    // comm is only ')', or starts and ends with spaces
+    write_fixture_file(root, "43/stat", "43 ()) R 42 43 42 0 -1 0 5 0 0 0 0 0 0 0 20 0 1 0 100 0 0 0\n");
+    (void)memset(&info, 0, sizeof(info));
+    CU_ASSERT(get_proc_stat(43, &info) == 0);
+    CU_ASSERT(strcmp(info.comm, ")") == 0);
+    CU_ASSERT(info.ppid == 42);
+    CU_ASSERT(info.pgid == 43);
+    CU_ASSERT(info.proc_start_time == 100);
+
+    write_fixture_file(root, "44/stat", "44 ( x (y) ) S 43 44 42 0 -1 0 0 0 0 0 0 0 0 0 20 0 3 0 200 0 0 0\n");
+    (void)memset(&info, 0, sizeof(info));
+    CU_ASSERT(get_proc_stat(44, &info) == 0);
+    CU_ASSERT(strcmp(info.comm, " x (y) ") == 0);
+    CU_ASSERT(info.ppid == 43);
+    CU_ASSERT(info.proc_stat_num_threads == 3);
+    CU_ASSERT(info.proc_start_time == 200);
+
+    // no comm, or the process is gone
+    write_fixture_file(root, "45/stat", "45 S 1 45 45\n");
+    CU_ASSERT(get_proc_stat(45, &info) != 0);
+    CU_ASSERT(get_proc_stat(46, &info) != 0);
+}
+
+void TestProcFileFixture(void)
+{
+    uint32_t ret;
+    int df_num = 0;
+    char *elemP = NULL;
+    char root[] = "/tmp/gala-gopher-proc-XXXXXX";
+    char expect[PATH_LEN];
+    char expect_ro[PATH_LEN];
+    struct proc_file_s pf = PROC_FILE_INITIALIZER;
+    struct proc_tok_s tok, line;
+    struct str_view_s field;
+    struct ipc_body_s ipc_body = {0};
+
+    ipc_body.probe_param.period = 5;
+    CU_ASSERT_FATAL(mkdtemp(root) != NULL);
+    mk_fixture_dir(root, "42");
+    mk_fixture_dir(root, "43");
+    mk_fixture_dir(root, "44");
+    mk_fixture_dir(root, "45");
+    mk_fixture_dir(root, "self");
+    mk_fixture_dir(root, "sys/fs");
+    mk_fixture_dir(root, "mnt a/sub");
+    mk_fixture_dir(root, "ro");
+
+    write_fixture_file(root, "diskstats",
+        "   8       0 sda 100 0 800 20 50 0 400 10 0 60 30 0 0 0 0\n"
+        " 253       0 dm-0 10 0 80 2 5 0 40 1 0 6 3 0 0 0 0\n");
+    write_fixture_file(root, "sys/fs/dentry-state", "12345\t6789\t45\t0\t0\t0\n");
+    write_mountinfo_fixture(root);
+    set_proc_root(root);
+
+    // tokenizer, comm with spaces and ')'
+    write_fixture_file(root, "42/stat", "42 (a b) c) S 1 42 42 0 -1 4194560 10 0 0 0 7 3 0 0 20 0 1 0 9527 1 2 0\n");
+    ret = load_proc_file(&pf, "42/stat");
+    CU_ASSERT(ret == 0);
+    proc_file_tok(&pf, &tok);
+    CU_ASSERT(proc_tok_line(&tok, &line) == 0);
+    CU_ASSERT(proc_tok_skip(&line, 3) == 0);
+    CU_ASSERT(proc_tok_next(&line, &field) == 0);
+    CU_ASSERT(str_view_eq(&field, "c)"));
+    CU_ASSERT(proc_tok_next(&line, &field) == 0);
+    CU_ASSERT(str_view_eq(&field, "S"));
+    CU_ASSERT(proc_tok_line(&tok, &line) != 0);
+    free_proc_file(&pf);
+
+    test_proc_stat_fixture(root);
+
+    g_probe = ProbeCreate();
+    CU_ASSERT_FATAL(g_probe != NULL);
+
+    // iostat, the second period is computed from the change of the fixture
+    ret = system_iostat_init();
+    CU_ASSERT(ret == 0);
+    ret = system_iostat_probe(&ipc_body);
+    CU_ASSERT(ret == 0);
+    write_fixture_file(root, "diskstats",
+        "   8       0 sda 150 0 1800 70 50 0 400 10 0 560 530 0 0 0 0\n"
+        " 253       0 dm-0 10 0 80 2 5 0 40 1 0 6 3 0 0 0 0\n");
+    g_probe->fifo->in = 0;
+    g_probe->fifo->out = 0;
+    ret = system_iostat_probe(&ipc_body);
+    CU_ASSERT(ret == 0);
+    ret = FifoGet(g_probe->fifo, (void **)&elemP);
+    CU_ASSERT(ret == 0);
+    CU_ASSERT(elemP != NULL && strstr(elemP, "|system_iostat|sda|10.00|100.00|1.00|10.00|0.00|0.00|0.00|0.00|0.10|10.00|") != NULL);
+    ret = FifoGet(g_probe->fifo, (void **)&elemP);
+    CU_ASSERT(ret == 0);
+    CU_ASSERT(elemP != NULL && strstr(elemP, "|system_iostat|dm-0|0.00|") != NULL);
+    system_iostat_destroy();
+
+    // dentry-state follows the meminfo record
+    g_probe->fifo->in = 0;
+    g_probe->fifo->out = 0;
+    ret = system_meminfo_init();
+    CU_ASSERT(ret == 0);
+    ret = system_meminfo_probe(&ipc_body);
+    CU_ASSERT(ret == 0);
+    ret = FifoGet(g_probe->fifo, (void **)&elemP);
+    CU_ASSERT(ret == 0);
+    ret = FifoGet(g_probe->fifo, (void **)&elemP);
+    CU_ASSERT(ret == 0);
+    CU_ASSERT(elemP != NULL && strstr(elemP, "|system_dentry|fs.dentry-state|12345|6789|45|") != NULL);
+    system_meminfo_destroy();
+
+    // df from mountinfo and statfs(): dummy fs, missing mount points and longer mounts of a device are hidden
+    g_probe->fifo->in = 0;
+    g_probe->fifo->out = 0;
+    ret = system_disk_init();
+    CU_ASSERT(ret == 0);
+    ret = system_disk_probe(&ipc_body);
+    CU_ASSERT(ret == 0);
+    (void)snprintf(expect, sizeof(expect), "|system_df|%s/mnt a|rw|/dev/sda2|ext4|", root);
+    (void)snprintf(expect_ro, sizeof(expect_ro), "|system_df|%s/ro|ro|/dev/sdb1|xfs|", root);
+    while (FifoGet(g_probe->fifo, (void **)&elemP) == 0) {
+        CU_ASSERT(strstr(elemP, expect) != NULL || strstr(elemP, expect_ro) != NULL);
+        df_num++;
+    }
+    CU_ASSERT(df_num == 2);
+    system_disk_destroy();
+
+    ProbeDestroy(g_probe);
+    set_proc_root(NULL);
+    rm_fixture_dir(root);
+    CU_ASSERT(access(root, F_OK) != 0);
+}
+
+#define HISTO_TEST_LOWEST   1000
+#define HISTO_TEST_HIGHEST  (60 * NSEC_PER_SEC)
+#define HISTO_TEST_NUM      10000
+
+static int histo_cmp_value(const void *a, const void *b)
+{
+    u64 x = *(const u64 *)a, y = *(const u64 *)b;
+    return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+static void histo_test_values(u64 values[], int num, u64 seed)
+{
+    // log-uniform values between 1us and ~1s
+    for (int i = 0; i < num; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        values[i] = HISTO_TEST_LOWEST << ((seed >> 33) % 20);
+        values[i] += (seed >> 13) % values[i];
+    }
+}
+
+static void histo_test_quantiles(int sig_digits)
+{
+    u64 *values;
+    u64 expect, value;
+    double bound = 1.0;
+    const double qs[] = {0.5, 0.9, 0.99, 0.999, 1.0};
+    struct histo_s *histo = create_histo(HISTO_TEST_LOWEST, HISTO_TEST_HIGHEST, sig_digits);
+
+    CU_ASSERT_FATAL(histo != NULL);
+    values = (u64 *)malloc(HISTO_TEST_NUM * sizeof(u64));
+    CU_ASSERT_FATAL(values != NULL);
+
+    for (int i = 0; i < sig_digits; i++) {
+        bound /= 10;
+    }
+    histo_test_values(values, HISTO_TEST_NUM, (u64)sig_digits);
+    for (int i = 0; i < HISTO_TEST_NUM; i++) {
+        CU_ASSERT(histo_add_value(histo, values[i]) == 0);
+    }
+    qsort(values, HISTO_TEST_NUM, sizeof(u64), histo_cmp_value);
+
+    CU_ASSERT(histo->total_count == HISTO_TEST_NUM);
+    CU_ASSERT(histo->min == values[0]);
+    CU_ASSERT(histo->max == values[HISTO_TEST_NUM - 1]);
+    for (int i = 0; i < sizeof(qs) / sizeof(qs[0]); i++) {
+        expect = values[(int)(qs[i] * HISTO_TEST_NUM + 0.5) - 1];
+        value = histo_value_at_quantile(histo, qs[i]);
+        CU_ASSERT(value >= expect);
+        CU_ASSERT((double)(value - expect) <= (double)expect * bound);
+    }
+
+    free(values);
+    destroy_histo(histo);
+}
+
+void TestHistogram(void)
+{
+    int len;
+    float p99;
+    char buf[8192];
+    u64 values[HISTO_TEST_NUM];
+    struct histo_s *a, *b, *c, *other;
+
+    histo_test_quantiles(1);
+    histo_test_quantiles(2);
+    histo_test_quantiles(3);
+
+    CU_ASSERT(create_histo(HISTO_TEST_LOWEST, HISTO_TEST_HIGHEST, 0) == NULL);
+    CU_ASSERT(create_histo(HISTO_TEST_LOWEST, HISTO_TEST_LOWEST, 2) == NULL);
+
+    a = create_histo(HISTO_TEST_LOWEST, HISTO_TEST_HIGHEST, 2);
+    b = create_histo(HISTO_TEST_LOWEST, HISTO_TEST_HIGHEST, 2);
+    c = create_histo(HISTO_TEST_LOWEST, HISTO_TEST_HIGHEST, 2);
+    other = create_histo(HISTO_TEST_LOWEST, HISTO_TEST_HIGHEST, 1);
+    CU_ASSERT_FATAL(a != NULL && b != NULL && c != NULL && other != NULL);
+
+    CU_ASSERT(histo_value(a, HISTO_P99, &p99) == -1);
+
+    // Values above highest are counted as highest
+    CU_ASSERT(histo_add_value(a, HISTO_TEST_HIGHEST * 2) == 0);
+    CU_ASSERT(histo_value_at_quantile(a, 1.0) == HISTO_TEST_HIGHEST);
+    histo_reset(a);
+    CU_ASSERT(a->total_count == 0);
+
+    histo_test_values(values, HISTO_TEST_NUM, 100);
+    for (int i = 0; i < HISTO_TEST_NUM; i++) {
+        (void)histo_add_value((i % 2) ? a : b, values[i]);
+        (void)histo_add_value(c, values[i]);
+    }
+
+    // merge(a, b) == c, then subtract(c, b) == a
+    CU_ASSERT(histo_merge(a, other) == -1);
+    CU_ASSERT(histo_merge(a, b) == 0);
+    CU_ASSERT(a->total_count == c->total_count);
+    CU_ASSERT(memcmp(a->counts, c->counts, a->counts_len * sizeof(u64)) == 0);
+    CU_ASSERT(histo_subtract(c, b) == 0);
+    CU_ASSERT(c->total_count == HISTO_TEST_NUM / 2);
+    CU_ASSERT(histo_subtract(b, a) == -1);
+
+    // serialize(a) + deserialize == a
+    len = histo_serialize(a, buf, sizeof(buf));
+    CU_ASSERT_FATAL(len > 0);
+    CU_ASSERT(len < a->counts_len * sizeof(u64));
+    CU_ASSERT(histo_serialize(a, buf, 4) == -1);
+    CU_ASSERT(histo_deserialize(other, buf, len) == -1);
+    CU_ASSERT(histo_deserialize(b, buf, len - 1) == -1);
+    histo_reset(b);
+    CU_ASSERT(histo_deserialize(b, buf, len) == 0);
+    CU_ASSERT(b->total_count == a->total_count && b->min == a->min && b->max == a->max);
+    CU_ASSERT(memcmp(a->counts, b->counts, a->counts_len * sizeof(u64)) == 0);
+    CU_ASSERT(histo_value(b, HISTO_P99, &p99) == 0);
+    CU_ASSERT(p99 == (float)histo_value_at_quantile(a, 0.99));
+
+    destroy_histo(a);
+    destroy_histo(b);
+    destroy_histo(c);
+    destroy_histo(other);
+}
+
+#define BLK_FIXTURE_DISK    "devices/pci0000:00/0000:00:1f.2/ata1/block/sda"
+#define BLK_FIXTURE_DM      "devices/virtual/block/dm-0"
+
+void TestBlkTopo(void)
+{
+    char root[] = "/tmp/gala-gopher-sysfs-XXXXXX";
+    char dev_name[DISK_NAME_LEN];
+    char disk_name[DISK_NAME_LEN];
+    struct blk_topo_s *topo;
+    struct blk_dev_s *dev;
+
+    CU_ASSERT_FATAL(mkdtemp(root) != NULL);
+
+    // sda with partition sda2, dm-0(vg-root) on top of sda2
+    mk_fixture_dir(root, BLK_FIXTURE_DISK "/sda2");
+    mk_fixture_dir(root, BLK_FIXTURE_DM "/dm");
+    mk_fixture_dir(root, BLK_FIXTURE_DM "/slaves");
+    mk_fixture_dir(root, "class/block");
+    write_fixture_file(root, BLK_FIXTURE_DISK "/dev", "8:0\n");
+    write_fixture_file(root, BLK_FIXTURE_DISK "/sda2/dev", "8:2\n");
+    write_fixture_file(root, BLK_FIXTURE_DISK "/sda2/partition", "2\n");
+    write_fixture_file(root, BLK_FIXTURE_DM "/dev", "253:0\n");
+    write_fixture_file(root, BLK_FIXTURE_DM "/dm/name", "vg-root\n");
+    link_fixture(root, "../../../../../" BLK_FIXTURE_DISK "/sda2", BLK_FIXTURE_DM "/slaves/sda2");
+    link_fixture(root, "../../" BLK_FIXTURE_DISK, "class/block/sda");
+    link_fixture(root, "../../" BLK_FIXTURE_DISK "/sda2", "class/block/sda2");
+    link_fixture(root, "../../" BLK_FIXTURE_DM, "class/block/dm-0");
+
+    topo = create_blk_topo(root);
+    CU_ASSERT_FATAL(topo != NULL);
+    CU_ASSERT(topo->uevent_fd < 0);
+
+    // partition -> disk
+    dev = blk_topo_find(topo, 8, 2);
+    CU_ASSERT_FATAL(dev != NULL);
+    CU_ASSERT(dev->is_partition == 1);
+    CU_ASSERT(strcmp(dev->parent, "sda") == 0);
+    CU_ASSERT(strcmp(dev->devpath, "/" BLK_FIXTURE_DISK "/sda2") == 0);
+    blk_topo_get_names(topo, 8, 2, dev_name, disk_name, DISK_NAME_LEN);
+    CU_ASSERT(strcmp(dev_name, "sda2") == 0);
+    CU_ASSERT(strcmp(disk_name, "sda") == 0);
+
+    blk_topo_get_names(topo, 8, 0, dev_name, disk_name, DISK_NAME_LEN);
+    CU_ASSERT(strcmp(dev_name, "sda") == 0);
+    CU_ASSERT(strcmp(disk_name, "sda") == 0);
+
+    // dm/name, then slaves -> partition -> disk
+    dev = blk_topo_find(topo, 253, 0);
+    CU_ASSERT_FATAL(dev != NULL);
+    CU_ASSERT(dev->is_partition == 0);
+    CU_ASSERT(strcmp(dev->kname, "dm-0") == 0);
+    CU_ASSERT(strcmp(dev->slave, "sda2") == 0);
+    blk_topo_get_names(topo, 253, 0, dev_name, disk_name, DISK_NAME_LEN);
+    CU_ASSERT(strcmp(dev_name, "vg-root") == 0);
+    CU_ASSERT(strcmp(disk_name, "sda") == 0);
+
+    blk_topo_get_names(topo, 8, 16, dev_name, disk_name, DISK_NAME_LEN);
+    CU_ASSERT(dev_name[0] == 0 && disk_name[0] == 0);
+
+    // unknown to the topology, then found in sysfs
+    CU_ASSERT(blk_topo_dev_exists(topo, 8, 0) == 1);
+    CU_ASSERT(blk_topo_dev_exists(topo, 8, 16) == 0);
+    mk_fixture_dir(root, "dev/block/8:16");
+    CU_ASSERT(blk_topo_dev_exists(topo, 8, 16) == 1);
+
+    CU_ASSERT(blk_topo_has_devpath(topo, "ata1") == 1);
+    CU_ASSERT(blk_topo_has_devpath(topo, "nvme") == 0);
+    CU_ASSERT(blk_topo_update(topo) == 0);
+    destroy_blk_topo(topo);
+
+    rm_fixture_dir(root);
+    CU_ASSERT(access(root, F_OK) != 0);
+    CU_ASSERT(create_blk_topo(root) == NULL);
+}
+
+static unsigned short get_sock_port(int fd)
+{
+    struct sockaddr_in addr = {0};
+    socklen_t len = sizeof(addr);
+
+    if (getsockname(fd, (struct sockaddr *)&addr, &len) != 0) {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+static struct tcp_estab *find_estab(struct tcp_estabs *tes, unsigned short lport, unsigned short rport)
+{
+    for (int i = 0; i < tes->te_num; i++) {
+        if (tes->te[i]->local.port == lport && tes->te[i]->remote.port == rport) {
+            return tes->te[i];
+        }
+    }
+    return NULL;
+}
+
+static char is_estab_owner(const struct tcp_estab *te, unsigned int pid, int fd)
+{
+    for (int i = 0; i < te->te_comm_num; i++) {
+        if (te->te_comm[i]->pid == pid && te->te_comm[i]->fd == (unsigned int)fd) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void TestTcpSockDiag(void)
+{
+    int listen_fd, client_fd, server_fd;
+    unsigned short lport, cport;
+    struct sockaddr_in addr = {0};
+    struct tcp_listen_ports *tlps = NULL;
+    struct tcp_estabs *tes = NULL;
+    struct tcp_listen_port *tlp = NULL;
+    struct tcp_estab *te;
+    unsigned int pid = (unsigned int)getpid();
+
+    // loopback listener and one connection to it, all owned by this process
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    CU_ASSERT_FATAL(listen_fd >= 0);
+    CU_ASSERT_FATAL(bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    CU_ASSERT_FATAL(listen(listen_fd, 1) == 0);
+    lport = get_sock_port(listen_fd);
+    CU_ASSERT_FATAL(lport != 0);
+
+    addr.sin_port = htons(lport);
+    client_fd = socket(AF_INET, SOCK_STREAM, 0);
+    CU_ASSERT_FATAL(client_fd >= 0);
+    CU_ASSERT_FATAL(connect(client_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    server_fd = accept(listen_fd, NULL, NULL);
+    CU_ASSERT_FATAL(server_fd >= 0);
+    cport = get_sock_port(client_fd);
+
+    CU_ASSERT_FATAL(get_listen_estab_tcps(&tlps, &tes) == 0);
+    CU_ASSERT_FATAL(tlps != NULL && tes != NULL);
+
+    CU_ASSERT(is_listen_port(lport, tlps) == 1);
+    CU_ASSERT(is_listen_port(cport, tlps) == 0);
+    for (int i = 0; i < tlps->tlp_num; i++) {
+        if (tlps->tlp[i]->port == lport) {
+            tlp = tlps->tlp[i];
+        }
+    }
+    CU_ASSERT(tlp != NULL && tlp->pid == pid && tlp->fd == (unsigned int)listen_fd);
+
+    // server side: local port is the listen port
+    te = find_estab(tes, lport, cport);
+    CU_ASSERT(te != NULL);
+    if (te != NULL) {
+        CU_ASSERT(te->is_client == 0);
+        CU_ASSERT(te->local.ipv4 == 1);
+        CU_ASSERT(strcmp(te->local.ip, "127.0.0.1") == 0);
+        CU_ASSERT(is_estab_owner(te, pid, server_fd) == 1);
+    }
+
+    // client side
+    te = find_estab(tes, cport, lport);
+    CU_ASSERT(te != NULL);
+    if (te != NULL) {
+        CU_ASSERT(te->is_client == 1);
+        CU_ASSERT(strcmp(te->remote.ip, "127.0.0.1") == 0);
+        CU_ASSERT(is_estab_owner(te, pid, client_fd) == 1);
+    }
+
+    free_listen_ports(&tlps);
+    free_estab_tcps(&tes);
+    (void)close(server_fd);
+    (void)close(client_fd);
+    (void)close(listen_fd);
+}
+
+#define PIN_FIXTURE_MAPS    2
+
+// Stands for the load of a skeleton, which creates and pins the maps.
+static int pin_fixture_maps(const struct pin_state_geo_s *geos, const char *const *paths)
+{
+    union bpf_attr attr;
+    int fd, ret;
+
+    for (int i = 0; i < PIN_FIXTURE_MAPS; i++) {
+        (void)memset(&attr, 0, sizeof(attr));
+        attr.map_type = geos[i].type;
+        attr.key_size = geos[i].key_size;
+        attr.value_size = geos[i].value_size;
+        attr.max_entries = geos[i].max_entries;
+        fd = (int)syscall(__NR_bpf, BPF_MAP_CREATE, &attr, sizeof(attr));
+        if (fd < 0) {
+            return -1;
+        }
+        ret = bpf_obj_pin(fd, paths[i]);
+        (void)close(fd);
+        if (ret != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static char is_pinned(const char *path)
+{
+    return (access(path, F_OK) == 0) ? 1 : 0;
+}
+
+void TestPinStateLayout(void)
+{
+    char root[] = "/sys/fs/bpf/gala-gopher-test-XXXXXX";
+    char layout[PATH_LEN], socks[PATH_LEN], links[PATH_LEN];
+    const char *paths[PIN_FIXTURE_MAPS] = {links, socks};
+    struct pin_state_geo_s geos[PIN_FIXTURE_MAPS] = {
+        {BPF_MAP_TYPE_LRU_HASH, sizeof(u64), 64, 1024},
+        {BPF_MAP_TYPE_LRU_HASH, sizeof(u64), 16, 1024}
+    };
+
+    // needs a bpffs and the privilege to create maps
+    if (mkdtemp(root) == NULL) {
+        printf("pin state test skipped, no bpffs: %s\n", strerror(errno));
+        return;
+    }
+    (void)snprintf(layout, sizeof(layout), "%s/layout", root);
+    (void)snprintf(links, sizeof(links), "%s/links", root);
+    (void)snprintf(socks, sizeof(socks), "%s/socks", root);
+
+    // nothing pinned: the layout is pinned, the maps are to be created
+    CU_ASSERT(pin_state_check_layout(layout, 1, geos, paths, PIN_FIXTURE_MAPS) == 0);
+    CU_ASSERT(is_pinned(layout) == 1);
+    CU_ASSERT_FATAL(pin_fixture_maps(geos, paths) == 0);
+
+    // same layout: reused, nothing unlinked
+    CU_ASSERT(pin_state_check_layout(layout, 1, geos, paths, PIN_FIXTURE_MAPS) == 1);
+    CU_ASSERT(is_pinned(links) == 1 && is_pinned(socks) == 1);
+
+    // version bumped
+    CU_ASSERT(pin_state_check_layout(layout, 2, geos, paths, PIN_FIXTURE_MAPS) == 0);
+    CU_ASSERT(is_pinned(links) == 0 && is_pinned(socks) == 0 && is_pinned(layout) == 1);
+    CU_ASSERT_FATAL(pin_fixture_maps(geos, paths) == 0);
+    CU_ASSERT(pin_state_check_layout(layout, 2, geos, paths, PIN_FIXTURE_MAPS) == 1);
+
+    // geometry changed: map type, then max entries
+    geos[1].type = BPF_MAP_TYPE_HASH;
+    CU_ASSERT(pin_state_check_layout(layout, 2, geos, paths, PIN_FIXTURE_MAPS) == 0);
+    CU_ASSERT(is_pinned(links) == 0 && is_pinned(socks) == 0);
+    CU_ASSERT_FATAL(pin_fixture_maps(geos, paths) == 0);
+    geos[0].max_entries = 2048;
+    CU_ASSERT(pin_state_check_layout(layout, 2, geos, paths, PIN_FIXTURE_MAPS) == 0);
+    CU_ASSERT(is_pinned(links) == 0 && is_pinned(socks) == 0);
+    CU_ASSERT_FATAL(pin_fixture_maps(geos, paths) == 0);
+    CU_ASSERT(pin_state_check_layout(layout, 2, geos, paths, PIN_FIXTURE_MAPS) == 1);
+
+    // one map is missing: the other one is unlinked too
+    (void)unlink(socks);
+    CU_ASSERT(pin_state_check_layout(layout, 2, geos, paths, PIN_FIXTURE_MAPS) == 0);
+    CU_ASSERT(is_pinned(links) == 0 && is_pinned(layout) == 1);
+
+    // the layout is missing
+    CU_ASSERT_FATAL(pin_fixture_maps(geos, paths) == 0);
+    (void)unlink(layout);
+    CU_ASSERT(pin_state_check_layout(layout, 2, geos, paths, PIN_FIXTURE_MAPS) == 0);
+    CU_ASSERT(is_pinned(links) == 0 && is_pinned(socks) == 0 && is_pinned(layout) == 1);
+
+    CU_ASSERT(pin_state_check_layout(layout, 2, geos, paths, 0) == -1);
+
+    (void)unlink(layout);
+    (void)unlink(links);
+    (void)unlink(socks);
+    (void)rmdir(root);
+}
+
+#ifndef TCP_SOCKBUF_BPF_OBJ
+#define TCP_SOCKBUF_BPF_OBJ     "../src/probes/extends/ebpf.probe/src/tcpprobe/tcp_sockbuf.bpf.o"
+#endif
+
+void TestBpfRawTracepoint(void)
+{
+    char raw_tp = is_raw_tracepoint_supported("tcp", "tcp_probe");
+
+    CU_ASSERT(raw_tp == 0 || raw_tp == 1);
+    CU_ASSERT(is_raw_tracepoint_supported("tcp", "gala_gopher_no_such_tp") == 0);
+    // since 4.17 the kernel has raw tracepoints, and BTF only since 5.2
+    if (access("/sys/kernel/btf/vmlinux", R_OK) == 0) {
+        CU_ASSERT(raw_tp == 1);
+    }
+}
+
+/*
+ * The object built once against the kernel BTF is relocated and verified on the running kernel, with the hook of
+ * tcp_probe selected at run time. It is only there after the ebpf probes are built.
+ */
+void TestTcpSockbufCoreLoad(void)
+{
+    int ret;
+    struct bpf_object *obj;
+    struct timespec start, end;
+    struct rlimit rlim = {RLIM_INFINITY, RLIM_INFINITY};
+
+    if (geteuid() != 0 || access(TCP_SOCKBUF_BPF_OBJ, R_OK) != 0 || access("/sys/kernel/btf/vmlinux", R_OK) != 0) {
+        printf("skip the CO-RE load of %s: not root, not built or no kernel BTF.\n", TCP_SOCKBUF_BPF_OBJ);
+        return;
+    }
+    (void)setrlimit(RLIMIT_MEMLOCK, &rlim);
+
+    obj = bpf_object__open_file(TCP_SOCKBUF_BPF_OBJ, NULL);
+    CU_ASSERT_FATAL(libbpf_get_error(obj) == 0 && obj != NULL);
+
+    ret = bpf_select_raw_tracepoint(obj, "tcp", "tcp_probe", "bpf_raw_trace_tcp_probe", "bpf_tcp_rcv_established");
+    CU_ASSERT(ret == is_raw_tracepoint_supported("tcp", "tcp_probe"));
+    CU_ASSERT(bpf_select_raw_tracepoint(obj, "tcp", "tcp_probe", "no_such_prog", "bpf_tcp_rcv_established") < 0);
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    ret = bpf_object__load(obj);
+    (void)clock_gettime(CLOCK_MONOTONIC, &end);
+    CU_ASSERT(ret == 0);
+    printf("CO-RE load of tcp_sockbuf: %ld us\n",
+           (long)((end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000));
+
+    bpf_object__close(obj);
+}
+
+#define UNWIND_TEST_DEPTH       32
+#define UNWIND_TEST_STACK_LEN   (8 * 1024)
+#define UNWIND_TEST_LEVELS      3
+
+#if defined(__x86_64__)
+#define UNWIND_TEST_RA_REG      16
+#define UNWIND_TEST_SP_REG      7
+#define UNWIND_TEST_FP_REG      6
+#define UNWIND_CAPTURE_REGS(regs) \
+    __asm__ volatile("lea 0(%%rip), %0\n\tmov %%rsp, %1\n\tmov %%rbp, %2" \
+                     : "=r"((regs)->ip), "=r"((regs)->sp), "=r"((regs)->fp))
+#elif defined(__aarch64__)
+#define UNWIND_TEST_RA_REG      30
+#define UNWIND_TEST_SP_REG      31
+#define UNWIND_TEST_FP_REG      29
+#define UNWIND_CAPTURE_REGS(regs) \
+    __asm__ volatile("adr %0, .\n\tmov %1, sp\n\tmov %2, x29\n\tmov %3, x30" \
+                     : "=r"((regs)->ip), "=r"((regs)->sp), "=r"((regs)->fp), "=r"((regs)->lr))
+#endif
+
+#if defined(UNWIND_CAPTURE_REGS)
+static struct unwind_regs_s g_unwind_regs;
+static struct unwind_stack_s g_unwind_stack;
+static u64 g_unwind_ras[UNWIND_TEST_LEVELS];
+
+// Copy the stack from the captured sp, as the oncpu probe does. It spans the redzones of ASan builds.
+static __attribute__((noinline, no_sanitize_address)) void unwind_test_copy_stack(void)
+{
+    pthread_attr_t attr;
+    void *addr;
+    char *data;
+    size_t size;
+    u64 top, len = UNWIND_TEST_STACK_LEN;
+
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+        return;
+    }
+    if (pthread_attr_getstack(&attr, &addr, &size) == 0) {
+        top = (u64)addr + size;
+        if (top - g_unwind_regs.sp < len) {
+            len = top - g_unwind_regs.sp;
+        }
+        data = (char *)malloc(len);
+        if (data != NULL) {
+            for (u64 i = 0; i < len; i++) {
+                data[i] = ((const volatile char *)g_unwind_regs.sp)[i];
+            }
+            g_unwind_stack.data = data;
+            g_unwind_stack.sp = g_unwind_regs.sp;
+            g_unwind_stack.len = (u32)len;
+        }
+    }
+    (void)pthread_attr_destroy(&attr);
+}
+
+/*
+ * The frames to unwind are built without frame pointers, so the frame pointer chain would skip them and only the
+ * .eh_frame of the test binary gets them right.
+ */
+static __attribute__((noinline, optimize("omit-frame-pointer"))) int unwind_test_level3(void)
+{
+    g_unwind_ras[2] = (u64)__builtin_return_address(0);
+    UNWIND_CAPTURE_REGS(&g_unwind_regs);
+    unwind_test_copy_stack();
+    return 3;
+}
+
+static __attribute__((noinline, optimize("omit-frame-pointer"))) int unwind_test_level2(void)
+{
+    volatile int ret;
+
+    g_unwind_ras[1] = (u64)__builtin_return_address(0);
+    ret = unwind_test_level3();
+    return ret + 1;
+}
+
+static __attribute__((noinline, optimize("omit-frame-pointer"))) int unwind_test_level1(void)
+{
+    volatile int ret;
+
+    g_unwind_ras[0] = (u64)__builtin_return_address(0);
+    ret = unwind_test_level2();
+    return ret + 1;
+}
+#endif
+
+void TestDwarfUnwind(void)
+{
+#if defined(UNWIND_CAPTURE_REGS)
+    struct unwind_tbl_s *tbl;
+    struct elf_reader_s *elf_reader;
+    struct proc_symbs_s *proc_symbs;
+    const struct unwind_row_s *row;
+    struct mod_s *mod;
+    u64 target_addr, ips[UNWIND_TEST_DEPTH] = {0};
+    int depth;
+
+    tbl = load_unwind_tbl("/proc/self/exe");
+    CU_ASSERT_FATAL(tbl != NULL);
+    CU_ASSERT(tbl->count > 0);
+    CU_ASSERT(search_unwind_row(tbl, tbl->base_pc - 1) == NULL);
+
+    elf_reader = create_elf_reader("/usr/lib/debug");
+    CU_ASSERT_FATAL(elf_reader != NULL);
+    proc_symbs = proc_load_all_symbs(elf_reader, (int)getpid());
+    CU_ASSERT_FATAL(proc_symbs != NULL);
+
+    // at the entry of a function CFA is sp based
+    mod = proc_get_mod_by_addr(proc_symbs, (u64)unwind_test_level3, &target_addr);
+    CU_ASSERT(mod != NULL);
+    row = search_unwind_row(tbl, target_addr);
+    CU_ASSERT(row != NULL && row->cfa_type == UNWIND_CFA_SP);
+
+    CU_ASSERT(unwind_test_level1() == 5);
+    CU_ASSERT_FATAL(g_unwind_stack.data != NULL);
+    depth = proc_unwind_user_stack(proc_symbs, &g_unwind_regs, &g_unwind_stack, ips, UNWIND_TEST_DEPTH);
+    CU_ASSERT(depth > UNWIND_TEST_LEVELS);
+    CU_ASSERT(ips[0] == g_unwind_regs.ip);
+    CU_ASSERT(ips[1] == g_unwind_ras[2]);
+    CU_ASSERT(ips[2] == g_unwind_ras[1]);
+    CU_ASSERT(ips[3] == g_unwind_ras[0]);
+
+    // the copy of the stack ends, so does the walk
+    g_unwind_stack.len = 0;
+    depth = proc_unwind_user_stack(proc_symbs, &g_unwind_regs, &g_unwind_stack, ips, UNWIND_TEST_DEPTH);
+    CU_ASSERT(depth == 1);
+
+    free((void *)g_unwind_stack.data);
+    g_unwind_stack.data = NULL;
+    proc_delete_all_symbs(proc_symbs);
+    destroy_elf_reader(elf_reader);
+    destroy_unwind_tbl(tbl);
+#endif
+}
+
+#if defined(UNWIND_TEST_RA_REG)
+#define UNWIND_TEST_EH_ADDR     0x1000
+#define UNWIND_TEST_PC          0x2000
+#define UNWIND_TEST_FDE_OFF     24
+#define UNWIND_TEST_EH_LEN      52
+
+/*
+ * CIE: zR, code align 1, data align -8, CFA = sp + 8, ra at CFA - 8.
+ * FDE: [0x2000, 0x2010), pc relative sdata4. After 1 byte: CFA = sp + 16, fp at CFA - 16.
+ */
+static const u8 g_unwind_eh_frame[UNWIND_TEST_EH_LEN] = {
+    0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 'z', 'R', 0x00,
+    0x01, 0x78, UNWIND_TEST_RA_REG, 0x01, 0x1b, 0x0c, UNWIND_TEST_SP_REG, 0x08,
+    0x80 | UNWIND_TEST_RA_REG, 0x01, 0x00, 0x00,
+
+    0x14, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00, 0xe0, 0x0f, 0x00, 0x00,
+    0x10, 0x00, 0x00, 0x00, 0x00, 0x41, 0x0e, 0x10, 0x80 | UNWIND_TEST_FP_REG, 0x02, 0x00, 0x00,
+
+    0x00, 0x00, 0x00, 0x00
+};
+
+struct unwind_corrupt_s {
+    u32 off;
+    u8 val;
+};
+
+// every one makes the only FDE unusable
+static const struct unwind_corrupt_s g_unwind_corrupts[] = {
+    {9, 'x'},                           // unknown augmentation without 'z' data
+    {8, 2},                             // CIE version
+    {4, 1},                             // CIE id
+    {15, 0x7f},                         // augmentation data longer than the CIE
+    {15, 0x80},                         // unterminated uleb128 of the augmentation data length
+    {27, 0xff},                         // FDE length beyond the end
+    {28, 0x40},                         // CIE pointer before .eh_frame
+    {28, 0x18},                         // CIE pointer into the CIE
+    {40, 0x7f},                         // FDE augmentation data longer than the FDE
+    {42, 0x0f},                         // DW_CFA_def_cfa_expression longer than the FDE
+    {46, 0x2f},                         // DW_CFA_GNU_negative_offset_extended, its operands run out
+};
+
+static struct unwind_tbl_s *unwind_test_create(const u8 *data, size_t len)
+{
+    struct unwind_tbl_s *tbl;
+    // exactly len bytes, reads beyond them are caught by ASan builds
+    char *buf = (char *)malloc(len ? len : 1);
+
+    if (buf == NULL) {
+        return NULL;
+    }
+    (void)memcpy(buf, data, len);
+    tbl = create_unwind_tbl(buf, len, UNWIND_TEST_EH_ADDR);
+    free(buf);
+    return tbl;
+}
+#endif
+
+void TestDwarfUnwindCorrupt(void)
+{
+#if defined(UNWIND_TEST_RA_REG)
+    struct unwind_tbl_s *tbl;
+    const struct unwind_row_s *row;
+    u8 data[UNWIND_TEST_EH_LEN];
+
+    tbl = unwind_test_create(g_unwind_eh_frame, sizeof(g_unwind_eh_frame));
+    CU_ASSERT_FATAL(tbl != NULL);
+    CU_ASSERT(tbl->base_pc == UNWIND_TEST_PC && tbl->count == 3);
+    CU_ASSERT(search_unwind_row(tbl, UNWIND_TEST_PC - 1) == NULL);
+    row = search_unwind_row(tbl, UNWIND_TEST_PC);
+    CU_ASSERT(row != NULL && row->cfa_type == UNWIND_CFA_SP && row->cfa_offset == 8 && row->ra_offset == -8 &&
+              row->fp_offset == 0);
+    row = search_unwind_row(tbl, UNWIND_TEST_PC + 5);
+    CU_ASSERT(row != NULL && row->cfa_type == UNWIND_CFA_SP && row->cfa_offset == 16 && row->fp_offset == -16);
+    row = search_unwind_row(tbl, UNWIND_TEST_PC + 0x10);
+    CU_ASSERT(row != NULL && row->cfa_type == UNWIND_CFA_UNDEF);
+    destroy_unwind_tbl(tbl);
+
+    // truncated anywhere before the terminator
+    for (size_t len = 0; len < sizeof(g_unwind_eh_frame); len++) {
+        tbl = unwind_test_create(g_unwind_eh_frame, len);
+        CU_ASSERT_FATAL(tbl != NULL);
+        CU_ASSERT(tbl->count == ((len < UNWIND_TEST_EH_LEN - sizeof(u32)) ? 0 : 3));
+        destroy_unwind_tbl(tbl);
+    }
+
+    for (size_t i = 0; i < sizeof(g_unwind_corrupts) / sizeof(g_unwind_corrupts[0]); i++) {
+        (void)memcpy(data, g_unwind_eh_frame, sizeof(data));
+        data[g_unwind_corrupts[i].off] = g_unwind_corrupts[i].val;
+        tbl = unwind_test_create(data, sizeof(data));
+        CU_ASSERT_FATAL(tbl != NULL);
+        CU_ASSERT(tbl->count == 0);
+        destroy_unwind_tbl(tbl);
+    }
+
+    // random corruption of the CIE and FDE never reads out of bounds
+    srand(1);
+    for (int i = 0; i < 10000; i++) {
+        (void)memcpy(data, g_unwind_eh_frame, sizeof(data));
+        data[rand() % (UNWIND_TEST_FDE_OFF * 2)] = (u8)rand();
+        data[rand() % (UNWIND_TEST_FDE_OFF * 2)] = (u8)rand();
+        tbl = unwind_test_create(data, sizeof(data));
+        CU_ASSERT_FATAL(tbl != NULL);
+        destroy_unwind_tbl(tbl);
+    }
+#endif
+}
+
+#define SYMB_TEST_FILLERS       1000
+#define SYMB_TEST_FILLER_BASE   0x10000
+#define SYMB_TEST_FILLER_STEP   0x40
+#define SYMB_TEST_NAME_LEN      32
+
+struct symb_test_s {
+    char name[SYMB_TEST_NAME_LEN];
+    u64 start;
+    u64 size;
+};
+
+// not in address order, the table is sorted when loaded
+static const struct symb_test_s g_symb_tests[] = {
+    {"last", 0x100000, 0x20},
+    {"first", 0x1000, 0x10},
+    {"inner_b", 0x1110, 0x10},
+    {"outer", 0x1100, 0x100},       // encloses inner_b and inner_c, and the gap after them
+    {"inner_c", 0x1130, 0x10},
+    {"no_size", 0x1300, 0},
+    {"after_no_size", 0x1310, 0x8},
+};
+
+// A minimal elf with .symtab, .strtab and .shstrtab only, no build-id so the symbol cache is not used.
+static int write_symb_elf(const char *path, const struct symb_test_s *symbs, u32 num)
+{
+    static const char shstrtab[] = "\0.symtab\0.strtab\0.shstrtab";
+    Elf64_Ehdr ehdr = {0};
+    Elf64_Shdr shdrs[4] = {0};
+    Elf64_Sym *syms;
+    char *strtab;
+    size_t strtab_len = 1, pos = 1;
+    FILE *fp;
+    int ret = -1;
+
+    for (u32 i = 0; i < num; i++) {
+        strtab_len += strlen(symbs[i].name) + 1;
+    }
+    syms = (Elf64_Sym *)calloc(num + 1, sizeof(Elf64_Sym));
+    strtab = (char *)calloc(1, strtab_len);
+    if (syms == NULL || strtab == NULL) {
+        goto out;
+    }
+    for (u32 i = 0; i < num; i++) {
+        syms[i + 1].st_name = (Elf64_Word)pos;
+        syms[i + 1].st_info = ELF64_ST_INFO(STB_GLOBAL, STT_FUNC);
+        syms[i + 1].st_shndx = SHN_ABS;
+        syms[i + 1].st_value = symbs[i].start;
+        syms[i + 1].st_size = symbs[i].size;
+        (void)strcpy(strtab + pos, symbs[i].name);
+        pos += strlen(symbs[i].name) + 1;
+    }
+
+    (void)memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+    ehdr.e_ident[EI_CLASS] = ELFCLASS64;
+    ehdr.e_ident[EI_DATA] = (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) ? ELFDATA2LSB : ELFDATA2MSB;
+    ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+    ehdr.e_type = ET_DYN;
+    ehdr.e_version = EV_CURRENT;
+    ehdr.e_ehsize = sizeof(Elf64_Ehdr);
+    ehdr.e_shentsize = sizeof(Elf64_Shdr);
+    ehdr.e_shnum = 4;
+    ehdr.e_shstrndx = 3;
+
+    shdrs[1].sh_name = 1;
+    shdrs[1].sh_type = SHT_SYMTAB;
+    shdrs[1].sh_offset = sizeof(Elf64_Ehdr);
+    shdrs[1].sh_size = (num + 1) * sizeof(Elf64_Sym);
+    shdrs[1].sh_link = 2;
+    shdrs[1].sh_info = 1;
+    shdrs[1].sh_addralign = 8;
+    shdrs[1].sh_entsize = sizeof(Elf64_Sym);
+    shdrs[2].sh_name = 9;
+    shdrs[2].sh_type = SHT_STRTAB;
+    shdrs[2].sh_offset = shdrs[1].sh_offset + shdrs[1].sh_size;
+    shdrs[2].sh_size = strtab_len;
+    shdrs[2].sh_addralign = 1;
+    shdrs[3].sh_name = 17;
+    shdrs[3].sh_type = SHT_STRTAB;
+    shdrs[3].sh_offset = shdrs[2].sh_offset + shdrs[2].sh_size;
+    shdrs[3].sh_size = sizeof(shstrtab);
+    shdrs[3].sh_addralign = 1;
+    ehdr.e_shoff = (shdrs[3].sh_offset + shdrs[3].sh_size + 7) & ~(Elf64_Off)7;
+
+    fp = fopen(path, "w");
+    if (fp == NULL) {
+        goto out;
+    }
+    (void)fwrite(&ehdr, sizeof(ehdr), 1, fp);
+    (void)fwrite(syms, sizeof(Elf64_Sym), num + 1, fp);
+    (void)fwrite(strtab, 1, strtab_len, fp);
+    (void)fwrite(shstrtab, 1, sizeof(shstrtab), fp);
+    (void)fseek(fp, (long)ehdr.e_shoff, SEEK_SET);
+    ret = (fwrite(shdrs, sizeof(shdrs), 1, fp) == 1) ? 0 : -1;
+    (void)fclose(fp);
+out:
+    free(syms);
+    free(strtab);
+    return ret;
+}
+
+// The reference: the symbol with the highest start address that contains addr.
+static const struct symb_test_s *symb_linear_search(const struct symb_test_s *symbs, u32 num, u64 addr)
+{
+    const struct symb_test_s *found = NULL;
+
+    for (u32 i = 0; i < num; i++) {
+        if (addr >= symbs[i].start && addr - symbs[i].start < symbs[i].size &&
+            (found == NULL || symbs[i].start > found->start)) {
+            found = &symbs[i];
+        }
+    }
+    return found;
+}
+
+static void symb_test_addr(struct elf_symbo_s *elf_symbo, const struct symb_test_s *symbs, u32 num, u64 addr)
+{
+    int ret;
+    struct addr_symb_s addr_symb = {0};
+    const struct symb_test_s *expect = symb_linear_search(symbs, num, addr);
+
+    ret = search_elf_symb(elf_symbo, addr, addr, "test", &addr_symb);
+    if (expect == NULL) {
+        CU_ASSERT(ret != 0);
+        return;
+    }
+    CU_ASSERT(ret == 0);
+    if (ret == 0) {
+        CU_ASSERT(strcmp(addr_symb.sym, expect->name) == 0);
+        CU_ASSERT(addr_symb.offset == addr - expect->start);
+    }
+}
+
+void TestElfSymbEytzinger(void)
+{
+    char path[] = "/tmp/gala-gopher-symb-XXXXXX";
+    u32 num = 0, max = sizeof(g_symb_tests) / sizeof(g_symb_tests[0]) + SYMB_TEST_FILLERS;
+    struct symb_test_s *symbs;
+    struct elf_symbo_s *elf_symbo;
+    int fd;
+
+    symbs = (struct symb_test_s *)calloc(max, sizeof(struct symb_test_s));
+    CU_ASSERT_FATAL(symbs != NULL);
+    for (u32 i = 0; i < sizeof(g_symb_tests) / sizeof(g_symb_tests[0]); i++) {
+        symbs[num++] = g_symb_tests[i];
+    }
+    // enough symbols for a deep tree, each followed by a gap
+    for (u32 i = 0; i < SYMB_TEST_FILLERS; i++) {
+        (void)snprintf(symbs[num].name, SYMB_TEST_NAME_LEN, "filler_%u", i);
+        symbs[num].start = SYMB_TEST_FILLER_BASE + (u64)i * SYMB_TEST_FILLER_STEP;
+        symbs[num].size = SYMB_TEST_FILLER_STEP / 2;
+        num++;
+    }
+
+    fd = mkstemp(path);
+    CU_ASSERT_FATAL(fd >= 0);
+    (void)close(fd);
+    CU_ASSERT_FATAL(write_symb_elf(path, symbs, num) == 0);
+
+    elf_symbo = get_symb_from_file(path, ELF_SYM);
+    CU_ASSERT_FATAL(elf_symbo != NULL);
+    CU_ASSERT(elf_symbo->symb_tbl != NULL && elf_symbo->symb_tbl->count == num);
+
+    symb_test_addr(elf_symbo, symbs, num, 0);
+    symb_test_addr(elf_symbo, symbs, num, (u64)-1);
+    for (u32 i = 0; i < num; i++) {
+        u64 start = symbs[i].start, end = symbs[i].start + symbs[i].size;
+
+        symb_test_addr(elf_symbo, symbs, num, start - 1);
+        symb_test_addr(elf_symbo, symbs, num, start);
+        symb_test_addr(elf_symbo, symbs, num, start + symbs[i].size / 2);
+        symb_test_addr(elf_symbo, symbs, num, end - 1);
+        symb_test_addr(elf_symbo, symbs, num, end);
+        symb_test_addr(elf_symbo, symbs, num, end + 1);
+    }
+
+    rm_elf_symb(elf_symbo);
+    (void)unlink(path);
+    free(symbs);
+}
+
 void TestVirtInfoProbe(void)
 {
     int ret;
@@ -22,6 +22,23 @@ void TestSystemDiskProbe(void);
 void TestSystemNetProbe(void);
 void TestSystemdNetTcpProbe(void);
 void TestSystemProcProbe(void);
+void TestProcFileFixture(void);
+void TestHistogram(void);
+void TestBlkTopo(void);
+void TestTcpSockDiag(void);
+void TestPinStateLayout(void);
+void TestBpfRawTracepoint(void);
+void TestTcpSockbufCoreLoad(void);
+void TestDwarfUnwind(void);
+void TestDwarfUnwindCorrupt(void);
+void TestElfSymbEytzinger(void);
+void TestCharScan(void);
+void TestHpackDecode(void);
+void TestDnsParser(void);
+void TestRedisParser(void);
+void TestHttp1Parser(void);
+void TestMysqlParser(void);
+void TestKafkaParser(void);
 void TestVirtInfoProbe(void);
 void TestEventProbe(void);
 